@@ -0,0 +1,895 @@
+/*
+ * benchmark - SwitchGLES performance benchmark
+ * Target: SwitchGLES (deko3d backend)
+ *
+ * Runs scripted scenarios back to back. Each one reports:
+ * - CPU time spent issuing the frame's GL calls, per draw and per frame
+ * - GPU time of the frame (GL_EXT_disjoint_timer_query)
+ * - Frame time, swap to swap
+ * - The backend counters of its last frame (sglGetFrameStats)
+ * Results are printed and written as JSON to BENCH_OUTPUT_PATH, so runs of
+ * different library versions can be compared.
+ * Press + to exit.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <switch.h>
+
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+#define GL_GLEXT_PROTOTYPES
+#include <GLES2/gl2ext.h>
+#include <GLES2/gl2sgl.h>  /* SwitchGLES extensions */
+
+/*==========================================================================
+ * Configuration
+ *==========================================================================*/
+
+#define SCREEN_WIDTH        1280
+#define SCREEN_HEIGHT       720
+
+#define BENCH_WARMUP_FRAMES 10
+#define BENCH_FRAMES        120     /* Measured frames per scenario */
+#define BENCH_QUERY_RING    4       /* Timer queries in flight */
+#define BENCH_MAX_RESULTS   16
+#define BENCH_MAX_EXTRAS    3
+
+#define BENCH_DRAWS         2000    /* Draw call scenarios */
+#define BENCH_ARRAY_DRAWS   500     /* Client array vs VBO scenarios */
+#define BENCH_STRIP_VERTS   256     /* Vertices per client array / VBO draw */
+#define BENCH_UPLOAD_SIZE   1024    /* Texture upload: 1024x1024 per frame */
+#define BENCH_FBO_PASSES    32
+#define BENCH_LINKS         16
+
+#define BENCH_OUTPUT_PATH   "sdmc:/switch/sgl_benchmark.json"
+
+/*==========================================================================
+ * nxlink support
+ *==========================================================================*/
+
+static int s_nxlinkSock = -1;
+
+static void initNxLink(void) {
+    if (R_FAILED(socketInitializeDefault()))
+        return;
+    s_nxlinkSock = nxlinkStdio();
+    if (s_nxlinkSock >= 0)
+        printf("=== BENCHMARK (SwitchGLES) ===\n");
+    else
+        socketExit();
+}
+
+static void deinitNxLink(void) {
+    if (s_nxlinkSock >= 0) {
+        close(s_nxlinkSock);
+        socketExit();
+        s_nxlinkSock = -1;
+    }
+}
+
+/*==========================================================================
+ * EGL state
+ *==========================================================================*/
+
+static EGLDisplay s_display;
+static EGLContext s_context;
+static EGLSurface s_surface;
+
+static bool initEgl(void) {
+    s_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (!s_display) {
+        printf("Could not connect to display! error: %d\n", eglGetError());
+        return false;
+    }
+
+    eglInitialize(s_display, NULL, NULL);
+
+    EGLConfig config;
+    EGLint numConfigs;
+    static const EGLint configAttribs[] = {
+        EGL_RED_SIZE,     8,
+        EGL_GREEN_SIZE,   8,
+        EGL_BLUE_SIZE,    8,
+        EGL_ALPHA_SIZE,   8,
+        EGL_DEPTH_SIZE,   24,
+        EGL_STENCIL_SIZE, 8,
+        EGL_NONE
+    };
+    eglChooseConfig(s_display, configAttribs, &config, 1, &numConfigs);
+    if (numConfigs == 0) {
+        printf("No config found! error: %d\n", eglGetError());
+        eglTerminate(s_display);
+        return false;
+    }
+
+    s_surface = eglCreateWindowSurface(s_display, config, NULL, NULL);
+    if (!s_surface) {
+        printf("Surface creation failed! error: %d\n", eglGetError());
+        eglTerminate(s_display);
+        return false;
+    }
+
+    static const EGLint contextAttribs[] = {
+        EGL_CONTEXT_CLIENT_VERSION, 2,
+        EGL_NONE
+    };
+    s_context = eglCreateContext(s_display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (!s_context) {
+        printf("Context creation failed! error: %d\n", eglGetError());
+        eglDestroySurface(s_display, s_surface);
+        eglTerminate(s_display);
+        return false;
+    }
+
+    eglMakeCurrent(s_display, s_surface, s_surface, s_context);
+    return true;
+}
+
+static void deinitEgl(void) {
+    if (s_display) {
+        eglMakeCurrent(s_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (s_context) eglDestroyContext(s_display, s_context);
+        if (s_surface) eglDestroySurface(s_display, s_surface);
+        eglTerminate(s_display);
+        s_display = NULL;
+    }
+}
+
+/*==========================================================================
+ * Timing and results
+ *==========================================================================*/
+
+static PadState s_pad;
+static bool s_exitRequested = false;
+
+static uint64_t nowNs(void) {
+    return armTicksToNs(armGetSystemTick());
+}
+
+typedef struct {
+    const char *name;
+    double value;
+} BenchExtra;
+
+typedef struct {
+    char name[48];
+    int frames;                 /* Measured frames (fewer if aborted) */
+    int drawsPerFrame;
+    double cpuUsPerDraw;
+    double cpuUsPerFrame;
+    double gpuUsPerFrame;       /* < 0: no timer query results */
+    double frameUs;
+    BenchExtra extras[BENCH_MAX_EXTRAS];
+    int numExtras;
+    sgl_frame_stats_t stats;    /* Last measured frame */
+} BenchResult;
+
+static BenchResult s_results[BENCH_MAX_RESULTS];
+static int s_numResults = 0;
+static GLuint s_queries[BENCH_QUERY_RING];
+
+static BenchResult *newResult(const char *name, int drawsPerFrame) {
+    if (s_numResults == BENCH_MAX_RESULTS) return NULL;
+    BenchResult *r = &s_results[s_numResults++];
+    memset(r, 0, sizeof(*r));
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->drawsPerFrame = drawsPerFrame;
+    r->gpuUsPerFrame = -1.0;
+    return r;
+}
+
+static void addExtra(BenchResult *r, const char *name, double value) {
+    if (!r || r->numExtras == BENCH_MAX_EXTRAS) return;
+    r->extras[r->numExtras].name = name;
+    r->extras[r->numExtras].value = value;
+    r->numExtras++;
+}
+
+static bool pollExit(void) {
+    padUpdate(&s_pad);
+    if (padGetButtonsDown(&s_pad) & HidNpadButton_Plus) s_exitRequested = true;
+    return s_exitRequested;
+}
+
+typedef void (*BenchFrameFunc)(int frame, bool measured);
+
+/*
+ * Run a scenario's frame function for the warm-up and measured frames.
+ * The timer query of a frame is read back BENCH_QUERY_RING frames later,
+ * by which time frame pacing has made sure the GPU finished it.
+ */
+static BenchResult *runFrames(const char *name, int drawsPerFrame, BenchFrameFunc frame) {
+    BenchResult *r = newResult(name, drawsPerFrame);
+    if (!r || s_exitRequested) return r;
+
+    int queryFrame[BENCH_QUERY_RING];
+    for (int i = 0; i < BENCH_QUERY_RING; i++) queryFrame[i] = -1;
+
+    uint64_t cpuNs = 0, gpuNs = 0, firstSwap = 0, lastSwap = 0;
+    int gpuSamples = 0;
+    const int total = BENCH_WARMUP_FRAMES + BENCH_FRAMES;
+
+    for (int f = 0; f <= total; f++) {
+        /* Collect the timer query about to be reused (one extra pass drains) */
+        int slot = f % BENCH_QUERY_RING;
+        for (int i = 0; i < BENCH_QUERY_RING; i++) {
+            bool drain = f == total;
+            if ((drain || i == slot) && queryFrame[i] >= BENCH_WARMUP_FRAMES) {
+                GLuint64 ns = 0;
+                glGetQueryObjectui64vEXT(s_queries[i], GL_QUERY_RESULT_EXT, &ns);
+                gpuNs += ns;
+                gpuSamples++;
+            }
+            if (drain || i == slot) queryFrame[i] = -1;
+        }
+        if (f == total || !appletMainLoop() || pollExit()) break;
+
+        bool measured = f >= BENCH_WARMUP_FRAMES;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+        glClearColor(0.1f, 0.1f, 0.12f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        glBeginQueryEXT(GL_TIME_ELAPSED_EXT, s_queries[slot]);
+        uint64_t t0 = nowNs();
+        frame(f, measured);
+        uint64_t t1 = nowNs();
+        glEndQueryEXT(GL_TIME_ELAPSED_EXT);
+        queryFrame[slot] = f;
+
+        eglSwapBuffers(s_display, s_surface);
+        uint64_t swap = nowNs();
+
+        if (measured) {
+            cpuNs += t1 - t0;
+            lastSwap = swap;
+            r->frames++;
+        } else {
+            firstSwap = swap;
+        }
+    }
+
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    sglGetFrameStats(&r->stats);
+
+    if (r->frames == 0) return r;
+    r->cpuUsPerFrame = cpuNs / 1000.0 / r->frames;
+    r->cpuUsPerDraw = drawsPerFrame > 0 ? r->cpuUsPerFrame / drawsPerFrame : 0.0;
+    r->frameUs = (lastSwap - firstSwap) / 1000.0 / r->frames;
+    if (gpuSamples > 0 && !disjoint) r->gpuUsPerFrame = gpuNs / 1000.0 / gpuSamples;
+    return r;
+}
+
+/*==========================================================================
+ * Shared resources
+ *==========================================================================*/
+
+static GLuint compileProgram(const char *vsSrc, const char *fsSrc) {
+    GLuint vs = glCreateShader(GL_VERTEX_SHADER);
+    GLuint fs = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(vs, 1, &vsSrc, NULL);
+    glShaderSource(fs, 1, &fsSrc, NULL);
+    glCompileShader(vs);
+    glCompileShader(fs);
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vs);
+    glAttachShader(program, fs);
+    glBindAttribLocation(program, 0, "a_pos");
+    glBindAttribLocation(program, 1, "a_uv");
+    glLinkProgram(program);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        char log[512];
+        glGetProgramInfoLog(program, sizeof(log), NULL, log);
+        printf("Program link failed: %.200s\n", log);
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+/* Flat color quad placed by u_offsetScale (xy = offset, zw = scale) */
+static const char *s_colorVs =
+    "#version 100\n"
+    "attribute vec2 a_pos;\n"
+    "uniform vec4 u_offsetScale;\n"
+    "void main() {\n"
+    "    gl_Position = vec4(a_pos * u_offsetScale.zw + u_offsetScale.xy, 0.0, 1.0);\n"
+    "}\n";
+
+static const char *s_colorFs =
+    "#version 100\n"
+    "precision mediump float;\n"
+    "uniform vec4 u_color;\n"
+    "void main() {\n"
+    "    gl_FragColor = u_color;\n"
+    "}\n";
+
+static const char *s_texVs =
+    "#version 100\n"
+    "attribute vec2 a_pos;\n"
+    "attribute vec2 a_uv;\n"
+    "uniform vec4 u_offsetScale;\n"
+    "varying vec2 v_uv;\n"
+    "void main() {\n"
+    "    v_uv = a_uv;\n"
+    "    gl_Position = vec4(a_pos * u_offsetScale.zw + u_offsetScale.xy, 0.0, 1.0);\n"
+    "}\n";
+
+static const char *s_texFs =
+    "#version 100\n"
+    "precision mediump float;\n"
+    "uniform sampler2D u_tex;\n"
+    "varying vec2 v_uv;\n"
+    "void main() {\n"
+    "    gl_FragColor = texture2D(u_tex, v_uv);\n"
+    "}\n";
+
+/* Transform and colors change every draw */
+static const char *s_mvpVs =
+    "#version 100\n"
+    "attribute vec2 a_pos;\n"
+    "uniform mat4 u_mvp;\n"
+    "uniform vec4 u_tint;\n"
+    "varying vec4 v_tint;\n"
+    "void main() {\n"
+    "    v_tint = u_tint;\n"
+    "    gl_Position = u_mvp * vec4(a_pos, 0.0, 1.0);\n"
+    "}\n";
+
+static const char *s_mvpFs =
+    "#version 100\n"
+    "precision mediump float;\n"
+    "uniform vec4 u_color;\n"
+    "varying vec4 v_tint;\n"
+    "void main() {\n"
+    "    gl_FragColor = u_color * v_tint;\n"
+    "}\n";
+
+typedef struct {
+    GLuint program;
+    GLint offsetScale;
+    GLint color;
+    GLint tex;
+    GLint mvp;
+    GLint tint;
+} BenchProgram;
+
+static BenchProgram s_color, s_tex, s_mvp;
+
+static GLuint s_quadVbo;        /* Triangle strip: pos.xy, uv.xy */
+static GLuint s_stripVbo;       /* BENCH_STRIP_VERTS pos.xy */
+static GLfloat s_stripVerts[BENCH_STRIP_VERTS * 2];
+static GLuint s_checkerTex[2];
+
+static bool loadProgram(BenchProgram *p, const char *vs, const char *fs) {
+    p->program = compileProgram(vs, fs);
+    if (!p->program) return false;
+    p->offsetScale = glGetUniformLocation(p->program, "u_offsetScale");
+    p->color = glGetUniformLocation(p->program, "u_color");
+    p->tex = glGetUniformLocation(p->program, "u_tex");
+    p->mvp = glGetUniformLocation(p->program, "u_mvp");
+    p->tint = glGetUniformLocation(p->program, "u_tint");
+    return true;
+}
+
+static GLuint createTexture(GLsizei width, GLsizei height, GLenum format, const void *pixels) {
+    GLuint tex;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, pixels);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return tex;
+}
+
+static bool initResources(void) {
+    if (!loadProgram(&s_color, s_colorVs, s_colorFs)) return false;
+    if (!loadProgram(&s_tex, s_texVs, s_texFs)) return false;
+    if (!loadProgram(&s_mvp, s_mvpVs, s_mvpFs)) return false;
+
+    static const GLfloat quad[] = {
+        -1.0f, -1.0f, 0.0f, 0.0f,
+         1.0f, -1.0f, 1.0f, 0.0f,
+        -1.0f,  1.0f, 0.0f, 1.0f,
+         1.0f,  1.0f, 1.0f, 1.0f,
+    };
+    glGenBuffers(1, &s_quadVbo);
+    glBindBuffer(GL_ARRAY_BUFFER, s_quadVbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+
+    /* A ribbon zig-zagging across the unit square */
+    for (int i = 0; i < BENCH_STRIP_VERTS; i++) {
+        s_stripVerts[i * 2 + 0] = -1.0f + 2.0f * (float)(i / 2) / (BENCH_STRIP_VERTS / 2 - 1);
+        s_stripVerts[i * 2 + 1] = (i & 1) ? 1.0f : -1.0f;
+    }
+    glGenBuffers(1, &s_stripVbo);
+    glBindBuffer(GL_ARRAY_BUFFER, s_stripVbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(s_stripVerts), s_stripVerts, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    uint8_t checker[2][64 * 64 * 4];
+    for (int y = 0; y < 64; y++) {
+        for (int x = 0; x < 64; x++) {
+            uint8_t on = ((x / 8) ^ (y / 8)) & 1 ? 255 : 40;
+            uint8_t *a = &checker[0][(y * 64 + x) * 4];
+            uint8_t *b = &checker[1][(y * 64 + x) * 4];
+            a[0] = on; a[1] = on; a[2] = 255; a[3] = 255;
+            b[0] = 255; b[1] = on; b[2] = on; b[3] = 255;
+        }
+    }
+    s_checkerTex[0] = createTexture(64, 64, GL_RGBA, checker[0]);
+    s_checkerTex[1] = createTexture(64, 64, GL_RGBA, checker[1]);
+
+    glGenQueriesEXT(BENCH_QUERY_RING, s_queries);
+    return true;
+}
+
+static void freeResources(void) {
+    glDeleteQueriesEXT(BENCH_QUERY_RING, s_queries);
+    glDeleteTextures(2, s_checkerTex);
+    glDeleteBuffers(1, &s_quadVbo);
+    glDeleteBuffers(1, &s_stripVbo);
+    glDeleteProgram(s_color.program);
+    glDeleteProgram(s_tex.program);
+    glDeleteProgram(s_mvp.program);
+}
+
+static void bindQuad(bool withUv) {
+    glBindBuffer(GL_ARRAY_BUFFER, s_quadVbo);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (const void *)0);
+    if (withUv) {
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat),
+                              (const void *)(2 * sizeof(GLfloat)));
+    } else {
+        glDisableVertexAttribArray(1);
+    }
+}
+
+/* Small quad i of a 50-column grid, in clip space */
+static void gridCell(int i, GLfloat *out) {
+    const int cols = 50, rows = 40;
+    out[2] = 1.0f / cols;
+    out[3] = 1.0f / rows;
+    out[0] = -1.0f + out[2] * (2 * (i % cols) + 1);
+    out[1] = -1.0f + out[3] * (2 * ((i / cols) % rows) + 1);
+}
+
+/*==========================================================================
+ * Scenario: draw calls
+ *==========================================================================*/
+
+/* Same program, buffers and uniforms for every draw */
+static void frameDrawsStatic(int frame, bool measured) {
+    (void)frame; (void)measured;
+    glUseProgram(s_color.program);
+    bindQuad(false);
+    glUniform4f(s_color.offsetScale, 0.0f, 0.0f, 0.05f, 0.05f);
+    glUniform4f(s_color.color, 0.2f, 0.8f, 0.3f, 1.0f);
+    for (int i = 0; i < BENCH_DRAWS; i++) {
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+}
+
+/* Blend, depth, scissor and texture change between consecutive draws */
+static void frameDrawsStateChanges(int frame, bool measured) {
+    (void)frame; (void)measured;
+    glUseProgram(s_tex.program);
+    glUniform1i(s_tex.tex, 0);
+    bindQuad(true);
+    glEnable(GL_SCISSOR_TEST);
+    for (int i = 0; i < BENCH_DRAWS; i++) {
+        GLfloat cell[4];
+        gridCell(i, cell);
+        glUniform4fv(s_tex.offsetScale, 1, cell);
+
+        if (i & 1) {
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        } else {
+            glDisable(GL_BLEND);
+        }
+        if (i & 2) glEnable(GL_DEPTH_TEST); else glDisable(GL_DEPTH_TEST);
+        glDepthFunc((i & 4) ? GL_LEQUAL : GL_ALWAYS);
+        glScissor((i * 37) % (SCREEN_WIDTH / 2), (i * 53) % (SCREEN_HEIGHT / 2),
+                  SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2);
+        glBindTexture(GL_TEXTURE_2D, s_checkerTex[(i >> 1) & 1]);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_BLEND);
+    glDisable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+}
+
+/* A mat4 and two vec4 uniforms written before every draw */
+static void frameUniformHeavy(int frame, bool measured) {
+    (void)measured;
+    glUseProgram(s_mvp.program);
+    bindQuad(false);
+    for (int i = 0; i < BENCH_DRAWS; i++) {
+        GLfloat cell[4];
+        gridCell(i, cell);
+        float a = (frame + i) * 0.01f;
+        float c = cosf(a), s = sinf(a);
+        const GLfloat mvp[16] = {
+            c * cell[2], s * cell[3], 0.0f, 0.0f,
+           -s * cell[2], c * cell[3], 0.0f, 0.0f,
+            0.0f,        0.0f,        1.0f, 0.0f,
+            cell[0],     cell[1],     0.0f, 1.0f,
+        };
+        glUniformMatrix4fv(s_mvp.mvp, 1, GL_FALSE, mvp);
+        glUniform4f(s_mvp.tint, 1.0f, 0.5f + 0.5f * c, 0.5f + 0.5f * s, 1.0f);
+        glUniform4f(s_mvp.color, (i % 7) / 7.0f, 0.6f, 0.9f, 1.0f);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+}
+
+/*==========================================================================
+ * Scenario: client arrays vs. VBOs
+ *==========================================================================*/
+
+static void drawStrips(bool clientArrays) {
+    glUseProgram(s_color.program);
+    glUniform4f(s_color.color, 0.9f, 0.7f, 0.2f, 1.0f);
+    glDisableVertexAttribArray(1);
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, clientArrays ? 0 : s_stripVbo);
+    for (int i = 0; i < BENCH_ARRAY_DRAWS; i++) {
+        GLfloat cell[4];
+        gridCell(i, cell);
+        glUniform4fv(s_color.offsetScale, 1, cell);
+        /* Client arrays are re-specified and copied for every draw */
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, clientArrays ? s_stripVerts : NULL);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, BENCH_STRIP_VERTS);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+static void frameClientArrays(int frame, bool measured) {
+    (void)frame; (void)measured;
+    drawStrips(true);
+}
+
+static void frameVbo(int frame, bool measured) {
+    (void)frame; (void)measured;
+    drawStrips(false);
+}
+
+/*==========================================================================
+ * Scenario: texture upload
+ *==========================================================================*/
+
+typedef struct {
+    const char *name;
+    GLenum format;
+    int bytesPerPixel;
+} UploadFormat;
+
+static const UploadFormat s_uploadFormats[] = {
+    { "upload_rgba8",           GL_RGBA,            4 },
+    { "upload_rgb8",            GL_RGB,             3 },
+    { "upload_luminance_alpha", GL_LUMINANCE_ALPHA, 2 },
+    { "upload_luminance",       GL_LUMINANCE,       1 },
+    { "upload_alpha",           GL_ALPHA,           1 },
+};
+
+static const UploadFormat *s_upload;
+static GLuint s_uploadTex;
+static uint8_t *s_uploadPixels;
+static uint64_t s_uploadNs;
+
+/* Replace the whole texture, then draw with it so the upload is consumed */
+static void frameUpload(int frame, bool measured) {
+    s_uploadPixels[0] = (uint8_t)frame;
+    glBindTexture(GL_TEXTURE_2D, s_uploadTex);
+    uint64_t t0 = nowNs();
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, BENCH_UPLOAD_SIZE, BENCH_UPLOAD_SIZE,
+                    s_upload->format, GL_UNSIGNED_BYTE, s_uploadPixels);
+    if (measured) s_uploadNs += nowNs() - t0;
+
+    glUseProgram(s_tex.program);
+    glUniform1i(s_tex.tex, 0);
+    glUniform4f(s_tex.offsetScale, 0.0f, 0.0f, 0.5f, 0.5f * SCREEN_WIDTH / SCREEN_HEIGHT);
+    bindQuad(true);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
+
+static void runUploadScenarios(void) {
+    const size_t maxBytes = (size_t)BENCH_UPLOAD_SIZE * BENCH_UPLOAD_SIZE * 4;
+    s_uploadPixels = (uint8_t *)malloc(maxBytes);
+    if (!s_uploadPixels) return;
+    for (size_t i = 0; i < maxBytes; i++) s_uploadPixels[i] = (uint8_t)(i * 31);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    for (size_t f = 0; f < sizeof(s_uploadFormats) / sizeof(s_uploadFormats[0]); f++) {
+        s_upload = &s_uploadFormats[f];
+        s_uploadTex = createTexture(BENCH_UPLOAD_SIZE, BENCH_UPLOAD_SIZE, s_upload->format, NULL);
+        s_uploadNs = 0;
+
+        BenchResult *r = runFrames(s_upload->name, 1, frameUpload);
+        double bytes = (double)BENCH_UPLOAD_SIZE * BENCH_UPLOAD_SIZE * s_upload->bytesPerPixel;
+        if (r && s_uploadNs > 0) {
+            addExtra(r, "upload_us", s_uploadNs / 1000.0 / r->frames);
+            addExtra(r, "mb_per_s", bytes * r->frames / (1024.0 * 1024.0) / (s_uploadNs / 1e9));
+        }
+        glDeleteTextures(1, &s_uploadTex);
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    free(s_uploadPixels);
+    s_uploadPixels = NULL;
+}
+
+/*==========================================================================
+ * Scenario: FBO ping-pong
+ *==========================================================================*/
+
+#define BENCH_FBO_WIDTH  640
+#define BENCH_FBO_HEIGHT 360
+
+static GLuint s_pingFbo[2];
+static GLuint s_pingTex[2];
+
+/* Each pass samples the target rendered by the previous one */
+static void frameFboPingPong(int frame, bool measured) {
+    (void)frame; (void)measured;
+    glUseProgram(s_tex.program);
+    glUniform1i(s_tex.tex, 0);
+    glUniform4f(s_tex.offsetScale, 0.0f, 0.0f, 1.0f, 1.0f);
+    bindQuad(true);
+
+    glViewport(0, 0, BENCH_FBO_WIDTH, BENCH_FBO_HEIGHT);
+    glBindFramebuffer(GL_FRAMEBUFFER, s_pingFbo[0]);
+    glBindTexture(GL_TEXTURE_2D, s_checkerTex[0]);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    for (int pass = 1; pass < BENCH_FBO_PASSES; pass++) {
+        glBindFramebuffer(GL_FRAMEBUFFER, s_pingFbo[pass & 1]);
+        glBindTexture(GL_TEXTURE_2D, s_pingTex[(pass - 1) & 1]);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+    glBindTexture(GL_TEXTURE_2D, s_pingTex[(BENCH_FBO_PASSES - 1) & 1]);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
+
+static void runFboScenario(void) {
+    for (int i = 0; i < 2; i++) {
+        s_pingTex[i] = createTexture(BENCH_FBO_WIDTH, BENCH_FBO_HEIGHT, GL_RGBA, NULL);
+        glGenFramebuffers(1, &s_pingFbo[i]);
+        glBindFramebuffer(GL_FRAMEBUFFER, s_pingFbo[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, s_pingTex[i], 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            printf("FBO ping-pong: framebuffer %d incomplete, skipped\n", i);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glDeleteFramebuffers(i + 1, s_pingFbo);
+            glDeleteTextures(i + 1, s_pingTex);
+            return;
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    runFrames("fbo_ping_pong", BENCH_FBO_PASSES + 1, frameFboPingPong);
+
+    glDeleteFramebuffers(2, s_pingFbo);
+    glDeleteTextures(2, s_pingTex);
+}
+
+/*==========================================================================
+ * Scenario: runtime shader compilation
+ *==========================================================================*/
+
+/*
+ * glLinkProgram of ES 1.00 sources transpiles and compiles on the worker
+ * threads; GL_LINK_STATUS waits for it. Both times are reported. Every
+ * program differs by a constant so nothing is shared between links, and
+ * the disk cache is off for the whole run.
+ */
+static void runLinkScenario(void) {
+    BenchResult *r = newResult("link_program", 0);
+    if (!r || s_exitRequested) return;
+
+    uint64_t callNs = 0, totalNs = 0, maxNs = 0;
+    int links = 0;
+    char vsSrc[512], fsSrc[512];
+
+    for (int i = 0; i < BENCH_LINKS && !pollExit(); i++) {
+        snprintf(vsSrc, sizeof(vsSrc),
+            "#version 100\n"
+            "attribute vec2 a_pos;\n"
+            "attribute vec2 a_uv;\n"
+            "uniform mat4 u_mvp;\n"
+            "varying vec2 v_uv;\n"
+            "void main() {\n"
+            "    v_uv = a_uv * %d.0;\n"
+            "    gl_Position = u_mvp * vec4(a_pos, 0.0, 1.0);\n"
+            "}\n", i + 1);
+        snprintf(fsSrc, sizeof(fsSrc),
+            "#version 100\n"
+            "precision mediump float;\n"
+            "uniform sampler2D u_tex;\n"
+            "uniform vec4 u_color;\n"
+            "varying vec2 v_uv;\n"
+            "void main() {\n"
+            "    vec4 t = texture2D(u_tex, fract(v_uv));\n"
+            "    gl_FragColor = mix(t, u_color, %d.0 / %d.0);\n"
+            "}\n", i, BENCH_LINKS);
+
+        const char *vsPtr = vsSrc, *fsPtr = fsSrc;
+        GLuint vs = glCreateShader(GL_VERTEX_SHADER);
+        GLuint fs = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(vs, 1, &vsPtr, NULL);
+        glShaderSource(fs, 1, &fsPtr, NULL);
+        GLuint program = glCreateProgram();
+
+        uint64_t t0 = nowNs();
+        glCompileShader(vs);
+        glCompileShader(fs);
+        glAttachShader(program, vs);
+        glAttachShader(program, fs);
+        glBindAttribLocation(program, 0, "a_pos");
+        glBindAttribLocation(program, 1, "a_uv");
+        glLinkProgram(program);
+        uint64_t t1 = nowNs();
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        uint64_t t2 = nowNs();
+
+        if (linked) {
+            callNs += t1 - t0;
+            totalNs += t2 - t0;
+            if (t2 - t0 > maxNs) maxNs = t2 - t0;
+            links++;
+        } else {
+            printf("link_program: link %d failed\n", i);
+        }
+        glDeleteShader(vs);
+        glDeleteShader(fs);
+        glDeleteProgram(program);
+    }
+
+    if (links > 0) {
+        r->cpuUsPerFrame = totalNs / 1000.0 / links;
+        addExtra(r, "link_call_us", callNs / 1000.0 / links);
+        addExtra(r, "link_total_us", totalNs / 1000.0 / links);
+        addExtra(r, "link_max_us", maxNs / 1000.0);
+    }
+}
+
+/*==========================================================================
+ * Report
+ *==========================================================================*/
+
+static void printResults(void) {
+    printf("\n%-24s %7s %10s %10s %10s %10s\n",
+           "scenario", "draws", "cpu/draw", "cpu/frame", "gpu/frame", "frame");
+    for (int i = 0; i < s_numResults; i++) {
+        const BenchResult *r = &s_results[i];
+        printf("%-24s %7d %8.3fus %8.1fus %8.1fus %8.1fus\n", r->name, r->drawsPerFrame,
+               r->cpuUsPerDraw, r->cpuUsPerFrame, r->gpuUsPerFrame, r->frameUs);
+        for (int e = 0; e < r->numExtras; e++) {
+            printf("    %-20s %10.2f\n", r->extras[e].name, r->extras[e].value);
+        }
+    }
+    fflush(stdout);
+}
+
+static void writeJson(FILE *f) {
+    fprintf(f, "{\n");
+    fprintf(f, "  \"version\": \"%s\",\n", (const char *)glGetString(GL_VERSION));
+    fprintf(f, "  \"renderer\": \"%s\",\n", (const char *)glGetString(GL_RENDERER));
+    fprintf(f, "  \"timestamp\": %lld,\n", (long long)time(NULL));
+    fprintf(f, "  \"warmup_frames\": %d,\n", BENCH_WARMUP_FRAMES);
+    fprintf(f, "  \"frames\": %d,\n", BENCH_FRAMES);
+    fprintf(f, "  \"complete\": %s,\n", s_exitRequested ? "false" : "true");
+    fprintf(f, "  \"scenarios\": [\n");
+    for (int i = 0; i < s_numResults; i++) {
+        const BenchResult *r = &s_results[i];
+        const sgl_frame_stats_t *s = &r->stats;
+        fprintf(f, "    {\n");
+        fprintf(f, "      \"name\": \"%s\",\n", r->name);
+        fprintf(f, "      \"frames\": %d,\n", r->frames);
+        fprintf(f, "      \"draws_per_frame\": %d,\n", r->drawsPerFrame);
+        fprintf(f, "      \"cpu_us_per_draw\": %.4f,\n", r->cpuUsPerDraw);
+        fprintf(f, "      \"cpu_us_per_frame\": %.2f,\n", r->cpuUsPerFrame);
+        if (r->gpuUsPerFrame >= 0.0) {
+            fprintf(f, "      \"gpu_us_per_frame\": %.2f,\n", r->gpuUsPerFrame);
+        } else {
+            fprintf(f, "      \"gpu_us_per_frame\": null,\n");
+        }
+        fprintf(f, "      \"frame_us\": %.2f,\n", r->frameUs);
+        for (int e = 0; e < r->numExtras; e++) {
+            fprintf(f, "      \"%s\": %.2f,\n", r->extras[e].name, r->extras[e].value);
+        }
+        fprintf(f, "      \"stats\": { \"draws\": %u, \"shader_binds\": %u, \"texture_binds\": %u, "
+                   "\"descriptor_binds\": %u, \"vertex_binds\": %u, \"barriers\": %u, "
+                   "\"wait_idle_stalls\": %u, \"client_array_bytes\": %u, \"client_array_chunks\": %u, "
+                   "\"uniform_bytes\": %u, \"cmd_mem_used\": %u }\n",
+                s->draws, s->shader_binds, s->texture_binds, s->descriptor_binds, s->vertex_binds,
+                s->barriers, s->wait_idle_stalls, s->client_array_bytes, s->client_array_chunks,
+                s->uniform_bytes, s->cmd_mem_used);
+        fprintf(f, "    }%s\n", i + 1 < s_numResults ? "," : "");
+    }
+    fprintf(f, "  ]\n");
+    fprintf(f, "}\n");
+}
+
+/*==========================================================================
+ * Main
+ *==========================================================================*/
+
+int main(int argc, char* argv[]) {
+    (void)argc; (void)argv;
+
+    initNxLink();
+    padConfigureInput(1, HidNpadStyleSet_NpadStandard);
+    padInitializeDefault(&s_pad);
+
+    /* Measure real compiles, not cache hits; must precede any link */
+    sglSetShaderCachePath(NULL);
+
+    if (!initEgl()) {
+        printf("EGL initialization failed!\n");
+        deinitNxLink();
+        return 1;
+    }
+    if (!initResources()) {
+        printf("Benchmark resources failed to initialize!\n");
+        deinitEgl();
+        deinitNxLink();
+        return 1;
+    }
+
+    printf("Running scenarios, %d frames each (+ to abort)...\n", BENCH_FRAMES);
+    fflush(stdout);
+
+    runFrames("draws_static", BENCH_DRAWS, frameDrawsStatic);
+    runFrames("draws_state_changes", BENCH_DRAWS, frameDrawsStateChanges);
+    runFrames("uniform_heavy", BENCH_DRAWS, frameUniformHeavy);
+    runFrames("client_arrays", BENCH_ARRAY_DRAWS, frameClientArrays);
+    runFrames("vbo", BENCH_ARRAY_DRAWS, frameVbo);
+    runUploadScenarios();
+    runFboScenario();
+    runLinkScenario();
+
+    printResults();
+    FILE *f = fopen(BENCH_OUTPUT_PATH, "w");
+    if (f) {
+        writeJson(f);
+        fclose(f);
+        printf("\nResults written to %s\n", BENCH_OUTPUT_PATH);
+    } else {
+        printf("\nCould not open %s, JSON follows:\n", BENCH_OUTPUT_PATH);
+        writeJson(stdout);
+    }
+
+    printf("\nPress + to exit...\n");
+    fflush(stdout);
+    while (!s_exitRequested && appletMainLoop()) {
+        if (pollExit()) break;
+        svcSleepThread(16000000ULL);
+    }
+
+    glFinish();
+    freeResources();
+    deinitEgl();
+    deinitNxLink();
+    return 0;
+}
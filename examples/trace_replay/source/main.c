@@ -0,0 +1,305 @@
+/*
+ * trace_replay - Play back a GL call trace and time every call
+ * Target: SwitchGLES (deko3d backend)
+ *
+ * Replays a trace written by sglBeginCapture() frame by frame and reports:
+ * - CPU time of each frame's calls and GPU time of the frame
+ *   (GL_EXT_disjoint_timer_query)
+ * - Calls and CPU time per GL entry point, over the whole trace
+ * - The slowest draws, with the frame and call they were in
+ * The trace is TRACE_DEFAULT_PATH, or the first argument (nxlink -a).
+ * Press + to exit, A to replay the trace again.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <switch.h>
+
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+#define GL_GLEXT_PROTOTYPES
+#include <GLES2/gl2ext.h>
+#include <GLES2/gl2sgl.h>  /* SwitchGLES extensions */
+
+/*==========================================================================
+ * Configuration
+ *==========================================================================*/
+
+#define TRACE_DEFAULT_PATH  "sdmc:/switch/sgl_trace.bin"
+#define MAX_ENTRY_POINTS    96      /* Distinct GL entry points reported */
+#define SLOWEST_DRAWS       10
+
+/*==========================================================================
+ * nxlink support
+ *==========================================================================*/
+
+static int s_nxlinkSock = -1;
+
+static void initNxLink(void) {
+    if (R_FAILED(socketInitializeDefault()))
+        return;
+    s_nxlinkSock = nxlinkStdio();
+    if (s_nxlinkSock >= 0)
+        printf("=== TRACE REPLAY (SwitchGLES) ===\n");
+    else
+        socketExit();
+}
+
+static void deinitNxLink(void) {
+    if (s_nxlinkSock >= 0) {
+        close(s_nxlinkSock);
+        socketExit();
+        s_nxlinkSock = -1;
+    }
+}
+
+/*==========================================================================
+ * EGL state
+ *==========================================================================*/
+
+static EGLDisplay s_display;
+static EGLContext s_context;
+static EGLSurface s_surface;
+
+static bool initEgl(void) {
+    s_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (!s_display) {
+        printf("Could not connect to display! error: %d\n", eglGetError());
+        return false;
+    }
+
+    eglInitialize(s_display, NULL, NULL);
+
+    EGLConfig config;
+    EGLint numConfigs;
+    static const EGLint configAttribs[] = {
+        EGL_RED_SIZE,     8,
+        EGL_GREEN_SIZE,   8,
+        EGL_BLUE_SIZE,    8,
+        EGL_ALPHA_SIZE,   8,
+        EGL_DEPTH_SIZE,   24,
+        EGL_STENCIL_SIZE, 8,
+        EGL_NONE
+    };
+    eglChooseConfig(s_display, configAttribs, &config, 1, &numConfigs);
+    if (numConfigs == 0) {
+        printf("No config found! error: %d\n", eglGetError());
+        eglTerminate(s_display);
+        return false;
+    }
+
+    s_surface = eglCreateWindowSurface(s_display, config, NULL, NULL);
+    if (!s_surface) {
+        printf("Surface creation failed! error: %d\n", eglGetError());
+        eglTerminate(s_display);
+        return false;
+    }
+
+    static const EGLint contextAttribs[] = {
+        EGL_CONTEXT_CLIENT_VERSION, 2,
+        EGL_NONE
+    };
+    s_context = eglCreateContext(s_display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (!s_context) {
+        printf("Context creation failed! error: %d\n", eglGetError());
+        eglDestroySurface(s_display, s_surface);
+        eglTerminate(s_display);
+        return false;
+    }
+
+    eglMakeCurrent(s_display, s_surface, s_surface, s_context);
+    return true;
+}
+
+static void deinitEgl(void) {
+    if (s_display) {
+        eglMakeCurrent(s_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (s_context) eglDestroyContext(s_display, s_context);
+        if (s_surface) eglDestroySurface(s_display, s_surface);
+        eglTerminate(s_display);
+        s_display = NULL;
+    }
+}
+
+/*==========================================================================
+ * Per-call statistics
+ *==========================================================================*/
+
+typedef struct {
+    const char *name;
+    unsigned calls;
+    uint64_t ns;
+} EntryPoint;
+
+typedef struct {
+    const char *name;
+    unsigned frame;
+    unsigned call;
+    uint64_t ns;
+} SlowDraw;
+
+static EntryPoint s_entryPoints[MAX_ENTRY_POINTS];
+static int s_numEntryPoints;
+static SlowDraw s_slowest[SLOWEST_DRAWS];
+static int s_numSlowest;
+
+static void resetStats(void) {
+    s_numEntryPoints = 0;
+    s_numSlowest = 0;
+}
+
+/* Called by sglReplayFrame after every replayed call */
+static void onCall(const sgl_replay_call_t *call, void *user) {
+    (void)user;
+
+    /* Names are static strings: one entry per pointer */
+    int e = 0;
+    while (e < s_numEntryPoints && s_entryPoints[e].name != call->name) e++;
+    if (e == s_numEntryPoints) {
+        if (e == MAX_ENTRY_POINTS) return;
+        s_entryPoints[s_numEntryPoints++] = (EntryPoint){ call->name, 0, 0 };
+    }
+    s_entryPoints[e].calls++;
+    s_entryPoints[e].ns += call->cpu_ns;
+
+    if (!call->draw) return;
+
+    /* Insertion into the list of slowest draws, slowest first */
+    int pos = s_numSlowest < SLOWEST_DRAWS ? s_numSlowest++ : SLOWEST_DRAWS;
+    while (pos > 0 && s_slowest[pos - 1].ns < call->cpu_ns) {
+        if (pos < SLOWEST_DRAWS) s_slowest[pos] = s_slowest[pos - 1];
+        pos--;
+    }
+    if (pos < SLOWEST_DRAWS) {
+        s_slowest[pos] = (SlowDraw){ call->name, call->frame, call->call, call->cpu_ns };
+    }
+}
+
+static int compareEntryPoints(const void *a, const void *b) {
+    uint64_t na = ((const EntryPoint *)a)->ns;
+    uint64_t nb = ((const EntryPoint *)b)->ns;
+    return na < nb ? 1 : na > nb ? -1 : 0;
+}
+
+static void printStats(void) {
+    qsort(s_entryPoints, s_numEntryPoints, sizeof(EntryPoint), compareEntryPoints);
+    printf("\n%-40s %8s %10s %9s\n", "entry point", "calls", "total", "per call");
+    for (int i = 0; i < s_numEntryPoints; i++) {
+        const EntryPoint *e = &s_entryPoints[i];
+        printf("%-40s %8u %8.1fus %7.2fus\n", e->name, e->calls, e->ns / 1000.0,
+               e->ns / 1000.0 / e->calls);
+    }
+
+    printf("\nSlowest draws:\n");
+    for (int i = 0; i < s_numSlowest; i++) {
+        const SlowDraw *d = &s_slowest[i];
+        printf("  %-24s frame %5u call %6u %8.2fus\n", d->name, d->frame, d->call, d->ns / 1000.0);
+    }
+}
+
+/*==========================================================================
+ * Replay
+ *==========================================================================*/
+
+static PadState s_pad;
+static bool s_exitRequested = false;
+
+static bool pollExit(void) {
+    padUpdate(&s_pad);
+    if (padGetButtonsDown(&s_pad) & HidNpadButton_Plus) s_exitRequested = true;
+    return s_exitRequested;
+}
+
+/*
+ * Replay the whole trace once, presenting every frame. The GPU time of a
+ * frame is read right after its swap, which waits for the GPU: frames are
+ * measured one at a time, not paced like the application ran them.
+ */
+static bool replayTrace(const char *path) {
+    sgl_replay_t *replay = sglReplayOpen(path);
+    if (!replay) {
+        printf("Could not open trace %s\n", path);
+        return false;
+    }
+    sglReplaySetCallback(replay, onCall, NULL);
+    resetStats();
+
+    GLuint query;
+    glGenQueriesEXT(1, &query);
+
+    uint64_t cpuTotal = 0;
+    uint64_t gpuTotal = 0;
+    unsigned frames = 0;
+    sgl_replay_stats_t stats;
+
+    printf("\n%6s %7s %6s %10s %10s %10s\n", "frame", "calls", "draws", "cpu", "draw cpu", "gpu");
+    for (;;) {
+        if (!appletMainLoop() || pollExit()) break;
+
+        glBeginQueryEXT(GL_TIME_ELAPSED_EXT, query);
+        GLboolean more = sglReplayFrame(replay, &stats);
+        glEndQueryEXT(GL_TIME_ELAPSED_EXT);
+        eglSwapBuffers(s_display, s_surface);
+        if (!more) break;
+
+        GLuint64 gpuNs = 0;
+        glGetQueryObjectui64vEXT(query, GL_QUERY_RESULT_EXT, &gpuNs);
+
+        printf("%6u %7u %6u %8.1fus %8.1fus %8.1fus\n", stats.frame, stats.calls, stats.draws,
+               stats.cpu_ns / 1000.0, stats.draw_ns / 1000.0, gpuNs / 1000.0);
+        cpuTotal += stats.cpu_ns;
+        gpuTotal += gpuNs;
+        frames++;
+    }
+
+    glDeleteQueriesEXT(1, &query);
+    sglReplayClose(replay);
+
+    if (frames > 0) {
+        printf("\n%u frames: %.1fus CPU, %.1fus GPU per frame on average\n", frames,
+               cpuTotal / 1000.0 / frames, gpuTotal / 1000.0 / frames);
+    }
+    printStats();
+    fflush(stdout);
+    return true;
+}
+
+/*==========================================================================
+ * Main
+ *==========================================================================*/
+
+int main(int argc, char* argv[]) {
+    const char *path = argc > 1 ? argv[1] : TRACE_DEFAULT_PATH;
+
+    initNxLink();
+    padConfigureInput(1, HidNpadStyleSet_NpadStandard);
+    padInitializeDefault(&s_pad);
+
+    if (!initEgl()) {
+        printf("EGL initialization failed!\n");
+        deinitNxLink();
+        return 1;
+    }
+
+    printf("Replaying %s (+ to abort)...\n", path);
+    fflush(stdout);
+    bool ok = replayTrace(path);
+
+    printf("\nPress A to replay again, + to exit...\n");
+    fflush(stdout);
+    while (ok && !s_exitRequested && appletMainLoop()) {
+        if (pollExit()) break;
+        if (padGetButtonsDown(&s_pad) & HidNpadButton_A) {
+            replayTrace(path);
+            printf("\nPress A to replay again, + to exit...\n");
+            fflush(stdout);
+        }
+        svcSleepThread(16000000ULL);
+    }
+
+    deinitEgl();
+    deinitNxLink();
+    return ok ? 0 : 1;
+}
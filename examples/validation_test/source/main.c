@@ -4,10 +4,14 @@
  *
  * Tests all implemented GLES2 features systematically.
  * Press + to exit.
+ *
+ * With --perf, runs performance scenes instead and compares them against a
+ * baseline on sdmc: (see "Performance regression mode" below).
  */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <math.h>
 #include <unistd.h>
@@ -15,6 +19,8 @@
 
 #include <EGL/egl.h>
 #include <GLES2/gl2.h>
+#define GL_GLEXT_PROTOTYPES
+#include <GLES2/gl2ext.h>
 #include <GLES2/gl2sgl.h>  /* SwitchGLES extensions */
 
 #ifdef SGL_ENABLE_RUNTIME_COMPILER
@@ -1217,6 +1223,101 @@ static void testCopyTexSubImage(void) {
     glDisableVertexAttribArray(1);
 }
 
+/*==========================================================================
+ * TEST: Copy Texture Matches Upload
+ *
+ * glCopyTexImage2D / glCopyTexSubImage2D must produce exactly the texels a
+ * glTexImage2D of the glReadPixels result would. Both textures are read back
+ * through an FBO and compared byte for byte; the quadrant pattern catches a
+ * missing or doubled Y-flip.
+ *==========================================================================*/
+
+#define COPY_CMP_SIZE 64
+
+static void readTextureTexels(GLuint tex, GLsizei w, GLsizei h, GLubyte *out) {
+    GLuint fbo;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
+    glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, out);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &fbo);
+}
+
+static void drawCopyPattern(GLint x, GLint y, GLsizei size) {
+    static const float colors[4][3] = {
+        { 1.0f, 0.0f, 0.0f },  /* bottom-left: red */
+        { 0.0f, 1.0f, 0.0f },  /* bottom-right: green */
+        { 0.0f, 0.0f, 1.0f },  /* top-left: blue */
+        { 1.0f, 1.0f, 0.0f },  /* top-right: yellow */
+    };
+    GLsizei half = size / 2;
+
+    glEnable(GL_SCISSOR_TEST);
+    for (int q = 0; q < 4; q++) {
+        glScissor(x + (q & 1) * half, y + (q >> 1) * half, half, half);
+        glClearColor(colors[q][0], colors[q][1], colors[q][2], 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+    glDisable(GL_SCISSOR_TEST);
+}
+
+static void testCopyTexMatchesUpload(void) {
+    printf("\n--- Test: glCopyTex*Image2D matches upload ---\n");
+
+    const GLint srcX = 600, srcY = 300;
+    const size_t bytes = COPY_CMP_SIZE * COPY_CMP_SIZE * 4;
+    GLubyte *reference = malloc(bytes);
+    GLubyte *copied = malloc(bytes);
+    GLubyte *uploaded = malloc(bytes);
+
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    drawCopyPattern(srcX, srcY, COPY_CMP_SIZE);
+    glReadPixels(srcX, srcY, COPY_CMP_SIZE, COPY_CMP_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, reference);
+
+    GLuint tex[2];
+    glGenTextures(2, tex);
+
+    /* Full copy vs upload of the same pixels */
+    glBindTexture(GL_TEXTURE_2D, tex[0]);
+    glCopyTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, srcX, srcY, COPY_CMP_SIZE, COPY_CMP_SIZE, 0);
+    glBindTexture(GL_TEXTURE_2D, tex[1]);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, COPY_CMP_SIZE, COPY_CMP_SIZE, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, reference);
+    recordResult("CopyTexImage2D + upload", glGetError() == GL_NO_ERROR, NULL);
+
+    readTextureTexels(tex[0], COPY_CMP_SIZE, COPY_CMP_SIZE, copied);
+    readTextureTexels(tex[1], COPY_CMP_SIZE, COPY_CMP_SIZE, uploaded);
+    recordResult("CopyTexImage2D texels match upload", memcmp(copied, uploaded, bytes) == 0,
+                 "copied texture differs from glTexImage2D of glReadPixels");
+
+    /* Sub-region copy: the bottom-right quadrant into the top-left corner */
+    const GLsizei half = COPY_CMP_SIZE / 2;
+    glBindTexture(GL_TEXTURE_2D, tex[0]);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, half, srcX + half, srcY, half, half);
+    glBindTexture(GL_TEXTURE_2D, tex[1]);
+    GLubyte *patch = malloc((size_t)half * half * 4);
+    for (GLsizei row = 0; row < half; row++) {
+        memcpy(patch + row * half * 4,
+               reference + (row * COPY_CMP_SIZE + half) * 4, (size_t)half * 4);
+    }
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, half, half, half, GL_RGBA, GL_UNSIGNED_BYTE, patch);
+    free(patch);
+    recordResult("CopyTexSubImage2D + upload", glGetError() == GL_NO_ERROR, NULL);
+
+    readTextureTexels(tex[0], COPY_CMP_SIZE, COPY_CMP_SIZE, copied);
+    readTextureTexels(tex[1], COPY_CMP_SIZE, COPY_CMP_SIZE, uploaded);
+    recordResult("CopyTexSubImage2D texels match upload", memcmp(copied, uploaded, bytes) == 0,
+                 "copied sub-region differs from glTexSubImage2D of glReadPixels");
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDeleteTextures(2, tex);
+    free(reference);
+    free(copied);
+    free(uploaded);
+}
+
 /*==========================================================================
  * TEST: All Uniform Types
  *==========================================================================*/
@@ -3500,6 +3601,918 @@ static void testTranspilerES100(void) {
 #endif
 }
 
+/*==========================================================================
+ * TEST: State kept across glClear and eglSwapBuffers
+ *
+ * State is only emitted when it changes. glClear overrides scissor and
+ * depth-stencil state in the backend, and eglSwapBuffers starts a new
+ * command buffer: scissor and depth test set once must still apply to the
+ * draws after both.
+ *==========================================================================*/
+
+/* Green quad at z=0.5, then red at z=0.7 (fails GL_LESS), full screen */
+static void drawScissorDepthFrame(GLint colorLoc, const char *label) {
+    static const float nearQuad[] = {
+        -1.0f, -1.0f, 0.5f,   1.0f, -1.0f, 0.5f,   1.0f, 1.0f, 0.5f,   -1.0f, 1.0f, 0.5f
+    };
+    static const float farQuad[] = {
+        -1.0f, -1.0f, 0.7f,   1.0f, -1.0f, 0.7f,   1.0f, 1.0f, 0.7f,   -1.0f, 1.0f, 0.7f
+    };
+
+    glClearColor(0.0f, 0.0f, 1.0f, 1.0f);
+    glClearDepthf(1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    glUniform4f(colorLoc, 0.0f, 1.0f, 0.0f, 1.0f);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nearQuad);
+    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    glUniform4f(colorLoc, 1.0f, 0.0f, 0.0f, 1.0f);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, farQuad);
+    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+
+    GLubyte pixelIn[4], pixelOut[4];
+    glReadPixels(640, 360, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixelIn);
+    glReadPixels(100, 100, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixelOut);
+
+    printf("  %s: in=(%u,%u,%u) out=(%u,%u,%u)\n", label, pixelIn[0], pixelIn[1], pixelIn[2],
+           pixelOut[0], pixelOut[1], pixelOut[2]);
+    bool ok = pixelIn[1] > 200 && pixelIn[0] < 50 &&     /* Depth test kept: green */
+              pixelOut[2] > 200 && pixelOut[1] < 50;      /* Scissor kept: blue */
+    recordResult(label, ok, NULL);
+}
+
+static void testStateAfterClearAndSwap(void) {
+    printf("\n--- Test: State after glClear / eglSwapBuffers ---\n");
+
+    GLuint program = getSimpleProgram();
+    glUseProgram(program);
+    GLint colorLoc = glGetUniformLocation(program, "u_color");
+    glEnableVertexAttribArray(0);
+
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(320, 180, 640, 360);
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_TRUE);
+
+    drawScissorDepthFrame(colorLoc, "before swap: scissor + depth after glClear");
+
+    /* Same frame again in a new command buffer, no state set in between */
+    eglSwapBuffers(s_display, s_surface);
+    drawScissorDepthFrame(colorLoc, "after swap: scissor + depth kept");
+
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_DEPTH_TEST);
+    glDisableVertexAttribArray(0);
+}
+
+/*==========================================================================
+ * TEST: Sampler reuse across wrap/filter changes
+ *
+ * Textures with equal parameters share one cached sampler descriptor.
+ * Changing one texture's wrap or filter must give it another sampler
+ * without touching the other's. Both textures are 2x1 (red, green) drawn
+ * with u from -0.5 to 0.5: at u = -0.25 CLAMP gives red and REPEAT green,
+ * at u = 0.45 NEAREST gives red and LINEAR a red/green mix.
+ *==========================================================================*/
+
+#define SAMPLER_QUAD_X0     64      /* Left quad in pixels; the right one is 640 further */
+#define SAMPLER_QUAD_WIDTH  512
+
+typedef struct {
+    GLubyte wrapped[4];     /* u = -0.25 */
+    GLubyte inner[4];       /* u = 0.45 */
+} SamplerProbe;
+
+static void drawSamplerQuads(GLuint texLeft, GLuint texRight, SamplerProbe *left, SamplerProbe *right) {
+    static const float quads[2][16] = {
+        {   /* pos          texcoord */
+            -0.9f, -0.4f,   -0.5f, 0.5f,
+            -0.1f, -0.4f,    0.5f, 0.5f,
+            -0.1f,  0.4f,    0.5f, 0.5f,
+            -0.9f,  0.4f,   -0.5f, 0.5f,
+        },
+        {
+             0.1f, -0.4f,   -0.5f, 0.5f,
+             0.9f, -0.4f,    0.5f, 0.5f,
+             0.9f,  0.4f,    0.5f, 0.5f,
+             0.1f,  0.4f,   -0.5f, 0.5f,
+        },
+    };
+
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    for (int i = 0; i < 2; i++) {
+        glBindTexture(GL_TEXTURE_2D, i == 0 ? texLeft : texRight);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 16, quads[i]);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 16, quads[i] + 2);
+        glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    }
+
+    SamplerProbe *probes[2] = { left, right };
+    for (int i = 0; i < 2; i++) {
+        GLint x0 = SAMPLER_QUAD_X0 + i * 640;
+        glReadPixels(x0 + SAMPLER_QUAD_WIDTH / 4, 360, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                     probes[i]->wrapped);
+        glReadPixels(x0 + SAMPLER_QUAD_WIDTH * 95 / 100, 360, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                     probes[i]->inner);
+    }
+}
+
+static bool isRed(const GLubyte *p)   { return p[0] > 200 && p[1] < 50; }
+static bool isGreen(const GLubyte *p) { return p[1] > 200 && p[0] < 50; }
+static bool isMixed(const GLubyte *p) { return p[0] > 60 && p[0] < 200 && p[1] > 60 && p[1] < 200; }
+
+static void testSamplerReuse(void) {
+    printf("\n--- Test: Sampler Reuse ---\n");
+
+    GLuint program = getTexturedProgram();
+    if (!program) {
+        recordResult("Sampler reuse shader", false, "failed to load");
+        return;
+    }
+    glUseProgram(program);
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+
+    static const GLubyte texels[] = { 255, 0, 0, 255,   0, 255, 0, 255 };
+    GLuint tex[2];
+    glGenTextures(2, tex);
+    for (int i = 0; i < 2; i++) {
+        glBindTexture(GL_TEXTURE_2D, tex[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    SamplerProbe a, b;
+
+    /* Same parameters: one sampler for both */
+    drawSamplerQuads(tex[0], tex[1], &a, &b);
+    recordResult("Shared sampler (clamp, nearest)",
+                 isRed(a.wrapped) && isRed(a.inner) && isRed(b.wrapped) && isRed(b.inner), NULL);
+
+    /* Wrap change on the second texture only */
+    glBindTexture(GL_TEXTURE_2D, tex[1]);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    drawSamplerQuads(tex[0], tex[1], &a, &b);
+    recordResult("Wrap change (other texture keeps clamp)",
+                 isRed(a.wrapped) && isGreen(b.wrapped) && isRed(b.inner), NULL);
+
+    /* Filter change on the second texture only */
+    glBindTexture(GL_TEXTURE_2D, tex[1]);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    drawSamplerQuads(tex[0], tex[1], &a, &b);
+    recordResult("Filter change (other texture keeps nearest)",
+                 isRed(a.inner) && isMixed(b.inner), NULL);
+
+    /* The first texture now matches the second's earlier parameters,
+     * whose sampler is already cached */
+    glBindTexture(GL_TEXTURE_2D, tex[0]);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    drawSamplerQuads(tex[0], tex[1], &a, &b);
+    printf("  left: wrapped=(%u,%u) inner=(%u,%u)  right: wrapped=(%u,%u) inner=(%u,%u)\n",
+           a.wrapped[0], a.wrapped[1], a.inner[0], a.inner[1],
+           b.wrapped[0], b.wrapped[1], b.inner[0], b.inner[1]);
+    recordResult("Cached sampler reused (repeat, nearest)",
+                 isGreen(a.wrapped) && isRed(a.inner) && isGreen(b.wrapped) && isMixed(b.inner), NULL);
+
+    glDisableVertexAttribArray(0);
+    glDisableVertexAttribArray(1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDeleteTextures(2, tex);
+}
+
+/*==========================================================================
+ * TEST: Buffer orphaning
+ *
+ * Respecifying a GL_DYNAMIC_DRAW or GL_STREAM_DRAW buffer the frame still
+ * draws from (glBufferData, or glBufferSubData over the whole buffer) moves
+ * it to fresh memory instead of overwriting it, so every draw sees the
+ * contents it was issued with. A partial glBufferSubData writes in place and
+ * is not covered here.
+ *==========================================================================*/
+
+/* Triangle fan quad, 0.3 wide, at NDC (x, y) */
+static void orphanQuad(float *out, float x, float y) {
+    const float quad[8] = { x, y, x + 0.3f, y, x + 0.3f, y + 0.3f, x, y + 0.3f };
+    memcpy(out, quad, sizeof(quad));
+}
+
+/* Pixel at the center of orphanQuad(x, y) */
+static void orphanProbe(float x, float y, GLubyte *pixel) {
+    GLint px = (GLint)((x + 0.15f + 1.0f) * 0.5f * SCREEN_WIDTH);
+    GLint py = (GLint)((y + 0.15f + 1.0f) * 0.5f * SCREEN_HEIGHT);
+    glReadPixels(px, py, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+}
+
+static void testBufferOrphaning(void) {
+    printf("\n--- Test: Buffer Orphaning ---\n");
+
+    GLuint program = getSimpleProgram();
+    glUseProgram(program);
+    GLint colorLoc = glGetUniformLocation(program, "u_color");
+
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    GLuint vbo[2];
+    glGenBuffers(2, vbo);
+    glEnableVertexAttribArray(0);
+
+    /* Dynamic: left and right quads, then the whole buffer rewritten with the
+     * second replaced by a top quad */
+    float verts[16];
+    orphanQuad(verts, -0.9f, -0.15f);
+    orphanQuad(verts + 8, 0.6f, -0.15f);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo[0]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_DYNAMIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
+
+    glUniform4f(colorLoc, 1.0f, 0.0f, 0.0f, 1.0f);
+    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);                /* Left: red, then blue */
+    glUniform4f(colorLoc, 0.0f, 1.0f, 0.0f, 1.0f);
+    glDrawArrays(GL_TRIANGLE_FAN, 4, 4);                /* Right: green */
+
+    orphanQuad(verts + 8, -0.15f, 0.5f);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(verts), verts);
+    glUniform4f(colorLoc, 0.0f, 0.0f, 1.0f, 1.0f);
+    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);                /* Left again, from the new range */
+    glUniform4f(colorLoc, 1.0f, 1.0f, 0.0f, 1.0f);
+    glDrawArrays(GL_TRIANGLE_FAN, 4, 4);                /* Top: yellow */
+    recordResult("GL_DYNAMIC_DRAW full-size glBufferSubData", glGetError() == GL_NO_ERROR, NULL);
+
+    /* Stream: respecified before every draw */
+    glBindBuffer(GL_ARRAY_BUFFER, vbo[1]);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    glUniform4f(colorLoc, 1.0f, 1.0f, 1.0f, 1.0f);
+    for (int i = 0; i < 4; i++) {
+        orphanQuad(verts, -0.8f + 0.45f * (float)i, -0.8f);
+        glBufferData(GL_ARRAY_BUFFER, 8 * sizeof(float), verts, GL_STREAM_DRAW);
+        glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    }
+    recordResult("GL_STREAM_DRAW glBufferData per draw", glGetError() == GL_NO_ERROR, NULL);
+
+    GLubyte left[4], right[4], top[4];
+    orphanProbe(-0.9f, -0.15f, left);
+    orphanProbe(0.6f, -0.15f, right);
+    orphanProbe(-0.15f, 0.5f, top);
+    printf("  left=(%u,%u,%u) right=(%u,%u,%u) top=(%u,%u,%u)\n", left[0], left[1], left[2],
+           right[0], right[1], right[2], top[0], top[1], top[2]);
+    recordResult("Draw before glBufferSubData keeps its data (right green)",
+                 right[1] > 200 && right[0] < 50 && right[2] < 50, NULL);
+    recordResult("Rewritten bytes carried over (left blue)",
+                 left[2] > 200 && left[0] < 50 && left[1] < 50, NULL);
+    recordResult("Draw after glBufferSubData sees new data (top yellow)",
+                 top[0] > 200 && top[1] > 200 && top[2] < 50, NULL);
+
+    bool allStream = true;
+    for (int i = 0; i < 4; i++) {
+        GLubyte pixel[4];
+        orphanProbe(-0.8f + 0.45f * (float)i, -0.8f, pixel);
+        if (pixel[0] < 200 || pixel[1] < 200 || pixel[2] < 200) allStream = false;
+    }
+    recordResult("Every stream draw keeps its data (4 white quads)", allStream, NULL);
+
+    glDisableVertexAttribArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glDeleteBuffers(2, vbo);
+}
+
+/*==========================================================================
+ * TEST: glReadPixels into a pixel pack buffer (NV_pixel_buffer_object)
+ *
+ * With a pack buffer bound the readback is only recorded; glMapBufferOES
+ * waits for it. Two readbacks around a second clear must each see their
+ * own clear, and rows must land in GL order (bottom row first).
+ *==========================================================================*/
+
+static bool pixelsMatch(const GLubyte *pixels, int count, const GLubyte *expected) {
+    for (int i = 0; i < count; i++) {
+        for (int c = 0; c < 3; c++) {
+            int diff = (int)pixels[i * 4 + c] - (int)expected[c];
+            if (diff < -2 || diff > 2) return false;
+        }
+    }
+    return true;
+}
+
+static void testPixelPackBuffer(void) {
+    printf("\n--- Test: Pixel Pack Buffer ---\n");
+
+    static const GLubyte first[3] = { 64, 128, 191 };
+    static const GLubyte second[3] = { 191, 64, 0 };
+    static const GLubyte green[3] = { 0, 255, 0 };
+
+    GLuint pbo;
+    glGenBuffers(1, &pbo);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER_NV, pbo);
+    glBufferData(GL_PIXEL_PACK_BUFFER_NV, 256, NULL, GL_STREAM_DRAW);
+    GLint binding = 0;
+    glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING_NV, &binding);
+    recordResult("GL_PIXEL_PACK_BUFFER_NV binding", binding == (GLint)pbo && glGetError() == GL_NO_ERROR,
+                 NULL);
+
+    /* 4x4 of each clear, at offsets 0 and 64 */
+    glClearColor(first[0] / 255.0f, first[1] / 255.0f, first[2] / 255.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glReadPixels(638, 358, 4, 4, GL_RGBA, GL_UNSIGNED_BYTE, (void *)0);
+    glClearColor(second[0] / 255.0f, second[1] / 255.0f, second[2] / 255.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glReadPixels(638, 358, 4, 4, GL_RGBA, GL_UNSIGNED_BYTE, (void *)64);
+
+    /* Green over the top half: the row below the middle is the second clear */
+    GLuint program = getSimpleProgram();
+    glUseProgram(program);
+    glUniform4f(glGetUniformLocation(program, "u_color"), 0.0f, 1.0f, 0.0f, 1.0f);
+    static const float topHalf[] = { -1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, -1.0f, 1.0f };
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, topHalf);
+    glEnableVertexAttribArray(0);
+    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    glDisableVertexAttribArray(0);
+    glReadPixels(640, SCREEN_HEIGHT / 2 - 1, 1, 2, GL_RGBA, GL_UNSIGNED_BYTE, (void *)128);
+    recordResult("glReadPixels into pack buffer", glGetError() == GL_NO_ERROR, NULL);
+
+    const GLubyte *data = (const GLubyte *)glMapBufferOES(GL_PIXEL_PACK_BUFFER_NV, GL_WRITE_ONLY_OES);
+    recordResult("glMapBufferOES(GL_PIXEL_PACK_BUFFER_NV)", data != NULL, NULL);
+    if (data) {
+        printf("  first=(%u,%u,%u) second=(%u,%u,%u) rows=(%u,%u,%u)/(%u,%u,%u)\n",
+               data[0], data[1], data[2], data[64], data[65], data[66],
+               data[128], data[129], data[130], data[132], data[133], data[134]);
+        recordResult("Readback before second clear", pixelsMatch(data, 16, first), NULL);
+        recordResult("Readback after second clear", pixelsMatch(data + 64, 16, second), NULL);
+        recordResult("Rows in GL order", pixelsMatch(data + 128, 1, second) &&
+                     pixelsMatch(data + 132, 1, green), NULL);
+        recordResult("glUnmapBufferOES", glUnmapBufferOES(GL_PIXEL_PACK_BUFFER_NV) == GL_TRUE, NULL);
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER_NV, 0);
+    glDeleteBuffers(1, &pbo);
+}
+
+/*==========================================================================
+ * TEST: Reads at a reduced render resolution
+ *
+ * At 640x360 the default framebuffer renders into a corner of a larger
+ * image, but glReadPixels, pack buffer readbacks and glCopyTex(Sub)Image2D
+ * still take surface coordinates: red left half, green right half.
+ *==========================================================================*/
+
+/* Red left half, green right half, in surface coordinates */
+static void drawHalves(void) {
+    glClearColor(1.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(SCREEN_WIDTH / 2, 0, SCREEN_WIDTH / 2, SCREEN_HEIGHT);
+    glClearColor(0.0f, 1.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+}
+
+static void testRenderResolutionReads(void) {
+    printf("\n--- Test: Render Resolution Reads ---\n");
+
+    /* Applies from the next frame */
+    sglSetRenderResolution(SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2);
+    eglSwapBuffers(s_display, s_surface);
+    GLint renderWidth = 0, renderHeight = 0;
+    sglGetRenderResolution(&renderWidth, &renderHeight);
+    printf("  render size %dx%d\n", renderWidth, renderHeight);
+    recordResult("sglSetRenderResolution(640, 360)",
+                 renderWidth == SCREEN_WIDTH / 2 && renderHeight == SCREEN_HEIGHT / 2, NULL);
+
+    drawHalves();
+
+    /* Left quarter, top-right corner: outside the rendered corner unless
+     * the read is mapped to the render size */
+    GLubyte left[4], corner[4];
+    glReadPixels(SCREEN_WIDTH / 4, SCREEN_HEIGHT / 2, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, left);
+    glReadPixels(SCREEN_WIDTH - 4, SCREEN_HEIGHT - 4, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, corner);
+    printf("  left=(%u,%u,%u) corner=(%u,%u,%u)\n",
+           left[0], left[1], left[2], corner[0], corner[1], corner[2]);
+    recordResult("glReadPixels in surface coordinates",
+                 isRed(left) && isGreen(corner), NULL);
+
+    GLuint pbo;
+    glGenBuffers(1, &pbo);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER_NV, pbo);
+    glBufferData(GL_PIXEL_PACK_BUFFER_NV, 8, NULL, GL_STREAM_DRAW);
+    glReadPixels(SCREEN_WIDTH / 4, SCREEN_HEIGHT / 2, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, (void *)0);
+    glReadPixels(SCREEN_WIDTH - 4, SCREEN_HEIGHT - 4, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, (void *)4);
+    const GLubyte *data = (const GLubyte *)glMapBufferOES(GL_PIXEL_PACK_BUFFER_NV, GL_WRITE_ONLY_OES);
+    recordResult("Pack buffer readback in surface coordinates",
+                 data && isRed(data) && isGreen(data + 4), NULL);
+    if (data) glUnmapBufferOES(GL_PIXEL_PACK_BUFFER_NV);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER_NV, 0);
+    glDeleteBuffers(1, &pbo);
+
+    /* 16x16 across the middle: texels 0-7 red, 8-15 green. Then the
+     * top-right 8x8 over the bottom-left texels. */
+    GLuint tex;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glCopyTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SCREEN_WIDTH / 2 - 8, SCREEN_HEIGHT - 16, 16, 16, 0);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, SCREEN_WIDTH - 8, SCREEN_HEIGHT - 8, 8, 8);
+    recordResult("glCopyTexImage2D / glCopyTexSubImage2D", glGetError() == GL_NO_ERROR, NULL);
+
+    GLuint fbo;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
+    GLubyte copied[3][4];
+    glReadPixels(2, 12, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, copied[0]);    /* Copy, left */
+    glReadPixels(13, 12, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, copied[1]);   /* Copy, right */
+    glReadPixels(2, 2, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, copied[2]);     /* Sub copy */
+    printf("  copied=(%u,%u,%u)/(%u,%u,%u) sub=(%u,%u,%u)\n",
+           copied[0][0], copied[0][1], copied[0][2], copied[1][0], copied[1][1], copied[1][2],
+           copied[2][0], copied[2][1], copied[2][2]);
+    recordResult("glCopyTexImage2D in surface coordinates",
+                 isRed(copied[0]) && isGreen(copied[1]), NULL);
+    recordResult("glCopyTexSubImage2D in surface coordinates", isGreen(copied[2]), NULL);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &fbo);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDeleteTextures(1, &tex);
+
+    /* Redraw for the visual check; full size again from the next frame */
+    drawHalves();
+    sglSetRenderResolution(0, 0);
+}
+
+/*==========================================================================
+ * Performance regression mode (--perf)
+ *
+ * Reruns a few scenes for PERF_FRAMES frames each and records CPU time per
+ * frame, GPU time (GL_EXT_disjoint_timer_query), frame time and the
+ * backend counters of the last frame (sglGetFrameStats). The results are
+ * compared against PERF_BASELINE_PATH:
+ * - Times regress when slower than the baseline by more than the threshold
+ *   (and by more than PERF_NOISE_US, so tiny scenes do not flap)
+ * - Counters regress when they grow at all: they do not depend on timing
+ * Without a baseline, or with --perf-baseline, the run becomes the baseline.
+ *
+ *   nxlink -s validation_test.nro --perf [--perf-threshold=10]
+ *   nxlink -s validation_test.nro --perf-baseline
+ *==========================================================================*/
+
+#define PERF_WARMUP_FRAMES  10
+#define PERF_FRAMES         120
+#define PERF_QUERY_RING     4       /* Timer queries in flight */
+#define PERF_THRESHOLD_PCT  10.0
+#define PERF_NOISE_US       5.0
+#define PERF_MAX_SCENES     8
+#define PERF_MANY_DRAWS     2000
+#define PERF_UNIFORM_DRAWS  1000
+#define PERF_UPLOAD_SIZE    512
+#define PERF_FBO_SIZE       512
+#define PERF_FBO_PASSES     16
+#define PERF_READBACK_SIZE  256
+
+#define PERF_BASELINE_PATH  "sdmc:/switch/sgl_validation_perf.json"
+#define PERF_LAST_PATH      "sdmc:/switch/sgl_validation_perf_last.json"
+
+typedef struct {
+    char name[32];
+    int frames;                 /* Measured frames (fewer if aborted) */
+    double cpuUs;               /* Per frame */
+    double gpuUs;               /* Per frame, < 0: no timer query results */
+    double frameUs;             /* Swap to swap */
+    sgl_frame_stats_t stats;    /* Last measured frame */
+} PerfResult;
+
+/* Metrics compared against the baseline, in JSON order */
+enum { PERF_CPU, PERF_GPU, PERF_FRAME, PERF_NUM_TIMES };
+
+static const char *const s_perfTimeKeys[PERF_NUM_TIMES] = { "cpu_us", "gpu_us", "frame_us" };
+
+static const struct {
+    const char *key;
+    size_t offset;
+} s_perfCounters[] = {
+    { "draws",            offsetof(sgl_frame_stats_t, draws) },
+    { "shader_binds",     offsetof(sgl_frame_stats_t, shader_binds) },
+    { "texture_binds",    offsetof(sgl_frame_stats_t, texture_binds) },
+    { "descriptor_binds", offsetof(sgl_frame_stats_t, descriptor_binds) },
+    { "barriers",         offsetof(sgl_frame_stats_t, barriers) },
+    { "wait_idle_stalls", offsetof(sgl_frame_stats_t, wait_idle_stalls) },
+    { "uniform_bytes",    offsetof(sgl_frame_stats_t, uniform_bytes) },
+    { "cmd_mem_used",     offsetof(sgl_frame_stats_t, cmd_mem_used) },
+};
+#define PERF_NUM_COUNTERS (sizeof(s_perfCounters) / sizeof(s_perfCounters[0]))
+
+static PerfResult s_perfResults[PERF_MAX_SCENES];
+static int s_numPerfResults = 0;
+static GLuint s_perfQueries[PERF_QUERY_RING];
+
+static uint64_t perfNowNs(void) {
+    return armTicksToNs(armGetSystemTick());
+}
+
+static double perfTime(const PerfResult *r, int metric) {
+    switch (metric) {
+        case PERF_CPU: return r->cpuUs;
+        case PERF_GPU: return r->gpuUs;
+        default:       return r->frameUs;
+    }
+}
+
+static GLuint perfCounter(const PerfResult *r, size_t i) {
+    return *(const GLuint *)((const uint8_t *)&r->stats + s_perfCounters[i].offset);
+}
+
+static bool perfPollExit(void) {
+    padUpdate(&s_pad);
+    if (padGetButtonsDown(&s_pad) & HidNpadButton_Plus) s_exitRequested = true;
+    return s_exitRequested;
+}
+
+typedef void (*PerfFrameFunc)(int frame);
+
+/*
+ * Run a scene's frame function for the warm-up and measured frames. The
+ * timer query of a frame is read back PERF_QUERY_RING frames later, by which
+ * time frame pacing has made sure the GPU finished it.
+ */
+static void perfRunScene(const char *name, PerfFrameFunc frame) {
+    if (s_numPerfResults == PERF_MAX_SCENES || s_exitRequested) return;
+    PerfResult *r = &s_perfResults[s_numPerfResults++];
+    memset(r, 0, sizeof(*r));
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->gpuUs = -1.0;
+
+    int queryFrame[PERF_QUERY_RING];
+    for (int i = 0; i < PERF_QUERY_RING; i++) queryFrame[i] = -1;
+
+    uint64_t cpuNs = 0, gpuNs = 0, firstSwap = 0, lastSwap = 0;
+    int gpuSamples = 0;
+    const int total = PERF_WARMUP_FRAMES + PERF_FRAMES;
+
+    for (int f = 0; f <= total; f++) {
+        /* Collect the timer query about to be reused (one extra pass drains) */
+        int slot = f % PERF_QUERY_RING;
+        for (int i = 0; i < PERF_QUERY_RING; i++) {
+            bool drain = f == total;
+            if ((drain || i == slot) && queryFrame[i] >= PERF_WARMUP_FRAMES) {
+                GLuint64 ns = 0;
+                glGetQueryObjectui64vEXT(s_perfQueries[i], GL_QUERY_RESULT_EXT, &ns);
+                gpuNs += ns;
+                gpuSamples++;
+            }
+            if (drain || i == slot) queryFrame[i] = -1;
+        }
+        if (f == total || !appletMainLoop() || perfPollExit()) break;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+        glClearColor(0.1f, 0.1f, 0.12f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        glBeginQueryEXT(GL_TIME_ELAPSED_EXT, s_perfQueries[slot]);
+        uint64_t t0 = perfNowNs();
+        frame(f);
+        uint64_t t1 = perfNowNs();
+        glEndQueryEXT(GL_TIME_ELAPSED_EXT);
+        queryFrame[slot] = f;
+
+        eglSwapBuffers(s_display, s_surface);
+        uint64_t swap = perfNowNs();
+
+        if (f >= PERF_WARMUP_FRAMES) {
+            cpuNs += t1 - t0;
+            lastSwap = swap;
+            r->frames++;
+        } else {
+            firstSwap = swap;
+        }
+    }
+
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    sglGetFrameStats(&r->stats);
+
+    if (r->frames == 0) return;
+    r->cpuUs = cpuNs / 1000.0 / r->frames;
+    r->frameUs = (lastSwap - firstSwap) / 1000.0 / r->frames;
+    if (gpuSamples > 0 && !disjoint) r->gpuUs = gpuNs / 1000.0 / gpuSamples;
+}
+
+/*--------------------------------------------------------------------------
+ * Scenes
+ *--------------------------------------------------------------------------*/
+
+static const float s_perfQuad[] = {
+    -1.0f, -1.0f, 0.0f, 0.0f,
+     1.0f, -1.0f, 1.0f, 0.0f,
+     1.0f,  1.0f, 1.0f, 1.0f,
+    -1.0f, -1.0f, 0.0f, 0.0f,
+     1.0f,  1.0f, 1.0f, 1.0f,
+    -1.0f,  1.0f, 0.0f, 1.0f
+};
+
+static GLuint s_perfTex[2];
+static GLuint s_perfFbo[2];
+static GLuint s_perfVbo;
+static GLubyte *s_perfPixels;
+
+static void perfDrawTexturedQuad(GLuint tex) {
+    glUseProgram(getTexturedProgram());
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 16, s_perfQuad);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 16, s_perfQuad + 2);
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glDisableVertexAttribArray(1);
+}
+
+/* Full texture re-upload every frame, then sampled once */
+static void perfFrameTextureUpload(int frame) {
+    memset(s_perfPixels, (frame * 16) & 0xFF, PERF_UPLOAD_SIZE * PERF_UPLOAD_SIZE * 4);
+    glBindTexture(GL_TEXTURE_2D, s_perfTex[0]);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, PERF_UPLOAD_SIZE, PERF_UPLOAD_SIZE,
+                    GL_RGBA, GL_UNSIGNED_BYTE, s_perfPixels);
+    perfDrawTexturedQuad(s_perfTex[0]);
+}
+
+/* Each pass samples the texture the previous pass rendered */
+static void perfFrameFboPingPong(int frame) {
+    (void)frame;
+    glViewport(0, 0, PERF_FBO_SIZE, PERF_FBO_SIZE);
+    for (int pass = 0; pass < PERF_FBO_PASSES; pass++) {
+        glBindFramebuffer(GL_FRAMEBUFFER, s_perfFbo[pass & 1]);
+        perfDrawTexturedQuad(s_perfTex[(pass + 1) & 1]);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+    perfDrawTexturedQuad(s_perfTex[(PERF_FBO_PASSES - 1) & 1]);
+}
+
+/* Many small draws from one VBO, nothing changing between them */
+static void perfFrameManyDraw(int frame) {
+    (void)frame;
+    GLuint program = getSimpleProgram();
+    glUseProgram(program);
+    glUniform4f(glGetUniformLocation(program, "u_color"), 0.0f, 1.0f, 0.0f, 1.0f);
+    glBindBuffer(GL_ARRAY_BUFFER, s_perfVbo);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (const void *)0);
+    glEnableVertexAttribArray(0);
+    for (int i = 0; i < PERF_MANY_DRAWS; i++) {
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/* New uniforms before every draw */
+static void perfFrameUniformHeavy(int frame) {
+    GLuint program = getUniformProgram();
+    glUseProgram(program);
+    GLint matLoc = glGetUniformLocation(program, "u_matrix");
+    GLint offsetLoc = glGetUniformLocation(program, "u_offset");
+    GLint colorLoc = glGetUniformLocation(program, "u_color");
+    GLint modeLoc = glGetUniformLocation(program, "u_mode");
+
+    static const float scale[16] = {
+        0.05f, 0, 0, 0,
+        0, 0.05f, 0, 0,
+        0, 0, 1, 0,
+        0, 0, 0, 1
+    };
+    glUniformMatrix4fv(matLoc, 1, GL_FALSE, scale);
+    if (modeLoc >= 0) glUniform1i(modeLoc, 0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, s_perfVbo);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (const void *)0);
+    glEnableVertexAttribArray(0);
+    for (int i = 0; i < PERF_UNIFORM_DRAWS; i++) {
+        float x = (float)(i % 40) / 20.0f - 1.0f;
+        float y = (float)(i / 40) / 12.5f - 1.0f;
+        glUniform4f(offsetLoc, x, y, 0.0f, 0.0f);
+        glUniform4f(colorLoc, (float)(i & 7) / 7.0f, (float)(frame & 7) / 7.0f, 0.5f, 1.0f);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/* Render, then read the result back on the CPU */
+static void perfFrameReadback(int frame) {
+    GLuint program = getSimpleProgram();
+    glUseProgram(program);
+    glUniform4f(glGetUniformLocation(program, "u_color"), (float)(frame & 1), 0.5f, 0.0f, 1.0f);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 16, s_perfQuad);
+    glEnableVertexAttribArray(0);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glReadPixels(0, 0, PERF_READBACK_SIZE, PERF_READBACK_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, s_perfPixels);
+}
+
+static bool perfInitScenes(void) {
+    if (!getSimpleProgram() || !getTexturedProgram() || !getUniformProgram()) return false;
+
+    s_perfPixels = (GLubyte *)malloc(PERF_UPLOAD_SIZE * PERF_UPLOAD_SIZE * 4);
+    if (!s_perfPixels) return false;
+
+    glGenQueriesEXT(PERF_QUERY_RING, s_perfQueries);
+
+    glGenTextures(2, s_perfTex);
+    glGenFramebuffers(2, s_perfFbo);
+    for (int i = 0; i < 2; i++) {
+        glBindTexture(GL_TEXTURE_2D, s_perfTex[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, PERF_FBO_SIZE, PERF_FBO_SIZE, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindFramebuffer(GL_FRAMEBUFFER, s_perfFbo[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, s_perfTex[i], 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) return false;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    static const float tri[] = { 0.0f, 0.5f, -0.5f, -0.5f, 0.5f, -0.5f };
+    glGenBuffers(1, &s_perfVbo);
+    glBindBuffer(GL_ARRAY_BUFFER, s_perfVbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(tri), tri, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return glGetError() == GL_NO_ERROR;
+}
+
+static void perfFreeScenes(void) {
+    glDeleteBuffers(1, &s_perfVbo);
+    glDeleteFramebuffers(2, s_perfFbo);
+    glDeleteTextures(2, s_perfTex);
+    glDeleteQueriesEXT(PERF_QUERY_RING, s_perfQueries);
+    free(s_perfPixels);
+    s_perfPixels = NULL;
+}
+
+/*--------------------------------------------------------------------------
+ * Baseline
+ *--------------------------------------------------------------------------*/
+
+static void perfWriteJson(FILE *f) {
+    fprintf(f, "{\n  \"frames\": %d,\n  \"scenes\": [\n", PERF_FRAMES);
+    for (int i = 0; i < s_numPerfResults; i++) {
+        const PerfResult *r = &s_perfResults[i];
+        fprintf(f, "    { \"name\": \"%s\"", r->name);
+        for (int m = 0; m < PERF_NUM_TIMES; m++) {
+            fprintf(f, ", \"%s\": %.1f", s_perfTimeKeys[m], perfTime(r, m));
+        }
+        for (size_t c = 0; c < PERF_NUM_COUNTERS; c++) {
+            fprintf(f, ", \"%s\": %u", s_perfCounters[c].key, perfCounter(r, c));
+        }
+        fprintf(f, " }%s\n", i + 1 < s_numPerfResults ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+}
+
+static bool perfWriteFile(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) return false;
+    perfWriteJson(f);
+    fclose(f);
+    return true;
+}
+
+static char *perfReadFile(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *text = size > 0 ? (char *)malloc((size_t)size + 1) : NULL;
+    if (text) {
+        text[fread(text, 1, (size_t)size, f)] = '\0';
+    }
+    fclose(f);
+    return text;
+}
+
+/* Value of "key" in the baseline scene object named name; false if absent.
+ * The baseline is the file perfWriteJson writes: one object per line. */
+static bool perfBaselineValue(const char *json, const char *name, const char *key, double *out) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"name\": \"%s\"", name);
+    const char *scene = strstr(json, pattern);
+    if (!scene) return false;
+    const char *end = strchr(scene, '}');
+
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    const char *value = strstr(scene, pattern);
+    if (!value || (end && value > end)) return false;
+    *out = strtod(value + strlen(pattern), NULL);
+    return true;
+}
+
+/* Print each scene against the baseline; returns the number of regressions */
+static int perfCompare(const char *json, double thresholdPct) {
+    int regressions = 0;
+    printf("\n%-16s %-16s %12s %12s %8s\n", "scene", "metric", "baseline", "now", "change");
+
+    for (int i = 0; i < s_numPerfResults; i++) {
+        const PerfResult *r = &s_perfResults[i];
+        double base;
+
+        for (int m = 0; m < PERF_NUM_TIMES; m++) {
+            double now = perfTime(r, m);
+            if (!perfBaselineValue(json, r->name, s_perfTimeKeys[m], &base)) continue;
+            if (base <= 0.0 || now < 0.0) continue;  /* No GPU timings on one side */
+
+            double pct = (now - base) * 100.0 / base;
+            bool regressed = pct > thresholdPct && now - base > PERF_NOISE_US;
+            printf("%-16s %-16s %12.1f %12.1f %+7.1f%%%s\n", r->name, s_perfTimeKeys[m],
+                   base, now, pct, regressed ? "  REGRESSION" : "");
+            if (regressed) regressions++;
+        }
+
+        for (size_t c = 0; c < PERF_NUM_COUNTERS; c++) {
+            GLuint now = perfCounter(r, c);
+            if (!perfBaselineValue(json, r->name, s_perfCounters[c].key, &base)) continue;
+            if ((double)now > base) {
+                printf("%-16s %-16s %12.0f %12u %8s  REGRESSION\n", r->name,
+                       s_perfCounters[c].key, base, now, "grew");
+                regressions++;
+            }
+        }
+    }
+    return regressions;
+}
+
+static void runPerfMode(bool writeBaseline, double thresholdPct) {
+    printf("\n========================================\n");
+    printf("    PERFORMANCE REGRESSION MODE\n");
+    printf("    %d frames per scene, threshold %.1f%%\n", PERF_FRAMES, thresholdPct);
+    printf("    Press + to abort\n");
+    printf("========================================\n");
+    fflush(stdout);
+
+    padConfigureInput(1, HidNpadStyleSet_NpadStandard);
+    padInitializeDefault(&s_pad);
+    s_padInitialized = true;
+
+    if (!perfInitScenes()) {
+        printf("[FAIL] perf: scene resources failed to initialize\n");
+        perfFreeScenes();
+        return;
+    }
+
+    perfRunScene("texture_upload", perfFrameTextureUpload);
+    perfRunScene("fbo_pingpong", perfFrameFboPingPong);
+    perfRunScene("many_draw", perfFrameManyDraw);
+    perfRunScene("uniform_heavy", perfFrameUniformHeavy);
+    perfRunScene("readback", perfFrameReadback);
+    perfFreeScenes();
+
+    if (s_exitRequested) {
+        printf("[PERF] Aborted, nothing compared or written\n");
+        return;
+    }
+
+    printf("\n%-16s %10s %10s %10s %8s %8s\n", "scene", "cpu_us", "gpu_us", "frame_us", "draws", "barriers");
+    for (int i = 0; i < s_numPerfResults; i++) {
+        const PerfResult *r = &s_perfResults[i];
+        printf("%-16s %10.1f %10.1f %10.1f %8u %8u\n", r->name, r->cpuUs, r->gpuUs, r->frameUs,
+               r->stats.draws, r->stats.barriers);
+    }
+
+    perfWriteFile(PERF_LAST_PATH);
+
+    char *baseline = writeBaseline ? NULL : perfReadFile(PERF_BASELINE_PATH);
+    if (!baseline) {
+        if (perfWriteFile(PERF_BASELINE_PATH)) {
+            printf("\n[PERF] Baseline written to %s\n", PERF_BASELINE_PATH);
+        } else {
+            printf("\n[PERF] Could not write %s, JSON follows:\n", PERF_BASELINE_PATH);
+            perfWriteJson(stdout);
+        }
+        fflush(stdout);
+        return;
+    }
+
+    int regressions = perfCompare(baseline, thresholdPct);
+    free(baseline);
+
+    printf("\n========================================\n");
+    if (regressions == 0) {
+        printf("[PERF] PASS - no regressions against %s\n", PERF_BASELINE_PATH);
+    } else {
+        printf("[PERF] FAIL - %d regression(s) against %s\n", regressions, PERF_BASELINE_PATH);
+    }
+    printf("Results of this run: %s\n", PERF_LAST_PATH);
+    printf("========================================\n");
+    fflush(stdout);
+
+    /* Show the verdict: green or red */
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+    if (regressions == 0) glClearColor(0.0f, 0.5f, 0.0f, 1.0f);
+    else glClearColor(0.5f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    eglSwapBuffers(s_display, s_surface);
+}
+
 /*==========================================================================
  * Print summary
  *==========================================================================*/
@@ -3531,29 +4544,10 @@ static void printSummary(void) {
 }
 
 /*==========================================================================
- * Main
+ * Visual validation run
  *==========================================================================*/
 
-int main(int argc, char* argv[]) {
-    (void)argc; (void)argv;
-
-    Result rc = romfsInit();
-    initNxLink();
-
-    if (R_FAILED(rc)) {
-        printf("[ERROR] romfsInit failed: 0x%x\n", rc);
-        printf("Make sure the NRO was built with --romfsdir\n");
-    } else {
-        printf("[OK] romfsInit succeeded\n");
-    }
-
-    if (!initEgl()) {
-        printf("EGL initialization failed!\n");
-        deinitNxLink();
-        romfsExit();
-        return 1;
-    }
-
+static void runValidationTests(void) {
     printf("\n========================================\n");
     printf("    VISUAL VALIDATION TEST (SwitchGLES)\n");
     printf("    Press A after each test to continue\n");
@@ -3647,6 +4641,11 @@ int main(int argc, char* argv[]) {
         "A RED quad with GREEN center patch\n"
         "(Green from framebuffer was copied to center of red texture)");
 
+    RUN_TEST(testCopyTexMatchesUpload, "glCopyTex*Image2D matches upload",
+        "Black background\n"
+        "Small red/green/blue/yellow quadrant square near center\n"
+        "(Copied texels compared against glTexImage2D of glReadPixels)");
+
     RUN_TEST(testReadPixels, "glReadPixels",
         "Blue-ish background (RGB ~64,128,191)\n"
         "Solid color - used for pixel readback test");
@@ -3704,6 +4703,29 @@ int main(int argc, char* argv[]) {
         "GREEN quad in center\n"
         "(ES 1.00 source transpiled to 4.60, compiled via libuam)");
 
+    RUN_TEST(testStateAfterClearAndSwap, "State after glClear / eglSwapBuffers",
+        "Blue background\n"
+        "GREEN rectangle covering the center half\n"
+        "(Scissor and depth test set once, before a clear and a swap)");
+
+    RUN_TEST(testSamplerReuse, "Sampler Reuse",
+        "Black background, two quads side by side\n"
+        "LEFT: GREEN left part, RED right part (repeat, nearest)\n"
+        "RIGHT: smooth GREEN/RED gradient (repeat, linear)");
+
+    RUN_TEST(testBufferOrphaning, "Buffer Orphaning",
+        "Black background\n"
+        "BLUE square on the left, GREEN on the right, YELLOW at the top\n"
+        "Row of 4 WHITE squares at the bottom");
+
+    RUN_TEST(testPixelPackBuffer, "Pixel Pack Buffer",
+        "GREEN top half, ORANGE bottom half\n"
+        "(Readbacks recorded into a pack buffer, checked after mapping)");
+
+    RUN_TEST(testRenderResolutionReads, "Render Resolution Reads",
+        "RED left half, GREEN right half, slightly soft at the edge\n"
+        "(Rendered at 640x360, read back in surface coordinates)");
+
     /* Print summary */
     printf("[EXIT] About to print summary\n");
     fflush(stdout);
@@ -3726,6 +4748,48 @@ int main(int argc, char* argv[]) {
         printf("\n[DONE] Tests termines - %d/%d PASS\n", passed, s_numResults);
         fflush(stdout);
     }
+}
+
+/*==========================================================================
+ * Main
+ *==========================================================================*/
+
+int main(int argc, char* argv[]) {
+    /* Arguments come from nxlink: nxlink -s validation_test.nro --perf */
+    bool perfMode = false, perfBaseline = false;
+    double perfThreshold = PERF_THRESHOLD_PCT;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--perf") == 0) {
+            perfMode = true;
+        } else if (strcmp(argv[i], "--perf-baseline") == 0) {
+            perfMode = perfBaseline = true;
+        } else if (strncmp(argv[i], "--perf-threshold=", 17) == 0) {
+            perfThreshold = atof(argv[i] + 17);
+        }
+    }
+
+    Result rc = romfsInit();
+    initNxLink();
+
+    if (R_FAILED(rc)) {
+        printf("[ERROR] romfsInit failed: 0x%x\n", rc);
+        printf("Make sure the NRO was built with --romfsdir\n");
+    } else {
+        printf("[OK] romfsInit succeeded\n");
+    }
+
+    if (!initEgl()) {
+        printf("EGL initialization failed!\n");
+        deinitNxLink();
+        romfsExit();
+        return 1;
+    }
+
+    if (perfMode) {
+        runPerfMode(perfBaseline, perfThreshold);
+    } else {
+        runValidationTests();
+    }
 
     /* Unbind current program before cleanup */
     printf("[EXIT] glUseProgram(0)\n");
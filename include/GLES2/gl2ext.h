@@ -331,6 +331,9 @@ GL_APICALL void GL_APIENTRY glEGLImageTargetRenderbufferStorageOES (GLenum targe
 #ifndef GL_DKSH_BINARY_FORMAT_NX
 #define GL_DKSH_BINARY_FORMAT_NX          0x10DE0001
 #endif
+#ifndef GL_SGL_PROGRAM_BINARY_FORMAT_NX
+#define GL_SGL_PROGRAM_BINARY_FORMAT_NX   0x10DE0002
+#endif
 
 #ifndef GL_OES_compressed_paletted_texture
 #define GL_OES_compressed_paletted_texture 1
@@ -29,6 +29,25 @@ extern "C" {
  */
 #define GL_DKSH_BINARY_FORMAT_NX 0x10DE0001
 
+/*
+ * Binary format for glGetProgramBinaryOES / glProgramBinaryOES - both DKSH
+ * stages plus the packed uniform and attribute bindings derived at link time
+ */
+#define GL_SGL_PROGRAM_BINARY_FORMAT_NX 0x10DE0002
+
+/*
+ * Packed vertex attribute types for glVertexAttribPointer (size must be 4).
+ * The OpenGL ES 3.0 layout, x in the low 10 bits, which is what the vertex
+ * fetch unit reads; GL_OES_vertex_type_10_10_10_2 stores x in the high bits
+ * and is not supported.
+ */
+#ifndef GL_INT_2_10_10_10_REV
+#define GL_INT_2_10_10_10_REV           0x8D9F
+#endif
+#ifndef GL_UNSIGNED_INT_2_10_10_10_REV
+#define GL_UNSIGNED_INT_2_10_10_10_REV  0x8368
+#endif
+
 /*
  * sglRegisterUniform - Register a uniform name to a specific shader binding
  *
@@ -110,6 +129,713 @@ GL_APICALL GLboolean GL_APIENTRY sglRegisterPackedUniform(const GLchar *name,
 GL_APICALL void GL_APIENTRY sglSetPackedUBOSize(GLint stage, GLint binding,
                                                   GLint size);
 
+/*
+ * sglGetUniformArenaStats - Report per-frame uniform memory usage
+ *
+ * Non-packed uniforms take a 256-byte slot per binding per draw, and each
+ * packed UBO one slot per command buffer, from a per-frame arena. The arena
+ * starts at 256 KB and chains another 256 KB block (up to 4 MB) when a
+ * frame runs out; blocks are kept for later frames. Returns, in bytes:
+ *
+ *   used       - allocated so far in the current frame
+ *   high_water - most any frame has allocated
+ *   capacity   - currently available across all blocks
+ *
+ * Any pointer may be NULL.
+ */
+GL_APICALL void GL_APIENTRY sglGetUniformArenaStats(GLuint *used, GLuint *high_water, GLuint *capacity);
+
+/*
+ * sglCompactTextureHeap - Defragment GPU texture memory
+ *
+ * Textures are sub-allocated from a GPU heap. Deleting and re-creating
+ * textures over a long session leaves holes that can make a large
+ * allocation fail, or the heap grow, even when enough memory is free in
+ * total. This call moves every live texture down to the lowest free
+ * offset and releases the memory blocks the heap added that end up empty.
+ *
+ * It waits for the GPU to go idle and copies texture memory, so call it
+ * during loading screens, not every frame. Texture names, parameters and
+ * contents are unchanged.
+ */
+GL_APICALL void GL_APIENTRY sglCompactTextureHeap(void);
+
+/*
+ * sglSetTransferQueue - Run texture uploads on a copy-only GPU queue
+ *
+ * By default uploads are recorded into the frame's command list and run on
+ * the graphics queue, in between the draws. Enabled, a second queue with
+ * its own command memory takes the uploads into textures no recorded or
+ * in-flight GPU work uses (new textures, streamed textures before their
+ * first draw). They are submitted as the staged data adds up and at the
+ * next graphics submission at the latest, when the graphics queue is made
+ * to wait for them, so they run while earlier frames still render.
+ *
+ * Uploads into textures already drawn with since the last drain, mipmap
+ * generation, copies between textures and glCopyTex*Image2D stay on the
+ * graphics queue. sglGetFrameStats counts the uploads the queue took in
+ * transfer_copies.
+ *
+ * Disabling waits for the queue's work and destroys it. Returns GL_TRUE if
+ * the transfer queue is in use after the call: always GL_FALSE when
+ * disabling, or when the backend has no such queue.
+ */
+GL_APICALL GLboolean GL_APIENTRY sglSetTransferQueue(GLboolean enable);
+
+/*
+ * sglTexImageFromFile - Load a compressed texture container into the bound texture
+ *
+ * Reads a KTX 1.1, KTX 2.0 (without supercompression) or .astc file, e.g.
+ * from "romfs:/" or "sdmc:/", into the texture bound to target (only
+ * GL_TEXTURE_2D), with every mip level the file contains. Level data is
+ * read straight into GPU upload memory in chunks and copied asynchronously,
+ * so no heap copy of the file is made and reading overlaps the GPU copies.
+ *
+ * Supports the block formats glCompressedTexImage2D accepts; arrays,
+ * cubemaps and 3D images are rejected. Returns GL_FALSE (with
+ * GL_INVALID_OPERATION for an unreadable or unsupported file).
+ */
+GL_APICALL GLboolean GL_APIENTRY sglTexImageFromFile(GLenum target, const GLchar *path);
+
+/*
+ * sglGetBarrierStats - Count GPU barriers for profiling
+ *
+ * Barriers are only recorded when a texture written by the GPU (render
+ * target, copy, upload) is sampled or read back, or when a sampled texture
+ * is rendered to. Returns the totals since initialization:
+ *
+ *   full      - DkBarrier_Full (readbacks, copy engine writes)
+ *   fragments - DkBarrier_Fragments (sampling a render target)
+ *   tiles     - DkBarrier_Tiles (plain render target switches)
+ *
+ * Any pointer may be NULL. Sample it once per frame and diff.
+ */
+GL_APICALL void GL_APIENTRY sglGetBarrierStats(GLuint *full, GLuint *fragments, GLuint *tiles);
+
+/*
+ * sglGetCommandMemoryStats - Measure command buffer memory use
+ *
+ * Every frame slot records into a fixed block (1 MB, see sglSetHeapConfig).
+ * Frames that need more get 256 KB chunks chained from a per-slot pool;
+ * chunks are reused once the slot's frame has finished and freed after
+ * about five seconds without overflow. Returns, in bytes:
+ *
+ *   peak   - most command memory a single frame has had attached
+ *   pooled - currently held in overflow chunks across all slots
+ *
+ * A peak above the block size means a larger cmd_size would avoid chaining.
+ * Any pointer may be NULL.
+ */
+GL_APICALL void GL_APIENTRY sglGetCommandMemoryStats(GLuint *peak, GLuint *pooled);
+
+/*
+ * sglGetMemoryStats - Usage of every GPU memory heap
+ *
+ * One entry per heap, indexed by SGL_MEMORY_HEAP_*, all sizes in bytes:
+ *
+ *   CODE         - Shader code (SGL_CODE_MEM_SIZE)
+ *   BUFFER       - VBO/EBO data, plus client array chunks chained by
+ *                  frames that outgrew their client array region
+ *   TEXTURE      - Texture images (SGL_TEXTURE_MEM_SIZE); renderbuffers
+ *                  have memory of their own and are not counted
+ *   UNIFORM      - The per-frame uniform arena (see sglGetUniformArenaStats)
+ *   CLIENT_ARRAY - The per-frame client vertex array / index region
+ *   STAGING      - The texture upload ring (SGL_STAGING_MEM_SIZE)
+ *   DESCRIPTOR   - Sampler and image descriptors
+ *   COMMAND      - Command memory of one frame (see sglGetCommandMemoryStats)
+ *
+ * used is what is allocated now (for the per-frame heaps: in the frame
+ * being recorded), peak the most ever allocated at once. largest_free is
+ * the biggest single allocation that would succeed without the heap
+ * growing, and fragmentation the percentage of free bytes outside that
+ * range: a texture heap with a high value needs sglCompactTextureHeap.
+ * failed_allocs counts allocations the heap could not satisfy since
+ * initialization; each one was also logged as an SGL_ERROR_BACKEND.
+ * The arenas that grow on demand (uniform, command) report as capacity
+ * what they currently hold.
+ *
+ * The same totals are available through glGetIntegerv with the
+ * GL_NVX_gpu_memory_info enums, in KB: DEDICATED_VIDMEM and
+ * TOTAL_AVAILABLE_MEMORY are the summed capacities, CURRENT_AVAILABLE_VIDMEM
+ * the summed free bytes, EVICTION_COUNT the summed failed_allocs and
+ * EVICTED_MEMORY always 0 (nothing is ever evicted).
+ */
+#define SGL_MEMORY_HEAP_CODE          0
+#define SGL_MEMORY_HEAP_BUFFER        1
+#define SGL_MEMORY_HEAP_TEXTURE       2
+#define SGL_MEMORY_HEAP_UNIFORM       3
+#define SGL_MEMORY_HEAP_CLIENT_ARRAY  4
+#define SGL_MEMORY_HEAP_STAGING       5
+#define SGL_MEMORY_HEAP_DESCRIPTOR    6
+#define SGL_MEMORY_HEAP_COMMAND       7
+#define SGL_MEMORY_HEAP_COUNT         8
+
+typedef struct sgl_memory_heap_stats {
+    GLuint capacity;
+    GLuint used;
+    GLuint peak;
+    GLuint largest_free;
+    GLuint fragmentation;       /* Percent of free bytes outside largest_free */
+    GLuint failed_allocs;
+} sgl_memory_heap_stats_t;
+
+typedef struct sgl_memory_stats {
+    sgl_memory_heap_stats_t heaps[SGL_MEMORY_HEAP_COUNT];
+} sgl_memory_stats_t;
+
+GL_APICALL void GL_APIENTRY sglGetMemoryStats(sgl_memory_stats_t *stats);
+
+/*
+ * sglSetHeapConfig - Size the GPU heaps of contexts created afterwards
+ *
+ * Sizes are in bytes; 0 keeps the default given below. Call it before
+ * eglInitialize, or at least before the eglCreateContext whose heaps it
+ * should size (shared contexts use their share group's heaps). NULL
+ * restores every default. The same sizes can be passed per context as
+ * eglCreateContext attributes, which override this configuration:
+ *
+ *   code_size     EGL_HEAP_CODE_SIZE_SGL     Shader code (4 MB)
+ *   data_size     EGL_HEAP_DATA_SIZE_SGL     VBO/EBO data, client arrays and
+ *                                            the first uniform block (16 MB)
+ *   texture_size  EGL_HEAP_TEXTURE_SIZE_SGL  Texture images (32 MB)
+ *   staging_size  EGL_HEAP_STAGING_SIZE_SGL  Texture upload ring (8 MB)
+ *   cmd_size      EGL_HEAP_COMMAND_SIZE_SGL  Command memory per frame in
+ *                                            flight (1 MB, chained beyond)
+ *   fixed_size    EGL_HEAP_FIXED_SIZE_SGL    See below (GL_FALSE)
+ *
+ * The code, texture and staging memory is only allocated on first use, so
+ * a program that never uploads a texture never pays for them. A full code,
+ * buffer or texture heap adds another memblock of its configured size (or
+ * of the allocation's size, when larger) instead of failing; with
+ * fixed_size set it fails as before. Added texture memory is given back
+ * by sglCompactTextureHeap once it is empty. Growth is reported in
+ * sglGetMemoryStats as a larger capacity.
+ */
+typedef struct sgl_heap_config {
+    GLuint code_size;
+    GLuint data_size;
+    GLuint texture_size;
+    GLuint staging_size;
+    GLuint cmd_size;
+    GLboolean fixed_size;
+} sgl_heap_config_t;
+
+GL_APICALL void GL_APIENTRY sglSetHeapConfig(const sgl_heap_config_t *config);
+
+#define EGL_HEAP_CODE_SIZE_SGL      0x10DE0011
+#define EGL_HEAP_DATA_SIZE_SGL      0x10DE0012
+#define EGL_HEAP_TEXTURE_SIZE_SGL   0x10DE0013
+#define EGL_HEAP_STAGING_SIZE_SGL   0x10DE0014
+#define EGL_HEAP_COMMAND_SIZE_SGL   0x10DE0015
+#define EGL_HEAP_FIXED_SIZE_SGL     0x10DE0016
+
+#ifndef GL_NVX_gpu_memory_info
+#define GL_NVX_gpu_memory_info 1
+#define GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX          0x9047
+#define GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX    0x9048
+#define GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX  0x9049
+#define GL_GPU_MEMORY_INFO_EVICTION_COUNT_NVX            0x904A
+#define GL_GPU_MEMORY_INFO_EVICTED_MEMORY_NVX            0x904B
+#endif
+
+/*
+ * sglSetShaderCachePath - Configure the runtime shader disk cache
+ *
+ * With SGL_ENABLE_RUNTIME_COMPILER, glLinkProgram stores every transpiled
+ * GLSL ES 1.00 stage (DKSH code plus uniform/attribute reflection) in this
+ * directory, keyed by a hash of the source, stage, attribute bindings and
+ * compiler version. Later links of the same shader skip the transpiler and
+ * libuam entirely.
+ *
+ * Parameters:
+ *   path - Cache directory, created on first use
+ *          (default "sdmc:/switch/.sgl_shader_cache"). NULL, "" or a
+ *          path of 256 characters or more disables the cache.
+ *
+ * Call before the first glLinkProgram. Delete the directory to clear it.
+ */
+GL_APICALL void GL_APIENTRY sglSetShaderCachePath(const GLchar *path);
+
+/*
+ * sglLoadShaderBundle - Load every program of a prebuilt shader bundle
+ *
+ * A bundle holds linked programs (GL_SGL_PROGRAM_BINARY_FORMAT_NX binaries,
+ * DKSH stages plus uniform and attribute layout) built from a directory of
+ * GLSL ES 1.00 shaders on the host by tools/shader_bundle
+ * (make -f Makefile.host, see its usage). Loading reads the file once and
+ * creates one program per entry: no transpiler, no libuam and no
+ * sglRegisterUniform calls, so release builds can leave the runtime
+ * compiler out. Attribute locations are the ones the transpiler assigned;
+ * query them with glGetAttribLocation.
+ *
+ * Returns the number of programs loaded, or -1 if the file cannot be read
+ * or is not a bundle. Entries built for another library version are
+ * skipped with a warning. Loading a bundle again reloads the programs of
+ * the same names in place.
+ *
+ * sglGetShaderBundleProgram returns the program loaded from the entry of
+ * that name (the shader file name without .vert/.frag), 0 if none.
+ */
+GL_APICALL GLint GL_APIENTRY sglLoadShaderBundle(const GLchar *path);
+GL_APICALL GLuint GL_APIENTRY sglGetShaderBundleProgram(const GLchar *name);
+
+/*
+ * sglSetFramePacing - Trade throughput for input latency
+ *
+ * The next frame's swapchain image is acquired lazily, at the first clear,
+ * draw or upload after eglSwapBuffers. By default the CPU may then run up
+ * to (swapchain images - 1) frames ahead of the GPU.
+ *
+ * Parameters:
+ *   swapchain_images - 2 (double) or 3 (triple buffering), 0 = default (3).
+ *                      Applies to windows created by later
+ *                      eglCreateWindowSurface calls
+ *   mode             - SGL_FRAME_PACING_THROUGHPUT (default), or
+ *                      SGL_FRAME_PACING_LOW_LATENCY: eglSwapBuffers waits
+ *                      for the GPU to finish the frame, so input sampled
+ *                      after it returns is shown in the very next frame.
+ *                      Applies from the next eglSwapBuffers
+ *
+ * Invalid values leave the configuration unchanged.
+ */
+#define SGL_FRAME_PACING_THROUGHPUT   0
+#define SGL_FRAME_PACING_LOW_LATENCY  1
+
+GL_APICALL void GL_APIENTRY sglSetFramePacing(GLint swapchain_images, GLenum mode);
+
+/*
+ * EGL_SHARED_DEPTH_BUFFER_SGL - eglCreateWindowSurface attribute
+ *
+ *   EGL_TRUE (default) - every swapchain image renders with one shared
+ *                        depth-stencil buffer. Frames run one after the
+ *                        other on the GPU and depth is not kept across
+ *                        eglSwapBuffers (EGL_BUFFER_DESTROYED), so the
+ *                        extra copies only cost memory (~8 MB each docked)
+ *   EGL_FALSE          - one depth-stencil buffer per swapchain image
+ *
+ * Readable with eglQuerySurface.
+ */
+#define EGL_SHARED_DEPTH_BUFFER_SGL   0x10DE0010
+
+/*
+ * sglGetFrameLatency - Report the current frame pacing
+ *
+ *   swapchain_images - images of the current draw surface
+ *   queued_frames    - frames the CPU may queue ahead of the GPU
+ *   acquire_wait_us  - last frame's time blocked acquiring its image
+ *                      and waiting for its slot to be free
+ *   gpu_wait_us      - last eglSwapBuffers' time waiting for the GPU
+ *                      (low latency mode only, otherwise 0)
+ *
+ * Any pointer may be NULL.
+ */
+GL_APICALL void GL_APIENTRY sglGetFrameLatency(GLuint *swapchain_images, GLuint *queued_frames,
+                                               GLuint *acquire_wait_us, GLuint *gpu_wait_us);
+
+/*
+ * sglSetRenderResolution - Render the default framebuffer below surface size
+ *
+ * Frames drawn to the default framebuffer go to an internal target of
+ * width x height, upscaled (linear filter) to the swapchain image when
+ * eglSwapBuffers presents it. Viewport and scissor keep surface
+ * coordinates and are scaled by the implementation; gl_FragCoord, line
+ * widths and point sizes are not. glReadPixels and copies from the default
+ * framebuffer also take surface coordinates: each one upscales the frame
+ * so far before reading, so read once per frame where it matters. Takes
+ * effect from the next frame and turns off
+ * sglSetDynamicResolution. 0, 0 (or the surface size) renders at full size.
+ *
+ * Costs one surface-sized RGBA8 image while in use.
+ * GL_INVALID_VALUE if a size is negative or only one of them is 0.
+ */
+GL_APICALL void GL_APIENTRY sglSetRenderResolution(GLsizei width, GLsizei height);
+
+/*
+ * sglSetDynamicResolution - Scale the render resolution to a GPU time budget
+ *
+ *   target_gpu_us - GPU time per frame to aim for, 0 turns the controller off
+ *                   and renders at full size again
+ *   min_scale     - smallest scale of each surface dimension, in (0, 1]
+ *
+ * Each frame the GPU time of the default framebuffer's frame is measured
+ * with timestamps and the scale moves towards the one expected to meet the
+ * target, within [min_scale, 1]. The measurement used is SGL_FB_NUM - 1
+ * frames old, as the GPU has not finished newer ones. Render sizes are
+ * multiples of 8 pixels. See sglSetRenderResolution for what scaling
+ * affects; sglGetRenderResolution returns the size chosen.
+ *
+ * GL_INVALID_VALUE if target_gpu_us is not 0 and min_scale is outside (0, 1].
+ */
+GL_APICALL void GL_APIENTRY sglSetDynamicResolution(GLuint target_gpu_us, GLfloat min_scale);
+
+/*
+ * sglGetRenderResolution - Size the current frame renders at
+ *
+ * The surface size unless sglSetRenderResolution or sglSetDynamicResolution
+ * lowered it. Any pointer may be NULL.
+ */
+GL_APICALL void GL_APIENTRY sglGetRenderResolution(GLint *width, GLint *height);
+
+/*
+ * sglGetFrameStats - Backend counters of the last completed frame
+ *
+ * Filled in by eglSwapBuffers for the frame it submitted, so the values of
+ * one frame can be read (e.g. for an overlay) while the next is recorded.
+ * Work recorded through sglSubmitRecorders counts towards the frame that
+ * submitted it. All values are zero before the first swap.
+ *
+ * The *_binds counters are deko3d state objects recorded, by GL state group;
+ * state the GL layer found unchanged is never recorded. cmd_mem_used is the
+ * command memory the frame occupied: its fixed block of cmd_mem_size bytes
+ * plus any overflow chunks chained to it.
+ */
+typedef struct sgl_frame_stats {
+    GLuint frame;               /* Number of the frame these values describe */
+    GLuint draws;               /* GPU draw commands (each multi-draw entry counts) */
+    GLuint clears;              /* Clear operations; glClear calls with no draw
+                                   between them are merged into one */
+    GLuint viewport_binds;
+    GLuint scissor_binds;
+    GLuint blend_binds;
+    GLuint depth_stencil_binds;
+    GLuint raster_binds;        /* Cull mode, front face and depth bias */
+    GLuint color_mask_binds;
+    GLuint vertex_binds;        /* Vertex attribute and buffer layouts */
+    GLuint shader_binds;
+    GLuint texture_binds;
+    GLuint descriptor_binds;    /* Image/sampler descriptor set binds */
+    GLuint barriers;
+    GLuint wait_idle_stalls;    /* CPU waits for the whole GPU queue to drain */
+    GLuint client_array_bytes;  /* Client vertex arrays and indices copied */
+    GLuint client_array_chunks; /* Buffer memory chunks chained once the frame's
+                                   client array region was full */
+    GLuint uniform_bytes;       /* Uniform data pushed into the command stream */
+    GLuint transfer_copies;     /* Uploads run on the transfer queue (sglSetTransferQueue) */
+    GLuint cmd_mem_used;
+    GLuint cmd_mem_size;
+} sgl_frame_stats_t;
+
+GL_APICALL void GL_APIENTRY sglGetFrameStats(sgl_frame_stats_t *stats);
+
+/*
+ * sglMultiDrawArrays / sglMultiDrawElements - Batched draws with per-draw uniforms
+ *
+ * Like glMultiDrawArraysEXT / glMultiDrawElementsEXT: program, textures and
+ * vertex state are validated and bound once, then one GPU draw is recorded
+ * per entry. In addition, the current program's packed UBO (stage, binding)
+ * is rebound before draw i so that its first byte is uniform_offsets[i]
+ * bytes into the packed buffer.
+ *
+ * Parameters:
+ *   stage, binding  - Packed UBO as in sglSetPackedUBOSize
+ *   uniform_offsets - drawcount byte offsets, each a multiple of 256 and
+ *                     below the packed UBO size
+ *
+ * Size the packed UBO to hold one 256-byte record per draw and write record
+ * i through the uniform locations plus i * 256, e.g.:
+ *
+ *   sglSetPackedUBOSize(SGL_STAGE_VERTEX, 0, 64 * 256);
+ *   sglRegisterPackedUniform("u_rect", SGL_STAGE_VERTEX, 0, 0);
+ *   GLint loc = glGetUniformLocation(prog, "u_rect");
+ *   for (i = 0; i < 64; i++) {
+ *       glUniform4fv(loc + i * 256, 1, rects[i]);
+ *       offsets[i] = i * 256;
+ *   }
+ *   sglMultiDrawArrays(GL_TRIANGLE_STRIP, firsts, counts, 64,
+ *                      SGL_STAGE_VERTEX, 0, offsets);
+ *
+ * Errors: GL_INVALID_VALUE for a bad stage, binding or offset,
+ * GL_INVALID_OPERATION when the program has no such packed UBO.
+ */
+GL_APICALL void GL_APIENTRY sglMultiDrawArrays(GLenum mode, const GLint *first, const GLsizei *count,
+                                                GLsizei drawcount, GLint stage, GLint binding,
+                                                const GLuint *uniform_offsets);
+GL_APICALL void GL_APIENTRY sglMultiDrawElements(GLenum mode, const GLsizei *count, GLenum type,
+                                                  const void *const *indices, GLsizei drawcount,
+                                                  GLint stage, GLint binding,
+                                                  const GLuint *uniform_offsets);
+
+/*
+ * sglSetDrawSortMode - Reorder opaque draws to minimize state changes
+ *
+ * With a mode other than SGL_DRAW_SORT_NONE (default), glDrawArrays and
+ * glDrawElements (instanced too) whose order the depth test mostly decides
+ * are buffered instead of recorded: blending and stencil test off, depth test
+ * and depth writes on with GL_LESS or GL_GREATER, and every enabled
+ * attribute and the indices in buffer objects. GL_LEQUAL and GL_GEQUAL
+ * draws are recorded in place: they let a later draw at equal depth win,
+ * as multipass and decal rendering rely on. The buffered
+ * draws are recorded sorted, with the program, textures, vertex attributes
+ * and uniforms each had:
+ *
+ *   SGL_DRAW_SORT_STATE - by program, then textures, then vertex layout,
+ *                         then the sglSetDrawSortDepth value
+ *   SGL_DRAW_SORT_DEPTH - by the sglSetDrawSortDepth value first, e.g.
+ *                         front to back to save fragment work, then state
+ *
+ * Draws with equal keys keep their order. Any other draw, a draw after a
+ * fixed-function state change, clears, framebuffer, buffer, texture and
+ * program updates, glReadPixels, glFlush, glFinish, syncs, queries,
+ * recorders and eglSwapBuffers record the buffered draws first.
+ *
+ * Sorting is opt-in because it is not invisible. Where buffered draws
+ * overlap at exactly equal depth, GL_LESS and GL_GREATER keep the first
+ * fragment drawn, and sorting changes which draw is first: coplanar
+ * geometry, and decals or overlays drawn over a surface at its depth, can
+ * change. Only enable it where opaque draws render to a depth buffer (the
+ * depth test decides nothing otherwise) and such draws are absent or use
+ * GL_LEQUAL/GL_GEQUAL.
+ *
+ * Errors: GL_INVALID_ENUM for an unknown mode, GL_INVALID_OPERATION on a
+ * recorder or command list context.
+ */
+#define SGL_DRAW_SORT_NONE   0
+#define SGL_DRAW_SORT_STATE  1
+#define SGL_DRAW_SORT_DEPTH  2
+
+GL_APICALL void GL_APIENTRY sglSetDrawSortMode(GLenum mode);
+
+/*
+ * sglSetDrawSortDepth - Sort key of the following draws
+ *
+ * Draws issued after the call sort by this value, smaller first: pass the
+ * view-space distance of the object for front-to-back order. Ignored while
+ * sorting is off. Default 0.
+ */
+GL_APICALL void GL_APIENTRY sglSetDrawSortDepth(GLfloat depth);
+
+/*
+ * sglBeginConditionalRender / sglEndConditionalRender - Occlusion culling
+ * without CPU stalls
+ *
+ * Draws (glDraw*, glMultiDraw*, sglMultiDraw*) between the two calls are
+ * dropped when the newest result the GPU has already written for the
+ * occlusion query 'id' (GL_ANY_SAMPLES_PASSED_EXT or
+ * GL_ANY_SAMPLES_PASSED_CONSERVATIVE_EXT) passed no samples. That result is
+ * typically last frame's, since the latest begin/end is still in flight.
+ * When no result is available yet the draws go ahead. The decision is made
+ * once, in sglBeginConditionalRender, and never waits for the GPU.
+ *
+ * Issue the query itself on a draw outside the block, e.g. a bounding box
+ * with color and depth writes off, so that a hidden object is still tested
+ * the next frame:
+ *
+ *   glBeginQueryEXT(GL_ANY_SAMPLES_PASSED_EXT, q);
+ *   draw_bounding_box();
+ *   glEndQueryEXT(GL_ANY_SAMPLES_PASSED_EXT);
+ *   sglBeginConditionalRender(q);
+ *   draw_object();
+ *   sglEndConditionalRender();
+ *
+ * Blocks do not nest. Errors: GL_INVALID_OPERATION for an id that is not an
+ * occlusion query, a nested begin or an end without a begin.
+ */
+GL_APICALL void GL_APIENTRY sglBeginConditionalRender(GLuint id);
+GL_APICALL void GL_APIENTRY sglEndConditionalRender(void);
+
+/*
+ * sglGetQueryLastResult - Newest available result of a query, never blocks
+ *
+ * Like glGetQueryObjectui64vEXT(id, GL_QUERY_RESULT_EXT, result), but
+ * returns the newest result the GPU has finished writing instead of waiting
+ * for the latest begin/end. For occlusion queries the result is the exact
+ * number of samples that passed, not a boolean.
+ *
+ * Returns GL_TRUE and writes *result (may be NULL) when a result was
+ * available, GL_FALSE otherwise.
+ */
+GL_APICALL GLboolean GL_APIENTRY sglGetQueryLastResult(GLuint id, GLuint64 *result);
+
+/*
+ * Command recorders - Record draws on worker threads
+ *
+ * A recorder is a secondary command list with its own command, uniform and
+ * client array memory. Typical frame:
+ *
+ *   GL thread:  sglBeginRecorder(rec[i]) for each worker, then start them
+ *   worker i:   sglRecorderMakeCurrent(rec[i]); draw...; sglRecorderMakeCurrent(0)
+ *   GL thread:  join the workers, sglSubmitRecorders(n, rec)
+ *
+ * sglBeginRecorder copies the calling context's GL state (bindings, program,
+ * blend/depth/... state) into the recorder, so each recording starts from
+ * the GL thread's state at that point. Returns GL_FALSE for an unknown
+ * recorder. It also finishes background links and forwards changed
+ * texture parameters, which workers cannot do.
+ *
+ * sglRecorderMakeCurrent routes the calling thread's GL calls into the
+ * recorder (0 returns to the context). One thread per recorder at a time.
+ *
+ * sglSubmitRecorders submits what the GL thread recorded so far, then the
+ * recorders' lists in array order, with full barriers before and after.
+ * Recorder state never leaks into the context. At most 8 recorders exist.
+ *
+ * While recording, only these calls are supported: state setters, glUseProgram,
+ * glUniform*, glBindBuffer/glBindTexture/glActiveTexture, glBindVertexArrayOES,
+ * vertex attribute setup, glClear and glDraw*. In particular:
+ * - No object creation, specification or deletion, on any thread, and no
+ *   changes to buffers, textures or VAOs a recorder uses until submit
+ * - No framebuffer or render target changes between begin and submit;
+ *   recorders draw into the one bound at sglBeginRecorder
+ * - Query uniform locations before recording
+ * - Uniform values set while recording stay in that recording. Values of
+ *   non-packed uniform arrays (sglRegisterUniform) carry over from the
+ *   context for the first element only; set them again while recording
+ */
+GL_APICALL GLuint GL_APIENTRY sglCreateRecorder(void);
+GL_APICALL void GL_APIENTRY sglDeleteRecorder(GLuint recorder);
+GL_APICALL GLboolean GL_APIENTRY sglBeginRecorder(GLuint recorder);
+GL_APICALL void GL_APIENTRY sglRecorderMakeCurrent(GLuint recorder);
+GL_APICALL void GL_APIENTRY sglSubmitRecorders(GLsizei count, const GLuint *recorders);
+
+/*
+ * Command lists - Record a static draw sequence once, replay it every frame
+ *
+ *   list = sglBeginCommandList();
+ *   state setup, glUniform*, glDraw*...
+ *   sglEndCommandList();
+ *   each frame: if (!sglCallCommandList(list)) { delete and record again }
+ *
+ * sglBeginCommandList makes a copy of the context's GL state current on the
+ * calling thread until sglEndCommandList, like a recorder (the same rules
+ * apply while recording). GL calls are recorded rather than executed, and
+ * state changed while recording is dropped at the end. Returns the list
+ * name, 0 on failure or while recording.
+ *
+ * sglCallCommandList replays the recorded commands in one call into the
+ * render target bound at that time, with full barriers before and after.
+ * Uniform values and client array data are captured by value at recording
+ * time; buffers and textures are read at replay time. Returns GL_FALSE,
+ * doing nothing, once a buffer, texture or program the list drew with was
+ * deleted, re-specified (glBufferData, orphaning, glTexImage2D, glTexParameter
+ * changes, glLinkProgram...) or the recording failed.
+ *
+ * sglDeleteCommandList waits for replays of the list still executing.
+ * Errors: GL_INVALID_OPERATION for Begin/Call/Delete while recording and
+ * End when not recording, GL_INVALID_VALUE for Call with an unknown list.
+ */
+GL_APICALL GLuint GL_APIENTRY sglBeginCommandList(void);
+GL_APICALL GLboolean GL_APIENTRY sglEndCommandList(void);
+GL_APICALL GLboolean GL_APIENTRY sglCallCommandList(GLuint list);
+GL_APICALL void GL_APIENTRY sglDeleteCommandList(GLuint list);
+
+/*
+ * sglMarkClientArrayStatic - Declare client vertex data as unchanging
+ *
+ * Client-side vertex arrays are copied into GPU memory on every draw. Draws
+ * reading attributes from [pointer, pointer + size) instead use a copy made
+ * once, on the first such draw.
+ *
+ * Parameters:
+ *   pointer - Start of the region (the glVertexAttribPointer pointer, or
+ *             the start of interleaved data)
+ *   size    - Bytes in the region. 0 forgets the region; do this before
+ *             freeing the memory
+ *
+ * Call again with the same pointer after changing the data. At most 32
+ * regions (shared with sglSetClientArrayPromotion's tracking) exist.
+ * Errors: GL_INVALID_VALUE for a NULL pointer or a negative size,
+ * GL_OUT_OF_MEMORY when every slot holds a marked region.
+ */
+GL_APICALL void GL_APIENTRY sglMarkClientArrayStatic(const void *pointer, GLsizeiptr size);
+
+/*
+ * sglSetClientArrayPromotion - Promote repeated client arrays automatically
+ *
+ * With frames > 0, client arrays are tracked by (pointer, stride). The first
+ * draw of each frame checks a fingerprint of the array. An array unchanged
+ * for the given number of frames is copied into a buffer once and drawn
+ * from it, until its fingerprint changes or a draw reads past the copy.
+ *
+ * The fingerprint samples the data rather than hashing all of it, so
+ * changes it does not cover, or changes made within a frame, are missed.
+ * Only enable this for applications whose client arrays are static or
+ * rewritten as a whole. 0 (default) turns tracking off.
+ */
+GL_APICALL void GL_APIENTRY sglSetClientArrayPromotion(GLuint frames);
+
+/*
+ * sglBeginCapture - Record the GL call stream to a file
+ *
+ * Every GL call of the current context until sglEndCapture is appended to
+ * a binary trace, with the data it read from client memory: buffer and
+ * texture contents, shader sources, client vertex arrays and indices. Each
+ * eglSwapBuffers ends a frame. The trace replays with sglReplay* on the
+ * device or with the host build, to profile a scene without the
+ * application that drew it.
+ *
+ * No GL state is captured with the trace, so begin right after
+ * eglMakeCurrent: a trace started later lacks the objects and state set up
+ * before it. Queries, syncs, recorders and command lists, the sgl*
+ * extensions, glShaderBinary/glProgramBinaryOES and glMultiDraw*EXT are
+ * not captured. Capturing costs a file write per call; the capture stops
+ * (with an error logged) if a write fails.
+ *
+ * Returns:
+ *   GL_FALSE if the file cannot be created, or GL_INVALID_OPERATION when
+ *   a capture is already running or a recorder is current
+ */
+GL_APICALL GLboolean GL_APIENTRY sglBeginCapture(const GLchar *path);
+GL_APICALL void GL_APIENTRY sglEndCapture(void);
+
+/*
+ * sglReplayOpen - Play back a trace written by sglBeginCapture
+ *
+ * sglReplayFrame issues the calls of the next frame, up to and including
+ * its eglSwapBuffers, to the current context; the caller presents. It
+ * returns GL_FALSE once the trace has no calls left. The objects the trace
+ * creates are made anew and the replay maps their names;
+ * sglReplayClose deletes them, so call it with the replaying context
+ * current. A mismatch between the uniform locations of the capture and the
+ * replay is logged once.
+ *
+ * The callback, if set, sees every call after it returns, with the CPU
+ * time spent in it. These are the submission costs of the GL layer and
+ * backend; GPU time is measured with GL_EXT_disjoint_timer_query around
+ * sglReplayFrame.
+ */
+typedef struct sgl_replay sgl_replay_t;
+
+typedef struct sgl_replay_call {
+    const GLchar *name;         /* GL entry point, e.g. "glDrawElements" */
+    GLuint frame;
+    GLuint call;                /* Index of the call within its frame */
+    GLboolean draw;
+    GLuint64 cpu_ns;
+} sgl_replay_call_t;
+
+typedef void (*sgl_replay_callback_t)(const sgl_replay_call_t *call, void *user);
+
+typedef struct sgl_replay_stats {
+    GLuint frame;
+    GLuint calls;
+    GLuint draws;
+    GLuint64 cpu_ns;            /* Time spent in all calls of the frame */
+    GLuint64 draw_ns;           /* The part of cpu_ns spent in draws */
+    GLuint64 bytes;             /* Trace bytes the frame took */
+} sgl_replay_stats_t;
+
+GL_APICALL sgl_replay_t *GL_APIENTRY sglReplayOpen(const GLchar *path);
+GL_APICALL void GL_APIENTRY sglReplaySetCallback(sgl_replay_t *replay, sgl_replay_callback_t callback,
+                                                 void *user);
+GL_APICALL GLboolean GL_APIENTRY sglReplayFrame(sgl_replay_t *replay, sgl_replay_stats_t *stats);
+GL_APICALL void GL_APIENTRY sglReplayClose(sgl_replay_t *replay);
+
+/*
+ * sglSetLogOutput - Choose where SwitchGLES log messages go
+ *
+ * After eglInitialize, logging calls only queue the message; a low
+ * priority thread formats and writes it. Errors are written before the
+ * call returns. Messages are dropped (and counted) if the queue fills up.
+ *
+ * Parameters:
+ *   path - File to append to, e.g. "sdmc:/switch/sgl.log".
+ *          NULL or "" = stdout (nxlink), the default
+ *
+ * Returns:
+ *   GL_FALSE if the file cannot be opened (the output is unchanged)
+ */
+GL_APICALL GLboolean GL_APIENTRY sglSetLogOutput(const GLchar *path);
+
 /*
  * sgl_load_shader_from_file - Load a precompiled deko3d shader from file
  *
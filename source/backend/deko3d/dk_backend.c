@@ -17,7 +17,9 @@
  * - dk_uniform.c    - Uniform buffer operations
  * - dk_shader.c     - Shader loading, program linking/binding
  * - dk_texture.c    - Texture operations
- * - dk_framebuffer.c - Framebuffer operations, read pixels
+ * - dk_framebuffer.c - Framebuffer operations, read pixels, blits
+ * - dk_resolution.c - Dynamic resolution (internal render target, upscale)
+ * - dk_upload.c     - Shared contexts, upload threads
  * - dk_utils.c      - Conversion helpers
  */
 
@@ -60,10 +62,11 @@ const sgl_backend_ops_t dk_backend_ops = {
     .delete_buffer = dk_delete_buffer,
     .buffer_data = dk_buffer_data,
     .buffer_sub_data = dk_buffer_sub_data,
+    .map_buffer = dk_map_buffer,
 
     /* Texture Operations (dk_texture.c) */
     .create_texture = NULL,  /* Handled at GL layer */
-    .delete_texture = NULL,  /* Handled at GL layer */
+    .delete_texture = dk_delete_texture,
     .texture_image_2d = dk_texture_image_2d,
     .texture_sub_image_2d = dk_texture_sub_image_2d,
     .texture_parameter = dk_texture_parameter,
@@ -73,18 +76,24 @@ const sgl_backend_ops_t dk_backend_ops = {
     .copy_tex_sub_image_2d = dk_copy_tex_sub_image_2d,
     .compressed_texture_image_2d = dk_compressed_texture_image_2d,
     .compressed_texture_sub_image_2d = dk_compressed_texture_sub_image_2d,
+    .compressed_texture_stream = dk_compressed_texture_stream,
+    .compact_texture_heap = dk_compact_texture_heap,
+    .set_transfer_queue = dk_set_transfer_queue,
+    .pixel_store = dk_pixel_store,
 
     /* Shader Operations (dk_shader.c) */
     .create_shader = NULL,   /* Handled at GL layer */
-    .delete_shader = NULL,   /* Handled at GL layer */
+    .delete_shader = dk_delete_shader,
     .load_shader_binary = dk_load_shader_binary,
     .load_shader_file = dk_load_shader_file,
 
     /* Program Operations (dk_shader.c) */
     .create_program = NULL,  /* Handled at GL layer */
-    .delete_program = NULL,  /* Handled at GL layer */
+    .delete_program = dk_delete_program,
     .attach_shader = NULL,   /* Handled at GL layer */
     .link_program = dk_link_program,
+    .get_program_code = dk_get_program_code,
+    .load_program_binary = dk_load_program_binary,
     .use_program = NULL,     /* Handled at GL layer */
     .bind_program = dk_bind_program,
 
@@ -93,31 +102,82 @@ const sgl_backend_ops_t dk_backend_ops = {
     .set_uniform_matrix4fv = NULL,
     .alloc_uniform = dk_alloc_uniform,
     .write_uniform = dk_write_uniform,
+    .get_uniform_stats = dk_get_uniform_stats,
 
     /* Vertex Attribute Operations (dk_draw.c) */
     .bind_vertex_attribs = dk_bind_vertex_attribs,
+    .bind_vertex_array = dk_bind_vertex_array,
+    .delete_vertex_array = dk_delete_vertex_array,
 
     /* Draw Operations (dk_draw.c) */
     .draw_arrays = dk_draw_arrays,
     .draw_elements = dk_draw_elements,
+    .upload_indices = dk_upload_indices,
+    .multi_draw_arrays = dk_multi_draw_arrays,
+    .multi_draw_elements = dk_multi_draw_elements,
 
     /* Framebuffer Operations (dk_framebuffer.c) */
     .create_framebuffer = NULL,        /* Handled at GL layer */
     .delete_framebuffer = NULL,        /* Handled at GL layer */
     .bind_framebuffer = dk_bind_framebuffer,
-    .framebuffer_texture = NULL,       /* Handled at GL layer */
+    .framebuffer_texture = dk_framebuffer_texture,
     .check_framebuffer_status = NULL,  /* Handled at GL layer */
+    .draw_buffers = dk_draw_buffers,
+    .blit_framebuffer = dk_blit_framebuffer,
+    .discard_framebuffer = dk_discard_framebuffer,
 
     /* Renderbuffer Operations (dk_framebuffer.c) */
     .renderbuffer_storage = dk_renderbuffer_storage,
     .delete_renderbuffer = dk_delete_renderbuffer,
 
     .read_pixels = dk_read_pixels,
+    .read_pixels_to_buffer = dk_read_pixels_to_buffer,
 
     /* Sync Operations (dk_command.c) */
     .flush = dk_flush,
     .finish = dk_finish,
     .insert_barrier = dk_insert_barrier,
+    .get_barrier_stats = dk_get_barrier_stats,
+    .get_frame_stats = dk_get_frame_stats,
+    .get_cmd_mem_stats = dk_get_cmd_mem_stats,
+    .get_memory_stats = dk_get_memory_stats,
+    .get_state_generation = dk_get_state_generation,
+    .create_sync = dk_create_sync,
+    .delete_sync = dk_delete_sync,
+    .wait_sync = dk_wait_sync,
+
+    /* Recorder Operations (dk_recorder.c) */
+    .create_recorder = dk_create_recorder,
+    .delete_recorder = dk_delete_recorder,
+    .begin_recorder = dk_begin_recorder,
+    .attach_recorder = dk_attach_recorder,
+    .submit_recorders = dk_submit_recorders,
+
+    /* Command List Operations (dk_recorder.c) */
+    .begin_cmdlist = dk_begin_cmdlist,
+    .end_cmdlist = dk_end_cmdlist,
+    .call_cmdlist = dk_call_cmdlist,
+    .delete_cmdlist = dk_delete_cmdlist,
+
+    /* Shared Contexts (dk_upload.c) */
+    .share = dk_share,
+    .attach_upload_thread = dk_attach_upload_thread,
+    .detach_upload_thread = dk_detach_upload_thread,
+
+    /* Query Operations (dk_query.c) */
+    .create_query = dk_create_query,
+    .delete_query = dk_delete_query,
+    .begin_query = dk_begin_query,
+    .end_query = dk_end_query,
+    .query_counter = dk_query_counter,
+    .get_query_result = dk_get_query_result,
+    .get_last_query_result = dk_get_last_query_result,
+    .get_gpu_timestamp = dk_get_gpu_timestamp,
+
+    /* Render Resolution (dk_resolution.c) */
+    .set_render_resolution = dk_set_render_resolution,
+    .set_dynamic_resolution = dk_set_dynamic_resolution,
+    .get_render_resolution = dk_get_render_resolution,
 
     /* Misc Operations (dk_state.c) */
     .set_line_width = NULL,
@@ -187,30 +247,62 @@ void sgl_backend_destroy(sgl_backend_t *be) {
     dk_backend_destroy(be);
 }
 
+/* ============================================================================
+ * Per-Handle Records
+ * ============================================================================ */
+
+const void *dk_record_none(void) {
+    static const union {
+        dk_texture_t texture;
+        dk_shader_record_t shader;
+        dk_program_t program;
+        dk_buffer_t buffer;
+        dk_renderbuffer_t renderbuffer;
+        dk_vtx_cache_t vertex_array;
+        dk_fbo_t fbo;
+    } s_none;
+    return &s_none;
+}
+
 /* ============================================================================
  * Lifecycle Operations
  * ============================================================================ */
 
+/* Requested heap size, or the default; at least min_size, page aligned */
+static uint32_t dk_heap_config_size(GLuint requested, uint32_t default_size, uint32_t min_size) {
+    uint64_t size = requested ? requested : default_size;
+    if (size < min_size) size = min_size;
+    size = SGL_ALIGN_UP(size, (uint64_t)SGL_PAGE_ALIGNMENT);
+    return size > 0x80000000u ? 0x80000000u : (uint32_t)size;
+}
+
 /**
  * Initialize the deko3d backend.
  *
  * Allocates GPU memory for:
  * - Command buffers (one per framebuffer slot for triple buffering)
- * - Shader code memory
  * - Data memory (vertices, indices, uniforms)
- * - Texture memory
  * - Descriptor memory (image and sampler descriptors)
+ * Shader code, texture and staging memory are created on first use.
  *
  * @param be        Backend pointer
  * @param device    Deko3d device handle (unused, already stored)
+ * @param heaps     Heap sizes (sglSetHeapConfig / EGL attributes), 0 fields = defaults
  * @return 0 on success, -1 on failure
  */
-int dk_init(sgl_backend_t *be, void *device) {
+int dk_init(sgl_backend_t *be, void *device, const struct sgl_heap_config *heaps) {
     (void)device;  /* Device already stored in create */
     dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
 
-    printf("[DK] Initializing deko3d backend\n");
-    fflush(stdout);
+    static const sgl_heap_config_t defaults;
+    if (!heaps) heaps = &defaults;
+    bool growable = !heaps->fixed_size;
+    uint32_t code_size = dk_heap_config_size(heaps->code_size, SGL_CODE_MEM_SIZE,
+                                             DK_SHADER_CODE_UNUSABLE_SIZE + 64 * 1024);
+    uint32_t texture_size = dk_heap_config_size(heaps->texture_size, SGL_TEXTURE_MEM_SIZE, 64 * 1024);
+    uint32_t staging_size = dk_heap_config_size(heaps->staging_size, SGL_STAGING_MEM_SIZE, 64 * 1024);
+    dk->cmd_mem_size = dk_heap_config_size(heaps->cmd_size, SGL_CMD_MEM_SIZE, 64 * 1024);
+    dk->data_mem_size = dk_heap_config_size(heaps->data_size, SGL_DATA_MEM_SIZE, 1024 * 1024);
 
     /* Create GPU queue */
     DkQueueMaker queueMaker;
@@ -225,7 +317,7 @@ int dk_init(sgl_backend_t *be, void *device) {
     /* Create command buffer memory and command buffers for each slot */
     for (int i = 0; i < SGL_FB_NUM; i++) {
         DkMemBlockMaker memMaker;
-        dkMemBlockMakerDefaults(&memMaker, dk->device, SGL_CMD_MEM_SIZE);
+        dkMemBlockMakerDefaults(&memMaker, dk->device, dk->cmd_mem_size);
         memMaker.flags = DkMemBlockFlags_CpuUncached | DkMemBlockFlags_GpuCached;
         dk->cmdbuf_memblock[i] = dkMemBlockCreate(&memMaker);
         if (!dk->cmdbuf_memblock[i]) {
@@ -235,31 +327,28 @@ int dk_init(sgl_backend_t *be, void *device) {
 
         DkCmdBufMaker cmdMaker;
         dkCmdBufMakerDefaults(&cmdMaker, dk->device);
+        dk_cmd_pool_init(dk, &dk->cmd_pools[i], i, &cmdMaker);
         dk->cmdbufs[i] = dkCmdBufCreate(&cmdMaker);
         if (!dk->cmdbufs[i]) {
             SGL_ERROR_BACKEND("Failed to create command buffer for slot %d", i);
             return -1;
         }
 
-        dkCmdBufAddMemory(dk->cmdbufs[i], dk->cmdbuf_memblock[i], 0, SGL_CMD_MEM_SIZE);
+        dkCmdBufAddMemory(dk->cmdbufs[i], dk->cmdbuf_memblock[i], 0, dk->cmd_mem_size);
         dk->fence_active[i] = false;
     }
 
     /* Set initial command buffer */
-    dk->cmdbuf = dk->cmdbufs[0];
+    dk->main_stream.cmdbuf = dk->cmdbufs[0];
     dk->current_cmdbuf = 0;
     dk->current_slot = 0;
 
-    /* Create shader code memory */
-    DkMemBlockMaker codeMaker;
-    dkMemBlockMakerDefaults(&codeMaker, dk->device, SGL_CODE_MEM_SIZE);
-    codeMaker.flags = DkMemBlockFlags_CpuUncached | DkMemBlockFlags_GpuCached | DkMemBlockFlags_Code;
-    dk->code_memblock = dkMemBlockCreate(&codeMaker);
-    if (!dk->code_memblock) {
-        SGL_ERROR_BACKEND("Failed to create shader code memory");
-        return -1;
-    }
-    dk->code_offset = 0;
+    /* Shader code memory, created by the first shader.
+     * The GPU prefetches past the end of shader code: keep each block's tail unused */
+    dk_heap_init(&dk->code_heap, "Code", 0, 0);
+    dk_heap_set_backing(&dk->code_heap, dk->device, code_size,
+                        DkMemBlockFlags_CpuUncached | DkMemBlockFlags_GpuCached | DkMemBlockFlags_Code,
+                        DK_SHADER_CODE_UNUSABLE_SIZE, growable);
 
     /* Create data memory (vertices, indices, uniforms)
      * Memory layout:
@@ -268,76 +357,67 @@ int dk_init(sgl_backend_t *be, void *device) {
      * [uniform_base ... end]: Uniform buffers
      */
     DkMemBlockMaker dataMaker;
-    dkMemBlockMakerDefaults(&dataMaker, dk->device, SGL_DATA_MEM_SIZE);
+    dkMemBlockMakerDefaults(&dataMaker, dk->device, dk->data_mem_size);
     dataMaker.flags = DkMemBlockFlags_CpuUncached | DkMemBlockFlags_GpuCached;
     dk->data_memblock = dkMemBlockCreate(&dataMaker);
     if (!dk->data_memblock) {
         SGL_ERROR_BACKEND("Failed to create data memory");
         return -1;
     }
-    dk->data_offset = 256;  /* Reserve offset 0 as error indicator */
-
-    /* Reserve regions within data memory */
-    dk->uniform_base = SGL_DATA_MEM_SIZE - SGL_UNIFORM_BUF_SIZE;
-    dk->uniform_offset = 0;
-    dk->client_array_base = dk->uniform_base - (4 * 1024 * 1024);  /* 4MB for client arrays */
-    dk->client_array_offset = 0;
-    dk->client_array_slot_end = dk->uniform_base - dk->client_array_base;  /* Full region initially */
-
-    /* Create texture memory */
-    DkMemBlockMaker texMaker;
-    dkMemBlockMakerDefaults(&texMaker, dk->device, SGL_TEXTURE_MEM_SIZE);
-    texMaker.flags = DkMemBlockFlags_GpuCached | DkMemBlockFlags_Image;
-    dk->texture_memblock = dkMemBlockCreate(&texMaker);
-    if (!dk->texture_memblock) {
-        SGL_ERROR_BACKEND("Failed to create texture memory");
-        return -1;
-    }
-    dk->texture_offset = 0;
-
-    /* Create descriptor memory */
-    DkMemBlockMaker descMaker;
-    dkMemBlockMakerDefaults(&descMaker, dk->device, SGL_DESCRIPTOR_MEM_SIZE);
-    descMaker.flags = DkMemBlockFlags_CpuUncached | DkMemBlockFlags_GpuCached;
-    dk->descriptor_memblock = dkMemBlockCreate(&descMaker);
-    if (!dk->descriptor_memblock) {
+
+    /* Reserve regions within data memory: 4MB for client arrays, less in small heaps */
+    uint32_t client_array_size = dk->data_mem_size / 4 < 4 * 1024 * 1024 ? dk->data_mem_size / 4
+                                                                         : 4 * 1024 * 1024;
+    dk->uniform_base = dk->data_mem_size - SGL_UNIFORM_BUF_SIZE;
+    dk->main_stream.uniform_offset = 0;
+    dk->main_stream.uniform_num_blocks = 1;
+    dk->client_array_base = dk->uniform_base - client_array_size;
+    dk->main_stream.client_array_base = dk->client_array_base;
+    dk->main_stream.client_array_offset = 0;
+    dk->main_stream.client_array_slot_end = dk->uniform_base - dk->client_array_base;  /* Full region initially */
+
+    /* VBO/EBO allocator owns [256, client_array_base) - offset 0 is the error indicator */
+    dk_buffer_heap_init(dk, growable);
+
+    /* Texture memory, created by the first texture */
+    dk_heap_init(&dk->texture_heap, "Texture", 0, 0);
+    dk_heap_set_backing(&dk->texture_heap, dk->device, texture_size,
+                        DkMemBlockFlags_GpuCached | DkMemBlockFlags_Image, 0, growable);
+
+    /* Upload staging ring, created by the first upload */
+    dk_staging_init(dk, staging_size);
+
+    /* Create descriptor memory: samplers first, then image slots that grow
+     * with the highest texture handle */
+    if (!dk_descriptor_heap_init(dk)) {
         SGL_ERROR_BACKEND("Failed to create descriptor memory");
         return -1;
     }
-
-    /* Set up descriptor addresses
-     * First half: image descriptors, second half: sampler descriptors */
-    DkGpuAddr descBase = dkMemBlockGetGpuAddr(dk->descriptor_memblock);
-    dk->image_descriptor_addr = descBase;
-    dk->sampler_descriptor_addr = descBase + SGL_MAX_TEXTURES * sizeof(DkImageDescriptor);
-    dk->descriptors_bound = false;
+    dk->main_stream.descriptors_bound = false;
+
+    /* Per-handle records - chunks are allocated (zeroed) on first use */
+    sgl_table_init(&dk->textures, sizeof(dk_texture_t));
+    sgl_table_init(&dk->shaders, sizeof(dk_shader_record_t));
+    sgl_table_init(&dk->programs, sizeof(dk_program_t));
+    sgl_table_init(&dk->buffers, sizeof(dk_buffer_t));
+    sgl_table_init(&dk->renderbuffers, sizeof(dk_renderbuffer_t));
+    sgl_table_init(&dk->vertex_arrays, sizeof(dk_vtx_cache_t));
+    sgl_table_init(&dk->fbos, sizeof(dk_fbo_t));
+    sgl_table_init(&dk->cmdlists, sizeof(dk_cmdlist_t *));
+    sgl_lock_init(&dk->share_lock);
 
     /* Initialize texture tracking */
-    memset(dk->texture_initialized, 0, sizeof(dk->texture_initialized));
-    memset(dk->texture_is_cubemap, 0, sizeof(dk->texture_is_cubemap));
-    memset(dk->texture_used_as_rt, 0, sizeof(dk->texture_used_as_rt));
-    memset(dk->cubemap_face_mask, 0, sizeof(dk->cubemap_face_mask));
-    memset(dk->cubemap_needs_barrier, 0, sizeof(dk->cubemap_needs_barrier));
-    memset(dk->shader_loaded, 0, sizeof(dk->shader_loaded));
-    memset(dk->program_shader_valid, 0, sizeof(dk->program_shader_valid));
-
-    /* Initialize renderbuffer tracking */
-    memset(dk->renderbuffer_memblocks, 0, sizeof(dk->renderbuffer_memblocks));
-    memset(dk->renderbuffer_initialized, 0, sizeof(dk->renderbuffer_initialized));
-    memset(dk->renderbuffer_width, 0, sizeof(dk->renderbuffer_width));
-    memset(dk->renderbuffer_height, 0, sizeof(dk->renderbuffer_height));
+    dk_hazard_init(dk);
+    memset(dk->sampler_cache_valid, 0, sizeof(dk->sampler_cache_valid));
+    dk_texture_reset_residency(&dk->main_stream);
+    dk->unpack_alignment = 4;  /* GL default */
 
     dk->state_initialized = true;
 
-    printf("[DK] Backend initialized successfully\n");
-    printf("[DK]   Queue: %p\n", (void*)dk->queue);
-    printf("[DK]   Code memory: %lu KB\n", (unsigned long)(SGL_CODE_MEM_SIZE / 1024));
-    printf("[DK]   Data memory: %lu MB\n", (unsigned long)(SGL_DATA_MEM_SIZE / (1024 * 1024)));
-    printf("[DK]   Texture memory: %lu MB\n", (unsigned long)(SGL_TEXTURE_MEM_SIZE / (1024 * 1024)));
-    printf("[DK]   Uniform region: offset=%u size=%u\n", dk->uniform_base, SGL_UNIFORM_BUF_SIZE);
-    printf("[DK]   Client array region: offset=%u\n", dk->client_array_base);
-    fflush(stdout);
-
+    SGL_INFO(SGL_LOG_CAT_BACKEND, "[BACKEND] deko3d: data %u KB, command %u KB x %d; "
+             "code %u KB, texture %u KB, staging %u KB on first use%s",
+             dk->data_mem_size / 1024, dk->cmd_mem_size / 1024, SGL_FB_NUM, code_size / 1024,
+             texture_size / 1024, staging_size / 1024, growable ? "" : " (fixed size)");
     SGL_TRACE_BACKEND("deko3d backend initialized");
     return 0;
 }
@@ -353,12 +433,9 @@ void dk_shutdown(sgl_backend_t *be) {
     dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
     if (!dk || !dk->state_initialized) return;
 
-    printf("[DK] Shutting down deko3d backend\n");
-    fflush(stdout);
-
     /* Wait for GPU to finish */
     if (dk->queue) {
-        dkQueueWaitIdle(dk->queue);
+        dk_wait_idle(dk);
     }
 
     /* Destroy command buffers and their memory */
@@ -367,37 +444,48 @@ void dk_shutdown(sgl_backend_t *be) {
             dkCmdBufDestroy(dk->cmdbufs[i]);
             dk->cmdbufs[i] = NULL;
         }
+        dk_cmd_pool_shutdown(&dk->cmd_pools[i]);
         if (dk->cmdbuf_memblock[i]) {
             dkMemBlockDestroy(dk->cmdbuf_memblock[i]);
             dk->cmdbuf_memblock[i] = NULL;
         }
     }
 
+    dk_recorder_shutdown(dk);
+    dk_upload_shutdown(dk);
+    dk_transfer_shutdown(dk);
+    dk_query_shutdown(dk);
+    dk_resolution_shutdown(dk);
+
     /* Destroy renderbuffer memory blocks */
-    for (int i = 0; i < SGL_MAX_RENDERBUFFERS; i++) {
-        if (dk->renderbuffer_memblocks[i]) {
-            dkMemBlockDestroy(dk->renderbuffer_memblocks[i]);
-            dk->renderbuffer_memblocks[i] = NULL;
+    for (uint32_t i = 1; i < sgl_table_end(&dk->renderbuffers); i++) {
+        dk_renderbuffer_t *rb = (dk_renderbuffer_t *)sgl_table_get(&dk->renderbuffers, i);
+        if (rb && rb->memblock) {
+            dkMemBlockDestroy(rb->memblock);
+            rb->memblock = NULL;
         }
     }
 
+    sgl_table_destroy(&dk->textures);
+    sgl_table_destroy(&dk->shaders);
+    sgl_table_destroy(&dk->programs);
+    sgl_table_destroy(&dk->buffers);
+    sgl_table_destroy(&dk->renderbuffers);
+    sgl_table_destroy(&dk->vertex_arrays);
+    sgl_table_destroy(&dk->fbos);
+    sgl_table_destroy(&dk->cmdlists);
+
     /* Destroy memory blocks */
-    if (dk->descriptor_memblock) {
-        dkMemBlockDestroy(dk->descriptor_memblock);
-        dk->descriptor_memblock = NULL;
-    }
-    if (dk->texture_memblock) {
-        dkMemBlockDestroy(dk->texture_memblock);
-        dk->texture_memblock = NULL;
-    }
+    dk_descriptor_heap_shutdown(dk);
+    dk_staging_shutdown(dk);
+    dk_uniform_shutdown(&dk->main_stream);
+    dk_heap_destroy(&dk->texture_heap);
+    dk_heap_destroy(&dk->buffer_heap);
+    dk_heap_destroy(&dk->code_heap);
     if (dk->data_memblock) {
         dkMemBlockDestroy(dk->data_memblock);
         dk->data_memblock = NULL;
     }
-    if (dk->code_memblock) {
-        dkMemBlockDestroy(dk->code_memblock);
-        dk->code_memblock = NULL;
-    }
 
     /* Destroy queue */
     if (dk->queue) {
@@ -405,10 +493,66 @@ void dk_shutdown(sgl_backend_t *be) {
         dk->queue = NULL;
     }
 
+    sgl_lock_destroy(&dk->share_lock);
     dk->state_initialized = false;
 
-    printf("[DK] Backend shutdown complete\n");
-    fflush(stdout);
-
     SGL_TRACE_BACKEND("deko3d backend shutdown");
 }
+
+/* ============================================================================
+ * Memory Statistics
+ * ============================================================================ */
+
+/* Arenas allocate linearly: whatever is not used is one free range */
+static void dk_arena_stats(sgl_memory_heap_stats_t *stats, uint32_t capacity, uint32_t used,
+                           uint32_t peak, uint32_t failed) {
+    stats->capacity = capacity;
+    stats->used = used;
+    stats->peak = peak > used ? peak : used;
+    stats->largest_free = capacity > used ? capacity - used : 0;
+    stats->fragmentation = 0;
+    stats->failed_allocs = failed;
+}
+
+void dk_get_memory_stats(sgl_backend_t *be, sgl_memory_stats_t *stats) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    const dk_stream_t *s = &dk->main_stream;
+
+    sgl_lock(&dk->share_lock);  /* Upload threads allocate from these heaps */
+    dk_heap_get_stats(&dk->code_heap, &stats->heaps[SGL_MEMORY_HEAP_CODE]);
+    dk_heap_get_stats(&dk->buffer_heap, &stats->heaps[SGL_MEMORY_HEAP_BUFFER]);
+    dk_heap_get_stats(&dk->texture_heap, &stats->heaps[SGL_MEMORY_HEAP_TEXTURE]);
+    sgl_unlock(&dk->share_lock);
+
+    dk_arena_stats(&stats->heaps[SGL_MEMORY_HEAP_UNIFORM], s->uniform_num_blocks * SGL_UNIFORM_BUF_SIZE,
+                   s->uniform_offset, s->uniform_high_water, s->uniform_failed);
+
+    /* Each frame gets its slot's share of the region */
+    dk_arena_stats(&stats->heaps[SGL_MEMORY_HEAP_CLIENT_ARRAY],
+                   (dk->uniform_base - dk->client_array_base) / SGL_FB_NUM,
+                   s->stats.client_array_bytes, dk->client_array_peak, s->client_array_failed);
+
+    const dk_staging_ring_t *ring = &dk->staging;
+    dk_arena_stats(&stats->heaps[SGL_MEMORY_HEAP_STAGING], ring->size,
+                   (uint32_t)(ring->head - ring->tail), ring->peak, ring->failed);
+
+    uint32_t descriptor_size = DK_IMAGE_DESCRIPTOR_BASE +
+                               dk->image_descriptor_capacity * sizeof(DkImageDescriptor);
+    uint32_t descriptor_used = DK_IMAGE_DESCRIPTOR_BASE +
+                               dk->image_descriptor_high_water * sizeof(DkImageDescriptor);
+    dk_arena_stats(&stats->heaps[SGL_MEMORY_HEAP_DESCRIPTOR], descriptor_size,
+                   descriptor_used, descriptor_used, dk->descriptor_failed);
+
+    /* The frame being recorded: its fixed block, the chunks attached so far
+     * and the idle ones its pool could still attach */
+    const dk_cmd_pool_t *pool = &dk->cmd_pools[dk->current_slot];
+    uint32_t pooled = 0;
+    for (uint32_t i = 0; i < pool->count; i++) pooled += pool->chunk_size[i];
+    uint32_t cmd_failed = 0;
+    for (int slot = 0; slot < SGL_FB_NUM; slot++) cmd_failed += dk->cmd_pools[slot].failed;
+    for (int r = 0; r < DK_MAX_RECORDERS; r++) {
+        if (dk->recorders[r]) cmd_failed += dk->recorders[r]->cmd_pool.failed;
+    }
+    dk_arena_stats(&stats->heaps[SGL_MEMORY_HEAP_COMMAND], dk->cmd_mem_size + pooled,
+                   dk->cmd_mem_size + pool->in_use_bytes, dk->cmd_mem_peak, cmd_failed);
+}
@@ -8,7 +8,429 @@
 
 #include "../sgl_backend.h"
 #include "../../context/sgl_gl_types.h"
+#include "../../util/sgl_table.h"
+#include "../../util/sgl_lock.h"
 #include <deko3d.h>
+#include <GLES2/gl2sgl.h>  /* sgl_frame_stats_t */
+
+/* Sampler descriptor heap - one slot per (min, mag, wrap_s, wrap_t) combination:
+ * 6 min filters x 2 mag filters x 3 wrap_s x 3 wrap_t */
+#define DK_SAMPLER_CACHE_SIZE   (6 * 2 * 3 * 3)
+#define DK_SAMPLER_KEY_NONE     0xFF  /* Texture params changed, key must be recomputed */
+
+/* Image descriptor heap - one slot per texture handle, grown by doubling
+ * (see dk_texture_publish_descriptor). Outgrown descriptor memblocks are
+ * destroyed once the slot that last used them has finished. */
+#define DK_IMAGE_DESCRIPTORS_INITIAL    256
+#define DK_IMAGE_DESCRIPTORS_MAX        (1u << 20)  /* Image id bits of a DkResHandle */
+#define DK_MAX_RETIRED_DESCRIPTORS      8
+#define DK_IMAGE_DESCRIPTOR_BASE        SGL_ALIGN_UP(DK_SAMPLER_CACHE_SIZE * sizeof(DkSamplerDescriptor), SGL_PAGE_ALIGNMENT)  /* After the samplers */
+
+/* Range heap - sub-allocator over a memblock region (see dk_heap.c) */
+typedef struct dk_heap_range {
+    uint32_t offset;
+    uint32_t size;
+} dk_heap_range_t;
+
+#define DK_MAX_HEAP_RANGES      1024
+
+/* Memblock backing part of a heap's offset space: heap offset base is byte 0
+ * of the memblock, [start, end) is the part the heap allocates from. Blocks
+ * a heap adds are DK_HEAP_BLOCK_ALIGN aligned with a gap before them, so
+ * free ranges never coalesce across two memblocks. */
+#define DK_MAX_HEAP_BLOCKS      16
+#define DK_HEAP_BLOCK_ALIGN     (1024 * 1024)
+
+typedef struct dk_heap_block {
+    DkMemBlock memblock;
+    uint32_t base;
+    uint32_t size;               /* Memblock size */
+    uint32_t start;
+    uint32_t end;
+    bool owned;                  /* Created by the heap, destroyed by dk_heap_destroy */
+} dk_heap_block_t;
+
+typedef struct dk_heap {
+    const char *name;            /* For error messages */
+    uint32_t base;
+    uint32_t size;               /* Bytes managed, over every block */
+    dk_heap_block_t blocks[DK_MAX_HEAP_BLOCKS];  /* Sorted by base */
+    uint32_t block_count;
+    DkDevice device;             /* dk_heap_set_backing: NULL = blocks are attached by the owner */
+    uint32_t block_size;         /* Size of created blocks (larger allocations get their own size) */
+    uint32_t block_flags;        /* DkMemBlockFlags of created blocks */
+    uint32_t block_reserve;      /* Unallocated tail of each created block */
+    bool growable;               /* Add blocks when full; otherwise only the first is created */
+    dk_heap_range_t free_list[DK_MAX_HEAP_RANGES];  /* Sorted by offset, coalesced */
+    uint32_t free_count;
+    dk_heap_range_t pending[SGL_FB_NUM][DK_MAX_HEAP_RANGES];  /* Freed, waiting on the slot's fence */
+    uint32_t pending_count[SGL_FB_NUM];
+    uint32_t high_water;         /* End of the highest range ever allocated */
+    uint32_t used;               /* Bytes allocated, pending frees included */
+    uint32_t peak;               /* Most bytes ever allocated at once */
+    uint32_t failed;             /* Allocations that found no free range */
+} dk_heap_t;
+
+/* Upload staging ring - fence-tracked ring over a dedicated memblock (see dk_staging.c).
+ * Uploads that do not fit chain a temporary memblock, destroyed after the slot's fence. */
+#define DK_MAX_STAGING_OVERFLOW 16
+
+/* Streamed texture loads (sglTexImageFromFile): bytes read per staging chunk,
+ * and bytes of copies recorded before the command list is handed to the GPU */
+#define DK_TEXTURE_STREAM_CHUNK  (256 * 1024)
+#define DK_TEXTURE_STREAM_SUBMIT (1024 * 1024)
+
+typedef struct dk_staging_ring {
+    DkMemBlock memblock;
+    uint32_t size;
+    uint64_t head;                  /* Next free position (monotonic, wraps modulo size) */
+    uint64_t tail;                  /* Oldest position the GPU may still read */
+    uint64_t slot_end[SGL_FB_NUM];  /* head after the slot's last allocation */
+    DkMemBlock overflow[SGL_FB_NUM][DK_MAX_STAGING_OVERFLOW];
+    uint32_t overflow_count[SGL_FB_NUM];
+    uint32_t peak;                  /* Most of the ring ever in use */
+    uint32_t failed;                /* Overflow blocks that could not be created */
+} dk_staging_ring_t;
+
+/* Per-slot command memory pool (see dk_cmdmem.c). Chunks chained by the
+ * cmdbuf out-of-memory callback when a frame outgrows its cmd_mem_size block. */
+#define DK_MAX_CMD_CHUNKS           16
+#define DK_CMD_CHUNK_SIZE           (256 * 1024)
+#define DK_CMD_POOL_QUIET_FRAMES    300   /* Resets without overflow before idle chunks are freed */
+
+typedef struct dk_cmd_pool {
+    DkDevice device;
+    int slot;
+    DkMemBlock chunks[DK_MAX_CMD_CHUNKS];   /* [0, in_use) attached to the cmdbuf, rest idle */
+    uint32_t chunk_size[DK_MAX_CMD_CHUNKS];
+    uint32_t count;
+    uint32_t in_use;
+    uint32_t in_use_bytes;
+    uint32_t quiet_frames;
+    uint32_t chunk_min;     /* Smallest chunk to create, doubled up to DK_CMD_CHUNK_SIZE */
+    uint32_t failed;        /* Out-of-memory callbacks that could not add a chunk */
+} dk_cmd_pool_t;
+
+/* Uniform arena (see dk_uniform.c): block 0 is the region at uniform_base in
+ * data_memblock, further SGL_UNIFORM_BUF_SIZE blocks are chained on demand */
+#define DK_MAX_UNIFORM_BLOCKS   16
+
+/* Recording stream - a command buffer plus everything whose validity is tied
+ * to what was recorded into it. dk_stream() returns the calling thread's. */
+typedef struct dk_stream {
+    DkCmdBuf cmdbuf;
+    uint32_t state_generation;  /* Changes whenever recorded state is lost (unique across streams) */
+    bool is_recorder;           /* Records for a recorder or command list (see dk_recorder.c) */
+    struct dk_cmdlist *cmdlist; /* Command list owning the stream, NULL otherwise */
+    struct dk_upload *upload;   /* Upload thread owning the stream, NULL otherwise */
+    bool descriptors_bound;
+    uint32_t descriptor_capacity;   /* image_descriptor_capacity when they were bound */
+
+    /* Uniform arena. Offsets are block * SGL_UNIFORM_BUF_SIZE + offset in block. */
+    uint32_t uniform_offset;        /* Next free arena offset, rewinds with the cmdbuf */
+    DkMemBlock uniform_blocks[DK_MAX_UNIFORM_BLOCKS];  /* Main stream: [0] unused (data_memblock) */
+    uint32_t uniform_num_blocks;    /* Blocks available, including block 0 */
+    uint32_t uniform_high_water;    /* Largest uniform_offset ever reached */
+    uint32_t uniform_failed;        /* Allocations the arena could not satisfy */
+
+    /* Client arrays and indices: [client_array_base + offset, client_array_base + slot_end)
+     * of data_memblock belongs to this stream until its cmdbuf is reset */
+    uint32_t client_array_base;
+    uint32_t client_array_offset;
+    uint32_t client_array_slot_end;
+    uint32_t client_array_failed;   /* Allocations neither the region nor a chunk could hold */
+
+    /* Program and uniform buffers bound in the cmdbuf, valid for bound_state_generation */
+    sgl_handle_t bound_program;
+    DkGpuAddr bound_ubo_addr[2][SGL_MAX_UNIFORMS];  /* [stage][binding] */
+    uint32_t bound_ubo_size[2][SGL_MAX_UNIFORMS];
+    uint32_t bound_state_generation;
+
+    GLuint bound_vertex_array;          /* VAO whose state is bound in the cmdbuf (0 = none) */
+    uint32_t vertex_array_generation;   /* state_generation bound_vertex_array belongs to */
+
+    /* Per-unit residency: the texture handle (image slot + sampler slot)
+     * bound to each unit since the last bindShaders */
+    DkResHandle unit_res_handle[SGL_MAX_TEXTURE_UNITS];
+    uint8_t unit_handle_bound_mask;     /* Units whose unit_res_handle entry is valid */
+    uint32_t unit_residency_generation; /* state_generation the residency above belongs to */
+
+    /* Counters since the last end_frame (recorders: since begin); only the
+     * recording thread touches them, recorders are merged on submit */
+    sgl_frame_stats_t stats;
+} dk_stream_t;
+
+/* Client array chunks a frame may chain past its slot's region (see dk_draw.c) */
+#define DK_MAX_CLIENT_CHUNKS        8
+
+/* Recorder (see dk_recorder.c) - a stream with its own command memory, uniform
+ * blocks and a client array range from buffer_heap, recorded by a worker thread
+ * and submitted by the GL thread */
+#define DK_MAX_RECORDERS            8
+#define DK_RECORDER_CMD_MEM_SIZE    (256 * 1024)
+#define DK_RECORDER_CLIENT_SIZE     (1024 * 1024)
+
+typedef struct dk_recorder {
+    dk_stream_t stream;
+    DkMemBlock cmd_memblock;
+    dk_cmd_pool_t cmd_pool;
+    uint32_t client_offset;     /* buffer_heap range backing the stream's client arrays */
+    DkFence fence;              /* Signaled when the last submitted recording has executed */
+    bool fence_active;
+    bool pending;               /* Recorded since sglBeginRecorder, not yet submitted */
+} dk_recorder_t;
+
+/* Command list (see dk_recorder.c) - a stream recorded once on the GL thread
+ * and replayed from the main cmdbuf with dkCmdBufCallList. Its command
+ * memory, uniform blocks and client array chunks are its own and start
+ * small: a list only holds what was recorded into it. */
+#define DK_CMDLIST_CHUNK_SIZE       (16 * 1024)
+#define DK_CMDLIST_CLIENT_CHUNK     (64 * 1024)
+#define DK_MAX_CMDLIST_CLIENT_CHUNKS 16
+
+typedef struct dk_cmdlist {
+    dk_stream_t stream;
+    dk_cmd_pool_t cmd_pool;
+    DkCmdList list;             /* Finished list, 0 while recording */
+    dk_heap_range_t client_chunks[DK_MAX_CMDLIST_CLIENT_CHUNKS];  /* buffer_heap ranges */
+    uint32_t client_chunk_count;
+    /* Last call: done once submitted and its slot's fence has signaled */
+    bool called;
+    uint32_t call_submit;       /* submit_serial when it was recorded */
+    int call_slot;
+    uint32_t call_frame;        /* slot_frame[call_slot] at the time */
+} dk_cmdlist_t;
+
+/* Query object (see dk_query.c) - each begin writes the next of
+ * DK_QUERY_HISTORY report pairs in query_memblock, so the results of
+ * the frames still in flight are not overwritten */
+#define DK_MAX_QUERIES      SGL_MAX_QUERIES
+#define DK_QUERY_HISTORY    (SGL_FB_NUM + 1)
+
+typedef struct dk_query_instance {
+    bool ended;         /* End report recorded: a result will become available */
+    uint32_t submit;    /* submit_serial when the end report was recorded */
+    int slot;           /* Frame slot and slot_frame[] it was recorded in */
+    uint32_t frame;
+} dk_query_instance_t;
+
+typedef struct dk_query {
+    bool used;
+    GLenum target;      /* GL_TIME_ELAPSED_EXT, GL_TIMESTAMP_EXT or GL_ANY_SAMPLES_PASSED*_EXT */
+    uint32_t current;   /* Instance written by the latest begin */
+    dk_query_instance_t instances[DK_QUERY_HISTORY];
+} dk_query_t;
+
+/* Backend side of an FBO, indexed by GL name (see dk_framebuffer.c) */
+typedef struct dk_fbo {
+    sgl_handle_t color[SGL_MAX_DRAW_BUFFERS];       /* Texture per GL_COLOR_ATTACHMENTi (0 = none) */
+    uint32_t color_layer[SGL_MAX_DRAW_BUFFERS];     /* Cubemap face rendered to (0 for 2D textures) */
+    sgl_handle_t depth_texture; /* Depth texture on GL_DEPTH_ATTACHMENT (GL_OES_depth_texture) */
+    uint8_t draw_buffers;       /* glDrawBuffersEXT mask, bit i = GL_COLOR_ATTACHMENTi */
+    bool draw_buffers_set;      /* draw_buffers specified; attachment 0 only otherwise */
+} dk_fbo_t;
+
+/* Dynamic resolution (see dk_resolution.c) - the default framebuffer renders
+ * into the lower-left render_width x render_height of one surface-sized
+ * image, which end_frame upscales into the swapchain image */
+#define DK_RESOLUTION_ALIGN     8       /* Render sizes are multiples of this */
+
+typedef struct dk_resolution {
+    uint32_t width;                 /* Requested size, 0 = surface size */
+    uint32_t height;
+    uint64_t target_ns;             /* GPU frame time the controller aims for, 0 = off */
+    float min_scale;
+    float scale;                    /* Controller output, fraction of the surface size */
+    float slot_scale[SGL_FB_NUM];   /* Scale each slot's last frame rendered at */
+    bool slot_timed[SGL_FB_NUM];    /* Frame time reports recorded for the slot's last frame */
+    bool timing;                    /* The current frame records frame time reports */
+
+    bool active;                    /* The current frame renders into image */
+    uint32_t render_width;          /* Size of the current frame */
+    uint32_t render_height;
+    DkMemBlock memblock;
+    DkImage image;
+    uint32_t image_width;           /* Surface size image was made for */
+    uint32_t image_height;
+} dk_resolution_t;
+
+/* Upload thread (see dk_upload.c) - a thread whose shared context is current
+ * without a surface records its uploads into a stream of its own and hands
+ * them to a queue of its own, so the GL thread's cmdbuf and queue are never
+ * touched. Staging is a linear block rewound once the thread's fence has
+ * signaled; ranges the thread frees reach the GL thread's slot at that point. */
+#define DK_MAX_UPLOAD_THREADS       4
+#define DK_UPLOAD_CMD_MEM_SIZE      (64 * 1024)
+#define DK_UPLOAD_STAGING_SIZE      (4 * 1024 * 1024)
+#define DK_MAX_UPLOAD_FREES         256
+
+typedef struct dk_upload_free {
+    dk_heap_t *heap;
+    uint32_t offset;
+    uint32_t size;
+} dk_upload_free_t;
+
+typedef struct dk_upload {
+    dk_stream_t stream;
+    DkQueue queue;
+    DkMemBlock cmd_memblock;
+    dk_cmd_pool_t cmd_pool;
+    DkFence fence;
+    bool fence_active;              /* Submitted since the last wait */
+    bool recorded;                  /* Recorded since the last submit */
+    bool transfer_pending;          /* Copy engine writes since the last L2 invalidate */
+    GLint unpack_alignment;         /* GL_UNPACK_ALIGNMENT of the thread's context */
+
+    DkMemBlock staging_memblock;
+    uint32_t staging_offset;
+    DkMemBlock staging_overflow[DK_MAX_STAGING_OVERFLOW];  /* Uploads larger than the block */
+    uint32_t staging_overflow_count;
+
+    dk_upload_free_t frees[DK_MAX_UPLOAD_FREES];
+    uint32_t free_count;
+} dk_upload_t;
+
+/* Transfer queue (see dk_transfer.c) - with sglSetTransferQueue(GL_TRUE) a
+ * copy-only queue takes the GL thread's uploads into textures no recorded
+ * work uses. Its batch is submitted once enough data was staged and before
+ * every graphics submission, which then waits on its fence. Command memory
+ * is recycled once that fence has signaled. */
+#define DK_TRANSFER_CMD_MEM_SIZE    (64 * 1024)
+
+typedef struct dk_transfer {
+    DkQueue queue;                  /* NULL while disabled */
+    DkCmdBuf cmdbuf;
+    DkMemBlock cmd_memblock;
+    dk_cmd_pool_t cmd_pool;
+    DkFence fence;
+    bool fence_active;              /* Submitted since command memory was recycled */
+    bool recorded;                  /* Recorded since the last submit */
+    bool wait_pending;              /* Submitted since the graphics queue last waited */
+    uint32_t staged_bytes;          /* Staging used by uploads since the last submit */
+} dk_transfer_t;
+
+/* Fence sync object (see dk_command.c) - the fence is submitted when the
+ * sync is made, so it can be waited on or dropped at any time */
+#define DK_MAX_SYNCS        SGL_MAX_SYNCS
+
+typedef struct dk_sync {
+    bool used;
+    bool fenced;        /* false: nothing was pending, signaled from the start */
+    bool signaled;      /* A wait has seen the fence signal */
+    DkFence fence;
+} dk_sync_t;
+
+/* Last GPU writer of a texture (see dk_hazard.c) */
+#define DK_WRITE_NONE       0
+#define DK_WRITE_RENDER     1   /* Render target of a draw or clear */
+#define DK_WRITE_TRANSFER   2   /* Copy engine (uploads, blits, copies) */
+
+typedef struct dk_barrier_stats {
+    uint32_t full;
+    uint32_t fragments;
+    uint32_t tiles;
+} dk_barrier_stats_t;
+
+/* Texture record - indexed by texture handle in dk->textures. Fields read
+ * when the texture is bound for sampling or as a render target come first. */
+typedef struct dk_texture {
+    bool initialized;
+    bool is_cubemap;                /* true if texture is cubemap, false if 2D */
+    uint8_t cubemap_face_mask;      /* Bitmask of uploaded cubemap faces (6 bits) */
+    bool cubemap_needs_barrier;     /* true after cubemap complete, cleared after first barrier */
+    uint8_t sampler_key;            /* Sampler heap slot (or DK_SAMPLER_KEY_NONE) */
+    bool descriptor_in_use;         /* Heap slot referenced by recorded/in-flight work */
+    bool graphics_copy;             /* Written on the graphics queue since the last drain */
+    uint8_t write_kind;             /* DK_WRITE_* of the last GPU write (dk_hazard.c) */
+    uint32_t write_epoch;           /* Epoch of the last GPU write */
+    uint32_t sample_epoch;          /* render_epoch of the last sampling bind */
+
+    /* Sampler parameters */
+    GLenum min_filter;
+    GLenum mag_filter;
+    GLenum wrap_s;
+    GLenum wrap_t;
+
+    /* Dimensions and format */
+    uint32_t width;
+    uint32_t height;
+    uint32_t mip_levels;            /* Levels allocated (1 until mips are specified) */
+    DkImageFormat format;
+    GLenum gl_format;               /* Original GL internalformat (for swizzle/bpp) */
+
+    /* Storage within texture_heap */
+    uint32_t mem_offset;
+    uint32_t mem_size;              /* 0 = no storage */
+
+    DkImageDescriptor descriptor;
+    DkImage image;
+    DkImageLayout layout;
+} dk_texture_t;
+
+/* Shader code blob - one DKSH copy in code_heap, shared by every shader and
+ * program record whose code is byte-identical (see dk_shader.c) */
+#define DK_MAX_CODE_BLOBS       1024
+
+typedef struct dk_code_blob {
+    uint32_t hash;                  /* FNV-1a of the DKSH bytes */
+    uint32_t offset;                /* Location in code_heap */
+    uint32_t size;                  /* DKSH bytes; the range is SGL_CODE_ALIGNMENT-aligned */
+    uint32_t refs;                  /* Shader and program records using it, 0 = free entry */
+} dk_code_blob_t;
+
+/* Shader record - indexed by shader handle (temporary storage until link) */
+typedef struct dk_shader_record {
+    DkShader shader;
+    bool loaded;
+    uint32_t code_offset;           /* DKSH location in code_heap */
+    uint32_t code_size;
+} dk_shader_record_t;
+
+/* Program record - shader copies captured at link time, [0]=VS, [1]=FS */
+typedef struct dk_program {
+    DkShader shaders[2];
+    bool shader_valid[2];
+    uint32_t code_offset[2];        /* Code blob of each valid stage; also for glGetProgramBinaryOES */
+    uint32_t code_size[2];
+
+    /* Last uniform-region copy of the packed UBOs, reused while the GL layer
+     * reports no change and the copy's cmdbuf is still current */
+    uint32_t packed_ubo_offset[2][SGL_MAX_PACKED_UBOS];
+    uint32_t packed_ubo_size[2][SGL_MAX_PACKED_UBOS];   /* Aligned, 0 = no copy */
+    uint32_t packed_ubo_generation[2][SGL_MAX_PACKED_UBOS];
+} dk_program_t;
+
+/* Buffer record - indexed by buffer handle */
+typedef struct dk_buffer {
+    uint32_t offset;                /* Range owned in buffer_heap (0 = none) */
+    uint32_t size;
+    bool pack_pending;              /* Readback recorded, not yet waited for */
+    uint32_t pack_generation;       /* state_generation the readback was recorded in */
+    DkFence pack_fence;             /* Signaled after a readback into the buffer */
+} dk_buffer_t;
+
+/* Renderbuffer record - indexed by renderbuffer handle */
+typedef struct dk_renderbuffer {
+    bool initialized;
+    uint32_t width;
+    uint32_t height;
+    DkMemBlock memblock;            /* Dedicated memblock per renderbuffer */
+    DkImage image;
+} dk_renderbuffer_t;
+
+/* Cached deko3d vertex state of a VAO whose attributes all come from VBOs
+ * (see dk_bind_vertex_array). Rebuilt when the GL layout changes; only the
+ * buffer extents are refreshed when a referenced buffer is reallocated. */
+typedef struct dk_vtx_cache {
+    bool valid;
+    int num_attribs;
+    int num_buffers;
+    DkVtxAttribState attribs[SGL_MAX_ATTRIBS];
+    DkVtxBufferState buffers[SGL_MAX_ATTRIBS];
+    DkBufExtents extents[SGL_MAX_ATTRIBS];
+    GLuint buffer_handles[SGL_MAX_ATTRIBS];
+    uint32_t buffer_offsets[SGL_MAX_ATTRIBS];  /* Buffer offsets the extents were built from */
+} dk_vtx_cache_t;
 
 /* deko3d backend-specific data */
 typedef struct dk_backend_data {
@@ -18,42 +440,79 @@ typedef struct dk_backend_data {
     /* Queue */
     DkQueue queue;
 
+    /* Heap sizes resolved from sglSetHeapConfig / EGL attributes at init */
+    uint32_t cmd_mem_size;
+    uint32_t data_mem_size;
+
     /* Command buffers - one per framebuffer slot */
     DkMemBlock cmdbuf_memblock[SGL_FB_NUM];
     DkCmdBuf cmdbufs[SGL_FB_NUM];
-    DkCmdBuf cmdbuf;  /* Active command buffer */
+    dk_cmd_pool_t cmd_pools[SGL_FB_NUM];   /* Overflow chunks, recycled with the slot */
+    uint32_t cmd_mem_peak;                  /* Most command memory one cmdbuf has used */
+    uint32_t client_array_peak;             /* Most client array bytes one frame copied */
     int current_cmdbuf;
 
+    /* Recording streams: the GL thread records into main_stream (whose cmdbuf
+     * is the current slot's), threads attached to a recorder into its own */
+    dk_stream_t main_stream;
+    dk_recorder_t *recorders[DK_MAX_RECORDERS];  /* Indexed by handle - 1, NULL = free */
+    uint32_t generation_counter;    /* Source of every stream's state_generation */
+
     /* Fences for synchronization */
     DkFence fences[SGL_FB_NUM];
     bool fence_active[SGL_FB_NUM];
 
-    /* Shader code memory */
-    DkMemBlock code_memblock;
-    uint32_t code_offset;
+    /* Submission tracking for query results (dk_query.c) */
+    uint32_t submit_serial;             /* Main cmdbuf submissions so far */
+    uint32_t idle_serial;               /* submit_serial at the last queue drain */
+    uint32_t frame_serial;              /* Bumped by every begin_frame */
+    uint32_t slot_frame[SGL_FB_NUM];    /* frame_serial each slot last began */
+
+    /* Fence sync objects - indexed by handle - 1 */
+    dk_sync_t syncs[DK_MAX_SYNCS];
+
+    /* Query objects - indexed by handle - 1 */
+    DkMemBlock query_memblock;
+    dk_query_t queries[DK_MAX_QUERIES];
+
+    /* Shader code memory - created on the first shader, grows by blocks */
+    dk_heap_t code_heap;
+    dk_code_blob_t code_blobs[DK_MAX_CODE_BLOBS];
 
     /* Data memory (vertices, indices, uniforms) */
     DkMemBlock data_memblock;
-    uint32_t data_offset;
 
-    /* Uniform buffer region */
+    /* VBO/EBO sub-allocator over [256, client_array_base), then added blocks.
+     * Block 0 is data_memblock: every data offset resolves through it. */
+    dk_heap_t buffer_heap;
+
+    /* Start of the main stream's uniform arena block 0 in data_memblock */
     uint32_t uniform_base;
-    uint32_t uniform_offset;
 
-    /* Client array region (per-frame, per-slot to avoid GPU race conditions) */
+    /* Client array region [client_array_base, uniform_base), split per slot */
     uint32_t client_array_base;
-    uint32_t client_array_offset;
-    uint32_t client_array_slot_end;  /* End boundary for current slot's sub-region */
 
-    /* Texture memory */
-    DkMemBlock texture_memblock;
-    uint32_t texture_offset;
+    /* Buffer heap chunks the main stream chained this frame once its part of
+     * the client array region ran out; freed (deferred) at the end of the frame */
+    dk_heap_range_t client_chunks[DK_MAX_CLIENT_CHUNKS];
+    uint32_t client_chunk_count;
+
+    /* Texture/compressed upload staging, independent of the client array region */
+    dk_staging_ring_t staging;
+
+    /* Texture memory - created on the first texture, grows by blocks */
+    dk_heap_t texture_heap;
 
-    /* Descriptor memory */
+    /* Descriptor memory - persistent heap written by the CPU: the samplers
+     * (slot = sampler key), then the images (slot = texture handle) */
     DkMemBlock descriptor_memblock;
     DkGpuAddr image_descriptor_addr;
     DkGpuAddr sampler_descriptor_addr;
-    bool descriptors_bound;
+    uint32_t image_descriptor_capacity;     /* Image slots in descriptor_memblock */
+    uint32_t image_descriptor_high_water;   /* Highest image slot ever written + 1 */
+    uint32_t descriptor_failed;             /* Handles the heap could not grow to */
+    DkMemBlock retired_descriptors[SGL_FB_NUM][DK_MAX_RETIRED_DESCRIPTORS];  /* Outgrown, waiting on the slot's fence */
+    uint32_t retired_descriptor_count[SGL_FB_NUM];
     bool cmdbuf_submitted;  /* true after dk_end_frame finishes the cmdbuf */
 
     /* Swapchain (from surface) */
@@ -71,42 +530,40 @@ typedef struct dk_backend_data {
     uint32_t fb_width;
     uint32_t fb_height;
 
-    /* Texture data for binding - store directly, indexed by texture ID */
-    DkImage textures[SGL_MAX_TEXTURES];
-    DkImageDescriptor texture_descriptors[SGL_MAX_TEXTURES];
-    bool texture_initialized[SGL_MAX_TEXTURES];
-    bool texture_is_cubemap[SGL_MAX_TEXTURES];  /* true if texture is cubemap, false if 2D */
-    bool texture_used_as_rt[SGL_MAX_TEXTURES];  /* true if texture was used as FBO render target */
-    uint8_t cubemap_face_mask[SGL_MAX_TEXTURES]; /* bitmask of uploaded cubemap faces (6 bits) */
-    bool cubemap_needs_barrier[SGL_MAX_TEXTURES]; /* true after cubemap complete, cleared after first barrier */
-
-    /* Texture dimensions and mipmap info - indexed by texture ID */
-    uint32_t texture_width[SGL_MAX_TEXTURES];
-    uint32_t texture_height[SGL_MAX_TEXTURES];
-    uint32_t texture_mip_levels[SGL_MAX_TEXTURES];
-    DkImageFormat texture_format[SGL_MAX_TEXTURES];
-    GLenum texture_gl_format[SGL_MAX_TEXTURES];  /* Original GL internalformat (for swizzle/bpp) */
-
-    /* Texture sampler parameters - indexed by texture ID */
-    GLenum texture_min_filter[SGL_MAX_TEXTURES];
-    GLenum texture_mag_filter[SGL_MAX_TEXTURES];
-    GLenum texture_wrap_s[SGL_MAX_TEXTURES];
-    GLenum texture_wrap_t[SGL_MAX_TEXTURES];
-
-    /* Renderbuffer depth images - indexed by renderbuffer ID */
-    DkImage renderbuffer_images[SGL_MAX_RENDERBUFFERS];
-    DkMemBlock renderbuffer_memblocks[SGL_MAX_RENDERBUFFERS];  /* Dedicated memblock per renderbuffer */
-    bool renderbuffer_initialized[SGL_MAX_RENDERBUFFERS];
-    uint32_t renderbuffer_width[SGL_MAX_RENDERBUFFERS];
-    uint32_t renderbuffer_height[SGL_MAX_RENDERBUFFERS];
-
-    /* Shader data - indexed by shader handle (temporary storage until link) */
-    DkShader dk_shaders[SGL_MAX_SHADERS];
-    bool shader_loaded[SGL_MAX_SHADERS];
-
-    /* Per-program shader copies - captured at link time */
-    DkShader program_shaders[SGL_MAX_PROGRAMS][2];  /* [prog][0]=VS, [prog][1]=FS */
-    bool program_shader_valid[SGL_MAX_PROGRAMS][2]; /* [prog][0]=VS valid, [prog][1]=FS valid */
+    /* Internal render target of the default framebuffer (sglSetRenderResolution) */
+    dk_resolution_t resolution;
+
+    /* Per-handle records (dk_texture() etc. in dk_internal.h) */
+    sgl_table_t textures;           /* dk_texture_t */
+    sgl_table_t shaders;            /* dk_shader_record_t */
+    sgl_table_t programs;           /* dk_program_t */
+    sgl_table_t buffers;            /* dk_buffer_t */
+    sgl_table_t renderbuffers;      /* dk_renderbuffer_t */
+    sgl_table_t vertex_arrays;      /* dk_vtx_cache_t */
+    sgl_table_t fbos;               /* dk_fbo_t */
+    sgl_table_t cmdlists;           /* dk_cmdlist_t * */
+
+    bool upload_barrier_pending;  /* Uploads recorded since the last texture cache invalidate */
+    GLint unpack_alignment;       /* GL_UNPACK_ALIGNMENT for client pixel rows */
+
+    /* Share group (dk_upload.c): once a second context joined, resource ops
+     * from any thread and the reclaim of deferred frees hold share_lock */
+    sgl_lock_t share_lock;
+    bool shared;
+    dk_upload_t *uploads[DK_MAX_UPLOAD_THREADS];  /* Attached upload threads, NULL = free */
+    dk_transfer_t transfer;         /* Copy-only queue of the GL thread (dk_transfer.c) */
+
+    /* Render target hazard tracking (dk_hazard.c), per texture in dk_texture_t */
+    uint32_t default_fb_write_epoch;  /* render_epoch of the last draw into the default framebuffer */
+    uint32_t render_epoch;            /* Bumped by barriers resolving render target writes */
+    uint32_t transfer_epoch;          /* Bumped by barriers resolving copy engine writes */
+    bool tiles_pending;               /* Rendered since the last barrier of any kind */
+    dk_barrier_stats_t barrier_stats; /* Barriers recorded since init, by kind */
+    sgl_frame_stats_t frame_stats;    /* Counters of the last frame end_frame submitted */
+
+    /* Sampler heap slots already written, one per (min, mag, wrap_s, wrap_t) key */
+    bool sampler_cache_valid[DK_SAMPLER_CACHE_SIZE];
+    bool descriptors_dirty;  /* Heap rewritten by the CPU, GPU descriptor cache must be invalidated */
 
     /* Program uniform tracking */
     sgl_uniform_binding_t *current_vertex_uniforms;
@@ -119,6 +576,9 @@ typedef struct dk_backend_data {
     sgl_handle_t current_fbo;        /* Currently bound FBO (0 = default) */
     sgl_handle_t current_fbo_color;  /* Color attachment texture */
     sgl_handle_t current_fbo_depth;  /* Depth attachment renderbuffer */
+    sgl_handle_t current_fbo_depth_tex;  /* Depth attachment texture, when no renderbuffer is */
+    sgl_handle_t current_fbo_targets[SGL_MAX_DRAW_BUFFERS];  /* Textures bound as color targets (0 = none) */
+    bool default_draw_none;          /* glDrawBuffersEXT(GL_NONE) on the default framebuffer */
 } dk_backend_data_t;
 
 /* Backend operations table */
@@ -135,10 +595,12 @@ DkBlendFactor dk_convert_blend_factor(GLenum factor);
 DkBlendOp dk_convert_blend_op(GLenum op);
 DkPrimitive dk_convert_primitive(GLenum mode);
 DkImageFormat dk_convert_format(GLenum internalformat, GLenum format, GLenum type);
+GLenum dk_packed16_type(DkImageFormat format);  /* GL type of a 16-bit format, else 0 */
 
 /* Vertex attribute helpers */
 void dk_get_attrib_format(GLenum type, GLint size, GLboolean normalized,
                           DkVtxAttribSize *outSize, DkVtxAttribType *outType);
 GLsizei dk_get_type_size(GLenum type);
+GLsizei dk_get_attrib_size(GLenum type, GLint size);
 
 #endif /* DK_BACKEND_H */
@@ -7,29 +7,64 @@
  * - Buffer data upload (glBufferData)
  * - Buffer sub-data update (glBufferSubData)
  *
- * Buffers are allocated from a single large memory block (data_memblock).
- * The allocation is a simple bump allocator that does not support deallocation.
+ * Buffers are sub-allocated from the [256, client_array_base) range of
+ * data_memblock, then from memblocks added when that is full, through a
+ * dk_heap_t (see dk_heap.c); ranges released
+ * by glDeleteBuffers or a resizing glBufferData are parked on the current
+ * slot's pending list and only become reusable once that slot's fence has
+ * signaled, so the GPU never reads memory that was handed out again.
+ * GL_DYNAMIC_DRAW / GL_STREAM_DRAW buffers are renamed the same way on every
+ * glBufferData (and full-size glBufferSubData) instead of being overwritten.
+ *
+ * Pixel pack buffers written by dk_read_pixels_to_buffer() carry a fence;
+ * mapping waits for it.
  */
 
 #include "dk_internal.h"
 
+/* ============================================================================
+ * Range Management (internal)
+ * ============================================================================ */
+
+void dk_buffer_heap_init(dk_backend_data_t *dk, bool growable) {
+    /* Offset 0 is reserved as the error indicator */
+    dk_heap_init(&dk->buffer_heap, "Buffer", 256, dk->client_array_base - 256);
+    dk_heap_attach(&dk->buffer_heap, dk->data_memblock, 0, dk->data_mem_size);
+    dk_heap_set_backing(&dk->buffer_heap, dk->device, dk->data_mem_size,
+                        DkMemBlockFlags_CpuUncached | DkMemBlockFlags_GpuCached, 0, growable);
+}
+
+/* Release a buffer's range once the GPU is done with the current slot */
+static void dk_buffer_release(dk_backend_data_t *dk, dk_buffer_t *buf) {
+    if (buf->offset == 0) return;
+
+    dk_defer_free(dk, &dk->buffer_heap, buf->offset, buf->size);
+    buf->offset = 0;
+    buf->size = 0;
+    buf->pack_pending = false;  /* A pending readback targets the old range */
+}
+
 /* ============================================================================
  * Buffer Handle Management
  *
- * Note: Backend doesn't allocate separate handles - uses data_memblock offsets.
- * Handle management is done at the GL layer.
+ * Note: Backend doesn't allocate separate handles - ranges are tracked per
+ * GL buffer name. Handle management is done at the GL layer.
  * ============================================================================ */
 
 sgl_handle_t dk_create_buffer(sgl_backend_t *be) {
     (void)be;
-    /* Backend doesn't allocate separate handles - uses data_memblock offsets */
+    /* Backend doesn't allocate separate handles - uses buffer heap offsets */
     return 1;  /* Non-zero to indicate success */
 }
 
 void dk_delete_buffer(sgl_backend_t *be, sgl_handle_t handle) {
-    (void)be;
-    (void)handle;
-    /* Memory is in a pool, not individually freed */
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+
+    dk_buffer_t *buf = (dk_buffer_t *)sgl_table_get(&dk->buffers, handle);
+    if (handle == 0 || !buf) return;
+    dk_buffer_release(dk, buf);
+
+    SGL_TRACE_BUFFER("delete_buffer handle=%u", handle);
 }
 
 /* ============================================================================
@@ -38,27 +73,40 @@ void dk_delete_buffer(sgl_backend_t *be, sgl_handle_t handle) {
 
 uint32_t dk_buffer_data(sgl_backend_t *be, sgl_handle_t handle, GLenum target,
                         GLsizeiptr size, const void *data, GLenum usage) {
-    (void)handle;
     (void)target;
-    (void)usage;
 
     dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
 
-    /* Allocate from data memory with 256-byte alignment */
-    uint32_t aligned_offset = SGL_ALIGN_UP(dk->data_offset, SGL_UNIFORM_ALIGNMENT);
-    if (aligned_offset + size > dk->client_array_base) {
-        SGL_ERROR_BACKEND("Buffer allocation failed: out of memory");
-        return 0;
+    dk_buffer_t *buf = handle ? (dk_buffer_t *)sgl_table_ensure(&dk->buffers, handle) : NULL;
+    if (!buf) return 0;
+
+    uint32_t aligned_size = SGL_ALIGN_UP((uint32_t)size, SGL_UNIFORM_ALIGNMENT);
+
+    /* Static buffers keep their range in place when the size is unchanged.
+     * Dynamic/stream buffers are orphaned: the old range stays valid for
+     * frames in flight and is reclaimed after the fence, while the CPU
+     * writes into a fresh range. */
+    bool orphan = (usage == GL_DYNAMIC_DRAW || usage == GL_STREAM_DRAW);
+    if (aligned_size == 0 || orphan || buf->size != aligned_size) {
+        dk_buffer_release(dk, buf);
+        if (aligned_size == 0) return 0;
+
+        uint32_t offset;
+        if (!dk_heap_alloc(&dk->buffer_heap, aligned_size, SGL_UNIFORM_ALIGNMENT, &offset)) {
+            SGL_ERROR_BACKEND("Buffer allocation failed: out of memory");
+            return 0;
+        }
+        buf->offset = offset;
+        buf->size = aligned_size;
     }
 
     /* Copy data if provided */
     if (data && size > 0) {
-        void *dst = (uint8_t*)dkMemBlockGetCpuAddr(dk->data_memblock) + aligned_offset;
+        void *dst = dk_heap_cpu_addr(&dk->buffer_heap, buf->offset);
         memcpy(dst, data, size);
     }
 
-    dk->data_offset = aligned_offset + size;
-    return aligned_offset;
+    return buf->offset;
 }
 
 /* ============================================================================
@@ -71,7 +119,37 @@ void dk_buffer_sub_data(sgl_backend_t *be, sgl_handle_t handle,
     dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
 
     if (data && size > 0) {
-        void *dst = (uint8_t*)dkMemBlockGetCpuAddr(dk->data_memblock) + buffer_offset;
+        void *dst = dk_heap_cpu_addr(&dk->buffer_heap, buffer_offset);
         memcpy(dst, data, size);
     }
 }
+
+/* ============================================================================
+ * Buffer Mapping
+ * ============================================================================ */
+
+void *dk_map_buffer(sgl_backend_t *be, sgl_handle_t handle) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+
+    dk_buffer_t *buf = dk_buffer_rw(dk, handle);
+    if (handle == 0 || !buf || buf->offset == 0) return NULL;
+
+    if (buf->pack_pending && !dkQueueIsInErrorState(dk->queue)) {
+        if (buf->pack_generation == dk->main_stream.state_generation && !dk->cmdbuf_submitted) {
+            /* Upload threads cannot drain the GL thread's queue */
+            if (dk_upload_current(dk)) {
+                SGL_ERROR_BUFFER("map_buffer handle=%u: readback still recording on the GL thread", handle);
+                return NULL;
+            }
+            /* Mapped in the frame that recorded the readback: its fence has
+             * not been submitted yet, so this has to stall */
+            SGL_TRACE_BUFFER("map_buffer handle=%u: readback still recording, draining", handle);
+            dk_drain_queue(dk);
+        } else {
+            dkFenceWait(&buf->pack_fence, -1);
+        }
+    }
+    buf->pack_pending = false;
+
+    return dk_heap_cpu_addr(&dk->buffer_heap, buf->offset);
+}
@@ -2,10 +2,12 @@
  * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
  * deko3d Backend - Clear Operations
  *
- * This module handles framebuffer clearing:
- * - Color buffer clear
- * - Depth buffer clear
- * - Stencil buffer clear
+ * The GL layer merges the glClear calls before a draw (gl_clear.c), so
+ * color, depth and stencil are cleared here in one operation:
+ * - No barrier: the render target's write epochs (dk_hazard.c) order the
+ *   clear against later reads, like a draw.
+ * - The render target stays bound. Scissor and depth-stencil state are
+ *   overridden; the GL layer re-emits both from its state at the next draw.
  */
 
 #include "dk_internal.h"
@@ -16,18 +18,22 @@
 
 void dk_clear(sgl_backend_t *be, GLbitfield mask, const float *color, float depth, int stencil) {
     dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_stream_t *s = dk_stream(dk);
 
     /* Set large scissor BEFORE any clears to ensure full buffer is cleared */
     DkScissor fullScissor = { 0, 0, 4096, 4096 };
-    dkCmdBufSetScissors(dk->cmdbuf, 0, &fullScissor, 1);
+    dkCmdBufSetScissors(s->cmdbuf, 0, &fullScissor, 1);
 
     if (mask & GL_COLOR_BUFFER_BIT) {
-        dkCmdBufClearColorFloat(dk->cmdbuf, 0, DkColorMask_RGBA,
-            color[0], color[1], color[2], color[3]);
-
-        /* Add barrier after color clear to ensure it's committed before any RT switch
-         * Include L2Cache invalidation for proper cache coherency with subsequent sampling */
-        dkCmdBufBarrier(dk->cmdbuf, DkBarrier_Full, DkInvalidateFlags_Image | DkInvalidateFlags_L2Cache);
+        /* Every color target drawn to (glDrawBuffersEXT) is cleared */
+        for (uint32_t i = 0; i < SGL_MAX_DRAW_BUFFERS; i++) {
+            bool bound = dk->current_fbo != 0 ? dk->current_fbo_targets[i] != 0
+                                              : i == 0 && !dk->default_draw_none;
+            if (!bound) continue;
+            dkCmdBufClearColorFloat(s->cmdbuf, i, DkColorMask_RGBA,
+                color[0], color[1], color[2], color[3]);
+        }
+        dk_hazard_render_write(dk);
     }
 
     if (mask & (GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT)) {
@@ -38,26 +44,15 @@ void dk_clear(sgl_backend_t *be, GLbitfield mask, const float *color, float dept
         dkDepthStencilStateDefaults(&dsState);
         dsState.depthTestEnable = false;  /* Test off for clear */
         dsState.depthWriteEnable = true;  /* Write MUST be on for clear to work */
-        dkCmdBufBindDepthStencilState(dk->cmdbuf, &dsState);
+        dkCmdBufBindDepthStencilState(s->cmdbuf, &dsState);
 
         bool clearDepth = (mask & GL_DEPTH_BUFFER_BIT) != 0;
         uint8_t stencilMask = (mask & GL_STENCIL_BUFFER_BIT) ? 0xFF : 0x00;
-        dkCmdBufClearDepthStencil(dk->cmdbuf, clearDepth, depth, stencilMask, (uint8_t)stencil);
-
-        /* Barrier after depth/stencil clear - include Image and L2Cache invalidation */
-        dkCmdBufBarrier(dk->cmdbuf, DkBarrier_Full, DkInvalidateFlags_Image | DkInvalidateFlags_L2Cache);
-
-        /* Rebind render target after depth clear if FBO is active */
-        if (dk->current_fbo != 0 && dk->current_fbo_color > 0 && dk->current_fbo_depth > 0) {
-            if (dk->current_fbo_color < SGL_MAX_TEXTURES && dk->texture_initialized[dk->current_fbo_color] &&
-                dk->current_fbo_depth < SGL_MAX_RENDERBUFFERS && dk->renderbuffer_initialized[dk->current_fbo_depth]) {
-                DkImageView colorView, depthView;
-                dkImageViewDefaults(&colorView, &dk->textures[dk->current_fbo_color]);
-                dkImageViewDefaults(&depthView, &dk->renderbuffer_images[dk->current_fbo_depth]);
-                dkCmdBufBindRenderTarget(dk->cmdbuf, &colorView, &depthView);
-            }
-        }
+        dkCmdBufClearDepthStencil(s->cmdbuf, clearDepth, depth, stencilMask, (uint8_t)stencil);
+        if (!s->is_recorder) dk->tiles_pending = true;
     }
 
+    s->stats.clears++;
+
     SGL_TRACE_DRAW("clear mask=0x%X", mask);
 }
@@ -0,0 +1,144 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * deko3d Backend - Command Memory Pool
+ *
+ * Each slot's command buffer starts with its fixed cmd_mem_size block.
+ * When recording runs past it, deko3d calls the out-of-memory callback,
+ * which hands the command buffer another chunk from the slot's pool:
+ * - Chunks stay owned by the slot while its cmdbuf may still be executing
+ * - Once the slot's fence has signaled (or the GPU is idle) the cmdbuf is
+ *   cleared and every chunk becomes idle again for the next frame
+ * - Idle chunks are destroyed after DK_CMD_POOL_QUIET_FRAMES resets in a
+ *   row that did not need them
+ * Recorders (dk_recorder.c) chain chunks the same way from a pool of their own.
+ * Command lists have no fixed block: their pools start at DK_CMDLIST_CHUNK_SIZE
+ * and double the size of each new chunk up to DK_CMD_CHUNK_SIZE.
+ */
+
+#include "dk_internal.h"
+
+/* ============================================================================
+ * Out-of-Memory Callback
+ * ============================================================================ */
+
+static void dk_cmd_pool_add_mem(void *user_data, DkCmdBuf cmdbuf, size_t min_size) {
+    dk_cmd_pool_t *pool = (dk_cmd_pool_t *)user_data;
+    uint32_t size = SGL_ALIGN_UP((uint32_t)min_size, SGL_PAGE_ALIGNMENT);
+    if (size < pool->chunk_min) size = pool->chunk_min;
+
+    /* Chunks [0, in_use) are attached to the cmdbuf; look for a big enough idle one */
+    uint32_t pick = pool->count;
+    for (uint32_t i = pool->in_use; i < pool->count; i++) {
+        if (pool->chunk_size[i] >= size) {
+            pick = i;
+            break;
+        }
+    }
+
+    if (pick == pool->count) {
+        if (pool->count >= DK_MAX_CMD_CHUNKS) {
+            pool->failed++;
+            SGL_ERROR_BACKEND("cmdmem: slot %d out of command memory (%u chunks)", pool->slot, pool->count);
+            return;
+        }
+        DkMemBlockMaker maker;
+        dkMemBlockMakerDefaults(&maker, pool->device, size);
+        maker.flags = DkMemBlockFlags_CpuUncached | DkMemBlockFlags_GpuCached;
+        DkMemBlock block = dkMemBlockCreate(&maker);
+        if (!block) {
+            pool->failed++;
+            SGL_ERROR_BACKEND("cmdmem: failed to allocate %u byte chunk", size);
+            return;
+        }
+        pool->chunks[pool->count] = block;
+        pool->chunk_size[pool->count] = size;
+        pool->count++;
+        if (pool->chunk_min < DK_CMD_CHUNK_SIZE) pool->chunk_min *= 2;
+    }
+
+    /* Move the chunk into the in-use prefix */
+    uint32_t slot = pool->in_use++;
+    if (pick != slot) {
+        DkMemBlock block = pool->chunks[pick];
+        uint32_t block_size = pool->chunk_size[pick];
+        pool->chunks[pick] = pool->chunks[slot];
+        pool->chunk_size[pick] = pool->chunk_size[slot];
+        pool->chunks[slot] = block;
+        pool->chunk_size[slot] = block_size;
+    }
+    pool->in_use_bytes += pool->chunk_size[slot];
+
+    dkCmdBufAddMemory(cmdbuf, pool->chunks[slot], 0, pool->chunk_size[slot]);
+    SGL_TRACE_BACKEND("cmdmem: slot %d chained chunk %u (%u bytes)", pool->slot, slot, pool->chunk_size[slot]);
+}
+
+/* ============================================================================
+ * Setup / Teardown
+ * ============================================================================ */
+
+void dk_cmd_pool_init(dk_backend_data_t *dk, dk_cmd_pool_t *pool, int slot, DkCmdBufMaker *maker) {
+    memset(pool, 0, sizeof(*pool));
+    pool->device = dk->device;
+    pool->slot = slot;
+    pool->chunk_min = DK_CMD_CHUNK_SIZE;
+
+    maker->userData = pool;
+    maker->cbAddMem = dk_cmd_pool_add_mem;
+}
+
+void dk_cmd_pool_shutdown(dk_cmd_pool_t *pool) {
+    for (uint32_t i = 0; i < pool->count; i++) {
+        dkMemBlockDestroy(pool->chunks[i]);
+    }
+    pool->count = 0;
+    pool->in_use = 0;
+    pool->in_use_bytes = 0;
+}
+
+/* ============================================================================
+ * Recycling
+ * ============================================================================ */
+
+void dk_cmd_pool_recycle(dk_backend_data_t *dk, dk_cmd_pool_t *pool, DkCmdBuf cmdbuf,
+                         DkMemBlock base_block, uint32_t base_size) {
+    uint32_t frame_bytes = base_size + pool->in_use_bytes;
+    if (frame_bytes > dk->cmd_mem_peak) dk->cmd_mem_peak = frame_bytes;
+
+    /* Shrink once the chunks have gone unused for a while */
+    if (pool->in_use == 0) {
+        if (pool->count > 0 && ++pool->quiet_frames >= DK_CMD_POOL_QUIET_FRAMES) {
+            dk_cmd_pool_shutdown(pool);
+            pool->quiet_frames = 0;
+        }
+    } else {
+        pool->quiet_frames = 0;
+    }
+    pool->in_use = 0;
+    pool->in_use_bytes = 0;
+
+    dkCmdBufClear(cmdbuf);
+    dkCmdBufAddMemory(cmdbuf, base_block, 0, base_size);
+}
+
+void dk_cmdbuf_recycle(dk_backend_data_t *dk, int slot) {
+    dk_cmd_pool_recycle(dk, &dk->cmd_pools[slot], dk->cmdbufs[slot],
+                        dk->cmdbuf_memblock[slot], dk->cmd_mem_size);
+}
+
+void dk_get_cmd_mem_stats(sgl_backend_t *be, uint32_t *peak, uint32_t *pooled) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    uint32_t bytes = 0;
+    for (int slot = 0; slot < SGL_FB_NUM; slot++) {
+        for (uint32_t i = 0; i < dk->cmd_pools[slot].count; i++) {
+            bytes += dk->cmd_pools[slot].chunk_size[i];
+        }
+    }
+    for (int r = 0; r < DK_MAX_RECORDERS; r++) {
+        if (!dk->recorders[r]) continue;
+        for (uint32_t i = 0; i < dk->recorders[r]->cmd_pool.count; i++) {
+            bytes += dk->recorders[r]->cmd_pool.chunk_size[i];
+        }
+    }
+    *peak = dk->cmd_mem_peak;
+    *pooled = bytes;
+}
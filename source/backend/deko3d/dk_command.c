@@ -16,56 +16,209 @@
  * Shared Helpers
  * ============================================================================ */
 
-void dk_rebind_default_render_target(dk_backend_data_t *dk) {
-    if (!dk->framebuffers) return;
+DkImage *dk_default_color_image(dk_backend_data_t *dk) {
+    if (dk->resolution.active) return &dk->resolution.image;
+    return dk->framebuffers ? &dk->framebuffers[dk->current_slot] : NULL;
+}
+
+static void dk_bind_default_render_target(dk_backend_data_t *dk, DkCmdBuf cmdbuf) {
+    DkImage *color = dk_default_color_image(dk);
+    if (!color) return;
 
     DkImageView colorView;
-    dkImageViewDefaults(&colorView, &dk->framebuffers[dk->current_slot]);
+    dkImageViewDefaults(&colorView, color);
+    DkImageView const *colorTarget = dk->default_draw_none ? NULL : &colorView;
     if (dk->depth_images[dk->current_slot]) {
         DkImageView depthView;
         dkImageViewDefaults(&depthView, dk->depth_images[dk->current_slot]);
-        dkCmdBufBindRenderTarget(dk->cmdbuf, &colorView, &depthView);
+        dkCmdBufBindRenderTargets(cmdbuf, &colorTarget, 1, &depthView);
     } else {
-        dkCmdBufBindRenderTarget(dk->cmdbuf, &colorView, NULL);
+        dkCmdBufBindRenderTargets(cmdbuf, &colorTarget, 1, NULL);
     }
 }
 
-void dk_rebind_render_target(dk_backend_data_t *dk) {
-    if (dk->current_fbo != 0 && dk->current_fbo_color > 0 &&
-        dk->current_fbo_color < SGL_MAX_TEXTURES &&
-        dk->texture_initialized[dk->current_fbo_color]) {
-        DkImageView colorView;
-        dkImageViewDefaults(&colorView, &dk->textures[dk->current_fbo_color]);
-        DkImageView *pDepthView = NULL;
-        DkImageView depthView;
-        if (dk->current_fbo_depth > 0 && dk->current_fbo_depth < SGL_MAX_RENDERBUFFERS &&
-            dk->renderbuffer_initialized[dk->current_fbo_depth]) {
-            dkImageViewDefaults(&depthView, &dk->renderbuffer_images[dk->current_fbo_depth]);
-            pDepthView = &depthView;
+void dk_rebind_default_render_target(dk_backend_data_t *dk) {
+    dk_bind_default_render_target(dk, dk->main_stream.cmdbuf);
+}
+
+const DkImage *dk_fbo_depth_image(dk_backend_data_t *dk) {
+    if (dk->current_fbo_depth > 0) {
+        const dk_renderbuffer_t *rb = dk_renderbuffer(dk, dk->current_fbo_depth);
+        return rb->initialized ? &rb->image : NULL;
+    }
+    if (dk->current_fbo_depth_tex > 0) {
+        const dk_texture_t *tex = dk_texture(dk, dk->current_fbo_depth_tex);
+        return tex->initialized ? &tex->image : NULL;
+    }
+    return NULL;
+}
+
+bool dk_fbo_has_target(dk_backend_data_t *dk) {
+    return (dk->current_fbo_color > 0 && dk_texture(dk, dk->current_fbo_color)->initialized) ||
+           dk_fbo_depth_image(dk) != NULL;
+}
+
+void dk_bind_render_target(dk_backend_data_t *dk, DkCmdBuf cmdbuf) {
+    /* Depth-only FBOs (shadow maps) bind no color target */
+    if (dk->current_fbo == 0 || !dk_fbo_has_target(dk)) {
+        dk_bind_default_render_target(dk, cmdbuf);
+        return;
+    }
+
+    /* Color target i is GL_COLOR_ATTACHMENTi; attachments not drawn to
+     * (glDrawBuffersEXT GL_NONE) are left as holes */
+    DkImageView views[SGL_MAX_DRAW_BUFFERS];
+    DkImageView const *targets[SGL_MAX_DRAW_BUFFERS];
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < SGL_MAX_DRAW_BUFFERS; i++) {
+        sgl_handle_t handle = dk->current_fbo_targets[i];
+        const dk_texture_t *color = dk_texture(dk, handle);
+        targets[i] = NULL;
+        if (handle == 0 || !color->initialized) continue;
+
+        dkImageViewDefaults(&views[i], &color->image);
+        views[i].mipLevelCount = 1;
+        if (color->is_cubemap) {
+            /* Render into one face, as a 2D layer */
+            views[i].type = DkImageType_2D;
+            views[i].layerOffset = dk_fbo(dk, dk->current_fbo)->color_layer[i];
+            views[i].layerCount = 1;
         }
-        dkCmdBufBindRenderTarget(dk->cmdbuf, &colorView, pDepthView);
-    } else {
-        dk_rebind_default_render_target(dk);
+        targets[i] = &views[i];
+        count = i + 1;
+    }
+
+    DkImageView *pDepthView = NULL;
+    DkImageView depthView;
+    const DkImage *depth = dk_fbo_depth_image(dk);
+    if (depth) {
+        dkImageViewDefaults(&depthView, depth);
+        depthView.mipLevelCount = 1;
+        pDepthView = &depthView;
+    }
+    dkCmdBufBindRenderTargets(cmdbuf, targets, count, pDepthView);
+}
+
+void dk_rebind_render_target(dk_backend_data_t *dk) {
+    dk_bind_render_target(dk, dk->main_stream.cmdbuf);
+}
+
+void dk_queue_submit(dk_backend_data_t *dk, DkCmdList cmdlist) {
+    dk_transfer_handoff(dk);
+    dkQueueSubmitCommands(dk->queue, cmdlist);
+}
+
+void dk_wait_idle(dk_backend_data_t *dk) {
+    dk_transfer_handoff(dk);
+    dkQueueWaitIdle(dk->queue);
+    dk->main_stream.stats.wait_idle_stalls++;
+}
+
+/*
+ * Reset the active command buffer after its contents were submitted.
+ * Everything recorded into it (state, descriptor bindings) is gone, so the
+ * state generation is bumped to make the GL layer re-emit its state.
+ */
+void dk_reset_cmdbuf(dk_backend_data_t *dk) {
+    dk_cmdbuf_recycle(dk, dk->current_slot);
+    dk->main_stream.descriptors_bound = false;
+    dk->main_stream.state_generation = dk_next_generation(dk);
+}
+
+/*
+ * Submit everything recorded so far, wait for the GPU to go idle and reopen
+ * the command buffer with the current render target bound. Deferred heap
+ * frees are reclaimed since nothing can reference them anymore.
+ */
+void dk_drain_queue(dk_backend_data_t *dk) {
+    if (!dk->cmdbuf_submitted) {
+        DkCmdList cmdlist = dkCmdBufFinishList(dk->main_stream.cmdbuf);
+        dk_queue_submit(dk, cmdlist);
     }
+    dk_wait_idle(dk);
+
+    sgl_lock(&dk->share_lock);
+    dk_heap_reclaim_all(&dk->buffer_heap);
+    dk_heap_reclaim_all(&dk->texture_heap);
+    dk_heap_reclaim_all(&dk->code_heap);
+    sgl_unlock(&dk->share_lock);
+    dk_staging_reclaim_all(dk);
+
+    dk_reset_cmdbuf(dk);
+    dk_rebind_render_target(dk);
+}
+
+void dk_submit_pending(dk_backend_data_t *dk) {
+    if (dk->cmdbuf_submitted) return;
+    DkCmdList cmdlist = dkCmdBufFinishList(dk->main_stream.cmdbuf);
+    dk_queue_submit(dk, cmdlist);
+    dkQueueFlush(dk->queue);
 }
 
 /*
- * Submit current command buffer, wait for GPU, and reset for continued use.
- * Shared implementation for dk_flush() and dk_finish().
+ * Submit current command buffer, wait for GPU, and reset for continued use
+ * (dk_finish).
  */
 static void dk_submit_and_reset(dk_backend_data_t *dk) {
-    DkCmdList cmdlist = dkCmdBufFinishList(dk->cmdbuf);
-    dkQueueSubmitCommands(dk->queue, cmdlist);
-    dkQueueWaitIdle(dk->queue);
+    DkCmdList cmdlist = dkCmdBufFinishList(dk->main_stream.cmdbuf);
+    dk_queue_submit(dk, cmdlist);
+    dk_wait_idle(dk);
+    dk->idle_serial = ++dk->submit_serial;
+
+    /* GPU is idle - every deferred buffer/texture/code range and staging block can be reused */
+    sgl_lock(&dk->share_lock);
+    dk_heap_reclaim_all(&dk->buffer_heap);
+    dk_heap_reclaim_all(&dk->texture_heap);
+    dk_heap_reclaim_all(&dk->code_heap);
+    sgl_unlock(&dk->share_lock);
+    dk_staging_reclaim_all(dk);
 
     /* Reset command buffer for continued use */
-    dkCmdBufClear(dk->cmdbuf);
-    dkCmdBufAddMemory(dk->cmdbuf, dk->cmdbuf_memblock[dk->current_slot], 0, SGL_CMD_MEM_SIZE);
-    dk->descriptors_bound = false;
+    dk_reset_cmdbuf(dk);
 
     dk_rebind_default_render_target(dk);
 }
 
+/* ============================================================================
+ * Frame Statistics
+ * ============================================================================ */
+
+void dk_frame_stats_add(sgl_frame_stats_t *dst, const sgl_frame_stats_t *src) {
+    dst->draws += src->draws;
+    dst->clears += src->clears;
+    dst->viewport_binds += src->viewport_binds;
+    dst->scissor_binds += src->scissor_binds;
+    dst->blend_binds += src->blend_binds;
+    dst->depth_stencil_binds += src->depth_stencil_binds;
+    dst->raster_binds += src->raster_binds;
+    dst->color_mask_binds += src->color_mask_binds;
+    dst->vertex_binds += src->vertex_binds;
+    dst->shader_binds += src->shader_binds;
+    dst->texture_binds += src->texture_binds;
+    dst->descriptor_binds += src->descriptor_binds;
+    dst->barriers += src->barriers;
+    dst->wait_idle_stalls += src->wait_idle_stalls;
+    dst->client_array_bytes += src->client_array_bytes;
+    dst->client_array_chunks += src->client_array_chunks;
+    dst->uniform_bytes += src->uniform_bytes;
+}
+
+/* The main stream's counters become the last frame's; recording starts over */
+static void dk_frame_stats_snapshot(dk_backend_data_t *dk, int slot) {
+    sgl_frame_stats_t *stats = &dk->frame_stats;
+    *stats = dk->main_stream.stats;
+    stats->frame = dk->frame_serial;
+    stats->cmd_mem_used = dk->cmd_mem_size + dk->cmd_pools[slot].in_use_bytes;
+    stats->cmd_mem_size = dk->cmd_mem_size;
+    if (stats->client_array_bytes > dk->client_array_peak) dk->client_array_peak = stats->client_array_bytes;
+    memset(&dk->main_stream.stats, 0, sizeof(dk->main_stream.stats));
+}
+
+void dk_get_frame_stats(sgl_backend_t *be, sgl_frame_stats_t *stats) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    *stats = dk->frame_stats;
+}
+
 /* ============================================================================
  * Frame Management
  * ============================================================================ */
@@ -74,8 +227,10 @@ void dk_begin_frame(sgl_backend_t *be, int slot) {
     dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
 
     dk->current_slot = slot;
-    dk->cmdbuf = dk->cmdbufs[slot];
+    dk->slot_frame[slot] = ++dk->frame_serial;
+    dk->main_stream.cmdbuf = dk->cmdbufs[slot];
     dk->current_cmdbuf = slot;
+    dk->main_stream.state_generation = dk_next_generation(dk);  /* Switched to another slot's cmdbuf */
 
     /* Reset client array allocator to this slot's sub-region.
      * The client array memory is partitioned per-slot to avoid GPU race conditions:
@@ -85,10 +240,13 @@ void dk_begin_frame(sgl_backend_t *be, int slot) {
     {
         uint32_t total_client_size = dk->uniform_base - dk->client_array_base;
         uint32_t per_slot_size = total_client_size / SGL_FB_NUM;
-        dk->client_array_offset = slot * per_slot_size;
-        dk->client_array_slot_end = (slot + 1) * per_slot_size;
+        dk->main_stream.client_array_base = dk->client_array_base;  /* Last frame may have chained */
+        dk->main_stream.client_array_offset = slot * per_slot_size;
+        dk->main_stream.client_array_slot_end = (slot + 1) * per_slot_size;
     }
 
+    /* Render size of this frame: swapchain image or internal target */
+    dk_resolution_begin_frame(dk, slot);
     dk_rebind_default_render_target(dk);
 
     SGL_TRACE_BACKEND("begin_frame slot=%d", slot);
@@ -104,14 +262,31 @@ void dk_end_frame(sgl_backend_t *be, int slot) {
         return;
     }
 
+    /* Surfaces report EGL_BUFFER_DESTROYED: the default depth-stencil is
+     * dead once the frame ends, so its tiles need not be written back */
+    if (dk->current_fbo == 0 && dk->depth_images[slot]) {
+        dkCmdBufDiscardDepthStencil(dk->cmdbufs[slot]);
+    }
+
+    /* Upscale into the swapchain image when rendering below its size */
+    dk_resolution_end_frame(dk, slot);
+
+    dk_frame_stats_snapshot(dk, slot);
+
+    /* Chunks the frame streamed client arrays into are free once it completes */
+    sgl_lock(&dk->share_lock);
+    dk_client_arrays_end_frame(dk, slot);
+    sgl_unlock(&dk->share_lock);
+
     /* Signal fence before finishing command list */
     dkCmdBufSignalFence(dk->cmdbufs[slot], &dk->fences[slot], false);
     dk->fence_active[slot] = true;
 
     /* Finish and submit command list */
     DkCmdList cmdlist = dkCmdBufFinishList(dk->cmdbufs[slot]);
-    dkQueueSubmitCommands(dk->queue, cmdlist);
+    dk_queue_submit(dk, cmdlist);
     dk->cmdbuf_submitted = true;
+    dk->submit_serial++;
 
     SGL_TRACE_BACKEND("end_frame slot=%d", slot);
 }
@@ -147,18 +322,28 @@ void dk_wait_fence(sgl_backend_t *be, int slot) {
         dk->fence_active[slot] = false;
     }
 
-    /* Reset command buffer for new frame */
-    dkCmdBufClear(dk->cmdbufs[slot]);
-    dkCmdBufAddMemory(dk->cmdbufs[slot], dk->cmdbuf_memblock[slot], 0, SGL_CMD_MEM_SIZE);
+    /* Ranges freed while this slot was recording are no longer read by the GPU.
+     * Upload threads free into the heaps and retire descriptor heaps too. */
+    sgl_lock(&dk->share_lock);
+    dk_heap_reclaim(&dk->buffer_heap, slot);
+    dk_heap_reclaim(&dk->texture_heap, slot);
+    dk_heap_reclaim(&dk->code_heap, slot);
+    dk_descriptor_heap_reclaim(dk, slot);
+    sgl_unlock(&dk->share_lock);
+    dk_staging_reclaim(dk, slot);
+
+    /* Reset command buffer for new frame; its overflow chunks go back to the pool */
+    dk_cmdbuf_recycle(dk, slot);
 
     /* Reset descriptors_bound flag since command buffer was cleared */
-    dk->descriptors_bound = false;
+    dk->main_stream.descriptors_bound = false;
     dk->cmdbuf_submitted = false;
+    dk->main_stream.state_generation = dk_next_generation(dk);
 
     /* Reset uniform allocator for new frame.
      * This is safe because pushConstants copied uniform data into the command buffer
      * at record time, so the GPU no longer references the CPU uniform memory. */
-    dk->uniform_offset = 0;
+    dk->main_stream.uniform_offset = 0;
 
     SGL_TRACE_BACKEND("wait_fence slot=%d", slot);
 }
@@ -170,6 +355,13 @@ void dk_wait_fence(sgl_backend_t *be, int slot) {
 void dk_flush(sgl_backend_t *be) {
     dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
 
+    dk_upload_t *u = dk_upload_current(dk);
+    if (u) {
+        dk_upload_flush(dk, u);
+        SGL_TRACE_BACKEND("flush (upload thread)");
+        return;
+    }
+
     if (dkQueueIsInErrorState(dk->queue)) {
         SGL_ERROR_BACKEND("flush: GPU queue in ERROR STATE — skipping");
         dk->cmdbuf_submitted = false;
@@ -177,19 +369,27 @@ void dk_flush(sgl_backend_t *be) {
     }
 
     if (dk->cmdbuf_submitted) {
-        dkQueueWaitIdle(dk->queue);
         dk->cmdbuf_submitted = false;
-        SGL_TRACE_BACKEND("flush (already submitted, waited idle)");
+        SGL_TRACE_BACKEND("flush (already submitted)");
         return;
     }
 
-    dk_submit_and_reset(dk);
+    /* Hand the work to the GPU and keep recording; glFinish is the one that waits.
+     * Deferred frees stay with their slot until wait_fence reclaims them. */
+    dk_submit_pending(dk);
     SGL_TRACE_BACKEND("flush");
 }
 
 void dk_finish(sgl_backend_t *be) {
     dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
 
+    dk_upload_t *u = dk_upload_current(dk);
+    if (u) {
+        dk_upload_finish(dk, u);
+        SGL_TRACE_BACKEND("finish (upload thread)");
+        return;
+    }
+
     if (dkQueueIsInErrorState(dk->queue)) {
         SGL_ERROR_BACKEND("finish: GPU queue in ERROR STATE — skipping");
         dk->cmdbuf_submitted = false;
@@ -199,7 +399,8 @@ void dk_finish(sgl_backend_t *be) {
     if (dk->cmdbuf_submitted) {
         /* Already submitted by dk_end_frame — just wait idle,
          * do NOT call dkCmdBufFinishList again. */
-        dkQueueWaitIdle(dk->queue);
+        dk_wait_idle(dk);
+        dk->idle_serial = dk->submit_serial;
         dk->cmdbuf_submitted = false;
         SGL_TRACE_BACKEND("finish (already submitted, waited idle)");
         return;
@@ -209,10 +410,73 @@ void dk_finish(sgl_backend_t *be) {
     SGL_TRACE_BACKEND("finish");
 }
 
+static dk_sync_t *dk_sync_get(dk_backend_data_t *dk, sgl_handle_t handle) {
+    if (handle == 0 || handle > DK_MAX_SYNCS) return NULL;
+    dk_sync_t *s = &dk->syncs[handle - 1];
+    return s->used ? s : NULL;
+}
+
+/*
+ * The fence is recorded in the main cmdbuf and submitted at once: deko3d
+ * fills the DkFence in at submit time, so a sync would otherwise have to
+ * outlive the next flush, and a wait before it would never return. Once
+ * end_frame has submitted the cmdbuf, that frame's fence covers all work.
+ * On an upload thread the sync takes the fence of the thread's own queue.
+ */
+sgl_handle_t dk_create_sync(sgl_backend_t *be) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_upload_t *u = dk_upload_current(dk);
+
+    for (uint32_t i = 0; i < DK_MAX_SYNCS; i++) {
+        dk_sync_t *s = &dk->syncs[i];
+        /* Contexts of a share group create syncs from different threads */
+        if (__atomic_exchange_n(&s->used, true, __ATOMIC_ACQUIRE)) continue;
+
+        s->fenced = false;
+        s->signaled = false;
+        if (u) {
+            s->fenced = dk_upload_fence(dk, u, &s->fence);
+        } else if (dkQueueIsInErrorState(dk->queue)) {
+            SGL_ERROR_BACKEND("create_sync: GPU queue in ERROR STATE — sync signaled");
+        } else if (!dk->cmdbuf_submitted) {
+            dkCmdBufSignalFence(dk->main_stream.cmdbuf, &s->fence, true);
+            dk_submit_pending(dk);
+            s->fenced = true;
+        } else if (dk->fence_active[dk->current_slot]) {
+            s->fence = dk->fences[dk->current_slot];
+            s->fenced = true;
+        }
+        return (sgl_handle_t)(i + 1);
+    }
+    SGL_ERROR_BACKEND("create_sync: all %d syncs in use", DK_MAX_SYNCS);
+    return 0;
+}
+
+void dk_delete_sync(sgl_backend_t *be, sgl_handle_t handle) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_sync_t *s = dk_sync_get(dk, handle);
+    if (s) __atomic_store_n(&s->used, false, __ATOMIC_RELEASE);
+}
+
+bool dk_wait_sync(sgl_backend_t *be, sgl_handle_t handle, uint64_t timeout_ns) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_sync_t *s = dk_sync_get(dk, handle);
+    if (!s || !s->fenced || s->signaled) return true;
+
+    int64_t timeout = timeout_ns > (uint64_t)INT64_MAX ? -1 : (int64_t)timeout_ns;
+    s->signaled = dkFenceWait(&s->fence, timeout) == DkResult_Success;
+    return s->signaled;
+}
+
+uint32_t dk_get_state_generation(sgl_backend_t *be) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    return dk_stream(dk)->state_generation;
+}
+
 void dk_insert_barrier(sgl_backend_t *be) {
     dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
 
-    dkCmdBufBarrier(dk->cmdbuf, DkBarrier_Full,
+    dk_barrier(dk, DkBarrier_Full,
                     DkInvalidateFlags_Image | DkInvalidateFlags_Descriptors);
 
     SGL_TRACE_BACKEND("insert_barrier");
@@ -4,15 +4,89 @@
  *
  * This module handles:
  * - Vertex attribute binding (glVertexAttribPointer state)
+ * - Cached vertex state for VBO-only vertex array objects
  * - Draw arrays (glDrawArrays)
  * - Draw elements (glDrawElements)
+ * - Multi draws (glMultiDraw*EXT, sglMultiDraw*)
  *
  * Vertex data handling:
  * - VBO path: Uses pre-uploaded GPU buffer data
- * - Client array path: Copies client memory to GPU staging area per-frame
+ * - Client array path: Copies the referenced vertex range [first, first + count)
+ *   of client memory to the GPU staging area per-frame; a frame that outgrows
+ *   its slot's region chains chunks from the buffer heap
+ * - Client indices: copied (u8 widened to u16) in one pass that also yields
+ *   the [min, max] vertex range used to size the client array copy
+ * - Instanced attributes (divisor > 0) advance per instance instead, so they
+ *   reference elements [0, ceil(instances / divisor)) whatever the draw range
  */
 
 #include "dk_internal.h"
+#include "../../util/sgl_index.h"
+
+/* ============================================================================
+ * Client Array Streaming
+ *
+ * Client arrays, constant attributes and client indices are bump-allocated
+ * from the stream's client array range. When the main stream's slot region
+ * is full, a chunk of at least a slot's size is taken from the buffer heap
+ * and streaming carries on there; the chunks go back to the heap as deferred
+ * frees when the frame ends, so they are reused once its fence has signaled.
+ * Command lists keep their chunks: the data is replayed with the list.
+ * Returns an offset resolved through the buffer heap (dk_heap_gpu_addr).
+ * ============================================================================ */
+
+static bool dk_client_chain(dk_backend_data_t *dk, dk_stream_t *s, uint32_t size) {
+    if (s->cmdlist) return dk_cmdlist_client_chain(dk, s, size);
+
+    /* Recorders stream into a fixed range of their own */
+    if (s != &dk->main_stream || dk->client_chunk_count >= DK_MAX_CLIENT_CHUNKS) {
+        return false;
+    }
+
+    uint32_t slot_size = (dk->uniform_base - dk->client_array_base) / SGL_FB_NUM;
+    uint32_t chunk_size = SGL_ALIGN_UP(size > slot_size ? size : slot_size, SGL_UNIFORM_ALIGNMENT);
+    uint32_t offset;
+    sgl_lock(&dk->share_lock);  /* Upload threads allocate from the same heap */
+    bool allocated = dk_heap_alloc(&dk->buffer_heap, chunk_size, SGL_UNIFORM_ALIGNMENT, &offset);
+    sgl_unlock(&dk->share_lock);
+    if (!allocated) {
+        return false;
+    }
+
+    dk->client_chunks[dk->client_chunk_count].offset = offset;
+    dk->client_chunks[dk->client_chunk_count].size = chunk_size;
+    dk->client_chunk_count++;
+
+    s->client_array_base = offset;
+    s->client_array_offset = 0;
+    s->client_array_slot_end = chunk_size;
+    s->stats.client_array_chunks++;
+
+    SGL_TRACE_BACKEND("client arrays: chained %u byte chunk at %u", chunk_size, offset);
+    return true;
+}
+
+static bool dk_client_alloc(dk_backend_data_t *dk, dk_stream_t *s, uint32_t size, uint32_t *out_addr) {
+    uint32_t aligned = SGL_ALIGN_UP(s->client_array_offset, SGL_UNIFORM_ALIGNMENT);
+    if (aligned + size > s->client_array_slot_end) {
+        if (!dk_client_chain(dk, s, size)) {
+            s->client_array_failed++;
+            return false;
+        }
+        aligned = 0;
+    }
+
+    *out_addr = s->client_array_base + aligned;
+    s->client_array_offset = aligned + size;
+    return true;
+}
+
+void dk_client_arrays_end_frame(dk_backend_data_t *dk, int slot) {
+    for (uint32_t i = 0; i < dk->client_chunk_count; i++) {
+        dk_heap_defer_free(&dk->buffer_heap, slot, dk->client_chunks[i].offset, dk->client_chunks[i].size);
+    }
+    dk->client_chunk_count = 0;
+}
 
 /* ============================================================================
  * Vertex Attribute Binding
@@ -22,8 +96,10 @@
  * ============================================================================ */
 
 void dk_bind_vertex_attribs(sgl_backend_t *be, const sgl_vertex_attrib_t *attribs,
-                            int num_attribs, GLint first, GLsizei count) {
+                            int num_attribs, GLint first, GLsizei count,
+                            GLsizei instances) {
     dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_stream_t *s = dk_stream(dk);
 
     DkVtxAttribState attribStates[SGL_MAX_ATTRIBS];
     DkVtxBufferState bufferStates[SGL_MAX_ATTRIBS];
@@ -32,8 +108,7 @@ void dk_bind_vertex_attribs(sgl_backend_t *be, const sgl_vertex_attrib_t *attrib
     int numAttribs = 0;
     int numBuffers = 0;
 
-    DkGpuAddr data_gpu_base = dkMemBlockGetGpuAddr(dk->data_memblock);
-    uint8_t *data_cpu_base = (uint8_t*)dkMemBlockGetCpuAddr(dk->data_memblock);
+    const dk_heap_t *data = &dk->buffer_heap;  /* Resolves VBO and client array offsets */
 
     /* Find highest enabled attribute to determine numAttribs */
     int maxAttribIdx = -1;
@@ -74,6 +149,7 @@ void dk_bind_vertex_attribs(sgl_backend_t *be, const sgl_vertex_attrib_t *attrib
      */
     int constBufSlot = -1;
     uint32_t constBufOffset = 0;  /* offset within constant buffer */
+    uint32_t constBufData = 0;    /* data offset of the constant buffer */
 
     /* Build attribute and buffer states */
     for (int i = 0; i < numAttribs; i++) {
@@ -83,18 +159,17 @@ void dk_bind_vertex_attribs(sgl_backend_t *be, const sgl_vertex_attrib_t *attrib
             /* Disabled attribute - use constant value from glVertexAttrib*f */
             if (constBufSlot < 0) {
                 /* First disabled attribute: allocate shared constant buffer */
-                uint32_t alignedOff = SGL_ALIGN_UP(dk->client_array_offset, SGL_UNIFORM_ALIGNMENT);
                 uint32_t totalSize = numAttribs * 16; /* worst case: all disabled */
-                uint32_t clientAddr = dk->client_array_base + alignedOff;
+                uint32_t clientAddr;
 
-                if (alignedOff + totalSize <= dk->client_array_slot_end) {
+                if (dk_client_alloc(dk, s, totalSize, &clientAddr)) {
                     constBufSlot = numBuffers;
                     boundBuffers[numBuffers] = 0xFFFFFFFF; /* marker for constant buffer */
                     bufferStates[numBuffers].stride = 0;  /* same value for all vertices */
                     bufferStates[numBuffers].divisor = 0;
-                    bufferExtents[numBuffers].addr = data_gpu_base + clientAddr;
+                    bufferExtents[numBuffers].addr = dk_heap_gpu_addr(data, clientAddr);
+                    constBufData = clientAddr;
                     bufferExtents[numBuffers].size = totalSize;
-                    dk->client_array_offset = alignedOff + totalSize;
                     numBuffers++;
                 } else {
                     /* Fallback: use isFixed if out of memory */
@@ -109,8 +184,7 @@ void dk_bind_vertex_attribs(sgl_backend_t *be, const sgl_vertex_attrib_t *attrib
             }
 
             /* Write constant value (vec4) to the shared buffer */
-            uint32_t writeAddr = (uint32_t)(bufferExtents[constBufSlot].addr - data_gpu_base) + constBufOffset;
-            float *dst = (float *)(data_cpu_base + writeAddr);
+            float *dst = (float *)(dk_heap_cpu_addr(data, constBufData) + constBufOffset);
             dst[0] = attr->current_value[0];
             dst[1] = attr->current_value[1];
             dst[2] = attr->current_value[2];
@@ -130,7 +204,7 @@ void dk_bind_vertex_attribs(sgl_backend_t *be, const sgl_vertex_attrib_t *attrib
         /* Calculate effective stride (0 means tightly packed) */
         GLsizei effectiveStride = attr->stride;
         if (effectiveStride == 0) {
-            effectiveStride = attr->size * dk_get_type_size(attr->type);
+            effectiveStride = dk_get_attrib_size(attr->type, attr->size);
         }
 
         /*
@@ -158,16 +232,25 @@ void dk_bind_vertex_attribs(sgl_backend_t *be, const sgl_vertex_attrib_t *attrib
             continue;  /* Skip this attribute */
         }
 
+        /* Elements this draw reads from the attribute */
+        GLint rangeFirst = first;
+        GLsizei rangeCount = count;
+        if (attr->divisor > 0) {
+            rangeFirst = 0;
+            rangeCount = (GLsizei)(((GLuint)instances + attr->divisor - 1) / attr->divisor);
+        }
+
         /* Find or add buffer to our list
-         * Match by: buffer ID AND stride (attributes with same buffer & stride share a slot)
-         * Different strides need different buffer states, even if same VBO
+         * Match by: buffer ID, stride AND divisor (attributes with same buffer & stride share a slot)
+         * Different strides or divisors need different buffer states, even if same VBO
          *
          * For client-side arrays (buffer == 0), we also check if pointers are within
          * the same interleaved data region (pointer difference < stride). */
         int bufIdx = -1;
         for (int j = 0; j < numBuffers; j++) {
             if (boundBuffers[j] == attr->buffer &&
-                bufferStates[j].stride == (uint32_t)effectiveStride) {
+                bufferStates[j].stride == (uint32_t)effectiveStride &&
+                bufferStates[j].divisor == attr->divisor) {
                 /* For client-side arrays, check if this pointer is part of the same
                  * interleaved buffer (difference from base pointer < stride) */
                 if (attr->buffer == 0 && bufferClientPtrs[j] != 0) {
@@ -193,44 +276,41 @@ void dk_bind_vertex_attribs(sgl_backend_t *be, const sgl_vertex_attrib_t *attrib
             boundBuffers[numBuffers] = attr->buffer;
 
             bufferStates[numBuffers].stride = effectiveStride;
-            bufferStates[numBuffers].divisor = 0;
+            bufferStates[numBuffers].divisor = attr->divisor;
 
             /* Buffer extent - GPU address and size */
             if (attr->buffer > 0) {
                 /* VBO path - use BASE address (data_offset only, not including pointer) */
                 /* buffer_offset includes pointer, so subtract it to get base */
                 uint32_t baseOffset = attr->buffer_offset - (uint32_t)(uintptr_t)attr->pointer;
-                bufferExtents[numBuffers].addr = data_gpu_base + baseOffset;
+                bufferExtents[numBuffers].addr = dk_heap_gpu_addr(data, baseOffset);
                 bufferBaseAddrs[numBuffers] = bufferExtents[numBuffers].addr;
                 /* Size estimate based on count + max offset */
-                bufferExtents[numBuffers].size = (first + count) * effectiveStride + attrOffset;
+                bufferExtents[numBuffers].size = (rangeFirst + rangeCount) * effectiveStride + attrOffset;
             } else if (attr->pointer != NULL) {
                 /*
                  * Client-side vertex array - copy data to GPU memory.
                  * Use bump allocator that persists until frame end.
+                 * Only elements [rangeFirst, rangeFirst + rangeCount) are copied;
+                 * the extent starts rangeFirst * stride before the copy so vertex
+                 * indices still address it directly.
                  */
-                GLsizei totalVertices = first + count;
-                GLsizei dataSize = totalVertices * effectiveStride;
+                uint32_t skipBytes = (uint32_t)rangeFirst * (uint32_t)effectiveStride;
+                GLsizei dataSize = rangeCount * effectiveStride;
+                uint32_t clientArrayAddr;
 
-                /* Align current offset to 256 bytes */
-                uint32_t alignedOffset = SGL_ALIGN_UP(dk->client_array_offset, SGL_UNIFORM_ALIGNMENT);
-                uint32_t clientArrayAddr = dk->client_array_base + alignedOffset;
-
-                /* Check we have space in this slot's sub-region */
-                if (alignedOffset + dataSize <= dk->client_array_slot_end) {
+                if (dk_client_alloc(dk, s, (uint32_t)dataSize, &clientArrayAddr)) {
                     /* Copy vertex data from client memory to GPU memory */
-                    void *dst = data_cpu_base + clientArrayAddr;
-                    memcpy(dst, attr->pointer, dataSize);
+                    void *dst = dk_heap_cpu_addr(data, clientArrayAddr);
+                    memcpy(dst, (const uint8_t *)attr->pointer + skipBytes, dataSize);
+                    s->stats.client_array_bytes += (uint32_t)dataSize;
 
-                    bufferExtents[numBuffers].addr = data_gpu_base + clientArrayAddr;
+                    bufferExtents[numBuffers].addr = dk_heap_gpu_addr(data, clientArrayAddr) - skipBytes;
                     bufferBaseAddrs[numBuffers] = bufferExtents[numBuffers].addr;
-                    bufferExtents[numBuffers].size = dataSize;
+                    bufferExtents[numBuffers].size = skipBytes + dataSize;
 
                     /* Store client pointer for computing offsets in interleaved data */
                     bufferClientPtrs[numBuffers] = (uintptr_t)attr->pointer;
-
-                    /* Advance bump allocator */
-                    dk->client_array_offset = alignedOffset + dataSize;
                 } else {
                     SGL_ERROR_BACKEND("bind_vertex_attribs: out of client array memory");
                 }
@@ -265,132 +345,393 @@ void dk_bind_vertex_attribs(sgl_backend_t *be, const sgl_vertex_attrib_t *attrib
      */
     DK_VERBOSE_PRINT("[DK] bind_vertex_attribs: numAttribs=%d numBuffers=%d\n", numAttribs, numBuffers);
 
-    dkCmdBufBindVtxAttribState(dk->cmdbuf, attribStates, numAttribs);
-    dkCmdBufBindVtxBufferState(dk->cmdbuf, bufferStates, numBuffers);
-    dkCmdBufBindVtxBuffers(dk->cmdbuf, 0, bufferExtents, numBuffers);
+    dkCmdBufBindVtxAttribState(s->cmdbuf, attribStates, numAttribs);
+    dkCmdBufBindVtxBufferState(s->cmdbuf, bufferStates, numBuffers);
+    dkCmdBufBindVtxBuffers(s->cmdbuf, 0, bufferExtents, numBuffers);
+    s->bound_vertex_array = 0;  /* Cached VAO state no longer bound */
+    s->stats.vertex_binds++;
 
-    SGL_TRACE_DRAW("bind_vertex_attribs numAttribs=%d numBuffers=%d first=%d count=%d",
-                   numAttribs, numBuffers, first, count);
+    SGL_TRACE_DRAW("bind_vertex_attribs numAttribs=%d numBuffers=%d first=%d count=%d instances=%d",
+                   numAttribs, numBuffers, first, count, instances);
 }
 
 /* ============================================================================
- * Draw Arrays
+ * Vertex Array Objects
+ *
+ * A VAO whose enabled attributes are contiguous and all sourced from VBOs has
+ * its deko3d attribute/buffer state built once and kept per VAO id. Extents
+ * cover each whole buffer, so the state does not depend on the draw range.
+ * Drawing the same VAO again records nothing; switching VAOs replays the
+ * cached state without re-deriving it.
  * ============================================================================ */
 
-void dk_draw_arrays(sgl_backend_t *be, GLenum mode, GLint first, GLsizei count) {
+static void dk_build_vertex_array(dk_backend_data_t *dk, dk_vtx_cache_t *cache,
+                                  const sgl_vertex_attrib_t *attribs, int num_attribs) {
+    memset(cache, 0, sizeof(*cache));
+
+    for (int i = 0; i < num_attribs && i < SGL_MAX_ATTRIBS; i++) {
+        const sgl_vertex_attrib_t *attr = &attribs[i];
+        if (!attr->enabled) continue;
+
+        GLsizei effectiveStride = attr->stride;
+        if (effectiveStride == 0) {
+            effectiveStride = dk_get_attrib_size(attr->type, attr->size);
+        }
+
+        /* Same buffer, stride and divisor share a binding, as in dk_bind_vertex_attribs */
+        int bufIdx = -1;
+        for (int j = 0; j < cache->num_buffers; j++) {
+            if (cache->buffer_handles[j] == attr->buffer &&
+                cache->buffers[j].stride == (uint32_t)effectiveStride &&
+                cache->buffers[j].divisor == attr->divisor) {
+                bufIdx = j;
+                break;
+            }
+        }
+        if (bufIdx < 0) {
+            bufIdx = cache->num_buffers++;
+            GLuint h = attr->buffer;
+            cache->buffer_handles[bufIdx] = h;
+            cache->buffers[bufIdx].stride = effectiveStride;
+            cache->buffers[bufIdx].divisor = attr->divisor;
+            const dk_buffer_t *buf = dk_buffer(dk, h);
+            cache->buffer_offsets[bufIdx] = buf->offset;
+            cache->extents[bufIdx].addr = dk_heap_gpu_addr(&dk->buffer_heap, buf->offset);
+            cache->extents[bufIdx].size = buf->size;
+        }
+
+        DkVtxAttribSize attrSize;
+        DkVtxAttribType attrType;
+        dk_get_attrib_format(attr->type, attr->size, attr->normalized, &attrSize, &attrType);
+
+        cache->attribs[i].bufferId = (uint32_t)bufIdx;
+        cache->attribs[i].isFixed = 0;
+        cache->attribs[i].offset = (uint32_t)(uintptr_t)attr->pointer;
+        cache->attribs[i].size = attrSize;
+        cache->attribs[i].type = attrType;
+        cache->attribs[i].isBgra = 0;
+        cache->num_attribs = i + 1;
+    }
+
+    cache->valid = cache->num_buffers > 0;
+}
+
+/* glBufferData may have moved a referenced buffer to a new heap range */
+static bool dk_vertex_array_moved(const dk_backend_data_t *dk, const dk_vtx_cache_t *cache) {
+    for (int j = 0; j < cache->num_buffers; j++) {
+        GLuint h = cache->buffer_handles[j];
+        if (cache->buffer_offsets[j] != dk_buffer(dk, h)->offset) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void dk_bind_vertex_array(sgl_backend_t *be, GLuint vao, const sgl_vertex_attrib_t *attribs,
+                          int num_attribs, bool layout_dirty) {
     dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_stream_t *s = dk_stream(dk);
 
-    if (count <= 0) {
+    if (vao == 0) {
         return;
     }
 
-    DkPrimitive prim = dk_convert_primitive(mode);
+    dk_vtx_cache_t local;
+    const dk_vtx_cache_t *cache;
+    bool rebuilt = false;
+    bool extents_changed = false;
+
+    if (s->is_recorder) {
+        /* The per-VAO cache belongs to the GL thread: a recorder only reuses
+         * it while it is current and otherwise builds a private copy (a
+         * missing record reads as invalid, recorders never allocate one) */
+        cache = dk_vertex_array(dk, vao);
+        if (layout_dirty || !cache->valid || dk_vertex_array_moved(dk, cache)) {
+            dk_build_vertex_array(dk, &local, attribs, num_attribs);
+            if (!local.valid) return;
+            cache = &local;
+            rebuilt = true;
+        }
+    } else {
+        dk_vtx_cache_t *own = (dk_vtx_cache_t *)sgl_table_ensure(&dk->vertex_arrays, vao);
+        if (!own) {
+            return;
+        }
+        if (layout_dirty || !own->valid) {
+            dk_build_vertex_array(dk, own, attribs, num_attribs);
+            if (!own->valid) return;
+            rebuilt = true;
+        } else if (dk_vertex_array_moved(dk, own)) {
+            for (int j = 0; j < own->num_buffers; j++) {
+                const dk_buffer_t *buf = dk_buffer(dk, own->buffer_handles[j]);
+                if (own->buffer_offsets[j] != buf->offset) {
+                    own->buffer_offsets[j] = buf->offset;
+                    own->extents[j].addr = dk_heap_gpu_addr(&dk->buffer_heap, buf->offset);
+                    own->extents[j].size = buf->size;
+                    extents_changed = true;
+                }
+            }
+        }
+        cache = own;
+    }
 
-    dkCmdBufDraw(dk->cmdbuf, prim, count, 1, first, 0);
+    bool state_lost = s->bound_vertex_array != vao ||
+                      s->vertex_array_generation != s->state_generation;
+    if (!rebuilt && !state_lost && !extents_changed) {
+        return;  /* Already bound and unchanged */
+    }
 
-    /* Insert barrier after FBO draws to ensure proper synchronization */
-    if (dk->current_fbo != 0) {
-        dkCmdBufBarrier(dk->cmdbuf, DkBarrier_Full, 0);
+    if (rebuilt || state_lost) {
+        dkCmdBufBindVtxAttribState(s->cmdbuf, cache->attribs, cache->num_attribs);
+        dkCmdBufBindVtxBufferState(s->cmdbuf, cache->buffers, cache->num_buffers);
     }
+    dkCmdBufBindVtxBuffers(s->cmdbuf, 0, cache->extents, cache->num_buffers);
+    s->stats.vertex_binds++;
 
-    DK_VERBOSE_PRINT("[DK] draw_arrays: mode=0x%X first=%d count=%d\n", mode, first, count);
-    SGL_TRACE_DRAW("draw_arrays mode=0x%X first=%d count=%d", mode, first, count);
+    s->bound_vertex_array = vao;
+    s->vertex_array_generation = s->state_generation;
+
+    SGL_TRACE_DRAW("bind_vertex_array vao=%u numAttribs=%d numBuffers=%d rebuilt=%d",
+                   vao, cache->num_attribs, cache->num_buffers, rebuilt);
+}
+
+void dk_delete_vertex_array(sgl_backend_t *be, GLuint vao) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+
+    dk_vtx_cache_t *cache = (dk_vtx_cache_t *)sgl_table_get(&dk->vertex_arrays, vao);
+    if (vao == 0 || !cache) {
+        return;
+    }
+
+    cache->valid = false;
+    if (dk->main_stream.bound_vertex_array == vao) {
+        dk->main_stream.bound_vertex_array = 0;
+    }
 }
 
 /* ============================================================================
- * Draw Elements
+ * Draw Arrays
  * ============================================================================ */
 
-void dk_draw_elements(sgl_backend_t *be, GLenum mode, GLsizei count,
-                      GLenum type, const void *indices, sgl_handle_t ebo) {
+void dk_draw_arrays(sgl_backend_t *be, GLenum mode, GLint first, GLsizei count,
+                    GLsizei instances) {
     dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_stream_t *s = dk_stream(dk);
 
-    if (count <= 0) {
+    if (count <= 0 || instances <= 0) {
         return;
     }
 
     DkPrimitive prim = dk_convert_primitive(mode);
 
-    /* Determine index format and size */
-    DkIdxFormat idxFormat;
-    size_t idxSize;
+    dkCmdBufDraw(s->cmdbuf, prim, count, instances, first, 0);
+    s->stats.draws++;
+
+    /* No barrier here: a later read of the render target resolves the hazard */
+    dk_hazard_render_write(dk);
+
+    DK_VERBOSE_PRINT("[DK] draw_arrays: mode=0x%X first=%d count=%d instances=%d\n",
+                     mode, first, count, instances);
+    SGL_TRACE_DRAW("draw_arrays mode=0x%X first=%d count=%d instances=%d",
+                   mode, first, count, instances);
+}
+
+/* ============================================================================
+ * Client Index Staging
+ * ============================================================================ */
+
+uint32_t dk_upload_indices(sgl_backend_t *be, GLenum type, const void *indices, GLsizei count,
+                           GLenum *out_type, GLuint *out_min, GLuint *out_max) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_stream_t *s = dk_stream(dk);
+
+    *out_min = 0;
+    *out_max = 0;
+    if (count <= 0 || !indices) {
+        return 0;
+    }
+
+    /* u8 indices are widened to u16 (no 8-bit index format on Maxwell) */
+    uint32_t dstIdxSize = (type == GL_UNSIGNED_INT) ? 4 : 2;
+    uint32_t dataSize = (uint32_t)count * dstIdxSize;
+
+    uint32_t clientAddr;
+    if (!dk_client_alloc(dk, s, dataSize, &clientAddr)) {
+        SGL_ERROR_BACKEND("upload_indices: out of client array memory");
+        return 0;
+    }
+    uint8_t *dst = dk_heap_cpu_addr(&dk->buffer_heap, clientAddr);
+
+    uint32_t lo, hi;
     switch (type) {
         case GL_UNSIGNED_BYTE:
-            /* DkIdxFormat_Uint8 is NOT supported by Maxwell GPU!
-             * Must convert to 16-bit indices. */
-            idxFormat = DkIdxFormat_Uint16;
-            idxSize = 2;  /* Will convert */
+            sgl_index_widen_u8((uint16_t *)dst, (const uint8_t *)indices, (uint32_t)count, &lo, &hi);
+            *out_type = GL_UNSIGNED_SHORT;
             break;
         case GL_UNSIGNED_SHORT:
-            idxFormat = DkIdxFormat_Uint16;
-            idxSize = 2;
+            sgl_index_copy_u16((uint16_t *)dst, (const uint16_t *)indices, (uint32_t)count, &lo, &hi);
+            *out_type = GL_UNSIGNED_SHORT;
             break;
         case GL_UNSIGNED_INT:
-            idxFormat = DkIdxFormat_Uint32;
-            idxSize = 4;
+            sgl_index_copy_u32((uint32_t *)dst, (const uint32_t *)indices, (uint32_t)count, &lo, &hi);
+            *out_type = GL_UNSIGNED_INT;
             break;
         default:
-            SGL_ERROR_BACKEND("draw_elements: unsupported index type 0x%X", type);
-            return;
+            SGL_ERROR_BACKEND("upload_indices: unsupported index type 0x%X", type);
+            return 0;
+    }
+
+    s->stats.client_array_bytes += dataSize;
+    *out_min = lo;
+    *out_max = hi;
+    return clientAddr;
+}
+
+/* ============================================================================
+ * Draw Elements
+ * ============================================================================ */
+
+static bool dk_index_format(GLenum type, DkIdxFormat *format) {
+    switch (type) {
+        case GL_UNSIGNED_BYTE:
+            /* DkIdxFormat_Uint8 is NOT supported by Maxwell GPU!
+             * Client indices are widened to 16-bit when staged. */
+            *format = DkIdxFormat_Uint16;
+            return true;
+        case GL_UNSIGNED_SHORT:
+            *format = DkIdxFormat_Uint16;
+            return true;
+        case GL_UNSIGNED_INT:
+            *format = DkIdxFormat_Uint32;
+            return true;
+        default:
+            return false;
+    }
+}
+
+void dk_draw_elements(sgl_backend_t *be, GLenum mode, GLsizei count,
+                      GLenum type, const void *indices, sgl_handle_t ebo,
+                      GLsizei instances) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_stream_t *s = dk_stream(dk);
+
+    if (count <= 0 || instances <= 0) {
+        return;
+    }
+
+    DkPrimitive prim = dk_convert_primitive(mode);
+
+    /* Determine index format */
+    DkIdxFormat idxFormat;
+    if (!dk_index_format(type, &idxFormat)) {
+        SGL_ERROR_BACKEND("draw_elements: unsupported index type 0x%X", type);
+        return;
     }
 
     DkGpuAddr idxAddr;
 
     if (ebo != 0) {
-        /* EBO bound - indices pointer is actually an offset */
-        DkGpuAddr data_gpu_base = dkMemBlockGetGpuAddr(dk->data_memblock);
-        uintptr_t offset = (uintptr_t)indices;
-        idxAddr = data_gpu_base + (uint32_t)ebo + (uint32_t)offset;
+        /* EBO bound (or indices already staged) - ebo is the data memory offset */
+        idxAddr = dk_heap_gpu_addr(&dk->buffer_heap, (uint32_t)ebo);
     } else {
         /* Client-side indices - copy to GPU staging area */
-        uint8_t *cpu_base = (uint8_t*)dkMemBlockGetCpuAddr(dk->data_memblock);
-        DkGpuAddr gpu_base = dkMemBlockGetGpuAddr(dk->data_memblock);
-
-        /* Align offset */
-        uint32_t alignedOffset = SGL_ALIGN_UP(dk->client_array_offset, SGL_UNIFORM_ALIGNMENT);
-        uint32_t clientAddr = dk->client_array_base + alignedOffset;
-
-        if (type == GL_UNSIGNED_BYTE) {
-            /* Convert 8-bit indices to 16-bit */
-            size_t size16 = count * 2;
-            if (alignedOffset + size16 > dk->client_array_slot_end) {
-                SGL_ERROR_BACKEND("draw_elements: out of client array memory for index conversion");
-                return;
-            }
-
-            uint16_t *dst = (uint16_t*)(cpu_base + clientAddr);
-            const uint8_t *src = (const uint8_t*)indices;
-            for (GLsizei i = 0; i < count; i++) {
-                dst[i] = src[i];
-            }
-
-            dk->client_array_offset = alignedOffset + size16;
-            idxAddr = gpu_base + clientAddr;
-        } else {
-            /* Direct copy for 16-bit and 32-bit indices */
-            size_t dataSize = count * idxSize;
-            if (alignedOffset + dataSize > dk->client_array_slot_end) {
-                SGL_ERROR_BACKEND("draw_elements: out of client array memory");
-                return;
-            }
-
-            memcpy(cpu_base + clientAddr, indices, dataSize);
-            dk->client_array_offset = alignedOffset + dataSize;
-            idxAddr = gpu_base + clientAddr;
+        GLenum stagedType;
+        GLuint minIdx, maxIdx;
+        uint32_t offset = dk_upload_indices(be, type, indices, count, &stagedType, &minIdx, &maxIdx);
+        if (offset == 0) {
+            return;
         }
+        idxAddr = dk_heap_gpu_addr(&dk->buffer_heap, offset);
     }
 
     /* Bind index buffer and draw */
-    dkCmdBufBindIdxBuffer(dk->cmdbuf, idxFormat, idxAddr);
-    dkCmdBufDrawIndexed(dk->cmdbuf, prim, count, 1, 0, 0, 0);
+    dkCmdBufBindIdxBuffer(s->cmdbuf, idxFormat, idxAddr);
+    dkCmdBufDrawIndexed(s->cmdbuf, prim, count, instances, 0, 0, 0);
+    s->stats.draws++;
 
-    /* Insert barrier after FBO draws to ensure proper synchronization */
-    if (dk->current_fbo != 0) {
-        dkCmdBufBarrier(dk->cmdbuf, DkBarrier_Full, 0);
-    }
+    /* No barrier here: a later read of the render target resolves the hazard */
+    dk_hazard_render_write(dk);
 
     DK_VERBOSE_PRINT("[DK] draw_elements: mode=0x%X count=%d type=0x%X ebo=%u\n",
                      mode, count, type, ebo);
-    SGL_TRACE_DRAW("draw_elements mode=0x%X count=%d type=0x%X ebo=%u",
-                   mode, count, type, ebo);
+    SGL_TRACE_DRAW("draw_elements mode=0x%X count=%d type=0x%X ebo=%u instances=%d",
+                   mode, count, type, ebo, instances);
+}
+
+/* ============================================================================
+ * Multi Draw
+ *
+ * The GL layer binds state once for the whole batch; each entry then costs
+ * only its draw command. With per-draw uniform offsets, one packed UBO of
+ * the bound program is also rebound before each draw so the shader sees the
+ * block starting that many bytes in, then restored to its full range.
+ * ============================================================================ */
+
+/* Rebind the packed UBO bound at [stage][binding] starting offset bytes in */
+static void dk_bind_ubo_window(dk_stream_t *s, int stage, int binding, uint32_t offset) {
+    DkGpuAddr base = s->bound_ubo_addr[stage][binding];
+    uint32_t size = s->bound_ubo_size[stage][binding];
+    if (base == 0 || offset >= size) return;
+    dkCmdBufBindUniformBuffer(s->cmdbuf, stage == 0 ? DkStage_Vertex : DkStage_Fragment,
+                              binding, base + offset, size - offset);
+}
+
+static bool dk_valid_ubo_window(int stage, int binding) {
+    return stage >= 0 && stage < 2 && binding >= 0 && binding < SGL_MAX_UNIFORMS;
+}
+
+void dk_multi_draw_arrays(sgl_backend_t *be, GLenum mode, const GLint *first,
+                          const GLsizei *count, GLsizei drawcount,
+                          int ubo_stage, int ubo_binding, const GLuint *ubo_offsets) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_stream_t *s = dk_stream(dk);
+
+    if (ubo_offsets && !dk_valid_ubo_window(ubo_stage, ubo_binding)) ubo_offsets = NULL;
+
+    DkPrimitive prim = dk_convert_primitive(mode);
+    int drawn = 0;
+    for (GLsizei i = 0; i < drawcount; i++) {
+        if (count[i] <= 0) continue;
+        if (ubo_offsets) dk_bind_ubo_window(s, ubo_stage, ubo_binding, ubo_offsets[i]);
+        dkCmdBufDraw(s->cmdbuf, prim, count[i], 1, first[i], 0);
+        drawn++;
+    }
+    if (drawn == 0) return;
+    if (ubo_offsets) dk_bind_ubo_window(s, ubo_stage, ubo_binding, 0);
+    s->stats.draws += drawn;
+
+    dk_hazard_render_write(dk);
+
+    SGL_TRACE_DRAW("multi_draw_arrays mode=0x%X draws=%d", mode, drawn);
+}
+
+void dk_multi_draw_elements(sgl_backend_t *be, GLenum mode, const GLsizei *count,
+                            GLenum type, const uint32_t *index_offsets, GLsizei drawcount,
+                            int ubo_stage, int ubo_binding, const GLuint *ubo_offsets) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_stream_t *s = dk_stream(dk);
+
+    DkIdxFormat idxFormat;
+    if (!dk_index_format(type, &idxFormat)) {
+        SGL_ERROR_BACKEND("multi_draw_elements: unsupported index type 0x%X", type);
+        return;
+    }
+    if (ubo_offsets && !dk_valid_ubo_window(ubo_stage, ubo_binding)) ubo_offsets = NULL;
+
+    DkPrimitive prim = dk_convert_primitive(mode);
+    int drawn = 0;
+    for (GLsizei i = 0; i < drawcount; i++) {
+        if (count[i] <= 0 || index_offsets[i] == 0) continue;
+        if (ubo_offsets) dk_bind_ubo_window(s, ubo_stage, ubo_binding, ubo_offsets[i]);
+        dkCmdBufBindIdxBuffer(s->cmdbuf, idxFormat, dk_heap_gpu_addr(&dk->buffer_heap, index_offsets[i]));
+        dkCmdBufDrawIndexed(s->cmdbuf, prim, count[i], 1, 0, 0, 0);
+        drawn++;
+    }
+    if (drawn == 0) return;
+    if (ubo_offsets) dk_bind_ubo_window(s, ubo_stage, ubo_binding, 0);
+    s->stats.draws += drawn;
+
+    dk_hazard_render_write(dk);
+
+    SGL_TRACE_DRAW("multi_draw_elements mode=0x%X type=0x%X draws=%d", mode, type, drawn);
 }
@@ -5,6 +5,8 @@
  * This module handles:
  * - Framebuffer binding (switching render targets)
  * - Reading pixels from framebuffer (glReadPixels)
+ * - Framebuffer blits on the 2D engine (glBlitFramebufferANGLE)
+ * - Discarding render target contents (glDiscardFramebufferEXT)
  *
  * FBO (Framebuffer Object) workflow:
  * 1. Create FBO texture with glGenTextures + glTexImage2D
@@ -14,18 +16,20 @@
  * 5. Bind default framebuffer with glBindFramebuffer(GL_FRAMEBUFFER, 0)
  * 6. Use FBO texture as source for sampling
  *
- * Important: Barriers are inserted when switching render targets to ensure
- * proper synchronization between rendering and texture sampling.
+ * Render target hazards (sampling or reading back an FBO texture after
+ * rendering to it) are resolved lazily by dk_hazard.c, not on every switch.
  */
 
 #include "dk_internal.h"
+#include "../../util/sgl_pixel.h"
 
 /* ============================================================================
  * Framebuffer Binding
  *
  * Switches the current render target:
  * - handle=0: Bind default framebuffer (swapchain image)
- * - handle>0: Bind FBO with specified color attachment texture
+ * - handle>0: Bind FBO with its color attachments enabled by glDrawBuffersEXT
+ *   (attachment 0 only by default) as color targets 0..3
  * ============================================================================ */
 
 void dk_bind_framebuffer(sgl_backend_t *be, sgl_handle_t handle,
@@ -37,48 +41,67 @@ void dk_bind_framebuffer(sgl_backend_t *be, sgl_handle_t handle,
     dk->current_fbo_color = color_tex;
     dk->current_fbo_depth = depth_rb;
 
-    /* Mark texture as used as render target (for barrier optimization) */
-    if (color_tex > 0 && color_tex < SGL_MAX_TEXTURES) {
-        dk->texture_used_as_rt[color_tex] = true;
-    }
-
-    /* Insert barrier before switching render targets
-     * This ensures any previous rendering is complete before we switch
-     * Include L2Cache invalidation for proper cache coherency when switching
-     * between render target and texture sampling */
-    dkCmdBufBarrier(dk->cmdbuf, DkBarrier_Full,
-                    DkInvalidateFlags_Image | DkInvalidateFlags_Descriptors | DkInvalidateFlags_L2Cache);
-
-    if (handle == 0) {
-        /* Bind default framebuffer (swapchain image) - use per-slot depth buffer */
-        if (dk->framebuffers) {
-            DkImageView colorView, depthView;
-            dkImageViewDefaults(&colorView, &dk->framebuffers[dk->current_slot]);
-            if (dk->depth_images[dk->current_slot]) {
-                dkImageViewDefaults(&depthView, dk->depth_images[dk->current_slot]);
-                dkCmdBufBindRenderTarget(dk->cmdbuf, &colorView, &depthView);
-            } else {
-                dkCmdBufBindRenderTarget(dk->cmdbuf, &colorView, NULL);
-            }
-        }
-    } else if (color_tex > 0 && color_tex < SGL_MAX_TEXTURES && dk->texture_initialized[color_tex]) {
-        /* Bind FBO with texture as color attachment */
-        DkImageView colorView;
-        dkImageViewDefaults(&colorView, &dk->textures[color_tex]);
-
-        /* Check for depth renderbuffer attachment */
-        DkImageView *pDepthView = NULL;
-        DkImageView depthView;
-        if (depth_rb > 0 && depth_rb < SGL_MAX_RENDERBUFFERS &&
-            dk->renderbuffer_initialized[depth_rb]) {
-            dkImageViewDefaults(&depthView, &dk->renderbuffer_images[depth_rb]);
-            pDepthView = &depthView;
-        }
+    const dk_fbo_t *rec = handle ? dk_fbo(dk, handle) : NULL;
+    dk->current_fbo_depth_tex = rec && depth_rb == 0 ? rec->depth_texture : 0;
+    uint32_t draw = rec && rec->draw_buffers_set ? rec->draw_buffers : 1;
+    for (uint32_t i = 0; i < SGL_MAX_DRAW_BUFFERS; i++) {
+        sgl_handle_t tex = i == 0 ? color_tex : rec ? rec->color[i] : 0;
+        dk->current_fbo_targets[i] = handle && (draw & (1u << i)) ? tex : 0;
+    }
+
+    /* Only barrier when a new target was sampled since the last fragment
+     * barrier; otherwise just the tiled cache of the old target is flushed.
+     * Writes to the old target are resolved when it is read (dk_hazard.c). */
+    dk_hazard_before_render(dk);
+
+    /* Default framebuffer (swapchain image or dynamic resolution target),
+     * or the FBO color targets and depth renderbuffer or texture */
+    if (handle == 0 || dk_fbo_has_target(dk)) {
+        dk_rebind_render_target(dk);
+    }
+
+    SGL_TRACE_FBO("bind_framebuffer handle=%u color_tex=%u depth_rb=%u draw=0x%X",
+                  handle, color_tex, depth_rb, draw);
+}
+
+void dk_framebuffer_texture(sgl_backend_t *be, sgl_handle_t fbo, GLenum attachment,
+                            GLenum textarget, sgl_handle_t texture, GLint level) {
+    (void)level;
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_fbo_t *rec = fbo ? (dk_fbo_t *)sgl_table_ensure(&dk->fbos, fbo) : NULL;
+    if (!rec) return;
+
+    if (attachment == GL_DEPTH_ATTACHMENT) {
+        rec->depth_texture = texture;
+        SGL_TRACE_FBO("framebuffer_texture fbo=%u depth texture=%u", fbo, texture);
+        return;
+    }
+    if (attachment < GL_COLOR_ATTACHMENT0 ||
+        attachment >= GL_COLOR_ATTACHMENT0 + SGL_MAX_DRAW_BUFFERS) return;
+    uint32_t index = attachment - GL_COLOR_ATTACHMENT0;
 
-        dkCmdBufBindRenderTarget(dk->cmdbuf, &colorView, pDepthView);
+    bool face = texture != 0 && textarget >= GL_TEXTURE_CUBE_MAP_POSITIVE_X &&
+                textarget <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z;
+    rec->color[index] = texture;
+    rec->color_layer[index] = face ? textarget - GL_TEXTURE_CUBE_MAP_POSITIVE_X : 0;
+
+    SGL_TRACE_FBO("framebuffer_texture fbo=%u attachment=%u texture=%u layer=%u",
+                  fbo, index, texture, rec->color_layer[index]);
+}
+
+void dk_draw_buffers(sgl_backend_t *be, sgl_handle_t fbo, uint32_t mask) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+
+    if (fbo == 0) {
+        dk->default_draw_none = (mask & 1u) == 0;
+    } else {
+        dk_fbo_t *rec = (dk_fbo_t *)sgl_table_ensure(&dk->fbos, fbo);
+        if (!rec) return;
+        rec->draw_buffers = (uint8_t)mask;
+        rec->draw_buffers_set = true;
     }
 
-    SGL_TRACE_FBO("bind_framebuffer handle=%u color_tex=%u depth_rb=%u", handle, color_tex, depth_rb);
+    SGL_TRACE_FBO("draw_buffers fbo=%u mask=0x%X", fbo, mask);
 }
 
 /* ============================================================================
@@ -106,15 +129,17 @@ void dk_read_pixels(sgl_backend_t *be, GLint x, GLint y,
     }
 
     /* Get current render target - check if FBO is bound */
-    DkImage *srcImage = NULL;
-    if (dk->current_fbo != 0 && dk->current_fbo_color > 0 &&
-        dk->current_fbo_color < SGL_MAX_TEXTURES &&
-        dk->texture_initialized[dk->current_fbo_color]) {
-        /* FBO is bound - read from FBO color texture */
-        srcImage = &dk->textures[dk->current_fbo_color];
-    } else if (dk->framebuffers) {
-        /* Default framebuffer */
-        srcImage = &dk->framebuffers[dk->current_slot];
+    const DkImage *srcImage = NULL;
+    GLenum packed = 0;
+    const dk_texture_t *color = dk_texture(dk, dk->current_fbo_color);
+    if (dk->current_fbo != 0 && dk->current_fbo_color > 0 && color->initialized) {
+        /* FBO is bound - read from FBO color texture; 16-bit
+         * attachments are widened to RGBA8 below */
+        srcImage = &color->image;
+        packed = dk_packed16_type(color->format);
+    } else {
+        /* Default framebuffer, at the surface size */
+        srcImage = dk_resolution_read_image(dk);
     }
 
     if (!srcImage) {
@@ -123,7 +148,8 @@ void dk_read_pixels(sgl_backend_t *be, GLint x, GLint y,
 
     /* Allocate separate memory block for readback
      * Using a dedicated block ensures proper CPU visibility */
-    size_t bufferSize = (size_t)width * (size_t)height * 4;
+    uint32_t src_bpp = packed ? 2 : 4;
+    size_t bufferSize = (size_t)width * (size_t)height * src_bpp;
     bufferSize = SGL_ALIGN_UP(bufferSize, SGL_PAGE_ALIGNMENT);  /* Align to 4KB */
 
     DkMemBlock readbackMem;
@@ -136,8 +162,8 @@ void dk_read_pixels(sgl_backend_t *be, GLint x, GLint y,
         return;
     }
 
-    /* Add barrier to ensure all rendering is complete before copy */
-    dkCmdBufBarrier(dk->cmdbuf, DkBarrier_Full, DkInvalidateFlags_Image);
+    /* Barrier only if the render target was written since the last one */
+    dk_hazard_before_read(dk);
 
     /* Create copy command */
     DkImageView srcView;
@@ -149,9 +175,8 @@ void dk_read_pixels(sgl_backend_t *be, GLint x, GLint y,
      * Both default framebuffer and FBO textures use deko3d Y convention
      * when rendered to (viewport maps NDC y=+1 to row 0). */
     uint32_t src_height;
-    if (dk->current_fbo != 0 && dk->current_fbo_color > 0 &&
-        dk->current_fbo_color < SGL_MAX_TEXTURES) {
-        src_height = dk->texture_height[dk->current_fbo_color];
+    if (dk->current_fbo != 0 && dk->current_fbo_color > 0) {
+        src_height = dk_texture(dk, dk->current_fbo_color)->height;
     } else {
         src_height = dk->fb_height;
     }
@@ -163,9 +188,9 @@ void dk_read_pixels(sgl_backend_t *be, GLint x, GLint y,
     uint32_t dk_y = src_height - (uint32_t)y - (uint32_t)height;
 
     DkImageRect srcRect = { (uint32_t)x, dk_y, 0, (uint32_t)width, (uint32_t)height, 1 };
-    DkCopyBuf dstBuf = { dkMemBlockGetGpuAddr(readbackMem), (uint32_t)(width * 4), (uint32_t)height };
+    DkCopyBuf dstBuf = { dkMemBlockGetGpuAddr(readbackMem), (uint32_t)width * src_bpp, (uint32_t)height };
 
-    dkCmdBufCopyImageToBuffer(dk->cmdbuf, &srcView, &srcRect, &dstBuf, 0);
+    dkCmdBufCopyImageToBuffer(dk->main_stream.cmdbuf, &srcView, &srcRect, &dstBuf, 0);
 
     /* Check GPU queue error state BEFORE submitting — if already in error,
      * skip the submit to prevent crash, and return black pixels */
@@ -175,18 +200,16 @@ void dk_read_pixels(sgl_backend_t *be, GLint x, GLint y,
         dkMemBlockDestroy(readbackMem);
 
         /* Reset command buffer anyway */
-        dkCmdBufClear(dk->cmdbuf);
-        dkCmdBufAddMemory(dk->cmdbuf, dk->cmdbuf_memblock[dk->current_slot], 0, SGL_CMD_MEM_SIZE);
-        dk->descriptors_bound = false;
+        dk_reset_cmdbuf(dk);
 
         dk_rebind_default_render_target(dk);
         return;
     }
 
     /* Submit and wait for copy to complete */
-    DkCmdList cmdlist = dkCmdBufFinishList(dk->cmdbuf);
-    dkQueueSubmitCommands(dk->queue, cmdlist);
-    dkQueueWaitIdle(dk->queue);
+    DkCmdList cmdlist = dkCmdBufFinishList(dk->main_stream.cmdbuf);
+    dk_queue_submit(dk, cmdlist);
+    dk_wait_idle(dk);
 
     /* Check if the GPU queue entered an error state during this submit */
     if (dkQueueIsInErrorState(dk->queue)) {
@@ -197,7 +220,15 @@ void dk_read_pixels(sgl_backend_t *be, GLint x, GLint y,
      * The GPU copy reads rows top-to-bottom (deko3d order), but GL expects
      * row 0 = bottom of the read region. For height=1, no flip needed. */
     void *cpuAddr = dkMemBlockGetCpuAddr(readbackMem);
-    if (height == 1) {
+    if (packed) {
+        uint8_t *src_ptr = (uint8_t *)cpuAddr;
+        uint8_t *dst_ptr = (uint8_t *)pixels;
+        for (int row = 0; row < height; row++) {
+            sgl_pixel_widen_rgba8(dst_ptr + (size_t)row * width * 4,
+                                  src_ptr + (size_t)(height - 1 - row) * width * 2,
+                                  (uint32_t)width, packed);
+        }
+    } else if (height == 1) {
         memcpy(pixels, cpuAddr, (size_t)width * 4);
     } else {
         /* Flip rows: GPU buffer row 0 = GL top, but user expects row 0 = GL bottom */
@@ -215,18 +246,235 @@ void dk_read_pixels(sgl_backend_t *be, GLint x, GLint y,
     dkMemBlockDestroy(readbackMem);
 
     /* Reset command buffer for continued use */
-    dkCmdBufClear(dk->cmdbuf);
-    dkCmdBufAddMemory(dk->cmdbuf, dk->cmdbuf_memblock[dk->current_slot], 0, SGL_CMD_MEM_SIZE);
+    dk_reset_cmdbuf(dk);
 
     /* Re-bind render target after clearing command buffer */
     dk_rebind_render_target(dk);
 
-    /* Reset descriptors_bound flag */
-    dk->descriptors_bound = false;
-
     SGL_TRACE_FBO("read_pixels %d,%d %dx%d", x, y, width, height);
 }
 
+/* ============================================================================
+ * Asynchronous Readback (NV_pixel_buffer_object)
+ *
+ * The copy into the pack buffer is recorded into the current command list
+ * and followed by a per-buffer fence (with cache flush), so nothing waits
+ * here. dk_map_buffer() waits on that fence, which has normally signaled by
+ * the time the application maps the buffer one or two frames later.
+ * Rows are copied individually into flipped positions so the buffer ends up
+ * in GL order (row 0 = bottom) without a CPU pass.
+ * ============================================================================ */
+
+void dk_read_pixels_to_buffer(sgl_backend_t *be, GLint x, GLint y,
+                              GLsizei width, GLsizei height,
+                              GLenum format, GLenum type,
+                              sgl_handle_t buffer, uint32_t offset) {
+    (void)format;
+    (void)type;
+
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+
+    dk_buffer_t *buf = dk_buffer_rw(dk, buffer);
+    if (buffer == 0 || !buf || buf->offset == 0) return;
+    if (width <= 0 || height <= 0 || x < 0 || y < 0) return;
+    if (offset + (uint32_t)width * (uint32_t)height * 4 > buf->size) return;
+
+    const DkImage *srcImage = NULL;
+    uint32_t src_height = 0;
+    const dk_texture_t *color = dk_texture(dk, dk->current_fbo_color);
+    if (dk->current_fbo != 0 && dk->current_fbo_color > 0 && color->initialized) {
+        /* The copy engine cannot widen 16-bit texels into the buffer */
+        if (dk_packed16_type(color->format)) {
+            SGL_ERROR_BACKEND("read_pixels_to_buffer: 16-bit color attachment not supported");
+            return;
+        }
+        srcImage = &color->image;
+        src_height = color->height;
+    } else if (dk->framebuffers) {
+        srcImage = dk_resolution_read_image(dk);
+        src_height = dk->fb_height;
+    }
+    if (!srcImage || (uint32_t)y + (uint32_t)height > src_height) {
+        return;
+    }
+
+    dk_hazard_before_read(dk);
+
+    DkImageView srcView;
+    dkImageViewDefaults(&srcView, srcImage);
+
+    /* GL row r (from the bottom) is storage row dk_y + height - 1 - r */
+    uint32_t dk_y = src_height - (uint32_t)y - (uint32_t)height;
+    uint32_t row_bytes = (uint32_t)width * 4;
+    DkGpuAddr dst = dk_heap_gpu_addr(&dk->buffer_heap, buf->offset) + offset;
+    for (GLsizei row = 0; row < height; row++) {
+        DkImageRect srcRect = { (uint32_t)x, dk_y + (uint32_t)(height - 1 - row), 0,
+                                (uint32_t)width, 1, 1 };
+        DkCopyBuf dstBuf = { dst + (DkGpuAddr)row * row_bytes, row_bytes, 1 };
+        dkCmdBufCopyImageToBuffer(dk->main_stream.cmdbuf, &srcView, &srcRect, &dstBuf, 0);
+    }
+
+    /* Flush so the CPU sees the data once the fence signals */
+    dkCmdBufSignalFence(dk->main_stream.cmdbuf, &buf->pack_fence, true);
+    buf->pack_pending = true;
+    buf->pack_generation = dk->main_stream.state_generation;
+
+    SGL_TRACE_FBO("read_pixels_to_buffer %d,%d %dx%d -> buffer=%u+%u",
+                  x, y, width, height, buffer, offset);
+}
+
+/* ============================================================================
+ * Blit Framebuffer (glBlitFramebufferANGLE / glBlitFramebufferNV)
+ *
+ * The 2D engine scales and filters the rectangle from the read framebuffer's
+ * color image into the bound one, recorded with the rest of the frame (no
+ * shader, vertex setup or draw). Both images are render targets, so both
+ * keep GL row y at storage row height - 1 - y (see dk_read_pixels): each
+ * rectangle is converted on its own and FlipX/FlipY only express mirrored
+ * blits. Rectangles are clipped to both images, keeping the scale.
+ * ============================================================================ */
+
+typedef struct dk_blit_side {
+    DkImageView view;
+    sgl_handle_t tex;       /* Color texture, 0 for the default framebuffer */
+    DkImageFormat format;
+    uint32_t width;         /* GL size of the framebuffer */
+    uint32_t height;
+    float scale_x;          /* GL to storage coordinates (sglSetRenderResolution) */
+    float scale_y;
+} dk_blit_side_t;
+
+/* Color image of an FBO (or the default framebuffer). False if it has none. */
+static bool dk_blit_side(dk_backend_data_t *dk, sgl_handle_t fbo, sgl_handle_t color_tex,
+                         dk_blit_side_t *side) {
+    if (fbo != 0) {
+        const dk_texture_t *color = dk_texture(dk, color_tex);
+        if (color_tex == 0 || !color->initialized) return false;
+
+        dkImageViewDefaults(&side->view, &color->image);
+        side->view.mipLevelCount = 1;
+        if (color->is_cubemap) {
+            side->view.type = DkImageType_2D;
+            side->view.layerOffset = dk_fbo(dk, fbo)->color_layer[0];
+            side->view.layerCount = 1;
+        }
+        side->tex = color_tex;
+        side->format = color->format;
+        side->width = color->width;
+        side->height = color->height;
+        side->scale_x = 1.0f;
+        side->scale_y = 1.0f;
+        return true;
+    }
+
+    if (!dk->framebuffers) return false;
+    dkImageViewDefaults(&side->view, dk_default_color_image(dk));
+    side->tex = 0;
+    side->format = DkImageFormat_RGBA8_Unorm;
+    side->width = dk->fb_width;
+    side->height = dk->fb_height;
+    dk_resolution_scale(dk, &side->scale_x, &side->scale_y);
+    return true;
+}
+
+/*
+ * Clip one axis of a blit to the source and destination sizes, keeping the
+ * mapping between the two ranges (s0 < s1, d0 < d1; mirrored maps s0 to d1).
+ * Returns false when nothing is left.
+ */
+static bool dk_blit_clip_axis(float *s0, float *s1, float *d0, float *d1, bool mirror,
+                              float src_size, float dst_size) {
+    float scale = (*d1 - *d0) / (*s1 - *s0);
+
+    if (*s0 < 0.0f) {
+        float cut = -*s0 * scale;
+        if (mirror) *d1 -= cut; else *d0 += cut;
+        *s0 = 0.0f;
+    }
+    if (*s1 > src_size) {
+        float cut = (*s1 - src_size) * scale;
+        if (mirror) *d0 += cut; else *d1 -= cut;
+        *s1 = src_size;
+    }
+    if (*d0 < 0.0f) {
+        float cut = -*d0 / scale;
+        if (mirror) *s1 -= cut; else *s0 += cut;
+        *d0 = 0.0f;
+    }
+    if (*d1 > dst_size) {
+        float cut = (*d1 - dst_size) / scale;
+        if (mirror) *s0 += cut; else *s1 -= cut;
+        *d1 = dst_size;
+    }
+    return *s1 > *s0 && *d1 > *d0;
+}
+
+/* Storage rectangle of GL range [x0, x1) x [y0, y1), rounded to pixels */
+static DkImageRect dk_blit_rect(const dk_blit_side_t *side, float x0, float y0, float x1, float y1) {
+    uint32_t left = (uint32_t)(x0 * side->scale_x + 0.5f);
+    uint32_t right = (uint32_t)(x1 * side->scale_x + 0.5f);
+    uint32_t bottom = (uint32_t)(y0 * side->scale_y + 0.5f);
+    uint32_t top = (uint32_t)(y1 * side->scale_y + 0.5f);
+
+    DkImageRect rect = { left, side->height - top, 0, right - left, top - bottom, 1 };
+    return rect;
+}
+
+bool dk_blit_framebuffer(sgl_backend_t *be, sgl_handle_t read_fbo, sgl_handle_t read_color,
+                         const GLint src[4], const GLint dst[4], GLenum filter) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+
+    dk_blit_side_t s, d;
+    if (!dk_blit_side(dk, read_fbo, read_color, &s) ||
+        !dk_blit_side(dk, dk->current_fbo, dk->current_fbo_color, &d)) {
+        return true;  /* Nothing to read from or draw to */
+    }
+    if (s.format != d.format) {
+        SGL_ERROR_BACKEND("blit_framebuffer: color formats differ (%d -> %d)", s.format, d.format);
+        return false;
+    }
+    if (src[0] == src[2] || src[1] == src[3] || dst[0] == dst[2] || dst[1] == dst[3]) {
+        return true;
+    }
+
+    bool mirror_x = (src[2] < src[0]) != (dst[2] < dst[0]);
+    bool mirror_y = (src[3] < src[1]) != (dst[3] < dst[1]);
+    float sx0 = (float)(src[0] < src[2] ? src[0] : src[2]), sx1 = (float)(src[0] < src[2] ? src[2] : src[0]);
+    float sy0 = (float)(src[1] < src[3] ? src[1] : src[3]), sy1 = (float)(src[1] < src[3] ? src[3] : src[1]);
+    float dx0 = (float)(dst[0] < dst[2] ? dst[0] : dst[2]), dx1 = (float)(dst[0] < dst[2] ? dst[2] : dst[0]);
+    float dy0 = (float)(dst[1] < dst[3] ? dst[1] : dst[3]), dy1 = (float)(dst[1] < dst[3] ? dst[3] : dst[1]);
+
+    if (!dk_blit_clip_axis(&sx0, &sx1, &dx0, &dx1, mirror_x, (float)s.width, (float)d.width) ||
+        !dk_blit_clip_axis(&sy0, &sy1, &dy0, &dy1, mirror_y, (float)s.height, (float)d.height)) {
+        return true;
+    }
+
+    DkImageRect srcRect = dk_blit_rect(&s, sx0, sy0, sx1, sy1);
+    DkImageRect dstRect = dk_blit_rect(&d, dx0, dy0, dx1, dy1);
+    if (!srcRect.width || !srcRect.height || !dstRect.width || !dstRect.height) {
+        return true;
+    }
+
+    uint32_t flags = filter == GL_LINEAR ? DkBlitFlag_FilterLinear : DkBlitFlag_FilterNearest;
+    if (mirror_x) flags |= DkBlitFlag_FlipX;
+    if (mirror_y) flags |= DkBlitFlag_FlipY;
+
+    dk_hazard_before_blit(dk, s.tex);
+    dkCmdBufBlitImage(dk->main_stream.cmdbuf, &s.view, &srcRect, &d.view, &dstRect, flags, 0);
+
+    /* Sampling the destination waits for the 2D engine (dk_hazard.c) */
+    if (d.tex) {
+        dk_hazard_transfer_write(dk, d.tex);
+    } else {
+        dk->default_fb_write_epoch = dk->render_epoch;
+    }
+
+    SGL_TRACE_FBO("blit_framebuffer fbo %u (%u,%u %ux%u) -> fbo %u (%u,%u %ux%u) flags=0x%x",
+                  read_fbo, srcRect.x, srcRect.y, srcRect.width, srcRect.height,
+                  dk->current_fbo, dstRect.x, dstRect.y, dstRect.width, dstRect.height, flags);
+    return true;
+}
+
 /* ============================================================================
  * Renderbuffer Storage
  *
@@ -238,7 +486,8 @@ void dk_renderbuffer_storage(sgl_backend_t *be, sgl_handle_t handle,
                               GLenum internalformat, GLsizei width, GLsizei height) {
     dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
 
-    if (handle == 0 || handle >= SGL_MAX_RENDERBUFFERS) {
+    dk_renderbuffer_t *rb = handle ? (dk_renderbuffer_t *)sgl_table_ensure(&dk->renderbuffers, handle) : NULL;
+    if (!rb) {
         return;
     }
 
@@ -283,22 +532,22 @@ void dk_renderbuffer_storage(sgl_backend_t *be, sgl_handle_t handle,
     memMaker.flags = DkMemBlockFlags_GpuCached | DkMemBlockFlags_Image;
 
     /* Destroy old memblock if it exists */
-    if (dk->renderbuffer_memblocks[handle]) {
-        dkMemBlockDestroy(dk->renderbuffer_memblocks[handle]);
+    if (rb->memblock) {
+        dkMemBlockDestroy(rb->memblock);
     }
 
-    dk->renderbuffer_memblocks[handle] = dkMemBlockCreate(&memMaker);
-    if (!dk->renderbuffer_memblocks[handle]) {
+    rb->memblock = dkMemBlockCreate(&memMaker);
+    if (!rb->memblock) {
         return;
     }
 
     /* Initialize the image in the dedicated memblock */
-    dkImageInitialize(&dk->renderbuffer_images[handle], &layout,
-                      dk->renderbuffer_memblocks[handle], 0);
+    dkImageInitialize(&rb->image, &layout,
+                      rb->memblock, 0);
 
-    dk->renderbuffer_width[handle] = width;
-    dk->renderbuffer_height[handle] = height;
-    dk->renderbuffer_initialized[handle] = true;
+    rb->width = width;
+    rb->height = height;
+    rb->initialized = true;
 
     SGL_TRACE_FBO("renderbuffer_storage handle=%u format=0x%X %dx%d", handle, internalformat, width, height);
 }
@@ -313,19 +562,49 @@ void dk_renderbuffer_storage(sgl_backend_t *be, sgl_handle_t handle,
 void dk_delete_renderbuffer(sgl_backend_t *be, sgl_handle_t handle) {
     dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
 
-    if (handle == 0 || handle >= SGL_MAX_RENDERBUFFERS) {
+    dk_renderbuffer_t *rb = (dk_renderbuffer_t *)sgl_table_get(&dk->renderbuffers, handle);
+    if (handle == 0 || !rb) {
         return;
     }
 
     /* Destroy the dedicated memblock */
-    if (dk->renderbuffer_memblocks[handle]) {
-        dkMemBlockDestroy(dk->renderbuffer_memblocks[handle]);
-        dk->renderbuffer_memblocks[handle] = NULL;
+    if (rb->memblock) {
+        dkMemBlockDestroy(rb->memblock);
+        rb->memblock = NULL;
     }
 
-    dk->renderbuffer_initialized[handle] = false;
-    dk->renderbuffer_width[handle] = 0;
-    dk->renderbuffer_height[handle] = 0;
+    rb->initialized = false;
+    rb->width = 0;
+    rb->height = 0;
 
     SGL_TRACE_FBO("delete_renderbuffer handle=%u", handle);
 }
+
+/* ============================================================================
+ * Discard Framebuffer (glDiscardFramebufferEXT)
+ *
+ * Marks render target contents as no longer needed, so the tiled ROPs can
+ * drop them instead of writing them back to memory.
+ * ============================================================================ */
+
+void dk_discard_framebuffer(sgl_backend_t *be, uint32_t color_mask, bool depth_stencil) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_stream_t *s = dk_stream(dk);
+
+    for (uint32_t i = 0; i < SGL_MAX_DRAW_BUFFERS; i++) {
+        bool bound = dk->current_fbo != 0 ? dk->current_fbo_targets[i] != 0
+                                          : i == 0 && !dk->default_draw_none;
+        if ((color_mask & (1u << i)) && bound) {
+            dkCmdBufDiscardColor(s->cmdbuf, i);
+        }
+    }
+
+    bool has_depth = dk->current_fbo != 0 ? dk_fbo_depth_image(dk) != NULL
+                                          : dk->depth_images[dk->current_slot] != NULL;
+    if (depth_stencil && has_depth) {
+        dkCmdBufDiscardDepthStencil(s->cmdbuf);
+    }
+
+    SGL_TRACE_FBO("discard_framebuffer fbo=%u color=0x%X depth_stencil=%d",
+                  dk->current_fbo, color_mask, depth_stencil && has_depth);
+}
@@ -0,0 +1,237 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * deko3d Backend - Render Target Hazard Tracking
+ *
+ * Barriers are only recorded when GPU work actually depends on earlier work:
+ * - A texture rendered to is sampled, read back or copied
+ * - A texture written by the copy engine is sampled
+ * - A texture sampled earlier is about to be rendered to
+ *
+ * Instead of clearing per-texture flags on every barrier, each barrier that
+ * resolves a class of hazards bumps an epoch. A write is pending while the
+ * epoch it was recorded in is still current:
+ * - render_epoch: bumped by Fragments/Full barriers that invalidate images
+ * - transfer_epoch: bumped by Full barriers that also invalidate L2 (copy
+ *   engine writes bypass the 3D engine's L2 cache)
+ */
+
+#include "dk_internal.h"
+
+/* ============================================================================
+ * Initialization
+ * ============================================================================ */
+
+void dk_hazard_init(dk_backend_data_t *dk) {
+    /* Texture records start zeroed: DK_WRITE_NONE, epoch 0 */
+    memset(&dk->barrier_stats, 0, sizeof(dk->barrier_stats));
+    dk->default_fb_write_epoch = 0;
+    dk->tiles_pending = false;
+
+    /* Epoch 0 means "never" */
+    dk->render_epoch = 1;
+    dk->transfer_epoch = 1;
+}
+
+/* ============================================================================
+ * Barriers
+ * ============================================================================ */
+
+void dk_barrier(dk_backend_data_t *dk, DkBarrier mode, uint32_t invalidate) {
+    /* Upload threads only order their own copies, the epochs are the GL thread's */
+    dk_upload_t *u = dk_upload_current(dk);
+    if (u) {
+        dkCmdBufBarrier(u->stream.cmdbuf, mode, invalidate);
+        u->recorded = true;
+        if (mode == DkBarrier_Full && (invalidate & DkInvalidateFlags_L2Cache)) {
+            u->transfer_pending = false;
+        }
+        return;
+    }
+
+    /* Cleared before recording, so an upload thread flushing meanwhile re-arms it */
+    if (mode == DkBarrier_Full && (invalidate & DkInvalidateFlags_Image) &&
+        (invalidate & DkInvalidateFlags_L2Cache)) {
+        __atomic_store_n(&dk->upload_barrier_pending, false, __ATOMIC_RELAXED);
+    }
+    dkCmdBufBarrier(dk->main_stream.cmdbuf, mode, invalidate);
+
+    switch (mode) {
+        case DkBarrier_Full:      dk->barrier_stats.full++; break;
+        case DkBarrier_Tiles:     dk->barrier_stats.tiles++; break;
+        case DkBarrier_None:      break;
+        default:                  dk->barrier_stats.fragments++; break;
+    }
+    if (mode != DkBarrier_None) dk->main_stream.stats.barriers++;
+
+    if (mode != DkBarrier_None) {
+        dk->tiles_pending = false;
+    }
+    if (mode >= DkBarrier_Fragments && (invalidate & DkInvalidateFlags_Image)) {
+        dk->render_epoch++;
+        if (mode == DkBarrier_Full && (invalidate & DkInvalidateFlags_L2Cache)) {
+            dk->transfer_epoch++;  /* Also orders every upload recorded so far */
+        }
+    }
+    if (invalidate & DkInvalidateFlags_Descriptors) {
+        dk->descriptors_dirty = false;
+    }
+}
+
+/* ============================================================================
+ * Write Tracking
+ * ============================================================================ */
+
+static bool dk_hazard_write_pending(const dk_backend_data_t *dk, const dk_texture_t *tex) {
+    switch (tex->write_kind) {
+        case DK_WRITE_RENDER:   return tex->write_epoch == dk->render_epoch;
+        case DK_WRITE_TRANSFER: return tex->write_epoch == dk->transfer_epoch;
+        default:                return false;
+    }
+}
+
+void dk_hazard_render_write(dk_backend_data_t *dk) {
+    /* Recorder writes are resolved by the barrier after their command lists */
+    if (dk_stream(dk)->is_recorder) return;
+
+    dk->tiles_pending = true;
+
+    if (dk->current_fbo == 0) {
+        dk->default_fb_write_epoch = dk->render_epoch;
+        return;
+    }
+
+    /* Color targets, then the depth texture of a depth-only or shadow pass */
+    for (uint32_t i = 0; i <= SGL_MAX_DRAW_BUFFERS; i++) {
+        sgl_handle_t handle = i < SGL_MAX_DRAW_BUFFERS ? dk->current_fbo_targets[i]
+                                                       : dk->current_fbo_depth_tex;
+        dk_texture_t *tex = handle ? dk_texture_rw(dk, handle) : NULL;
+        if (!tex) continue;
+
+        /* A pending copy-engine write needs the stronger barrier, keep it */
+        if (tex->write_kind == DK_WRITE_TRANSFER && dk_hazard_write_pending(dk, tex)) {
+            continue;
+        }
+        tex->write_kind = DK_WRITE_RENDER;
+        tex->write_epoch = dk->render_epoch;
+    }
+}
+
+void dk_hazard_transfer_write(dk_backend_data_t *dk, sgl_handle_t handle) {
+    dk_texture_t *tex = handle ? dk_texture_rw(dk, handle) : NULL;
+    if (!tex) return;
+
+    /* The upload thread's flush ends with a full barrier and arms the GL
+     * thread's upload barrier, so only its own later copies need one */
+    dk_upload_t *u = dk_upload_current(dk);
+    if (u) {
+        u->transfer_pending = true;
+        tex->write_kind = DK_WRITE_NONE;
+        return;
+    }
+    tex->write_kind = DK_WRITE_TRANSFER;
+    tex->write_epoch = dk->transfer_epoch;
+}
+
+void dk_hazard_forget(dk_backend_data_t *dk, sgl_handle_t handle) {
+    dk_texture_t *tex = handle ? dk_texture_rw(dk, handle) : NULL;
+    if (!tex) return;
+    tex->write_kind = DK_WRITE_NONE;
+    tex->write_epoch = 0;
+    tex->sample_epoch = 0;
+}
+
+/* ============================================================================
+ * Hazard Resolution
+ * ============================================================================ */
+
+void dk_hazard_before_sample(dk_backend_data_t *dk, sgl_handle_t handle) {
+    dk_texture_t *tex = handle ? dk_texture_rw(dk, handle) : NULL;
+    if (!tex) return;
+
+    if (dk_hazard_write_pending(dk, tex)) {
+        if (tex->write_kind == DK_WRITE_TRANSFER) {
+            dk_barrier(dk, DkBarrier_Full,
+                       DkInvalidateFlags_Image | DkInvalidateFlags_Descriptors | DkInvalidateFlags_L2Cache);
+        } else {
+            /* Rendered by the 3D engine: fragments done + texture cache invalidate */
+            dk_barrier(dk, DkBarrier_Fragments, DkInvalidateFlags_Image);
+        }
+        SGL_TRACE_TEXTURE("hazard: sampling handle=%u after write", handle);
+    }
+    tex->sample_epoch = dk->render_epoch;
+}
+
+void dk_hazard_before_render(dk_backend_data_t *dk) {
+    /* Sampled since the last fragment barrier: those reads must finish first */
+    for (uint32_t i = 0; i <= SGL_MAX_DRAW_BUFFERS; i++) {
+        sgl_handle_t handle = i < SGL_MAX_DRAW_BUFFERS ? dk->current_fbo_targets[i]
+                                                       : dk->current_fbo_depth_tex;
+        if (handle > 0 && dk_texture(dk, handle)->sample_epoch == dk->render_epoch) {
+            dk_barrier(dk, DkBarrier_Fragments, DkInvalidateFlags_Image);
+            SGL_TRACE_FBO("hazard: rendering to handle=%u after sampling", handle);
+            return;
+        }
+    }
+
+    /* Plain target switch: only flush the tiled cache of the previous target */
+    if (dk->tiles_pending) {
+        dk_barrier(dk, DkBarrier_Tiles, 0);
+    }
+}
+
+void dk_hazard_before_copy(dk_backend_data_t *dk, sgl_handle_t handle) {
+    dk_texture_t *tex = handle ? dk_texture_rw(dk, handle) : NULL;
+    if (!tex) return;
+
+    dk_upload_t *u = dk_upload_current(dk);
+    if (u) {
+        if (u->transfer_pending) {
+            dk_barrier(dk, DkBarrier_Full, DkInvalidateFlags_Image | DkInvalidateFlags_L2Cache);
+        }
+        return;
+    }
+
+    /* Copies run outside the 3D pipeline: wait for everything */
+    bool pending = dk_hazard_write_pending(dk, tex);
+    if (dk->upload_barrier_pending || (pending && tex->write_kind == DK_WRITE_TRANSFER)) {
+        dk_barrier(dk, DkBarrier_Full, DkInvalidateFlags_Image | DkInvalidateFlags_L2Cache);
+    } else if (pending) {
+        dk_barrier(dk, DkBarrier_Full, DkInvalidateFlags_Image);
+    }
+}
+
+void dk_hazard_before_blit(dk_backend_data_t *dk, sgl_handle_t src) {
+    const dk_texture_t *s = src ? dk_texture(dk, src) : NULL;
+    const dk_texture_t *d = dk->current_fbo_color ? dk_texture(dk, dk->current_fbo_color) : NULL;
+
+    /* The 2D engine runs outside the 3D pipeline: the source must be
+     * finished, and so must draws to and sampling of the destination */
+    bool transfer = dk->upload_barrier_pending ||
+                    (s && s->write_kind == DK_WRITE_TRANSFER && dk_hazard_write_pending(dk, s)) ||
+                    (d && d->write_kind == DK_WRITE_TRANSFER && dk_hazard_write_pending(dk, d));
+    bool pending = dk->tiles_pending ||
+                   (s ? dk_hazard_write_pending(dk, s) : dk->default_fb_write_epoch == dk->render_epoch) ||
+                   (d ? dk_hazard_write_pending(dk, d) || d->sample_epoch == dk->render_epoch
+                      : dk->default_fb_write_epoch == dk->render_epoch);
+
+    if (transfer) {
+        dk_barrier(dk, DkBarrier_Full, DkInvalidateFlags_Image | DkInvalidateFlags_L2Cache);
+    } else if (pending) {
+        dk_barrier(dk, DkBarrier_Full, DkInvalidateFlags_Image);
+    }
+}
+
+void dk_hazard_before_read(dk_backend_data_t *dk) {
+    if (dk->current_fbo != 0) {
+        dk_hazard_before_copy(dk, dk->current_fbo_color);
+    } else if (dk->default_fb_write_epoch == dk->render_epoch) {
+        dk_barrier(dk, DkBarrier_Full, DkInvalidateFlags_Image);
+    }
+}
+
+void dk_get_barrier_stats(sgl_backend_t *be, uint32_t *full, uint32_t *fragments, uint32_t *tiles) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    if (full) *full = dk->barrier_stats.full;
+    if (fragments) *fragments = dk->barrier_stats.fragments;
+    if (tiles) *tiles = dk->barrier_stats.tiles;
+}
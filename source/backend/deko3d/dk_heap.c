@@ -0,0 +1,335 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * deko3d Backend - Range Heap Allocator
+ *
+ * Generic sub-allocator over one or more memblocks, used for shader code,
+ * VBO/EBO data and texture images:
+ * - Best-fit allocation with arbitrary power-of-two alignment
+ * - Heaps with backing create their memblocks on first use and, when
+ *   growable, add one whenever no free range fits
+ * - Free ranges kept sorted by offset and coalesced with their neighbours
+ * - Deferred frees parked per framebuffer slot and reclaimed once that
+ *   slot's fence has signaled, so the GPU never reads reused memory
+ */
+
+#include "dk_internal.h"
+
+/* ============================================================================
+ * Initialization
+ * ============================================================================ */
+
+void dk_heap_init(dk_heap_t *heap, const char *name, uint32_t base, uint32_t size) {
+    heap->name = name;
+    heap->base = base;
+    heap->size = size;
+    heap->free_list[0].offset = base;
+    heap->free_list[0].size = size;
+    heap->free_count = size > 0 ? 1 : 0;
+    memset(heap->pending_count, 0, sizeof(heap->pending_count));
+    heap->high_water = base;
+    heap->used = 0;
+    heap->peak = 0;
+    heap->failed = 0;
+    heap->block_count = 0;
+    heap->device = NULL;
+    heap->growable = false;
+}
+
+void dk_heap_set_backing(dk_heap_t *heap, DkDevice device, uint32_t block_size, uint32_t flags,
+                         uint32_t reserve, bool growable) {
+    heap->device = device;
+    heap->block_size = block_size;
+    heap->block_flags = flags;
+    heap->block_reserve = reserve;
+    heap->growable = growable;
+}
+
+void dk_heap_attach(dk_heap_t *heap, DkMemBlock memblock, uint32_t mem_base, uint32_t mem_size) {
+    dk_heap_block_t *b = &heap->blocks[0];
+    b->memblock = memblock;
+    b->base = mem_base;
+    b->size = mem_size;
+    b->start = heap->base;
+    b->end = heap->base + heap->size;
+    b->owned = false;
+    heap->block_count = 1;
+}
+
+void dk_heap_destroy(dk_heap_t *heap) {
+    for (uint32_t i = 0; i < heap->block_count; i++) {
+        if (heap->blocks[i].owned) {
+            dkMemBlockDestroy(heap->blocks[i].memblock);
+        }
+    }
+    heap->block_count = 0;
+}
+
+/* ============================================================================
+ * Growth
+ * ============================================================================ */
+
+/* Create a block with room for size bytes after the last one */
+static bool dk_heap_grow(dk_heap_t *heap, uint32_t size) {
+    if (!heap->device || heap->block_count >= DK_MAX_HEAP_BLOCKS) return false;
+    if (heap->block_count > 0 && !heap->growable) return false;
+    if (heap->free_count >= DK_MAX_HEAP_RANGES) return false;
+
+    uint64_t mem_size = SGL_ALIGN_UP((uint64_t)size + heap->block_reserve, SGL_PAGE_ALIGNMENT);
+    if (mem_size < heap->block_size) mem_size = heap->block_size;
+
+    uint64_t mem_base = 0;
+    if (heap->block_count > 0) {
+        const dk_heap_block_t *last = &heap->blocks[heap->block_count - 1];
+        mem_base = SGL_ALIGN_UP((uint64_t)last->base + last->size + 1, DK_HEAP_BLOCK_ALIGN);
+    }
+    if (mem_base + mem_size > UINT32_MAX) return false;
+
+    DkMemBlockMaker maker;
+    dkMemBlockMakerDefaults(&maker, heap->device, (uint32_t)mem_size);
+    maker.flags = heap->block_flags;
+    DkMemBlock memblock = dkMemBlockCreate(&maker);
+    if (!memblock) {
+        SGL_ERROR_BACKEND("%s heap: failed to create a %u KB block", heap->name,
+                          (unsigned)(mem_size / 1024));
+        return false;
+    }
+
+    /* Filled in before it is counted: lookups of older offsets never see a partial block */
+    dk_heap_block_t *b = &heap->blocks[heap->block_count];
+    b->memblock = memblock;
+    b->base = (uint32_t)mem_base;
+    b->size = (uint32_t)mem_size;
+    b->start = b->base;
+    b->end = b->base + b->size - heap->block_reserve;
+    b->owned = true;
+    heap->block_count++;
+
+    /* Above every existing range: append */
+    heap->free_list[heap->free_count].offset = b->start;
+    heap->free_list[heap->free_count].size = b->end - b->start;
+    heap->free_count++;
+    heap->size += b->end - b->start;
+
+    SGL_INFO(SGL_LOG_CAT_BACKEND, "[BACKEND] %s heap: block %u, %u KB (%u KB total)", heap->name,
+             heap->block_count - 1, b->size / 1024, heap->size / 1024);
+    return true;
+}
+
+/* ============================================================================
+ * Allocation
+ * ============================================================================ */
+
+/* Index of the free range to allocate from (best fit, or lowest offset), -1 if none fits */
+static int dk_heap_find(const dk_heap_t *heap, uint32_t size, uint32_t align, bool lowest,
+                        uint32_t *out_start) {
+    int best = -1;
+    for (uint32_t i = 0; i < heap->free_count; i++) {
+        const dk_heap_range_t *r = &heap->free_list[i];
+        uint32_t start = SGL_ALIGN_UP(r->offset, align);
+        if (start - r->offset + (uint64_t)size > r->size) continue;
+
+        if (best < 0 || r->size < heap->free_list[best].size) {
+            best = (int)i;
+            *out_start = start;
+            if (lowest || (r->size == size && start == r->offset)) break;  /* First or exact fit */
+        }
+    }
+    return best;
+}
+
+/* Carve [start, start + size) out of free range index */
+static void dk_heap_take(dk_heap_t *heap, int index, uint32_t start, uint32_t size) {
+    dk_heap_range_t *r = &heap->free_list[index];
+    uint32_t padding = start - r->offset;
+    uint32_t tail_offset = start + size;
+    uint32_t tail_size = r->offset + r->size - tail_offset;
+
+    if (padding > 0) {
+        /* Keep the alignment padding free, then the tail after it */
+        r->size = padding;
+        if (tail_size > 0) {
+            if (heap->free_count >= DK_MAX_HEAP_RANGES) {
+                SGL_ERROR_BACKEND("%s heap: free list full, dropping %u bytes", heap->name, tail_size);
+            } else {
+                memmove(r + 2, r + 1, (heap->free_count - index - 1) * sizeof(dk_heap_range_t));
+                r[1].offset = tail_offset;
+                r[1].size = tail_size;
+                heap->free_count++;
+            }
+        }
+    } else if (tail_size > 0) {
+        r->offset = tail_offset;
+        r->size = tail_size;
+    } else {
+        memmove(r, r + 1, (heap->free_count - index - 1) * sizeof(dk_heap_range_t));
+        heap->free_count--;
+    }
+
+    if (tail_offset > heap->high_water) {
+        heap->high_water = tail_offset;
+    }
+    heap->used += size;
+    if (heap->used > heap->peak) heap->peak = heap->used;
+}
+
+bool dk_heap_alloc(dk_heap_t *heap, uint32_t size, uint32_t align, uint32_t *out_offset) {
+    if (size == 0) return false;
+    if (align == 0) align = 1;
+
+    uint32_t start = 0;
+    int best = dk_heap_find(heap, size, align, false, &start);
+    if (best < 0 && dk_heap_grow(heap, size)) {
+        best = dk_heap_find(heap, size, align, false, &start);
+    }
+    if (best < 0) {
+        heap->failed++;
+        return false;
+    }
+
+    dk_heap_take(heap, best, start, size);
+    *out_offset = start;
+    return true;
+}
+
+bool dk_heap_alloc_low(dk_heap_t *heap, uint32_t size, uint32_t align, uint32_t *out_offset) {
+    if (size == 0) return false;
+    if (align == 0) align = 1;
+
+    uint32_t start = 0;
+    int index = dk_heap_find(heap, size, align, true, &start);
+    if (index < 0) return false;
+
+    dk_heap_take(heap, index, start, size);
+    *out_offset = start;
+    return true;
+}
+
+/* ============================================================================
+ * Deallocation
+ * ============================================================================ */
+
+void dk_heap_free(dk_heap_t *heap, uint32_t offset, uint32_t size) {
+    if (size == 0) return;
+    heap->used -= size < heap->used ? size : heap->used;
+
+    uint32_t i = 0;
+    while (i < heap->free_count && heap->free_list[i].offset < offset) i++;
+
+    bool merge_prev = i > 0 &&
+        heap->free_list[i - 1].offset + heap->free_list[i - 1].size == offset;
+    bool merge_next = i < heap->free_count &&
+        offset + size == heap->free_list[i].offset;
+
+    if (merge_prev && merge_next) {
+        heap->free_list[i - 1].size += size + heap->free_list[i].size;
+        memmove(&heap->free_list[i], &heap->free_list[i + 1],
+                (heap->free_count - i - 1) * sizeof(dk_heap_range_t));
+        heap->free_count--;
+    } else if (merge_prev) {
+        heap->free_list[i - 1].size += size;
+    } else if (merge_next) {
+        heap->free_list[i].offset = offset;
+        heap->free_list[i].size += size;
+    } else {
+        if (heap->free_count >= DK_MAX_HEAP_RANGES) {
+            SGL_ERROR_BACKEND("%s heap: free list full, leaking %u bytes at offset %u",
+                              heap->name, size, offset);
+            return;
+        }
+        memmove(&heap->free_list[i + 1], &heap->free_list[i],
+                (heap->free_count - i) * sizeof(dk_heap_range_t));
+        heap->free_list[i].offset = offset;
+        heap->free_list[i].size = size;
+        heap->free_count++;
+    }
+}
+
+void dk_heap_defer_free(dk_heap_t *heap, int slot, uint32_t offset, uint32_t size) {
+    if (size == 0) return;
+
+    uint32_t count = heap->pending_count[slot];
+    dk_heap_range_t *last = count > 0 ? &heap->pending[slot][count - 1] : NULL;
+
+    /* Orphaned ranges tend to be contiguous - extend the last pending entry */
+    if (last && last->offset + last->size == offset) {
+        last->size += size;
+    } else if (last && offset + size == last->offset) {
+        last->offset = offset;
+        last->size += size;
+    } else if (count >= DK_MAX_HEAP_RANGES) {
+        SGL_ERROR_BACKEND("%s heap: pending list full, leaking %u bytes at offset %u",
+                          heap->name, size, offset);
+    } else {
+        heap->pending[slot][count].offset = offset;
+        heap->pending[slot][count].size = size;
+        heap->pending_count[slot] = count + 1;
+    }
+}
+
+void dk_heap_reclaim(dk_heap_t *heap, int slot) {
+    for (uint32_t i = 0; i < heap->pending_count[slot]; i++) {
+        dk_heap_free(heap, heap->pending[slot][i].offset, heap->pending[slot][i].size);
+    }
+    heap->pending_count[slot] = 0;
+}
+
+void dk_heap_reclaim_all(dk_heap_t *heap) {
+    for (int slot = 0; slot < SGL_FB_NUM; slot++) {
+        dk_heap_reclaim(heap, slot);
+    }
+}
+
+/* ============================================================================
+ * Re-packing
+ * ============================================================================ */
+
+void dk_heap_reset(dk_heap_t *heap) {
+    heap->free_count = 0;
+    for (uint32_t i = 0; i < heap->block_count; i++) {
+        const dk_heap_block_t *b = &heap->blocks[i];
+        if (b->end > b->start) {
+            heap->free_list[heap->free_count].offset = b->start;
+            heap->free_list[heap->free_count].size = b->end - b->start;
+            heap->free_count++;
+        }
+    }
+    memset(heap->pending_count, 0, sizeof(heap->pending_count));
+    heap->high_water = heap->base;
+    heap->used = 0;
+}
+
+uint32_t dk_heap_trim(dk_heap_t *heap) {
+    uint32_t released = 0;
+    while (heap->block_count > 1 && heap->free_count > 0) {
+        dk_heap_block_t *b = &heap->blocks[heap->block_count - 1];
+        dk_heap_range_t *r = &heap->free_list[heap->free_count - 1];
+        if (!b->owned || r->offset != b->start || r->size != b->end - b->start) break;
+
+        dkMemBlockDestroy(b->memblock);
+        heap->size -= r->size;
+        heap->free_count--;
+        heap->block_count--;
+        released += b->size;
+    }
+    return released;
+}
+
+/* ============================================================================
+ * Statistics
+ * ============================================================================ */
+
+void dk_heap_get_stats(const dk_heap_t *heap, sgl_memory_heap_stats_t *stats) {
+    uint32_t largest = 0;
+    uint64_t free_bytes = 0;
+    for (uint32_t i = 0; i < heap->free_count; i++) {
+        free_bytes += heap->free_list[i].size;
+        if (heap->free_list[i].size > largest) largest = heap->free_list[i].size;
+    }
+
+    stats->capacity = heap->size;
+    stats->used = heap->used;
+    stats->peak = heap->peak;
+    stats->largest_free = largest;
+    stats->fragmentation = free_bytes ? (GLuint)((free_bytes - largest) * 100 / free_bytes) : 0;
+    stats->failed_allocs = heap->failed;
+}
@@ -30,6 +30,75 @@
 #define DK_VERBOSE_PRINT(...) do {} while(0)
 #endif
 
+/* ============================================================================
+ * Per-Handle Records
+ * ============================================================================ */
+
+/**
+ * Zeroed record standing in for a handle that has none yet (see dk_record).
+ * Shared by every thread and never written.
+ *
+ * @return Read-only zeroed record, large enough for any record type
+ */
+const void *dk_record_none(void);
+
+/*
+ * Record of a handle in one of the backend's tables. Lookups never allocate,
+ * so recorder threads may use them while the GL thread creates objects; a
+ * handle without a record reads as zeroed. They are read-only: entry points
+ * that write a record call sgl_table_ensure() first and give up when it
+ * fails, helpers write through the *_rw lookups below.
+ */
+static inline const void *dk_record(const sgl_table_t *t, uint32_t handle) {
+    const void *record = sgl_table_get(t, handle);
+    return record ? record : dk_record_none();
+}
+
+static inline const dk_texture_t *dk_texture(const dk_backend_data_t *dk, sgl_handle_t handle) {
+    return (const dk_texture_t *)dk_record(&dk->textures, handle);
+}
+
+static inline const dk_shader_record_t *dk_shader_record(const dk_backend_data_t *dk, sgl_handle_t handle) {
+    return (const dk_shader_record_t *)dk_record(&dk->shaders, handle);
+}
+
+static inline const dk_program_t *dk_program(const dk_backend_data_t *dk, sgl_handle_t handle) {
+    return (const dk_program_t *)dk_record(&dk->programs, handle);
+}
+
+static inline const dk_buffer_t *dk_buffer(const dk_backend_data_t *dk, sgl_handle_t handle) {
+    return (const dk_buffer_t *)dk_record(&dk->buffers, handle);
+}
+
+static inline const dk_renderbuffer_t *dk_renderbuffer(const dk_backend_data_t *dk, sgl_handle_t handle) {
+    return (const dk_renderbuffer_t *)dk_record(&dk->renderbuffers, handle);
+}
+
+static inline const dk_vtx_cache_t *dk_vertex_array(const dk_backend_data_t *dk, GLuint handle) {
+    return (const dk_vtx_cache_t *)dk_record(&dk->vertex_arrays, handle);
+}
+
+static inline const dk_fbo_t *dk_fbo(const dk_backend_data_t *dk, sgl_handle_t handle) {
+    return (const dk_fbo_t *)dk_record(&dk->fbos, handle);
+}
+
+/*
+ * Writable record of a handle, NULL if it has none. Only the thread that
+ * creates the handle's objects writes: the GL thread, or an upload thread
+ * for its own uploads.
+ */
+static inline dk_texture_t *dk_texture_rw(const dk_backend_data_t *dk, sgl_handle_t handle) {
+    return (dk_texture_t *)sgl_table_get(&dk->textures, handle);
+}
+
+static inline dk_program_t *dk_program_rw(const dk_backend_data_t *dk, sgl_handle_t handle) {
+    return (dk_program_t *)sgl_table_get(&dk->programs, handle);
+}
+
+static inline dk_buffer_t *dk_buffer_rw(const dk_backend_data_t *dk, sgl_handle_t handle) {
+    return (dk_buffer_t *)sgl_table_get(&dk->buffers, handle);
+}
+
 /* ============================================================================
  * Lifecycle Operations (dk_backend.c)
  * ============================================================================ */
@@ -42,7 +111,7 @@
  * @param device    Deko3d device handle (DkDevice)
  * @return 0 on success, -1 on failure
  */
-int dk_init(sgl_backend_t *be, void *device);
+int dk_init(sgl_backend_t *be, void *device, const struct sgl_heap_config *heaps);
 
 /**
  * Shutdown the deko3d backend.
@@ -119,6 +188,106 @@ void dk_finish(sgl_backend_t *be);
  */
 void dk_insert_barrier(sgl_backend_t *be);
 
+/**
+ * Get the current command state generation.
+ * The value changes every time the active command buffer is reset, which
+ * tells the GL layer that all previously applied state must be re-emitted.
+ *
+ * @param be    Backend pointer
+ * @return Monotonic generation counter
+ */
+uint32_t dk_get_state_generation(sgl_backend_t *be);
+
+/**
+ * Create a fence sync covering everything recorded so far. The main command
+ * buffer is submitted (without waiting) so the fence can be waited on at once.
+ *
+ * @param be    Backend pointer
+ * @return Sync handle, or 0 when all DK_MAX_SYNCS are in use
+ */
+sgl_handle_t dk_create_sync(sgl_backend_t *be);
+
+/**
+ * Delete a fence sync. Its fence is already submitted, so this never waits.
+ *
+ * @param be        Backend pointer
+ * @param handle    Sync handle
+ */
+void dk_delete_sync(sgl_backend_t *be, sgl_handle_t handle);
+
+/**
+ * Wait for a fence sync to signal.
+ *
+ * @param be            Backend pointer
+ * @param handle        Sync handle
+ * @param timeout_ns    Nanoseconds to wait: 0 polls, UINT64_MAX waits forever
+ * @return true once the work before the fence has finished
+ */
+bool dk_wait_sync(sgl_backend_t *be, sgl_handle_t handle, uint64_t timeout_ns);
+
+/**
+ * Clear the active command buffer and hand its memory back for recording.
+ * Resets descriptors_bound and bumps the state generation; the caller is
+ * responsible for re-binding the render target afterwards.
+ *
+ * @param dk    Backend data pointer (not sgl_backend_t)
+ */
+void dk_reset_cmdbuf(dk_backend_data_t *dk);
+
+/**
+ * Submit pending work, wait for the GPU to go idle, then reset the command
+ * buffer and rebind the current render target. Used when the CPU must touch
+ * memory that recorded or in-flight work may still access.
+ *
+ * @param dk    Backend data pointer (not sgl_backend_t)
+ */
+void dk_drain_queue(dk_backend_data_t *dk);
+
+/**
+ * Submit what the main stream has recorded so far without waiting, so the
+ * GPU starts on it while the CPU keeps recording into the same command
+ * buffer. Queue state carries over to the next command list.
+ *
+ * @param dk    Backend data pointer (not sgl_backend_t)
+ */
+void dk_submit_pending(dk_backend_data_t *dk);
+
+/**
+ * Submit a command list to the graphics queue. Copies recorded on the
+ * transfer queue are submitted first and waited for by the queue, so the
+ * list and every fence it signals come after them. Use it instead of
+ * calling dkQueueSubmitCommands on dk->queue directly.
+ *
+ * @param dk        Backend data pointer (not sgl_backend_t)
+ * @param cmdlist   Command list to submit
+ */
+void dk_queue_submit(dk_backend_data_t *dk, DkCmdList cmdlist);
+
+/**
+ * Wait for the GPU queue to go idle, counting the stall for sglGetFrameStats.
+ * Transfer queue copies are handed to it first, so they are complete too.
+ * Use it instead of calling dkQueueWaitIdle directly.
+ *
+ * @param dk    Backend data pointer (not sgl_backend_t)
+ */
+void dk_wait_idle(dk_backend_data_t *dk);
+
+/**
+ * Add one stream's frame counters to another's (recorder submission).
+ *
+ * @param dst   Counters to add to
+ * @param src   Counters to add
+ */
+void dk_frame_stats_add(sgl_frame_stats_t *dst, const sgl_frame_stats_t *src);
+
+/**
+ * Report the counters of the last frame submitted by dk_end_frame.
+ *
+ * @param be        Backend pointer
+ * @param stats     Receives the counters
+ */
+void dk_get_frame_stats(sgl_backend_t *be, sgl_frame_stats_t *stats);
+
 /**
  * Re-bind the default framebuffer's render target for the current slot.
  * Called after command buffer resets to restore rendering state.
@@ -130,7 +299,8 @@ void dk_rebind_default_render_target(dk_backend_data_t *dk);
 /**
  * Re-bind the current render target (FBO-aware).
  *
- * If an FBO is currently bound, re-binds the FBO color+depth attachments.
+ * If an FBO is currently bound, re-binds the FBO color targets (one per
+ * attachment enabled by glDrawBuffersEXT) and depth attachment.
  * Otherwise, falls back to dk_rebind_default_render_target() (swapchain).
  *
  * Call this after clearing/resetting the command buffer to restore the
@@ -140,6 +310,42 @@ void dk_rebind_default_render_target(dk_backend_data_t *dk);
  */
 void dk_rebind_render_target(dk_backend_data_t *dk);
 
+/**
+ * Depth image of the bound FBO: its depth renderbuffer, else its depth
+ * texture (GL_OES_depth_texture).
+ *
+ * @param dk    Backend data pointer
+ * @return Depth image, or NULL if the FBO has no initialized depth attachment
+ */
+const DkImage *dk_fbo_depth_image(dk_backend_data_t *dk);
+
+/**
+ * Check that the bound FBO has something to render into: an initialized
+ * color attachment 0 or depth attachment.
+ *
+ * @param dk    Backend data pointer
+ * @return true if the FBO can be bound as render target
+ */
+bool dk_fbo_has_target(dk_backend_data_t *dk);
+
+/**
+ * Bind the current render target (FBO-aware) into any command buffer.
+ * dk_rebind_render_target() is this on the main stream.
+ *
+ * @param dk        Backend data pointer (not sgl_backend_t)
+ * @param cmdbuf    Command buffer to record the binding into
+ */
+void dk_bind_render_target(dk_backend_data_t *dk, DkCmdBuf cmdbuf);
+
+/**
+ * Color image the default framebuffer renders into this frame: the
+ * swapchain image, or the internal target while dynamic resolution is on.
+ *
+ * @param dk    Backend data pointer (not sgl_backend_t)
+ * @return Image, or NULL before a surface is current
+ */
+DkImage *dk_default_color_image(dk_backend_data_t *dk);
+
 /* ============================================================================
  * State Application (dk_state.c)
  * ============================================================================ */
@@ -235,352 +441,1544 @@ void dk_set_depth_bias(sgl_backend_t *be, GLfloat factor, GLfloat units);
 void dk_clear(sgl_backend_t *be, GLbitfield mask, const float *color, float depth, int stencil);
 
 /* ============================================================================
- * Buffer Operations (dk_buffer.c)
+ * Range Heap Allocator (dk_heap.c)
  * ============================================================================ */
 
 /**
- * Create a new GPU buffer handle.
+ * Initialize a heap covering [base, base + size).
  *
- * @param be    Backend pointer
- * @return Handle to the new buffer, or 0 on failure
+ * @param heap  Heap to initialize
+ * @param name  Name used in error messages
+ * @param base  First offset managed by the heap
+ * @param size  Size of the managed region in bytes
  */
-sgl_handle_t dk_create_buffer(sgl_backend_t *be);
+void dk_heap_init(dk_heap_t *heap, const char *name, uint32_t base, uint32_t size);
 
 /**
- * Delete a GPU buffer.
+ * Let a heap create its own memblocks. Nothing is allocated until the first
+ * dk_heap_alloc needs memory; a growable heap then adds a block whenever
+ * no free range fits.
  *
- * @param be        Backend pointer
- * @param handle    Buffer handle to delete
+ * @param heap          Heap initialized with dk_heap_init(heap, name, 0, 0)
+ * @param device        Device the memblocks are created on
+ * @param block_size    Size of each block (page aligned)
+ * @param flags         DkMemBlockFlags of the blocks
+ * @param reserve       Bytes at the end of each block never allocated
+ * @param growable      false = a single block of block_size
  */
-void dk_delete_buffer(sgl_backend_t *be, sgl_handle_t handle);
+void dk_heap_set_backing(dk_heap_t *heap, DkDevice device, uint32_t block_size, uint32_t flags,
+                         uint32_t reserve, bool growable);
 
 /**
- * Upload data to a GPU buffer.
+ * Register a memblock owned by the caller that backs the heap's initial
+ * range [base, base + size). Offsets from mem_base up to the memblock's
+ * size resolve to it, so regions outside the heap can share the lookup.
  *
- * @param be        Backend pointer
- * @param handle    Buffer handle
- * @param target    GL buffer target (GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER)
- * @param size      Size of data in bytes
- * @param data      Pointer to source data (may be NULL for allocation only)
- * @param usage     GL usage hint
- * @return GPU memory offset of the allocated buffer, or 0 on failure
+ * @param heap      Heap to attach to
+ * @param memblock  Memblock holding the heap range
+ * @param mem_base  Heap offset of the memblock's first byte
+ * @param mem_size  Memblock size
  */
-uint32_t dk_buffer_data(sgl_backend_t *be, sgl_handle_t handle, GLenum target,
-                        GLsizeiptr size, const void *data, GLenum usage);
+void dk_heap_attach(dk_heap_t *heap, DkMemBlock memblock, uint32_t mem_base, uint32_t mem_size);
 
 /**
- * Update a portion of a GPU buffer.
+ * Destroy the memblocks the heap created.
  *
- * @param be            Backend pointer
- * @param handle        Buffer handle
- * @param buffer_offset Offset within the buffer to update
- * @param size          Size of data to update
- * @param data          Pointer to source data
+ * @param heap  Heap to release
  */
-void dk_buffer_sub_data(sgl_backend_t *be, sgl_handle_t handle,
-                        uint32_t buffer_offset, GLsizeiptr size, const void *data);
-
-/* ============================================================================
- * Draw Operations (dk_draw.c)
- * ============================================================================ */
+void dk_heap_destroy(dk_heap_t *heap);
 
 /**
- * Draw primitives from vertex arrays.
+ * Allocate a range (best fit). A heap with backing adds a memblock when no
+ * free range fits.
  *
- * @param be    Backend pointer
- * @param mode  Primitive type (GL_TRIANGLES, GL_TRIANGLE_STRIP, etc.)
- * @param first Index of first vertex
- * @param count Number of vertices to draw
+ * @param heap          Heap to allocate from
+ * @param size          Size in bytes
+ * @param align         Required alignment (power of two)
+ * @param out_offset    Receives the offset of the range
+ * @return true on success, false if no free range fits
  */
-void dk_draw_arrays(sgl_backend_t *be, GLenum mode, GLint first, GLsizei count);
+bool dk_heap_alloc(dk_heap_t *heap, uint32_t size, uint32_t align, uint32_t *out_offset);
 
 /**
- * Draw indexed primitives.
+ * Allocate the lowest free range that fits (first fit), never adding blocks.
+ * Used to re-pack a heap emptied with dk_heap_reset.
  *
- * @param be        Backend pointer
- * @param mode      Primitive type
- * @param count     Number of indices to draw
- * @param type      Index type (GL_UNSIGNED_SHORT, GL_UNSIGNED_INT)
- * @param indices   Pointer to indices (client array) or offset if EBO bound
- * @param ebo       Element buffer object handle (0 for client-side indices)
+ * @param heap          Heap to allocate from
+ * @param size          Size in bytes
+ * @param align         Required alignment (power of two)
+ * @param out_offset    Receives the offset of the range
+ * @return true on success, false if no free range fits
  */
-void dk_draw_elements(sgl_backend_t *be, GLenum mode, GLsizei count,
-                      GLenum type, const void *indices, sgl_handle_t ebo);
+bool dk_heap_alloc_low(dk_heap_t *heap, uint32_t size, uint32_t align, uint32_t *out_offset);
 
 /**
- * Bind vertex attributes for drawing.
- * Configures vertex buffer bindings and attribute formats.
+ * Return a range to the heap immediately, coalescing with its neighbours.
+ * Only valid when the GPU can no longer access the range.
  *
- * @param be            Backend pointer
- * @param attribs       Array of vertex attribute states
- * @param num_attribs   Number of attributes in array
- * @param first         First vertex index (for offset calculation)
- * @param count         Number of vertices (for size calculation)
+ * @param heap      Heap the range belongs to
+ * @param offset    Offset of the range
+ * @param size      Size of the range
  */
-void dk_bind_vertex_attribs(sgl_backend_t *be, const sgl_vertex_attrib_t *attribs,
-                            int num_attribs, GLint first, GLsizei count);
-
-/* ============================================================================
- * Uniform Operations (dk_uniform.c)
- * ============================================================================ */
+void dk_heap_free(dk_heap_t *heap, uint32_t offset, uint32_t size);
 
 /**
- * Allocate space in the uniform buffer.
+ * Free a range once the given slot's fence has signaled.
  *
- * @param be    Backend pointer
- * @param size  Size to allocate (will be aligned to 256 bytes)
- * @return Offset within uniform buffer region
+ * @param heap      Heap the range belongs to
+ * @param slot      Framebuffer slot currently recording
+ * @param offset    Offset of the range
+ * @param size      Size of the range
  */
-uint32_t dk_alloc_uniform(sgl_backend_t *be, uint32_t size);
+void dk_heap_defer_free(dk_heap_t *heap, int slot, uint32_t offset, uint32_t size);
 
 /**
- * Write data to uniform buffer at specified offset.
+ * Return every range deferred on a slot to the free list.
+ * Call only once the GPU has finished that slot's work.
  *
- * @param be        Backend pointer
- * @param offset    Offset within uniform buffer region
- * @param data      Pointer to source data
- * @param size      Size of data to write
+ * @param heap  Heap to reclaim
+ * @param slot  Framebuffer slot whose fence has signaled
  */
-void dk_write_uniform(sgl_backend_t *be, uint32_t offset, const void *data, uint32_t size);
-
-/* ============================================================================
- * Shader Operations (dk_shader.c)
- * ============================================================================ */
+void dk_heap_reclaim(dk_heap_t *heap, int slot);
 
 /**
- * Load a compiled shader from a .dksh file.
+ * Return every deferred range of every slot (GPU known to be idle).
  *
- * @param be        Backend pointer
- * @param handle    Shader handle to load into
- * @param path      Path to the .dksh file
- * @return true on success, false on failure
+ * @param heap  Heap to reclaim
  */
-bool dk_load_shader_file(sgl_backend_t *be, sgl_handle_t handle, const char *path);
+void dk_heap_reclaim_all(dk_heap_t *heap);
 
 /**
- * Load a compiled shader from a memory buffer.
+ * Mark every block entirely free, dropping pending frees. Statistics other
+ * than the bytes in use are kept. Call only once the GPU is idle.
  *
- * @param be        Backend pointer
- * @param handle    Shader handle to load into
- * @param data      Pointer to DKSH binary data
- * @param size      Size of binary data in bytes
- * @return true on success, false on failure
+ * @param heap  Heap to empty
  */
-bool dk_load_shader_binary(sgl_backend_t *be, sgl_handle_t handle,
-                           const void *data, size_t size);
+void dk_heap_reset(dk_heap_t *heap);
 
 /**
- * Link vertex and fragment shaders into a program.
- * Copies shader code to per-program storage for independent binding.
+ * Destroy created blocks at the end of the heap that hold no allocation,
+ * except the first. Call only once the GPU is idle.
  *
- * @param be                Backend pointer
- * @param program           Program handle
- * @param vertex_shader     Vertex shader handle
- * @param fragment_shader   Fragment shader handle
- * @return true on success, false on failure
+ * @param heap  Heap to shrink
+ * @return Bytes released
  */
-bool dk_link_program(sgl_backend_t *be, sgl_handle_t program,
-                     sgl_handle_t vertex_shader, sgl_handle_t fragment_shader);
+uint32_t dk_heap_trim(dk_heap_t *heap);
+
+/* Block holding a heap offset (NULL if none, e.g. no memory created yet) */
+static inline const dk_heap_block_t *dk_heap_block(const dk_heap_t *heap, uint32_t offset) {
+    uint32_t i = heap->block_count;
+    while (i > 0 && heap->blocks[i - 1].base > offset) i--;
+    return i > 0 ? &heap->blocks[i - 1] : NULL;
+}
+
+/* GPU address of a heap offset; the offset must be inside a block */
+static inline DkGpuAddr dk_heap_gpu_addr(const dk_heap_t *heap, uint32_t offset) {
+    const dk_heap_block_t *b = dk_heap_block(heap, offset);
+    return dkMemBlockGetGpuAddr(b->memblock) + (offset - b->base);
+}
+
+/* CPU address of a heap offset; the offset must be inside a CPU-visible block */
+static inline uint8_t *dk_heap_cpu_addr(const dk_heap_t *heap, uint32_t offset) {
+    const dk_heap_block_t *b = dk_heap_block(heap, offset);
+    return (uint8_t *)dkMemBlockGetCpuAddr(b->memblock) + (offset - b->base);
+}
 
 /**
- * Bind a program for rendering.
- * Binds shaders and uniform buffers with pushConstants for data capture.
+ * Fill one heap's sglGetMemoryStats entry.
  *
- * @param be                Backend pointer
- * @param program           Program handle
- * @param vertex_shader     Vertex shader handle (unused, kept for interface)
- * @param fragment_shader   Fragment shader handle (unused, kept for interface)
- * @param vertex_uniforms   Vertex stage uniform bindings
- * @param fragment_uniforms Fragment stage uniform bindings
- * @param max_uniforms      Maximum number of uniform bindings to process
+ * @param heap   Heap to report
+ * @param stats  Entry to fill
  */
-void dk_bind_program(sgl_backend_t *be, sgl_handle_t program,
-                     sgl_handle_t vertex_shader, sgl_handle_t fragment_shader,
-                     const sgl_uniform_binding_t *vertex_uniforms,
-                     const sgl_uniform_binding_t *fragment_uniforms,
-                     int max_uniforms,
-                     const sgl_packed_ubo_t *packed_vertex,
-                     const sgl_packed_ubo_t *packed_fragment,
-                     int max_packed_ubos);
+void dk_heap_get_stats(const dk_heap_t *heap, sgl_memory_heap_stats_t *stats);
 
 /* ============================================================================
- * Texture Operations (dk_texture.c)
+ * Upload Staging Ring (dk_staging.c)
  * ============================================================================ */
 
 /**
- * Upload 2D texture image data.
+ * Set up the staging ring. Its memblock is created by the first upload.
  *
- * @param be                Backend pointer
- * @param handle            Texture handle
- * @param target            Texture target (GL_TEXTURE_2D)
- * @param level             Mipmap level
- * @param internalformat    Internal format
- * @param width             Texture width
- * @param height            Texture height
- * @param border            Border width (must be 0)
- * @param format            Pixel data format
- * @param type              Pixel data type
- * @param pixels            Pointer to pixel data (may be NULL)
+ * @param dk    Backend data
+ * @param size  Ring size in bytes (multiple of SGL_PAGE_ALIGNMENT)
  */
-void dk_texture_image_2d(sgl_backend_t *be, sgl_handle_t handle,
-                         GLenum target, GLint level, GLint internalformat,
-                         GLsizei width, GLsizei height, GLint border,
-                         GLenum format, GLenum type, const void *pixels);
+void dk_staging_init(dk_backend_data_t *dk, uint32_t size);
 
 /**
- * Update a sub-region of a 2D texture.
+ * Destroy the staging ring and any chained memblocks (GPU must be idle).
  *
- * @param be        Backend pointer
- * @param handle    Texture handle
- * @param target    Texture target
- * @param level     Mipmap level
- * @param xoffset   X offset of region
- * @param yoffset   Y offset of region
- * @param width     Region width
- * @param height    Region height
- * @param format    Pixel data format
- * @param type      Pixel data type
- * @param pixels    Pointer to pixel data
+ * @param dk    Backend data
  */
-void dk_texture_sub_image_2d(sgl_backend_t *be, sgl_handle_t handle,
-                             GLenum target, GLint level,
-                             GLint xoffset, GLint yoffset,
-                             GLsizei width, GLsizei height,
-                             GLenum format, GLenum type, const void *pixels);
+void dk_staging_shutdown(dk_backend_data_t *dk);
 
 /**
- * Set a texture parameter.
+ * Allocate CPU-written, GPU-read staging memory for the current slot.
+ * The memory stays valid until the slot's fence has signaled. When the ring
+ * is full or the request is larger than the ring, a dedicated memblock is
+ * chained instead.
  *
- * @param be        Backend pointer
- * @param handle    Texture handle
- * @param target    Texture target
- * @param pname     Parameter name (GL_TEXTURE_MIN_FILTER, etc.)
- * @param param     Parameter value
+ * @param dk        Backend data
+ * @param size      Size in bytes
+ * @param align     Required alignment (power of two, at most SGL_PAGE_ALIGNMENT)
+ * @param out_cpu   Receives the CPU address
+ * @param out_gpu   Receives the GPU address
+ * @return true on success, false if no memory could be obtained
  */
-void dk_texture_parameter(sgl_backend_t *be, sgl_handle_t handle,
-                          GLenum target, GLenum pname, GLint param);
+bool dk_staging_alloc(dk_backend_data_t *dk, uint32_t size, uint32_t align,
+                      uint8_t **out_cpu, DkGpuAddr *out_gpu);
 
 /**
- * Bind a texture to a texture unit for sampling.
+ * Release the staging memory used by a slot.
+ * Call only once the GPU has finished that slot's work.
  *
- * @param be        Backend pointer
- * @param unit      Texture unit index
- * @param handle    Texture handle
+ * @param dk    Backend data
+ * @param slot  Framebuffer slot whose fence has signaled
  */
-void dk_bind_texture(sgl_backend_t *be, GLuint unit, sgl_handle_t handle);
+void dk_staging_reclaim(dk_backend_data_t *dk, int slot);
 
 /**
- * Generate mipmaps for a texture.
+ * Release all staging memory (GPU known to be idle).
  *
- * @param be        Backend pointer
- * @param handle    Texture handle
+ * @param dk    Backend data
  */
-void dk_generate_mipmap(sgl_backend_t *be, sgl_handle_t handle);
+void dk_staging_reclaim_all(dk_backend_data_t *dk);
+
+/* ============================================================================
+ * Command Memory Pool (dk_cmdmem.c)
+ * ============================================================================ */
 
 /**
- * Copy framebuffer to a new texture.
+ * Set up a chunk pool and install its out-of-memory callback.
  *
- * @param be                Backend pointer
- * @param handle            Texture handle
- * @param target            Texture target
- * @param level             Mipmap level
- * @param internalformat    Internal format
- * @param x                 Framebuffer X coordinate
- * @param y                 Framebuffer Y coordinate
- * @param width             Copy width
- * @param height            Copy height
+ * @param dk        Backend data
+ * @param pool      Pool to initialize
+ * @param slot      Framebuffer slot (or recorder id) for messages
+ * @param maker     Command buffer maker, before dkCmdBufCreate
  */
-void dk_copy_tex_image_2d(sgl_backend_t *be, sgl_handle_t handle,
-                          GLenum target, GLint level, GLenum internalformat,
-                          GLint x, GLint y, GLsizei width, GLsizei height);
+void dk_cmd_pool_init(dk_backend_data_t *dk, dk_cmd_pool_t *pool, int slot, DkCmdBufMaker *maker);
 
 /**
- * Copy framebuffer to a texture sub-region.
+ * Destroy every chunk of a pool (GPU must be done with its cmdbuf).
+ *
+ * @param pool  Pool to empty
+ */
+void dk_cmd_pool_shutdown(dk_cmd_pool_t *pool);
+
+/**
+ * Clear a command buffer, return its chunks to the pool and re-attach the
+ * base block. Call only once the GPU has finished with the cmdbuf.
+ *
+ * @param dk            Backend data
+ * @param pool          The cmdbuf's pool
+ * @param cmdbuf        Command buffer to clear
+ * @param base_block    Fixed block the cmdbuf starts with
+ * @param base_size     Size of base_block
+ */
+void dk_cmd_pool_recycle(dk_backend_data_t *dk, dk_cmd_pool_t *pool, DkCmdBuf cmdbuf,
+                         DkMemBlock base_block, uint32_t base_size);
+
+/**
+ * Recycle a slot's command buffer (dk_cmd_pool_recycle on the slot).
+ *
+ * @param dk    Backend data
+ * @param slot  Framebuffer slot
+ */
+void dk_cmdbuf_recycle(dk_backend_data_t *dk, int slot);
+
+/**
+ * Report command memory usage (sglGetCommandMemoryStats).
  *
  * @param be        Backend pointer
+ * @param peak      Most bytes a single cmdbuf has had attached
+ * @param pooled    Bytes currently held in overflow chunks
+ */
+void dk_get_cmd_mem_stats(sgl_backend_t *be, uint32_t *peak, uint32_t *pooled);
+
+/**
+ * Report the usage of every heap (sglGetMemoryStats).
+ *
+ * @param be     Backend pointer
+ * @param stats  Zero-filled stats to complete
+ */
+void dk_get_memory_stats(sgl_backend_t *be, sgl_memory_stats_t *stats);
+
+/* ============================================================================
+ * Render Target Hazard Tracking (dk_hazard.c)
+ * ============================================================================ */
+
+/**
+ * Reset hazard state and barrier counters.
+ *
+ * @param dk    Backend data
+ */
+void dk_hazard_init(dk_backend_data_t *dk);
+
+/**
+ * Record a barrier. Every barrier in the backend goes through here so the
+ * hazards it resolves are retired and it is counted in the barrier stats.
+ *
+ * @param dk            Backend data
+ * @param mode          Barrier mode
+ * @param invalidate    DkInvalidateFlags mask
+ */
+void dk_barrier(dk_backend_data_t *dk, DkBarrier mode, uint32_t invalidate);
+
+/**
+ * Note that a draw or clear wrote the current render target.
+ *
+ * @param dk    Backend data
+ */
+void dk_hazard_render_write(dk_backend_data_t *dk);
+
+/**
+ * Note that the copy engine wrote a texture. Sampling it requires a full
+ * barrier with L2 invalidation.
+ *
+ * @param dk        Backend data
  * @param handle    Texture handle
- * @param target    Texture target
- * @param level     Mipmap level
- * @param xoffset   Texture X offset
- * @param yoffset   Texture Y offset
- * @param x         Framebuffer X coordinate
- * @param y         Framebuffer Y coordinate
- * @param width     Copy width
- * @param height    Copy height
  */
-void dk_copy_tex_sub_image_2d(sgl_backend_t *be, sgl_handle_t handle,
-                              GLenum target, GLint level,
-                              GLint xoffset, GLint yoffset,
-                              GLint x, GLint y, GLsizei width, GLsizei height);
+void dk_hazard_transfer_write(dk_backend_data_t *dk, sgl_handle_t handle);
 
 /**
- * Upload compressed texture data (glCompressedTexImage2D).
- * Supports ASTC, ETC2, and BC (S3TC) formats natively.
+ * Drop the hazard state of a deleted texture.
+ *
+ * @param dk        Backend data
+ * @param handle    Texture handle
  */
-void dk_compressed_texture_image_2d(sgl_backend_t *be, sgl_handle_t handle,
-                                     GLenum target, GLint level, GLenum internalformat,
-                                     GLsizei width, GLsizei height,
-                                     GLsizei imageSize, const void *data);
+void dk_hazard_forget(dk_backend_data_t *dk, sgl_handle_t handle);
 
 /**
- * Update a region of a compressed texture (glCompressedTexSubImage2D).
+ * Resolve hazards before a texture is bound for sampling.
+ *
+ * @param dk        Backend data
+ * @param handle    Texture handle
  */
-void dk_compressed_texture_sub_image_2d(sgl_backend_t *be, sgl_handle_t handle,
-                                         GLenum target, GLint level,
-                                         GLint xoffset, GLint yoffset,
-                                         GLsizei width, GLsizei height,
-                                         GLenum format, GLsizei imageSize, const void *data);
+void dk_hazard_before_sample(dk_backend_data_t *dk, sgl_handle_t handle);
+
+/**
+ * Resolve hazards before switching the render target to
+ * dk->current_fbo_targets and current_fbo_depth_tex (all zero for the
+ * default framebuffer).
+ *
+ * @param dk        Backend data
+ */
+void dk_hazard_before_render(dk_backend_data_t *dk);
+
+/**
+ * Resolve hazards before the copy engine reads a texture (mipmap blits).
+ *
+ * @param dk        Backend data
+ * @param handle    Texture handle
+ */
+void dk_hazard_before_copy(dk_backend_data_t *dk, sgl_handle_t handle);
+
+/**
+ * Resolve hazards before the 2D engine blits into the current render target.
+ *
+ * @param dk        Backend data
+ * @param src       Source texture handle (0 = default framebuffer)
+ */
+void dk_hazard_before_blit(dk_backend_data_t *dk, sgl_handle_t src);
+
+/**
+ * Resolve hazards before the copy engine reads the current render target
+ * (glReadPixels, glCopyTexImage2D).
+ *
+ * @param dk    Backend data
+ */
+void dk_hazard_before_read(dk_backend_data_t *dk);
+
+/**
+ * Return the number of barriers recorded since init, by kind.
+ *
+ * @param be        Backend pointer
+ * @param full      Receives the DkBarrier_Full count (may be NULL)
+ * @param fragments Receives the DkBarrier_Fragments count (may be NULL)
+ * @param tiles     Receives the DkBarrier_Tiles count (may be NULL)
+ */
+void dk_get_barrier_stats(sgl_backend_t *be, uint32_t *full, uint32_t *fragments, uint32_t *tiles);
 
 /* ============================================================================
- * Framebuffer Operations (dk_framebuffer.c)
+ * Buffer Operations (dk_buffer.c)
  * ============================================================================ */
 
 /**
- * Bind a framebuffer for rendering.
+ * Create a new GPU buffer handle.
+ *
+ * @param be    Backend pointer
+ * @return Handle to the new buffer, or 0 on failure
+ */
+sgl_handle_t dk_create_buffer(sgl_backend_t *be);
+
+/**
+ * Delete a GPU buffer.
+ *
+ * @param be        Backend pointer
+ * @param handle    Buffer handle to delete
+ */
+void dk_delete_buffer(sgl_backend_t *be, sgl_handle_t handle);
+
+/**
+ * Upload data to a GPU buffer.
+ *
+ * @param be        Backend pointer
+ * @param handle    Buffer handle
+ * @param target    GL buffer target (GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER)
+ * @param size      Size of data in bytes
+ * @param data      Pointer to source data (may be NULL for allocation only)
+ * @param usage     GL usage hint (dynamic/stream buffers get a fresh range every call)
+ * @return GPU memory offset of the allocated buffer, or 0 on failure
+ */
+uint32_t dk_buffer_data(sgl_backend_t *be, sgl_handle_t handle, GLenum target,
+                        GLsizeiptr size, const void *data, GLenum usage);
+
+/**
+ * Update a portion of a GPU buffer.
  *
  * @param be            Backend pointer
- * @param handle        FBO handle (0 for default framebuffer)
- * @param color_tex     Color attachment texture handle
- * @param depth_rb      Depth renderbuffer handle (0 for none/default)
+ * @param handle        Buffer handle
+ * @param buffer_offset Offset within the buffer to update
+ * @param size          Size of data to update
+ * @param data          Pointer to source data
  */
-void dk_bind_framebuffer(sgl_backend_t *be, sgl_handle_t handle,
-                         sgl_handle_t color_tex, sgl_handle_t depth_rb);
+void dk_buffer_sub_data(sgl_backend_t *be, sgl_handle_t handle,
+                        uint32_t buffer_offset, GLsizeiptr size, const void *data);
 
 /**
- * Allocate GPU storage for a renderbuffer (depth/stencil).
+ * Return the CPU address of a buffer's storage for glMapBufferOES.
+ * Waits for a pending pixel pack readback into the buffer; this only stalls
+ * when the buffer is mapped in the same frame the readback was recorded.
  *
- * @param be                Backend pointer
- * @param handle            Renderbuffer handle
- * @param internalformat    Format (GL_DEPTH_COMPONENT16, GL_STENCIL_INDEX8, etc.)
- * @param width             Width in pixels
- * @param height            Height in pixels
+ * @param be        Backend pointer
+ * @param handle    Buffer handle
+ * @return CPU address, or NULL if the buffer has no storage
  */
-void dk_renderbuffer_storage(sgl_backend_t *be, sgl_handle_t handle,
-                              GLenum internalformat, GLsizei width, GLsizei height);
+void *dk_map_buffer(sgl_backend_t *be, sgl_handle_t handle);
 
 /**
- * Delete a renderbuffer's GPU resources.
+ * Initialize the VBO/EBO range allocator over [256, client_array_base) of
+ * data_memblock; unless growable is false, full heaps add memblocks.
+ * Must be called after the data memory regions are laid out.
+ *
+ * @param dk        Backend data pointer (not sgl_backend_t)
+ * @param growable  Add a data_mem_size block when no range fits
+ */
+void dk_buffer_heap_init(dk_backend_data_t *dk, bool growable);
+
+/* ============================================================================
+ * Draw Operations (dk_draw.c)
+ * ============================================================================ */
+
+/**
+ * Draw primitives from vertex arrays.
+ *
+ * @param be    Backend pointer
+ * @param mode  Primitive type (GL_TRIANGLES, GL_TRIANGLE_STRIP, etc.)
+ * @param first Index of first vertex
+ * @param count Number of vertices to draw
+ * @param instances Number of instances to draw (1 = not instanced)
+ */
+void dk_draw_arrays(sgl_backend_t *be, GLenum mode, GLint first, GLsizei count,
+                    GLsizei instances);
+
+/**
+ * Draw indexed primitives.
+ *
+ * @param be        Backend pointer
+ * @param mode      Primitive type
+ * @param count     Number of indices to draw
+ * @param type      Index type (GL_UNSIGNED_SHORT, GL_UNSIGNED_INT)
+ * @param indices   Pointer to indices (client array, only used when ebo is 0)
+ * @param ebo       Data memory offset of the indices (EBO data + offset, or
+ *                  indices staged by dk_upload_indices), 0 for client-side indices
+ * @param instances Number of instances to draw (1 = not instanced)
+ */
+void dk_draw_elements(sgl_backend_t *be, GLenum mode, GLsizei count,
+                      GLenum type, const void *indices, sgl_handle_t ebo,
+                      GLsizei instances);
+
+/**
+ * Copy client-side indices into this frame's client array region in a single
+ * pass that also returns the referenced vertex range.
+ *
+ * @param be        Backend pointer
+ * @param type      Index type (GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT, GL_UNSIGNED_INT)
+ * @param indices   Client index pointer
+ * @param count     Number of indices
+ * @param out_type  Receives the staged index type (u8 is widened to GL_UNSIGNED_SHORT)
+ * @param out_min   Receives the smallest index
+ * @param out_max   Receives the largest index
+ * @return Data memory offset of the staged indices, or 0 on failure
+ */
+uint32_t dk_upload_indices(sgl_backend_t *be, GLenum type, const void *indices, GLsizei count,
+                           GLenum *out_type, GLuint *out_min, GLuint *out_max);
+
+/**
+ * Hand the client array chunks chained this frame back to the buffer heap,
+ * reclaimed once the slot's fence has signaled.
+ *
+ * @param dk   Backend data
+ * @param slot Slot of the frame being ended
+ */
+void dk_client_arrays_end_frame(dk_backend_data_t *dk, int slot);
+
+/**
+ * Draw several vertex ranges with the state bound once.
+ *
+ * @param be          Backend pointer
+ * @param mode        Primitive type
+ * @param first       First vertex of each draw
+ * @param count       Vertex count of each draw (draws with 0 are skipped)
+ * @param drawcount   Number of draws
+ * @param ubo_stage   Stage of the packed UBO rebound per draw (0=VS, 1=FS)
+ * @param ubo_binding Binding of the packed UBO rebound per draw
+ * @param ubo_offsets Byte offset, a multiple of SGL_UNIFORM_ALIGNMENT, at
+ *                    which the UBO is bound for each draw. NULL = no rebinding
+ */
+void dk_multi_draw_arrays(sgl_backend_t *be, GLenum mode, const GLint *first,
+                          const GLsizei *count, GLsizei drawcount,
+                          int ubo_stage, int ubo_binding, const GLuint *ubo_offsets);
+
+/**
+ * Draw several index ranges with the state bound once.
  *
  * @param be            Backend pointer
- * @param handle        Renderbuffer handle
+ * @param mode          Primitive type
+ * @param count         Index count of each draw (draws with 0 are skipped)
+ * @param type          Index type, shared by all draws
+ * @param index_offsets Data memory offset of each draw's indices (EBO data +
+ *                      offset, or indices staged by dk_upload_indices)
+ * @param drawcount     Number of draws
+ * @param ubo_stage     See dk_multi_draw_arrays
+ * @param ubo_binding   See dk_multi_draw_arrays
+ * @param ubo_offsets   See dk_multi_draw_arrays
  */
-void dk_delete_renderbuffer(sgl_backend_t *be, sgl_handle_t handle);
+void dk_multi_draw_elements(sgl_backend_t *be, GLenum mode, const GLsizei *count,
+                            GLenum type, const uint32_t *index_offsets, GLsizei drawcount,
+                            int ubo_stage, int ubo_binding, const GLuint *ubo_offsets);
 
 /**
- * Read pixels from the current framebuffer.
+ * Bind vertex attributes for drawing.
+ * Configures vertex buffer bindings and attribute formats.
+ *
+ * @param be            Backend pointer
+ * @param attribs       Array of vertex attribute states
+ * @param num_attribs   Number of attributes in array
+ * @param first         First vertex index (for offset calculation)
+ * @param count         Number of vertices (for size calculation)
+ * @param instances     Number of instances (sizes attributes with a divisor)
+ */
+void dk_bind_vertex_attribs(sgl_backend_t *be, const sgl_vertex_attrib_t *attribs,
+                            int num_attribs, GLint first, GLsizei count,
+                            GLsizei instances);
+
+/**
+ * Bind the cached vertex state of a vertex array object.
+ * Only used for VAOs whose enabled attributes are contiguous and VBO-backed.
+ * Records nothing when the VAO is already bound and its buffers did not move.
+ *
+ * @param be            Backend pointer
+ * @param vao           Vertex array object id
+ * @param attribs       The VAO's vertex attribute states
+ * @param num_attribs   Number of attributes in array
+ * @param layout_dirty  Attribute layout changed since the last bind (rebuild the cache)
+ */
+void dk_bind_vertex_array(sgl_backend_t *be, GLuint vao, const sgl_vertex_attrib_t *attribs,
+                          int num_attribs, bool layout_dirty);
+
+/**
+ * Drop the cached vertex state of a deleted vertex array object.
+ *
+ * @param be    Backend pointer
+ * @param vao   Vertex array object id
+ */
+void dk_delete_vertex_array(sgl_backend_t *be, GLuint vao);
+
+/* ============================================================================
+ * Uniform Operations (dk_uniform.c)
+ * ============================================================================ */
+
+/**
+ * Allocate space in the uniform arena, chaining another block if the
+ * current ones are full.
+ *
+ * @param be    Backend pointer
+ * @param size  Size to allocate (will be aligned to 256 bytes)
+ * @return Arena offset (0 with an error logged if the arena is exhausted)
+ */
+uint32_t dk_alloc_uniform(sgl_backend_t *be, uint32_t size);
+
+/**
+ * CPU address of an arena offset.
+ *
+ * @param dk        Backend data
+ * @param offset    Arena offset from dk_alloc_uniform
+ * @return Pointer into the block holding the offset
+ */
+uint8_t *dk_uniform_cpu_addr(dk_backend_data_t *dk, uint32_t offset);
+
+/**
+ * GPU address of an arena offset.
+ *
+ * @param dk        Backend data
+ * @param offset    Arena offset from dk_alloc_uniform
+ * @return GPU address for binding or pushConstants
+ */
+DkGpuAddr dk_uniform_gpu_addr(dk_backend_data_t *dk, uint32_t offset);
+
+/**
+ * Destroy a stream's chained arena blocks (GPU must be idle).
+ * A recorder's block 0 is its own and is destroyed too.
+ *
+ * @param s     Stream owning the arena
+ */
+void dk_uniform_shutdown(dk_stream_t *s);
+
+/**
+ * Report uniform arena usage (sglGetUniformArenaStats).
+ *
+ * @param be            Backend pointer
+ * @param used          Bytes allocated so far this frame
+ * @param high_water    Most bytes any frame has allocated
+ * @param capacity      Bytes available across all blocks
+ */
+void dk_get_uniform_stats(sgl_backend_t *be, uint32_t *used, uint32_t *high_water, uint32_t *capacity);
+
+/**
+ * Write data to uniform buffer at specified offset.
  *
  * @param be        Backend pointer
- * @param x         X coordinate
- * @param y         Y coordinate
- * @param width     Read width
- * @param height    Read height
- * @param format    Pixel format (GL_RGBA)
- * @param type      Pixel type (GL_UNSIGNED_BYTE)
- * @param pixels    Destination buffer
+ * @param offset    Arena offset from dk_alloc_uniform
+ * @param data      Pointer to source data
+ * @param size      Size of data to write
  */
-void dk_read_pixels(sgl_backend_t *be, GLint x, GLint y,
-                    GLsizei width, GLsizei height,
-                    GLenum format, GLenum type, void *pixels);
+void dk_write_uniform(sgl_backend_t *be, uint32_t offset, const void *data, uint32_t size);
+
+/* ============================================================================
+ * Shader Operations (dk_shader.c)
+ * ============================================================================ */
+
+/**
+ * Load a compiled shader from a .dksh file.
+ *
+ * @param be        Backend pointer
+ * @param handle    Shader handle to load into
+ * @param path      Path to the .dksh file
+ * @return true on success, false on failure
+ */
+bool dk_load_shader_file(sgl_backend_t *be, sgl_handle_t handle, const char *path);
+
+/**
+ * Load a compiled shader from a memory buffer.
+ *
+ * @param be        Backend pointer
+ * @param handle    Shader handle to load into
+ * @param data      Pointer to DKSH binary data
+ * @param size      Size of binary data in bytes
+ * @return true on success, false on failure
+ */
+bool dk_load_shader_binary(sgl_backend_t *be, sgl_handle_t handle,
+                           const void *data, size_t size);
+
+/**
+ * Drop a shader's code. Programs linked from it keep their own reference.
+ *
+ * @param be        Backend pointer
+ * @param handle    Shader handle
+ */
+void dk_delete_shader(sgl_backend_t *be, sgl_handle_t handle);
+
+/**
+ * Link vertex and fragment shaders into a program.
+ * Copies shader code to per-program storage for independent binding.
+ *
+ * @param be                Backend pointer
+ * @param program           Program handle
+ * @param vertex_shader     Vertex shader handle
+ * @param fragment_shader   Fragment shader handle
+ * @return true on success, false on failure
+ */
+bool dk_link_program(sgl_backend_t *be, sgl_handle_t program,
+                     sgl_handle_t vertex_shader, sgl_handle_t fragment_shader);
+
+/**
+ * Drop a program's shader code; code no longer referenced is freed once
+ * the frames in flight have finished.
+ *
+ * @param be        Backend pointer
+ * @param handle    Program handle
+ */
+void dk_delete_program(sgl_backend_t *be, sgl_handle_t handle);
+
+/**
+ * Get the DKSH code a linked program uses for one stage.
+ * The pointer refers to code_heap memory and stays valid for the program's life.
+ *
+ * @param be        Backend pointer
+ * @param program   Program handle
+ * @param stage     0 = vertex, 1 = fragment
+ * @param code      Receives a CPU pointer to the DKSH code
+ * @param size      Receives the code size in bytes
+ * @return true if the stage is linked
+ */
+bool dk_get_program_code(sgl_backend_t *be, sgl_handle_t program, int stage,
+                         const void **code, uint32_t *size);
+
+/**
+ * Load a program's DKSH code directly, bypassing shader objects.
+ * Used by glProgramBinaryOES; equivalent to loading both shaders and linking.
+ *
+ * @param be        Backend pointer
+ * @param program   Program handle
+ * @param vs_code   Vertex shader DKSH
+ * @param vs_size   Vertex shader size in bytes
+ * @param fs_code   Fragment shader DKSH
+ * @param fs_size   Fragment shader size in bytes
+ * @return true on success, false on failure
+ */
+bool dk_load_program_binary(sgl_backend_t *be, sgl_handle_t program,
+                            const void *vs_code, size_t vs_size,
+                            const void *fs_code, size_t fs_size);
+
+/**
+ * Bind a program for rendering.
+ * Binds shaders and uniform buffers with pushConstants for data capture.
+ *
+ * @param be                Backend pointer
+ * @param program           Program handle
+ * @param vertex_shader     Vertex shader handle (unused, kept for interface)
+ * @param fragment_shader   Fragment shader handle (unused, kept for interface)
+ * @param vertex_uniforms   Vertex stage uniform bindings
+ * @param fragment_uniforms Fragment stage uniform bindings
+ * @param max_uniforms      Maximum number of uniform bindings to process
+ */
+void dk_bind_program(sgl_backend_t *be, sgl_handle_t program,
+                     sgl_handle_t vertex_shader, sgl_handle_t fragment_shader,
+                     const sgl_uniform_binding_t *vertex_uniforms,
+                     const sgl_uniform_binding_t *fragment_uniforms,
+                     int max_uniforms,
+                     const sgl_packed_ubo_t *packed_vertex,
+                     const sgl_packed_ubo_t *packed_fragment,
+                     int max_packed_ubos);
+
+/* ============================================================================
+ * Texture Operations (dk_texture.c)
+ * ============================================================================ */
+
+/**
+ * Upload 2D texture image data.
+ *
+ * @param be                Backend pointer
+ * @param handle            Texture handle
+ * @param target            Texture target (GL_TEXTURE_2D)
+ * @param level             Mipmap level
+ * @param internalformat    Internal format
+ * @param width             Texture width
+ * @param height            Texture height
+ * @param border            Border width (must be 0)
+ * @param format            Pixel data format
+ * @param type              Pixel data type
+ * @param pixels            Pointer to pixel data (may be NULL)
+ */
+void dk_texture_image_2d(sgl_backend_t *be, sgl_handle_t handle,
+                         GLenum target, GLint level, GLint internalformat,
+                         GLsizei width, GLsizei height, GLint border,
+                         GLenum format, GLenum type, const void *pixels);
+
+/**
+ * Update a sub-region of a 2D texture.
+ *
+ * @param be        Backend pointer
+ * @param handle    Texture handle
+ * @param target    Texture target
+ * @param level     Mipmap level
+ * @param xoffset   X offset of region
+ * @param yoffset   Y offset of region
+ * @param width     Region width
+ * @param height    Region height
+ * @param format    Pixel data format
+ * @param type      Pixel data type
+ * @param pixels    Pointer to pixel data
+ */
+void dk_texture_sub_image_2d(sgl_backend_t *be, sgl_handle_t handle,
+                             GLenum target, GLint level,
+                             GLint xoffset, GLint yoffset,
+                             GLsizei width, GLsizei height,
+                             GLenum format, GLenum type, const void *pixels);
+
+/**
+ * Set a texture parameter.
+ *
+ * @param be        Backend pointer
+ * @param handle    Texture handle
+ * @param target    Texture target
+ * @param pname     Parameter name (GL_TEXTURE_MIN_FILTER, etc.)
+ * @param param     Parameter value
+ */
+void dk_texture_parameter(sgl_backend_t *be, sgl_handle_t handle,
+                          GLenum target, GLenum pname, GLint param);
+
+/**
+ * Bind a texture to a texture unit for sampling.
+ *
+ * @param be        Backend pointer
+ * @param unit      Texture unit index
+ * @param handle    Texture handle
+ */
+void dk_bind_texture(sgl_backend_t *be, GLuint unit, sgl_handle_t handle);
+
+/**
+ * Forget which texture handle is bound to each unit.
+ * Called when recording into a new command buffer; the next bind of every
+ * unit records its texture handle again.
+ *
+ * @param s     Stream whose command buffer was reset
+ */
+void dk_texture_reset_residency(dk_stream_t *s);
+
+/**
+ * Create the descriptor heap: the sampler slots, then
+ * DK_IMAGE_DESCRIPTORS_INITIAL image slots. The image part grows on demand.
+ *
+ * @param dk    Backend data
+ * @return true on success
+ */
+bool dk_descriptor_heap_init(dk_backend_data_t *dk);
+
+/**
+ * Destroy the descriptor heap and every outgrown copy still waiting.
+ *
+ * @param dk    Backend data
+ */
+void dk_descriptor_heap_shutdown(dk_backend_data_t *dk);
+
+/**
+ * Destroy the descriptor memblocks outgrown while the slot was recording.
+ * Called once the slot's fence has signaled.
+ *
+ * @param dk    Backend data
+ * @param slot  Framebuffer slot index
+ */
+void dk_descriptor_heap_reclaim(dk_backend_data_t *dk, int slot);
+
+/**
+ * Delete a texture. Its storage returns to the texture heap once the
+ * current frame's fence has signaled.
+ *
+ * @param be        Backend pointer
+ * @param handle    Texture handle
+ */
+void dk_delete_texture(sgl_backend_t *be, sgl_handle_t handle);
+
+/**
+ * Defragment the texture heap by moving live textures down to the lowest
+ * free offsets. Drains the GPU; meant for loading screens.
+ *
+ * @param be    Backend pointer
+ */
+void dk_compact_texture_heap(sgl_backend_t *be);
+
+/**
+ * Set a pixel storage mode applied to subsequent uploads.
+ *
+ * @param be        Backend pointer
+ * @param pname     GL_UNPACK_ALIGNMENT (others ignored)
+ * @param param     Row alignment of client pixel data (1, 2, 4 or 8)
+ */
+void dk_pixel_store(sgl_backend_t *be, GLenum pname, GLint param);
+
+/**
+ * Generate mipmaps for a texture.
+ *
+ * @param be        Backend pointer
+ * @param handle    Texture handle
+ */
+void dk_generate_mipmap(sgl_backend_t *be, sgl_handle_t handle);
+
+/**
+ * Copy framebuffer to a new texture.
+ *
+ * @param be                Backend pointer
+ * @param handle            Texture handle
+ * @param target            Texture target
+ * @param level             Mipmap level
+ * @param internalformat    Internal format
+ * @param x                 Framebuffer X coordinate
+ * @param y                 Framebuffer Y coordinate
+ * @param width             Copy width
+ * @param height            Copy height
+ */
+void dk_copy_tex_image_2d(sgl_backend_t *be, sgl_handle_t handle,
+                          GLenum target, GLint level, GLenum internalformat,
+                          GLint x, GLint y, GLsizei width, GLsizei height);
+
+/**
+ * Copy framebuffer to a texture sub-region.
+ *
+ * @param be        Backend pointer
+ * @param handle    Texture handle
+ * @param target    Texture target
+ * @param level     Mipmap level
+ * @param xoffset   Texture X offset
+ * @param yoffset   Texture Y offset
+ * @param x         Framebuffer X coordinate
+ * @param y         Framebuffer Y coordinate
+ * @param width     Copy width
+ * @param height    Copy height
+ */
+void dk_copy_tex_sub_image_2d(sgl_backend_t *be, sgl_handle_t handle,
+                              GLenum target, GLint level,
+                              GLint xoffset, GLint yoffset,
+                              GLint x, GLint y, GLsizei width, GLsizei height);
+
+/**
+ * Upload compressed texture data (glCompressedTexImage2D).
+ * Supports ASTC, ETC2, and BC (S3TC) formats natively.
+ */
+void dk_compressed_texture_image_2d(sgl_backend_t *be, sgl_handle_t handle,
+                                     GLenum target, GLint level, GLenum internalformat,
+                                     GLsizei width, GLsizei height,
+                                     GLsizei imageSize, const void *data);
+
+/**
+ * Update a region of a compressed texture (glCompressedTexSubImage2D).
+ */
+void dk_compressed_texture_sub_image_2d(sgl_backend_t *be, sgl_handle_t handle,
+                                         GLenum target, GLint level,
+                                         GLint xoffset, GLint yoffset,
+                                         GLsizei width, GLsizei height,
+                                         GLenum format, GLsizei imageSize, const void *data);
+
+/**
+ * Create a compressed 2D texture and stream its levels into staging memory
+ * (sglTexImageFromFile). Each chunk is read straight into the staging ring
+ * and its copy recorded; the command list is submitted every
+ * DK_TEXTURE_STREAM_SUBMIT bytes so copies overlap the next reads.
+ *
+ * @param be                Backend pointer
+ * @param handle            Texture handle
+ * @param internalformat    Compressed format
+ * @param width             Level 0 width
+ * @param height            Level 0 height
+ * @param levels            Number of mip levels in the stream
+ * @param read              Reader for the level data
+ * @param user              Reader context
+ * @return true if every level was read and uploaded
+ */
+bool dk_compressed_texture_stream(sgl_backend_t *be, sgl_handle_t handle,
+                                  GLenum internalformat, GLsizei width, GLsizei height,
+                                  GLint levels, sgl_texture_read_fn read, void *user);
+
+/* ============================================================================
+ * Framebuffer Operations (dk_framebuffer.c)
+ * ============================================================================ */
+
+/**
+ * Bind a framebuffer for rendering.
+ *
+ * @param be            Backend pointer
+ * @param handle        FBO handle (0 for default framebuffer)
+ * @param color_tex     Color attachment texture handle
+ * @param depth_rb      Depth renderbuffer handle (0 for none/default)
+ */
+void dk_bind_framebuffer(sgl_backend_t *be, sgl_handle_t handle,
+                         sgl_handle_t color_tex, sgl_handle_t depth_rb);
+
+/**
+ * Record which cubemap face an FBO's color attachment renders to. Takes
+ * effect at the next dk_bind_framebuffer of the FBO.
+ *
+ * @param be            Backend pointer
+ * @param fbo           FBO handle
+ * @param attachment    GL attachment point (GL_COLOR_ATTACHMENT0..3 are tracked)
+ * @param textarget     GL_TEXTURE_2D or a GL_TEXTURE_CUBE_MAP_* face
+ * @param texture       Attached texture handle (0 detaches)
+ * @param level         Mip level (always 0 in GLES2)
+ */
+void dk_framebuffer_texture(sgl_backend_t *be, sgl_handle_t fbo, GLenum attachment,
+                            GLenum textarget, sgl_handle_t texture, GLint level);
+
+/**
+ * Select the color attachments an FBO draws to (glDrawBuffersEXT). Takes
+ * effect at the next dk_bind_framebuffer of the FBO.
+ *
+ * @param be            Backend pointer
+ * @param fbo           FBO handle (0 for default framebuffer, bit 0 = GL_BACK)
+ * @param mask          Bit i set draws fragment output i to GL_COLOR_ATTACHMENTi
+ */
+void dk_draw_buffers(sgl_backend_t *be, sgl_handle_t fbo, uint32_t mask);
+
+/**
+ * Blit a color rectangle from a read framebuffer into the bound one on the
+ * 2D engine (glBlitFramebufferANGLE).
+ *
+ * @param be            Backend pointer
+ * @param read_fbo      Read FBO handle (0 for default framebuffer)
+ * @param read_color    Color attachment texture handle of the read FBO
+ * @param src           Source corners x0, y0, x1, y1 (GL coordinates)
+ * @param dst           Destination corners x0, y0, x1, y1 (GL coordinates)
+ * @param filter        GL_NEAREST or GL_LINEAR
+ * @return false if the two color formats differ
+ */
+bool dk_blit_framebuffer(sgl_backend_t *be, sgl_handle_t read_fbo, sgl_handle_t read_color,
+                         const GLint src[4], const GLint dst[4], GLenum filter);
+
+/**
+ * Drop contents of the bound render target (glDiscardFramebufferEXT).
+ *
+ * @param be            Backend pointer
+ * @param color_mask    Color targets to discard, bit i = GL_COLOR_ATTACHMENTi
+ * @param depth_stencil Discard the depth-stencil image too
+ */
+void dk_discard_framebuffer(sgl_backend_t *be, uint32_t color_mask, bool depth_stencil);
+
+/**
+ * Allocate GPU storage for a renderbuffer (depth/stencil).
+ *
+ * @param be                Backend pointer
+ * @param handle            Renderbuffer handle
+ * @param internalformat    Format (GL_DEPTH_COMPONENT16, GL_STENCIL_INDEX8, etc.)
+ * @param width             Width in pixels
+ * @param height            Height in pixels
+ */
+void dk_renderbuffer_storage(sgl_backend_t *be, sgl_handle_t handle,
+                              GLenum internalformat, GLsizei width, GLsizei height);
+
+/**
+ * Delete a renderbuffer's GPU resources.
+ *
+ * @param be            Backend pointer
+ * @param handle        Renderbuffer handle
+ */
+void dk_delete_renderbuffer(sgl_backend_t *be, sgl_handle_t handle);
+
+/**
+ * Read pixels from the current framebuffer.
+ *
+ * @param be        Backend pointer
+ * @param x         X coordinate
+ * @param y         Y coordinate
+ * @param width     Read width
+ * @param height    Read height
+ * @param format    Pixel format (GL_RGBA)
+ * @param type      Pixel type (GL_UNSIGNED_BYTE)
+ * @param pixels    Destination buffer
+ */
+void dk_read_pixels(sgl_backend_t *be, GLint x, GLint y,
+                    GLsizei width, GLsizei height,
+                    GLenum format, GLenum type, void *pixels);
+
+/**
+ * Record a readback of the current framebuffer into a pixel pack buffer.
+ * Does not wait: the copy completes on a fence that dk_map_buffer() waits on.
+ *
+ * @param be        Backend pointer
+ * @param x         X coordinate
+ * @param y         Y coordinate
+ * @param width     Read width
+ * @param height    Read height
+ * @param format    Pixel format (GL_RGBA)
+ * @param type      Pixel type (GL_UNSIGNED_BYTE)
+ * @param buffer    Pack buffer handle
+ * @param offset    Byte offset within the buffer
+ */
+void dk_read_pixels_to_buffer(sgl_backend_t *be, GLint x, GLint y,
+                              GLsizei width, GLsizei height,
+                              GLenum format, GLenum type,
+                              sgl_handle_t buffer, uint32_t offset);
+
+/* ============================================================================
+ * Recorders and Command Lists (dk_recorder.c)
+ * ============================================================================ */
+
+/**
+ * Get the stream the calling thread records into.
+ * Worker threads attached to a recorder get its stream, everyone else
+ * the main stream. Every op that records commands must go through this.
+ *
+ * @param dk    Backend data pointer (not sgl_backend_t)
+ * @return Stream for the calling thread
+ */
+dk_stream_t *dk_stream(dk_backend_data_t *dk);
+
+/**
+ * Route the calling thread's recording into a stream (upload threads).
+ *
+ * @param s     Stream, NULL to go back to the main stream
+ */
+void dk_set_thread_stream(dk_stream_t *s);
+
+/**
+ * Allocate a state generation unique across all streams.
+ *
+ * @param dk    Backend data pointer (not sgl_backend_t)
+ * @return New generation value
+ */
+uint32_t dk_next_generation(dk_backend_data_t *dk);
+
+/**
+ * Create a recorder with its own command memory, uniform arena and
+ * client array range.
+ *
+ * @param be    Backend pointer
+ * @return Recorder handle, or 0 on failure
+ */
+sgl_handle_t dk_create_recorder(sgl_backend_t *be);
+
+/**
+ * Destroy a recorder, waiting for its last submission first.
+ *
+ * @param be        Backend pointer
+ * @param handle    Recorder handle
+ */
+void dk_delete_recorder(sgl_backend_t *be, sgl_handle_t handle);
+
+/**
+ * Rewind a recorder for a new recording and bind the current render
+ * target into it. GL thread only.
+ *
+ * @param be        Backend pointer
+ * @param handle    Recorder handle
+ * @return false if the handle is invalid
+ */
+bool dk_begin_recorder(sgl_backend_t *be, sgl_handle_t handle);
+
+/**
+ * Route the calling thread's recording into a recorder.
+ *
+ * @param be        Backend pointer
+ * @param handle    Recorder handle, 0 to go back to the main stream
+ */
+void dk_attach_recorder(sgl_backend_t *be, sgl_handle_t handle);
+
+/**
+ * Submit the main command buffer's work so far, then each pending
+ * recorder's list, with full barriers before and after. GL thread only.
+ *
+ * @param be        Backend pointer
+ * @param handles   Recorder handles, in submission order
+ * @param count     Number of handles
+ */
+void dk_submit_recorders(sgl_backend_t *be, const sgl_handle_t *handles, int count);
+
+/**
+ * Create a command list and record the GL thread's commands into it until
+ * dk_end_cmdlist. Nothing is bound up front: replays draw into the render
+ * target current at the call.
+ *
+ * @param be    Backend pointer
+ * @return Command list handle, or 0 on failure
+ */
+sgl_handle_t dk_begin_cmdlist(sgl_backend_t *be);
+
+/**
+ * Finish a command list and go back to recording the main stream.
+ *
+ * @param be        Backend pointer
+ * @param handle    Command list handle
+ * @return false if the handle is invalid or not recording
+ */
+bool dk_end_cmdlist(sgl_backend_t *be, sgl_handle_t handle);
+
+/**
+ * Replay a finished command list from the main command buffer, with full
+ * barriers around it; main stream state is re-emitted afterwards.
+ *
+ * @param be        Backend pointer
+ * @param handle    Command list handle
+ */
+void dk_call_cmdlist(sgl_backend_t *be, sgl_handle_t handle);
+
+/**
+ * Destroy a command list, waiting for its last replay first.
+ *
+ * @param be        Backend pointer
+ * @param handle    Command list handle
+ */
+void dk_delete_cmdlist(sgl_backend_t *be, sgl_handle_t handle);
+
+/**
+ * Give a command list's stream another client array chunk of at least
+ * size bytes from the buffer heap (dk_draw.c).
+ *
+ * @param dk    Backend data pointer (not sgl_backend_t)
+ * @param s     Stream of the command list being recorded
+ * @param size  Bytes the next allocation needs
+ * @return false if out of chunks or heap memory
+ */
+bool dk_cmdlist_client_chain(dk_backend_data_t *dk, dk_stream_t *s, uint32_t size);
+
+/**
+ * Destroy every recorder and command list (backend shutdown).
+ *
+ * @param dk    Backend data pointer (not sgl_backend_t)
+ */
+void dk_recorder_shutdown(dk_backend_data_t *dk);
+
+/* ============================================================================
+ * Shared Contexts and Upload Threads (dk_upload.c)
+ * ============================================================================ */
+
+/**
+ * A second context joined the share group: install the ops table whose
+ * resource ops hold share_lock and whose rendering ops are dropped on
+ * upload threads.
+ *
+ * @param be    Backend pointer
+ */
+void dk_share(sgl_backend_t *be);
+
+/**
+ * Give the calling thread an upload stream: command memory, staging block
+ * and queue of its own.
+ *
+ * @param be    Backend pointer
+ * @return false if all upload threads are taken or out of memory
+ */
+bool dk_attach_upload_thread(sgl_backend_t *be);
+
+/**
+ * Wait for the calling thread's uploads and free its upload stream.
+ *
+ * @param be    Backend pointer
+ */
+void dk_detach_upload_thread(sgl_backend_t *be);
+
+/**
+ * Upload stream of the calling thread.
+ *
+ * @param dk    Backend data pointer (not sgl_backend_t)
+ * @return The thread's upload stream, NULL on the GL thread
+ */
+dk_upload_t *dk_upload_current(dk_backend_data_t *dk);
+
+/**
+ * Submit the upload stream's work with a full barrier and its fence, and
+ * have the GL thread invalidate its texture caches at its next bind.
+ *
+ * @param dk    Backend data pointer (not sgl_backend_t)
+ * @param u     Upload stream
+ */
+void dk_upload_flush(dk_backend_data_t *dk, dk_upload_t *u);
+
+/**
+ * Flush, wait for the fence, then rewind staging and command memory and
+ * hand the ranges the thread freed to the GL thread's current slot.
+ *
+ * @param dk    Backend data pointer (not sgl_backend_t)
+ * @param u     Upload stream
+ */
+void dk_upload_finish(dk_backend_data_t *dk, dk_upload_t *u);
+
+/**
+ * Flush the upload stream and return the fence covering its work.
+ *
+ * @param dk        Backend data pointer (not sgl_backend_t)
+ * @param u         Upload stream
+ * @param out_fence Receives the fence
+ * @return false if nothing was ever submitted (already complete)
+ */
+bool dk_upload_fence(dk_backend_data_t *dk, dk_upload_t *u, DkFence *out_fence);
+
+/**
+ * Reserve staging memory in the upload stream's block, waiting for its
+ * earlier copies when the block is used up.
+ *
+ * @param dk        Backend data pointer (not sgl_backend_t)
+ * @param u         Upload stream
+ * @param size      Bytes needed
+ * @param align     Alignment (power of two)
+ * @param out_cpu   Receives the CPU address
+ * @param out_gpu   Receives the GPU address
+ * @return false if out of memory
+ */
+bool dk_upload_staging_alloc(dk_backend_data_t *dk, dk_upload_t *u, uint32_t size, uint32_t align,
+                             uint8_t **out_cpu, DkGpuAddr *out_gpu);
+
+/**
+ * Free a heap range once the GPU is done with it: after the current slot's
+ * fence, and on upload threads after the thread's own fence as well.
+ *
+ * @param dk        Backend data pointer (not sgl_backend_t)
+ * @param heap      Heap the range belongs to
+ * @param offset    Range offset
+ * @param size      Range size
+ */
+void dk_defer_free(dk_backend_data_t *dk, dk_heap_t *heap, uint32_t offset, uint32_t size);
+
+/**
+ * GL_UNPACK_ALIGNMENT of the calling thread's context.
+ *
+ * @param dk    Backend data pointer (not sgl_backend_t)
+ * @return Row alignment of client pixel data
+ */
+GLint dk_unpack_alignment(dk_backend_data_t *dk);
+
+/**
+ * Wait for and free every upload stream (backend shutdown).
+ *
+ * @param dk    Backend data pointer (not sgl_backend_t)
+ */
+void dk_upload_shutdown(dk_backend_data_t *dk);
+
+/* ============================================================================
+ * Transfer Queue (dk_transfer.c)
+ * ============================================================================ */
+
+/**
+ * Create or destroy the copy-only queue (sglSetTransferQueue). Destroying
+ * hands its last batch to the graphics queue and waits for it.
+ *
+ * @param be        Backend pointer
+ * @param enable    true to create the queue, false to destroy it
+ * @return true if the transfer queue is in use after the call
+ */
+bool dk_set_transfer_queue(sgl_backend_t *be, bool enable);
+
+/**
+ * Command buffer copies and uploads are recorded into: the calling thread's
+ * upload stream, the transfer queue's when the destination texture is not
+ * used by graphics work, or the main stream.
+ *
+ * @param dk            Backend data pointer (not sgl_backend_t)
+ * @param dst           Texture written (0: graphics queue)
+ * @param from_image    The source is an image or the copy needs the 2D
+ *                      engine: always record on the graphics queue
+ * @return Command buffer to record the transfer into
+ */
+DkCmdBuf dk_transfer_cmdbuf(dk_backend_data_t *dk, sgl_handle_t dst, bool from_image);
+
+/**
+ * Submit the transfer queue's recorded copies so they start right away.
+ * The graphics queue waits for them at its next dk_queue_submit.
+ *
+ * @param dk    Backend data pointer (not sgl_backend_t)
+ */
+void dk_transfer_submit(dk_backend_data_t *dk);
+
+/**
+ * dk_transfer_submit() once DK_TEXTURE_STREAM_SUBMIT bytes of staging were
+ * used since the last submit.
+ *
+ * @param dk    Backend data pointer (not sgl_backend_t)
+ */
+void dk_transfer_submit_staged(dk_backend_data_t *dk);
+
+/**
+ * Submit the transfer queue's copies and make the graphics queue wait for
+ * them. Called before every graphics submission and idle wait.
+ *
+ * @param dk    Backend data pointer (not sgl_backend_t)
+ */
+void dk_transfer_handoff(dk_backend_data_t *dk);
+
+/**
+ * Wait for and destroy the transfer queue (backend shutdown).
+ *
+ * @param dk    Backend data pointer (not sgl_backend_t)
+ */
+void dk_transfer_shutdown(dk_backend_data_t *dk);
+
+/* ============================================================================
+ * Query Objects (dk_query.c)
+ * ============================================================================ */
+
+/**
+ * Create a query object. Report memory is allocated on first use.
+ *
+ * @param be    Backend pointer
+ * @return Query handle, or 0 on failure
+ */
+sgl_handle_t dk_create_query(sgl_backend_t *be);
+
+/**
+ * Delete a query object. Reports still in flight land harmlessly.
+ *
+ * @param be        Backend pointer
+ * @param handle    Query handle
+ */
+void dk_delete_query(sgl_backend_t *be, sgl_handle_t handle);
+
+/**
+ * Record the begin report of a query in the main command buffer.
+ *
+ * @param be        Backend pointer
+ * @param handle    Query handle
+ * @param target    Query target (GL_TIME_ELAPSED_EXT, GL_ANY_SAMPLES_PASSED*_EXT)
+ */
+void dk_begin_query(sgl_backend_t *be, sgl_handle_t handle, GLenum target);
+
+/**
+ * Record the end report of a query begun with dk_begin_query.
+ *
+ * @param be        Backend pointer
+ * @param handle    Query handle
+ */
+void dk_end_query(sgl_backend_t *be, sgl_handle_t handle);
+
+/**
+ * Record a GPU timestamp into a query (glQueryCounterEXT).
+ *
+ * @param be        Backend pointer
+ * @param handle    Query handle
+ */
+void dk_query_counter(sgl_backend_t *be, sgl_handle_t handle);
+
+/**
+ * Read a query's result once the GPU has written it.
+ *
+ * @param be        Backend pointer
+ * @param handle    Query handle
+ * @param wait      Block until the result is available
+ * @param result    Receives GPU time in nanoseconds or the samples passed
+ * @return false if the result is not available yet (never when wait is set
+ *         and the query was ended)
+ */
+bool dk_get_query_result(sgl_backend_t *be, sgl_handle_t handle, bool wait, uint64_t *result);
+
+/**
+ * Read the newest result the GPU has finished writing, which may belong to
+ * an earlier begin/end of the query than the latest one. Never blocks.
+ *
+ * @param be        Backend pointer
+ * @param handle    Query handle
+ * @param result    Receives the result
+ * @return false if none of the query's recent results is available
+ */
+bool dk_get_last_query_result(sgl_backend_t *be, sgl_handle_t handle, uint64_t *result);
+
+/**
+ * Read the current GPU time. Submits and drains the queue.
+ *
+ * @param be    Backend pointer
+ * @return GPU time in nanoseconds, 0 on failure
+ */
+uint64_t dk_get_gpu_timestamp(sgl_backend_t *be);
+
+/**
+ * Free the query report memory (backend shutdown).
+ *
+ * @param dk    Backend data pointer (not sgl_backend_t)
+ */
+void dk_query_shutdown(dk_backend_data_t *dk);
+
+/**
+ * Record the start timestamp of a slot's frame (first thing in its cmdbuf).
+ *
+ * @param dk    Backend data pointer (not sgl_backend_t)
+ * @param slot  Frame slot
+ * @return false if the report memory could not be allocated
+ */
+bool dk_query_frame_begin(dk_backend_data_t *dk, int slot);
+
+/**
+ * Record the end timestamp of a slot's frame (before its fence).
+ *
+ * @param dk    Backend data pointer (not sgl_backend_t)
+ * @param slot  Frame slot
+ */
+void dk_query_frame_end(dk_backend_data_t *dk, int slot);
+
+/**
+ * GPU time between a slot's frame timestamps. Only valid once the slot's
+ * fence has been waited for.
+ *
+ * @param dk    Backend data pointer (not sgl_backend_t)
+ * @param slot  Frame slot
+ * @return Nanoseconds
+ */
+uint64_t dk_query_frame_time(dk_backend_data_t *dk, int slot);
+
+/* ============================================================================
+ * Dynamic Resolution (dk_resolution.c)
+ * ============================================================================ */
+
+/**
+ * Request a render size for the default framebuffer (sglSetRenderResolution).
+ * Turns the automatic controller off. Applies from the next frame.
+ *
+ * @param be        Backend pointer
+ * @param width     Render width, 0 (with height 0) for the surface size
+ * @param height    Render height
+ */
+void dk_set_render_resolution(sgl_backend_t *be, GLsizei width, GLsizei height);
+
+/**
+ * Let the GPU frame time pick the render size (sglSetDynamicResolution).
+ *
+ * @param be            Backend pointer
+ * @param target_ns     GPU frame time to stay under, 0 turns the controller off
+ * @param min_scale     Smallest fraction of the surface size to render at
+ */
+void dk_set_dynamic_resolution(sgl_backend_t *be, uint64_t target_ns, float min_scale);
+
+/**
+ * Size the default framebuffer renders at in the current frame.
+ *
+ * @param be        Backend pointer
+ * @param width     Receives the width
+ * @param height    Receives the height
+ */
+void dk_get_render_resolution(sgl_backend_t *be, GLsizei *width, GLsizei *height);
+
+/**
+ * Pick the slot's render size (feeding the controller with the GPU time of
+ * the slot's previous frame), make the internal target and start the frame
+ * timer. Called by dk_begin_frame after wait_fence, before the bind.
+ *
+ * @param dk    Backend data pointer (not sgl_backend_t)
+ * @param slot  Frame slot
+ */
+void dk_resolution_begin_frame(dk_backend_data_t *dk, int slot);
+
+/**
+ * Upscale the internal target into the slot's swapchain image and stop the
+ * frame timer. Called by dk_end_frame before the fence.
+ *
+ * @param dk    Backend data pointer (not sgl_backend_t)
+ * @param slot  Frame slot
+ */
+void dk_resolution_end_frame(dk_backend_data_t *dk, int slot);
+
+/**
+ * Default framebuffer color image to read from, in surface coordinates.
+ * While rendering below the surface size, records an upscale of the frame so
+ * far into the slot's swapchain image (which end_frame overwrites) and
+ * returns that; otherwise the image the frame renders into.
+ *
+ * @param dk    Backend data pointer (not sgl_backend_t)
+ * @return      Image of the surface size, NULL without a surface
+ */
+const DkImage *dk_resolution_read_image(dk_backend_data_t *dk);
+
+/**
+ * Factors from surface to render size of the default framebuffer
+ * (1, 1 while dynamic resolution is off).
+ *
+ * @param dk    Backend data pointer (not sgl_backend_t)
+ * @param sx    Receives the horizontal factor
+ * @param sy    Receives the vertical factor
+ */
+void dk_resolution_scale(const dk_backend_data_t *dk, float *sx, float *sy);
+
+/**
+ * Scale a default framebuffer rectangle from surface to render size.
+ * Leaves it alone while an FBO is bound or dynamic resolution is off.
+ *
+ * @param dk    Backend data pointer (not sgl_backend_t)
+ * @param x     X, scaled in place
+ * @param y     Y, scaled in place
+ * @param w     Width, scaled in place
+ * @param h     Height, scaled in place
+ */
+void dk_resolution_scale_rect(const dk_backend_data_t *dk, float *x, float *y, float *w, float *h);
+
+/**
+ * Free the internal target (backend shutdown).
+ *
+ * @param dk    Backend data pointer (not sgl_backend_t)
+ */
+void dk_resolution_shutdown(dk_backend_data_t *dk);
 
 /* ============================================================================
  * Utility/Conversion Functions (dk_utils.c)
@@ -592,12 +1990,14 @@ void dk_read_pixels(sgl_backend_t *be, GLint x, GLint y,
  * - DkBlendOp dk_convert_blend_op(GLenum op);
  * - DkPrimitive dk_convert_primitive(GLenum mode);
  * - DkImageFormat dk_convert_format(GLenum internalformat, GLenum format, GLenum type);
+ * - GLenum dk_packed16_type(DkImageFormat format);
  * - DkImageFormat dk_convert_compressed_format(GLenum internalformat);
  * - void dk_get_compressed_block_size(GLenum internalformat, int *blockWidth, int *blockHeight);
  * - int dk_get_compressed_block_bytes(GLenum internalformat);
  * - void dk_get_attrib_format(GLenum type, GLint size, GLboolean normalized,
  *                             DkVtxAttribSize *outSize, DkVtxAttribType *outType);
  * - GLsizei dk_get_type_size(GLenum type);
+ * - GLsizei dk_get_attrib_size(GLenum type, GLint size);
  * ============================================================================ */
 
 /* Compressed texture format helpers */
@@ -0,0 +1,274 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * deko3d Backend - Query Objects
+ *
+ * Each query owns DK_QUERY_HISTORY pairs of 16-byte counter reports
+ * (value, timestamp) in a CPU-visible memblock: begin and end. Every begin
+ * moves the query to its next pair, so the results of frames still in
+ * flight survive a query being reused every frame. A timestamp query
+ * writes only end; an occlusion query counts the samples passed between
+ * begin and end. dkCmdBufReportCounter lands the reports when the GPU
+ * reaches them, so a result is only read once the submission that held it
+ * has finished:
+ * - Every main cmdbuf submission bumps submit_serial; an instance remembers
+ *   the serial current when its end report was recorded (still unsubmitted)
+ * - Submissions that waited for the queue to drain move idle_serial along
+ * - Otherwise the instance's slot fence is polled with a zero timeout,
+ *   unless the slot has started a newer frame (wait_fence already waited)
+ * None of this blocks, so result availability can be polled every frame.
+ * Recorder cmdbufs never carry queries.
+ */
+#include "dk_internal.h"
+#include <GLES2/gl2ext.h>
+
+#define DK_QUERY_REPORT_SIZE    16  /* DkCounter report: u64 value, u64 timestamp */
+#define DK_QUERY_SLOT_SIZE      (2 * DK_QUERY_REPORT_SIZE)
+
+/* Maxwell's GPU timer ticks at 614.4 MHz */
+#define DK_GPU_TICKS_TO_NS(t)   ((t) * 625 / 384)
+
+typedef struct {
+    uint64_t value;
+    uint64_t timestamp;
+} dk_counter_report_t;
+
+static dk_query_t *dk_query_get(dk_backend_data_t *dk, sgl_handle_t handle) {
+    if (handle == 0 || handle > DK_MAX_QUERIES) return NULL;
+    dk_query_t *q = &dk->queries[handle - 1];
+    return q->used ? q : NULL;
+}
+
+/* Report pair index of a query instance; DK_TIMESTAMP_SLOT is reserved below */
+static uint32_t dk_query_slot(sgl_handle_t handle, uint32_t instance) {
+    return (handle - 1) * DK_QUERY_HISTORY + instance;
+}
+
+#define DK_TIMESTAMP_SLOT   (DK_MAX_QUERIES * DK_QUERY_HISTORY)
+#define DK_FRAME_TIME_SLOT  (DK_TIMESTAMP_SLOT + 1)     /* One pair per frame slot */
+#define DK_QUERY_NUM_SLOTS  (DK_FRAME_TIME_SLOT + SGL_FB_NUM)
+
+static DkGpuAddr dk_query_report_addr(dk_backend_data_t *dk, uint32_t index, int report) {
+    return dkMemBlockGetGpuAddr(dk->query_memblock) + index * DK_QUERY_SLOT_SIZE +
+           report * DK_QUERY_REPORT_SIZE;
+}
+
+static const dk_counter_report_t *dk_query_reports(dk_backend_data_t *dk, uint32_t index) {
+    const uint8_t *base = (const uint8_t *)dkMemBlockGetCpuAddr(dk->query_memblock);
+    return (const dk_counter_report_t *)(base + index * DK_QUERY_SLOT_SIZE);
+}
+
+/* Report memory is only allocated once queries are used */
+static bool dk_query_init_memory(dk_backend_data_t *dk) {
+    if (dk->query_memblock) return true;
+
+    /* Extra slots back dk_get_gpu_timestamp and the frame timer */
+    DkMemBlockMaker maker;
+    dkMemBlockMakerDefaults(&maker, dk->device,
+                            SGL_ALIGN_UP(DK_QUERY_NUM_SLOTS * DK_QUERY_SLOT_SIZE, SGL_PAGE_ALIGNMENT));
+    maker.flags = DkMemBlockFlags_CpuUncached | DkMemBlockFlags_GpuCached;
+    dk->query_memblock = dkMemBlockCreate(&maker);
+    if (!dk->query_memblock) {
+        SGL_ERROR_BACKEND("query: failed to allocate report memory");
+        return false;
+    }
+    return true;
+}
+
+/* Timer queries report the clock, occlusion queries the samples passed */
+static uint32_t dk_query_counter_type(GLenum target) {
+    switch (target) {
+        case GL_ANY_SAMPLES_PASSED_EXT:
+        case GL_ANY_SAMPLES_PASSED_CONSERVATIVE_EXT:
+            return DkCounter_SamplesPassed;
+        default:
+            return DkCounter_Timestamp;
+    }
+}
+
+/* ============================================================================
+ * Creation / Deletion
+ * ============================================================================ */
+
+sgl_handle_t dk_create_query(sgl_backend_t *be) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    if (!dk_query_init_memory(dk)) return 0;
+
+    for (uint32_t i = 0; i < DK_MAX_QUERIES; i++) {
+        if (!dk->queries[i].used) {
+            memset(&dk->queries[i], 0, sizeof(dk_query_t));
+            dk->queries[i].used = true;
+            return (sgl_handle_t)(i + 1);
+        }
+    }
+    SGL_ERROR_BACKEND("create_query: all %d queries in use", DK_MAX_QUERIES);
+    return 0;
+}
+
+void dk_delete_query(sgl_backend_t *be, sgl_handle_t handle) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_query_t *q = dk_query_get(dk, handle);
+    if (q) q->used = false;
+}
+
+void dk_query_shutdown(dk_backend_data_t *dk) {
+    if (dk->query_memblock) {
+        dkMemBlockDestroy(dk->query_memblock);
+        dk->query_memblock = NULL;
+    }
+    memset(dk->queries, 0, sizeof(dk->queries));
+}
+
+/* ============================================================================
+ * Recording
+ * ============================================================================ */
+
+/* Move to the next report pair; the oldest result is the one given up */
+static uint32_t dk_query_advance(dk_query_t *q, GLenum target) {
+    q->target = target;
+    q->current = (q->current + 1) % DK_QUERY_HISTORY;
+    q->instances[q->current].ended = false;
+    return q->current;
+}
+
+/* The end report decides when the result becomes readable */
+static void dk_query_mark_ended(dk_backend_data_t *dk, dk_query_instance_t *inst) {
+    inst->ended = true;
+    inst->submit = dk->submit_serial;
+    inst->slot = dk->current_slot;
+    inst->frame = dk->slot_frame[dk->current_slot];
+}
+
+void dk_begin_query(sgl_backend_t *be, sgl_handle_t handle, GLenum target) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_query_t *q = dk_query_get(dk, handle);
+    if (!q) return;
+
+    uint32_t instance = dk_query_advance(q, target);
+    dkCmdBufReportCounter(dk->main_stream.cmdbuf, dk_query_counter_type(target),
+                          dk_query_report_addr(dk, dk_query_slot(handle, instance), 0));
+
+    SGL_TRACE_BACKEND("begin_query %u target=0x%X instance=%u", handle, target, instance);
+}
+
+void dk_end_query(sgl_backend_t *be, sgl_handle_t handle) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_query_t *q = dk_query_get(dk, handle);
+    if (!q) return;
+
+    dkCmdBufReportCounter(dk->main_stream.cmdbuf, dk_query_counter_type(q->target),
+                          dk_query_report_addr(dk, dk_query_slot(handle, q->current), 1));
+    dk_query_mark_ended(dk, &q->instances[q->current]);
+
+    SGL_TRACE_BACKEND("end_query %u", handle);
+}
+
+void dk_query_counter(sgl_backend_t *be, sgl_handle_t handle) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_query_t *q = dk_query_get(dk, handle);
+    if (!q) return;
+
+    uint32_t instance = dk_query_advance(q, GL_TIMESTAMP_EXT);
+    dkCmdBufReportCounter(dk->main_stream.cmdbuf, DkCounter_Timestamp,
+                          dk_query_report_addr(dk, dk_query_slot(handle, instance), 1));
+    dk_query_mark_ended(dk, &q->instances[instance]);
+
+    SGL_TRACE_BACKEND("query_counter %u", handle);
+}
+
+/* ============================================================================
+ * Results
+ * ============================================================================ */
+
+static bool dk_query_done(dk_backend_data_t *dk, const dk_query_instance_t *inst) {
+    if (dk->submit_serial == inst->submit) return false;  /* Not submitted yet */
+    if (dk->idle_serial > inst->submit) return true;      /* Queue drained since */
+    if (dk->slot_frame[inst->slot] != inst->frame) return true;  /* Slot reused: its fence was waited */
+    return dkFenceWait(&dk->fences[inst->slot], 0) == DkResult_Success;
+}
+
+static uint64_t dk_query_value(dk_backend_data_t *dk, const dk_query_t *q, uint32_t index) {
+    const dk_counter_report_t *reports = dk_query_reports(dk, index);
+    switch (q->target) {
+        case GL_TIMESTAMP_EXT:
+            return DK_GPU_TICKS_TO_NS(reports[1].timestamp);
+        case GL_ANY_SAMPLES_PASSED_EXT:
+        case GL_ANY_SAMPLES_PASSED_CONSERVATIVE_EXT:
+            return reports[1].value - reports[0].value;
+        case GL_TIME_ELAPSED_EXT:
+        default:
+            return DK_GPU_TICKS_TO_NS(reports[1].timestamp - reports[0].timestamp);
+    }
+}
+
+bool dk_get_query_result(sgl_backend_t *be, sgl_handle_t handle, bool wait, uint64_t *result) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_query_t *q = dk_query_get(dk, handle);
+    if (!q) return false;
+    const dk_query_instance_t *inst = &q->instances[q->current];
+    if (!inst->ended) return false;
+
+    if (!dk_query_done(dk, inst)) {
+        if (!wait) return false;
+        if (dk->submit_serial == inst->submit) {
+            dk_finish(be);  /* Submits the current cmdbuf and waits for idle */
+        } else {
+            dkFenceWait(&dk->fences[inst->slot], -1);
+        }
+    }
+
+    *result = dk_query_value(dk, q, dk_query_slot(handle, q->current));
+    return true;
+}
+
+bool dk_get_last_query_result(sgl_backend_t *be, sgl_handle_t handle, uint64_t *result) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_query_t *q = dk_query_get(dk, handle);
+    if (!q) return false;
+
+    /* Newest instance first; all older ones were submitted before it */
+    for (uint32_t age = 0; age < DK_QUERY_HISTORY; age++) {
+        uint32_t instance = (q->current + DK_QUERY_HISTORY - age) % DK_QUERY_HISTORY;
+        const dk_query_instance_t *inst = &q->instances[instance];
+        if (inst->ended && dk_query_done(dk, inst)) {
+            *result = dk_query_value(dk, q, dk_query_slot(handle, instance));
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t dk_get_gpu_timestamp(sgl_backend_t *be) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    if (!dk_query_init_memory(dk)) return 0;
+
+    /* glGetInteger64v(GL_TIMESTAMP_EXT) has to return now: record and drain */
+    dkCmdBufReportCounter(dk->main_stream.cmdbuf, DkCounter_Timestamp,
+                          dk_query_report_addr(dk, DK_TIMESTAMP_SLOT, 1));
+    dk_finish(be);
+    return DK_GPU_TICKS_TO_NS(dk_query_reports(dk, DK_TIMESTAMP_SLOT)[1].timestamp);
+}
+
+/* ============================================================================
+ * Frame Timer (dk_resolution.c)
+ *
+ * A timestamp pair around each frame's command buffer. The slot's pair is
+ * read back at its next begin_frame, after wait_fence waited for the frame.
+ * ============================================================================ */
+
+bool dk_query_frame_begin(dk_backend_data_t *dk, int slot) {
+    if (!dk_query_init_memory(dk)) return false;
+    dkCmdBufReportCounter(dk->main_stream.cmdbuf, DkCounter_Timestamp,
+                          dk_query_report_addr(dk, DK_FRAME_TIME_SLOT + slot, 0));
+    return true;
+}
+
+void dk_query_frame_end(dk_backend_data_t *dk, int slot) {
+    dkCmdBufReportCounter(dk->main_stream.cmdbuf, DkCounter_Timestamp,
+                          dk_query_report_addr(dk, DK_FRAME_TIME_SLOT + slot, 1));
+}
+
+uint64_t dk_query_frame_time(dk_backend_data_t *dk, int slot) {
+    const dk_counter_report_t *reports = dk_query_reports(dk, DK_FRAME_TIME_SLOT + slot);
+    if (reports[1].timestamp < reports[0].timestamp) return 0;
+    return DK_GPU_TICKS_TO_NS(reports[1].timestamp - reports[0].timestamp);
+}
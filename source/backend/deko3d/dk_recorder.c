@@ -0,0 +1,397 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * deko3d Backend - Secondary Command Recorders
+ *
+ * A recorder is a command buffer plus the per-stream allocators a thread
+ * needs to record draws without touching the main stream:
+ * - Its own command memory, chained from a pool like the slot cmdbufs
+ * - Its own uniform arena (block 0 is a dedicated memblock)
+ * - A client array range carved from the buffer heap
+ * The GL thread rewinds a recorder (begin), worker threads attach to it and
+ * record, then the GL thread submits the lists after the main cmdbuf's work.
+ * Every backend op that records commands goes through dk_stream(), which
+ * returns the calling thread's attached recorder or the main stream.
+ *
+ * Command lists are streams the GL thread records once and then replays
+ * from the main cmdbuf with dkCmdBufCallList, any number of times:
+ * - Command memory, uniform blocks and client array chunks are the list's
+ *   own, allocated as recording needs them and kept until deletion
+ * - Neither the render target nor the descriptor sets are recorded, a
+ *   replay uses what the main cmdbuf has bound at the call
+ * - Like recorders, lists skip hazard tracking and get full barriers
+ */
+
+#include "dk_internal.h"
+
+/* Stream the calling thread records into; NULL = main stream */
+static __thread dk_stream_t *s_thread_stream = NULL;
+
+/* ============================================================================
+ * Streams
+ * ============================================================================ */
+
+dk_stream_t *dk_stream(dk_backend_data_t *dk) {
+    return s_thread_stream ? s_thread_stream : &dk->main_stream;
+}
+
+void dk_set_thread_stream(dk_stream_t *s) {
+    s_thread_stream = s;
+}
+
+uint32_t dk_next_generation(dk_backend_data_t *dk) {
+    /* Shared by all streams so a recorder's generation never matches a main one */
+    return __atomic_add_fetch(&dk->generation_counter, 1, __ATOMIC_RELAXED);
+}
+
+static dk_recorder_t *dk_recorder_get(dk_backend_data_t *dk, sgl_handle_t handle) {
+    if (handle == 0 || handle > DK_MAX_RECORDERS) return NULL;
+    return dk->recorders[handle - 1];
+}
+
+/* Wait until the GPU is done with the recorder's last submitted list */
+static void dk_recorder_wait(dk_recorder_t *r) {
+    if (r->fence_active) {
+        dkFenceWait(&r->fence, -1);
+        r->fence_active = false;
+    }
+}
+
+static void dk_recorder_destroy(dk_backend_data_t *dk, dk_recorder_t *r) {
+    dk_recorder_wait(r);
+    if (r->stream.cmdbuf) dkCmdBufDestroy(r->stream.cmdbuf);
+    dk_cmd_pool_shutdown(&r->cmd_pool);
+    if (r->cmd_memblock) dkMemBlockDestroy(r->cmd_memblock);
+    dk_uniform_shutdown(&r->stream);
+    if (r->stream.client_array_slot_end > 0) {
+        dk_heap_free(&dk->buffer_heap, r->client_offset, r->stream.client_array_slot_end);
+    }
+    free(r);
+}
+
+/* ============================================================================
+ * Creation / Deletion
+ * ============================================================================ */
+
+sgl_handle_t dk_create_recorder(sgl_backend_t *be) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+
+    int index = 0;
+    while (index < DK_MAX_RECORDERS && dk->recorders[index]) index++;
+    if (index == DK_MAX_RECORDERS) {
+        SGL_ERROR_BACKEND("create_recorder: all %d recorders in use", DK_MAX_RECORDERS);
+        return 0;
+    }
+
+    dk_recorder_t *r = (dk_recorder_t *)calloc(1, sizeof(dk_recorder_t));
+    if (!r) return 0;
+    dk_stream_t *s = &r->stream;
+    s->is_recorder = true;
+
+    DkMemBlockMaker memMaker;
+    dkMemBlockMakerDefaults(&memMaker, dk->device, DK_RECORDER_CMD_MEM_SIZE);
+    memMaker.flags = DkMemBlockFlags_CpuUncached | DkMemBlockFlags_GpuCached;
+    r->cmd_memblock = dkMemBlockCreate(&memMaker);
+
+    DkCmdBufMaker cmdMaker;
+    dkCmdBufMakerDefaults(&cmdMaker, dk->device);
+    dk_cmd_pool_init(dk, &r->cmd_pool, SGL_FB_NUM + index, &cmdMaker);
+    s->cmdbuf = r->cmd_memblock ? dkCmdBufCreate(&cmdMaker) : NULL;
+
+    dkMemBlockMakerDefaults(&memMaker, dk->device, SGL_UNIFORM_BUF_SIZE);
+    memMaker.flags = DkMemBlockFlags_CpuUncached | DkMemBlockFlags_GpuCached;
+    s->uniform_blocks[0] = dkMemBlockCreate(&memMaker);
+    if (s->uniform_blocks[0]) s->uniform_num_blocks = 1;
+
+    bool have_client = dk_heap_alloc(&dk->buffer_heap, DK_RECORDER_CLIENT_SIZE,
+                                     SGL_UNIFORM_ALIGNMENT, &r->client_offset);
+    if (have_client) {
+        s->client_array_base = r->client_offset;
+        s->client_array_slot_end = DK_RECORDER_CLIENT_SIZE;
+    }
+
+    if (!s->cmdbuf || !s->uniform_blocks[0] || !have_client) {
+        SGL_ERROR_BACKEND("create_recorder: out of memory");
+        dk_recorder_destroy(dk, r);
+        return 0;
+    }
+    dkCmdBufAddMemory(s->cmdbuf, r->cmd_memblock, 0, DK_RECORDER_CMD_MEM_SIZE);
+
+    dk->recorders[index] = r;
+    SGL_TRACE_BACKEND("create_recorder -> %d", index + 1);
+    return (sgl_handle_t)(index + 1);
+}
+
+void dk_delete_recorder(sgl_backend_t *be, sgl_handle_t handle) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_recorder_t *r = dk_recorder_get(dk, handle);
+    if (!r) return;
+
+    if (s_thread_stream == &r->stream) s_thread_stream = NULL;
+    dk_recorder_destroy(dk, r);
+    dk->recorders[handle - 1] = NULL;
+}
+
+static void dk_cmdlist_destroy(dk_backend_data_t *dk, dk_cmdlist_t *l);
+
+void dk_recorder_shutdown(dk_backend_data_t *dk) {
+    for (int i = 0; i < DK_MAX_RECORDERS; i++) {
+        if (dk->recorders[i]) {
+            dk_recorder_destroy(dk, dk->recorders[i]);
+            dk->recorders[i] = NULL;
+        }
+    }
+    for (uint32_t handle = 1; handle < sgl_table_end(&dk->cmdlists); handle++) {
+        dk_cmdlist_t **slot = (dk_cmdlist_t **)sgl_table_get(&dk->cmdlists, handle);
+        if (slot && *slot) {
+            dk_cmdlist_destroy(dk, *slot);
+            *slot = NULL;
+        }
+    }
+    s_thread_stream = NULL;
+}
+
+/* ============================================================================
+ * Recording
+ * ============================================================================ */
+
+bool dk_begin_recorder(sgl_backend_t *be, sgl_handle_t handle) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_recorder_t *r = dk_recorder_get(dk, handle);
+    if (!r) return false;
+
+    /* The previous recording may still be executing */
+    dk_recorder_wait(r);
+    dk_cmd_pool_recycle(dk, &r->cmd_pool, r->stream.cmdbuf, r->cmd_memblock, DK_RECORDER_CMD_MEM_SIZE);
+
+    dk_stream_t *s = &r->stream;
+    s->uniform_offset = 0;
+    s->client_array_offset = 0;
+    s->descriptors_bound = false;
+    s->bound_vertex_array = 0;
+    s->state_generation = dk_next_generation(dk);
+    dk_texture_reset_residency(s);
+    memset(&s->stats, 0, sizeof(s->stats));
+
+    /* Recorders draw into whatever the GL thread has bound right now */
+    dk_bind_render_target(dk, s->cmdbuf);
+    r->pending = true;
+
+    SGL_TRACE_BACKEND("begin_recorder %u", handle);
+    return true;
+}
+
+void dk_attach_recorder(sgl_backend_t *be, sgl_handle_t handle) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_recorder_t *r = dk_recorder_get(dk, handle);
+    s_thread_stream = r ? &r->stream : NULL;
+}
+
+/* ============================================================================
+ * Submission
+ * ============================================================================ */
+
+void dk_submit_recorders(sgl_backend_t *be, const sgl_handle_t *handles, int count) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+
+    if (dkQueueIsInErrorState(dk->queue)) {
+        SGL_ERROR_BACKEND("submit_recorders: GPU queue in ERROR STATE — skipping");
+        return;
+    }
+
+    /* Recorders skip hazard tracking: order everything before them, then after */
+    const uint32_t invalidate = DkInvalidateFlags_Image | DkInvalidateFlags_Descriptors |
+                                DkInvalidateFlags_L2Cache;
+    dk_barrier(dk, DkBarrier_Full, invalidate);
+    if (!dk->cmdbuf_submitted) {
+        dk_queue_submit(dk, dkCmdBufFinishList(dk->main_stream.cmdbuf));
+    }
+
+    for (int i = 0; i < count; i++) {
+        dk_recorder_t *r = dk_recorder_get(dk, handles[i]);
+        if (!r || !r->pending) continue;
+
+        dkCmdBufSignalFence(r->stream.cmdbuf, &r->fence, false);
+        dk_queue_submit(dk, dkCmdBufFinishList(r->stream.cmdbuf));
+        r->fence_active = true;
+        r->pending = false;
+
+        /* The recorded work counts towards the frame submitting it */
+        dk_frame_stats_add(&dk->main_stream.stats, &r->stream.stats);
+        memset(&r->stream.stats, 0, sizeof(r->stream.stats));
+    }
+
+    /* The recorders left their own state on the queue; re-emit ours */
+    dk->main_stream.descriptors_bound = false;
+    dk->main_stream.state_generation = dk_next_generation(dk);
+    dk_texture_reset_residency(&dk->main_stream);
+    dk_rebind_render_target(dk);
+    dk_barrier(dk, DkBarrier_Full, invalidate);
+
+    SGL_TRACE_BACKEND("submit_recorders count=%d", count);
+}
+
+/* ============================================================================
+ * Command Lists
+ * ============================================================================ */
+
+static dk_cmdlist_t *dk_cmdlist_get(dk_backend_data_t *dk, sgl_handle_t handle) {
+    dk_cmdlist_t **slot = handle ? (dk_cmdlist_t **)sgl_table_get(&dk->cmdlists, handle) : NULL;
+    return slot ? *slot : NULL;
+}
+
+static void dk_cmdlist_destroy(dk_backend_data_t *dk, dk_cmdlist_t *l) {
+    if (l->stream.cmdbuf) dkCmdBufDestroy(l->stream.cmdbuf);
+    dk_cmd_pool_shutdown(&l->cmd_pool);
+    dk_uniform_shutdown(&l->stream);
+    for (uint32_t i = 0; i < l->client_chunk_count; i++) {
+        dk_heap_free(&dk->buffer_heap, l->client_chunks[i].offset, l->client_chunks[i].size);
+    }
+    free(l);
+}
+
+/* Wait until the GPU is done with the list's last replay */
+static void dk_cmdlist_wait(sgl_backend_t *be, dk_backend_data_t *dk, dk_cmdlist_t *l) {
+    if (!l->called) return;
+    if (dk->submit_serial == l->call_submit) {
+        dk_finish(be);  /* Still in the main cmdbuf: submit it and wait for idle */
+    } else if (dk->idle_serial <= l->call_submit && dk->slot_frame[l->call_slot] == l->call_frame) {
+        dkFenceWait(&dk->fences[l->call_slot], -1);
+    }
+    l->called = false;
+}
+
+bool dk_cmdlist_client_chain(dk_backend_data_t *dk, dk_stream_t *s, uint32_t size) {
+    dk_cmdlist_t *l = s->cmdlist;
+    if (l->client_chunk_count >= DK_MAX_CMDLIST_CLIENT_CHUNKS) return false;
+
+    uint32_t chunk_size = SGL_ALIGN_UP(size > DK_CMDLIST_CLIENT_CHUNK ? size : DK_CMDLIST_CLIENT_CHUNK,
+                                       SGL_UNIFORM_ALIGNMENT);
+    uint32_t offset;
+    sgl_lock(&dk->share_lock);  /* Upload threads allocate from the same heap */
+    bool allocated = dk_heap_alloc(&dk->buffer_heap, chunk_size, SGL_UNIFORM_ALIGNMENT, &offset);
+    sgl_unlock(&dk->share_lock);
+    if (!allocated) {
+        return false;
+    }
+
+    l->client_chunks[l->client_chunk_count].offset = offset;
+    l->client_chunks[l->client_chunk_count].size = chunk_size;
+    l->client_chunk_count++;
+
+    s->client_array_base = offset;
+    s->client_array_offset = 0;
+    s->client_array_slot_end = chunk_size;
+    s->stats.client_array_chunks++;
+    return true;
+}
+
+sgl_handle_t dk_begin_cmdlist(sgl_backend_t *be) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+
+    if (s_thread_stream) {
+        SGL_ERROR_BACKEND("begin_cmdlist: the calling thread is already recording elsewhere");
+        return 0;
+    }
+
+    dk_cmdlist_t *l = (dk_cmdlist_t *)calloc(1, sizeof(dk_cmdlist_t));
+    uint32_t handle = l ? sgl_table_alloc(&dk->cmdlists) : 0;
+    if (handle == 0) {
+        SGL_ERROR_BACKEND("begin_cmdlist: out of memory");
+        free(l);
+        return 0;
+    }
+
+    dk_stream_t *s = &l->stream;
+    s->is_recorder = true;
+    s->cmdlist = l;
+
+    /* No memory up front: the pool's first chunk is small and later ones double */
+    DkCmdBufMaker cmdMaker;
+    dkCmdBufMakerDefaults(&cmdMaker, dk->device);
+    dk_cmd_pool_init(dk, &l->cmd_pool, (int)handle, &cmdMaker);
+    l->cmd_pool.chunk_min = DK_CMDLIST_CHUNK_SIZE;
+    s->cmdbuf = dkCmdBufCreate(&cmdMaker);
+    if (!s->cmdbuf) {
+        SGL_ERROR_BACKEND("begin_cmdlist: failed to create command buffer");
+        dk_cmdlist_destroy(dk, l);
+        sgl_table_release(&dk->cmdlists, handle);
+        return 0;
+    }
+
+    /* The descriptor heap may be reallocated before a replay; the list
+     * samples through whatever sets the main cmdbuf binds at the call */
+    s->descriptors_bound = true;
+    s->state_generation = dk_next_generation(dk);
+    dk_texture_reset_residency(s);
+
+    *(dk_cmdlist_t **)sgl_table_get(&dk->cmdlists, handle) = l;
+    s_thread_stream = s;
+
+    SGL_TRACE_BACKEND("begin_cmdlist -> %u", handle);
+    return (sgl_handle_t)handle;
+}
+
+bool dk_end_cmdlist(sgl_backend_t *be, sgl_handle_t handle) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_cmdlist_t *l = dk_cmdlist_get(dk, handle);
+    if (!l || s_thread_stream != &l->stream) return false;
+
+    l->list = dkCmdBufFinishList(l->stream.cmdbuf);
+    s_thread_stream = NULL;
+
+    SGL_TRACE_BACKEND("end_cmdlist %u: %u command bytes in %u chunks, %u uniform blocks, %u client chunks",
+                      handle, l->cmd_pool.in_use_bytes, l->cmd_pool.in_use,
+                      l->stream.uniform_num_blocks, l->client_chunk_count);
+    return l->list != 0;
+}
+
+void dk_call_cmdlist(sgl_backend_t *be, sgl_handle_t handle) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_cmdlist_t *l = dk_cmdlist_get(dk, handle);
+    if (!l || !l->list) return;
+
+    if (dkQueueIsInErrorState(dk->queue)) {
+        SGL_ERROR_BACKEND("call_cmdlist: GPU queue in ERROR STATE — skipping");
+        return;
+    }
+
+    dk_stream_t *s = &dk->main_stream;
+    const uint32_t invalidate = DkInvalidateFlags_Image | DkInvalidateFlags_Descriptors |
+                                DkInvalidateFlags_L2Cache;
+    dk_barrier(dk, DkBarrier_Full, invalidate);
+    dkCmdBufBindImageDescriptorSet(s->cmdbuf, dk->image_descriptor_addr, dk->image_descriptor_capacity);
+    dkCmdBufBindSamplerDescriptorSet(s->cmdbuf, dk->sampler_descriptor_addr, DK_SAMPLER_CACHE_SIZE);
+    s->descriptors_bound = true;
+    s->descriptor_capacity = dk->image_descriptor_capacity;
+
+    dkCmdBufCallList(s->cmdbuf, l->list);
+    l->called = true;
+    l->call_submit = dk->submit_serial;
+    l->call_slot = dk->current_slot;
+    l->call_frame = dk->slot_frame[dk->current_slot];
+
+    /* Every replay counts towards the frame calling it */
+    dk_frame_stats_add(&s->stats, &l->stream.stats);
+
+    /* The list left its own state in the cmdbuf; re-emit ours */
+    s->state_generation = dk_next_generation(dk);
+    dk_texture_reset_residency(s);
+    dk_rebind_render_target(dk);
+    dk_barrier(dk, DkBarrier_Full, invalidate);
+
+    SGL_TRACE_BACKEND("call_cmdlist %u", handle);
+}
+
+void dk_delete_cmdlist(sgl_backend_t *be, sgl_handle_t handle) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_cmdlist_t *l = dk_cmdlist_get(dk, handle);
+    if (!l) return;
+
+    if (s_thread_stream == &l->stream) s_thread_stream = NULL;
+    dk_cmdlist_wait(be, dk, l);
+    dk_cmdlist_destroy(dk, l);
+    *(dk_cmdlist_t **)sgl_table_get(&dk->cmdlists, handle) = NULL;
+    sgl_table_release(&dk->cmdlists, handle);
+
+    SGL_TRACE_BACKEND("delete_cmdlist %u", handle);
+}
@@ -0,0 +1,262 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * deko3d Backend - Dynamic Resolution
+ *
+ * With a render size below the surface size, the default framebuffer is an
+ * internal RGBA8 image of the surface size instead of the swapchain image.
+ * A frame renders into its lower-left render_width x render_height pixels
+ * (the surface depth buffer is used the same way): viewports and scissors of
+ * the default framebuffer are scaled in dk_state.c, so the application keeps
+ * working in surface coordinates. dk_end_frame blits the rectangle into the
+ * swapchain image with linear filtering, before the frame's fence.
+ *
+ * Because the image has the surface size, the render size can change every
+ * frame without reallocating anything.
+ *
+ * glReadPixels, pixel pack readbacks and glCopyTex(Sub)Image2D from the
+ * default framebuffer take surface coordinates like everything else: they
+ * read from dk_resolution_read_image, which upscales the frame so far into
+ * the slot's swapchain image first.
+ *
+ * The automatic controller times every frame with a pair of timestamp
+ * reports (dk_query.c). A slot's reports are read at its next begin_frame,
+ * when wait_fence has already waited for them, so nothing stalls; the
+ * measurement is therefore SGL_FB_NUM - 1 frames old. GPU time is taken to
+ * grow with the pixel count, so the scale moves half way towards
+ * scale * sqrt(target / measured) each frame. Render sizes are rounded to
+ * DK_RESOLUTION_ALIGN pixels, which keeps small fluctuations from changing
+ * the size every frame.
+ */
+
+#include "dk_internal.h"
+#include <math.h>
+
+/* ============================================================================
+ * Internal Render Target
+ * ============================================================================ */
+
+static void dk_resolution_free_image(dk_backend_data_t *dk) {
+    dk_resolution_t *res = &dk->resolution;
+    if (!res->memblock) return;
+
+    /* Frames in flight may still render into it or blit from it */
+    dk_wait_idle(dk);
+    dkMemBlockDestroy(res->memblock);
+    res->memblock = NULL;
+    res->image_width = 0;
+    res->image_height = 0;
+}
+
+static bool dk_resolution_make_image(dk_backend_data_t *dk) {
+    dk_resolution_t *res = &dk->resolution;
+    if (res->memblock && res->image_width == dk->fb_width && res->image_height == dk->fb_height) {
+        return true;
+    }
+    dk_resolution_free_image(dk);
+
+    DkImageLayoutMaker layoutMaker;
+    dkImageLayoutMakerDefaults(&layoutMaker, dk->device);
+    layoutMaker.flags = DkImageFlags_UsageRender | DkImageFlags_Usage2DEngine | DkImageFlags_HwCompression;
+    layoutMaker.format = DkImageFormat_RGBA8_Unorm;
+    layoutMaker.dimensions[0] = dk->fb_width;
+    layoutMaker.dimensions[1] = dk->fb_height;
+
+    DkImageLayout layout;
+    dkImageLayoutInitialize(&layout, &layoutMaker);
+
+    DkMemBlockMaker memMaker;
+    dkMemBlockMakerDefaults(&memMaker, dk->device,
+                            SGL_ALIGN_UP(dkImageLayoutGetSize(&layout), dkImageLayoutGetAlignment(&layout)));
+    memMaker.flags = DkMemBlockFlags_GpuCached | DkMemBlockFlags_Image;
+    res->memblock = dkMemBlockCreate(&memMaker);
+    if (!res->memblock) {
+        SGL_ERROR_BACKEND("resolution: failed to allocate the %ux%u render target",
+                          dk->fb_width, dk->fb_height);
+        return false;
+    }
+
+    dkImageInitialize(&res->image, &layout, res->memblock, 0);
+    res->image_width = dk->fb_width;
+    res->image_height = dk->fb_height;
+    return true;
+}
+
+void dk_resolution_shutdown(dk_backend_data_t *dk) {
+    if (dk->resolution.memblock) {
+        dkMemBlockDestroy(dk->resolution.memblock);
+        dk->resolution.memblock = NULL;
+    }
+}
+
+/* ============================================================================
+ * Controller
+ * ============================================================================ */
+
+static void dk_resolution_update_scale(dk_resolution_t *res, float rendered_scale, uint64_t gpu_ns) {
+    float ideal = rendered_scale * sqrtf((float)res->target_ns / (float)gpu_ns);
+    float scale = res->scale + (ideal - res->scale) * 0.5f;
+
+    if (scale < res->min_scale) scale = res->min_scale;
+    if (scale > 1.0f) scale = 1.0f;
+    res->scale = scale;
+}
+
+static uint32_t dk_resolution_scaled(uint32_t size, float scale) {
+    uint32_t scaled = (uint32_t)((float)size * scale) & ~(uint32_t)(DK_RESOLUTION_ALIGN - 1);
+    if (scaled < DK_RESOLUTION_ALIGN) scaled = DK_RESOLUTION_ALIGN;
+    return scaled < size ? scaled : size;
+}
+
+/* ============================================================================
+ * Frame Hooks
+ * ============================================================================ */
+
+void dk_resolution_begin_frame(dk_backend_data_t *dk, int slot) {
+    dk_resolution_t *res = &dk->resolution;
+    uint32_t width = dk->fb_width;
+    uint32_t height = dk->fb_height;
+
+    if (res->target_ns) {
+        /* wait_fence has waited for the slot's previous frame */
+        if (res->slot_timed[slot]) {
+            uint64_t gpu_ns = dk_query_frame_time(dk, slot);
+            if (gpu_ns) dk_resolution_update_scale(res, res->slot_scale[slot], gpu_ns);
+        }
+        width = dk_resolution_scaled(width, res->scale);
+        height = dk_resolution_scaled(height, res->scale);
+    } else if (res->width) {
+        if (res->width < width) width = res->width;
+        if (res->height < height) height = res->height;
+    }
+
+    res->active = dk->framebuffers && (width < dk->fb_width || height < dk->fb_height);
+    if (res->active && !dk_resolution_make_image(dk)) {
+        res->active = false;
+    }
+    if (!res->active) {
+        width = dk->fb_width;
+        height = dk->fb_height;
+        if (!res->target_ns && !res->width) dk_resolution_free_image(dk);
+    }
+    res->render_width = width;
+    res->render_height = height;
+
+    res->slot_timed[slot] = false;
+    res->slot_scale[slot] = res->scale;
+    res->timing = res->target_ns && dk_query_frame_begin(dk, slot);
+}
+
+void dk_resolution_end_frame(dk_backend_data_t *dk, int slot) {
+    dk_resolution_t *res = &dk->resolution;
+    DkCmdBuf cmdbuf = dk->main_stream.cmdbuf;
+
+    if (res->active && dk->framebuffers) {
+        /* The 2D engine reads what the 3D engine rendered */
+        dk_barrier(dk, DkBarrier_Full, DkInvalidateFlags_Image);
+
+        DkImageView srcView, dstView;
+        dkImageViewDefaults(&srcView, &res->image);
+        dkImageViewDefaults(&dstView, &dk->framebuffers[slot]);
+
+        /* GL rows [0, render_height) are the bottom rows of the image */
+        DkImageRect srcRect = { 0, res->image_height - res->render_height, 0,
+                                res->render_width, res->render_height, 1 };
+        DkImageRect dstRect = { 0, 0, 0, dk->fb_width, dk->fb_height, 1 };
+        dkCmdBufBlitImage(cmdbuf, &srcView, &srcRect, &dstView, &dstRect, DkBlitFlag_FilterLinear, 0);
+
+        /* The next frame renders into the same image */
+        dk_barrier(dk, DkBarrier_Full, 0);
+    }
+
+    if (res->timing) {
+        dk_query_frame_end(dk, slot);
+        res->slot_timed[slot] = true;
+        res->timing = false;
+    }
+}
+
+const DkImage *dk_resolution_read_image(dk_backend_data_t *dk) {
+    dk_resolution_t *res = &dk->resolution;
+    if (!res->active || !dk->framebuffers) return dk_default_color_image(dk);
+
+    /* The slot's swapchain image is unused until end_frame overwrites it
+     * with the final upscale, so it can hold a surface-sized copy of the
+     * frame so far. Reads then work in surface coordinates. */
+    dk_barrier(dk, DkBarrier_Full, DkInvalidateFlags_Image);
+
+    DkImage *surface = &dk->framebuffers[dk->current_slot];
+    DkImageView srcView, dstView;
+    dkImageViewDefaults(&srcView, &res->image);
+    dkImageViewDefaults(&dstView, surface);
+
+    DkImageRect srcRect = { 0, res->image_height - res->render_height, 0,
+                            res->render_width, res->render_height, 1 };
+    DkImageRect dstRect = { 0, 0, 0, dk->fb_width, dk->fb_height, 1 };
+    dkCmdBufBlitImage(dk->main_stream.cmdbuf, &srcView, &srcRect, &dstView, &dstRect,
+                      DkBlitFlag_FilterLinear, 0);
+
+    /* The read that follows comes from another engine */
+    dk_barrier(dk, DkBarrier_Full, DkInvalidateFlags_Image);
+    return surface;
+}
+
+void dk_resolution_scale(const dk_backend_data_t *dk, float *sx, float *sy) {
+    const dk_resolution_t *res = &dk->resolution;
+    if (!res->active) {
+        *sx = 1.0f;
+        *sy = 1.0f;
+        return;
+    }
+    *sx = (float)res->render_width / (float)dk->fb_width;
+    *sy = (float)res->render_height / (float)dk->fb_height;
+}
+
+void dk_resolution_scale_rect(const dk_backend_data_t *dk, float *x, float *y, float *w, float *h) {
+    if (!dk->resolution.active || dk->current_fbo != 0) return;
+
+    float sx, sy;
+    dk_resolution_scale(dk, &sx, &sy);
+    *x *= sx;
+    *w *= sx;
+    *y *= sy;
+    *h *= sy;
+}
+
+/* ============================================================================
+ * Configuration (sglSetRenderResolution / sglSetDynamicResolution)
+ * ============================================================================ */
+
+void dk_set_render_resolution(sgl_backend_t *be, GLsizei width, GLsizei height) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_resolution_t *res = &dk->resolution;
+
+    res->width = (uint32_t)width;
+    res->height = (uint32_t)height;
+    res->target_ns = 0;
+
+    SGL_TRACE_BACKEND("set_render_resolution %dx%d", width, height);
+}
+
+void dk_set_dynamic_resolution(sgl_backend_t *be, uint64_t target_ns, float min_scale) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_resolution_t *res = &dk->resolution;
+
+    /* Start from full resolution; the first measurements pull it down */
+    if (target_ns && !res->target_ns) {
+        res->scale = 1.0f;
+        memset(res->slot_timed, 0, sizeof(res->slot_timed));
+    }
+    res->target_ns = target_ns;
+    res->min_scale = min_scale;
+
+    SGL_TRACE_BACKEND("set_dynamic_resolution target=%lluns min_scale=%.2f",
+                      (unsigned long long)target_ns, min_scale);
+}
+
+void dk_get_render_resolution(sgl_backend_t *be, GLsizei *width, GLsizei *height) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    const dk_resolution_t *res = &dk->resolution;
+
+    *width = (GLsizei)(res->render_width ? res->render_width : dk->fb_width);
+    *height = (GLsizei)(res->render_height ? res->render_height : dk->fb_height);
+}
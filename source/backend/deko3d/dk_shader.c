@@ -5,6 +5,7 @@
  * This module handles:
  * - Shader loading from .dksh files
  * - Program linking (copies shaders to per-program storage)
+ * - Program binaries (GL_OES_get_program_binary)
  * - Program binding for rendering
  *
  * Shader storage strategy:
@@ -12,6 +13,8 @@
  * - At link time, shaders are COPIED to per-program storage
  * - This allows independent program binding without shared shader state
  * - Original shaders can be deleted after linking
+ * - The DKSH code itself is shared: identical binaries use one refcounted
+ *   copy in code_heap, freed when the last shader or program drops it
  *
  * Uniform binding:
  * - Uses pushConstants to capture uniform data at draw time
@@ -21,75 +24,128 @@
 #include "dk_internal.h"
 
 /* ============================================================================
- * Shader Loading
+ * Shader Code Heap
  *
- * Loads a pre-compiled .dksh shader file into GPU code memory.
- * The shader code is stored at the handle index for later linking.
+ * DKSH code lives in code_heap ranges aligned to SGL_CODE_ALIGNMENT. Each
+ * range is a blob refcounted by the shader and program records using it:
+ * loading code that is byte-identical to a live blob (a fullscreen vertex
+ * shader shared by many programs, a hot-reloaded shader that did not change)
+ * takes another reference instead of a copy. When the last reference goes,
+ * the range is freed past the current slot's fence, since frames in flight
+ * may still run the code.
  * ============================================================================ */
 
-bool dk_load_shader_file(sgl_backend_t *be, sgl_handle_t handle, const char *path) {
-    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
-
-    /* Validate handle */
-    if (handle == 0 || handle >= SGL_MAX_SHADERS) {
-        SGL_ERROR_BACKEND("Invalid shader handle: %u", handle);
-        return false;
+static uint32_t dk_code_hash(const void *data, size_t size) {
+    const uint8_t *p = (const uint8_t *)data;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ p[i]) * 16777619u;
     }
+    return hash;
+}
 
-    FILE *f = fopen(path, "rb");
-    if (!f) {
-        SGL_ERROR_BACKEND("Failed to open shader: %s", path);
-        return false;
+static dk_code_blob_t *dk_code_blob_at(dk_backend_data_t *dk, uint32_t offset) {
+    for (int i = 0; i < DK_MAX_CODE_BLOBS; i++) {
+        dk_code_blob_t *blob = &dk->code_blobs[i];
+        if (blob->refs > 0 && blob->offset == offset) return blob;
     }
+    return NULL;
+}
 
-    fseek(f, 0, SEEK_END);
-    long size = ftell(f);
-    fseek(f, 0, SEEK_SET);
+static void dk_code_retain(dk_backend_data_t *dk, uint32_t offset) {
+    dk_code_blob_t *blob = dk_code_blob_at(dk, offset);
+    if (blob) blob->refs++;
+}
 
-    if (size <= 0 || (uint32_t)size > SGL_CODE_MEM_SIZE - dk->code_offset) {
-        fclose(f);
-        SGL_ERROR_BACKEND("Shader too large: %s", path);
+static void dk_code_release(dk_backend_data_t *dk, uint32_t offset) {
+    dk_code_blob_t *blob = dk_code_blob_at(dk, offset);
+    if (!blob || --blob->refs > 0) return;
+
+    dk_defer_free(dk, &dk->code_heap, blob->offset, SGL_ALIGN_UP(blob->size, SGL_CODE_ALIGNMENT));
+    SGL_TRACE_SHADER("code blob at offset=%u (%u bytes) released", blob->offset, blob->size);
+}
+
+/* Initialize a DkShader on the code at a code_heap offset */
+static void dk_init_shader_at(dk_backend_data_t *dk, DkShader *shader, uint32_t offset) {
+    const dk_heap_block_t *block = dk_heap_block(&dk->code_heap, offset);
+    DkShaderMaker shaderMaker;
+    dkShaderMakerDefaults(&shaderMaker, block->memblock, offset - block->base);
+    dkShaderInitialize(shader, &shaderMaker);
+}
+
+/*
+ * Find or copy DKSH code into code_heap and initialize a DkShader on it.
+ * On success the caller holds a reference to the blob at *out_offset; an
+ * invalid shader gives its space back.
+ */
+static bool dk_load_code(dk_backend_data_t *dk, const void *data, size_t size,
+                         DkShader *shader, uint32_t *out_offset) {
+    if (!data || size == 0 || size > SGL_CODE_MEM_SIZE) {
+        SGL_ERROR_BACKEND("Invalid shader binary data");
         return false;
     }
 
-    /* Align code offset to 256 bytes */
-    uint32_t aligned_offset = SGL_ALIGN_UP(dk->code_offset, SGL_CODE_ALIGNMENT);
-    uint8_t *code_ptr = (uint8_t*)dkMemBlockGetCpuAddr(dk->code_memblock) + aligned_offset;
+    uint32_t hash = dk_code_hash(data, size);
+    dk_code_blob_t *free_entry = NULL;
+    for (int i = 0; i < DK_MAX_CODE_BLOBS; i++) {
+        dk_code_blob_t *blob = &dk->code_blobs[i];
+        if (blob->refs == 0) {
+            if (!free_entry) free_entry = blob;
+            continue;
+        }
+        if (blob->hash == hash && blob->size == size &&
+            memcmp(dk_heap_cpu_addr(&dk->code_heap, blob->offset), data, size) == 0) {
+            dk_init_shader_at(dk, shader, blob->offset);
+            blob->refs++;
+            *out_offset = blob->offset;
+            return true;
+        }
+    }
+    if (!free_entry) {
+        SGL_ERROR_BACKEND("Too many distinct shader binaries (%d)", DK_MAX_CODE_BLOBS);
+        return false;
+    }
 
-    if (fread(code_ptr, 1, size, f) != (size_t)size) {
-        fclose(f);
-        SGL_ERROR_BACKEND("Failed to read shader: %s", path);
+    /* Align size to 256 bytes (DK_SHADER_CODE_ALIGNMENT) */
+    uint32_t aligned_size = (uint32_t)SGL_ALIGN_UP(size, SGL_CODE_ALIGNMENT);
+    uint32_t offset;
+    if (!dk_heap_alloc(&dk->code_heap, aligned_size, SGL_CODE_ALIGNMENT, &offset)) {
+        SGL_ERROR_BACKEND("Out of shader code memory: %zu bytes", size);
         return false;
     }
-    fclose(f);
+    uint8_t *code_ptr = dk_heap_cpu_addr(&dk->code_heap, offset);
 
-    DkGpuAddr code_addr = dkMemBlockGetGpuAddr(dk->code_memblock) + aligned_offset;
+    /* Zero the aligned region first, then copy DKSH data.
+     * This matches the pure deko3d libuam test pattern (memset before write).
+     * Critical: dkShaderInitialize may read up to the aligned boundary,
+     * and libuam doesn't zero DKSH internal padding. */
+    memset(code_ptr, 0, aligned_size);
+    memcpy(code_ptr, data, size);
 
-    /* Initialize shader at the handle index */
-    DkShaderMaker shaderMaker;
-    dkShaderMakerDefaults(&shaderMaker, dk->code_memblock, aligned_offset);
-    dkShaderInitialize(&dk->dk_shaders[handle], &shaderMaker);
+    dk_init_shader_at(dk, shader, offset);
 
     /* Validate shader — prevents GPU crash from invalid DKSH data */
-    if (!dkShaderIsValid(&dk->dk_shaders[handle])) {
-        SGL_ERROR_BACKEND("load_shader_file: shader %u INVALID (path=%s)", handle, path);
-        dk->shader_loaded[handle] = false;
+    if (!dkShaderIsValid(shader)) {
+        SGL_ERROR_BACKEND("load_shader_binary: INVALID after init (size=%zu at offset=%u)",
+                          size, offset);
+        /* Never bound, so the space can be reused right away */
+        dk_heap_free(&dk->code_heap, offset, aligned_size);
         return false;
     }
 
-    dk->shader_loaded[handle] = true;
-    dk->code_offset = aligned_offset + SGL_ALIGN_UP(size, SGL_CODE_ALIGNMENT);
-
-    SGL_TRACE_SHADER("load_shader_file: handle=%u path=%s at 0x%lx (valid)",
-                     handle, path, (unsigned long)code_addr);
+    free_entry->hash = hash;
+    free_entry->offset = offset;
+    free_entry->size = (uint32_t)size;
+    free_entry->refs = 1;
+    *out_offset = offset;
     return true;
 }
 
 /* ============================================================================
- * Shader Binary Loading
+ * Shader Loading
  *
- * Loads a pre-compiled .dksh shader from a memory buffer into GPU code memory.
- * Same logic as dk_load_shader_file but reads from data/size instead of file.
+ * Loads pre-compiled .dksh code from a file or memory into the shader
+ * record at the handle index, replacing (and releasing) any code it held.
  * ============================================================================ */
 
 bool dk_load_shader_binary(sgl_backend_t *be, sgl_handle_t handle,
@@ -97,102 +153,206 @@ bool dk_load_shader_binary(sgl_backend_t *be, sgl_handle_t handle,
     dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
 
     /* Validate handle */
-    if (handle == 0 || handle >= SGL_MAX_SHADERS) {
+    dk_shader_record_t *sh = handle ? (dk_shader_record_t *)sgl_table_ensure(&dk->shaders, handle) : NULL;
+    if (!sh) {
         SGL_ERROR_BACKEND("Invalid shader handle: %u", handle);
         return false;
     }
 
-    if (!data || size == 0) {
-        SGL_ERROR_BACKEND("Invalid shader binary data");
-        return false;
+    if (sh->loaded) {
+        dk_code_release(dk, sh->code_offset);
+        sh->loaded = false;
     }
 
-    if ((uint32_t)size > SGL_CODE_MEM_SIZE - dk->code_offset) {
-        SGL_ERROR_BACKEND("Shader binary too large: %zu bytes", size);
+    uint32_t offset;
+    if (!dk_load_code(dk, data, size, &sh->shader, &offset)) {
         return false;
     }
 
-    /* Align code offset and size to 256 bytes (DK_SHADER_CODE_ALIGNMENT) */
-    uint32_t aligned_offset = SGL_ALIGN_UP(dk->code_offset, SGL_CODE_ALIGNMENT);
-    uint32_t aligned_size = (uint32_t)SGL_ALIGN_UP(size, SGL_CODE_ALIGNMENT);
-    uint8_t *code_ptr = (uint8_t*)dkMemBlockGetCpuAddr(dk->code_memblock) + aligned_offset;
+    sh->loaded = true;
+    sh->code_offset = offset;
+    sh->code_size = (uint32_t)size;
 
-    /* Zero the aligned region first, then copy DKSH data.
-     * This matches the pure deko3d libuam test pattern (memset before write).
-     * Critical: dkShaderInitialize may read up to the aligned boundary,
-     * and libuam doesn't zero DKSH internal padding. */
-    memset(code_ptr, 0, aligned_size);
-    memcpy(code_ptr, data, size);
+    SGL_TRACE_SHADER("load_shader_binary: handle=%u size=%zu at offset=%u (valid)",
+                     handle, size, offset);
+    return true;
+}
 
-    /* Initialize shader at the handle index */
-    DkShaderMaker shaderMaker;
-    dkShaderMakerDefaults(&shaderMaker, dk->code_memblock, aligned_offset);
-    dkShaderInitialize(&dk->dk_shaders[handle], &shaderMaker);
+bool dk_load_shader_file(sgl_backend_t *be, sgl_handle_t handle, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        SGL_ERROR_BACKEND("Failed to open shader: %s", path);
+        return false;
+    }
 
-    /* Validate shader — prevents GPU crash from invalid DKSH data */
-    if (!dkShaderIsValid(&dk->dk_shaders[handle])) {
-        SGL_ERROR_BACKEND("load_shader_binary: shader %u INVALID after init (size=%zu at offset=%u)",
-                          handle, size, aligned_offset);
-        dk->shader_loaded[handle] = false;
-        /* Don't advance code_offset — reclaim the space */
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    if (size <= 0 || (unsigned long)size > SGL_CODE_MEM_SIZE) {
+        fclose(f);
+        SGL_ERROR_BACKEND("Shader too large: %s", path);
+        return false;
+    }
+
+    void *data = malloc((size_t)size);
+    if (!data || fread(data, 1, (size_t)size, f) != (size_t)size) {
+        free(data);
+        fclose(f);
+        SGL_ERROR_BACKEND("Failed to read shader: %s", path);
         return false;
     }
+    fclose(f);
 
-    dk->shader_loaded[handle] = true;
-    dk->code_offset = aligned_offset + aligned_size;
+    bool ok = dk_load_shader_binary(be, handle, data, (size_t)size);
+    free(data);
 
-    SGL_TRACE_SHADER("load_shader_binary: handle=%u size=%zu at offset=%u (valid)",
-                     handle, size, aligned_offset);
-    return true;
+    SGL_TRACE_SHADER("load_shader_file: handle=%u path=%s (%s)", handle, path, ok ? "valid" : "INVALID");
+    return ok;
+}
+
+void dk_delete_shader(sgl_backend_t *be, sgl_handle_t handle) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+
+    dk_shader_record_t *sh = (dk_shader_record_t *)sgl_table_get(&dk->shaders, handle);
+    if (handle == 0 || !sh || !sh->loaded) return;
+
+    /* Programs linked from it keep their own references */
+    dk_code_release(dk, sh->code_offset);
+    sh->loaded = false;
+
+    SGL_TRACE_SHADER("delete_shader handle=%u", handle);
 }
 
 /* ============================================================================
  * Program Linking
  *
  * Links vertex and fragment shaders into a program.
- * COPIES shader data to per-program storage for independent binding.
+ * COPIES shader data to per-program storage for independent binding; the
+ * program takes its own reference to each stage's code.
  * ============================================================================ */
 
+/* A (re)linked program has new shaders and no valid packed UBO copies */
+static void dk_forget_program(dk_backend_data_t *dk, sgl_handle_t program, dk_program_t *prog) {
+    memset(prog->packed_ubo_size, 0, sizeof(prog->packed_ubo_size));
+    if (dk->main_stream.bound_program == program) dk->main_stream.bound_program = 0;
+    for (int stage = 0; stage < 2; stage++) {
+        if (prog->shader_valid[stage]) dk_code_release(dk, prog->code_offset[stage]);
+        prog->shader_valid[stage] = false;
+    }
+}
+
 bool dk_link_program(sgl_backend_t *be, sgl_handle_t program,
                      sgl_handle_t vertex_shader, sgl_handle_t fragment_shader) {
     dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
 
     /* Validate handles */
-    if (program == 0 || program >= SGL_MAX_PROGRAMS) {
+    dk_program_t *prog = program ? (dk_program_t *)sgl_table_ensure(&dk->programs, program) : NULL;
+    if (!prog) {
         SGL_ERROR_BACKEND("Invalid program handle: %u", program);
         return false;
     }
 
     /* Initialize program shader slots as invalid */
-    dk->program_shader_valid[program][0] = false;
-    dk->program_shader_valid[program][1] = false;
+    dk_forget_program(dk, program, prog);
 
     /* Copy vertex shader to program storage */
-    if (vertex_shader > 0 && vertex_shader < SGL_MAX_SHADERS && dk->shader_loaded[vertex_shader]) {
+    const dk_shader_record_t *vs = dk_shader_record(dk, vertex_shader);
+    if (vertex_shader > 0 && vs->loaded) {
         /* Copy the entire DkShader structure */
-        memcpy(&dk->program_shaders[program][0], &dk->dk_shaders[vertex_shader], sizeof(DkShader));
-        dk->program_shader_valid[program][0] = true;
+        memcpy(&prog->shaders[0], &vs->shader, sizeof(DkShader));
+        prog->shader_valid[0] = true;
+        prog->code_offset[0] = vs->code_offset;
+        prog->code_size[0] = vs->code_size;
+        dk_code_retain(dk, vs->code_offset);
     }
 
     /* Copy fragment shader to program storage */
-    if (fragment_shader > 0 && fragment_shader < SGL_MAX_SHADERS && dk->shader_loaded[fragment_shader]) {
+    const dk_shader_record_t *fs = dk_shader_record(dk, fragment_shader);
+    if (fragment_shader > 0 && fs->loaded) {
         /* Copy the entire DkShader structure */
-        memcpy(&dk->program_shaders[program][1], &dk->dk_shaders[fragment_shader], sizeof(DkShader));
-        dk->program_shader_valid[program][1] = true;
+        memcpy(&prog->shaders[1], &fs->shader, sizeof(DkShader));
+        prog->shader_valid[1] = true;
+        prog->code_offset[1] = fs->code_offset;
+        prog->code_size[1] = fs->code_size;
+        dk_code_retain(dk, fs->code_offset);
     }
 
     SGL_TRACE_SHADER("link_program prog=%u vs=%u(%s) fs=%u(%s)", program,
-                     vertex_shader, dk->program_shader_valid[program][0] ? "ok" : "MISSING",
-                     fragment_shader, dk->program_shader_valid[program][1] ? "ok" : "MISSING");
+                     vertex_shader, prog->shader_valid[0] ? "ok" : "MISSING",
+                     fragment_shader, prog->shader_valid[1] ? "ok" : "MISSING");
 
     /* Both VS and FS required for a valid graphics program */
-    if (!dk->program_shader_valid[program][0] || !dk->program_shader_valid[program][1]) {
+    if (!prog->shader_valid[0] || !prog->shader_valid[1]) {
         SGL_ERROR_BACKEND("link_program: prog %u missing shaders (vs=%d fs=%d)",
                           program,
-                          dk->program_shader_valid[program][0],
-                          dk->program_shader_valid[program][1]);
+                          prog->shader_valid[0],
+                          prog->shader_valid[1]);
+        return false;
+    }
+    return true;
+}
+
+void dk_delete_program(sgl_backend_t *be, sgl_handle_t handle) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+
+    dk_program_t *prog = (dk_program_t *)sgl_table_get(&dk->programs, handle);
+    if (handle == 0 || !prog) return;
+    dk_forget_program(dk, handle, prog);
+
+    SGL_TRACE_SHADER("delete_program handle=%u", handle);
+}
+
+/* ============================================================================
+ * Program Binaries (GL_OES_get_program_binary)
+ *
+ * A linked program's DKSH stays in code_heap, so saving it only needs
+ * the code location captured at link. Loading writes both stages straight
+ * into the program slots; no shader objects are involved.
+ * ============================================================================ */
+
+bool dk_get_program_code(sgl_backend_t *be, sgl_handle_t program, int stage,
+                         const void **code, uint32_t *size) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+
+    if (program == 0 || stage < 0 || stage > 1) return false;
+    const dk_program_t *prog = dk_program(dk, program);
+    if (!prog->shader_valid[stage] || prog->code_size[stage] == 0) {
+        return false;
+    }
+
+    *code = dk_heap_cpu_addr(&dk->code_heap, prog->code_offset[stage]);
+    *size = prog->code_size[stage];
+    return true;
+}
+
+bool dk_load_program_binary(sgl_backend_t *be, sgl_handle_t program,
+                            const void *vs_code, size_t vs_size,
+                            const void *fs_code, size_t fs_size) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+
+    dk_program_t *prog = program ? (dk_program_t *)sgl_table_ensure(&dk->programs, program) : NULL;
+    if (!prog) {
+        SGL_ERROR_BACKEND("Invalid program handle: %u", program);
         return false;
     }
+
+    dk_forget_program(dk, program, prog);
+
+    const void *code[2] = { vs_code, fs_code };
+    size_t size[2] = { vs_size, fs_size };
+    for (int stage = 0; stage < 2; stage++) {
+        uint32_t offset;
+        if (!dk_load_code(dk, code[stage], size[stage], &prog->shaders[stage], &offset)) {
+            dk_forget_program(dk, program, prog);
+            return false;
+        }
+        prog->shader_valid[stage] = true;
+        prog->code_offset[stage] = offset;
+        prog->code_size[stage] = (uint32_t)size[stage];
+    }
+
+    SGL_TRACE_SHADER("load_program_binary prog=%u vs=%zu fs=%zu bytes", program, vs_size, fs_size);
     return true;
 }
 
@@ -203,8 +363,85 @@ bool dk_link_program(sgl_backend_t *be, sgl_handle_t program,
  * - Binds per-program shader copies
  * - Binds uniform buffers
  * - Uses pushConstants to capture uniform data NOW (prevents race conditions)
+ *
+ * Each program's packed UBOs get one range of the uniform region per
+ * cmdbuf (uniform_offset only rewinds on a cmdbuf reset). The first bind
+ * pushes the whole shadow buffer; later binds push only the byte range the
+ * GL layer marked dirty into that same range, since pushConstants updates
+ * are ordered with the draws around them. Unchanged UBOs are just re-bound. Shader and uniform buffer bindings that are already current in
+ * the cmdbuf are skipped, so redrawing with an unchanged program records
+ * nothing here.
  * ============================================================================ */
 
+/* Forget what the cmdbuf has bound if it was reset since */
+static void dk_sync_bound_state(dk_stream_t *s) {
+    if (s->bound_state_generation == s->state_generation) return;
+    s->bound_state_generation = s->state_generation;
+    s->bound_program = 0;
+    memset(s->bound_ubo_addr, 0, sizeof(s->bound_ubo_addr));
+    memset(s->bound_ubo_size, 0, sizeof(s->bound_ubo_size));
+}
+
+static void dk_bind_ubo(dk_stream_t *s, int stage, int binding, DkGpuAddr gpu_addr, uint32_t size) {
+    if (s->bound_ubo_addr[stage][binding] == gpu_addr && s->bound_ubo_size[stage][binding] == size) {
+        return;
+    }
+    dkCmdBufBindUniformBuffer(s->cmdbuf, stage == 0 ? DkStage_Vertex : DkStage_Fragment,
+                              binding, gpu_addr, size);
+    s->bound_ubo_addr[stage][binding] = gpu_addr;
+    s->bound_ubo_size[stage][binding] = size;
+}
+
+static void dk_bind_packed_ubo(sgl_backend_t *be, sgl_handle_t program, int stage, int binding,
+                               const sgl_packed_ubo_t *packed) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_stream_t *s = dk_stream(dk);
+    const dk_program_t *prog = dk_program(dk, program);
+    uint32_t aligned = SGL_ALIGN_UP(packed->size, SGL_UNIFORM_ALIGNMENT);
+
+    /* The per-program copies are the GL thread's; recorders always push in full */
+    bool have_copy = !s->is_recorder &&
+                     prog->packed_ubo_size[stage][binding] == aligned &&
+                     prog->packed_ubo_generation[stage][binding] == s->state_generation;
+    if (have_copy) {
+        uint32_t offset = prog->packed_ubo_offset[stage][binding];
+        DkGpuAddr gpu_addr = dk_uniform_gpu_addr(dk, offset);
+        dk_bind_ubo(s, stage, binding, gpu_addr, aligned);
+        if (!packed->dirty) return;
+
+        /* Push only the bytes written since the last bind; pushConstants
+         * offsets and sizes are in words */
+        uint32_t begin = packed->dirty_begin & ~3u;
+        uint32_t end = SGL_ALIGN_UP(packed->dirty_end, 4);
+        if (end > packed->size) end = packed->size;
+        if (begin >= end) return;
+
+        uint8_t *cpu_addr = dk_uniform_cpu_addr(dk, offset);
+        memcpy(cpu_addr + begin, packed->data + begin, end - begin);
+        dkCmdBufPushConstants(s->cmdbuf, gpu_addr, aligned, begin, end - begin, cpu_addr + begin);
+        s->stats.uniform_bytes += end - begin;
+        return;
+    }
+
+    /* First bind in this cmdbuf (or resized): full copy into a fresh range */
+    uint32_t offset = dk_alloc_uniform(be, aligned);
+
+    /* Copy shadow buffer to CPU-visible GPU memory */
+    uint8_t *cpu_addr = dk_uniform_cpu_addr(dk, offset);
+    memcpy(cpu_addr, packed->data, packed->size);
+
+    DkGpuAddr gpu_addr = dk_uniform_gpu_addr(dk, offset);
+    dk_bind_ubo(s, stage, binding, gpu_addr, aligned);
+    dkCmdBufPushConstants(s->cmdbuf, gpu_addr, aligned, 0, packed->size, cpu_addr);
+    s->stats.uniform_bytes += packed->size;
+    dk_program_t *own = s->is_recorder ? NULL : dk_program_rw(dk, program);
+    if (!own) return;
+
+    own->packed_ubo_offset[stage][binding] = offset;
+    own->packed_ubo_size[stage][binding] = aligned;
+    own->packed_ubo_generation[stage][binding] = s->state_generation;
+}
+
 void dk_bind_program(sgl_backend_t *be, sgl_handle_t program,
                      sgl_handle_t vertex_shader, sgl_handle_t fragment_shader,
                      const sgl_uniform_binding_t *vertex_uniforms,
@@ -216,46 +453,53 @@ void dk_bind_program(sgl_backend_t *be, sgl_handle_t program,
     (void)vertex_shader;  /* Not used - we use per-program shader copies */
     (void)fragment_shader;
     dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_stream_t *s = dk_stream(dk);
 
     DK_VERBOSE_PRINT("[DK] bind_program: prog=%u\n", program);
 
-    if (program == 0 || program >= SGL_MAX_PROGRAMS) {
+    if (program == 0) {
         SGL_ERROR_BACKEND("bind_program: Invalid program handle %u", program);
         return;
     }
+    const dk_program_t *prog = dk_program(dk, program);
+
+    dk_sync_bound_state(s);
 
     /* Bind shaders using per-program copies (captured at link time) */
-    DkShader const* shaders[2];
-    int numShaders = 0;
+    if (s->bound_program != program) {
+        DkShader const* shaders[2];
+        int numShaders = 0;
 
-    if (dk->program_shader_valid[program][0]) {
-        shaders[numShaders++] = &dk->program_shaders[program][0];
-    }
-    if (dk->program_shader_valid[program][1]) {
-        shaders[numShaders++] = &dk->program_shaders[program][1];
-    }
+        if (prog->shader_valid[0]) {
+            shaders[numShaders++] = &prog->shaders[0];
+        }
+        if (prog->shader_valid[1]) {
+            shaders[numShaders++] = &prog->shaders[1];
+        }
 
-    if (numShaders > 0) {
-        dkCmdBufBindShaders(dk->cmdbuf, DkStageFlag_GraphicsMask, shaders, numShaders);
+        if (numShaders > 0) {
+            dkCmdBufBindShaders(s->cmdbuf, DkStageFlag_GraphicsMask, shaders, numShaders);
+            s->unit_handle_bound_mask = 0;  /* Texture handles must be re-bound after bindShaders */
+            s->bound_program = program;
+            s->stats.shader_binds++;
+        }
     }
 
-    DkGpuAddr uniform_gpu_base = dkMemBlockGetGpuAddr(dk->data_memblock) + dk->uniform_base;
-
     /* Bind vertex stage uniforms with pushConstants */
     for (int i = 0; i < max_uniforms; i++) {
         const sgl_uniform_binding_t *ub = &vertex_uniforms[i];
         if (ub->valid && ub->size > 0) {
-            DkGpuAddr gpu_addr = uniform_gpu_base + ub->offset;
-            dkCmdBufBindUniformBuffer(dk->cmdbuf, DkStage_Vertex, i, gpu_addr, ub->size);
+            DkGpuAddr gpu_addr = dk_uniform_gpu_addr(dk, ub->offset);
+            dk_bind_ubo(s, 0, i, gpu_addr, ub->size);
 
             /* CRITICAL: pushConstants captures data NOW, not at GPU execution time
              * This prevents race conditions when multiple draws use different uniform values
              * in the same command buffer.
              * Use data_size (actual data) not size (256-byte aligned) to avoid reading garbage. */
-            uint8_t *cpu_addr = (uint8_t*)dkMemBlockGetCpuAddr(dk->data_memblock);
-            void *uniform_data = cpu_addr + dk->uniform_base + ub->offset;
+            void *uniform_data = dk_uniform_cpu_addr(dk, ub->offset);
             uint32_t push_size = ub->data_size > 0 ? ub->data_size : ub->size;
-            dkCmdBufPushConstants(dk->cmdbuf, gpu_addr, ub->size, 0, push_size, uniform_data);
+            dkCmdBufPushConstants(s->cmdbuf, gpu_addr, ub->size, 0, push_size, uniform_data);
+            s->stats.uniform_bytes += push_size;
         }
     }
 
@@ -263,56 +507,34 @@ void dk_bind_program(sgl_backend_t *be, sgl_handle_t program,
     for (int i = 0; i < max_uniforms; i++) {
         const sgl_uniform_binding_t *ub = &fragment_uniforms[i];
         if (ub->valid && ub->size > 0) {
-            DkGpuAddr gpu_addr = uniform_gpu_base + ub->offset;
-            dkCmdBufBindUniformBuffer(dk->cmdbuf, DkStage_Fragment, i, gpu_addr, ub->size);
+            DkGpuAddr gpu_addr = dk_uniform_gpu_addr(dk, ub->offset);
+            dk_bind_ubo(s, 1, i, gpu_addr, ub->size);
 
             /* CRITICAL: pushConstants captures data NOW
              * Use data_size (actual data) not size (256-byte aligned) to avoid reading garbage. */
-            uint8_t *cpu_addr = (uint8_t*)dkMemBlockGetCpuAddr(dk->data_memblock);
-            void *uniform_data = cpu_addr + dk->uniform_base + ub->offset;
+            void *uniform_data = dk_uniform_cpu_addr(dk, ub->offset);
             uint32_t push_size = ub->data_size > 0 ? ub->data_size : ub->size;
 
-            dkCmdBufPushConstants(dk->cmdbuf, gpu_addr, ub->size, 0, push_size, uniform_data);
+            dkCmdBufPushConstants(s->cmdbuf, gpu_addr, ub->size, 0, push_size, uniform_data);
+            s->stats.uniform_bytes += push_size;
         }
     }
 
     /* ---- Bind packed UBOs (vertex stage) ---- */
     if (packed_vertex) {
-        uint8_t *cpu_base = (uint8_t*)dkMemBlockGetCpuAddr(dk->data_memblock);
         for (int i = 0; i < max_packed_ubos; i++) {
             const sgl_packed_ubo_t *packed = &packed_vertex[i];
             if (!packed->valid || packed->size == 0) continue;
-
-            uint32_t aligned = SGL_ALIGN_UP(packed->size, SGL_UNIFORM_ALIGNMENT);
-            uint32_t offset = dk_alloc_uniform(be, aligned);
-
-            /* Copy shadow buffer to CPU-visible GPU memory */
-            memcpy(cpu_base + dk->uniform_base + offset, packed->data, packed->size);
-
-            DkGpuAddr gpu_addr = uniform_gpu_base + offset;
-            dkCmdBufBindUniformBuffer(dk->cmdbuf, DkStage_Vertex, i, gpu_addr, aligned);
-            dkCmdBufPushConstants(dk->cmdbuf, gpu_addr, aligned, 0, packed->size,
-                                  cpu_base + dk->uniform_base + offset);
+            dk_bind_packed_ubo(be, program, 0, i, packed);
         }
     }
 
     /* ---- Bind packed UBOs (fragment stage) ---- */
     if (packed_fragment) {
-        uint8_t *cpu_base = (uint8_t*)dkMemBlockGetCpuAddr(dk->data_memblock);
         for (int i = 0; i < max_packed_ubos; i++) {
             const sgl_packed_ubo_t *packed = &packed_fragment[i];
             if (!packed->valid || packed->size == 0) continue;
-
-            uint32_t aligned = SGL_ALIGN_UP(packed->size, SGL_UNIFORM_ALIGNMENT);
-            uint32_t offset = dk_alloc_uniform(be, aligned);
-
-            /* Copy shadow buffer to CPU-visible GPU memory */
-            memcpy(cpu_base + dk->uniform_base + offset, packed->data, packed->size);
-
-            DkGpuAddr gpu_addr = uniform_gpu_base + offset;
-            dkCmdBufBindUniformBuffer(dk->cmdbuf, DkStage_Fragment, i, gpu_addr, aligned);
-            dkCmdBufPushConstants(dk->cmdbuf, gpu_addr, aligned, 0, packed->size,
-                                  cpu_base + dk->uniform_base + offset);
+            dk_bind_packed_ubo(be, program, 1, i, packed);
         }
     }
 
@@ -0,0 +1,135 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * deko3d Backend - Upload Staging Ring
+ *
+ * CPU-written staging memory for texture uploads, kept apart from the
+ * client array region so vertex streaming and uploads never compete:
+ * - Ring allocator over a dedicated memblock, created by the first upload;
+ *   positions are monotonic
+ * - Each slot remembers where its allocations end; once the slot's fence
+ *   has signaled the tail moves past them
+ * - Uploads that do not fit chain a temporary memblock owned by the slot
+ */
+
+#include "dk_internal.h"
+
+/* ============================================================================
+ * Initialization
+ * ============================================================================ */
+
+void dk_staging_init(dk_backend_data_t *dk, uint32_t size) {
+    dk_staging_ring_t *ring = &dk->staging;
+    memset(ring, 0, sizeof(*ring));
+    ring->size = size;
+}
+
+/* Applications that never upload a texture never pay for the ring */
+static bool dk_staging_create(dk_backend_data_t *dk) {
+    dk_staging_ring_t *ring = &dk->staging;
+    DkMemBlockMaker maker;
+    dkMemBlockMakerDefaults(&maker, dk->device, ring->size);
+    maker.flags = DkMemBlockFlags_CpuUncached | DkMemBlockFlags_GpuCached;
+    ring->memblock = dkMemBlockCreate(&maker);
+    if (!ring->memblock) {
+        SGL_ERROR_BACKEND("staging: failed to create the %u KB ring", ring->size / 1024);
+        return false;
+    }
+    return true;
+}
+
+void dk_staging_shutdown(dk_backend_data_t *dk) {
+    dk_staging_reclaim_all(dk);
+    if (dk->staging.memblock) {
+        dkMemBlockDestroy(dk->staging.memblock);
+        dk->staging.memblock = NULL;
+    }
+}
+
+/* ============================================================================
+ * Allocation
+ * ============================================================================ */
+
+/* Chain a dedicated memblock, released with the rest of the slot's staging */
+static bool dk_staging_alloc_overflow(dk_backend_data_t *dk, uint32_t size, uint32_t align,
+                                      uint8_t **out_cpu, DkGpuAddr *out_gpu) {
+    dk_staging_ring_t *ring = &dk->staging;
+    int slot = dk->current_slot;
+
+    if (ring->overflow_count[slot] >= DK_MAX_STAGING_OVERFLOW) {
+        /* Too many chained blocks in flight - wait for the GPU and start over */
+        dk_drain_queue(dk);
+        if (size <= ring->size) {
+            return dk_staging_alloc(dk, size, align, out_cpu, out_gpu);
+        }
+    }
+
+    DkMemBlockMaker maker;
+    dkMemBlockMakerDefaults(&maker, dk->device, SGL_ALIGN_UP(size, SGL_PAGE_ALIGNMENT));
+    maker.flags = DkMemBlockFlags_CpuUncached | DkMemBlockFlags_GpuCached;
+    DkMemBlock block = dkMemBlockCreate(&maker);
+    if (!block) {
+        ring->failed++;
+        SGL_ERROR_BACKEND("staging: failed to allocate %u byte overflow block", size);
+        return false;
+    }
+
+    ring->overflow[slot][ring->overflow_count[slot]++] = block;
+    *out_cpu = (uint8_t *)dkMemBlockGetCpuAddr(block);
+    *out_gpu = dkMemBlockGetGpuAddr(block);
+    return true;
+}
+
+bool dk_staging_alloc(dk_backend_data_t *dk, uint32_t size, uint32_t align,
+                      uint8_t **out_cpu, DkGpuAddr *out_gpu) {
+    dk_staging_ring_t *ring = &dk->staging;
+    if (size == 0) return false;
+    if (align == 0) align = 1;
+
+    if (size <= ring->size && (ring->memblock || dk_staging_create(dk))) {
+        uint64_t start = (ring->head + align - 1) & ~(uint64_t)(align - 1);
+        uint32_t offset = (uint32_t)(start % ring->size);
+
+        /* Never split an allocation across the end of the ring */
+        if (offset + size > ring->size) {
+            start += ring->size - offset;
+            offset = 0;
+        }
+
+        if (start + size - ring->tail <= ring->size) {
+            ring->head = start + size;
+            ring->slot_end[dk->current_slot] = ring->head;
+            if (ring->head - ring->tail > ring->peak) ring->peak = (uint32_t)(ring->head - ring->tail);
+            *out_cpu = (uint8_t *)dkMemBlockGetCpuAddr(ring->memblock) + offset;
+            *out_gpu = dkMemBlockGetGpuAddr(ring->memblock) + offset;
+            return true;
+        }
+    }
+
+    return dk_staging_alloc_overflow(dk, size, align, out_cpu, out_gpu);
+}
+
+/* ============================================================================
+ * Reclamation
+ * ============================================================================ */
+
+void dk_staging_reclaim(dk_backend_data_t *dk, int slot) {
+    dk_staging_ring_t *ring = &dk->staging;
+
+    /* Frames complete in submission order, so everything up to this slot's
+     * last allocation has been consumed */
+    if (ring->slot_end[slot] > ring->tail) {
+        ring->tail = ring->slot_end[slot];
+    }
+
+    for (uint32_t i = 0; i < ring->overflow_count[slot]; i++) {
+        dkMemBlockDestroy(ring->overflow[slot][i]);
+    }
+    ring->overflow_count[slot] = 0;
+}
+
+void dk_staging_reclaim_all(dk_backend_data_t *dk) {
+    for (int slot = 0; slot < SGL_FB_NUM; slot++) {
+        dk_staging_reclaim(dk, slot);
+    }
+    dk->staging.tail = dk->staging.head;
+}
@@ -14,6 +14,7 @@
  */
 
 #include "dk_internal.h"
+#include <math.h>
 
 /* ============================================================================
  * Viewport State
@@ -21,13 +22,17 @@
 
 void dk_apply_viewport(sgl_backend_t *be, const sgl_viewport_state_t *state) {
     dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_stream_t *s = dk_stream(dk);
+    DkCmdBuf cmdbuf = s->cmdbuf;
+    s->stats.viewport_binds++;
 
     DkViewport viewport = {
         (float)state->x, (float)state->y,
         (float)state->width, (float)state->height,
         state->near_val, state->far_val
     };
-    dkCmdBufSetViewports(dk->cmdbuf, 0, &viewport, 1);
+    dk_resolution_scale_rect(dk, &viewport.x, &viewport.y, &viewport.width, &viewport.height);
+    dkCmdBufSetViewports(cmdbuf, 0, &viewport, 1);
 
     SGL_TRACE_STATE("apply_viewport %d,%d %dx%d", state->x, state->y, state->width, state->height);
 }
@@ -38,14 +43,24 @@ void dk_apply_viewport(sgl_backend_t *be, const sgl_viewport_state_t *state) {
 
 void dk_apply_scissor(sgl_backend_t *be, const sgl_scissor_state_t *state) {
     dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
-
+    dk_stream_t *s = dk_stream(dk);
+    DkCmdBuf cmdbuf = s->cmdbuf;
+    s->stats.scissor_binds++;
+
+    float x = (float)(state->x < 0 ? 0 : state->x);
+    float y = (float)(state->y < 0 ? 0 : state->y);
+    float w = (float)(state->width < 0 ? 0 : state->width);
+    float h = (float)(state->height < 0 ? 0 : state->height);
+    dk_resolution_scale_rect(dk, &x, &y, &w, &h);
+
+    /* Round outwards so a scaled scissor never cuts into the scaled viewport */
+    uint32_t x0 = (uint32_t)x, y0 = (uint32_t)y;
     DkScissor scissor = {
-        (uint32_t)(state->x < 0 ? 0 : state->x),
-        (uint32_t)(state->y < 0 ? 0 : state->y),
-        (uint32_t)(state->width < 0 ? 0 : state->width),
-        (uint32_t)(state->height < 0 ? 0 : state->height)
+        x0, y0,
+        (uint32_t)ceilf(x + w) - x0,
+        (uint32_t)ceilf(y + h) - y0
     };
-    dkCmdBufSetScissors(dk->cmdbuf, 0, &scissor, 1);
+    dkCmdBufSetScissors(cmdbuf, 0, &scissor, 1);
 
     SGL_TRACE_STATE("apply_scissor %d,%d %dx%d", state->x, state->y, state->width, state->height);
 }
@@ -55,17 +70,22 @@ void dk_apply_scissor(sgl_backend_t *be, const sgl_scissor_state_t *state) {
  * ============================================================================ */
 
 void dk_apply_blend(sgl_backend_t *be, const sgl_blend_state_t *state) {
-    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_stream_t *s = dk_stream((dk_backend_data_t *)be->impl_data);
+    DkCmdBuf cmdbuf = s->cmdbuf;
+    s->stats.blend_binds++;
 
     DkColorState colorState;
     memset(&colorState, 0, sizeof(colorState));
     dkColorStateDefaults(&colorState);
 
+    /* GLES2 blend state applies to every draw buffer alike */
     if (state->enabled) {
-        dkColorStateSetBlendEnable(&colorState, 0, true);
+        for (uint32_t i = 0; i < SGL_MAX_DRAW_BUFFERS; i++) {
+            dkColorStateSetBlendEnable(&colorState, i, true);
+        }
     }
 
-    dkCmdBufBindColorState(dk->cmdbuf, &colorState);
+    dkCmdBufBindColorState(cmdbuf, &colorState);
 
     if (state->enabled) {
         DkBlendState blendState;
@@ -81,10 +101,14 @@ void dk_apply_blend(sgl_backend_t *be, const sgl_blend_state_t *state) {
             dk_convert_blend_op(state->equation_rgb),
             dk_convert_blend_op(state->equation_alpha));
 
-        dkCmdBufBindBlendStates(dk->cmdbuf, 0, &blendState, 1);
+        DkBlendState blendStates[SGL_MAX_DRAW_BUFFERS];
+        for (uint32_t i = 0; i < SGL_MAX_DRAW_BUFFERS; i++) {
+            blendStates[i] = blendState;
+        }
+        dkCmdBufBindBlendStates(cmdbuf, 0, blendStates, SGL_MAX_DRAW_BUFFERS);
 
         /* Apply blend constant color */
-        dkCmdBufSetBlendConst(dk->cmdbuf, state->color[0], state->color[1],
+        dkCmdBufSetBlendConst(cmdbuf, state->color[0], state->color[1],
                               state->color[2], state->color[3]);
     }
 
@@ -96,7 +120,9 @@ void dk_apply_blend(sgl_backend_t *be, const sgl_blend_state_t *state) {
  * ============================================================================ */
 
 void dk_apply_depth(sgl_backend_t *be, const sgl_depth_state_t *state) {
-    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_stream_t *s = dk_stream((dk_backend_data_t *)be->impl_data);
+    DkCmdBuf cmdbuf = s->cmdbuf;
+    s->stats.depth_stencil_binds++;
 
     DkDepthStencilState dsState;
     memset(&dsState, 0, sizeof(dsState));
@@ -106,7 +132,7 @@ void dk_apply_depth(sgl_backend_t *be, const sgl_depth_state_t *state) {
     dsState.depthWriteEnable = state->write_enabled;
     dsState.depthCompareOp = dk_convert_compare_op(state->func);
 
-    dkCmdBufBindDepthStencilState(dk->cmdbuf, &dsState);
+    dkCmdBufBindDepthStencilState(cmdbuf, &dsState);
 
     SGL_TRACE_STATE("apply_depth test=%d write=%d func=0x%X",
                     state->test_enabled, state->write_enabled, state->func);
@@ -117,7 +143,9 @@ void dk_apply_depth(sgl_backend_t *be, const sgl_depth_state_t *state) {
  * ============================================================================ */
 
 void dk_apply_stencil(sgl_backend_t *be, const sgl_stencil_state_t *state) {
-    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_stream_t *s = dk_stream((dk_backend_data_t *)be->impl_data);
+    DkCmdBuf cmdbuf = s->cmdbuf;
+    s->stats.depth_stencil_binds++;
 
     DkDepthStencilState dsState;
     memset(&dsState, 0, sizeof(dsState));
@@ -137,15 +165,15 @@ void dk_apply_stencil(sgl_backend_t *be, const sgl_stencil_state_t *state) {
     dsState.stencilBackPassOp = dk_convert_stencil_op(state->back.zpass_op);
     dsState.stencilBackCompareOp = dk_convert_compare_op(state->back.func);
 
-    dkCmdBufBindDepthStencilState(dk->cmdbuf, &dsState);
+    dkCmdBufBindDepthStencilState(cmdbuf, &dsState);
 
     /* Apply stencil reference values */
-    dkCmdBufSetStencil(dk->cmdbuf, DkFace_Front,
+    dkCmdBufSetStencil(cmdbuf, DkFace_Front,
         (uint8_t)state->front.write_mask,
         (uint8_t)state->front.ref,
         (uint8_t)state->front.func_mask);
 
-    dkCmdBufSetStencil(dk->cmdbuf, DkFace_Back,
+    dkCmdBufSetStencil(cmdbuf, DkFace_Back,
         (uint8_t)state->back.write_mask,
         (uint8_t)state->back.ref,
         (uint8_t)state->back.func_mask);
@@ -162,7 +190,9 @@ void dk_apply_stencil(sgl_backend_t *be, const sgl_stencil_state_t *state) {
  * ============================================================================ */
 
 void dk_apply_depth_stencil(sgl_backend_t *be, const sgl_depth_stencil_state_t *state) {
-    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_stream_t *s = dk_stream((dk_backend_data_t *)be->impl_data);
+    DkCmdBuf cmdbuf = s->cmdbuf;
+    s->stats.depth_stencil_binds++;
 
     DkDepthStencilState dsState;
     memset(&dsState, 0, sizeof(dsState));
@@ -189,16 +219,16 @@ void dk_apply_depth_stencil(sgl_backend_t *be, const sgl_depth_stencil_state_t *
     dsState.stencilBackCompareOp = dk_convert_compare_op(state->stencil_back.func);
 
     /* Bind combined depth-stencil state */
-    dkCmdBufBindDepthStencilState(dk->cmdbuf, &dsState);
+    dkCmdBufBindDepthStencilState(cmdbuf, &dsState);
 
     /* Apply stencil reference values (these are set separately from state) */
     if (state->stencil_test_enabled) {
-        dkCmdBufSetStencil(dk->cmdbuf, DkFace_Front,
+        dkCmdBufSetStencil(cmdbuf, DkFace_Front,
             (uint8_t)state->stencil_front.write_mask,
             (uint8_t)state->stencil_front.ref,
             (uint8_t)state->stencil_front.func_mask);
 
-        dkCmdBufSetStencil(dk->cmdbuf, DkFace_Back,
+        dkCmdBufSetStencil(cmdbuf, DkFace_Back,
             (uint8_t)state->stencil_back.write_mask,
             (uint8_t)state->stencil_back.ref,
             (uint8_t)state->stencil_back.func_mask);
@@ -213,7 +243,9 @@ void dk_apply_depth_stencil(sgl_backend_t *be, const sgl_depth_stencil_state_t *
  * ============================================================================ */
 
 void dk_apply_raster(sgl_backend_t *be, const sgl_raster_state_t *state) {
-    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_stream_t *s = dk_stream((dk_backend_data_t *)be->impl_data);
+    DkCmdBuf cmdbuf = s->cmdbuf;
+    s->stats.raster_binds++;
 
     DkRasterizerState rasterState;
     dkRasterizerStateDefaults(&rasterState);
@@ -234,7 +266,7 @@ void dk_apply_raster(sgl_backend_t *be, const sgl_raster_state_t *state) {
      * So no winding order inversion is needed. */
     rasterState.frontFace = (state->front_face == GL_CW) ? DkFrontFace_CW : DkFrontFace_CCW;
 
-    dkCmdBufBindRasterizerState(dk->cmdbuf, &rasterState);
+    dkCmdBufBindRasterizerState(cmdbuf, &rasterState);
 
     SGL_TRACE_STATE("apply_raster cull=%d mode=0x%X front=0x%X",
                     state->cull_enabled, state->cull_mode, state->front_face);
@@ -245,7 +277,9 @@ void dk_apply_raster(sgl_backend_t *be, const sgl_raster_state_t *state) {
  * ============================================================================ */
 
 void dk_apply_color_mask(sgl_backend_t *be, const sgl_color_state_t *state) {
-    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_stream_t *s = dk_stream((dk_backend_data_t *)be->impl_data);
+    DkCmdBuf cmdbuf = s->cmdbuf;
+    s->stats.color_mask_binds++;
 
     DkColorWriteState cwState;
     dkColorWriteStateDefaults(&cwState);
@@ -256,8 +290,10 @@ void dk_apply_color_mask(sgl_backend_t *be, const sgl_color_state_t *state) {
     if (state->mask[2]) mask |= DkColorMask_B;
     if (state->mask[3]) mask |= DkColorMask_A;
 
-    dkColorWriteStateSetMask(&cwState, 0, mask);
-    dkCmdBufBindColorWriteState(dk->cmdbuf, &cwState);
+    for (uint32_t i = 0; i < SGL_MAX_DRAW_BUFFERS; i++) {
+        dkColorWriteStateSetMask(&cwState, i, mask);
+    }
+    dkCmdBufBindColorWriteState(cmdbuf, &cwState);
 
     SGL_TRACE_STATE("apply_color_mask [%d%d%d%d]",
                     state->mask[0], state->mask[1], state->mask[2], state->mask[3]);
@@ -268,9 +304,11 @@ void dk_apply_color_mask(sgl_backend_t *be, const sgl_color_state_t *state) {
  * ============================================================================ */
 
 void dk_set_depth_bias(sgl_backend_t *be, GLfloat factor, GLfloat units) {
-    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_stream_t *s = dk_stream((dk_backend_data_t *)be->impl_data);
+    DkCmdBuf cmdbuf = s->cmdbuf;
+    s->stats.raster_binds++;
 
-    dkCmdBufSetDepthBias(dk->cmdbuf, factor, 0.0f, units);
+    dkCmdBufSetDepthBias(cmdbuf, factor, 0.0f, units);
 
     SGL_TRACE_STATE("set_depth_bias factor=%f units=%f", factor, units);
 }
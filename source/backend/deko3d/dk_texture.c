@@ -11,12 +11,18 @@
  * - Copy from framebuffer (glCopyTexImage2D, glCopyTexSubImage2D)
  *
  * Texture memory management:
- * - Textures are allocated from texture_memblock (bump allocator)
- * - Image descriptors are stored in texture_descriptors array
+ * - Textures are allocated from texture_heap memblocks (dk_heap.c);
+ *   storage is reused on same-layout re-specification and freed after the
+ *   frame fence on delete; dk_compact_texture_heap() defragments it
+ * - Image descriptors are stored in each texture's record and published to
+ *   descriptor_memblock, which grows with the highest texture handle
  * - Sampler parameters are stored per-texture and applied at bind time
  */
 
 #include "dk_internal.h"
+#include <GLES2/gl2ext.h>
+#include "../../util/sgl_pixel.h"
+#include "../../util/sgl_texfile.h"
 
 /* deko3d requires linear buffer row strides to be 32-byte aligned */
 #define DK_LINEAR_STRIDE_ALIGNMENT 32
@@ -52,17 +58,20 @@ static void dk_apply_format_swizzle(DkImageView *view, GLenum gl_format) {
             view->swizzle[2] = DkImageSwizzle_Red;   /* B = L */
             view->swizzle[3] = DkImageSwizzle_Green; /* A = A (stored in G) */
             break;
+        case GL_DEPTH_COMPONENT:
+        case GL_DEPTH_STENCIL_OES:
+            view->swizzle[0] = DkImageSwizzle_Red;   /* Depth reads as luminance */
+            view->swizzle[1] = DkImageSwizzle_Red;
+            view->swizzle[2] = DkImageSwizzle_Red;
+            view->swizzle[3] = DkImageSwizzle_One;
+            break;
         default: break; /* RGBA/RGB: default swizzle is identity */
     }
 }
 
-/* Get bytes-per-pixel for staging buffer size computation */
-static uint32_t dk_gl_format_bpp(GLenum gl_format) {
-    switch (gl_format) {
-        case GL_LUMINANCE: case GL_ALPHA: return 1;
-        case GL_LUMINANCE_ALPHA: return 2;
-        default: return 4; /* RGBA and RGB (RGB expanded to RGBA on upload) */
-    }
+/* Depth textures (GL_OES_depth_texture) only get contents by rendering */
+static bool dk_gl_format_is_depth(GLenum gl_format) {
+    return gl_format == GL_DEPTH_COMPONENT || gl_format == GL_DEPTH_STENCIL_OES;
 }
 
 /* ============================================================================
@@ -78,6 +87,341 @@ static int dk_cubemap_face_index(GLenum target) {
     return (int)(target - GL_TEXTURE_CUBE_MAP_POSITIVE_X);
 }
 
+/* ============================================================================
+ * Unit Residency (internal)
+ * ============================================================================ */
+
+void dk_texture_reset_residency(dk_stream_t *s) {
+    s->unit_handle_bound_mask = 0;
+    s->unit_residency_generation = s->state_generation;
+}
+
+/* ============================================================================
+ * Descriptor Heap (internal)
+ *
+ * descriptor_memblock holds the sampler slots at offset 0 and the image slots
+ * at DK_IMAGE_DESCRIPTOR_BASE. When a texture handle outgrows the image part,
+ * the heap is copied into a memblock twice the size; command buffers already
+ * recorded keep the old address, so the old memblock is destroyed after the
+ * current slot's fence.
+ * ============================================================================ */
+
+static DkMemBlock dk_descriptor_memblock_create(dk_backend_data_t *dk, uint32_t image_capacity) {
+    uint32_t size = SGL_ALIGN_UP(DK_IMAGE_DESCRIPTOR_BASE + image_capacity * sizeof(DkImageDescriptor),
+                                 SGL_PAGE_ALIGNMENT);
+    DkMemBlockMaker maker;
+    dkMemBlockMakerDefaults(&maker, dk->device, size);
+    maker.flags = DkMemBlockFlags_CpuUncached | DkMemBlockFlags_GpuCached;
+    return dkMemBlockCreate(&maker);
+}
+
+static void dk_descriptor_heap_set(dk_backend_data_t *dk, DkMemBlock memblock, uint32_t image_capacity) {
+    DkGpuAddr base = dkMemBlockGetGpuAddr(memblock);
+    dk->descriptor_memblock = memblock;
+    dk->sampler_descriptor_addr = base;
+    dk->image_descriptor_addr = base + DK_IMAGE_DESCRIPTOR_BASE;
+    dk->image_descriptor_capacity = image_capacity;
+}
+
+bool dk_descriptor_heap_init(dk_backend_data_t *dk) {
+    DkMemBlock memblock = dk_descriptor_memblock_create(dk, DK_IMAGE_DESCRIPTORS_INITIAL);
+    if (!memblock) return false;
+    dk_descriptor_heap_set(dk, memblock, DK_IMAGE_DESCRIPTORS_INITIAL);
+    return true;
+}
+
+void dk_descriptor_heap_shutdown(dk_backend_data_t *dk) {
+    for (int slot = 0; slot < SGL_FB_NUM; slot++) {
+        dk_descriptor_heap_reclaim(dk, slot);
+    }
+    if (dk->descriptor_memblock) {
+        dkMemBlockDestroy(dk->descriptor_memblock);
+        dk->descriptor_memblock = NULL;
+    }
+}
+
+void dk_descriptor_heap_reclaim(dk_backend_data_t *dk, int slot) {
+    for (uint32_t i = 0; i < dk->retired_descriptor_count[slot]; i++) {
+        dkMemBlockDestroy(dk->retired_descriptors[slot][i]);
+    }
+    dk->retired_descriptor_count[slot] = 0;
+}
+
+/* Grow the image part of the heap until it has a slot for handle */
+static bool dk_descriptor_heap_grow(dk_backend_data_t *dk, sgl_handle_t handle) {
+    if (handle >= DK_IMAGE_DESCRIPTORS_MAX) {
+        dk->descriptor_failed++;
+        SGL_ERROR_TEXTURE("texture handle %u exceeds the descriptor heap limit (%u)",
+                          handle, DK_IMAGE_DESCRIPTORS_MAX);
+        return false;
+    }
+
+    uint32_t capacity = dk->image_descriptor_capacity;
+    while (capacity <= handle) capacity *= 2;
+
+    DkMemBlock memblock = dk_descriptor_memblock_create(dk, capacity);
+    if (!memblock) {
+        dk->descriptor_failed++;
+        SGL_ERROR_TEXTURE("out of memory growing the descriptor heap to %u images", capacity);
+        return false;
+    }
+
+    /* Samplers and published images keep their slots */
+    memcpy(dkMemBlockGetCpuAddr(memblock), dkMemBlockGetCpuAddr(dk->descriptor_memblock),
+           DK_IMAGE_DESCRIPTOR_BASE + dk->image_descriptor_capacity * sizeof(DkImageDescriptor));
+
+    int slot = dk->current_slot;
+    bool upload = dk_upload_current(dk) != NULL;
+    if (dk->retired_descriptor_count[slot] == DK_MAX_RETIRED_DESCRIPTORS) {
+        /* Upload threads cannot drain the GL thread's queue */
+        if (upload) {
+            dk->descriptor_failed++;
+            SGL_ERROR_TEXTURE("descriptor heap grown too often this frame on an upload thread");
+            dkMemBlockDestroy(memblock);
+            return false;
+        }
+        /* Nothing recorded may reference the retired heaps after a drain */
+        dk_drain_queue(dk);
+        for (int i = 0; i < SGL_FB_NUM; i++) dk_descriptor_heap_reclaim(dk, i);
+    }
+    dk->retired_descriptors[slot][dk->retired_descriptor_count[slot]++] = dk->descriptor_memblock;
+
+    SGL_TRACE_TEXTURE("descriptor heap grown: %u -> %u images", dk->image_descriptor_capacity, capacity);
+    dk_descriptor_heap_set(dk, memblock, capacity);
+
+    /* GL thread streams notice the new capacity at their next texture bind,
+     * and the upload flush invalidates their descriptor caches */
+    if (upload) return true;
+
+    /* Every stream binds the new heap before its next texture bind */
+    dk->main_stream.descriptors_bound = false;
+    for (int i = 0; i < DK_MAX_RECORDERS; i++) {
+        if (dk->recorders[i]) dk->recorders[i]->stream.descriptors_bound = false;
+    }
+    dk->descriptors_dirty = true;
+    return true;
+}
+
+/*
+ * Write a texture's image descriptor into its persistent heap slot.
+ * The slot is written by the CPU, so any recorded or in-flight work that may
+ * still sample the previous descriptor is drained first.
+ */
+static void dk_texture_publish_descriptor(dk_backend_data_t *dk, sgl_handle_t handle) {
+    if (handle >= dk->image_descriptor_capacity && !dk_descriptor_heap_grow(dk, handle)) {
+        return;
+    }
+    if (handle >= dk->image_descriptor_high_water) dk->image_descriptor_high_water = handle + 1;
+
+    dk_texture_t *tex = dk_texture_rw(dk, handle);
+    if (!tex) return;
+    DkImageDescriptor *heap = (DkImageDescriptor *)((uint8_t *)dkMemBlockGetCpuAddr(dk->descriptor_memblock)
+                                                    + DK_IMAGE_DESCRIPTOR_BASE);
+
+    /* Re-specification into the same storage yields the same descriptor */
+    if (memcmp(&heap[handle], &tex->descriptor, sizeof(DkImageDescriptor)) == 0) {
+        return;
+    }
+
+    /* Upload threads cannot drain the GL thread's queue: GL leaves
+     * re-specifying a texture in use elsewhere to the application's fences */
+    bool upload = dk_upload_current(dk) != NULL;
+    if (tex->descriptor_in_use && !upload) {
+        dk_drain_queue(dk);
+        tex->descriptor_in_use = false;
+        tex->graphics_copy = false;
+    }
+
+    memcpy(&heap[handle], &tex->descriptor, sizeof(DkImageDescriptor));
+    if (!upload) dk->descriptors_dirty = true;
+}
+
+/* ============================================================================
+ * Upload Staging (internal)
+ * ============================================================================ */
+
+typedef struct dk_staging {
+    uint8_t *cpu;
+    DkGpuAddr gpu;
+} dk_staging_t;
+
+/*
+ * Reserve staging memory for a texture upload from the staging ring.
+ * The ring is only recycled after this slot's fence, so the copy is simply
+ * recorded into the current command list and runs with the rest of the frame.
+ */
+static bool dk_staging_begin(dk_backend_data_t *dk, uint32_t size, dk_staging_t *st) {
+    dk_upload_t *u = dk_upload_current(dk);
+    if (u) {
+        return dk_upload_staging_alloc(dk, u, size, DK_LINEAR_STRIDE_ALIGNMENT, &st->cpu, &st->gpu);
+    }
+    if (dk->transfer.queue) dk->transfer.staged_bytes += size;
+    return dk_staging_alloc(dk, size, DK_LINEAR_STRIDE_ALIGNMENT, &st->cpu, &st->gpu);
+}
+
+/*
+ * Order an upload into a texture after earlier work in the command list that
+ * may still sample it (its storage may have been reused in place).
+ */
+static void dk_staging_prepare(dk_backend_data_t *dk, sgl_handle_t handle) {
+    if (dk_texture(dk, handle)->descriptor_in_use) {
+        dk_barrier(dk, DkBarrier_Full, 0);
+    }
+}
+
+/*
+ * Finish an upload recorded with dk_staging_begin(). Only one cache-invalidating
+ * barrier is armed, issued at the next texture bind so a batch of uploads
+ * shares it. Transfer queue copies start once enough data was staged.
+ */
+static void dk_staging_submit(dk_backend_data_t *dk) {
+    /* An upload thread arms it when it flushes */
+    if (dk_upload_current(dk)) return;
+    dk->upload_barrier_pending = true;
+    dk_transfer_submit_staged(dk);
+}
+
+/* ============================================================================
+ * Texture Storage (internal)
+ * ============================================================================ */
+
+/* Initialize a texture's DkImage on its texture_heap range */
+static void dk_texture_init_image(dk_backend_data_t *dk, dk_texture_t *tex, const DkImageLayout *layout) {
+    const dk_heap_block_t *block = dk_heap_block(&dk->texture_heap, tex->mem_offset);
+    dkImageInitialize(&tex->image, layout, block->memblock, tex->mem_offset - block->base);
+}
+
+/*
+ * Bind storage in texture_heap to a texture's DkImage.
+ * A re-specified texture whose layout needs the same size and alignment keeps
+ * its existing range; otherwise the old range is freed after the frame fence.
+ * Returns false when the texture heap has no room.
+ */
+static bool dk_texture_alloc_storage(dk_backend_data_t *dk, sgl_handle_t handle,
+                                     const DkImageLayout *layout) {
+    dk_texture_t *tex = dk_texture_rw(dk, handle);
+    if (!tex) return false;
+    uint32_t size = (uint32_t)dkImageLayoutGetSize(layout);
+    uint32_t align = dkImageLayoutGetAlignment(layout);
+
+    bool reuse = tex->mem_size == size &&
+                 (tex->mem_offset & (align - 1)) == 0;
+    if (!reuse) {
+        uint32_t offset;
+        if (!dk_heap_alloc(&dk->texture_heap, size, align, &offset)) {
+            return false;
+        }
+        if (tex->mem_size > 0) {
+            dk_defer_free(dk, &dk->texture_heap, tex->mem_offset, tex->mem_size);
+        }
+        tex->mem_offset = offset;
+        tex->mem_size = size;
+    }
+
+    tex->layout = *layout;
+    dk_texture_init_image(dk, tex, layout);
+    return true;
+}
+
+/* Number of levels in a full mip chain down to 1x1 */
+static uint32_t dk_full_mip_levels(uint32_t width, uint32_t height) {
+    uint32_t max_dim = width > height ? width : height;
+    uint32_t levels = 1;
+    while (max_dim > 1) {
+        max_dim >>= 1;
+        levels++;
+    }
+    return levels;
+}
+
+/* Size of a dimension at a mip level */
+static uint32_t dk_mip_dim(uint32_t dim, uint32_t level) {
+    dim >>= level;
+    return dim > 0 ? dim : 1;
+}
+
+/* View of one level of one face (layer 0 for 2D textures), as a 2D image */
+static void dk_mip_face_view(DkImageView *view, const DkImage *image, const dk_texture_t *tex,
+                             uint32_t face, uint32_t level) {
+    dkImageViewDefaults(view, image);
+    view->mipLevelOffset = level;
+    view->mipLevelCount = 1;
+    if (tex->is_cubemap) {
+        view->type = DkImageType_2D;
+        view->layerOffset = face;
+        view->layerCount = 1;
+    }
+}
+
+/*
+ * Give a texture storage for its full mip chain.
+ * Textures are created with level 0 only; the chain is allocated the first
+ * time mip levels get content (glGenerateMipmap, glTexImage2D with level > 0).
+ * Level 0 (of every face for cubemaps) is copied into the new storage on the
+ * GPU and the old range is freed after the frame fence. Returns false when
+ * the texture heap is full.
+ */
+static bool dk_texture_ensure_mips(dk_backend_data_t *dk, sgl_handle_t handle) {
+    dk_texture_t *tex = dk_texture_rw(dk, handle);
+    if (!tex) return false;
+    uint32_t levels = dk_full_mip_levels(tex->width, tex->height);
+    if (tex->mip_levels >= levels) {
+        return true;
+    }
+
+    DkImageLayoutMaker layoutMaker;
+    dkImageLayoutMakerDefaults(&layoutMaker, dk->device);
+    layoutMaker.flags = DkImageFlags_UsageRender | DkImageFlags_Usage2DEngine;
+    layoutMaker.format = tex->format;
+    if (tex->is_cubemap) layoutMaker.type = DkImageType_Cubemap;
+    layoutMaker.dimensions[0] = tex->width;
+    layoutMaker.dimensions[1] = tex->height;
+    layoutMaker.dimensions[2] = 1;
+    layoutMaker.mipLevels = levels;
+
+    DkImageLayout layout;
+    dkImageLayoutInitialize(&layout, &layoutMaker);
+
+    /* Level 0 may have pending uploads or renders */
+    dk_hazard_before_copy(dk, handle);
+
+    DkImage old_image = tex->image;
+    if (!dk_texture_alloc_storage(dk, handle, &layout)) {
+        SGL_ERROR_BACKEND("Texture memory overflow allocating %u mip levels", levels);
+        return false;
+    }
+    tex->mip_levels = levels;
+
+    uint32_t faces = tex->is_cubemap ? 6 : 1;
+    DkImageRect rect = { 0, 0, 0, tex->width, tex->height, 1 };
+    for (uint32_t face = 0; face < faces; face++) {
+        DkImageView srcView, dstView;
+        dk_mip_face_view(&srcView, &old_image, tex, face, 0);
+        dk_mip_face_view(&dstView, &tex->image, tex, face, 0);
+        dkCmdBufCopyImage(dk_transfer_cmdbuf(dk, handle, true), &srcView, &rect, &dstView, &rect, 0);
+    }
+    dk_hazard_transfer_write(dk, handle);
+
+    DkImageView imageView;
+    dkImageViewDefaults(&imageView, &tex->image);
+    if (tex->is_cubemap) imageView.type = DkImageType_Cubemap;
+    dk_apply_format_swizzle(&imageView, tex->gl_format);
+    dkImageDescriptorInitialize(&tex->descriptor, &imageView, false, false);
+    dk_texture_publish_descriptor(dk, handle);
+
+    /* A bound FBO still targets the old storage (the GL thread's: an upload
+     * thread leaves it to the application to bind the FBO again) */
+    for (uint32_t i = 0; dk->current_fbo != 0 && !dk_upload_current(dk) && i < SGL_MAX_DRAW_BUFFERS; i++) {
+        if (dk->current_fbo_targets[i] == handle) {
+            dk_rebind_render_target(dk);
+            break;
+        }
+    }
+
+    SGL_TRACE_TEXTURE("ensure_mips handle=%u levels=%u", handle, levels);
+    return true;
+}
+
 /* ============================================================================
  * Cubemap Texture Upload (internal)
  * ============================================================================ */
@@ -86,10 +430,12 @@ static void dk_cubemap_face_upload(dk_backend_data_t *dk, sgl_handle_t handle,
                                     GLenum target, GLint internalformat,
                                     GLsizei width, GLsizei height,
                                     GLenum format, GLenum type, const void *pixels) {
+    dk_texture_t *tex = dk_texture_rw(dk, handle);
+    if (!tex) return;
     int face_index = dk_cubemap_face_index(target);
 
     /* Create cubemap GPU image on first face upload (allocates memory for all 6 faces) */
-    if (!dk->texture_initialized[handle]) {
+    if (!tex->initialized) {
         /* Initialize DkImage as cubemap */
         DkImageLayoutMaker layoutMaker;
         dkImageLayoutMakerDefaults(&layoutMaker, dk->device);
@@ -104,33 +450,26 @@ static void dk_cubemap_face_upload(dk_backend_data_t *dk, sgl_handle_t handle,
         DkImageLayout layout;
         dkImageLayoutInitialize(&layout, &layoutMaker);
 
-        uint64_t texSize = dkImageLayoutGetSize(&layout);
-        uint32_t texAlign = dkImageLayoutGetAlignment(&layout);
-
-        uint32_t aligned_offset = (dk->texture_offset + texAlign - 1) & ~(texAlign - 1);
-        if (aligned_offset + texSize > SGL_TEXTURE_MEM_SIZE) {
+        if (!dk_texture_alloc_storage(dk, handle, &layout)) {
             SGL_ERROR_BACKEND("Cubemap texture memory overflow");
             return;
         }
-
-        DkImage *texImage = &dk->textures[handle];
-        dkImageInitialize(texImage, &layout, dk->texture_memblock, aligned_offset);
-        dk->texture_offset = aligned_offset + texSize;
-        dk->texture_initialized[handle] = true;
-        dk->texture_is_cubemap[handle] = true;
-        dk->cubemap_face_mask[handle] = 0;  /* No faces uploaded yet */
-        dk->cubemap_needs_barrier[handle] = false;
-
-        dk->texture_width[handle] = width;
-        dk->texture_height[handle] = height;
-        dk->texture_mip_levels[handle] = 1;
-        dk->texture_format[handle] = layoutMaker.format;
-        dk->texture_gl_format[handle] = (GLenum)internalformat;
-
-        dk->texture_min_filter[handle] = GL_LINEAR;
-        dk->texture_mag_filter[handle] = GL_LINEAR;
-        dk->texture_wrap_s[handle] = GL_CLAMP_TO_EDGE;
-        dk->texture_wrap_t[handle] = GL_CLAMP_TO_EDGE;
+        tex->initialized = true;
+        tex->is_cubemap = true;
+        tex->cubemap_face_mask = 0;  /* No faces uploaded yet */
+        tex->cubemap_needs_barrier = false;
+
+        tex->width = width;
+        tex->height = height;
+        tex->mip_levels = 1;
+        tex->format = layoutMaker.format;
+        tex->gl_format = (GLenum)internalformat;
+
+        tex->min_filter = GL_LINEAR;
+        tex->mag_filter = GL_LINEAR;
+        tex->wrap_s = GL_CLAMP_TO_EDGE;
+        tex->wrap_t = GL_CLAMP_TO_EDGE;
+        tex->sampler_key = DK_SAMPLER_KEY_NONE;
 
         /* NOTE: Descriptor creation is DEFERRED until all 6 faces are uploaded.
          * This follows the GLOVE pattern where GPU resources are fully initialized
@@ -141,44 +480,25 @@ static void dk_cubemap_face_upload(dk_backend_data_t *dk, sgl_handle_t handle,
 
     /* Upload face pixels if provided */
     if (pixels) {
-        DkImage *texImage = &dk->textures[handle];
+        const DkImage *texImage = &tex->image;
 
-        uint32_t bpp = dk_gl_format_bpp(format);
+        uint32_t bpp = sgl_pixel_dst_bpp(format, type);
         uint32_t row_size = width * bpp;
         uint32_t aligned_row_size = SGL_ALIGN_UP(row_size, DK_LINEAR_STRIDE_ALIGNMENT);
         uint32_t staging_size = aligned_row_size * height;
 
-        uint32_t stagingOffset = SGL_ALIGN_UP(dk->client_array_offset, DK_LINEAR_STRIDE_ALIGNMENT);
-        if (stagingOffset + staging_size > dk->uniform_base - dk->client_array_base) {
+        dk_staging_t st;
+        if (!dk_staging_begin(dk, staging_size, &st)) {
             SGL_ERROR_BACKEND("cubemap staging buffer overflow");
             return;
         }
 
-        uint8_t *staging = (uint8_t*)dkMemBlockGetCpuAddr(dk->data_memblock)
-                           + dk->client_array_base + stagingOffset;
+        uint8_t *staging = st.cpu;
         const uint8_t *src = (const uint8_t*)pixels;
 
-        /* Copy pixels to staging buffer */
-        if (format == GL_RGB && type == GL_UNSIGNED_BYTE) {
-            /* Convert RGB to RGBA (bpp=4 for staging) */
-            for (int y = 0; y < height; y++) {
-                uint8_t *dst_row = staging + y * aligned_row_size;
-                const uint8_t *src_row = src + y * width * 3;
-                for (int x = 0; x < width; x++) {
-                    dst_row[x * 4 + 0] = src_row[x * 3 + 0];
-                    dst_row[x * 4 + 1] = src_row[x * 3 + 1];
-                    dst_row[x * 4 + 2] = src_row[x * 3 + 2];
-                    dst_row[x * 4 + 3] = 255;
-                }
-            }
-        } else {
-            /* RGBA, LUMINANCE, ALPHA, LUMINANCE_ALPHA: copy bpp bytes per pixel */
-            for (int y = 0; y < height; y++) {
-                memcpy(staging + y * aligned_row_size, src + y * width * bpp, width * bpp);
-            }
-        }
-
-        dk->client_array_offset = stagingOffset + staging_size;
+        /* Convert/copy pixels to staging buffer (RGB widens to RGBA) */
+        sgl_pixel_unpack(staging, aligned_row_size, src, (uint32_t)width, (uint32_t)height,
+                         format, type, dk_unpack_alignment(dk));
 
         /* Create image view targeting specific face */
         DkImageView faceView;
@@ -187,54 +507,46 @@ static void dk_cubemap_face_upload(dk_backend_data_t *dk, sgl_handle_t handle,
         faceView.layerOffset = face_index;
         faceView.layerCount = 1;
 
-        DkGpuAddr stagingAddr = dkMemBlockGetGpuAddr(dk->data_memblock)
-                                + dk->client_array_base + stagingOffset;
-        DkCopyBuf srcBuf = { stagingAddr, aligned_row_size, (uint32_t)height };
+        DkCopyBuf srcBuf = { st.gpu, aligned_row_size, (uint32_t)height };
         DkImageRect dstRect = { 0, 0, 0, (uint32_t)width, (uint32_t)height, 1 };
 
-        dkCmdBufCopyBufferToImage(dk->cmdbuf, &srcBuf, &faceView, &dstRect, 0);
-
-        /* Submit and wait for copy to complete */
-        DkCmdList cmdlist = dkCmdBufFinishList(dk->cmdbuf);
-        dkQueueSubmitCommands(dk->queue, cmdlist);
-        dkQueueWaitIdle(dk->queue);
-
-        /* Reset command buffer */
-        dkCmdBufClear(dk->cmdbuf);
-        dkCmdBufAddMemory(dk->cmdbuf, dk->cmdbuf_memblock[dk->current_slot], 0, SGL_CMD_MEM_SIZE);
-        dk->descriptors_bound = false;
-
-        /* Track this face as uploaded */
-        dk->cubemap_face_mask[handle] |= (1 << face_index);
-
-        SGL_TRACE_TEXTURE("cubemap face %d uploaded handle=%u (mask=0x%02X)",
-                          face_index, handle, dk->cubemap_face_mask[handle]);
-
-        /* GLOVE pattern: Create descriptor only after ALL 6 faces are uploaded.
-         * This ensures the cubemap image is fully populated before creating
-         * the sampling descriptor. */
-        if (dk->cubemap_face_mask[handle] == DK_CUBEMAP_ALL_FACES) {
-            /* All 6 faces uploaded - create the cubemap image descriptor now */
-            DkImageView imageView;
-            dkImageViewDefaults(&imageView, texImage);
-            imageView.type = DkImageType_Cubemap;
-            dk_apply_format_swizzle(&imageView, dk->texture_gl_format[handle]);
-
-            DkImageDescriptor *imgDesc = &dk->texture_descriptors[handle];
-            dkImageDescriptorInitialize(imgDesc, &imageView, false, false);
-
-            /* Mark cubemap as needing L2 cache barrier before first sampling.
-             * The DMA copy engine writes directly to DRAM, but the texture sampler
-             * reads through L2 cache. Without invalidation, the sampler may read
-             * stale (zero) data from L2 instead of the freshly DMA'd face data. */
-            dk->cubemap_needs_barrier[handle] = true;
-            dk->texture_used_as_rt[handle] = true;  /* Belt-and-suspenders: also set RT flag */
-
-            SGL_TRACE_TEXTURE("cubemap COMPLETE handle=%u - descriptor created, barrier pending",
-                              handle);
-        }
+        dk_staging_prepare(dk, handle);
+        dkCmdBufCopyBufferToImage(dk_transfer_cmdbuf(dk, handle, false), &srcBuf, &faceView, &dstRect, 0);
+        dk_staging_submit(dk);
+
+        SGL_TRACE_TEXTURE("cubemap face %d uploaded handle=%u", face_index, handle);
+    }
 
-        dk_rebind_render_target(dk);
+    /* A face specified without data still counts: render-target cubemaps
+     * (dynamic environment maps) get their content from draws */
+    bool was_complete = tex->cubemap_face_mask == DK_CUBEMAP_ALL_FACES;
+    tex->cubemap_face_mask |= (1 << face_index);
+
+    /* GLOVE pattern: Create descriptor only after ALL 6 faces are specified.
+     * This ensures the cubemap image is fully populated before creating
+     * the sampling descriptor. */
+    if (!was_complete && tex->cubemap_face_mask == DK_CUBEMAP_ALL_FACES) {
+        /* All 6 faces specified - create the cubemap image descriptor now */
+        DkImageView imageView;
+        dkImageViewDefaults(&imageView, &tex->image);
+        imageView.type = DkImageType_Cubemap;
+        dk_apply_format_swizzle(&imageView, tex->gl_format);
+
+        DkImageDescriptor *imgDesc = &tex->descriptor;
+        dkImageDescriptorInitialize(imgDesc, &imageView, false, false);
+        dk_texture_publish_descriptor(dk, handle);
+
+        /* Mark cubemap as needing L2 cache barrier before first sampling.
+         * The DMA copy engine writes directly to DRAM, but the texture sampler
+         * reads through L2 cache. Without invalidation, the sampler may read
+         * stale (zero) data from L2 instead of the freshly DMA'd face data. */
+        tex->cubemap_needs_barrier = true;
+        dk_hazard_transfer_write(dk, handle);
+
+        SGL_TRACE_TEXTURE("cubemap COMPLETE handle=%u - descriptor created, barrier pending",
+                          handle);
+    } else if (pixels && was_complete) {
+        dk_hazard_transfer_write(dk, handle);
     }
 }
 
@@ -246,94 +558,116 @@ void dk_texture_image_2d(sgl_backend_t *be, sgl_handle_t handle,
                          GLenum target, GLint level, GLint internalformat,
                          GLsizei width, GLsizei height, GLint border,
                          GLenum format, GLenum type, const void *pixels) {
-    (void)level;
     (void)border;
     dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
 
-    if (handle == 0 || handle >= SGL_MAX_TEXTURES) return;
+    dk_texture_t *tex = handle ? (dk_texture_t *)sgl_table_ensure(&dk->textures, handle) : NULL;
+    if (!tex) return;
 
     /* Handle cubemap faces separately */
     if (dk_is_cubemap_face(target)) {
+        if (level > 0) {
+            SGL_ERROR_BACKEND("texture_image_2d: cubemap mip levels not supported");
+            return;
+        }
         dk_cubemap_face_upload(dk, handle, target, internalformat, width, height, format, type, pixels);
         return;
     }
 
-    /* === Regular 2D texture path (unchanged) === */
+    /* Mip level: must match the level 0 image, then upload into the chain */
+    if (level > 0) {
+        DkImageFormat level_format = dk_convert_format(internalformat, format, type);
+        if (!tex->initialized || tex->is_cubemap || tex->format != level_format ||
+            (uint32_t)level >= dk_full_mip_levels(tex->width, tex->height) ||
+            (uint32_t)width != dk_mip_dim(tex->width, level) ||
+            (uint32_t)height != dk_mip_dim(tex->height, level)) {
+            SGL_ERROR_BACKEND("texture_image_2d: level %d of texture %u does not match level 0",
+                              level, handle);
+            return;
+        }
+        if (!dk_texture_ensure_mips(dk, handle)) {
+            return;
+        }
+        dk_texture_sub_image_2d(be, handle, target, level, 0, 0, width, height, format, type, pixels);
+        return;
+    }
 
-    /* Calculate number of mip levels (for potential glGenerateMipmap) */
-    uint32_t max_dim = (uint32_t)(width > height ? width : height);
+    /* Level 0 only; re-specifying a mipmapped texture at the same size and
+     * format keeps its chain (and its storage) */
+    DkImageFormat dk_format = dk_convert_format(internalformat, format, type);
     uint32_t mip_levels = 1;
-    uint32_t temp = max_dim;
-    while (temp > 1) {
-        temp >>= 1;
-        mip_levels++;
+    if (tex->initialized && !tex->is_cubemap && tex->format == dk_format &&
+        tex->width == (uint32_t)width && tex->height == (uint32_t)height) {
+        mip_levels = tex->mip_levels;
     }
 
-    /* Initialize DkImage for this texture */
+    /* Initialize DkImage for this texture; depth formats are not
+     * 2D engine surfaces, they are only rendered to and sampled */
+    bool is_depth = dk_gl_format_is_depth(format);
     DkImageLayoutMaker layoutMaker;
     dkImageLayoutMakerDefaults(&layoutMaker, dk->device);
-    layoutMaker.flags = DkImageFlags_UsageRender | DkImageFlags_Usage2DEngine;
-    layoutMaker.format = dk_convert_format(internalformat, format, type);
+    layoutMaker.flags = is_depth ? DkImageFlags_UsageRender
+                                 : DkImageFlags_UsageRender | DkImageFlags_Usage2DEngine;
+    layoutMaker.format = dk_format;
     layoutMaker.dimensions[0] = width;
     layoutMaker.dimensions[1] = height;
     layoutMaker.dimensions[2] = 1;
-    layoutMaker.mipLevels = mip_levels;  /* Allocate space for all mip levels */
+    layoutMaker.mipLevels = mip_levels;
 
     DkImageLayout layout;
     dkImageLayoutInitialize(&layout, &layoutMaker);
 
-    uint64_t texSize = dkImageLayoutGetSize(&layout);
-    uint32_t texAlign = dkImageLayoutGetAlignment(&layout);
-
-    /* Align texture offset */
-    uint32_t aligned_offset = (dk->texture_offset + texAlign - 1) & ~(texAlign - 1);
-    if (aligned_offset + texSize > SGL_TEXTURE_MEM_SIZE) {
+    if (!dk_texture_alloc_storage(dk, handle, &layout)) {
         SGL_ERROR_BACKEND("Texture memory overflow");
         return;
     }
 
-    DkImage *texImage = &dk->textures[handle];
-    dkImageInitialize(texImage, &layout, dk->texture_memblock, aligned_offset);
-    dk->texture_offset = aligned_offset + texSize;
-    dk->texture_initialized[handle] = true;
-    dk->texture_is_cubemap[handle] = false;  /* This is a 2D texture */
+    const DkImage *texImage = &tex->image;
+    tex->initialized = true;
+    tex->is_cubemap = false;  /* This is a 2D texture */
 
     /* Store texture dimensions and format for glGenerateMipmap */
-    dk->texture_width[handle] = width;
-    dk->texture_height[handle] = height;
-    dk->texture_mip_levels[handle] = mip_levels;
-    dk->texture_format[handle] = layoutMaker.format;
-    dk->texture_gl_format[handle] = (GLenum)internalformat;
+    tex->width = width;
+    tex->height = height;
+    tex->mip_levels = mip_levels;
+    tex->format = layoutMaker.format;
+    tex->gl_format = (GLenum)internalformat;
 
     /* Initialize default sampler parameters (GL defaults) */
-    dk->texture_min_filter[handle] = GL_NEAREST_MIPMAP_LINEAR;  /* GL default */
-    dk->texture_mag_filter[handle] = GL_LINEAR;                  /* GL default */
-    dk->texture_wrap_s[handle] = GL_REPEAT;
-    dk->texture_wrap_t[handle] = GL_REPEAT;
+    tex->min_filter = GL_NEAREST_MIPMAP_LINEAR;  /* GL default */
+    tex->mag_filter = GL_LINEAR;                  /* GL default */
+    tex->wrap_s = GL_REPEAT;
+    tex->wrap_t = GL_REPEAT;
+    tex->sampler_key = DK_SAMPLER_KEY_NONE;
 
     /* Create image descriptor with format-specific swizzle */
     DkImageView imageView;
     dkImageViewDefaults(&imageView, texImage);
     dk_apply_format_swizzle(&imageView, internalformat);
 
-    DkImageDescriptor *imgDesc = &dk->texture_descriptors[handle];
+    DkImageDescriptor *imgDesc = &tex->descriptor;
     dkImageDescriptorInitialize(imgDesc, &imageView, false, false);
+    dk_texture_publish_descriptor(dk, handle);
+
+    /* Upload into level 0 only */
+    imageView.mipLevelCount = 1;
 
     /* Upload pixel data if provided - use staging buffer and GPU copy like legacy */
-    if (pixels) {
+    if (pixels && is_depth) {
+        SGL_ERROR_BACKEND("texture_image_2d: depth texture %u data ignored", handle);
+    } else if (pixels) {
         /* Calculate source size with stride alignment (bpp-aware) */
-        uint32_t bpp = dk_gl_format_bpp(format);
+        uint32_t bpp = sgl_pixel_dst_bpp(format, type);
         uint32_t row_size = width * bpp;
         uint32_t aligned_row_size = SGL_ALIGN_UP(row_size, DK_LINEAR_STRIDE_ALIGNMENT);
         uint32_t staging_size = aligned_row_size * height;
 
         const uint8_t *src = (const uint8_t*)pixels;
 
-        /* Use client array region as staging */
-        uint32_t stagingOffset = SGL_ALIGN_UP(dk->client_array_offset, DK_LINEAR_STRIDE_ALIGNMENT);
-        if (stagingOffset + staging_size <= dk->uniform_base - dk->client_array_base) {
-            uint8_t *staging = (uint8_t*)dkMemBlockGetCpuAddr(dk->data_memblock)
-                               + dk->client_array_base + stagingOffset;
+        /* Stage and record the copy - it executes with the rest of the frame */
+        dk_staging_t st;
+        if (dk_staging_begin(dk, staging_size, &st)) {
+            uint8_t *staging = st.cpu;
 
             /* Copy pixel data to staging buffer with proper stride.
              *
@@ -342,52 +676,23 @@ void dk_texture_image_2d(sgl_backend_t *be, sgl_handle_t handle,
              * deko3d texture V=0 samples the TOP of the texture storage (row 0).
              * By storing GL row 0 (bottom) at storage row 0 (top), deko3d V=0
              * will sample what GL expects at V=0 (bottom content). */
-            if (format == GL_RGB && type == GL_UNSIGNED_BYTE) {
-                /* Convert RGB to RGBA, no Y-flip */
-                for (int y = 0; y < height; y++) {
-                    uint8_t *dst_row = staging + y * aligned_row_size;
-                    const uint8_t *src_row = src + y * width * 3;
-                    for (int x = 0; x < width; x++) {
-                        dst_row[x * 4 + 0] = src_row[x * 3 + 0];
-                        dst_row[x * 4 + 1] = src_row[x * 3 + 1];
-                        dst_row[x * 4 + 2] = src_row[x * 3 + 2];
-                        dst_row[x * 4 + 3] = 255;
-                    }
-                }
-            } else {
-                /* RGBA, LUMINANCE, ALPHA, LUMINANCE_ALPHA: copy bpp bytes per pixel */
-                for (int y = 0; y < height; y++) {
-                    memcpy(staging + y * aligned_row_size, src + y * width * bpp, width * bpp);
-                }
-            }
-
-            dk->client_array_offset = stagingOffset + staging_size;
+            sgl_pixel_unpack(staging, aligned_row_size, src, (uint32_t)width, (uint32_t)height,
+                             format, type, dk_unpack_alignment(dk));
 
             /* Copy staging to texture */
-            DkGpuAddr stagingAddr = dkMemBlockGetGpuAddr(dk->data_memblock)
-                                    + dk->client_array_base + stagingOffset;
-            DkCopyBuf srcBuf = { stagingAddr, aligned_row_size, (uint32_t)height };
+            DkCopyBuf srcBuf = { st.gpu, aligned_row_size, (uint32_t)height };
             DkImageRect dstRect = { 0, 0, 0, (uint32_t)width, (uint32_t)height, 1 };
 
-            dkCmdBufCopyBufferToImage(dk->cmdbuf, &srcBuf, &imageView, &dstRect, 0);
-
-            /* Submit and wait for copy to complete */
-            DkCmdList cmdlist = dkCmdBufFinishList(dk->cmdbuf);
-            dkQueueSubmitCommands(dk->queue, cmdlist);
-            dkQueueWaitIdle(dk->queue);
-
-            /* Reset command buffer for continued use */
-            dkCmdBufClear(dk->cmdbuf);
-            dkCmdBufAddMemory(dk->cmdbuf, dk->cmdbuf_memblock[dk->current_slot], 0, SGL_CMD_MEM_SIZE);
-
-            /* Reset descriptors_bound since we cleared the command buffer */
-            dk->descriptors_bound = false;
-
-            dk_rebind_render_target(dk);
+            dk_staging_prepare(dk, handle);
+            dkCmdBufCopyBufferToImage(dk_transfer_cmdbuf(dk, handle, false), &srcBuf, &imageView,
+                                      &dstRect, 0);
+            dk_staging_submit(dk);
+        } else {
+            SGL_ERROR_BACKEND("texture_image_2d: staging buffer overflow");
         }
     }
 
-    SGL_TRACE_TEXTURE("texture_image_2d handle=%u %dx%d", handle, width, height);
+    SGL_TRACE_TEXTURE("texture_image_2d handle=%u %dx%d levels=%u", handle, width, height, mip_levels);
 }
 
 /* ============================================================================
@@ -399,67 +704,58 @@ void dk_texture_sub_image_2d(sgl_backend_t *be, sgl_handle_t handle,
                              GLint xoffset, GLint yoffset,
                              GLsizei width, GLsizei height,
                              GLenum format, GLenum type, const void *pixels) {
-    (void)level;
     dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
 
-    if (handle == 0 || handle >= SGL_MAX_TEXTURES) return;
-    if (!dk->texture_initialized[handle]) {
+    dk_texture_t *tex = handle ? (dk_texture_t *)sgl_table_ensure(&dk->textures, handle) : NULL;
+    if (!tex) return;
+    if (!tex->initialized) {
         SGL_ERROR_BACKEND("texture_sub_image_2d: texture %u not initialized", handle);
         return;
     }
+    if ((uint32_t)level >= tex->mip_levels) {
+        SGL_ERROR_BACKEND("texture_sub_image_2d: level %d of texture %u not specified", level, handle);
+        return;
+    }
     if (!pixels) return;
+    if (dk_gl_format_is_depth(tex->gl_format)) {
+        SGL_ERROR_BACKEND("texture_sub_image_2d: depth texture %u data ignored", handle);
+        return;
+    }
 
     /* Get the existing DkImage */
-    DkImage *texImage = &dk->textures[handle];
+    const DkImage *texImage = &tex->image;
 
-    /* Calculate source size with stride alignment (bpp from stored GL format) */
-    uint32_t bpp = dk_gl_format_bpp(dk->texture_gl_format[handle]);
+    /* Calculate source size with stride alignment (the GL layer keeps the
+     * type of packed 16-bit textures, so this matches their storage) */
+    uint32_t bpp = sgl_pixel_dst_bpp(format, type);
     uint32_t row_size = width * bpp;
     uint32_t aligned_row_size = SGL_ALIGN_UP(row_size, DK_LINEAR_STRIDE_ALIGNMENT);
     uint32_t staging_size = aligned_row_size * height;
 
     const uint8_t *src = (const uint8_t*)pixels;
 
-    /* Use client array region as staging */
-    uint32_t stagingOffset = SGL_ALIGN_UP(dk->client_array_offset, DK_LINEAR_STRIDE_ALIGNMENT);
-    if (stagingOffset + staging_size > dk->uniform_base - dk->client_array_base) {
+    dk_staging_t st;
+    if (!dk_staging_begin(dk, staging_size, &st)) {
         SGL_ERROR_BACKEND("texture_sub_image_2d: staging buffer overflow");
         return;
     }
 
-    uint8_t *staging = (uint8_t*)dkMemBlockGetCpuAddr(dk->data_memblock)
-                       + dk->client_array_base + stagingOffset;
+    uint8_t *staging = st.cpu;
 
     /* Copy pixel data to staging buffer with proper stride.
      * No Y-flip needed - texture storage matches GL row order (see glTexImage2D comment). */
-    if (format == GL_RGB && type == GL_UNSIGNED_BYTE) {
-        /* Convert RGB to RGBA, no Y-flip */
-        for (int y = 0; y < height; y++) {
-            uint8_t *dst_row = staging + y * aligned_row_size;
-            const uint8_t *src_row = src + y * width * 3;
-            for (int x = 0; x < width; x++) {
-                dst_row[x * 4 + 0] = src_row[x * 3 + 0];
-                dst_row[x * 4 + 1] = src_row[x * 3 + 1];
-                dst_row[x * 4 + 2] = src_row[x * 3 + 2];
-                dst_row[x * 4 + 3] = 255;
-            }
-        }
-    } else {
-        /* RGBA, LUMINANCE, ALPHA, LUMINANCE_ALPHA: copy bpp bytes per pixel */
-        for (int y = 0; y < height; y++) {
-            memcpy(staging + y * aligned_row_size, src + y * width * bpp, width * bpp);
-        }
-    }
-
-    dk->client_array_offset = stagingOffset + staging_size;
+    sgl_pixel_unpack(staging, aligned_row_size, src, (uint32_t)width, (uint32_t)height,
+                     format, type, dk_unpack_alignment(dk));
 
     /* Create image view for the existing texture */
     DkImageView imageView;
     dkImageViewDefaults(&imageView, texImage);
+    imageView.mipLevelOffset = (uint32_t)level;
+    imageView.mipLevelCount = 1;
 
     /* For cubemap face targets, select the specific face layer */
     uint32_t dst_z = 0;
-    if (dk_is_cubemap_face(target) && dk->texture_is_cubemap[handle]) {
+    if (dk_is_cubemap_face(target) && tex->is_cubemap) {
         dst_z = (uint32_t)dk_cubemap_face_index(target);
     }
 
@@ -468,34 +764,20 @@ void dk_texture_sub_image_2d(sgl_backend_t *be, sgl_handle_t handle,
      * GL yoffset maps directly to storage row offset. */
     uint32_t dk_yoffset = (uint32_t)yoffset;
 
-    DkGpuAddr stagingAddr = dkMemBlockGetGpuAddr(dk->data_memblock)
-                            + dk->client_array_base + stagingOffset;
-    DkCopyBuf srcBuf = { stagingAddr, aligned_row_size, (uint32_t)height };
+    DkCopyBuf srcBuf = { st.gpu, aligned_row_size, (uint32_t)height };
     /* Note: DkImageRect is { x, y, z, width, height, depth } */
     DkImageRect dstRect = { (uint32_t)xoffset, dk_yoffset, dst_z, (uint32_t)width, (uint32_t)height, 1 };
 
-    dkCmdBufCopyBufferToImage(dk->cmdbuf, &srcBuf, &imageView, &dstRect, 0);
-
-    /* Submit and wait for copy to complete */
-    DkCmdList cmdlist = dkCmdBufFinishList(dk->cmdbuf);
-    dkQueueSubmitCommands(dk->queue, cmdlist);
-    dkQueueWaitIdle(dk->queue);
+    dk_staging_prepare(dk, handle);
+    dkCmdBufCopyBufferToImage(dk_transfer_cmdbuf(dk, handle, false), &srcBuf, &imageView, &dstRect, 0);
+    dk_staging_submit(dk);
 
-    /* Reset command buffer for continued use */
-    dkCmdBufClear(dk->cmdbuf);
-    dkCmdBufAddMemory(dk->cmdbuf, dk->cmdbuf_memblock[dk->current_slot], 0, SGL_CMD_MEM_SIZE);
-
-    /* Reset descriptors_bound since we cleared the command buffer */
-    dk->descriptors_bound = false;
-
-    dk_rebind_render_target(dk);
-
-    SGL_TRACE_TEXTURE("texture_sub_image_2d handle=%u target=0x%X offset=(%d,%d) %dx%d",
-                      handle, target, xoffset, yoffset, width, height);
+    SGL_TRACE_TEXTURE("texture_sub_image_2d handle=%u target=0x%X level=%d offset=(%d,%d) %dx%d",
+                      handle, target, level, xoffset, yoffset, width, height);
 }
 
 /* ============================================================================
- * Texture Parameter Setting (glTexParameteri)
+ * Texture Parameter Setting (glTexParameteri, glPixelStorei)
  * ============================================================================ */
 
 void dk_texture_parameter(sgl_backend_t *be, sgl_handle_t handle,
@@ -503,159 +785,201 @@ void dk_texture_parameter(sgl_backend_t *be, sgl_handle_t handle,
     (void)target;
     dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
 
-    if (handle == 0 || handle >= SGL_MAX_TEXTURES) return;
+    dk_texture_t *tex = handle ? (dk_texture_t *)sgl_table_ensure(&dk->textures, handle) : NULL;
+    if (!tex) return;
 
     /* Store sampler parameters - used when binding texture */
+    GLenum *slot;
     switch (pname) {
-        case GL_TEXTURE_MIN_FILTER:
-            dk->texture_min_filter[handle] = (GLenum)param;
-            break;
-        case GL_TEXTURE_MAG_FILTER:
-            dk->texture_mag_filter[handle] = (GLenum)param;
-            break;
-        case GL_TEXTURE_WRAP_S:
-            dk->texture_wrap_s[handle] = (GLenum)param;
-            break;
-        case GL_TEXTURE_WRAP_T:
-            dk->texture_wrap_t[handle] = (GLenum)param;
-            break;
+        case GL_TEXTURE_MIN_FILTER: slot = &tex->min_filter; break;
+        case GL_TEXTURE_MAG_FILTER: slot = &tex->mag_filter; break;
+        case GL_TEXTURE_WRAP_S:     slot = &tex->wrap_s; break;
+        case GL_TEXTURE_WRAP_T:     slot = &tex->wrap_t; break;
         default:
-            break;
+            return;
+    }
+
+    /* Only drop the cached sampler key when the value actually changes */
+    if (*slot != (GLenum)param) {
+        *slot = (GLenum)param;
+        tex->sampler_key = DK_SAMPLER_KEY_NONE;
     }
 
     SGL_TRACE_TEXTURE("texture_parameter handle=%u pname=0x%X param=0x%X", handle, pname, param);
 }
 
+void dk_pixel_store(sgl_backend_t *be, GLenum pname, GLint param) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+
+    if (pname == GL_UNPACK_ALIGNMENT) {
+        dk_upload_t *u = dk_upload_current(dk);
+        if (u) u->unpack_alignment = param;
+        else dk->unpack_alignment = param;
+    }
+}
+
+/* ============================================================================
+ * Sampler Descriptor Cache
+ * ============================================================================ */
+
+/* Map GL sampler params to a dense sampler heap slot */
+static uint8_t dk_sampler_key(GLenum min_filter, GLenum mag_filter,
+                              GLenum wrap_s, GLenum wrap_t) {
+    uint32_t min_idx;
+    switch (min_filter) {
+        case GL_NEAREST:                min_idx = 0; break;
+        case GL_LINEAR:                 min_idx = 1; break;
+        case GL_NEAREST_MIPMAP_NEAREST: min_idx = 2; break;
+        case GL_NEAREST_MIPMAP_LINEAR:  min_idx = 3; break;
+        case GL_LINEAR_MIPMAP_NEAREST:  min_idx = 4; break;
+        case GL_LINEAR_MIPMAP_LINEAR:
+        default:                        min_idx = 5; break;
+    }
+
+    uint32_t mag_idx = (mag_filter == GL_NEAREST) ? 0 : 1;
+
+    uint32_t wrap_idx[2];
+    GLenum wraps[2] = { wrap_s, wrap_t };
+    for (int i = 0; i < 2; i++) {
+        switch (wraps[i]) {
+            case GL_REPEAT:          wrap_idx[i] = 0; break;
+            case GL_MIRRORED_REPEAT: wrap_idx[i] = 1; break;
+            case GL_CLAMP_TO_EDGE:
+            default:                 wrap_idx[i] = 2; break;
+        }
+    }
+
+    return (uint8_t)(((min_idx * 2 + mag_idx) * 3 + wrap_idx[0]) * 3 + wrap_idx[1]);
+}
+
+/* Build the sampler descriptor for a cache key (inverse of dk_sampler_key) */
+static void dk_build_sampler_descriptor(uint8_t key, DkSamplerDescriptor *out) {
+    static const DkWrapMode wrap_modes[3] = {
+        DkWrapMode_Repeat, DkWrapMode_MirroredRepeat, DkWrapMode_ClampToEdge
+    };
+    static const DkFilter min_filters[6] = {
+        DkFilter_Nearest, DkFilter_Linear, DkFilter_Nearest,
+        DkFilter_Nearest, DkFilter_Linear, DkFilter_Linear
+    };
+    static const DkMipFilter mip_filters[6] = {
+        DkMipFilter_None, DkMipFilter_None, DkMipFilter_Nearest,
+        DkMipFilter_Linear, DkMipFilter_Nearest, DkMipFilter_Linear
+    };
+
+    uint32_t wrap_t_idx = key % 3;
+    uint32_t wrap_s_idx = (key / 3) % 3;
+    uint32_t mag_idx = (key / 9) % 2;
+    uint32_t min_idx = key / 18;
+
+    DkSampler sampler;
+    dkSamplerDefaults(&sampler);
+    sampler.minFilter = min_filters[min_idx];
+    sampler.mipFilter = mip_filters[min_idx];
+    sampler.magFilter = mag_idx ? DkFilter_Linear : DkFilter_Nearest;
+    sampler.wrapMode[0] = wrap_modes[wrap_s_idx];
+    sampler.wrapMode[1] = wrap_modes[wrap_t_idx];
+    sampler.wrapMode[2] = DkWrapMode_ClampToEdge;
+
+    dkSamplerDescriptorInitialize(out, &sampler);
+}
+
+/* Return the texture's sampler heap slot, recomputing it after a param change.
+ * Each slot's descriptor is immutable, so it is written once on first use. */
+static uint8_t dk_texture_sampler_key(dk_backend_data_t *dk, dk_texture_t *tex) {
+    uint8_t key = tex->sampler_key;
+    if (key == DK_SAMPLER_KEY_NONE) {
+        key = dk_sampler_key(tex->min_filter, tex->mag_filter, tex->wrap_s, tex->wrap_t);
+        tex->sampler_key = key;
+    }
+    if (!dk->sampler_cache_valid[key]) {
+        DkSamplerDescriptor *heap = (DkSamplerDescriptor *)dkMemBlockGetCpuAddr(dk->descriptor_memblock);
+        DkSamplerDescriptor desc;
+        dk_build_sampler_descriptor(key, &desc);
+        memcpy(&heap[key], &desc, sizeof(DkSamplerDescriptor));
+        dk->sampler_cache_valid[key] = true;
+        dk->descriptors_dirty = true;
+    }
+    return key;
+}
+
 /* ============================================================================
  * Texture Binding for Sampling
  * ============================================================================ */
 
 void dk_bind_texture(sgl_backend_t *be, GLuint unit, sgl_handle_t handle) {
     dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_texture_t *tex = dk_texture_rw(dk, handle);
 
-    if (handle == 0 || handle >= SGL_MAX_TEXTURES || !dk->texture_initialized[handle]) {
+    /* A texture without a record is not bound; one whose handle did not
+     * fit in the descriptor heap was never published */
+    if (handle == 0 || !tex || !tex->initialized || handle >= dk->image_descriptor_capacity ||
+        unit >= SGL_MAX_TEXTURE_UNITS) {
         return;
     }
 
     /* Skip binding incomplete cubemaps (not all 6 faces uploaded yet).
-     * The descriptor is only created after all 6 faces, so binding an
-     * incomplete cubemap would push an uninitialized descriptor. */
-    if (dk->texture_is_cubemap[handle] && dk->cubemap_face_mask[handle] != 0x3F) {
+     * The descriptor is only published after all 6 faces, so binding an
+     * incomplete cubemap would reference an unwritten heap slot. */
+    if (tex->is_cubemap && tex->cubemap_face_mask != 0x3F) {
         SGL_TRACE_TEXTURE("bind_texture: skipping incomplete cubemap handle=%u (mask=0x%02X)",
-                          handle, dk->cubemap_face_mask[handle]);
+                          handle, tex->cubemap_face_mask);
         return;
     }
 
-    /* Insert barrier if this texture was used as a render target (FBO)
-     * or if it's a freshly-completed cubemap needing L2 cache coherency.
-     * This avoids expensive full barriers on every texture bind when sampling
-     * normal textures that were never rendered to. */
-    if (dk->texture_used_as_rt[handle] || dk->cubemap_needs_barrier[handle]) {
-        dkCmdBufBarrier(dk->cmdbuf, DkBarrier_Full,
-                        DkInvalidateFlags_Image | DkInvalidateFlags_Descriptors | DkInvalidateFlags_L2Cache);
-        dk->texture_used_as_rt[handle] = false;
-        dk->cubemap_needs_barrier[handle] = false;
+    /* Residency is only valid for the command buffer it was recorded into */
+    dk_stream_t *s = dk_stream(dk);
+    if (s->unit_residency_generation != s->state_generation) {
+        dk_texture_reset_residency(s);
     }
 
-    /* Bind descriptor block if not already done */
-    if (!dk->descriptors_bound) {
-        dkCmdBufBindImageDescriptorSet(dk->cmdbuf, dk->image_descriptor_addr, SGL_MAX_TEXTURES);
-        dkCmdBufBindSamplerDescriptorSet(dk->cmdbuf, dk->sampler_descriptor_addr, SGL_MAX_TEXTURES);
-        dk->descriptors_bound = true;
-    }
-
-    /* CRITICAL FIX: Push descriptors at UNIT index, not handle index!
-     * The shader samples from descriptor[unit], so we must place the texture's
-     * descriptor at that slot. Previously we were pushing at descriptor[handle]
-     * which meant sampling from wrong descriptor when unit != handle. */
-
-    /* Push image descriptor at UNIT position */
-    DkGpuAddr imgDescAddr = dk->image_descriptor_addr + unit * sizeof(DkImageDescriptor);
-    dkCmdBufPushData(dk->cmdbuf, imgDescAddr, &dk->texture_descriptors[handle], sizeof(DkImageDescriptor));
-
-    /* Create and push sampler descriptor at UNIT position using stored parameters */
-    DkSamplerDescriptor samplerDesc;
-    DkSampler sampler;
-    dkSamplerDefaults(&sampler);
+    /* Recorders leave hazards to the barriers dk_submit_recorders puts
+     * around their command lists */
+    if (!s->is_recorder) {
+        /* Uploads (or a freshly-completed cubemap) need L2 cache coherency before
+         * any sampling; this barrier covers every upload recorded so far */
+        if (tex->cubemap_needs_barrier || __atomic_load_n(&dk->upload_barrier_pending, __ATOMIC_ACQUIRE)) {
+            dk_barrier(dk, DkBarrier_Full,
+                       DkInvalidateFlags_Image | DkInvalidateFlags_Descriptors | DkInvalidateFlags_L2Cache);
+            tex->cubemap_needs_barrier = false;
+        }
 
-    /* Convert GL min filter to deko3d (minFilter + mipFilter) */
-    switch (dk->texture_min_filter[handle]) {
-        case GL_NEAREST:
-            sampler.minFilter = DkFilter_Nearest;
-            sampler.mipFilter = DkMipFilter_None;
-            break;
-        case GL_LINEAR:
-            sampler.minFilter = DkFilter_Linear;
-            sampler.mipFilter = DkMipFilter_None;
-            break;
-        case GL_NEAREST_MIPMAP_NEAREST:
-            sampler.minFilter = DkFilter_Nearest;
-            sampler.mipFilter = DkMipFilter_Nearest;
-            break;
-        case GL_NEAREST_MIPMAP_LINEAR:
-            sampler.minFilter = DkFilter_Nearest;
-            sampler.mipFilter = DkMipFilter_Linear;
-            break;
-        case GL_LINEAR_MIPMAP_NEAREST:
-            sampler.minFilter = DkFilter_Linear;
-            sampler.mipFilter = DkMipFilter_Nearest;
-            break;
-        case GL_LINEAR_MIPMAP_LINEAR:
-        default:
-            sampler.minFilter = DkFilter_Linear;
-            sampler.mipFilter = DkMipFilter_Linear;
-            break;
+        /* Only textures written by the GPU since the last matching barrier
+         * (render targets, copies) need one before sampling */
+        dk_hazard_before_sample(dk, handle);
     }
 
-    /* Convert GL mag filter to deko3d */
-    switch (dk->texture_mag_filter[handle]) {
-        case GL_NEAREST:
-            sampler.magFilter = DkFilter_Nearest;
-            break;
-        case GL_LINEAR:
-        default:
-            sampler.magFilter = DkFilter_Linear;
-            break;
+    /* Bind descriptor block if not already done, or if an upload thread grew
+     * it (command lists use whatever the main cmdbuf binds at the call) */
+    if (!s->descriptors_bound || (s->descriptor_capacity != dk->image_descriptor_capacity && !s->cmdlist)) {
+        dkCmdBufBindImageDescriptorSet(s->cmdbuf, dk->image_descriptor_addr, dk->image_descriptor_capacity);
+        dkCmdBufBindSamplerDescriptorSet(s->cmdbuf, dk->sampler_descriptor_addr, DK_SAMPLER_CACHE_SIZE);
+        s->descriptors_bound = true;
+        s->descriptor_capacity = dk->image_descriptor_capacity;
+        s->stats.descriptor_binds++;
     }
 
-    /* Convert GL wrap modes to deko3d */
-    switch (dk->texture_wrap_s[handle]) {
-        case GL_REPEAT:
-            sampler.wrapMode[0] = DkWrapMode_Repeat;
-            break;
-        case GL_MIRRORED_REPEAT:
-            sampler.wrapMode[0] = DkWrapMode_MirroredRepeat;
-            break;
-        case GL_CLAMP_TO_EDGE:
-        default:
-            sampler.wrapMode[0] = DkWrapMode_ClampToEdge;
-            break;
-    }
+    /* Descriptors live in a persistent heap: image slot = texture handle,
+     * sampler slot = sampler key. Nothing is copied into the command stream. */
+    uint8_t key = dk_texture_sampler_key(dk, tex);
+    tex->descriptor_in_use = true;
 
-    switch (dk->texture_wrap_t[handle]) {
-        case GL_REPEAT:
-            sampler.wrapMode[1] = DkWrapMode_Repeat;
-            break;
-        case GL_MIRRORED_REPEAT:
-            sampler.wrapMode[1] = DkWrapMode_MirroredRepeat;
-            break;
-        case GL_CLAMP_TO_EDGE:
-        default:
-            sampler.wrapMode[1] = DkWrapMode_ClampToEdge;
-            break;
+    /* The heap was written by the CPU since the last bind - drop cached descriptors */
+    if (dk->descriptors_dirty && !s->is_recorder) {
+        dk_barrier(dk, DkBarrier_None, DkInvalidateFlags_Descriptors);
+        dk->descriptors_dirty = false;
     }
-    sampler.wrapMode[2] = DkWrapMode_ClampToEdge;
-
-    dkSamplerDescriptorInitialize(&samplerDesc, &sampler);
-
-    DkGpuAddr sampDescAddr = dk->sampler_descriptor_addr + unit * sizeof(DkSamplerDescriptor);
-    dkCmdBufPushData(dk->cmdbuf, sampDescAddr, &samplerDesc, sizeof(DkSamplerDescriptor));
 
     /* CRITICAL: Bind the texture handle to the fragment shader stage!
      * This tells the shader which image/sampler descriptor indices to use.
-     * The handle combines image descriptor index (unit) and sampler descriptor index (unit). */
-    DkResHandle texHandle = dkMakeTextureHandle(unit, unit);
-    dkCmdBufBindTexture(dk->cmdbuf, DkStage_Fragment, unit, texHandle);
+     * Skipped when the unit already holds the same handle since the last bindShaders. */
+    DkResHandle texHandle = dkMakeTextureHandle(handle, key);
+    uint8_t unit_bit = (uint8_t)(1u << unit);
+    if (!(s->unit_handle_bound_mask & unit_bit) || s->unit_res_handle[unit] != texHandle) {
+        dkCmdBufBindTexture(s->cmdbuf, DkStage_Fragment, unit, texHandle);
+        s->unit_res_handle[unit] = texHandle;
+        s->unit_handle_bound_mask |= unit_bit;
+        s->stats.texture_binds++;
+    }
 
     SGL_TRACE_TEXTURE("bind_texture unit=%u handle=%u", unit, handle);
 }
@@ -666,110 +990,172 @@ void dk_bind_texture(sgl_backend_t *be, GLuint unit, sgl_handle_t handle) {
 
 void dk_generate_mipmap(sgl_backend_t *be, sgl_handle_t handle) {
     dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    const dk_texture_t *tex = dk_texture(dk, handle);
 
-    if (handle == 0 || handle >= SGL_MAX_TEXTURES || !dk->texture_initialized[handle]) {
+    if (handle == 0 || !tex->initialized) {
         return;
     }
 
-    uint32_t width = dk->texture_width[handle];
-    uint32_t height = dk->texture_height[handle];
-    uint32_t mip_levels = dk->texture_mip_levels[handle];
-
-    if (mip_levels <= 1) {
+    /* Cubemaps need every face specified (GL: cube complete) */
+    if (tex->is_cubemap && tex->cubemap_face_mask != DK_CUBEMAP_ALL_FACES) {
         return;
     }
 
-    DkImage *texImage = &dk->textures[handle];
-
-    /* Generate each mip level by blitting from the previous level */
-    uint32_t src_width = width;
-    uint32_t src_height = height;
-
-    for (uint32_t level = 1; level < mip_levels; level++) {
-        uint32_t dst_width = src_width > 1 ? src_width >> 1 : 1;
-        uint32_t dst_height = src_height > 1 ? src_height >> 1 : 1;
-
-        /* Create image views for source (level-1) and destination (level) */
-        DkImageView srcView, dstView;
-        dkImageViewDefaults(&srcView, texImage);
-        srcView.mipLevelOffset = level - 1;
-        srcView.mipLevelCount = 1;
+    if (!dk_texture_ensure_mips(dk, handle)) {
+        return;
+    }
 
-        dkImageViewDefaults(&dstView, texImage);
-        dstView.mipLevelOffset = level;
-        dstView.mipLevelCount = 1;
+    uint32_t mip_levels = tex->mip_levels;
+    uint32_t faces = tex->is_cubemap ? 6 : 1;
 
-        /* Define source and destination rectangles */
-        DkImageRect srcRect = { 0, 0, 0, src_width, src_height, 1 };
-        DkImageRect dstRect = { 0, 0, 0, dst_width, dst_height, 1 };
+    if (mip_levels <= 1) {
+        return;
+    }
 
-        /* Blit with linear filtering for smooth downscaling */
-        dkCmdBufBlitImage(dk->cmdbuf, &srcView, &srcRect, &dstView, &dstRect,
-                          DkBlitFlag_FilterLinear, 0);
+    /* Level 0 may have just been rendered to or uploaded */
+    dk_hazard_before_copy(dk, handle);
 
-        /* Add barrier between mip levels to ensure proper synchronization
-         * The previous blit must complete before the next level reads from it */
-        dkCmdBufBarrier(dk->cmdbuf, DkBarrier_Full, DkInvalidateFlags_Image | DkInvalidateFlags_L2Cache);
+    /* Each level is blitted from the previous one, all faces in one batch.
+     * The 2D engine reads and writes through L2 and bypasses the texture
+     * cache, so levels only need the previous blits to finish, not a cache
+     * invalidate; the sampler's barrier comes once, at the next bind. */
+    for (uint32_t level = 1; level < mip_levels; level++) {
+        DkImageRect srcRect = { 0, 0, 0, dk_mip_dim(tex->width, level - 1),
+                                dk_mip_dim(tex->height, level - 1), 1 };
+        DkImageRect dstRect = { 0, 0, 0, dk_mip_dim(tex->width, level),
+                                dk_mip_dim(tex->height, level), 1 };
+
+        for (uint32_t face = 0; face < faces; face++) {
+            DkImageView srcView, dstView;
+            dk_mip_face_view(&srcView, &tex->image, tex, face, level - 1);
+            dk_mip_face_view(&dstView, &tex->image, tex, face, level);
+
+            /* A 2:1 linear blit averages each 2x2 block (box filter) */
+            dkCmdBufBlitImage(dk_transfer_cmdbuf(dk, handle, true), &srcView, &srcRect, &dstView, &dstRect,
+                              DkBlitFlag_FilterLinear, 0);
+        }
 
-        src_width = dst_width;
-        src_height = dst_height;
+        if (level + 1 < mip_levels) {
+            dk_barrier(dk, DkBarrier_Full, 0);
+        }
     }
 
-    /* Final barrier to ensure all mipmap generation is complete before sampling */
-    dkCmdBufBarrier(dk->cmdbuf, DkBarrier_Full, DkInvalidateFlags_Image | DkInvalidateFlags_L2Cache);
+    /* The barrier before sampling is deferred to the next bind of this texture */
+    dk_hazard_transfer_write(dk, handle);
 
-    SGL_TRACE_TEXTURE("generate_mipmap handle=%u levels=%u", handle, mip_levels);
+    SGL_TRACE_TEXTURE("generate_mipmap handle=%u levels=%u faces=%u", handle, mip_levels, faces);
 }
 
 /* ============================================================================
- * Copy Framebuffer to Texture (glCopyTexImage2D)
+ * Copy Framebuffer to Texture (glCopyTexImage2D / glCopyTexSubImage2D)
  *
- * Based on GLOVE (GL Over Vulkan) pattern: GPU → CPU → GPU.
- * 1. Finish() — submit all pending rendering, wait for GPU idle
- * 2. ReadBack — CopyImageToBuffer to CPU-accessible memory (like glReadPixels)
- * 3. Upload — CPU pixels to staging, CopyBufferToImage (like glTexImage2D)
+ * The 2D engine blits the region straight from the render target into the
+ * texture, recorded with the rest of the frame:
+ * 1. dk_hazard_before_read() - Full barrier if the source has pending renders
+ * 2. BlitImage with FlipY - storage row 0 of a render target is the top of
+ *    the screen, texture row 0 is GL y=0 (same as glTexImage2D uploads)
+ * 3. dk_hazard_transfer_write() - the Full + L2 barrier the sampler needs is
+ *    deferred to the next bind of the texture
  *
- * Both readback and upload are individually proven operations in SwitchGLES.
- * Previous attempts using direct GPU→GPU copies (BlitImage, DMA copy) all
- * failed with white textures. The CPU roundtrip avoids GPU copy issues.
+ * Copies the 2D engine cannot do (format conversion, region outside the
+ * source, copies from the texture into itself) take the CPU path: drain the
+ * queue, read back, flip rows on the CPU and upload. Building with
+ * SGL_COPY_TEX_CPU forces the CPU path for every copy.
  * ============================================================================ */
 
-void dk_copy_tex_image_2d(sgl_backend_t *be, sgl_handle_t handle,
-                          GLenum target, GLint level, GLenum internalformat,
-                          GLint x, GLint y, GLsizei width, GLsizei height) {
-    (void)target;
-    (void)level;
-    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
-
-    if (handle == 0 || handle >= SGL_MAX_TEXTURES) return;
-    if (width <= 0 || height <= 0) return;
-
-    /* Get current render target - check FBO binding (like dk_read_pixels) */
-    DkImage *srcImage = NULL;
-    uint32_t src_height;
-    if (dk->current_fbo != 0 && dk->current_fbo_color > 0 &&
-        dk->current_fbo_color < SGL_MAX_TEXTURES &&
-        dk->texture_initialized[dk->current_fbo_color]) {
-        srcImage = &dk->textures[dk->current_fbo_color];
-        src_height = dk->texture_height[dk->current_fbo_color];
-    } else if (dk->framebuffers) {
-        srcImage = &dk->framebuffers[dk->current_slot];
-        src_height = dk->fb_height;
+/*
+ * Resolve the current read framebuffer (like dk_read_pixels). The default
+ * framebuffer is read at the surface size. Returns NULL when nothing is bound.
+ */
+static const DkImage *dk_copy_source(dk_backend_data_t *dk, sgl_handle_t *src_handle,
+                               uint32_t *src_width, uint32_t *src_height) {
+    const dk_texture_t *color = dk_texture(dk, dk->current_fbo_color);
+    if (dk->current_fbo != 0 && dk->current_fbo_color > 0 && color->initialized) {
+        *src_handle = dk->current_fbo_color;
+        *src_width = color->width;
+        *src_height = color->height;
+        return &color->image;
     }
-    if (!srcImage) {
-        SGL_ERROR_BACKEND("copy_tex_image_2d: no framebuffer");
-        return;
+    if (dk->framebuffers) {
+        *src_handle = 0;
+        *src_width = dk->fb_width;
+        *src_height = dk->fb_height;
+        return dk_resolution_read_image(dk);
+    }
+    return NULL;
+}
+
+/*
+ * Check whether a copy can run on the 2D engine. The render targets are
+ * RGBA8, so the destination must be RGBA8 as well.
+ */
+static bool dk_copy_use_blit(dk_backend_data_t *dk, sgl_handle_t handle, sgl_handle_t src_handle,
+                             DkImageFormat dst_format, uint32_t src_width, uint32_t src_height,
+                             GLint x, GLint y, GLsizei width, GLsizei height) {
+#ifdef SGL_COPY_TEX_CPU
+    (void)dk; (void)handle; (void)src_handle; (void)dst_format;
+    (void)src_width; (void)src_height; (void)x; (void)y; (void)width; (void)height;
+    return false;
+#else
+    DkImageFormat src_format = src_handle ? dk_texture(dk, src_handle)->format : DkImageFormat_RGBA8_Unorm;
+    if (src_format != DkImageFormat_RGBA8_Unorm || dst_format != DkImageFormat_RGBA8_Unorm) {
+        return false;
     }
+    if (handle == src_handle) return false;
+    if (x < 0 || y < 0) return false;
+    return (uint32_t)x + (uint32_t)width <= src_width &&
+           (uint32_t)y + (uint32_t)height <= src_height;
+#endif
+}
+
+/*
+ * Blit a framebuffer region into a texture with the Y-flip applied.
+ * Only records commands: the caller publishes the descriptor, and the
+ * sampling barrier follows from dk_hazard_transfer_write().
+ */
+static void dk_copy_blit(dk_backend_data_t *dk, const DkImage *srcImage, uint32_t src_height,
+                         sgl_handle_t handle, GLint xoffset, GLint yoffset,
+                         GLint x, GLint y, GLsizei width, GLsizei height) {
+    const dk_texture_t *tex = dk_texture(dk, handle);
+    /* Source rendering must be done; earlier sampling of the destination too */
+    dk_hazard_before_read(dk);
+    dk_staging_prepare(dk, handle);
+
+    DkImageView srcView, dstView;
+    dkImageViewDefaults(&srcView, srcImage);
+    dkImageViewDefaults(&dstView, &tex->image);
+
+    uint32_t dk_src_y = src_height - (uint32_t)y - (uint32_t)height;
+    DkImageRect srcRect = { (uint32_t)x, dk_src_y, 0, (uint32_t)width, (uint32_t)height, 1 };
+    DkImageRect dstRect = { (uint32_t)xoffset, (uint32_t)yoffset, 0, (uint32_t)width, (uint32_t)height, 1 };
+
+    dkCmdBufBlitImage(dk->main_stream.cmdbuf, &srcView, &srcRect, &dstView, &dstRect,
+                      DkBlitFlag_FlipY | DkBlitFlag_FilterNearest, 0);
+
+    dk_hazard_transfer_write(dk, handle);
+}
+
+/*
+ * CPU path: GPU -> CPU -> GPU (GLOVE pattern).
+ * 1. Finish() - submit all pending rendering, wait for GPU idle
+ * 2. ReadBack - CopyImageToBuffer to CPU-accessible memory (like glReadPixels)
+ * 3. Upload - CPU pixels to staging, CopyBufferToImage (like glTexImage2D)
+ */
+static void dk_copy_tex_image_2d_cpu(dk_backend_data_t *dk, sgl_handle_t handle,
+                                     const DkImage *srcImage, uint32_t src_height,
+                                     GLenum internalformat,
+                                     GLint x, GLint y, GLsizei width, GLsizei height) {
+    dk_texture_t *tex = dk_texture_rw(dk, handle);
+    if (!tex) return;
 
     /* === Step 1: Finish() — submit pending rendering, wait for idle ===
      * GLOVE pattern: rendering MUST be fully completed in a SEPARATE
      * submission before the readback begins. Not just a barrier. */
-    DkCmdList cmdlist = dkCmdBufFinishList(dk->cmdbuf);
-    dkQueueSubmitCommands(dk->queue, cmdlist);
-    dkQueueWaitIdle(dk->queue);
+    DkCmdList cmdlist = dkCmdBufFinishList(dk->main_stream.cmdbuf);
+    dk_queue_submit(dk, cmdlist);
+    dk_wait_idle(dk);
 
-    dkCmdBufClear(dk->cmdbuf);
-    dkCmdBufAddMemory(dk->cmdbuf, dk->cmdbuf_memblock[dk->current_slot], 0, SGL_CMD_MEM_SIZE);
+    dk_reset_cmdbuf(dk);
 
     /* === Step 2: Read framebuffer to CPU-accessible memory ===
      * Same approach as dk_read_pixels (proven to work). */
@@ -790,7 +1176,7 @@ void dk_copy_tex_image_2d(sgl_backend_t *be, sgl_handle_t handle,
     uint32_t dk_src_y = src_height - (uint32_t)y - (uint32_t)height;
 
     /* Readback in a separate command list (GLOVE uses auxiliary command buffer) */
-    dkCmdBufBarrier(dk->cmdbuf, DkBarrier_Full, DkInvalidateFlags_Image);
+    dk_barrier(dk, DkBarrier_Full, DkInvalidateFlags_Image);
 
     DkImageView srcView;
     dkImageViewDefaults(&srcView, srcImage);
@@ -799,11 +1185,11 @@ void dk_copy_tex_image_2d(sgl_backend_t *be, sgl_handle_t handle,
     DkImageRect srcRect = { (uint32_t)x, dk_src_y, 0, (uint32_t)width, (uint32_t)height, 1 };
     DkCopyBuf readbackBuf = { dkMemBlockGetGpuAddr(readbackMem), (uint32_t)(width * 4), (uint32_t)height };
 
-    dkCmdBufCopyImageToBuffer(dk->cmdbuf, &srcView, &srcRect, &readbackBuf, 0);
+    dkCmdBufCopyImageToBuffer(dk->main_stream.cmdbuf, &srcView, &srcRect, &readbackBuf, 0);
 
-    cmdlist = dkCmdBufFinishList(dk->cmdbuf);
-    dkQueueSubmitCommands(dk->queue, cmdlist);
-    dkQueueWaitIdle(dk->queue);
+    cmdlist = dkCmdBufFinishList(dk->main_stream.cmdbuf);
+    dk_queue_submit(dk, cmdlist);
+    dk_wait_idle(dk);
 
     /* === Step 3: Create destination texture === */
     DkImageLayoutMaker layoutMaker;
@@ -818,31 +1204,26 @@ void dk_copy_tex_image_2d(sgl_backend_t *be, sgl_handle_t handle,
     DkImageLayout layout;
     dkImageLayoutInitialize(&layout, &layoutMaker);
 
-    uint64_t texSize = dkImageLayoutGetSize(&layout);
-    uint32_t texAlign = dkImageLayoutGetAlignment(&layout);
-
-    uint32_t aligned_offset = (dk->texture_offset + texAlign - 1) & ~(texAlign - 1);
-    if (aligned_offset + texSize > SGL_TEXTURE_MEM_SIZE) {
+    if (!dk_texture_alloc_storage(dk, handle, &layout)) {
         SGL_ERROR_BACKEND("copy_tex_image_2d: texture memory overflow");
         dkMemBlockDestroy(readbackMem);
         return;
     }
 
-    DkImage *texImage = &dk->textures[handle];
-    dkImageInitialize(texImage, &layout, dk->texture_memblock, aligned_offset);
-    dk->texture_offset = aligned_offset + texSize;
-    dk->texture_initialized[handle] = true;
+    const DkImage *texImage = &tex->image;
+    tex->initialized = true;
 
-    dk->texture_width[handle] = width;
-    dk->texture_height[handle] = height;
-    dk->texture_mip_levels[handle] = 1;
-    dk->texture_format[handle] = layoutMaker.format;
-    dk->texture_gl_format[handle] = (GLenum)internalformat;
+    tex->width = width;
+    tex->height = height;
+    tex->mip_levels = 1;
+    tex->format = layoutMaker.format;
+    tex->gl_format = (GLenum)internalformat;
 
-    dk->texture_min_filter[handle] = GL_NEAREST;
-    dk->texture_mag_filter[handle] = GL_LINEAR;
-    dk->texture_wrap_s[handle] = GL_REPEAT;
-    dk->texture_wrap_t[handle] = GL_REPEAT;
+    tex->min_filter = GL_NEAREST;
+    tex->mag_filter = GL_LINEAR;
+    tex->wrap_s = GL_REPEAT;
+    tex->wrap_t = GL_REPEAT;
+    tex->sampler_key = DK_SAMPLER_KEY_NONE;
 
     /* NOTE: Descriptor creation is DEFERRED to after the pixel upload.
      * This follows the proven pattern from the standalone deko3d test where
@@ -863,15 +1244,14 @@ void dk_copy_tex_image_2d(sgl_backend_t *be, sgl_handle_t handle,
     uint32_t aligned_row_size = SGL_ALIGN_UP((uint32_t)(width * 4), DK_LINEAR_STRIDE_ALIGNMENT);
     uint32_t staging_size = aligned_row_size * height;
 
-    uint32_t stagingOffset = SGL_ALIGN_UP(dk->client_array_offset, DK_LINEAR_STRIDE_ALIGNMENT);
-    if (stagingOffset + staging_size > dk->uniform_base - dk->client_array_base) {
+    dk_staging_t st;
+    if (!dk_staging_begin(dk, staging_size, &st)) {
         SGL_ERROR_BACKEND("copy_tex_image_2d: staging buffer overflow");
         dkMemBlockDestroy(readbackMem);
         return;
     }
 
-    uint8_t *staging = (uint8_t*)dkMemBlockGetCpuAddr(dk->data_memblock)
-                       + dk->client_array_base + stagingOffset;
+    uint8_t *staging = st.cpu;
 
     /* Copy with Y-flip from readback → staging (matching GLOVE's InvertImageYAxis) */
     for (int row = 0; row < height; row++) {
@@ -880,98 +1260,60 @@ void dk_copy_tex_image_2d(sgl_backend_t *be, sgl_handle_t handle,
                row_bytes);
     }
 
-    dk->client_array_offset = stagingOffset + staging_size;
-
     /* Done with readback buffer */
     dkMemBlockDestroy(readbackMem);
 
     /* === Step 5: Upload staging to texture (same as dk_texture_image_2d) === */
-    dkCmdBufClear(dk->cmdbuf);
-    dkCmdBufAddMemory(dk->cmdbuf, dk->cmdbuf_memblock[dk->current_slot], 0, SGL_CMD_MEM_SIZE);
+    dk_reset_cmdbuf(dk);
 
-    DkGpuAddr stagingAddr = dkMemBlockGetGpuAddr(dk->data_memblock)
-                            + dk->client_array_base + stagingOffset;
-    DkCopyBuf srcBuf = { stagingAddr, aligned_row_size, (uint32_t)height };
+    DkCopyBuf srcBuf = { st.gpu, aligned_row_size, (uint32_t)height };
     DkImageRect dstRect = { 0, 0, 0, (uint32_t)width, (uint32_t)height, 1 };
 
-    dkCmdBufCopyBufferToImage(dk->cmdbuf, &srcBuf, &texView, &dstRect, 0);
+    dkCmdBufCopyBufferToImage(dk->main_stream.cmdbuf, &srcBuf, &texView, &dstRect, 0);
 
-    cmdlist = dkCmdBufFinishList(dk->cmdbuf);
-    dkQueueSubmitCommands(dk->queue, cmdlist);
-    dkQueueWaitIdle(dk->queue);
+    cmdlist = dkCmdBufFinishList(dk->main_stream.cmdbuf);
+    dk_queue_submit(dk, cmdlist);
+    dk_wait_idle(dk);
 
     /* === Step 6: Create descriptor AFTER upload completes ===
      * The standalone deko3d test creates the descriptor after CopyBufferToImage.
      * This ensures the image metadata is fully consistent after the DMA copy.
      * Swizzle was already applied to texView above. */
-    DkImageDescriptor *imgDesc = &dk->texture_descriptors[handle];
+    DkImageDescriptor *imgDesc = &tex->descriptor;
     dkImageDescriptorInitialize(imgDesc, &texView, false, false);
+    dk_texture_publish_descriptor(dk, handle);
 
     /* CRITICAL: Mark texture as needing L2 cache barrier before first sampling.
      * CopyBufferToImage uses the DMA/2D engine which writes directly to DRAM.
      * The 3D engine's texture sampler reads through its own L2 cache.
      * Without invalidation, the sampler may read stale (zero/white) data.
      * The standalone deko3d test proves this barrier is required. */
-    dk->texture_used_as_rt[handle] = true;
+    dk_hazard_transfer_write(dk, handle);
 
     /* === Step 7: Restore command buffer state === */
-    dkCmdBufClear(dk->cmdbuf);
-    dkCmdBufAddMemory(dk->cmdbuf, dk->cmdbuf_memblock[dk->current_slot], 0, SGL_CMD_MEM_SIZE);
-    dk->descriptors_bound = false;
+    dk_reset_cmdbuf(dk);
 
     dk_rebind_render_target(dk);
 
     SGL_TRACE_TEXTURE("copy_tex_image_2d handle=%u (%d,%d) %dx%d", handle, x, y, width, height);
 }
 
-/* ============================================================================
- * Copy Framebuffer to Texture Sub-Region (glCopyTexSubImage2D)
- *
- * Same GPU → CPU → GPU approach as CopyTexImage2D (GLOVE pattern).
- * Writes to a sub-region of an existing texture.
- * ============================================================================ */
-
-void dk_copy_tex_sub_image_2d(sgl_backend_t *be, sgl_handle_t handle,
-                              GLenum target, GLint level,
-                              GLint xoffset, GLint yoffset,
-                              GLint x, GLint y, GLsizei width, GLsizei height) {
-    (void)target;
-    (void)level;
-    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
-
-    if (handle == 0 || handle >= SGL_MAX_TEXTURES) return;
-    if (!dk->texture_initialized[handle]) {
-        SGL_ERROR_BACKEND("copy_tex_sub_image_2d: texture %u not initialized", handle);
-        return;
-    }
-    if (width <= 0 || height <= 0) return;
-
-    /* Get current render target - check FBO binding (like dk_read_pixels) */
-    DkImage *srcImage = NULL;
-    uint32_t src_height;
-    if (dk->current_fbo != 0 && dk->current_fbo_color > 0 &&
-        dk->current_fbo_color < SGL_MAX_TEXTURES &&
-        dk->texture_initialized[dk->current_fbo_color]) {
-        srcImage = &dk->textures[dk->current_fbo_color];
-        src_height = dk->texture_height[dk->current_fbo_color];
-    } else if (dk->framebuffers) {
-        srcImage = &dk->framebuffers[dk->current_slot];
-        src_height = dk->fb_height;
-    }
-    if (!srcImage) {
-        SGL_ERROR_BACKEND("copy_tex_sub_image_2d: no framebuffer");
-        return;
-    }
+/* CPU path for glCopyTexSubImage2D, same GPU -> CPU -> GPU approach */
+static void dk_copy_tex_sub_image_2d_cpu(dk_backend_data_t *dk, sgl_handle_t handle,
+                                         const DkImage *srcImage, uint32_t src_height,
+                                         GLint xoffset, GLint yoffset,
+                                         GLint x, GLint y, GLsizei width, GLsizei height) {
+    dk_texture_t *tex = dk_texture_rw(dk, handle);
+    if (!tex) return;
 
-    DkImage *texImage = &dk->textures[handle];
+    const DkImage *texImage = &tex->image;
 
     /* === Step 1: Finish() — submit pending rendering, wait for idle === */
-    DkCmdList cmdlist = dkCmdBufFinishList(dk->cmdbuf);
-    dkQueueSubmitCommands(dk->queue, cmdlist);
-    dkQueueWaitIdle(dk->queue);
+    DkCmdList cmdlist = dkCmdBufFinishList(dk->main_stream.cmdbuf);
+    dk_queue_submit(dk, cmdlist);
+    dk_wait_idle(dk);
 
-    dkCmdBufClear(dk->cmdbuf);
-    dkCmdBufAddMemory(dk->cmdbuf, dk->cmdbuf_memblock[dk->current_slot], 0, SGL_CMD_MEM_SIZE);
+    dk_reset_cmdbuf(dk);
 
     /* === Step 2: Read framebuffer to CPU-accessible memory === */
     size_t pixelBufSize = (size_t)width * (size_t)height * 4;
@@ -989,7 +1331,7 @@ void dk_copy_tex_sub_image_2d(sgl_backend_t *be, sgl_handle_t handle,
 
     uint32_t dk_src_y = src_height - (uint32_t)y - (uint32_t)height;
 
-    dkCmdBufBarrier(dk->cmdbuf, DkBarrier_Full, DkInvalidateFlags_Image);
+    dk_barrier(dk, DkBarrier_Full, DkInvalidateFlags_Image);
 
     DkImageView srcView;
     dkImageViewDefaults(&srcView, srcImage);
@@ -997,74 +1339,73 @@ void dk_copy_tex_sub_image_2d(sgl_backend_t *be, sgl_handle_t handle,
     DkImageRect srcRect = { (uint32_t)x, dk_src_y, 0, (uint32_t)width, (uint32_t)height, 1 };
     DkCopyBuf readbackBuf = { dkMemBlockGetGpuAddr(readbackMem), (uint32_t)(width * 4), (uint32_t)height };
 
-    dkCmdBufCopyImageToBuffer(dk->cmdbuf, &srcView, &srcRect, &readbackBuf, 0);
+    dkCmdBufCopyImageToBuffer(dk->main_stream.cmdbuf, &srcView, &srcRect, &readbackBuf, 0);
 
-    cmdlist = dkCmdBufFinishList(dk->cmdbuf);
-    dkQueueSubmitCommands(dk->queue, cmdlist);
-    dkQueueWaitIdle(dk->queue);
+    cmdlist = dkCmdBufFinishList(dk->main_stream.cmdbuf);
+    dk_queue_submit(dk, cmdlist);
+    dk_wait_idle(dk);
 
-    /* === Step 3: CPU Y-flip from readback to staging === */
+    /* === Step 3: CPU Y-flip from readback to staging, packing into 16-bit textures === */
     uint8_t *gpuData = (uint8_t *)dkMemBlockGetCpuAddr(readbackMem);
     size_t row_bytes = (size_t)width * 4;
+    GLenum packed = dk_packed16_type(tex->format);
+    uint32_t dst_bpp = packed ? 2 : 4;
 
-    uint32_t aligned_row_size = SGL_ALIGN_UP((uint32_t)(width * 4), DK_LINEAR_STRIDE_ALIGNMENT);
+    uint32_t aligned_row_size = SGL_ALIGN_UP((uint32_t)width * dst_bpp, DK_LINEAR_STRIDE_ALIGNMENT);
     uint32_t staging_size = aligned_row_size * height;
 
-    uint32_t stagingOffset = SGL_ALIGN_UP(dk->client_array_offset, DK_LINEAR_STRIDE_ALIGNMENT);
-    if (stagingOffset + staging_size > dk->uniform_base - dk->client_array_base) {
+    dk_staging_t st;
+    if (!dk_staging_begin(dk, staging_size, &st)) {
         SGL_ERROR_BACKEND("copy_tex_sub_image_2d: staging buffer overflow");
         dkMemBlockDestroy(readbackMem);
         return;
     }
 
-    uint8_t *staging = (uint8_t*)dkMemBlockGetCpuAddr(dk->data_memblock)
-                       + dk->client_array_base + stagingOffset;
+    uint8_t *staging = st.cpu;
 
     for (int row = 0; row < height; row++) {
-        memcpy(staging + row * aligned_row_size,
-               gpuData + (height - 1 - row) * row_bytes,
-               row_bytes);
+        const uint8_t *src_row = gpuData + (height - 1 - row) * row_bytes;
+        if (packed) {
+            sgl_pixel_pack_rgba8(staging + row * aligned_row_size, src_row, (uint32_t)width, packed);
+        } else {
+            memcpy(staging + row * aligned_row_size, src_row, row_bytes);
+        }
     }
 
-    dk->client_array_offset = stagingOffset + staging_size;
     dkMemBlockDestroy(readbackMem);
 
     /* === Step 4: Upload staging to texture sub-region === */
-    dkCmdBufClear(dk->cmdbuf);
-    dkCmdBufAddMemory(dk->cmdbuf, dk->cmdbuf_memblock[dk->current_slot], 0, SGL_CMD_MEM_SIZE);
+    dk_reset_cmdbuf(dk);
 
     DkImageView dstView;
     dkImageViewDefaults(&dstView, texImage);
 
     /* Destination Y: GL yoffset maps directly to storage row
      * (same convention as glTexSubImage2D upload) */
-    DkGpuAddr stagingAddr = dkMemBlockGetGpuAddr(dk->data_memblock)
-                            + dk->client_array_base + stagingOffset;
-    DkCopyBuf srcBuf = { stagingAddr, aligned_row_size, (uint32_t)height };
+    DkCopyBuf srcBuf = { st.gpu, aligned_row_size, (uint32_t)height };
     DkImageRect dstRect = { (uint32_t)xoffset, (uint32_t)yoffset, 0, (uint32_t)width, (uint32_t)height, 1 };
 
-    dkCmdBufCopyBufferToImage(dk->cmdbuf, &srcBuf, &dstView, &dstRect, 0);
+    dkCmdBufCopyBufferToImage(dk->main_stream.cmdbuf, &srcBuf, &dstView, &dstRect, 0);
 
-    cmdlist = dkCmdBufFinishList(dk->cmdbuf);
-    dkQueueSubmitCommands(dk->queue, cmdlist);
-    dkQueueWaitIdle(dk->queue);
+    cmdlist = dkCmdBufFinishList(dk->main_stream.cmdbuf);
+    dk_queue_submit(dk, cmdlist);
+    dk_wait_idle(dk);
 
     /* CRITICAL: Mark texture as needing L2 cache barrier before next sampling.
      * Same reason as CopyTexImage2D: DMA writes bypass the 3D engine's L2 cache.
      * Also recreate the descriptor to ensure consistency after the DMA copy. */
-    dk->texture_used_as_rt[handle] = true;
+    dk_hazard_transfer_write(dk, handle);
 
     /* Refresh descriptor after sub-image update (preserve swizzle) */
     DkImageView updatedView;
     dkImageViewDefaults(&updatedView, texImage);
-    dk_apply_format_swizzle(&updatedView, dk->texture_gl_format[handle]);
-    DkImageDescriptor *imgDesc = &dk->texture_descriptors[handle];
+    dk_apply_format_swizzle(&updatedView, tex->gl_format);
+    DkImageDescriptor *imgDesc = &tex->descriptor;
     dkImageDescriptorInitialize(imgDesc, &updatedView, false, false);
+    dk_texture_publish_descriptor(dk, handle);
 
     /* === Step 5: Restore command buffer state === */
-    dkCmdBufClear(dk->cmdbuf);
-    dkCmdBufAddMemory(dk->cmdbuf, dk->cmdbuf_memblock[dk->current_slot], 0, SGL_CMD_MEM_SIZE);
-    dk->descriptors_bound = false;
+    dk_reset_cmdbuf(dk);
 
     dk_rebind_render_target(dk);
 
@@ -1072,6 +1413,110 @@ void dk_copy_tex_sub_image_2d(sgl_backend_t *be, sgl_handle_t handle,
                       handle, x, y, xoffset, yoffset, width, height);
 }
 
+void dk_copy_tex_image_2d(sgl_backend_t *be, sgl_handle_t handle,
+                          GLenum target, GLint level, GLenum internalformat,
+                          GLint x, GLint y, GLsizei width, GLsizei height) {
+    (void)target;
+    (void)level;
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+
+    dk_texture_t *tex = handle ? (dk_texture_t *)sgl_table_ensure(&dk->textures, handle) : NULL;
+    if (!tex) return;
+    if (width <= 0 || height <= 0) return;
+
+    sgl_handle_t src_handle;
+    uint32_t src_width, src_height;
+    const DkImage *srcImage = dk_copy_source(dk, &src_handle, &src_width, &src_height);
+    if (!srcImage) {
+        SGL_ERROR_BACKEND("copy_tex_image_2d: no framebuffer");
+        return;
+    }
+
+    DkImageFormat format = dk_convert_format(internalformat, GL_RGBA, GL_UNSIGNED_BYTE);
+    if (!dk_copy_use_blit(dk, handle, src_handle, format, src_width, src_height, x, y, width, height)) {
+        dk_copy_tex_image_2d_cpu(dk, handle, srcImage, src_height, internalformat, x, y, width, height);
+        return;
+    }
+
+    DkImageLayoutMaker layoutMaker;
+    dkImageLayoutMakerDefaults(&layoutMaker, dk->device);
+    layoutMaker.flags = DkImageFlags_UsageRender | DkImageFlags_Usage2DEngine;
+    layoutMaker.format = format;
+    layoutMaker.dimensions[0] = width;
+    layoutMaker.dimensions[1] = height;
+    layoutMaker.dimensions[2] = 1;
+    layoutMaker.mipLevels = 1;
+
+    DkImageLayout layout;
+    dkImageLayoutInitialize(&layout, &layoutMaker);
+
+    if (!dk_texture_alloc_storage(dk, handle, &layout)) {
+        SGL_ERROR_BACKEND("copy_tex_image_2d: texture memory overflow");
+        return;
+    }
+
+    tex->initialized = true;
+    tex->width = width;
+    tex->height = height;
+    tex->mip_levels = 1;
+    tex->format = format;
+    tex->gl_format = (GLenum)internalformat;
+
+    tex->min_filter = GL_NEAREST;
+    tex->mag_filter = GL_LINEAR;
+    tex->wrap_s = GL_REPEAT;
+    tex->wrap_t = GL_REPEAT;
+    tex->sampler_key = DK_SAMPLER_KEY_NONE;
+
+    dk_copy_blit(dk, srcImage, src_height, handle, 0, 0, x, y, width, height);
+
+    DkImageView texView;
+    dkImageViewDefaults(&texView, &tex->image);
+    dk_apply_format_swizzle(&texView, internalformat);
+    dkImageDescriptorInitialize(&tex->descriptor, &texView, false, false);
+    dk_texture_publish_descriptor(dk, handle);
+
+    SGL_TRACE_TEXTURE("copy_tex_image_2d handle=%u (%d,%d) %dx%d blit", handle, x, y, width, height);
+}
+
+void dk_copy_tex_sub_image_2d(sgl_backend_t *be, sgl_handle_t handle,
+                              GLenum target, GLint level,
+                              GLint xoffset, GLint yoffset,
+                              GLint x, GLint y, GLsizei width, GLsizei height) {
+    (void)target;
+    (void)level;
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+
+    dk_texture_t *tex = handle ? (dk_texture_t *)sgl_table_ensure(&dk->textures, handle) : NULL;
+    if (!tex) return;
+    if (!tex->initialized) {
+        SGL_ERROR_BACKEND("copy_tex_sub_image_2d: texture %u not initialized", handle);
+        return;
+    }
+    if (width <= 0 || height <= 0) return;
+
+    sgl_handle_t src_handle;
+    uint32_t src_width, src_height;
+    const DkImage *srcImage = dk_copy_source(dk, &src_handle, &src_width, &src_height);
+    if (!srcImage) {
+        SGL_ERROR_BACKEND("copy_tex_sub_image_2d: no framebuffer");
+        return;
+    }
+
+    if (!dk_copy_use_blit(dk, handle, src_handle, tex->format,
+                          src_width, src_height, x, y, width, height)) {
+        dk_copy_tex_sub_image_2d_cpu(dk, handle, srcImage, src_height,
+                                     xoffset, yoffset, x, y, width, height);
+        return;
+    }
+
+    /* Storage and descriptor are unchanged, only the texels */
+    dk_copy_blit(dk, srcImage, src_height, handle, xoffset, yoffset, x, y, width, height);
+
+    SGL_TRACE_TEXTURE("copy_tex_sub_image_2d handle=%u fb(%d,%d)->tex(%d,%d) %dx%d blit",
+                      handle, x, y, xoffset, yoffset, width, height);
+}
+
 /* ============================================================================
  * Compressed Texture Operations
  * ============================================================================ */
@@ -1100,7 +1545,8 @@ void dk_compressed_texture_image_2d(sgl_backend_t *be, sgl_handle_t handle,
     (void)level;
     dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
 
-    if (handle == 0 || handle >= SGL_MAX_TEXTURES) return;
+    dk_texture_t *tex = handle ? (dk_texture_t *)sgl_table_ensure(&dk->textures, handle) : NULL;
+    if (!tex) return;
 
     /* Convert GL compressed format to deko3d format */
     DkImageFormat dkFormat = dk_convert_compressed_format(internalformat);
@@ -1123,48 +1569,33 @@ void dk_compressed_texture_image_2d(sgl_backend_t *be, sgl_handle_t handle,
     DkImageLayout layout;
     dkImageLayoutInitialize(&layout, &layoutMaker);
 
-    uint32_t imageAlign = dkImageLayoutGetAlignment(&layout);
-    uint32_t imageSize_layout = dkImageLayoutGetSize(&layout);
-
-    /* Align texture offset */
-    dk->texture_offset = (dk->texture_offset + imageAlign - 1) & ~(imageAlign - 1);
-
-    /* Check memory availability */
-    if (dk->texture_offset + imageSize_layout > SGL_TEXTURE_MEM_SIZE) {
-        SGL_ERROR_TEXTURE("Compressed texture memory exhausted (need %u, have %u)",
-                         imageSize_layout, SGL_TEXTURE_MEM_SIZE - dk->texture_offset);
+    /* Create image */
+    if (!dk_texture_alloc_storage(dk, handle, &layout)) {
+        SGL_ERROR_TEXTURE("Compressed texture memory exhausted (need %u bytes)",
+                          (uint32_t)dkImageLayoutGetSize(&layout));
         return;
     }
-
-    /* Create image */
-    DkImage *texImage = &dk->textures[handle];
-    dkImageInitialize(texImage, &layout, dk->texture_memblock, dk->texture_offset);
-    dk->texture_offset += imageSize_layout;
+    const DkImage *texImage = &tex->image;
 
     /* Upload compressed data if provided */
     if (data && imageSize > 0) {
-        /* Use client array region as staging (NOT offset 0 which overwrites VBOs!) */
-        uint32_t stagingOffset = SGL_ALIGN_UP(dk->client_array_offset, DK_LINEAR_STRIDE_ALIGNMENT);
-        if (stagingOffset + (uint32_t)imageSize <= dk->uniform_base - dk->client_array_base) {
-            uint8_t *staging = (uint8_t*)dkMemBlockGetCpuAddr(dk->data_memblock)
-                               + dk->client_array_base + stagingOffset;
-
+        dk_staging_t st;
+        if (dk_staging_begin(dk, (uint32_t)imageSize, &st)) {
             /* Copy compressed data to staging */
-            memcpy(staging, data, imageSize);
-            dk->client_array_offset = stagingOffset + (uint32_t)imageSize;
+            memcpy(st.cpu, data, imageSize);
 
             /* Copy from staging to texture */
             DkImageView dstView;
             dkImageViewDefaults(&dstView, texImage);
 
             DkCopyBuf srcBuf;
-            srcBuf.addr = dkMemBlockGetGpuAddr(dk->data_memblock)
-                          + dk->client_array_base + stagingOffset;
+            srcBuf.addr = st.gpu;
             srcBuf.rowLength = 0;  /* Tightly packed */
             srcBuf.imageHeight = 0;
 
-            dkCmdBufCopyBufferToImage(dk->cmdbuf, &srcBuf, &dstView, NULL, 0);
-            dkCmdBufBarrier(dk->cmdbuf, DkBarrier_Full, DkInvalidateFlags_Image | DkInvalidateFlags_L2Cache);
+            dk_staging_prepare(dk, handle);
+            dkCmdBufCopyBufferToImage(dk_transfer_cmdbuf(dk, handle, false), &srcBuf, &dstView, NULL, 0);
+            dk_staging_submit(dk);
         } else {
             SGL_ERROR_TEXTURE("Compressed texture staging memory exhausted");
         }
@@ -1173,22 +1604,25 @@ void dk_compressed_texture_image_2d(sgl_backend_t *be, sgl_handle_t handle,
     /* Create image descriptor */
     DkImageView texView;
     dkImageViewDefaults(&texView, texImage);
-    DkImageDescriptor *desc = &dk->texture_descriptors[handle];
+    DkImageDescriptor *desc = &tex->descriptor;
     dkImageDescriptorInitialize(desc, &texView, false, false);
+    dk_texture_publish_descriptor(dk, handle);
 
     /* Store texture info */
-    dk->texture_initialized[handle] = true;
-    dk->texture_is_cubemap[handle] = false;
-    dk->texture_width[handle] = width;
-    dk->texture_height[handle] = height;
-    dk->texture_format[handle] = dkFormat;
-    dk->texture_mip_levels[handle] = 1;
+    tex->initialized = true;
+    tex->is_cubemap = false;
+    tex->width = width;
+    tex->height = height;
+    tex->format = dkFormat;
+    tex->gl_format = (GLenum)internalformat;
+    tex->mip_levels = 1;
 
     /* Initialize default sampler parameters */
-    dk->texture_min_filter[handle] = GL_NEAREST_MIPMAP_LINEAR;
-    dk->texture_mag_filter[handle] = GL_LINEAR;
-    dk->texture_wrap_s[handle] = GL_REPEAT;
-    dk->texture_wrap_t[handle] = GL_REPEAT;
+    tex->min_filter = GL_NEAREST_MIPMAP_LINEAR;
+    tex->mag_filter = GL_LINEAR;
+    tex->wrap_s = GL_REPEAT;
+    tex->wrap_t = GL_REPEAT;
+    tex->sampler_key = DK_SAMPLER_KEY_NONE;
 
     SGL_TRACE_TEXTURE("compressed_texture_image_2d handle=%u %dx%d format=0x%X size=%d",
                       handle, width, height, internalformat, imageSize);
@@ -1219,31 +1653,26 @@ void dk_compressed_texture_sub_image_2d(sgl_backend_t *be, sgl_handle_t handle,
     (void)format;
     dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
 
-    if (handle == 0 || handle >= SGL_MAX_TEXTURES) return;
-    if (!dk->texture_initialized[handle]) return;
+    dk_texture_t *tex = handle ? (dk_texture_t *)sgl_table_ensure(&dk->textures, handle) : NULL;
+    if (!tex) return;
+    if (!tex->initialized) return;
     if (!data || imageSize <= 0) return;
 
-    DkImage *texImage = &dk->textures[handle];
+    const DkImage *texImage = &tex->image;
 
-    /* Use client array region as staging (NOT offset 0 which overwrites VBOs!) */
-    uint32_t stagingOffset = SGL_ALIGN_UP(dk->client_array_offset, DK_LINEAR_STRIDE_ALIGNMENT);
-    if (stagingOffset + (uint32_t)imageSize > dk->uniform_base - dk->client_array_base) {
+    dk_staging_t st;
+    if (!dk_staging_begin(dk, (uint32_t)imageSize, &st)) {
         SGL_ERROR_TEXTURE("Compressed sub-image staging memory exhausted");
         return;
     }
-
-    uint8_t *staging = (uint8_t*)dkMemBlockGetCpuAddr(dk->data_memblock)
-                       + dk->client_array_base + stagingOffset;
-    memcpy(staging, data, imageSize);
-    dk->client_array_offset = stagingOffset + (uint32_t)imageSize;
+    memcpy(st.cpu, data, imageSize);
 
     /* Copy from staging to texture region */
     DkImageView dstView;
     dkImageViewDefaults(&dstView, texImage);
 
     DkCopyBuf srcBuf;
-    srcBuf.addr = dkMemBlockGetGpuAddr(dk->data_memblock)
-                  + dk->client_array_base + stagingOffset;
+    srcBuf.addr = st.gpu;
     srcBuf.rowLength = 0;
     srcBuf.imageHeight = 0;
 
@@ -1255,9 +1684,260 @@ void dk_compressed_texture_sub_image_2d(sgl_backend_t *be, sgl_handle_t handle,
     dstRect.height = height;
     dstRect.depth = 1;
 
-    dkCmdBufCopyBufferToImage(dk->cmdbuf, &srcBuf, &dstView, &dstRect, 0);
-    dkCmdBufBarrier(dk->cmdbuf, DkBarrier_Full, DkInvalidateFlags_Image | DkInvalidateFlags_L2Cache);
+    dk_staging_prepare(dk, handle);
+    dkCmdBufCopyBufferToImage(dk_transfer_cmdbuf(dk, handle, false), &srcBuf, &dstView, &dstRect, 0);
+    dk_staging_submit(dk);
 
     SGL_TRACE_TEXTURE("compressed_texture_sub_image_2d handle=%u offset(%d,%d) %dx%d size=%d",
                       handle, xoffset, yoffset, width, height, imageSize);
 }
+
+/* ============================================================================
+ * Streamed Compressed Upload (sglTexImageFromFile)
+ *
+ * Level data goes file -> staging ring -> texture without a heap copy:
+ * each chunk of block rows is read straight into staging memory and its
+ * copy recorded. Every DK_TEXTURE_STREAM_SUBMIT bytes the command list is
+ * submitted, so the copy engine works while the next chunks are read.
+ * ============================================================================ */
+
+bool dk_compressed_texture_stream(sgl_backend_t *be, sgl_handle_t handle,
+                                  GLenum internalformat, GLsizei width, GLsizei height,
+                                  GLint levels, sgl_texture_read_fn read, void *user) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+
+    dk_texture_t *tex = handle ? (dk_texture_t *)sgl_table_ensure(&dk->textures, handle) : NULL;
+    if (!tex) return false;
+
+    DkImageFormat dkFormat = dk_convert_compressed_format(internalformat);
+    uint32_t bw, bh, bpb;
+    if (dkFormat == 0 || !sgl_compressed_block_info(internalformat, &bw, &bh, &bpb)) {
+        SGL_ERROR_TEXTURE("Unsupported compressed format 0x%X", internalformat);
+        return false;
+    }
+
+    DkImageLayoutMaker layoutMaker;
+    dkImageLayoutMakerDefaults(&layoutMaker, dk->device);
+    layoutMaker.flags = DkImageFlags_UsageRender | DkImageFlags_Usage2DEngine;
+    layoutMaker.format = dkFormat;
+    layoutMaker.type = DkImageType_2D;
+    layoutMaker.dimensions[0] = width;
+    layoutMaker.dimensions[1] = height;
+    layoutMaker.dimensions[2] = 1;
+    layoutMaker.mipLevels = (uint32_t)levels;
+
+    DkImageLayout layout;
+    dkImageLayoutInitialize(&layout, &layoutMaker);
+
+    if (!dk_texture_alloc_storage(dk, handle, &layout)) {
+        SGL_ERROR_TEXTURE("Compressed texture memory exhausted (need %u bytes)",
+                          (uint32_t)dkImageLayoutGetSize(&layout));
+        return false;
+    }
+
+    /* The storage may have been reused in place */
+    dk_staging_prepare(dk, handle);
+
+    bool ok = true;
+    uint32_t unsubmitted = 0;
+    for (uint32_t level = 0; ok && level < (uint32_t)levels; level++) {
+        uint32_t level_w = dk_mip_dim((uint32_t)width, level);
+        uint32_t level_h = dk_mip_dim((uint32_t)height, level);
+        uint32_t row_bytes = ((level_w + bw - 1) / bw) * bpb;
+        uint32_t block_rows = (level_h + bh - 1) / bh;
+        uint32_t chunk_rows = DK_TEXTURE_STREAM_CHUNK / row_bytes;
+        if (chunk_rows == 0) chunk_rows = 1;
+
+        DkImageView dstView;
+        dkImageViewDefaults(&dstView, &tex->image);
+        dstView.mipLevelOffset = level;
+        dstView.mipLevelCount = 1;
+
+        for (uint32_t row = 0; row < block_rows; row += chunk_rows) {
+            uint32_t rows = block_rows - row < chunk_rows ? block_rows - row : chunk_rows;
+            uint32_t size = rows * row_bytes;
+
+            dk_staging_t st;
+            if (!dk_staging_begin(dk, size, &st)) {
+                SGL_ERROR_TEXTURE("texture stream: staging memory exhausted");
+                ok = false;
+                break;
+            }
+            if (!read(user, (GLint)level, row * row_bytes, st.cpu, size)) {
+                SGL_ERROR_TEXTURE("texture stream: read failed at level %u", level);
+                ok = false;
+                break;
+            }
+
+            /* Block rows map to texel rows; the last chunk ends at the level edge */
+            uint32_t y = row * bh;
+            uint32_t rect_h = rows * bh < level_h - y ? rows * bh : level_h - y;
+            DkCopyBuf srcBuf = { st.gpu, 0, 0 };
+            DkImageRect dstRect = { 0, y, 0, level_w, rect_h, 1 };
+            DkCmdBuf cmdbuf = dk_transfer_cmdbuf(dk, handle, false);
+            dkCmdBufCopyBufferToImage(cmdbuf, &srcBuf, &dstView, &dstRect, 0);
+
+            unsubmitted += size;
+            if (unsubmitted >= DK_TEXTURE_STREAM_SUBMIT) {
+                dk_upload_t *u = dk_upload_current(dk);
+                if (u) dk_upload_flush(dk, u);
+                else if (cmdbuf == dk->transfer.cmdbuf) dk_transfer_submit(dk);
+                else dk_submit_pending(dk);
+                unsubmitted = 0;
+            }
+        }
+    }
+    dk_staging_submit(dk);
+
+    /* Publish even after a short read so the texture stays consistent */
+    DkImageView texView;
+    dkImageViewDefaults(&texView, &tex->image);
+    dkImageDescriptorInitialize(&tex->descriptor, &texView, false, false);
+    dk_texture_publish_descriptor(dk, handle);
+
+    tex->initialized = true;
+    tex->is_cubemap = false;
+    tex->width = (uint32_t)width;
+    tex->height = (uint32_t)height;
+    tex->format = dkFormat;
+    tex->gl_format = internalformat;
+    tex->mip_levels = (uint32_t)levels;
+
+    tex->min_filter = GL_NEAREST_MIPMAP_LINEAR;
+    tex->mag_filter = GL_LINEAR;
+    tex->wrap_s = GL_REPEAT;
+    tex->wrap_t = GL_REPEAT;
+    tex->sampler_key = DK_SAMPLER_KEY_NONE;
+
+    SGL_TRACE_TEXTURE("compressed_texture_stream handle=%u %dx%d format=0x%X levels=%d ok=%d",
+                      handle, width, height, internalformat, levels, ok);
+    return ok;
+}
+
+/* ============================================================================
+ * Texture Deletion (glDeleteTextures)
+ * ============================================================================ */
+
+void dk_delete_texture(sgl_backend_t *be, sgl_handle_t handle) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+
+    dk_texture_t *tex = (dk_texture_t *)sgl_table_get(&dk->textures, handle);
+    if (handle == 0 || !tex) return;
+
+    /* Frames in flight may still sample the image - free after the fence */
+    if (tex->mem_size > 0) {
+        dk_defer_free(dk, &dk->texture_heap, tex->mem_offset, tex->mem_size);
+        tex->mem_size = 0;
+        tex->mem_offset = 0;
+    }
+
+    tex->initialized = false;
+    tex->is_cubemap = false;
+    dk_hazard_forget(dk, handle);
+    tex->cubemap_face_mask = 0;
+    tex->cubemap_needs_barrier = false;
+
+    SGL_TRACE_TEXTURE("delete_texture handle=%u", handle);
+}
+
+/* ============================================================================
+ * Texture Heap Compaction (sglCompactTextureHeap)
+ *
+ * Slides every live texture down to the lowest free offset so that churn
+ * during a session does not leave the heap fragmented. Intended for loading
+ * screens: the GPU is drained, images are moved with GPU buffer copies and
+ * their DkImage/descriptors are rebuilt at the new address.
+ * ============================================================================ */
+
+void dk_compact_texture_heap(sgl_backend_t *be) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+
+    /* === Step 1: Drain the GPU so nothing references the old ranges === */
+    dk_drain_queue(dk);
+
+    /* === Step 2: Collect live textures in offset order === */
+    uint32_t end = sgl_table_end(&dk->textures);
+    sgl_handle_t *order = (sgl_handle_t *)malloc(end * sizeof(sgl_handle_t));
+    if (!order) {
+        SGL_ERROR_TEXTURE("compact_texture_heap: out of memory");
+        return;
+    }
+    uint32_t count = 0;
+    for (sgl_handle_t h = 1; h < end; h++) {
+        const dk_texture_t *tex = (const dk_texture_t *)sgl_table_get(&dk->textures, h);
+        if (!tex || tex->mem_size == 0) continue;
+        uint32_t i = count++;
+        while (i > 0 && dk_texture(dk, order[i - 1])->mem_offset > tex->mem_offset) {
+            order[i] = order[i - 1];
+            i--;
+        }
+        order[i] = h;
+    }
+
+    /* === Step 3: Re-pack from the bottom of the heap ===
+     * Allocating the lowest fit in ascending order from an empty heap never
+     * places a texture above its old offset, so each move only ever slides
+     * data downwards, within its block or into an earlier one. */
+    uint32_t free_before = dk->texture_heap.size - dk->texture_heap.high_water;
+    dk_heap_reset(&dk->texture_heap);  /* Statistics outlive the re-pack */
+
+    uint32_t moved = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        dk_texture_t *tex = dk_texture_rw(dk, order[i]);
+        uint32_t size = tex->mem_size;
+        uint32_t old_offset = tex->mem_offset;
+        uint32_t new_offset;
+        dk_heap_alloc_low(&dk->texture_heap, size, dkImageLayoutGetAlignment(&tex->layout), &new_offset);
+
+        if (new_offset < old_offset) {
+            /* Overlapping moves are split into chunks no larger than the
+             * distance, each completing before the next reads its source */
+            DkGpuAddr src = dk_heap_gpu_addr(&dk->texture_heap, old_offset);
+            DkGpuAddr dst = dk_heap_gpu_addr(&dk->texture_heap, new_offset);
+            uint32_t chunk = dk_heap_block(&dk->texture_heap, old_offset) ==
+                             dk_heap_block(&dk->texture_heap, new_offset) ? old_offset - new_offset : size;
+            for (uint32_t done = 0; done < size; done += chunk) {
+                uint32_t len = (size - done < chunk) ? size - done : chunk;
+                dkCmdBufCopyBuffer(dk->main_stream.cmdbuf, src + done, dst + done, len);
+                dk_barrier(dk, DkBarrier_Full, 0);
+            }
+            tex->mem_offset = new_offset;
+            moved++;
+        }
+    }
+
+    DkCmdList cmdlist = dkCmdBufFinishList(dk->main_stream.cmdbuf);
+    dk_queue_submit(dk, cmdlist);
+    dk_wait_idle(dk);
+    dk_reset_cmdbuf(dk);
+
+    /* === Step 4: Rebuild images and descriptors at their new address === */
+    for (uint32_t i = 0; i < count; i++) {
+        sgl_handle_t h = order[i];
+        dk_texture_t *tex = dk_texture_rw(dk, h);
+        dk_texture_init_image(dk, tex, &tex->layout);
+        tex->descriptor_in_use = false;  /* GPU is idle */
+        tex->graphics_copy = false;
+        dk_hazard_transfer_write(dk, h);  /* Invalidate image caches before next sampling */
+
+        if (!tex->is_cubemap || tex->cubemap_face_mask == DK_CUBEMAP_ALL_FACES) {
+            DkImageView view;
+            dkImageViewDefaults(&view, &tex->image);
+            if (tex->is_cubemap) {
+                view.type = DkImageType_Cubemap;
+            }
+            dk_apply_format_swizzle(&view, tex->gl_format);
+            dkImageDescriptorInitialize(&tex->descriptor, &view, false, false);
+            dk_texture_publish_descriptor(dk, h);
+        }
+    }
+    free(order);
+
+    dk_rebind_render_target(dk);
+
+    /* Blocks added when the heap was full are released once the re-pack empties them */
+    uint32_t released = dk_heap_trim(&dk->texture_heap);
+
+    SGL_TRACE_TEXTURE("compact_texture_heap: moved %u/%u textures, free tail %u -> %u bytes, released %u",
+                      moved, count, free_before, dk->texture_heap.size - dk->texture_heap.high_water, released);
+}
@@ -0,0 +1,164 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * deko3d Backend - Transfer Queue
+ *
+ * With sglSetTransferQueue(GL_TRUE) the GL thread's uploads can run on a
+ * copy-only queue, so streaming textures overlaps the frames the graphics
+ * queue is still rendering instead of taking time from them:
+ * - Only buffer-to-image copies into a texture no recorded or in-flight
+ *   graphics work uses go there. The two queues are not ordered against
+ *   each other, and the 2D engine (blits, mipmaps) is graphics-only.
+ * - The batch is submitted once DK_TEXTURE_STREAM_SUBMIT bytes were staged,
+ *   and before every graphics submission (dk_queue_submit), which makes the
+ *   graphics queue wait on the batch's fence. Frame fences and queue drains
+ *   therefore still cover the copies: staging and freed ranges are recycled
+ *   as before.
+ * - The GL thread's next texture bind invalidates the texture caches, as
+ *   after any upload (upload_barrier_pending).
+ */
+
+#include "dk_internal.h"
+
+/* ============================================================================
+ * Setup / Teardown
+ * ============================================================================ */
+
+static void dk_transfer_destroy(dk_transfer_t *t) {
+    if (t->queue) dkQueueDestroy(t->queue);
+    if (t->cmdbuf) dkCmdBufDestroy(t->cmdbuf);
+    dk_cmd_pool_shutdown(&t->cmd_pool);
+    if (t->cmd_memblock) dkMemBlockDestroy(t->cmd_memblock);
+    memset(t, 0, sizeof(*t));
+}
+
+static bool dk_transfer_create(dk_backend_data_t *dk) {
+    dk_transfer_t *t = &dk->transfer;
+
+    DkMemBlockMaker memMaker;
+    dkMemBlockMakerDefaults(&memMaker, dk->device, DK_TRANSFER_CMD_MEM_SIZE);
+    memMaker.flags = DkMemBlockFlags_CpuUncached | DkMemBlockFlags_GpuCached;
+    t->cmd_memblock = dkMemBlockCreate(&memMaker);
+
+    DkCmdBufMaker cmdMaker;
+    dkCmdBufMakerDefaults(&cmdMaker, dk->device);
+    dk_cmd_pool_init(dk, &t->cmd_pool, SGL_FB_NUM + DK_MAX_RECORDERS + DK_MAX_UPLOAD_THREADS, &cmdMaker);
+    t->cmdbuf = t->cmd_memblock ? dkCmdBufCreate(&cmdMaker) : NULL;
+
+    DkQueueMaker queueMaker;
+    dkQueueMakerDefaults(&queueMaker, dk->device);
+    queueMaker.flags = DkQueueFlags_Transfer;
+    t->queue = t->cmdbuf ? dkQueueCreate(&queueMaker) : NULL;
+
+    if (!t->queue) {
+        SGL_ERROR_BACKEND("set_transfer_queue: cannot create the transfer queue");
+        dk_transfer_destroy(t);
+        return false;
+    }
+    dkCmdBufAddMemory(t->cmdbuf, t->cmd_memblock, 0, DK_TRANSFER_CMD_MEM_SIZE);
+    return true;
+}
+
+bool dk_set_transfer_queue(sgl_backend_t *be, bool enable) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_transfer_t *t = &dk->transfer;
+
+    if (enable) {
+        if (!t->queue && dk_transfer_create(dk)) {
+            SGL_INFO(SGL_LOG_CAT_BACKEND, "[BACKEND] transfer queue enabled");
+        }
+        return t->queue != NULL;
+    }
+
+    if (t->queue) {
+        /* The graphics queue waits for the last batch; the batch must have run
+         * before its command memory goes away */
+        dk_transfer_handoff(dk);
+        dkQueueWaitIdle(t->queue);
+        dk_transfer_destroy(t);
+        SGL_INFO(SGL_LOG_CAT_BACKEND, "[BACKEND] transfer queue disabled");
+    }
+    return false;
+}
+
+void dk_transfer_shutdown(dk_backend_data_t *dk) {
+    dk_transfer_t *t = &dk->transfer;
+    if (!t->queue) return;
+    dkQueueWaitIdle(t->queue);
+    dk_transfer_destroy(t);
+}
+
+/* ============================================================================
+ * Recording
+ * ============================================================================ */
+
+/* A new batch reuses the command memory once the queue has run the last one.
+ * Until then the batch is appended; past half the pool's chunks it waits. */
+static void dk_transfer_begin(dk_backend_data_t *dk, dk_transfer_t *t) {
+    if (t->fence_active) {
+        bool full = t->cmd_pool.in_use > DK_MAX_CMD_CHUNKS / 2;
+        if (dkFenceWait(&t->fence, full ? -1 : 0) != DkResult_Success) return;
+        t->fence_active = false;
+    }
+    dk_cmd_pool_recycle(dk, &t->cmd_pool, t->cmdbuf, t->cmd_memblock, DK_TRANSFER_CMD_MEM_SIZE);
+}
+
+DkCmdBuf dk_transfer_cmdbuf(dk_backend_data_t *dk, sgl_handle_t dst, bool from_image) {
+    dk_upload_t *u = dk_upload_current(dk);
+    if (u) {
+        u->recorded = true;
+        return u->stream.cmdbuf;
+    }
+    if (dst == 0) return dk->main_stream.cmdbuf;
+
+    /* Graphics work on the texture, recorded or still running, would not be
+     * ordered against the transfer queue: such copies stay in the frame, and
+     * so do later ones into the texture until the next queue drain */
+    dk_texture_t *tex = dk_texture_rw(dk, dst);
+    if (!tex) return dk->main_stream.cmdbuf;
+    dk_transfer_t *t = &dk->transfer;
+    if (!t->queue || from_image || tex->descriptor_in_use || tex->graphics_copy ||
+        tex->write_kind == DK_WRITE_RENDER) {
+        tex->graphics_copy = true;
+        return dk->main_stream.cmdbuf;
+    }
+
+    if (!t->recorded) {
+        dk_transfer_begin(dk, t);
+        t->recorded = true;
+    }
+    dk->main_stream.stats.transfer_copies++;
+    return t->cmdbuf;
+}
+
+/* ============================================================================
+ * Submission
+ * ============================================================================ */
+
+void dk_transfer_submit(dk_backend_data_t *dk) {
+    dk_transfer_t *t = &dk->transfer;
+    if (!t->recorded) return;
+
+    dkCmdBufSignalFence(t->cmdbuf, &t->fence, true);
+    dkQueueSubmitCommands(t->queue, dkCmdBufFinishList(t->cmdbuf));
+    dkQueueFlush(t->queue);
+    t->fence_active = true;
+    t->wait_pending = true;
+    t->recorded = false;
+    t->staged_bytes = 0;
+}
+
+void dk_transfer_submit_staged(dk_backend_data_t *dk) {
+    dk_transfer_t *t = &dk->transfer;
+    if (t->recorded && t->staged_bytes >= DK_TEXTURE_STREAM_SUBMIT) dk_transfer_submit(dk);
+}
+
+void dk_transfer_handoff(dk_backend_data_t *dk) {
+    dk_transfer_t *t = &dk->transfer;
+    if (!t->queue) return;
+
+    dk_transfer_submit(dk);
+    if (t->wait_pending) {
+        dkQueueWaitFence(dk->queue, &t->fence);
+        t->wait_pending = false;
+    }
+}
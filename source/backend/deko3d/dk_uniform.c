@@ -10,35 +10,106 @@
  * as part of dk_bind_program() to capture uniform values at draw time.
  *
  * Memory layout:
- * - Uniform buffer region is at the end of data_memblock
+ * - The arena starts with the uniform region at the end of data_memblock
+ * - When a frame needs more, extra memblocks of the same size are chained
+ *   and kept for later frames; the arena rewinds at each frame start
  * - Each uniform allocation is aligned to 256 bytes (DK_UNIFORM_BUF_ALIGNMENT)
+ *   and never straddles two blocks
+ * - Recorders own a separate arena whose block 0 is a memblock of its own;
+ *   offsets are always relative to the calling thread's stream
  */
 
 #include "dk_internal.h"
 
+/* ============================================================================
+ * Arena Blocks
+ * ============================================================================ */
+
+static bool dk_uniform_grow(dk_backend_data_t *dk, dk_stream_t *s) {
+    if (s->uniform_num_blocks >= DK_MAX_UNIFORM_BLOCKS) return false;
+
+    DkMemBlockMaker maker;
+    dkMemBlockMakerDefaults(&maker, dk->device, SGL_UNIFORM_BUF_SIZE);
+    maker.flags = DkMemBlockFlags_CpuUncached | DkMemBlockFlags_GpuCached;
+    DkMemBlock block = dkMemBlockCreate(&maker);
+    if (!block) return false;
+
+    s->uniform_blocks[s->uniform_num_blocks++] = block;
+    SGL_TRACE_UNIFORM("uniform arena grown to %u blocks", s->uniform_num_blocks);
+    return true;
+}
+
+void dk_uniform_shutdown(dk_stream_t *s) {
+    /* The main stream's block 0 belongs to data_memblock */
+    uint32_t first = s->is_recorder ? 0 : 1;
+    for (uint32_t i = first; i < s->uniform_num_blocks; i++) {
+        dkMemBlockDestroy(s->uniform_blocks[i]);
+        s->uniform_blocks[i] = NULL;
+    }
+    s->uniform_num_blocks = first;
+}
+
+uint8_t *dk_uniform_cpu_addr(dk_backend_data_t *dk, uint32_t offset) {
+    uint32_t block = offset / SGL_UNIFORM_BUF_SIZE;
+    uint32_t in_block = offset % SGL_UNIFORM_BUF_SIZE;
+    dk_stream_t *s = dk_stream(dk);
+    if (block == 0 && !s->is_recorder) {
+        return (uint8_t *)dkMemBlockGetCpuAddr(dk->data_memblock) + dk->uniform_base + in_block;
+    }
+    return (uint8_t *)dkMemBlockGetCpuAddr(s->uniform_blocks[block]) + in_block;
+}
+
+DkGpuAddr dk_uniform_gpu_addr(dk_backend_data_t *dk, uint32_t offset) {
+    uint32_t block = offset / SGL_UNIFORM_BUF_SIZE;
+    uint32_t in_block = offset % SGL_UNIFORM_BUF_SIZE;
+    dk_stream_t *s = dk_stream(dk);
+    if (block == 0 && !s->is_recorder) {
+        return dkMemBlockGetGpuAddr(dk->data_memblock) + dk->uniform_base + in_block;
+    }
+    return dkMemBlockGetGpuAddr(s->uniform_blocks[block]) + in_block;
+}
+
 /* ============================================================================
  * Uniform Allocation
  *
- * Allocates space in the uniform buffer region.
- * Returns the offset relative to uniform_base that can be used with
- * write_uniform and for binding.
+ * Allocates space in the uniform arena.
+ * Returns the arena offset that can be used with write_uniform and for
+ * binding (dk_uniform_gpu_addr).
  * ============================================================================ */
 
 uint32_t dk_alloc_uniform(sgl_backend_t *be, uint32_t size) {
     dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_stream_t *s = dk_stream(dk);
 
     /* Align size to 256 bytes (DK_UNIFORM_BUF_ALIGNMENT) */
     uint32_t alignedSize = SGL_ALIGN_UP(size, SGL_UNIFORM_ALIGNMENT);
+    if (alignedSize > SGL_UNIFORM_BUF_SIZE) {
+        s->uniform_failed++;
+        SGL_ERROR_BACKEND("alloc_uniform: %u bytes exceeds the %u byte block size",
+                          alignedSize, SGL_UNIFORM_BUF_SIZE);
+        return 0;
+    }
 
-    /* Check for overflow */
-    if (dk->uniform_offset + alignedSize > SGL_UNIFORM_BUF_SIZE) {
-        SGL_ERROR_BACKEND("alloc_uniform: out of uniform memory (need %u, have %u)",
-                          alignedSize, SGL_UNIFORM_BUF_SIZE - dk->uniform_offset);
+    /* Move to the next block if this one cannot hold the allocation */
+    uint32_t block = s->uniform_offset / SGL_UNIFORM_BUF_SIZE;
+    if (s->uniform_offset % SGL_UNIFORM_BUF_SIZE + alignedSize > SGL_UNIFORM_BUF_SIZE) {
+        block++;
+    }
+    if (block >= s->uniform_num_blocks && !dk_uniform_grow(dk, s)) {
+        s->uniform_failed++;
+        SGL_ERROR_BACKEND("alloc_uniform: out of uniform memory (%u blocks of %u bytes in use)",
+                          s->uniform_num_blocks, SGL_UNIFORM_BUF_SIZE);
         return 0;
     }
+    if (block != s->uniform_offset / SGL_UNIFORM_BUF_SIZE) {
+        s->uniform_offset = block * SGL_UNIFORM_BUF_SIZE;
+    }
 
-    uint32_t offset = dk->uniform_offset;
-    dk->uniform_offset += alignedSize;
+    uint32_t offset = s->uniform_offset;
+    s->uniform_offset += alignedSize;
+    if (s->uniform_offset > s->uniform_high_water) {
+        s->uniform_high_water = s->uniform_offset;
+    }
 
     DK_VERBOSE_PRINT("[DK] alloc_uniform: size=%u aligned=%u offset=%u\n",
                      size, alignedSize, offset);
@@ -47,6 +118,14 @@ uint32_t dk_alloc_uniform(sgl_backend_t *be, uint32_t size) {
     return offset;
 }
 
+void dk_get_uniform_stats(sgl_backend_t *be, uint32_t *used, uint32_t *high_water, uint32_t *capacity) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_stream_t *s = dk_stream(dk);
+    *used = s->uniform_offset;
+    *high_water = s->uniform_high_water;
+    *capacity = s->uniform_num_blocks * SGL_UNIFORM_BUF_SIZE;
+}
+
 /* ============================================================================
  * Uniform Write
  *
@@ -61,9 +140,8 @@ void dk_write_uniform(sgl_backend_t *be, uint32_t offset, const void *data, uint
         return;
     }
 
-    /* Calculate CPU address in uniform buffer region */
-    uint8_t *cpu_base = (uint8_t*)dkMemBlockGetCpuAddr(dk->data_memblock);
-    void *dst = cpu_base + dk->uniform_base + offset;
+    /* Calculate CPU address in the uniform arena */
+    void *dst = dk_uniform_cpu_addr(dk, offset);
 
     /* Copy uniform data */
     memcpy(dst, data, size);
@@ -0,0 +1,480 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * deko3d Backend - Shared Contexts and Upload Threads
+ *
+ * The contexts of an EGL share group use one backend. When a second context
+ * joins, dk_share installs a copy of the ops table in which:
+ * - Resource ops (specification, deletion, linking) hold share_lock, and so
+ *   does the GL thread when it reclaims deferred frees
+ * - Ops that only make sense on the rendering thread (render targets,
+ *   readbacks, queries, recorders, uniforms) are dropped on upload threads
+ * Draws and state changes never take the lock.
+ *
+ * A thread whose shared context is current without a surface is an upload
+ * thread. It gets a stream with its own command memory, staging block and
+ * queue: copies are recorded there and submitted on glFlush, glFinish, a
+ * fence, or when staging runs out, closed by a full barrier. The GL thread
+ * invalidates its texture caches at its next texture bind. Objects still in
+ * use on the other thread need a fence, as GL share groups require.
+ */
+
+#include "dk_internal.h"
+
+/* ============================================================================
+ * Upload Streams
+ * ============================================================================ */
+
+dk_upload_t *dk_upload_current(dk_backend_data_t *dk) {
+    return dk_stream(dk)->upload;
+}
+
+GLint dk_unpack_alignment(dk_backend_data_t *dk) {
+    dk_upload_t *u = dk_upload_current(dk);
+    return u ? u->unpack_alignment : dk->unpack_alignment;
+}
+
+void dk_upload_flush(dk_backend_data_t *dk, dk_upload_t *u) {
+    if (!u->recorded) return;
+
+    /* Copy engine writes bypass the 3D engine's L2; make them visible to it */
+    dkCmdBufBarrier(u->stream.cmdbuf, DkBarrier_Full,
+                    DkInvalidateFlags_Image | DkInvalidateFlags_L2Cache | DkInvalidateFlags_Descriptors);
+    dkCmdBufSignalFence(u->stream.cmdbuf, &u->fence, true);
+    dkQueueSubmitCommands(u->queue, dkCmdBufFinishList(u->stream.cmdbuf));
+    dkQueueFlush(u->queue);
+    u->fence_active = true;
+    u->recorded = false;
+    u->transfer_pending = false;
+
+    /* The GL thread's next texture bind invalidates what it may have cached */
+    __atomic_store_n(&dk->upload_barrier_pending, true, __ATOMIC_RELEASE);
+}
+
+void dk_upload_finish(dk_backend_data_t *dk, dk_upload_t *u) {
+    dk_upload_flush(dk, u);
+    if (u->fence_active) {
+        dkFenceWait(&u->fence, -1);
+        u->fence_active = false;
+    }
+
+    /* Nothing the thread recorded is pending: rewind staging and command memory */
+    u->staging_offset = 0;
+    for (uint32_t i = 0; i < u->staging_overflow_count; i++) {
+        dkMemBlockDestroy(u->staging_overflow[i]);
+    }
+    u->staging_overflow_count = 0;
+    dk_cmd_pool_recycle(dk, &u->cmd_pool, u->stream.cmdbuf, u->cmd_memblock, DK_UPLOAD_CMD_MEM_SIZE);
+    u->stream.state_generation = dk_next_generation(dk);
+
+    /* Work the GL thread recorded before may still read the freed ranges */
+    if (u->free_count > 0) {
+        sgl_lock(&dk->share_lock);
+        for (uint32_t i = 0; i < u->free_count; i++) {
+            dk_upload_free_t *f = &u->frees[i];
+            dk_heap_defer_free(f->heap, dk->current_slot, f->offset, f->size);
+        }
+        sgl_unlock(&dk->share_lock);
+        u->free_count = 0;
+    }
+}
+
+bool dk_upload_fence(dk_backend_data_t *dk, dk_upload_t *u, DkFence *out_fence) {
+    dk_upload_flush(dk, u);
+    if (!u->fence_active) return false;
+    *out_fence = u->fence;
+    return true;
+}
+
+bool dk_upload_staging_alloc(dk_backend_data_t *dk, dk_upload_t *u, uint32_t size, uint32_t align,
+                             uint8_t **out_cpu, DkGpuAddr *out_gpu) {
+    if (size == 0) return false;
+    if (align == 0) align = 1;
+
+    if (size <= DK_UPLOAD_STAGING_SIZE) {
+        uint32_t offset = SGL_ALIGN_UP(u->staging_offset, align);
+        if ((uint64_t)offset + size > DK_UPLOAD_STAGING_SIZE) {
+            /* Block used up: wait for the copies still reading it */
+            dk_upload_finish(dk, u);
+            offset = 0;
+        }
+        u->staging_offset = offset + size;
+        *out_cpu = (uint8_t *)dkMemBlockGetCpuAddr(u->staging_memblock) + offset;
+        *out_gpu = dkMemBlockGetGpuAddr(u->staging_memblock) + offset;
+        return true;
+    }
+
+    if (u->staging_overflow_count >= DK_MAX_STAGING_OVERFLOW) {
+        dk_upload_finish(dk, u);
+    }
+
+    DkMemBlockMaker maker;
+    dkMemBlockMakerDefaults(&maker, dk->device, SGL_ALIGN_UP(size, SGL_PAGE_ALIGNMENT));
+    maker.flags = DkMemBlockFlags_CpuUncached | DkMemBlockFlags_GpuCached;
+    DkMemBlock block = dkMemBlockCreate(&maker);
+    if (!block) {
+        SGL_ERROR_BACKEND("upload: failed to allocate %u byte staging block", size);
+        return false;
+    }
+
+    u->staging_overflow[u->staging_overflow_count++] = block;
+    *out_cpu = (uint8_t *)dkMemBlockGetCpuAddr(block);
+    *out_gpu = dkMemBlockGetGpuAddr(block);
+    return true;
+}
+
+void dk_defer_free(dk_backend_data_t *dk, dk_heap_t *heap, uint32_t offset, uint32_t size) {
+    dk_upload_t *u = dk_upload_current(dk);
+    if (!u) {
+        dk_heap_defer_free(heap, dk->current_slot, offset, size);
+        return;
+    }
+    if (size == 0) return;
+
+    if (u->free_count == DK_MAX_UPLOAD_FREES) {
+        dk_upload_finish(dk, u);
+    }
+    dk_upload_free_t *f = &u->frees[u->free_count++];
+    f->heap = heap;
+    f->offset = offset;
+    f->size = size;
+}
+
+/* ============================================================================
+ * Attach / Detach
+ * ============================================================================ */
+
+static void dk_upload_destroy(dk_backend_data_t *dk, dk_upload_t *u) {
+    if (u->queue && u->stream.cmdbuf) dk_upload_finish(dk, u);
+    if (u->queue) dkQueueDestroy(u->queue);
+    if (u->stream.cmdbuf) dkCmdBufDestroy(u->stream.cmdbuf);
+    dk_cmd_pool_shutdown(&u->cmd_pool);
+    if (u->cmd_memblock) dkMemBlockDestroy(u->cmd_memblock);
+    if (u->staging_memblock) dkMemBlockDestroy(u->staging_memblock);
+    free(u);
+}
+
+bool dk_attach_upload_thread(sgl_backend_t *be) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    if (dk_upload_current(dk)) return true;
+
+    sgl_lock(&dk->share_lock);
+
+    int index = 0;
+    while (index < DK_MAX_UPLOAD_THREADS && dk->uploads[index]) index++;
+    if (index == DK_MAX_UPLOAD_THREADS) {
+        SGL_ERROR_BACKEND("attach_upload_thread: all %d upload threads in use", DK_MAX_UPLOAD_THREADS);
+        sgl_unlock(&dk->share_lock);
+        return false;
+    }
+
+    dk_upload_t *u = (dk_upload_t *)calloc(1, sizeof(dk_upload_t));
+    if (!u) {
+        sgl_unlock(&dk->share_lock);
+        return false;
+    }
+    u->stream.upload = u;
+    u->stream.state_generation = dk_next_generation(dk);
+    u->unpack_alignment = 4;  /* GL default, the context sends its own */
+
+    DkMemBlockMaker memMaker;
+    dkMemBlockMakerDefaults(&memMaker, dk->device, DK_UPLOAD_CMD_MEM_SIZE);
+    memMaker.flags = DkMemBlockFlags_CpuUncached | DkMemBlockFlags_GpuCached;
+    u->cmd_memblock = dkMemBlockCreate(&memMaker);
+
+    DkCmdBufMaker cmdMaker;
+    dkCmdBufMakerDefaults(&cmdMaker, dk->device);
+    dk_cmd_pool_init(dk, &u->cmd_pool, SGL_FB_NUM + DK_MAX_RECORDERS + index, &cmdMaker);
+    u->stream.cmdbuf = u->cmd_memblock ? dkCmdBufCreate(&cmdMaker) : NULL;
+
+    dkMemBlockMakerDefaults(&memMaker, dk->device, DK_UPLOAD_STAGING_SIZE);
+    memMaker.flags = DkMemBlockFlags_CpuUncached | DkMemBlockFlags_GpuCached;
+    u->staging_memblock = dkMemBlockCreate(&memMaker);
+
+    DkQueueMaker queueMaker;
+    dkQueueMakerDefaults(&queueMaker, dk->device);
+    queueMaker.flags = DkQueueFlags_Graphics;
+    u->queue = dkQueueCreate(&queueMaker);
+
+    if (!u->stream.cmdbuf || !u->staging_memblock || !u->queue) {
+        SGL_ERROR_BACKEND("attach_upload_thread: out of memory");
+        dk_upload_destroy(dk, u);
+        sgl_unlock(&dk->share_lock);
+        return false;
+    }
+    dkCmdBufAddMemory(u->stream.cmdbuf, u->cmd_memblock, 0, DK_UPLOAD_CMD_MEM_SIZE);
+
+    dk->uploads[index] = u;
+    sgl_unlock(&dk->share_lock);
+
+    dk_set_thread_stream(&u->stream);
+    SGL_TRACE_BACKEND("attach_upload_thread -> %d", index);
+    return true;
+}
+
+void dk_detach_upload_thread(sgl_backend_t *be) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    dk_upload_t *u = dk_upload_current(dk);
+    if (!u) return;
+
+    sgl_lock(&dk->share_lock);
+    for (int i = 0; i < DK_MAX_UPLOAD_THREADS; i++) {
+        if (dk->uploads[i] == u) dk->uploads[i] = NULL;
+    }
+    dk_upload_destroy(dk, u);
+    sgl_unlock(&dk->share_lock);
+
+    dk_set_thread_stream(NULL);
+    SGL_TRACE_BACKEND("detach_upload_thread");
+}
+
+void dk_upload_shutdown(dk_backend_data_t *dk) {
+    for (int i = 0; i < DK_MAX_UPLOAD_THREADS; i++) {
+        if (dk->uploads[i]) {
+            dk_upload_destroy(dk, dk->uploads[i]);
+            dk->uploads[i] = NULL;
+        }
+    }
+}
+
+/* ============================================================================
+ * Shared Operations Table
+ *
+ * DK_SHARED_LOCKED wraps a resource op in share_lock. DK_SHARED_RENDER also
+ * drops the op on upload threads: it reads or records into the GL thread's
+ * render target, queue or per-frame state.
+ * ============================================================================ */
+
+#define DK_SHARED_LOCKED(name, params, args)                                  \
+    static void dk_shared_##name params {                                     \
+        dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;           \
+        sgl_lock(&dk->share_lock);                                            \
+        dk_##name args;                                                       \
+        sgl_unlock(&dk->share_lock);                                          \
+    }
+
+#define DK_SHARED_LOCKED_RET(type, name, params, args)                        \
+    static type dk_shared_##name params {                                     \
+        dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;           \
+        sgl_lock(&dk->share_lock);                                            \
+        type ret = dk_##name args;                                            \
+        sgl_unlock(&dk->share_lock);                                          \
+        return ret;                                                           \
+    }
+
+#define DK_SHARED_RENDER(name, params, args)                                  \
+    static void dk_shared_##name params {                                     \
+        dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;           \
+        if (dk_upload_current(dk)) return;                                    \
+        sgl_lock(&dk->share_lock);                                            \
+        dk_##name args;                                                       \
+        sgl_unlock(&dk->share_lock);                                          \
+    }
+
+#define DK_SHARED_RENDER_RET(type, name, dropped, params, args)               \
+    static type dk_shared_##name params {                                     \
+        dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;           \
+        if (dk_upload_current(dk)) return dropped;                            \
+        sgl_lock(&dk->share_lock);                                            \
+        type ret = dk_##name args;                                            \
+        sgl_unlock(&dk->share_lock);                                          \
+        return ret;                                                           \
+    }
+
+/* Buffers */
+DK_SHARED_LOCKED(delete_buffer, (sgl_backend_t *be, sgl_handle_t handle), (be, handle))
+DK_SHARED_LOCKED_RET(uint32_t, buffer_data,
+    (sgl_backend_t *be, sgl_handle_t handle, GLenum target, GLsizeiptr size, const void *data, GLenum usage),
+    (be, handle, target, size, data, usage))
+DK_SHARED_LOCKED_RET(void *, map_buffer, (sgl_backend_t *be, sgl_handle_t handle), (be, handle))
+
+/* Textures */
+DK_SHARED_LOCKED(delete_texture, (sgl_backend_t *be, sgl_handle_t handle), (be, handle))
+DK_SHARED_LOCKED(texture_image_2d,
+    (sgl_backend_t *be, sgl_handle_t handle, GLenum target, GLint level, GLint internalformat,
+     GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels),
+    (be, handle, target, level, internalformat, width, height, border, format, type, pixels))
+DK_SHARED_LOCKED(texture_sub_image_2d,
+    (sgl_backend_t *be, sgl_handle_t handle, GLenum target, GLint level, GLint xoffset, GLint yoffset,
+     GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels),
+    (be, handle, target, level, xoffset, yoffset, width, height, format, type, pixels))
+DK_SHARED_LOCKED(generate_mipmap, (sgl_backend_t *be, sgl_handle_t handle), (be, handle))
+DK_SHARED_RENDER(copy_tex_image_2d,
+    (sgl_backend_t *be, sgl_handle_t handle, GLenum target, GLint level, GLenum internalformat,
+     GLint x, GLint y, GLsizei width, GLsizei height),
+    (be, handle, target, level, internalformat, x, y, width, height))
+DK_SHARED_RENDER(copy_tex_sub_image_2d,
+    (sgl_backend_t *be, sgl_handle_t handle, GLenum target, GLint level, GLint xoffset, GLint yoffset,
+     GLint x, GLint y, GLsizei width, GLsizei height),
+    (be, handle, target, level, xoffset, yoffset, x, y, width, height))
+DK_SHARED_LOCKED(compressed_texture_image_2d,
+    (sgl_backend_t *be, sgl_handle_t handle, GLenum target, GLint level, GLenum internalformat,
+     GLsizei width, GLsizei height, GLsizei imageSize, const void *data),
+    (be, handle, target, level, internalformat, width, height, imageSize, data))
+DK_SHARED_LOCKED(compressed_texture_sub_image_2d,
+    (sgl_backend_t *be, sgl_handle_t handle, GLenum target, GLint level, GLint xoffset, GLint yoffset,
+     GLsizei width, GLsizei height, GLenum format, GLsizei imageSize, const void *data),
+    (be, handle, target, level, xoffset, yoffset, width, height, format, imageSize, data))
+DK_SHARED_LOCKED_RET(bool, compressed_texture_stream,
+    (sgl_backend_t *be, sgl_handle_t handle, GLenum internalformat, GLsizei width, GLsizei height,
+     GLint levels, sgl_texture_read_fn read, void *user),
+    (be, handle, internalformat, width, height, levels, read, user))
+DK_SHARED_RENDER(compact_texture_heap, (sgl_backend_t *be), (be))
+DK_SHARED_RENDER_RET(bool, set_transfer_queue, false, (sgl_backend_t *be, bool enable), (be, enable))
+
+/* Shaders and programs */
+DK_SHARED_LOCKED(delete_shader, (sgl_backend_t *be, sgl_handle_t handle), (be, handle))
+DK_SHARED_LOCKED_RET(bool, load_shader_binary,
+    (sgl_backend_t *be, sgl_handle_t handle, const void *data, size_t size), (be, handle, data, size))
+DK_SHARED_LOCKED_RET(bool, load_shader_file,
+    (sgl_backend_t *be, sgl_handle_t handle, const char *path), (be, handle, path))
+DK_SHARED_LOCKED(delete_program, (sgl_backend_t *be, sgl_handle_t handle), (be, handle))
+DK_SHARED_LOCKED_RET(bool, link_program,
+    (sgl_backend_t *be, sgl_handle_t program, sgl_handle_t vertex_shader, sgl_handle_t fragment_shader),
+    (be, program, vertex_shader, fragment_shader))
+DK_SHARED_LOCKED_RET(bool, load_program_binary,
+    (sgl_backend_t *be, sgl_handle_t program, const void *vs_code, size_t vs_size,
+     const void *fs_code, size_t fs_size),
+    (be, program, vs_code, vs_size, fs_code, fs_size))
+DK_SHARED_LOCKED(delete_vertex_array, (sgl_backend_t *be, GLuint vao), (be, vao))
+
+/* Framebuffers and renderbuffers */
+DK_SHARED_RENDER(bind_framebuffer,
+    (sgl_backend_t *be, sgl_handle_t handle, sgl_handle_t color_tex, sgl_handle_t depth_rb),
+    (be, handle, color_tex, depth_rb))
+DK_SHARED_LOCKED(framebuffer_texture,
+    (sgl_backend_t *be, sgl_handle_t fbo, GLenum attachment, GLenum textarget, sgl_handle_t texture, GLint level),
+    (be, fbo, attachment, textarget, texture, level))
+DK_SHARED_RENDER(draw_buffers, (sgl_backend_t *be, sgl_handle_t fbo, uint32_t mask), (be, fbo, mask))
+DK_SHARED_RENDER_RET(bool, blit_framebuffer, true,
+    (sgl_backend_t *be, sgl_handle_t read_fbo, sgl_handle_t read_color,
+     const GLint src[4], const GLint dst[4], GLenum filter),
+    (be, read_fbo, read_color, src, dst, filter))
+DK_SHARED_RENDER(discard_framebuffer, (sgl_backend_t *be, uint32_t color_mask, bool depth_stencil),
+    (be, color_mask, depth_stencil))
+DK_SHARED_LOCKED(renderbuffer_storage,
+    (sgl_backend_t *be, sgl_handle_t handle, GLenum internalformat, GLsizei width, GLsizei height),
+    (be, handle, internalformat, width, height))
+DK_SHARED_LOCKED(delete_renderbuffer, (sgl_backend_t *be, sgl_handle_t handle), (be, handle))
+DK_SHARED_RENDER(read_pixels,
+    (sgl_backend_t *be, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type,
+     void *pixels),
+    (be, x, y, width, height, format, type, pixels))
+DK_SHARED_RENDER(read_pixels_to_buffer,
+    (sgl_backend_t *be, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type,
+     sgl_handle_t buffer, uint32_t offset),
+    (be, x, y, width, height, format, type, buffer, offset))
+DK_SHARED_RENDER(insert_barrier, (sgl_backend_t *be), (be))
+
+/* Recorders and command lists */
+DK_SHARED_LOCKED_RET(sgl_handle_t, create_recorder, (sgl_backend_t *be), (be))
+DK_SHARED_LOCKED(delete_recorder, (sgl_backend_t *be, sgl_handle_t handle), (be, handle))
+DK_SHARED_RENDER_RET(bool, begin_recorder, false, (sgl_backend_t *be, sgl_handle_t handle), (be, handle))
+DK_SHARED_RENDER(submit_recorders, (sgl_backend_t *be, const sgl_handle_t *handles, int count),
+    (be, handles, count))
+DK_SHARED_RENDER_RET(sgl_handle_t, begin_cmdlist, 0, (sgl_backend_t *be), (be))
+DK_SHARED_RENDER_RET(bool, end_cmdlist, false, (sgl_backend_t *be, sgl_handle_t handle), (be, handle))
+DK_SHARED_RENDER(call_cmdlist, (sgl_backend_t *be, sgl_handle_t handle), (be, handle))
+DK_SHARED_LOCKED(delete_cmdlist, (sgl_backend_t *be, sgl_handle_t handle), (be, handle))
+
+/* Queries */
+DK_SHARED_LOCKED_RET(sgl_handle_t, create_query, (sgl_backend_t *be), (be))
+DK_SHARED_LOCKED(delete_query, (sgl_backend_t *be, sgl_handle_t handle), (be, handle))
+DK_SHARED_RENDER(begin_query, (sgl_backend_t *be, sgl_handle_t handle, GLenum target), (be, handle, target))
+DK_SHARED_RENDER(end_query, (sgl_backend_t *be, sgl_handle_t handle), (be, handle))
+DK_SHARED_RENDER(query_counter, (sgl_backend_t *be, sgl_handle_t handle), (be, handle))
+DK_SHARED_RENDER_RET(bool, get_query_result, false,
+    (sgl_backend_t *be, sgl_handle_t handle, bool wait, uint64_t *result), (be, handle, wait, result))
+DK_SHARED_RENDER_RET(uint64_t, get_gpu_timestamp, 0, (sgl_backend_t *be), (be))
+
+/* Render resolution */
+DK_SHARED_RENDER(set_render_resolution, (sgl_backend_t *be, GLsizei width, GLsizei height),
+    (be, width, height))
+DK_SHARED_RENDER(set_dynamic_resolution, (sgl_backend_t *be, uint64_t target_ns, float min_scale),
+    (be, target_ns, min_scale))
+
+/* Uniforms live in the stream's arena, whose block 0 is the GL thread's:
+ * upload threads have none, and the GL thread needs no lock for its own */
+static uint32_t dk_shared_alloc_uniform(sgl_backend_t *be, uint32_t size) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    return dk_upload_current(dk) ? 0 : dk_alloc_uniform(be, size);
+}
+
+static void dk_shared_write_uniform(sgl_backend_t *be, uint32_t offset, const void *data, uint32_t size) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    if (!dk_upload_current(dk)) dk_write_uniform(be, offset, data, size);
+}
+
+static sgl_backend_ops_t dk_shared_ops;
+
+void dk_share(sgl_backend_t *be) {
+    dk_backend_data_t *dk = (dk_backend_data_t *)be->impl_data;
+    if (dk->shared) return;
+
+    /* Every backend shares the same wrappers; only the first share fills them in */
+    if (!dk_shared_ops.init) {
+        sgl_backend_ops_t ops = dk_backend_ops;
+
+        ops.delete_buffer = dk_shared_delete_buffer;
+        ops.buffer_data = dk_shared_buffer_data;
+        ops.map_buffer = dk_shared_map_buffer;
+
+        ops.delete_texture = dk_shared_delete_texture;
+        ops.texture_image_2d = dk_shared_texture_image_2d;
+        ops.texture_sub_image_2d = dk_shared_texture_sub_image_2d;
+        ops.generate_mipmap = dk_shared_generate_mipmap;
+        ops.copy_tex_image_2d = dk_shared_copy_tex_image_2d;
+        ops.copy_tex_sub_image_2d = dk_shared_copy_tex_sub_image_2d;
+        ops.compressed_texture_image_2d = dk_shared_compressed_texture_image_2d;
+        ops.compressed_texture_sub_image_2d = dk_shared_compressed_texture_sub_image_2d;
+        ops.compressed_texture_stream = dk_shared_compressed_texture_stream;
+        ops.compact_texture_heap = dk_shared_compact_texture_heap;
+        ops.set_transfer_queue = dk_shared_set_transfer_queue;
+
+        ops.delete_shader = dk_shared_delete_shader;
+        ops.load_shader_binary = dk_shared_load_shader_binary;
+        ops.load_shader_file = dk_shared_load_shader_file;
+        ops.delete_program = dk_shared_delete_program;
+        ops.link_program = dk_shared_link_program;
+        ops.load_program_binary = dk_shared_load_program_binary;
+        ops.delete_vertex_array = dk_shared_delete_vertex_array;
+        ops.alloc_uniform = dk_shared_alloc_uniform;
+        ops.write_uniform = dk_shared_write_uniform;
+
+        ops.bind_framebuffer = dk_shared_bind_framebuffer;
+        ops.framebuffer_texture = dk_shared_framebuffer_texture;
+        ops.draw_buffers = dk_shared_draw_buffers;
+        ops.blit_framebuffer = dk_shared_blit_framebuffer;
+        ops.discard_framebuffer = dk_shared_discard_framebuffer;
+        ops.renderbuffer_storage = dk_shared_renderbuffer_storage;
+        ops.delete_renderbuffer = dk_shared_delete_renderbuffer;
+        ops.read_pixels = dk_shared_read_pixels;
+        ops.read_pixels_to_buffer = dk_shared_read_pixels_to_buffer;
+        ops.insert_barrier = dk_shared_insert_barrier;
+
+        ops.create_recorder = dk_shared_create_recorder;
+        ops.delete_recorder = dk_shared_delete_recorder;
+        ops.begin_recorder = dk_shared_begin_recorder;
+        ops.submit_recorders = dk_shared_submit_recorders;
+        ops.begin_cmdlist = dk_shared_begin_cmdlist;
+        ops.end_cmdlist = dk_shared_end_cmdlist;
+        ops.call_cmdlist = dk_shared_call_cmdlist;
+        ops.delete_cmdlist = dk_shared_delete_cmdlist;
+
+        ops.create_query = dk_shared_create_query;
+        ops.delete_query = dk_shared_delete_query;
+        ops.begin_query = dk_shared_begin_query;
+        ops.end_query = dk_shared_end_query;
+        ops.query_counter = dk_shared_query_counter;
+        ops.get_query_result = dk_shared_get_query_result;
+        ops.get_gpu_timestamp = dk_shared_get_gpu_timestamp;
+
+        ops.set_render_resolution = dk_shared_set_render_resolution;
+        ops.set_dynamic_resolution = dk_shared_set_dynamic_resolution;
+
+        dk_shared_ops = ops;
+    }
+
+    dk->shared = true;
+    be->ops = &dk_shared_ops;
+    SGL_TRACE_BACKEND("share: resource ops serialized");
+}
@@ -114,6 +114,17 @@ DkImageFormat dk_convert_format(GLenum internalformat, GLenum format, GLenum typ
     if (format == GL_RGBA && type == GL_UNSIGNED_BYTE) {
         return DkImageFormat_RGBA8_Unorm;
     }
+    /* Packed 16-bit types: native formats with the GL bit layout (red in the
+     * top bits), so uploads are plain copies and the default swizzle applies */
+    if (format == GL_RGB && type == GL_UNSIGNED_SHORT_5_6_5) {
+        return DkImageFormat_RGB565_Unorm;
+    }
+    if (format == GL_RGBA && type == GL_UNSIGNED_SHORT_4_4_4_4) {
+        return DkImageFormat_RGBA4_Unorm;
+    }
+    if (format == GL_RGBA && type == GL_UNSIGNED_SHORT_5_5_5_1) {
+        return DkImageFormat_RGB5A1_Unorm;
+    }
     if (format == GL_RGB && type == GL_UNSIGNED_BYTE) {
         return DkImageFormat_RGBA8_Unorm;  /* Convert to RGBA */
     }
@@ -126,9 +137,25 @@ DkImageFormat dk_convert_format(GLenum internalformat, GLenum format, GLenum typ
     if (format == GL_LUMINANCE_ALPHA && type == GL_UNSIGNED_BYTE) {
         return DkImageFormat_RG8_Unorm;
     }
+    /* GL_OES_depth_texture, GL_OES_packed_depth_stencil */
+    if (format == GL_DEPTH_COMPONENT) {
+        return type == GL_UNSIGNED_SHORT ? DkImageFormat_Z16 : DkImageFormat_Z24X8;
+    }
+    if (format == GL_DEPTH_STENCIL_OES) {
+        return DkImageFormat_Z24S8;
+    }
     return DkImageFormat_RGBA8_Unorm;
 }
 
+GLenum dk_packed16_type(DkImageFormat format) {
+    switch (format) {
+        case DkImageFormat_RGB565_Unorm: return GL_UNSIGNED_SHORT_5_6_5;
+        case DkImageFormat_RGBA4_Unorm:  return GL_UNSIGNED_SHORT_4_4_4_4;
+        case DkImageFormat_RGB5A1_Unorm: return GL_UNSIGNED_SHORT_5_5_5_1;
+        default:                         return 0;
+    }
+}
+
 /* ============================================================================
  * Compressed Format Conversion
  * ============================================================================ */
@@ -323,6 +350,19 @@ int dk_get_compressed_block_bytes(GLenum internalformat) {
 
 void dk_get_attrib_format(GLenum type, GLint size, GLboolean normalized,
                           DkVtxAttribSize *outSize, DkVtxAttribType *outType) {
+    /* Packed 2_10_10_10 (always 4 components, x in the low bits); unnormalized
+     * values reach the shader as floats, so they are scaled rather than int */
+    if (type == GL_INT_2_10_10_10_REV || type == GL_UNSIGNED_INT_2_10_10_10_REV) {
+        bool is_signed = type == GL_INT_2_10_10_10_REV;
+        *outSize = DkVtxAttribSize_10_10_10_2;
+        if (normalized) {
+            *outType = is_signed ? DkVtxAttribType_Snorm : DkVtxAttribType_Unorm;
+        } else {
+            *outType = is_signed ? DkVtxAttribType_Sscaled : DkVtxAttribType_Uscaled;
+        }
+        return;
+    }
+
     /* Size */
     switch (size) {
         case 1:
@@ -331,6 +371,7 @@ void dk_get_attrib_format(GLenum type, GLint size, GLboolean normalized,
                 case GL_UNSIGNED_BYTE:  *outSize = DkVtxAttribSize_1x8; break;
                 case GL_SHORT:          *outSize = DkVtxAttribSize_1x16; break;
                 case GL_UNSIGNED_SHORT: *outSize = DkVtxAttribSize_1x16; break;
+                case GL_HALF_FLOAT_OES: *outSize = DkVtxAttribSize_1x16; break;
                 default:                *outSize = DkVtxAttribSize_1x32; break;
             }
             break;
@@ -340,6 +381,7 @@ void dk_get_attrib_format(GLenum type, GLint size, GLboolean normalized,
                 case GL_UNSIGNED_BYTE:  *outSize = DkVtxAttribSize_2x8; break;
                 case GL_SHORT:          *outSize = DkVtxAttribSize_2x16; break;
                 case GL_UNSIGNED_SHORT: *outSize = DkVtxAttribSize_2x16; break;
+                case GL_HALF_FLOAT_OES: *outSize = DkVtxAttribSize_2x16; break;
                 default:                *outSize = DkVtxAttribSize_2x32; break;
             }
             break;
@@ -349,6 +391,7 @@ void dk_get_attrib_format(GLenum type, GLint size, GLboolean normalized,
                 case GL_UNSIGNED_BYTE:  *outSize = DkVtxAttribSize_3x8; break;
                 case GL_SHORT:          *outSize = DkVtxAttribSize_3x16; break;
                 case GL_UNSIGNED_SHORT: *outSize = DkVtxAttribSize_3x16; break;
+                case GL_HALF_FLOAT_OES: *outSize = DkVtxAttribSize_3x16; break;
                 default:                *outSize = DkVtxAttribSize_3x32; break;
             }
             break;
@@ -358,6 +401,7 @@ void dk_get_attrib_format(GLenum type, GLint size, GLboolean normalized,
                 case GL_UNSIGNED_BYTE:  *outSize = DkVtxAttribSize_4x8; break;
                 case GL_SHORT:          *outSize = DkVtxAttribSize_4x16; break;
                 case GL_UNSIGNED_SHORT: *outSize = DkVtxAttribSize_4x16; break;
+                case GL_HALF_FLOAT_OES: *outSize = DkVtxAttribSize_4x16; break;
                 default:                *outSize = DkVtxAttribSize_4x32; break;
             }
             break;
@@ -377,6 +421,7 @@ void dk_get_attrib_format(GLenum type, GLint size, GLboolean normalized,
         case GL_UNSIGNED_SHORT:
             *outType = normalized ? DkVtxAttribType_Unorm : DkVtxAttribType_Uint;
             break;
+        case GL_HALF_FLOAT_OES:     /* Float with 16-bit components is half */
         case GL_FLOAT:
         default:
             *outType = DkVtxAttribType_Float;
@@ -395,6 +440,7 @@ GLsizei dk_get_type_size(GLenum type) {
             return 1;
         case GL_SHORT:
         case GL_UNSIGNED_SHORT:
+        case GL_HALF_FLOAT_OES:
             return 2;
         case GL_INT:
         case GL_UNSIGNED_INT:
@@ -405,3 +451,11 @@ GLsizei dk_get_type_size(GLenum type) {
             return 4;
     }
 }
+
+/* Bytes of one vertex of an attribute (the stride of a tightly packed array) */
+GLsizei dk_get_attrib_size(GLenum type, GLint size) {
+    if (type == GL_INT_2_10_10_10_REV || type == GL_UNSIGNED_INT_2_10_10_10_REV) {
+        return 4;
+    }
+    return size * dk_get_type_size(type);
+}
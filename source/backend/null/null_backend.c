@@ -0,0 +1,1467 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * Null Backend - Implementation
+ *
+ * Every op is safe to call in any order. Handles are never reused. Data
+ * "offsets" are handed out from a counter and start at 256, so the GL
+ * layer's 0 = failure checks hold. Queries complete immediately: timers
+ * read 0 ns, occlusion queries 1 sample, so conditional rendering draws.
+ */
+
+#include "null_backend.h"
+#include "../../util/sgl_index.h"
+#include "../../util/sgl_log.h"
+#include "../../util/sgl_texfile.h"
+#include <GLES2/gl2ext.h>
+#include <GLES2/gl2sgl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NULL_UNIFORM_ARENA_SIZE (1024 * 1024)
+#define NULL_CLIENT_ARENA_SIZE  (4 * 1024 * 1024)
+#define NULL_DATA_ALIGNMENT     256
+#define NULL_NUM_SLOTS          3
+
+typedef struct {
+    uint8_t *data;
+    uint32_t size;
+    uint32_t offset;        /* Data offset returned by the last buffer_data */
+} null_buffer_t;
+
+typedef struct {
+    void *code;
+    uint32_t size;
+} null_code_t;
+
+typedef struct {
+    null_code_t stages[2];  /* 0 = vertex, 1 = fragment */
+    /* Packed UBO copies [stage][binding], kept up to date as deko3d keeps its own */
+    uint8_t *packed[2][SGL_MAX_PACKED_UBOS];
+    uint32_t packed_size[2][SGL_MAX_PACKED_UBOS];
+    uint32_t packed_generation[2][SGL_MAX_PACKED_UBOS];
+} null_program_t;
+
+typedef struct {
+    bool used;
+    sgl_frame_stats_t stats;    /* Counters recorded into the list, added by every call */
+} null_cmdlist_t;
+
+/* Growable table indexed by handle */
+typedef struct {
+    void *items;
+    uint32_t capacity;
+    uint32_t item_size;
+} null_table_t;
+
+typedef struct {
+    uint32_t next_handle;
+    null_table_t buffers;   /* null_buffer_t */
+    null_table_t shaders;   /* null_code_t */
+    null_table_t programs;  /* null_program_t */
+    null_table_t queries;   /* GLenum target */
+    null_table_t cmdlists;  /* null_cmdlist_t */
+
+    uint32_t data_offset;   /* Next buffer_data offset */
+    uint32_t buffer_budget; /* Data heap size of sglSetHeapConfig, SGL_DATA_MEM_SIZE by default */
+    uint32_t buffer_bytes;  /* Storage of live buffers, against buffer_budget */
+    uint32_t buffer_peak;
+    uint32_t buffer_failed;
+    uint8_t *uniform_arena;
+    uint32_t uniform_offset;
+    uint32_t uniform_high_water;
+    uint8_t *client_arena;
+    uint32_t client_offset;
+    uint32_t client_high_water;
+
+    GLsizei render_width;   /* sglSetRenderResolution, 0 = surface size */
+    GLsizei render_height;
+
+    int slot;
+    uint32_t generation;
+
+    /* Program and textures bound since generation bound_generation: as in
+     * deko3d, binding them again is not counted as a state change */
+    uint32_t bound_generation;
+    sgl_handle_t bound_program;
+    sgl_handle_t bound_textures[SGL_MAX_TEXTURE_UNITS];
+    sgl_frame_stats_t stats;        /* Frame being recorded */
+    sgl_frame_stats_t last_stats;   /* Last frame ended */
+    uint32_t barriers;
+    sgl_frame_stats_t list_saved;   /* Frame counters put aside while a command list records */
+
+    /* Draw log (null_backend_set_draw_log) and the state its records take */
+    null_draw_record_t *log;
+    uint32_t log_capacity;
+    uint32_t log_count;
+    uint32_t bound_uniforms;        /* Uniform hash of the bound program */
+    sgl_scissor_state_t scissor;
+    bool color_mask[4];
+    bool depth_test;
+    bool depth_write;
+    GLenum depth_func;
+} null_backend_data_t;
+
+static null_backend_data_t *null_data(sgl_backend_t *be) {
+    return (null_backend_data_t *)be->impl_data;
+}
+
+static sgl_handle_t null_new_handle(sgl_backend_t *be) {
+    return ++null_data(be)->next_handle;
+}
+
+/* Entry for handle, growing the table as needed; NULL for 0 or no memory */
+static void *null_table_get(null_table_t *t, sgl_handle_t handle, bool create) {
+    if (handle == 0) return NULL;
+    if (handle >= t->capacity) {
+        if (!create) return NULL;
+        uint32_t capacity = t->capacity ? t->capacity : 64;
+        while (capacity <= handle) capacity *= 2;
+        void *items = realloc(t->items, (size_t)capacity * t->item_size);
+        if (!items) return NULL;
+        memset((uint8_t *)items + (size_t)t->capacity * t->item_size, 0,
+               (size_t)(capacity - t->capacity) * t->item_size);
+        t->items = items;
+        t->capacity = capacity;
+    }
+    return (uint8_t *)t->items + (size_t)handle * t->item_size;
+}
+
+static uint32_t null_alloc_offset(null_backend_data_t *nb, uint32_t size) {
+    uint32_t offset = nb->data_offset;
+    nb->data_offset += SGL_ALIGN_UP(size ? size : 1, NULL_DATA_ALIGNMENT);
+    if (nb->data_offset < offset) {     /* Wrapped */
+        offset = NULL_DATA_ALIGNMENT;
+        nb->data_offset = offset + SGL_ALIGN_UP(size ? size : 1, NULL_DATA_ALIGNMENT);
+    }
+    return offset;
+}
+
+static void null_code_free(null_code_t *c) {
+    free(c->code);
+    c->code = NULL;
+    c->size = 0;
+}
+
+static bool null_code_copy(null_code_t *dst, const void *data, size_t size) {
+    null_code_free(dst);
+    if (!data || size == 0) return true;
+    dst->code = malloc(size);
+    if (!dst->code) return false;
+    memcpy(dst->code, data, size);
+    dst->size = (uint32_t)size;
+    return true;
+}
+
+/* ============================================================================
+ * Lifecycle
+ * ============================================================================ */
+
+static void null_program_free_packed(null_program_t *p) {
+    for (int stage = 0; stage < 2; stage++) {
+        for (int i = 0; i < SGL_MAX_PACKED_UBOS; i++) {
+            free(p->packed[stage][i]);
+            p->packed[stage][i] = NULL;
+            p->packed_size[stage][i] = 0;
+        }
+    }
+}
+
+/* FNV-1a, for the uniform data of a draw */
+static uint32_t null_hash(uint32_t hash, const void *data, uint32_t size) {
+    const uint8_t *p = (const uint8_t *)data;
+    for (uint32_t i = 0; i < size; i++) hash = (hash ^ p[i]) * 16777619u;
+    return hash;
+}
+
+/* Next record of the draw log, NULL when not logging or full */
+static null_draw_record_t *null_log_append(null_backend_data_t *nb) {
+    if (!nb->log) return NULL;
+    uint32_t index = nb->log_count++;
+    if (index >= nb->log_capacity) return NULL;
+    null_draw_record_t *r = &nb->log[index];
+    memset(r, 0, sizeof(*r));
+    return r;
+}
+
+static int null_init(sgl_backend_t *be, void *device, const struct sgl_heap_config *heaps) {
+    (void)device;
+    null_backend_data_t *nb = null_data(be);
+    nb->buffer_budget = heaps && heaps->data_size ? heaps->data_size : SGL_DATA_MEM_SIZE;
+    nb->uniform_arena = (uint8_t *)malloc(NULL_UNIFORM_ARENA_SIZE);
+    nb->client_arena = (uint8_t *)malloc(NULL_CLIENT_ARENA_SIZE);
+    if (!nb->uniform_arena || !nb->client_arena) {
+        SGL_ERROR_BACKEND("null: failed to allocate host arenas");
+        return -1;
+    }
+    nb->data_offset = NULL_DATA_ALIGNMENT;
+    nb->generation = 1;
+    return 0;
+}
+
+static void null_shutdown(sgl_backend_t *be) {
+    null_backend_data_t *nb = null_data(be);
+
+    for (uint32_t i = 0; i < nb->buffers.capacity; i++) {
+        free(((null_buffer_t *)nb->buffers.items)[i].data);
+    }
+    for (uint32_t i = 0; i < nb->shaders.capacity; i++) {
+        null_code_free(&((null_code_t *)nb->shaders.items)[i]);
+    }
+    for (uint32_t i = 0; i < nb->programs.capacity; i++) {
+        null_program_t *p = &((null_program_t *)nb->programs.items)[i];
+        null_code_free(&p->stages[0]);
+        null_code_free(&p->stages[1]);
+        null_program_free_packed(p);
+    }
+    free(nb->buffers.items);
+    free(nb->shaders.items);
+    free(nb->programs.items);
+    free(nb->queries.items);
+    free(nb->cmdlists.items);
+    free(nb->uniform_arena);
+    free(nb->client_arena);
+
+    memset(nb, 0, sizeof(*nb));
+    nb->buffers.item_size = sizeof(null_buffer_t);
+    nb->shaders.item_size = sizeof(null_code_t);
+    nb->programs.item_size = sizeof(null_program_t);
+    nb->queries.item_size = sizeof(GLenum);
+    nb->cmdlists.item_size = sizeof(null_cmdlist_t);
+}
+
+/* ============================================================================
+ * Frame Management
+ * ============================================================================ */
+
+static void null_begin_frame(sgl_backend_t *be, int slot) {
+    null_backend_data_t *nb = null_data(be);
+    nb->slot = slot;
+    nb->generation++;
+    nb->uniform_offset = 0;
+    nb->client_offset = 0;
+
+    /* A new command buffer has no state: draws log zeroes until it is applied */
+    memset(&nb->scissor, 0, sizeof(nb->scissor));
+    memset(nb->color_mask, 0, sizeof(nb->color_mask));
+    nb->depth_test = false;
+    nb->depth_write = false;
+    nb->depth_func = 0;
+}
+
+static void null_end_frame(sgl_backend_t *be, int slot) {
+    (void)slot;
+    null_backend_data_t *nb = null_data(be);
+    nb->stats.frame = nb->last_stats.frame + 1;
+    nb->last_stats = nb->stats;
+    memset(&nb->stats, 0, sizeof(nb->stats));
+}
+
+static void null_present(sgl_backend_t *be, int slot) {
+    (void)be;
+    (void)slot;
+}
+
+static int null_acquire_image(sgl_backend_t *be) {
+    return (null_data(be)->slot + 1) % NULL_NUM_SLOTS;
+}
+
+static void null_wait_fence(sgl_backend_t *be, int slot) {
+    (void)be;
+    (void)slot;
+}
+
+/* ============================================================================
+ * State Application
+ * ============================================================================ */
+
+static void null_apply_viewport(sgl_backend_t *be, const sgl_viewport_state_t *state) {
+    (void)state;
+    null_data(be)->stats.viewport_binds++;
+}
+
+static void null_apply_scissor(sgl_backend_t *be, const sgl_scissor_state_t *state) {
+    null_backend_data_t *nb = null_data(be);
+    nb->scissor = *state;
+    nb->stats.scissor_binds++;
+}
+
+static void null_apply_blend(sgl_backend_t *be, const sgl_blend_state_t *state) {
+    (void)state;
+    null_data(be)->stats.blend_binds++;
+}
+
+static void null_apply_depth(sgl_backend_t *be, const sgl_depth_state_t *state) {
+    null_backend_data_t *nb = null_data(be);
+    nb->depth_test = state->test_enabled;
+    nb->depth_write = state->write_enabled;
+    nb->depth_func = state->func;
+    nb->stats.depth_stencil_binds++;
+}
+
+static void null_apply_stencil(sgl_backend_t *be, const sgl_stencil_state_t *state) {
+    (void)state;
+    null_data(be)->stats.depth_stencil_binds++;
+}
+
+static void null_apply_depth_stencil(sgl_backend_t *be, const sgl_depth_stencil_state_t *state) {
+    null_backend_data_t *nb = null_data(be);
+    nb->depth_test = state->depth_test_enabled;
+    nb->depth_write = state->depth_write_enabled;
+    nb->depth_func = state->depth_func;
+    nb->stats.depth_stencil_binds++;
+}
+
+static void null_apply_raster(sgl_backend_t *be, const sgl_raster_state_t *state) {
+    (void)state;
+    null_data(be)->stats.raster_binds++;
+}
+
+static void null_apply_color_mask(sgl_backend_t *be, const sgl_color_state_t *state) {
+    null_backend_data_t *nb = null_data(be);
+    memcpy(nb->color_mask, state->mask, sizeof(nb->color_mask));
+    nb->stats.color_mask_binds++;
+}
+
+/* As dk_clear: the scissor is opened up, and a depth/stencil clear leaves
+ * the depth test off with writes on */
+static void null_clear(sgl_backend_t *be, GLbitfield mask, const float *color, float depth, int stencil) {
+    null_backend_data_t *nb = null_data(be);
+    nb->stats.clears++;
+
+    null_draw_record_t *r = null_log_append(nb);
+    if (r) {
+        r->clear_mask = mask;
+        if (mask & GL_COLOR_BUFFER_BIT) memcpy(r->clear_color, color, sizeof(r->clear_color));
+        if (mask & GL_DEPTH_BUFFER_BIT) r->clear_depth = depth;
+        if (mask & GL_STENCIL_BUFFER_BIT) r->clear_stencil = stencil;
+    }
+
+    nb->scissor = (sgl_scissor_state_t){ 0, 0, 4096, 4096, true };
+    if (mask & (GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT)) {
+        nb->depth_test = false;
+        nb->depth_write = true;
+        nb->depth_func = GL_ALWAYS;
+    }
+}
+
+/* ============================================================================
+ * Buffers
+ * ============================================================================ */
+
+static sgl_handle_t null_create_buffer(sgl_backend_t *be) {
+    return null_new_handle(be);
+}
+
+static void null_delete_buffer(sgl_backend_t *be, sgl_handle_t handle) {
+    null_buffer_t *b = (null_buffer_t *)null_table_get(&null_data(be)->buffers, handle, false);
+    if (!b) return;
+    null_data(be)->buffer_bytes -= b->size;
+    free(b->data);
+    memset(b, 0, sizeof(*b));
+}
+
+static uint32_t null_buffer_data(sgl_backend_t *be, sgl_handle_t handle, GLenum target,
+                                 GLsizeiptr size, const void *data, GLenum usage) {
+    (void)target;
+    (void)usage;
+    null_backend_data_t *nb = null_data(be);
+    null_buffer_t *b = (null_buffer_t *)null_table_get(&nb->buffers, handle, true);
+    if (!b || size < 0) return 0;
+
+    if ((uint32_t)size != b->size) {
+        uint8_t *storage = (uint8_t *)realloc(b->data, size ? (size_t)size : 1);
+        if (!storage) {
+            nb->buffer_failed++;
+            return 0;
+        }
+        nb->buffer_bytes += (uint32_t)size - b->size;
+        if (nb->buffer_bytes > nb->buffer_peak) nb->buffer_peak = nb->buffer_bytes;
+        b->data = storage;
+        b->size = (uint32_t)size;
+    }
+    if (data && size > 0) memcpy(b->data, data, (size_t)size);
+    b->offset = null_alloc_offset(nb, (uint32_t)size);
+    return b->offset;
+}
+
+static void null_buffer_sub_data(sgl_backend_t *be, sgl_handle_t handle, uint32_t buffer_offset,
+                                 GLsizeiptr size, const void *data) {
+    null_buffer_t *b = (null_buffer_t *)null_table_get(&null_data(be)->buffers, handle, false);
+    if (!b || !b->data || !data || size <= 0 || buffer_offset < b->offset) return;
+    uint32_t offset = buffer_offset - b->offset;
+    if ((uint64_t)offset + (uint64_t)size > b->size) return;
+    memcpy(b->data + offset, data, (size_t)size);
+}
+
+static void *null_map_buffer(sgl_backend_t *be, sgl_handle_t handle) {
+    null_buffer_t *b = (null_buffer_t *)null_table_get(&null_data(be)->buffers, handle, false);
+    return b ? b->data : NULL;
+}
+
+/* ============================================================================
+ * Textures (no storage)
+ * ============================================================================ */
+
+static sgl_handle_t null_create_texture(sgl_backend_t *be) {
+    return null_new_handle(be);
+}
+
+static void null_delete_texture(sgl_backend_t *be, sgl_handle_t handle) {
+    (void)be;
+    (void)handle;
+}
+
+static void null_texture_image_2d(sgl_backend_t *be, sgl_handle_t handle, GLenum target, GLint level,
+                                  GLint internalformat, GLsizei width, GLsizei height, GLint border,
+                                  GLenum format, GLenum type, const void *pixels) {
+    (void)be; (void)handle; (void)target; (void)level; (void)internalformat;
+    (void)width; (void)height; (void)border; (void)format; (void)type; (void)pixels;
+}
+
+static void null_texture_sub_image_2d(sgl_backend_t *be, sgl_handle_t handle, GLenum target, GLint level,
+                                      GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
+                                      GLenum format, GLenum type, const void *pixels) {
+    (void)be; (void)handle; (void)target; (void)level; (void)xoffset; (void)yoffset;
+    (void)width; (void)height; (void)format; (void)type; (void)pixels;
+}
+
+static void null_texture_parameter(sgl_backend_t *be, sgl_handle_t handle, GLenum target,
+                                   GLenum pname, GLint param) {
+    (void)be; (void)handle; (void)target; (void)pname; (void)param;
+}
+
+/* Forget the bound program and textures once the state was reset */
+static void null_sync_binds(null_backend_data_t *nb) {
+    if (nb->bound_generation == nb->generation) return;
+    nb->bound_generation = nb->generation;
+    nb->bound_program = 0;
+    nb->bound_uniforms = 0;
+    memset(nb->bound_textures, 0, sizeof(nb->bound_textures));
+}
+
+static void null_bind_texture(sgl_backend_t *be, GLuint unit, sgl_handle_t handle) {
+    null_backend_data_t *nb = null_data(be);
+    null_sync_binds(nb);
+    if (unit < SGL_MAX_TEXTURE_UNITS && nb->bound_textures[unit] == handle) return;
+    if (unit < SGL_MAX_TEXTURE_UNITS) nb->bound_textures[unit] = handle;
+    nb->stats.texture_binds++;
+}
+
+static void null_generate_mipmap(sgl_backend_t *be, sgl_handle_t handle) {
+    (void)be;
+    (void)handle;
+}
+
+static void null_copy_tex_image_2d(sgl_backend_t *be, sgl_handle_t handle, GLenum target, GLint level,
+                                   GLenum internalformat, GLint x, GLint y, GLsizei width, GLsizei height) {
+    (void)be; (void)handle; (void)target; (void)level; (void)internalformat;
+    (void)x; (void)y; (void)width; (void)height;
+}
+
+static void null_copy_tex_sub_image_2d(sgl_backend_t *be, sgl_handle_t handle, GLenum target, GLint level,
+                                       GLint xoffset, GLint yoffset, GLint x, GLint y,
+                                       GLsizei width, GLsizei height) {
+    (void)be; (void)handle; (void)target; (void)level; (void)xoffset; (void)yoffset;
+    (void)x; (void)y; (void)width; (void)height;
+}
+
+static void null_compressed_texture_image_2d(sgl_backend_t *be, sgl_handle_t handle, GLenum target,
+                                             GLint level, GLenum internalformat, GLsizei width,
+                                             GLsizei height, GLsizei imageSize, const void *data) {
+    (void)be; (void)handle; (void)target; (void)level; (void)internalformat;
+    (void)width; (void)height; (void)imageSize; (void)data;
+}
+
+static void null_compressed_texture_sub_image_2d(sgl_backend_t *be, sgl_handle_t handle, GLenum target,
+                                                 GLint level, GLint xoffset, GLint yoffset,
+                                                 GLsizei width, GLsizei height, GLenum format,
+                                                 GLsizei imageSize, const void *data) {
+    (void)be; (void)handle; (void)target; (void)level; (void)xoffset; (void)yoffset;
+    (void)width; (void)height; (void)format; (void)imageSize; (void)data;
+}
+
+/* Reads every level through the chunk-sized reads the GPU path makes, into a
+ * scratch buffer, so file loading costs the same I/O as on device */
+static bool null_compressed_texture_stream(sgl_backend_t *be, sgl_handle_t handle,
+                                           GLenum internalformat, GLsizei width, GLsizei height,
+                                           GLint levels, sgl_texture_read_fn read, void *user) {
+    (void)be; (void)handle;
+    enum { CHUNK = 256 * 1024 };
+    uint8_t *scratch = (uint8_t *)malloc(CHUNK);
+    if (!scratch) return false;
+
+    bool ok = true;
+    for (GLint level = 0; ok && level < levels; level++) {
+        uint32_t w = (uint32_t)width >> level ? (uint32_t)width >> level : 1;
+        uint32_t h = (uint32_t)height >> level ? (uint32_t)height >> level : 1;
+        uint32_t size = sgl_compressed_level_size(internalformat, w, h);
+        if (size == 0) ok = false;
+        for (uint32_t offset = 0; ok && offset < size; offset += CHUNK) {
+            uint32_t n = size - offset < CHUNK ? size - offset : CHUNK;
+            ok = read(user, level, offset, scratch, n);
+        }
+    }
+    free(scratch);
+    return ok;
+}
+
+static void null_compact_texture_heap(sgl_backend_t *be) {
+    (void)be;
+}
+
+static void null_pixel_store(sgl_backend_t *be, GLenum pname, GLint param) {
+    (void)be;
+    (void)pname;
+    (void)param;
+}
+
+/* ============================================================================
+ * Shaders and Programs
+ * ============================================================================ */
+
+static sgl_handle_t null_create_shader(sgl_backend_t *be, GLenum type) {
+    (void)type;
+    return null_new_handle(be);
+}
+
+static void null_delete_shader(sgl_backend_t *be, sgl_handle_t handle) {
+    null_code_t *c = (null_code_t *)null_table_get(&null_data(be)->shaders, handle, false);
+    if (c) null_code_free(c);
+}
+
+static bool null_load_shader_binary(sgl_backend_t *be, sgl_handle_t handle, const void *data, size_t size) {
+    null_code_t *c = (null_code_t *)null_table_get(&null_data(be)->shaders, handle, true);
+    return c && data && size > 0 && null_code_copy(c, data, size);
+}
+
+static bool null_load_shader_file(sgl_backend_t *be, sgl_handle_t handle, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    bool ok = false;
+    void *data = size > 0 ? malloc((size_t)size) : NULL;
+    if (data && fread(data, 1, (size_t)size, f) == (size_t)size) {
+        ok = null_load_shader_binary(be, handle, data, (size_t)size);
+    }
+    free(data);
+    fclose(f);
+    return ok;
+}
+
+static sgl_handle_t null_create_program(sgl_backend_t *be) {
+    return null_new_handle(be);
+}
+
+static void null_delete_program(sgl_backend_t *be, sgl_handle_t handle) {
+    null_program_t *p = (null_program_t *)null_table_get(&null_data(be)->programs, handle, false);
+    if (!p) return;
+    null_code_free(&p->stages[0]);
+    null_code_free(&p->stages[1]);
+    null_program_free_packed(p);
+}
+
+static void null_attach_shader(sgl_backend_t *be, sgl_handle_t program, sgl_handle_t shader) {
+    (void)be;
+    (void)program;
+    (void)shader;
+}
+
+static bool null_link_program(sgl_backend_t *be, sgl_handle_t program,
+                              sgl_handle_t vertex_shader, sgl_handle_t fragment_shader) {
+    null_backend_data_t *nb = null_data(be);
+    null_program_t *p = (null_program_t *)null_table_get(&nb->programs, program, true);
+    null_code_t *vs = (null_code_t *)null_table_get(&nb->shaders, vertex_shader, false);
+    null_code_t *fs = (null_code_t *)null_table_get(&nb->shaders, fragment_shader, false);
+    if (!p || !vs || !vs->code || !fs || !fs->code) return false;
+    null_program_free_packed(p);
+    return null_code_copy(&p->stages[0], vs->code, vs->size) &&
+           null_code_copy(&p->stages[1], fs->code, fs->size);
+}
+
+static void null_use_program(sgl_backend_t *be, sgl_handle_t handle) {
+    (void)be;
+    (void)handle;
+}
+
+static bool null_get_program_code(sgl_backend_t *be, sgl_handle_t program, int stage,
+                                  const void **code, uint32_t *size) {
+    null_program_t *p = (null_program_t *)null_table_get(&null_data(be)->programs, program, false);
+    if (!p || stage < 0 || stage > 1 || !p->stages[stage].code) return false;
+    *code = p->stages[stage].code;
+    *size = p->stages[stage].size;
+    return true;
+}
+
+static bool null_load_program_binary(sgl_backend_t *be, sgl_handle_t program,
+                                     const void *vs_code, size_t vs_size,
+                                     const void *fs_code, size_t fs_size) {
+    null_program_t *p = (null_program_t *)null_table_get(&null_data(be)->programs, program, true);
+    if (!p || !vs_code || !vs_size || !fs_code || !fs_size) return false;
+    null_program_free_packed(p);
+    return null_code_copy(&p->stages[0], vs_code, vs_size) &&
+           null_code_copy(&p->stages[1], fs_code, fs_size);
+}
+
+/* Count what the deko3d backend would push: dirty uniform ranges */
+static uint32_t null_dirty_uniform_bytes(const sgl_uniform_binding_t *uniforms, int max_uniforms,
+                                         const sgl_packed_ubo_t *packed, int max_packed) {
+    uint32_t bytes = 0;
+    for (int i = 0; uniforms && i < max_uniforms; i++) {
+        if (uniforms[i].valid && uniforms[i].dirty) bytes += uniforms[i].data_size;
+    }
+    for (int i = 0; packed && i < max_packed; i++) {
+        if (packed[i].valid && packed[i].dirty) bytes += packed[i].dirty_end - packed[i].dirty_begin;
+    }
+    return bytes;
+}
+
+/* Bring the program's copy of a packed UBO up to date as dk_bind_packed_ubo
+ * does: in full on its first bind in a frame or after a resize, otherwise
+ * only the dirty range. Returns the data the shader reads. */
+static const uint8_t *null_update_packed(null_backend_data_t *nb, null_program_t *p, int stage,
+                                         int binding, const sgl_packed_ubo_t *packed) {
+    if (!p) return packed->data;
+    uint8_t *copy = p->packed[stage][binding];
+    if (copy && p->packed_size[stage][binding] == packed->size &&
+        p->packed_generation[stage][binding] == nb->generation) {
+        uint32_t begin = packed->dirty_begin & ~3u;
+        uint32_t end = SGL_ALIGN_UP(packed->dirty_end, 4);
+        if (end > packed->size) end = packed->size;
+        if (packed->dirty && begin < end) memcpy(copy + begin, packed->data + begin, end - begin);
+        return copy;
+    }
+
+    copy = (uint8_t *)realloc(copy, packed->size);
+    if (!copy) return packed->data;
+    memcpy(copy, packed->data, packed->size);
+    p->packed[stage][binding] = copy;
+    p->packed_size[stage][binding] = packed->size;
+    p->packed_generation[stage][binding] = nb->generation;
+    return copy;
+}
+
+/* Hash of the uniform data the bound shaders read: legacy bindings from
+ * the arena (deko3d pushes them at bind time), packed UBOs from the copies */
+static uint32_t null_bind_uniforms(null_backend_data_t *nb, sgl_handle_t program,
+                                   const sgl_uniform_binding_t *vertex_uniforms,
+                                   const sgl_uniform_binding_t *fragment_uniforms, int max_uniforms,
+                                   const sgl_packed_ubo_t *packed_vertex,
+                                   const sgl_packed_ubo_t *packed_fragment, int max_packed_ubos) {
+    null_program_t *p = (null_program_t *)null_table_get(&nb->programs, program, false);
+    uint32_t hash = 2166136261u;
+    for (int stage = 0; stage < 2; stage++) {
+        const sgl_uniform_binding_t *ub = stage == 0 ? vertex_uniforms : fragment_uniforms;
+        const sgl_packed_ubo_t *packed = stage == 0 ? packed_vertex : packed_fragment;
+        for (int i = 0; ub && i < max_uniforms; i++) {
+            if (!ub[i].valid || ub[i].size == 0) continue;
+            uint32_t size = ub[i].data_size ? ub[i].data_size : ub[i].size;
+            if ((uint64_t)ub[i].offset + size > NULL_UNIFORM_ARENA_SIZE) continue;
+            uint32_t slot = (uint32_t)(stage << 8 | i);
+            hash = null_hash(hash, &slot, sizeof(slot));
+            hash = null_hash(hash, nb->uniform_arena + ub[i].offset, size);
+        }
+        for (int i = 0; packed && i < max_packed_ubos && i < SGL_MAX_PACKED_UBOS; i++) {
+            if (!packed[i].valid || packed[i].size == 0) continue;
+            uint32_t slot = (uint32_t)(stage << 8 | 0x80 | i);
+            hash = null_hash(hash, &slot, sizeof(slot));
+            hash = null_hash(hash, null_update_packed(nb, p, stage, i, &packed[i]), packed[i].size);
+        }
+    }
+    return hash;
+}
+
+static void null_bind_program(sgl_backend_t *be, sgl_handle_t program,
+                              sgl_handle_t vertex_shader, sgl_handle_t fragment_shader,
+                              const sgl_uniform_binding_t *vertex_uniforms,
+                              const sgl_uniform_binding_t *fragment_uniforms,
+                              int max_uniforms,
+                              const sgl_packed_ubo_t *packed_vertex,
+                              const sgl_packed_ubo_t *packed_fragment,
+                              int max_packed_ubos) {
+    (void)vertex_shader;
+    (void)fragment_shader;
+    null_backend_data_t *nb = null_data(be);
+    null_sync_binds(nb);
+    if (nb->bound_program != program) {
+        /* Texture handles are bound again after a shader change */
+        nb->bound_program = program;
+        memset(nb->bound_textures, 0, sizeof(nb->bound_textures));
+        nb->stats.shader_binds++;
+    }
+    nb->stats.uniform_bytes +=
+        null_dirty_uniform_bytes(vertex_uniforms, max_uniforms, packed_vertex, max_packed_ubos) +
+        null_dirty_uniform_bytes(fragment_uniforms, max_uniforms, packed_fragment, max_packed_ubos);
+    nb->bound_uniforms = null_bind_uniforms(nb, program, vertex_uniforms, fragment_uniforms, max_uniforms,
+                                            packed_vertex, packed_fragment, max_packed_ubos);
+}
+
+/* ============================================================================
+ * Uniforms
+ * ============================================================================ */
+
+static void null_set_uniform_4f(sgl_backend_t *be, sgl_handle_t program, GLint location,
+                                GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3) {
+    (void)be; (void)program; (void)location; (void)v0; (void)v1; (void)v2; (void)v3;
+}
+
+static void null_set_uniform_matrix4fv(sgl_backend_t *be, sgl_handle_t program, GLint location,
+                                       GLsizei count, GLboolean transpose, const GLfloat *value) {
+    (void)be; (void)program; (void)location; (void)count; (void)transpose; (void)value;
+}
+
+/* The arena restarts every frame and wraps instead of failing */
+static uint32_t null_alloc_uniform(sgl_backend_t *be, uint32_t size) {
+    null_backend_data_t *nb = null_data(be);
+    uint32_t aligned = SGL_ALIGN_UP(size, SGL_UNIFORM_ALIGNMENT);
+    if (aligned > NULL_UNIFORM_ARENA_SIZE) return 0;
+    if (nb->uniform_offset + aligned > NULL_UNIFORM_ARENA_SIZE) nb->uniform_offset = 0;
+    uint32_t offset = nb->uniform_offset;
+    nb->uniform_offset += aligned;
+    if (nb->uniform_offset > nb->uniform_high_water) nb->uniform_high_water = nb->uniform_offset;
+    return offset;
+}
+
+static void null_write_uniform(sgl_backend_t *be, uint32_t offset, const void *data, uint32_t size) {
+    null_backend_data_t *nb = null_data(be);
+    if (!data || (uint64_t)offset + size > NULL_UNIFORM_ARENA_SIZE) return;
+    memcpy(nb->uniform_arena + offset, data, size);
+}
+
+static void null_get_uniform_stats(sgl_backend_t *be, uint32_t *used, uint32_t *high_water, uint32_t *capacity) {
+    null_backend_data_t *nb = null_data(be);
+    if (used) *used = nb->uniform_offset;
+    if (high_water) *high_water = nb->uniform_high_water;
+    if (capacity) *capacity = NULL_UNIFORM_ARENA_SIZE;
+}
+
+/* ============================================================================
+ * Vertex Attributes and Draws
+ * ============================================================================ */
+
+static uint32_t null_attrib_type_size(GLenum type) {
+    switch (type) {
+        case GL_BYTE:
+        case GL_UNSIGNED_BYTE:  return 1;
+        case GL_SHORT:
+        case GL_UNSIGNED_SHORT: return 2;
+        default:                return 4;
+    }
+}
+
+/* Client arrays are copied like the deko3d backend does, into a scratch arena */
+static void null_bind_vertex_attribs(sgl_backend_t *be, const sgl_vertex_attrib_t *attribs,
+                                     int num_attribs, GLint first, GLsizei count, GLsizei instances) {
+    null_backend_data_t *nb = null_data(be);
+    nb->stats.vertex_binds++;
+
+    for (int i = 0; i < num_attribs; i++) {
+        const sgl_vertex_attrib_t *a = &attribs[i];
+        if (!a->enabled || a->buffer != 0 || !a->pointer) continue;
+
+        uint32_t elem = (uint32_t)a->size * null_attrib_type_size(a->type);
+        uint32_t stride = a->stride ? (uint32_t)a->stride : elem;
+        uint32_t elements = a->divisor ? ((uint32_t)instances + a->divisor - 1) / a->divisor
+                                       : (uint32_t)(first + count);
+        uint32_t bytes = elements ? (elements - 1) * stride + elem : 0;
+        if (bytes > NULL_CLIENT_ARENA_SIZE) continue;
+        if (nb->client_offset + bytes > NULL_CLIENT_ARENA_SIZE) nb->client_offset = 0;
+        memcpy(nb->client_arena + nb->client_offset, a->pointer, bytes);
+        nb->client_offset = SGL_ALIGN_UP(nb->client_offset + bytes, 4);
+        if (nb->client_offset > nb->client_high_water) nb->client_high_water = nb->client_offset;
+        nb->stats.client_array_bytes += bytes;
+    }
+}
+
+static void null_bind_vertex_array(sgl_backend_t *be, GLuint vao, const sgl_vertex_attrib_t *attribs,
+                                   int num_attribs, bool layout_dirty) {
+    (void)vao;
+    (void)attribs;
+    (void)num_attribs;
+    (void)layout_dirty;
+    null_data(be)->stats.vertex_binds++;
+}
+
+static void null_delete_vertex_array(sgl_backend_t *be, GLuint vao) {
+    (void)be;
+    (void)vao;
+}
+
+static void null_log_draw(null_backend_data_t *nb, bool elements, GLenum mode, GLint first,
+                          GLsizei count, uint32_t ebo_offset, GLsizei instances) {
+    null_draw_record_t *r = null_log_append(nb);
+    if (!r) return;
+    null_sync_binds(nb);
+    r->program = nb->bound_program;
+    r->uniforms = nb->bound_uniforms;
+    memcpy(r->textures, nb->bound_textures, sizeof(r->textures));
+    r->scissor = nb->scissor;
+    memcpy(r->color_mask, nb->color_mask, sizeof(r->color_mask));
+    r->depth_test = nb->depth_test;
+    r->depth_write = nb->depth_write;
+    r->depth_func = nb->depth_func;
+    r->elements = elements;
+    r->mode = mode;
+    r->first = first;
+    r->count = count;
+    r->ebo_offset = ebo_offset;
+    r->instances = instances;
+}
+
+static void null_draw_arrays(sgl_backend_t *be, GLenum mode, GLint first, GLsizei count, GLsizei instances) {
+    null_backend_data_t *nb = null_data(be);
+    null_log_draw(nb, false, mode, first, count, 0, instances);
+    nb->stats.draws++;
+}
+
+static void null_draw_elements(sgl_backend_t *be, GLenum mode, GLsizei count, GLenum type,
+                               const void *indices, uint32_t ebo_offset, GLsizei instances) {
+    null_backend_data_t *nb = null_data(be);
+    /* Client indices not staged by upload_indices are copied here */
+    if (ebo_offset == 0 && indices && count > 0) {
+        uint32_t bytes = (uint32_t)count * (type == GL_UNSIGNED_INT ? 4 : 2);
+        nb->stats.client_array_bytes += bytes;
+    }
+    null_log_draw(nb, true, mode, 0, count, ebo_offset, instances);
+    nb->stats.draws++;
+}
+
+static uint32_t null_upload_indices(sgl_backend_t *be, GLenum type, const void *indices, GLsizei count,
+                                    GLenum *out_type, GLuint *out_min, GLuint *out_max) {
+    null_backend_data_t *nb = null_data(be);
+    *out_min = 0;
+    *out_max = 0;
+    if (count <= 0 || !indices) return 0;
+
+    uint32_t bytes = (uint32_t)count * (type == GL_UNSIGNED_INT ? 4 : 2);
+    if (bytes > NULL_CLIENT_ARENA_SIZE) return 0;
+    if (nb->client_offset + bytes > NULL_CLIENT_ARENA_SIZE) nb->client_offset = 0;
+    uint8_t *dst = nb->client_arena + nb->client_offset;
+
+    uint32_t lo, hi;
+    switch (type) {
+        case GL_UNSIGNED_BYTE:
+            sgl_index_widen_u8((uint16_t *)dst, (const uint8_t *)indices, (uint32_t)count, &lo, &hi);
+            *out_type = GL_UNSIGNED_SHORT;
+            break;
+        case GL_UNSIGNED_SHORT:
+            sgl_index_copy_u16((uint16_t *)dst, (const uint16_t *)indices, (uint32_t)count, &lo, &hi);
+            *out_type = GL_UNSIGNED_SHORT;
+            break;
+        case GL_UNSIGNED_INT:
+            sgl_index_copy_u32((uint32_t *)dst, (const uint32_t *)indices, (uint32_t)count, &lo, &hi);
+            *out_type = GL_UNSIGNED_INT;
+            break;
+        default:
+            return 0;
+    }
+
+    nb->client_offset = SGL_ALIGN_UP(nb->client_offset + bytes, 4);
+    if (nb->client_offset > nb->client_high_water) nb->client_high_water = nb->client_offset;
+    nb->stats.client_array_bytes += bytes;
+    *out_min = lo;
+    *out_max = hi;
+    return null_alloc_offset(nb, bytes);
+}
+
+static void null_multi_draw_arrays(sgl_backend_t *be, GLenum mode, const GLint *first, const GLsizei *count,
+                                   GLsizei drawcount, int ubo_stage, int ubo_binding, const GLuint *ubo_offsets) {
+    (void)mode;
+    (void)first;
+    (void)ubo_stage;
+    (void)ubo_binding;
+    (void)ubo_offsets;
+    null_backend_data_t *nb = null_data(be);
+    for (GLsizei i = 0; i < drawcount; i++) {
+        if (count[i] > 0) nb->stats.draws++;
+    }
+}
+
+static void null_multi_draw_elements(sgl_backend_t *be, GLenum mode, const GLsizei *count, GLenum type,
+                                     const uint32_t *index_offsets, GLsizei drawcount,
+                                     int ubo_stage, int ubo_binding, const GLuint *ubo_offsets) {
+    (void)mode;
+    (void)type;
+    (void)index_offsets;
+    (void)ubo_stage;
+    (void)ubo_binding;
+    (void)ubo_offsets;
+    null_backend_data_t *nb = null_data(be);
+    for (GLsizei i = 0; i < drawcount; i++) {
+        if (count[i] > 0) nb->stats.draws++;
+    }
+}
+
+/* ============================================================================
+ * Framebuffers and Readback
+ * ============================================================================ */
+
+static sgl_handle_t null_create_framebuffer(sgl_backend_t *be) {
+    return null_new_handle(be);
+}
+
+static void null_delete_framebuffer(sgl_backend_t *be, sgl_handle_t handle) {
+    (void)be;
+    (void)handle;
+}
+
+static void null_bind_framebuffer(sgl_backend_t *be, sgl_handle_t handle,
+                                  sgl_handle_t color_tex, sgl_handle_t depth_rb) {
+    (void)be;
+    (void)handle;
+    (void)color_tex;
+    (void)depth_rb;
+}
+
+static void null_framebuffer_texture(sgl_backend_t *be, sgl_handle_t fbo, GLenum attachment,
+                                     GLenum textarget, sgl_handle_t texture, GLint level) {
+    (void)be;
+    (void)fbo;
+    (void)attachment;
+    (void)textarget;
+    (void)texture;
+    (void)level;
+}
+
+static GLenum null_check_framebuffer_status(sgl_backend_t *be, sgl_handle_t handle) {
+    (void)be;
+    (void)handle;
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+static void null_draw_buffers(sgl_backend_t *be, sgl_handle_t handle, uint32_t mask) {
+    (void)be;
+    (void)handle;
+    (void)mask;
+}
+
+static bool null_blit_framebuffer(sgl_backend_t *be, sgl_handle_t read_fbo, sgl_handle_t read_color,
+                                  const GLint src[4], const GLint dst[4], GLenum filter) {
+    (void)be;
+    (void)read_fbo;
+    (void)read_color;
+    (void)src;
+    (void)dst;
+    (void)filter;
+    return true;
+}
+
+static void null_discard_framebuffer(sgl_backend_t *be, uint32_t color_mask, bool depth_stencil) {
+    (void)be;
+    (void)color_mask;
+    (void)depth_stencil;
+}
+
+static void null_renderbuffer_storage(sgl_backend_t *be, sgl_handle_t handle, GLenum internalformat,
+                                      GLsizei width, GLsizei height) {
+    (void)be;
+    (void)handle;
+    (void)internalformat;
+    (void)width;
+    (void)height;
+}
+
+static void null_delete_renderbuffer(sgl_backend_t *be, sgl_handle_t handle) {
+    (void)be;
+    (void)handle;
+}
+
+/* Reads back zeros */
+static void null_read_pixels(sgl_backend_t *be, GLint x, GLint y, GLsizei width, GLsizei height,
+                             GLenum format, GLenum type, void *pixels) {
+    (void)be;
+    (void)x;
+    (void)y;
+    (void)format;
+    (void)type;
+    /* Like deko3d, readback is always RGBA8 */
+    if (!pixels || width <= 0 || height <= 0) return;
+    memset(pixels, 0, (size_t)width * (size_t)height * 4);
+}
+
+static void null_read_pixels_to_buffer(sgl_backend_t *be, GLint x, GLint y, GLsizei width, GLsizei height,
+                                       GLenum format, GLenum type, sgl_handle_t buffer, uint32_t offset) {
+    (void)x; (void)y; (void)format; (void)type;
+    null_buffer_t *b = (null_buffer_t *)null_table_get(&null_data(be)->buffers, buffer, false);
+    if (!b || !b->data || offset < b->offset || width <= 0 || height <= 0) return;
+    uint64_t start = offset - b->offset;
+    uint64_t bytes = (uint64_t)width * (uint64_t)height * 4;
+    if (start + bytes <= b->size) memset(b->data + start, 0, (size_t)bytes);
+}
+
+/* ============================================================================
+ * Sync and Statistics
+ * ============================================================================ */
+
+static void null_flush(sgl_backend_t *be) {
+    (void)be;
+}
+
+static void null_finish(sgl_backend_t *be) {
+    (void)be;
+}
+
+static void null_insert_barrier(sgl_backend_t *be) {
+    null_backend_data_t *nb = null_data(be);
+    nb->stats.barriers++;
+    nb->barriers++;
+}
+
+static void null_get_frame_stats(sgl_backend_t *be, struct sgl_frame_stats *stats) {
+    *stats = null_data(be)->last_stats;
+}
+
+static void null_get_barrier_stats(sgl_backend_t *be, uint32_t *full, uint32_t *fragments, uint32_t *tiles) {
+    if (full) *full = null_data(be)->barriers;
+    if (fragments) *fragments = 0;
+    if (tiles) *tiles = 0;
+}
+
+static void null_get_cmd_mem_stats(sgl_backend_t *be, uint32_t *peak, uint32_t *pooled) {
+    (void)be;
+    if (peak) *peak = 0;
+    if (pooled) *pooled = 0;
+}
+
+/* Buffers are budgeted like the deko3d buffer heap; the arenas wrap and never fail */
+static void null_get_memory_stats(sgl_backend_t *be, struct sgl_memory_stats *stats) {
+    null_backend_data_t *nb = null_data(be);
+
+    /* No code heap: shader and program code live on the host heap until freed */
+    sgl_memory_heap_stats_t *h = &stats->heaps[SGL_MEMORY_HEAP_CODE];
+    for (uint32_t i = 0; i < nb->shaders.capacity; i++) {
+        h->used += ((null_code_t *)nb->shaders.items)[i].size;
+    }
+    for (uint32_t i = 0; i < nb->programs.capacity; i++) {
+        const null_program_t *p = &((null_program_t *)nb->programs.items)[i];
+        h->used += p->stages[0].size + p->stages[1].size;
+    }
+    h->peak = h->used;
+
+    h = &stats->heaps[SGL_MEMORY_HEAP_BUFFER];
+    h->capacity = nb->buffer_budget;
+    h->used = nb->buffer_bytes;
+    h->peak = nb->buffer_peak;
+    h->largest_free = nb->buffer_bytes < nb->buffer_budget ? nb->buffer_budget - nb->buffer_bytes : 0;
+    h->failed_allocs = nb->buffer_failed;
+
+    h = &stats->heaps[SGL_MEMORY_HEAP_UNIFORM];
+    h->capacity = NULL_UNIFORM_ARENA_SIZE;
+    h->used = nb->uniform_offset;
+    h->peak = nb->uniform_high_water;
+    h->largest_free = NULL_UNIFORM_ARENA_SIZE - nb->uniform_offset;
+
+    h = &stats->heaps[SGL_MEMORY_HEAP_CLIENT_ARRAY];
+    h->capacity = NULL_CLIENT_ARENA_SIZE;
+    h->used = nb->client_offset;
+    h->peak = nb->client_high_water;
+    h->largest_free = NULL_CLIENT_ARENA_SIZE - nb->client_offset;
+}
+
+static uint32_t null_get_state_generation(sgl_backend_t *be) {
+    return null_data(be)->generation;
+}
+
+/* Nothing runs, so every fence is signaled as soon as it exists */
+static sgl_handle_t null_create_sync(sgl_backend_t *be) {
+    return null_new_handle(be);
+}
+
+static void null_delete_sync(sgl_backend_t *be, sgl_handle_t sync) {
+    (void)be; (void)sync;
+}
+
+static bool null_wait_sync(sgl_backend_t *be, sgl_handle_t sync, uint64_t timeout_ns) {
+    (void)be; (void)sync; (void)timeout_ns;
+    return true;
+}
+
+/* ============================================================================
+ * Recorders (record straight into the null stream)
+ * ============================================================================ */
+
+static sgl_handle_t null_create_recorder(sgl_backend_t *be) {
+    return null_new_handle(be);
+}
+
+static void null_delete_recorder(sgl_backend_t *be, sgl_handle_t handle) {
+    (void)be;
+    (void)handle;
+}
+
+static bool null_begin_recorder(sgl_backend_t *be, sgl_handle_t handle) {
+    (void)be;
+    (void)handle;
+    return true;
+}
+
+static void null_attach_recorder(sgl_backend_t *be, sgl_handle_t handle) {
+    (void)be;
+    (void)handle;
+}
+
+static void null_submit_recorders(sgl_backend_t *be, const sgl_handle_t *handles, int count) {
+    (void)be;
+    (void)handles;
+    (void)count;
+}
+
+/* ============================================================================
+ * Command Lists (recording counts into the list, calls add it to the frame)
+ * ============================================================================ */
+
+static sgl_handle_t null_begin_cmdlist(sgl_backend_t *be) {
+    null_backend_data_t *nb = null_data(be);
+    sgl_handle_t handle = null_new_handle(be);
+    null_cmdlist_t *list = (null_cmdlist_t *)null_table_get(&nb->cmdlists, handle, true);
+    if (!list) return 0;
+    memset(list, 0, sizeof(*list));
+    list->used = true;
+
+    nb->list_saved = nb->stats;
+    memset(&nb->stats, 0, sizeof(nb->stats));
+    nb->generation++;
+    return handle;
+}
+
+static bool null_end_cmdlist(sgl_backend_t *be, sgl_handle_t handle) {
+    null_backend_data_t *nb = null_data(be);
+    null_cmdlist_t *list = (null_cmdlist_t *)null_table_get(&nb->cmdlists, handle, false);
+    if (!list || !list->used) return false;
+
+    list->stats = nb->stats;
+    nb->stats = nb->list_saved;
+    nb->generation++;
+    return true;
+}
+
+static void null_call_cmdlist(sgl_backend_t *be, sgl_handle_t handle) {
+    null_backend_data_t *nb = null_data(be);
+    null_cmdlist_t *list = (null_cmdlist_t *)null_table_get(&nb->cmdlists, handle, false);
+    if (!list || !list->used) return;
+
+    sgl_frame_stats_t *s = &nb->stats;
+    const sgl_frame_stats_t *l = &list->stats;
+    s->draws += l->draws;
+    s->clears += l->clears;
+    s->viewport_binds += l->viewport_binds;
+    s->scissor_binds += l->scissor_binds;
+    s->blend_binds += l->blend_binds;
+    s->depth_stencil_binds += l->depth_stencil_binds;
+    s->raster_binds += l->raster_binds;
+    s->color_mask_binds += l->color_mask_binds;
+    s->vertex_binds += l->vertex_binds;
+    s->shader_binds += l->shader_binds;
+    s->texture_binds += l->texture_binds;
+    s->uniform_bytes += l->uniform_bytes;
+    nb->generation++;
+}
+
+static void null_delete_cmdlist(sgl_backend_t *be, sgl_handle_t handle) {
+    null_cmdlist_t *list = (null_cmdlist_t *)null_table_get(&null_data(be)->cmdlists, handle, false);
+    if (list) list->used = false;
+}
+
+/* ============================================================================
+ * Shared Contexts (nothing to record: upload threads need no stream of their own;
+ * host tests hand the backend from one thread to the other, never share it live)
+ * ============================================================================ */
+
+static void null_share(sgl_backend_t *be) {
+    (void)be;
+}
+
+static bool null_attach_upload_thread(sgl_backend_t *be) {
+    (void)be;
+    return true;
+}
+
+static void null_detach_upload_thread(sgl_backend_t *be) {
+    (void)be;
+}
+
+/* ============================================================================
+ * Queries (complete immediately)
+ * ============================================================================ */
+
+static sgl_handle_t null_create_query(sgl_backend_t *be) {
+    return null_new_handle(be);
+}
+
+static void null_delete_query(sgl_backend_t *be, sgl_handle_t query) {
+    GLenum *target = (GLenum *)null_table_get(&null_data(be)->queries, query, false);
+    if (target) *target = 0;
+}
+
+static void null_begin_query(sgl_backend_t *be, sgl_handle_t query, GLenum target) {
+    GLenum *t = (GLenum *)null_table_get(&null_data(be)->queries, query, true);
+    if (t) *t = target;
+}
+
+static void null_end_query(sgl_backend_t *be, sgl_handle_t query) {
+    (void)be;
+    (void)query;
+}
+
+static void null_query_counter(sgl_backend_t *be, sgl_handle_t query) {
+    null_begin_query(be, query, GL_TIMESTAMP_EXT);
+}
+
+static uint64_t null_get_gpu_timestamp(sgl_backend_t *be) {
+    (void)be;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static bool null_get_query_result(sgl_backend_t *be, sgl_handle_t query, bool wait, uint64_t *result) {
+    (void)wait;
+    GLenum *target = (GLenum *)null_table_get(&null_data(be)->queries, query, false);
+    if (!target || !*target) return false;
+    switch (*target) {
+        case GL_ANY_SAMPLES_PASSED_EXT:
+        case GL_ANY_SAMPLES_PASSED_CONSERVATIVE_EXT:
+            *result = 1;
+            break;
+        case GL_TIMESTAMP_EXT:
+            *result = null_get_gpu_timestamp(be);
+            break;
+        default:
+            *result = 0;
+            break;
+    }
+    return true;
+}
+
+static bool null_get_last_query_result(sgl_backend_t *be, sgl_handle_t query, uint64_t *result) {
+    return null_get_query_result(be, query, false, result);
+}
+
+/* ============================================================================
+ * Render Resolution (recorded, nothing is rendered)
+ * ============================================================================ */
+
+static void null_set_render_resolution(sgl_backend_t *be, GLsizei width, GLsizei height) {
+    null_backend_data_t *nb = null_data(be);
+    nb->render_width = width;
+    nb->render_height = height;
+}
+
+static void null_set_dynamic_resolution(sgl_backend_t *be, uint64_t target_ns, float min_scale) {
+    (void)be;
+    (void)target_ns;
+    (void)min_scale;
+}
+
+static void null_get_render_resolution(sgl_backend_t *be, GLsizei *width, GLsizei *height) {
+    null_backend_data_t *nb = null_data(be);
+    *width = nb->render_width ? nb->render_width : SGL_FB_WIDTH;
+    *height = nb->render_height ? nb->render_height : SGL_FB_HEIGHT;
+}
+
+/* ============================================================================
+ * Misc
+ * ============================================================================ */
+
+static void null_set_line_width(sgl_backend_t *be, GLfloat width) {
+    (void)width;
+    null_data(be)->stats.raster_binds++;
+}
+
+static void null_set_depth_bias(sgl_backend_t *be, GLfloat factor, GLfloat units) {
+    (void)factor;
+    (void)units;
+    null_data(be)->stats.raster_binds++;
+}
+
+static void null_set_blend_color(sgl_backend_t *be, GLfloat r, GLfloat g, GLfloat b, GLfloat a) {
+    (void)r;
+    (void)g;
+    (void)b;
+    (void)a;
+    null_data(be)->stats.blend_binds++;
+}
+
+/* ============================================================================
+ * Backend Operations Table
+ * ============================================================================ */
+
+static const sgl_backend_ops_t null_backend_ops = {
+    .init = null_init,
+    .shutdown = null_shutdown,
+
+    .begin_frame = null_begin_frame,
+    .end_frame = null_end_frame,
+    .present = null_present,
+    .acquire_image = null_acquire_image,
+    .wait_fence = null_wait_fence,
+
+    .apply_viewport = null_apply_viewport,
+    .apply_scissor = null_apply_scissor,
+    .apply_blend = null_apply_blend,
+    .apply_depth = null_apply_depth,
+    .apply_stencil = null_apply_stencil,
+    .apply_depth_stencil = null_apply_depth_stencil,
+    .apply_raster = null_apply_raster,
+    .apply_color_mask = null_apply_color_mask,
+
+    .clear = null_clear,
+
+    .create_buffer = null_create_buffer,
+    .delete_buffer = null_delete_buffer,
+    .buffer_data = null_buffer_data,
+    .buffer_sub_data = null_buffer_sub_data,
+    .map_buffer = null_map_buffer,
+
+    .create_texture = null_create_texture,
+    .delete_texture = null_delete_texture,
+    .texture_image_2d = null_texture_image_2d,
+    .texture_sub_image_2d = null_texture_sub_image_2d,
+    .texture_parameter = null_texture_parameter,
+    .bind_texture = null_bind_texture,
+    .generate_mipmap = null_generate_mipmap,
+    .copy_tex_image_2d = null_copy_tex_image_2d,
+    .copy_tex_sub_image_2d = null_copy_tex_sub_image_2d,
+    .compressed_texture_image_2d = null_compressed_texture_image_2d,
+    .compressed_texture_sub_image_2d = null_compressed_texture_sub_image_2d,
+    .compressed_texture_stream = null_compressed_texture_stream,
+    .compact_texture_heap = null_compact_texture_heap,
+    .pixel_store = null_pixel_store,
+
+    .create_shader = null_create_shader,
+    .delete_shader = null_delete_shader,
+    .load_shader_binary = null_load_shader_binary,
+    .load_shader_file = null_load_shader_file,
+
+    .create_program = null_create_program,
+    .delete_program = null_delete_program,
+    .attach_shader = null_attach_shader,
+    .link_program = null_link_program,
+    .use_program = null_use_program,
+    .get_program_code = null_get_program_code,
+    .load_program_binary = null_load_program_binary,
+    .bind_program = null_bind_program,
+
+    .set_uniform_4f = null_set_uniform_4f,
+    .set_uniform_matrix4fv = null_set_uniform_matrix4fv,
+    .alloc_uniform = null_alloc_uniform,
+    .write_uniform = null_write_uniform,
+    .get_uniform_stats = null_get_uniform_stats,
+
+    .bind_vertex_attribs = null_bind_vertex_attribs,
+    .bind_vertex_array = null_bind_vertex_array,
+    .delete_vertex_array = null_delete_vertex_array,
+
+    .draw_arrays = null_draw_arrays,
+    .draw_elements = null_draw_elements,
+    .upload_indices = null_upload_indices,
+    .multi_draw_arrays = null_multi_draw_arrays,
+    .multi_draw_elements = null_multi_draw_elements,
+
+    .create_framebuffer = null_create_framebuffer,
+    .delete_framebuffer = null_delete_framebuffer,
+    .bind_framebuffer = null_bind_framebuffer,
+    .framebuffer_texture = null_framebuffer_texture,
+    .check_framebuffer_status = null_check_framebuffer_status,
+    .draw_buffers = null_draw_buffers,
+    .blit_framebuffer = null_blit_framebuffer,
+    .discard_framebuffer = null_discard_framebuffer,
+
+    .renderbuffer_storage = null_renderbuffer_storage,
+    .delete_renderbuffer = null_delete_renderbuffer,
+
+    .read_pixels = null_read_pixels,
+    .read_pixels_to_buffer = null_read_pixels_to_buffer,
+
+    .flush = null_flush,
+    .finish = null_finish,
+    .insert_barrier = null_insert_barrier,
+    .get_frame_stats = null_get_frame_stats,
+    .get_barrier_stats = null_get_barrier_stats,
+    .get_cmd_mem_stats = null_get_cmd_mem_stats,
+    .get_memory_stats = null_get_memory_stats,
+    .get_state_generation = null_get_state_generation,
+    .create_sync = null_create_sync,
+    .delete_sync = null_delete_sync,
+    .wait_sync = null_wait_sync,
+
+    .create_recorder = null_create_recorder,
+    .delete_recorder = null_delete_recorder,
+    .begin_recorder = null_begin_recorder,
+    .attach_recorder = null_attach_recorder,
+    .submit_recorders = null_submit_recorders,
+
+    .begin_cmdlist = null_begin_cmdlist,
+    .end_cmdlist = null_end_cmdlist,
+    .call_cmdlist = null_call_cmdlist,
+    .delete_cmdlist = null_delete_cmdlist,
+
+    .share = null_share,
+    .attach_upload_thread = null_attach_upload_thread,
+    .detach_upload_thread = null_detach_upload_thread,
+
+    .create_query = null_create_query,
+    .delete_query = null_delete_query,
+    .begin_query = null_begin_query,
+    .end_query = null_end_query,
+    .query_counter = null_query_counter,
+    .get_query_result = null_get_query_result,
+    .get_last_query_result = null_get_last_query_result,
+    .get_gpu_timestamp = null_get_gpu_timestamp,
+
+    .set_render_resolution = null_set_render_resolution,
+    .set_dynamic_resolution = null_set_dynamic_resolution,
+    .get_render_resolution = null_get_render_resolution,
+
+    .set_line_width = null_set_line_width,
+    .set_depth_bias = null_set_depth_bias,
+    .set_blend_color = null_set_blend_color,
+};
+
+/* ============================================================================
+ * Creation / Destruction
+ * ============================================================================ */
+
+sgl_backend_t *null_backend_create(void) {
+    sgl_backend_t *be = (sgl_backend_t *)calloc(1, sizeof(sgl_backend_t));
+    null_backend_data_t *nb = (null_backend_data_t *)calloc(1, sizeof(null_backend_data_t));
+    if (!be || !nb) {
+        free(be);
+        free(nb);
+        return NULL;
+    }
+    nb->buffers.item_size = sizeof(null_buffer_t);
+    nb->shaders.item_size = sizeof(null_code_t);
+    nb->programs.item_size = sizeof(null_program_t);
+    nb->queries.item_size = sizeof(GLenum);
+    nb->cmdlists.item_size = sizeof(null_cmdlist_t);
+
+    be->ops = &null_backend_ops;
+    be->impl_data = nb;
+    SGL_TRACE_BACKEND("null backend created");
+    return be;
+}
+
+void null_backend_set_draw_log(sgl_backend_t *be, null_draw_record_t *records, uint32_t capacity) {
+    null_backend_data_t *nb = null_data(be);
+    nb->log = records;
+    nb->log_capacity = records ? capacity : 0;
+    nb->log_count = 0;
+}
+
+uint32_t null_backend_draw_log_count(sgl_backend_t *be) {
+    return null_data(be)->log_count;
+}
+
+void null_backend_destroy(sgl_backend_t *be) {
+    if (!be) return;
+    if (be->impl_data) {
+        null_shutdown(be);
+        free(be->impl_data);
+    }
+    free(be);
+}
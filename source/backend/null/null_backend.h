@@ -0,0 +1,61 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * Null Backend
+ *
+ * Implements every sgl_backend_ops entry without a GPU so the GL layer,
+ * the transpiler and the shader pipeline can run (and be profiled) on a
+ * host. Commands are not executed, only counted in an sgl_frame_stats_t
+ * (sglGetFrameStats); buffer contents and uniform writes are kept in host
+ * memory so the GL layer does the same amount of copying as on device.
+ * Counters are backend op calls: the deko3d backend filters some binds
+ * further, so compare null runs with null runs. Shader "binaries" are
+ * accepted as opaque blobs.
+ */
+
+#ifndef NULL_BACKEND_H
+#define NULL_BACKEND_H
+
+#include "../sgl_backend.h"
+#include "../../context/sgl_gl_types.h"
+
+/* Create/destroy a null backend (device is ignored by init) */
+sgl_backend_t *null_backend_create(void);
+void null_backend_destroy(sgl_backend_t *be);
+
+/*
+ * Draw log for host tests (tests/test_draw_order.c). While set, every clear
+ * and glDrawArrays/glDrawElements reaching the backend is appended with the
+ * state the device would draw it with: what the backend was last given,
+ * forgotten when a frame starts and, for scissor and depth, overridden by a
+ * clear, as deko3d does. Two runs render the same image if their logs hold
+ * the same draws in an order the depth test does not depend on.
+ */
+typedef struct null_draw_record {
+    GLbitfield clear_mask;          /* Buffers cleared, 0 for a draw */
+    float clear_color[4];
+    float clear_depth;
+    int clear_stencil;
+
+    sgl_handle_t program;
+    uint32_t uniforms;              /* Hash of the uniform data the shaders read */
+    sgl_handle_t textures[SGL_MAX_TEXTURE_UNITS];
+    sgl_scissor_state_t scissor;
+    bool color_mask[4];
+    bool depth_test;
+    bool depth_write;
+    GLenum depth_func;
+    bool elements;
+    GLenum mode;
+    GLint first;                    /* First vertex, 0 for elements */
+    GLsizei count;
+    uint32_t ebo_offset;
+    GLsizei instances;
+} null_draw_record_t;
+
+/* Log into records, at most capacity of them; NULL stops logging */
+void null_backend_set_draw_log(sgl_backend_t *be, null_draw_record_t *records, uint32_t capacity);
+
+/* Records appended since the log was set, including those past capacity */
+uint32_t null_backend_draw_log_count(sgl_backend_t *be);
+
+#endif /* NULL_BACKEND_H */
@@ -15,10 +15,16 @@ typedef struct sgl_uniform_binding sgl_uniform_binding_t;
 typedef struct sgl_vertex_attrib sgl_vertex_attrib_t;
 typedef struct sgl_packed_ubo sgl_packed_ubo_t;
 
+/* Reads `size` bytes of mip `level`, starting `offset` bytes into the level.
+ * Returns false on an I/O error. */
+typedef bool (*sgl_texture_read_fn)(void *user, GLint level, uint32_t offset,
+                                    void *dst, uint32_t size);
+
 /* Backend interface */
 struct sgl_backend_ops {
     /* ======== Lifecycle ======== */
-    int  (*init)(sgl_backend_t *be, void *device);
+    /* heaps: sizes from sglSetHeapConfig / eglCreateContext, 0 fields = defaults */
+    int  (*init)(sgl_backend_t *be, void *device, const struct sgl_heap_config *heaps);
     void (*shutdown)(sgl_backend_t *be);
 
     /* ======== Frame Management ======== */
@@ -51,6 +57,8 @@ struct sgl_backend_ops {
                             GLenum target, GLsizeiptr size, const void *data, GLenum usage);
     void (*buffer_sub_data)(sgl_backend_t *be, sgl_handle_t handle,
                             uint32_t buffer_offset, GLsizeiptr size, const void *data);
+    /* CPU address of the buffer's storage, once pending GPU writes completed */
+    void *(*map_buffer)(sgl_backend_t *be, sgl_handle_t handle);
 
     /* ======== Texture Operations ======== */
     sgl_handle_t (*create_texture)(sgl_backend_t *be);
@@ -86,6 +94,18 @@ struct sgl_backend_ops {
                                              GLint xoffset, GLint yoffset,
                                              GLsizei width, GLsizei height,
                                              GLenum format, GLsizei imageSize, const void *data);
+    /* Create a compressed texture with `levels` mips, reading each level
+     * through read() straight into upload memory (sglTexImageFromFile) */
+    bool (*compressed_texture_stream)(sgl_backend_t *be, sgl_handle_t handle,
+                                      GLenum internalformat, GLsizei width, GLsizei height,
+                                      GLint levels, sgl_texture_read_fn read, void *user);
+    /* Defragment texture storage (sglCompactTextureHeap) - drains the GPU */
+    void (*compact_texture_heap)(sgl_backend_t *be);
+    /* Record uploads into idle textures on a copy-only queue (sglSetTransferQueue).
+     * Returns whether that queue is in use after the call. */
+    bool (*set_transfer_queue)(sgl_backend_t *be, bool enable);
+    /* Pixel storage modes used by texture uploads (GL_UNPACK_ALIGNMENT) */
+    void (*pixel_store)(sgl_backend_t *be, GLenum pname, GLint param);
 
     /* ======== Shader Operations ======== */
     sgl_handle_t (*create_shader)(sgl_backend_t *be, GLenum type);
@@ -103,6 +123,13 @@ struct sgl_backend_ops {
     bool (*link_program)(sgl_backend_t *be, sgl_handle_t program,
                          sgl_handle_t vertex_shader, sgl_handle_t fragment_shader);
     void (*use_program)(sgl_backend_t *be, sgl_handle_t handle);
+    /* Linked DKSH code of one stage (0=VS, 1=FS), for glGetProgramBinaryOES */
+    bool (*get_program_code)(sgl_backend_t *be, sgl_handle_t program, int stage,
+                             const void **code, uint32_t *size);
+    /* Load both stages straight into a program (glProgramBinaryOES) */
+    bool (*load_program_binary)(sgl_backend_t *be, sgl_handle_t program,
+                                const void *vs_code, size_t vs_size,
+                                const void *fs_code, size_t fs_size);
     /* Binds shaders AND uniform buffers with pushConstants - call before draw */
     void (*bind_program)(sgl_backend_t *be, sgl_handle_t program,
                          sgl_handle_t vertex_shader, sgl_handle_t fragment_shader,
@@ -123,17 +150,44 @@ struct sgl_backend_ops {
     /* Get/set uniform offset for a location */
     uint32_t (*alloc_uniform)(sgl_backend_t *be, uint32_t size);
     void (*write_uniform)(sgl_backend_t *be, uint32_t offset, const void *data, uint32_t size);
+    /* Uniform arena bytes used this frame, peak over all frames, and capacity */
+    void (*get_uniform_stats)(sgl_backend_t *be, uint32_t *used, uint32_t *high_water, uint32_t *capacity);
 
     /* ======== Vertex Attribute Operations ======== */
     void (*bind_vertex_attribs)(sgl_backend_t *be,
                                  const sgl_vertex_attrib_t *attribs,
-                                 int num_attribs, GLint first, GLsizei count);
+                                 int num_attribs, GLint first, GLsizei count,
+                                 GLsizei instances);
+    /* Bind a VBO-only vertex array object's cached vertex state; layout_dirty
+     * means its attributes changed since the previous bind */
+    void (*bind_vertex_array)(sgl_backend_t *be, GLuint vao,
+                              const sgl_vertex_attrib_t *attribs,
+                              int num_attribs, bool layout_dirty);
+    void (*delete_vertex_array)(sgl_backend_t *be, GLuint vao);
 
     /* ======== Draw Operations ======== */
-    void (*draw_arrays)(sgl_backend_t *be, GLenum mode, GLint first, GLsizei count);
-    /* draw_elements: ebo_offset is pre-computed GPU buffer offset if EBO bound, 0 for client indices */
+    /* instances: number of instances to draw, 1 for a non-instanced draw */
+    void (*draw_arrays)(sgl_backend_t *be, GLenum mode, GLint first, GLsizei count,
+                        GLsizei instances);
+    /* draw_elements: ebo_offset is the pre-computed data offset of the indices
+     * (EBO or upload_indices), 0 for client indices copied by the backend */
     void (*draw_elements)(sgl_backend_t *be, GLenum mode, GLsizei count,
-                          GLenum type, const void *indices, uint32_t ebo_offset);
+                          GLenum type, const void *indices, uint32_t ebo_offset,
+                          GLsizei instances);
+    /* Stage client indices (u8 widened to u16) and return their [min, max] range.
+     * Returns the data offset to pass to draw_elements as ebo_offset, 0 on failure */
+    uint32_t (*upload_indices)(sgl_backend_t *be, GLenum type, const void *indices, GLsizei count,
+                               GLenum *out_type, GLuint *out_min, GLuint *out_max);
+    /* Multi draws with state bound once by the caller. Draws with a zero count
+     * are skipped. ubo_offsets (NULL = none) rebinds the bound program's packed
+     * UBO [ubo_stage][ubo_binding] at that byte offset before each draw */
+    void (*multi_draw_arrays)(sgl_backend_t *be, GLenum mode, const GLint *first,
+                              const GLsizei *count, GLsizei drawcount,
+                              int ubo_stage, int ubo_binding, const GLuint *ubo_offsets);
+    /* index_offsets: per-draw data offsets as passed to draw_elements as ebo_offset */
+    void (*multi_draw_elements)(sgl_backend_t *be, GLenum mode, const GLsizei *count,
+                                GLenum type, const uint32_t *index_offsets, GLsizei drawcount,
+                                int ubo_stage, int ubo_binding, const GLuint *ubo_offsets);
 
     /* ======== Framebuffer Operations ======== */
     sgl_handle_t (*create_framebuffer)(sgl_backend_t *be);
@@ -142,9 +196,23 @@ struct sgl_backend_ops {
      * depth_rb: renderbuffer handle for depth attachment (0 = none) */
     void (*bind_framebuffer)(sgl_backend_t *be, sgl_handle_t handle,
                               sgl_handle_t color_tex, sgl_handle_t depth_rb);
-    void (*framebuffer_texture)(sgl_backend_t *be, sgl_handle_t fbo,
-                                 GLenum attachment, sgl_handle_t texture, GLint level);
+    /* Texture attached to an FBO color (GL_COLOR_ATTACHMENT0..3) point;
+     * textarget selects the face of a cubemap (called before the
+     * bind_framebuffer that uses it) */
+    void (*framebuffer_texture)(sgl_backend_t *be, sgl_handle_t fbo, GLenum attachment,
+                                 GLenum textarget, sgl_handle_t texture, GLint level);
     GLenum (*check_framebuffer_status)(sgl_backend_t *be, sgl_handle_t handle);
+    /* Color attachments an FBO draws to, bit i = GL_COLOR_ATTACHMENTi (handle 0:
+     * default framebuffer, bit 0 = GL_BACK). Takes effect at the next bind_framebuffer. */
+    void (*draw_buffers)(sgl_backend_t *be, sgl_handle_t handle, uint32_t mask);
+    /* Blit color from a read FBO (0 = default FB, read_color its color texture)
+     * into the bound one. src/dst are GL corners x0, y0, x1, y1; reversed
+     * corners mirror. Returns false if the color formats cannot be blitted. */
+    bool (*blit_framebuffer)(sgl_backend_t *be, sgl_handle_t read_fbo, sgl_handle_t read_color,
+                             const GLint src[4], const GLint dst[4], GLenum filter);
+    /* Drop the contents of the bound render target: color targets in color_mask
+     * (bit i = GL_COLOR_ATTACHMENTi) and, if depth_stencil, the depth-stencil image */
+    void (*discard_framebuffer)(sgl_backend_t *be, uint32_t color_mask, bool depth_stencil);
 
     /* ======== Renderbuffer Operations ======== */
     /* Allocate GPU storage for renderbuffer (depth/stencil) */
@@ -156,11 +224,94 @@ struct sgl_backend_ops {
     void (*read_pixels)(sgl_backend_t *be, GLint x, GLint y,
                         GLsizei width, GLsizei height,
                         GLenum format, GLenum type, void *pixels);
+    /* Record a readback into a pixel pack buffer (handle, byte offset) without
+     * waiting; map_buffer waits for it */
+    void (*read_pixels_to_buffer)(sgl_backend_t *be, GLint x, GLint y,
+                                  GLsizei width, GLsizei height,
+                                  GLenum format, GLenum type,
+                                  sgl_handle_t buffer, uint32_t offset);
 
     /* ======== Sync Operations ======== */
     void (*flush)(sgl_backend_t *be);
     void (*finish)(sgl_backend_t *be);
     void (*insert_barrier)(sgl_backend_t *be);
+    /* Counters of the last frame submitted by end_frame (sglGetFrameStats) */
+    void (*get_frame_stats)(sgl_backend_t *be, struct sgl_frame_stats *stats);
+    /* Barriers recorded since init, by kind (sglGetBarrierStats) */
+    void (*get_barrier_stats)(sgl_backend_t *be, uint32_t *full, uint32_t *fragments, uint32_t *tiles);
+    /* Peak command memory of one cmdbuf and bytes held in overflow chunks (sglGetCommandMemoryStats) */
+    void (*get_cmd_mem_stats)(sgl_backend_t *be, uint32_t *peak, uint32_t *pooled);
+    /* Usage of every heap, zero-filled by the caller (sglGetMemoryStats) */
+    void (*get_memory_stats)(sgl_backend_t *be, struct sgl_memory_stats *stats);
+    /* Changes whenever recorded command state is lost (cmdbuf reset) */
+    uint32_t (*get_state_generation)(sgl_backend_t *be);
+    /* Fence signaled once the work recorded so far has finished; that work is
+     * submitted right away (GL_APPLE_sync, EGL_KHR_fence_sync) */
+    sgl_handle_t (*create_sync)(sgl_backend_t *be);
+    void (*delete_sync)(sgl_backend_t *be, sgl_handle_t sync);
+    /* Wait up to timeout_ns (0 polls, UINT64_MAX forever); true once signaled */
+    bool (*wait_sync)(sgl_backend_t *be, sgl_handle_t sync, uint64_t timeout_ns);
+
+    /* ======== Recorder Operations ======== */
+    /* Secondary command lists filled on worker threads (sglCreateRecorder) */
+    sgl_handle_t (*create_recorder)(sgl_backend_t *be);
+    void (*delete_recorder)(sgl_backend_t *be, sgl_handle_t handle);
+    /* GL thread: rewind the recorder and bind the current render target into it */
+    bool (*begin_recorder)(sgl_backend_t *be, sgl_handle_t handle);
+    /* Route the calling thread's recording to a recorder (0 = main cmdbuf) */
+    void (*attach_recorder)(sgl_backend_t *be, sgl_handle_t handle);
+    /* GL thread: submit the main cmdbuf so far, then the recorders in order */
+    void (*submit_recorders)(sgl_backend_t *be, const sgl_handle_t *handles, int count);
+
+    /* ======== Command List Operations ======== */
+    /* Persistent lists recorded once on the GL thread, replayed many times
+     * (sglBeginCommandList). Begin creates a list and routes the GL thread's
+     * recording into it; it inherits the render target of every call. */
+    sgl_handle_t (*begin_cmdlist)(sgl_backend_t *be);
+    /* Finish the list and record into the main cmdbuf again; false if recording failed */
+    bool (*end_cmdlist)(sgl_backend_t *be, sgl_handle_t handle);
+    /* Replay a finished list in the main cmdbuf */
+    void (*call_cmdlist)(sgl_backend_t *be, sgl_handle_t handle);
+    /* Free a list once the GPU is done with its replays */
+    void (*delete_cmdlist)(sgl_backend_t *be, sgl_handle_t handle);
+
+    /* ======== Shared Context Operations ======== */
+    /* Contexts of a share group use one backend. Share is called when a
+     * second context joins: from then on resource ops (object creation,
+     * specification, deletion) may arrive from several threads, and the
+     * backend serializes them. Draws and state changes stay unlocked. */
+    void (*share)(sgl_backend_t *be);
+    /* Record the calling thread's uploads into a command buffer of its own,
+     * submitted to its own queue on flush, finish or fence; false when the
+     * thread cannot get one */
+    bool (*attach_upload_thread)(sgl_backend_t *be);
+    /* Submit the calling thread's uploads and stop redirecting them */
+    void (*detach_upload_thread)(sgl_backend_t *be);
+
+    /* ======== Query Operations ======== */
+    /* Query objects (EXT_disjoint_timer_query, EXT_occlusion_query_boolean),
+     * recorded in the main cmdbuf */
+    sgl_handle_t (*create_query)(sgl_backend_t *be);
+    void (*delete_query)(sgl_backend_t *be, sgl_handle_t query);
+    void (*begin_query)(sgl_backend_t *be, sgl_handle_t query, GLenum target);
+    void (*end_query)(sgl_backend_t *be, sgl_handle_t query);
+    /* Write the GPU time into the query (GL_TIMESTAMP_EXT) */
+    void (*query_counter)(sgl_backend_t *be, sgl_handle_t query);
+    /* Nanoseconds (timers) or samples passed; false while not written and !wait */
+    bool (*get_query_result)(sgl_backend_t *be, sgl_handle_t query, bool wait, uint64_t *result);
+    /* Newest result already written, possibly from an earlier begin/end; never blocks */
+    bool (*get_last_query_result)(sgl_backend_t *be, sgl_handle_t query, uint64_t *result);
+    /* Current GPU time in nanoseconds - drains the queue */
+    uint64_t (*get_gpu_timestamp)(sgl_backend_t *be);
+
+    /* ======== Render Resolution ======== */
+    /* Render the default framebuffer at width x height (0 x 0 = surface size)
+     * from the next frame on and upscale it at end_frame; stops the controller */
+    void (*set_render_resolution)(sgl_backend_t *be, GLsizei width, GLsizei height);
+    /* Pick the render size each frame from GPU frame time (target_ns 0 = off) */
+    void (*set_dynamic_resolution)(sgl_backend_t *be, uint64_t target_ns, float min_scale);
+    /* Size the default framebuffer renders at in the current frame */
+    void (*get_render_resolution)(sgl_backend_t *be, GLsizei *width, GLsizei *height);
 
     /* ======== Misc Operations ======== */
     void (*set_line_width)(sgl_backend_t *be, GLfloat width);
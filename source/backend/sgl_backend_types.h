@@ -14,8 +14,11 @@
 typedef uint32_t sgl_handle_t;
 #define SGL_INVALID_HANDLE 0
 
-/* Forward declaration */
+/* Forward declarations */
 typedef struct sgl_backend sgl_backend_t;
+struct sgl_frame_stats;  /* <GLES2/gl2sgl.h> */
+struct sgl_memory_stats; /* <GLES2/gl2sgl.h> */
+struct sgl_heap_config;  /* <GLES2/gl2sgl.h> */
 
 /* Viewport state */
 typedef struct sgl_viewport_state {
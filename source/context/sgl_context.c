@@ -5,12 +5,16 @@
 
 #include "sgl_context.h"
 #include "../util/sgl_log.h"
+#include "../util/sgl_trace.h"
 #include <string.h>
 
-/* Global current context (single-threaded on Switch) */
-static sgl_context_t *g_current_context = NULL;
+/* Context made current on the calling thread by eglMakeCurrent */
+static __thread sgl_context_t *t_current_context = NULL;
 
-void sgl_context_init(sgl_context_t *ctx) {
+/* Per-thread override: a recorder context on worker threads */
+static __thread sgl_context_t *t_thread_context = NULL;
+
+void sgl_context_init(sgl_context_t *ctx, sgl_resource_manager_t *res_mgr) {
     memset(ctx, 0, sizeof(sgl_context_t));
 
     /* Initialize state classes */
@@ -20,15 +24,20 @@ void sgl_context_init(sgl_context_t *ctx) {
     sgl_state_viewport_init(&ctx->viewport_state, SGL_FB_WIDTH, SGL_FB_HEIGHT);
     sgl_state_color_init(&ctx->color_state);
 
-    /* Initialize resource manager */
-    sgl_res_mgr_init(&ctx->res_mgr);
+    /* Initialize resource manager, unless the context joins a share group */
+    ctx->res_mgr = res_mgr;
+    if (res_mgr->share_count == 0) sgl_res_mgr_init(ctx->res_mgr);
+    res_mgr->share_count++;
 
     /* Clear bindings */
     ctx->current_program = 0;
     ctx->bound_array_buffer = 0;
     ctx->bound_element_buffer = 0;
+    ctx->bound_pixel_pack_buffer = 0;
     ctx->active_texture_unit = 0;
     ctx->bound_framebuffer = 0;
+    ctx->bound_read_framebuffer = 0;
+    ctx->default_draw_buffers = 1;
     ctx->bound_renderbuffer = 0;
 
     for (int i = 0; i < SGL_MAX_TEXTURE_UNITS; i++) {
@@ -45,6 +54,7 @@ void sgl_context_init(sgl_context_t *ctx) {
         ctx->vertex_attribs[i].pointer = NULL;
         ctx->vertex_attribs[i].buffer = 0;
         ctx->vertex_attribs[i].buffer_offset = 0;
+        ctx->vertex_attribs[i].divisor = 0;
         /* GL spec default: (0, 0, 0, 1) */
         ctx->vertex_attribs[i].current_value[0] = 0.0f;
         ctx->vertex_attribs[i].current_value[1] = 0.0f;
@@ -65,6 +75,10 @@ void sgl_context_init(sgl_context_t *ctx) {
     ctx->sample_alpha_to_coverage = false;
     ctx->sample_coverage_enabled = false;
 
+    /* Nothing has been emitted to the backend yet */
+    ctx->dirty_state = SGL_DIRTY_ALL;
+    ctx->backend_state_generation = 0;
+
     ctx->error = GL_NO_ERROR;
     ctx->initialized = true;
 
@@ -77,6 +91,14 @@ void sgl_context_destroy(sgl_context_t *ctx) {
     /* Backend will be destroyed separately */
     ctx->backend = NULL;
 
+    /* A capture still running ends with its context, buffered draws are dropped */
+    sgl_trace_close(ctx->capture);
+    sgl_draw_sort_destroy(ctx->draw_sort);
+
+    /* Shader sources, logs and per-program uniform storage live on the heap;
+     * the last context of a share group frees them */
+    if (ctx->res_mgr && --ctx->res_mgr->share_count == 0) sgl_res_mgr_shutdown(ctx->res_mgr);
+
     /* Clear everything */
     memset(ctx, 0, sizeof(sgl_context_t));
 
@@ -84,11 +106,51 @@ void sgl_context_destroy(sgl_context_t *ctx) {
 }
 
 sgl_context_t *sgl_get_current_context(void) {
-    return g_current_context;
+    return t_thread_context ? t_thread_context : t_current_context;
 }
 
 void sgl_set_current_context(sgl_context_t *ctx) {
-    g_current_context = ctx;
+    t_current_context = ctx;
+}
+
+/* Switch a context between rendering and uploading on the calling thread */
+static void sgl_context_set_upload_only(sgl_context_t *ctx, bool upload_only) {
+    sgl_backend_t *be = ctx->backend;
+    if (upload_only == ctx->upload_only || !be) return;
+
+    if (upload_only) {
+        if (!be->ops->attach_upload_thread || !be->ops->attach_upload_thread(be)) return;
+    } else if (be->ops->detach_upload_thread) {
+        be->ops->detach_upload_thread(be);
+    }
+    ctx->upload_only = upload_only;
+}
+
+bool sgl_context_make_current(sgl_context_t *ctx, bool has_surface) {
+    sgl_context_t *prev = t_current_context;
+
+    if (ctx && ctx != prev && __atomic_exchange_n(&ctx->current, true, __ATOMIC_ACQ_REL)) {
+        return false;
+    }
+    if (prev && prev != ctx) {
+        sgl_context_flush_deferred(prev);
+        sgl_context_set_upload_only(prev, false);
+        __atomic_store_n(&prev->current, false, __ATOMIC_RELEASE);
+    }
+    t_current_context = ctx;
+
+    if (ctx) {
+        sgl_context_set_upload_only(ctx, !has_surface && ctx->res_mgr->share_count > 1);
+
+        /* Contexts sharing a backend each have their own unpack alignment */
+        sgl_backend_t *be = ctx->backend;
+        if (be && be->ops->pixel_store) be->ops->pixel_store(be, GL_UNPACK_ALIGNMENT, ctx->unpack_alignment);
+    }
+    return true;
+}
+
+void sgl_set_thread_context(sgl_context_t *ctx) {
+    t_thread_context = ctx;
 }
 
 void sgl_set_error(sgl_context_t *ctx, GLenum error) {
@@ -114,4 +176,26 @@ void sgl_context_init_state(sgl_context_t *ctx) {
     sgl_state_raster_init(&ctx->raster_state);
     sgl_state_viewport_init(&ctx->viewport_state, SGL_FB_WIDTH, SGL_FB_HEIGHT);
     sgl_state_color_init(&ctx->color_state);
+
+    sgl_context_invalidate_state(ctx);
+}
+
+void sgl_context_mark_dirty(sgl_context_t *ctx, uint32_t groups) {
+    if (ctx) {
+        ctx->dirty_state |= groups;
+    }
+}
+
+void sgl_context_invalidate_state(sgl_context_t *ctx) {
+    sgl_context_mark_dirty(ctx, SGL_DIRTY_ALL);
+}
+
+void sgl_context_capture_swap(sgl_context_t *ctx) {
+    if (!ctx || !ctx->capture) return;
+
+    if (!sgl_trace_write(ctx->capture, SGL_TRACE_SWAP, NULL, 0, NULL, 0)) {
+        SGL_ERROR_CORE("Capture write failed, capture stopped");
+        sgl_trace_close(ctx->capture);
+        ctx->capture = NULL;
+    }
 }
@@ -15,8 +15,22 @@
 #include "sgl_resource_manager.h"
 #include "../backend/sgl_backend.h"
 
+/* Dirty state groups - set when GL state changes, cleared once the group
+ * has been re-emitted to the backend at draw time */
+#define SGL_DIRTY_VIEWPORT      (1u << 0)
+#define SGL_DIRTY_SCISSOR       (1u << 1)
+#define SGL_DIRTY_DEPTH_STENCIL (1u << 2)
+#define SGL_DIRTY_BLEND         (1u << 3)
+#define SGL_DIRTY_RASTER        (1u << 4)
+#define SGL_DIRTY_COLOR_MASK    (1u << 5)
+#define SGL_DIRTY_DEPTH_BIAS    (1u << 6)
+#define SGL_DIRTY_ALL           0x7Fu
+
 /* Forward declarations for EGL types */
 typedef struct sgl_surface sgl_surface_t;
+typedef struct sgl_recorder sgl_recorder_t;
+typedef struct sgl_trace sgl_trace_t;
+typedef struct sgl_draw_sort sgl_draw_sort_t;
 
 /* GL Context */
 typedef struct sgl_context {
@@ -27,23 +41,58 @@ typedef struct sgl_context {
     sgl_state_viewport_t    viewport_state;
     sgl_state_color_t       color_state;
 
-    /* Resource manager */
-    sgl_resource_manager_t  res_mgr;
+    /* Resource manager (owned by EGL, shared with recorder contexts and the
+     * contexts of the share group) */
+    sgl_resource_manager_t *res_mgr;
 
     /* Backend (opaque) */
     sgl_backend_t          *backend;
 
+    /* Set on a recorder's private copy of the context (gl_recorder.c) */
+    sgl_recorder_t         *recorder;
+
+    /* Trace the entry points append to while sglBeginCapture is active (gl_capture.c) */
+    sgl_trace_t            *capture;
+
+    /* Draws buffered for sorting while sglSetDrawSortMode is on (gl_draw_sort.c) */
+    sgl_draw_sort_t        *draw_sort;
+
+    /* glClear buffers not cleared yet, with the values they were cleared to;
+     * recorded at the next draw or flush point (gl_clear.c) */
+    GLbitfield              pending_clear;
+    float                   pending_clear_color[4];
+    float                   pending_clear_depth;
+    GLint                   pending_clear_stencil;
+
     /* Current bindings */
     GLuint                  current_program;
     GLuint                  bound_array_buffer;
     GLuint                  bound_element_buffer;
+    GLuint                  bound_pixel_pack_buffer;  /* NV_pixel_buffer_object */
     GLuint                  bound_textures[SGL_MAX_TEXTURE_UNITS];
     GLuint                  active_texture_unit;
-    GLuint                  bound_framebuffer;
+    GLuint                  bound_framebuffer;       /* Draw binding (render target) */
+    GLuint                  bound_read_framebuffer;  /* Source of glBlitFramebuffer/glReadPixels */
+    uint8_t                 default_draw_buffers;    /* glDrawBuffersEXT on FBO 0: 1 = GL_BACK, 0 = GL_NONE */
     GLuint                  bound_renderbuffer;
+    GLuint                  bound_vertex_array;  /* OES_vertex_array_object (0 = default) */
+    GLuint                  active_time_query;   /* GL_TIME_ELAPSED_EXT query (0 = none) */
+    GLuint                  active_occlusion_query;  /* GL_ANY_SAMPLES_PASSED*_EXT query */
+
+    /* sglBeginConditionalRender: draws are dropped while conditional_skip is set */
+    GLuint                  conditional_query;
+    bool                    conditional_skip;
 
-    /* Vertex attributes */
+    /* Vertex attributes of the bound VAO */
     sgl_vertex_attrib_t     vertex_attribs[SGL_MAX_ATTRIBS];
+    bool                    vertex_layout_dirty;       /* Layout changed since last cached by the backend */
+    sgl_vertex_array_t      default_vertex_array;      /* Parked VAO 0 state while a VAO is bound */
+
+    /* Client arrays promoted to buffers (gl_client_array.c) */
+    sgl_client_array_t      client_arrays[SGL_MAX_CLIENT_ARRAYS];
+    GLuint                  client_array_count;        /* Entries in use */
+    GLuint                  client_array_promote_frames; /* sglSetClientArrayPromotion, 0 = off */
+    GLuint                  frame_count;               /* eglSwapBuffers calls, ages the entries */
 
     /* Bound surfaces (from EGL) */
     sgl_surface_t          *draw_surface;
@@ -62,22 +111,35 @@ typedef struct sgl_context {
     bool                    sample_alpha_to_coverage;  /* default false */
     bool                    sample_coverage_enabled;   /* default false */
 
+    /* Dirty state tracking (SGL_DIRTY_* bits) */
+    uint32_t                dirty_state;
+    uint32_t                backend_state_generation;  /* Last seen backend generation */
+
     /* Error */
     GLenum                  error;
 
     /* Flags */
     bool                    initialized;
     bool                    used;
+    bool                    current;         /* Current on some thread (eglMakeCurrent) */
+    bool                    upload_only;     /* Current without a surface in a share group: uploads
+                                              * go to the thread's own stream, draws and clears are dropped */
     int                     client_version;  /* 2 for GLES2 */
 } sgl_context_t;
 
 /* Context lifecycle */
-void sgl_context_init(sgl_context_t *ctx);
+void sgl_context_init(sgl_context_t *ctx, sgl_resource_manager_t *res_mgr);
 void sgl_context_destroy(sgl_context_t *ctx);
 
-/* Get/set current context */
+/* Get/set the calling thread's current context */
 sgl_context_t *sgl_get_current_context(void);
 void sgl_set_current_context(sgl_context_t *ctx);
+/* eglMakeCurrent: release the thread's previous context and make ctx (or
+ * nothing) current. A context of a share group made current without a draw
+ * surface becomes upload_only. False if ctx is current on another thread. */
+bool sgl_context_make_current(sgl_context_t *ctx, bool has_surface);
+/* Override the current context on the calling thread only (NULL = global) */
+void sgl_set_thread_context(sgl_context_t *ctx);
 
 /* Error handling */
 void sgl_set_error(sgl_context_t *ctx, GLenum error);
@@ -86,4 +148,17 @@ GLenum sgl_get_error(sgl_context_t *ctx);
 /* Initialize GL state to defaults */
 void sgl_context_init_state(sgl_context_t *ctx);
 
+/* Dirty state tracking */
+void sgl_context_mark_dirty(sgl_context_t *ctx, uint32_t groups);
+/* Force every state group to be re-emitted (e.g. after a command buffer reset) */
+void sgl_context_invalidate_state(sgl_context_t *ctx);
+
+/* eglSwapBuffers: end the frame of a running sglBeginCapture */
+void sgl_context_capture_swap(sgl_context_t *ctx);
+
+/* eglSwapBuffers, eglMakeCurrent: record the pending glClear and the draws
+ * sglSetDrawSortMode buffered (gl_clear.c) */
+void sgl_context_flush_deferred(sgl_context_t *ctx);
+void sgl_draw_sort_destroy(sgl_draw_sort_t *sort);
+
 #endif /* SGL_CONTEXT_H */
@@ -11,19 +11,19 @@
 #include <stdint.h>
 
 /* Configuration */
-#define SGL_FB_NUM              3       /* Triple buffering */
+#define SGL_FB_NUM              3       /* Max swapchain images (triple buffering) */
 #define SGL_FB_WIDTH            1280
 #define SGL_FB_HEIGHT           720
 
 #define SGL_CODE_MEM_SIZE       (4 * 1024 * 1024)   /* 4MB for precompiled shaders */
 #define SGL_CMD_MEM_SIZE        (1 * 1024 * 1024)  /* 1MB - reset each frame via wait_fence */
 #define SGL_DATA_MEM_SIZE       (16 * 1024 * 1024)
-#define SGL_UNIFORM_BUF_SIZE    (256 * 1024)
+#define SGL_UNIFORM_BUF_SIZE    (256 * 1024)        /* Per uniform arena block */
 #define SGL_UNIFORM_ALIGNMENT   0x100   /* DK_UNIFORM_BUF_ALIGNMENT */
 #define SGL_CODE_ALIGNMENT      0x100   /* Shader code alignment (256 bytes) */
 #define SGL_PAGE_ALIGNMENT      0x1000  /* Memory block page alignment (4KB) */
 #define SGL_TEXTURE_MEM_SIZE    (32 * 1024 * 1024)
-#define SGL_DESCRIPTOR_MEM_SIZE (SGL_MAX_TEXTURES * 64)  /* 64 = sizeof(DkImageDescriptor) + sizeof(DkSamplerDescriptor) */
+#define SGL_STAGING_MEM_SIZE    (8 * 1024 * 1024)   /* Upload staging ring (larger uploads chain a memblock) */
 
 /* Alignment helper */
 #define SGL_ALIGN_UP(x, align) (((x) + (align) - 1) & ~((align) - 1))
@@ -36,30 +36,33 @@
 #define SGL_LOC_BINDING_MASK    0xFF
 #define SGL_LOC_OFFSET_MASK     0xFFFF
 
-/* Maximum resources */
+/* Maximum resources. Buffers, shaders, programs, textures, framebuffers,
+ * renderbuffers and vertex arrays live in growable tables (sgl_table.h). */
 #define SGL_MAX_SURFACES        4
 #define SGL_MAX_CONTEXTS        4
-#define SGL_MAX_BUFFERS         256
-#define SGL_MAX_SHADERS         1024
-#define SGL_MAX_PROGRAMS        512
-#define SGL_MAX_TEXTURES        256
-#define SGL_MAX_FRAMEBUFFERS    8
-#define SGL_MAX_RENDERBUFFERS   8
 #define SGL_MAX_ATTRIBS         16
 #define SGL_MAX_UNIFORMS        16
 #define SGL_MAX_TEXTURE_UNITS   8
+#define SGL_MAX_DRAW_BUFFERS    4       /* Color attachments per FBO (GL_EXT_draw_buffers) */
+#define SGL_MAX_QUERIES         256     /* Timer and occlusion query names */
+#define SGL_MAX_SYNCS           64      /* Fence sync objects (GL and EGL) */
+#define SGL_MAX_CLIENT_ARRAYS   32      /* Client arrays tracked for promotion to buffers */
 
 /* Packed UBO configuration */
 #define SGL_MAX_PACKED_UBO_SIZE  8192  /* Max bytes per packed UBO (supports 128 bones) */
 #define SGL_MAX_PACKED_UBOS      2     /* Per stage: 0=main, 1=bones */
 #define SGL_ATTRIB_NAME_MAX      64    /* Max attribute name length */
+#define SGL_UNIFORM_NAME_MAX     64    /* Max registered uniform name length */
 
 /* Packed UBO shadow buffer (CPU-side, flushed to GPU at draw time) */
 typedef struct sgl_packed_ubo {
-    uint8_t data[SGL_MAX_PACKED_UBO_SIZE];  /* CPU shadow buffer */
+    uint8_t *data;       /* CPU shadow buffer, allocated when the UBO is first configured */
+    uint32_t capacity;   /* Bytes allocated at data */
     uint32_t size;       /* Total used size (set at registration time) */
     bool dirty;          /* Any uniform written since last bind? */
     bool valid;          /* Has been configured? */
+    uint32_t dirty_begin; /* Byte range [begin, end) written since last bind, when dirty */
+    uint32_t dirty_end;
 } sgl_packed_ubo_t;
 
 /* Buffer object */
@@ -70,6 +73,15 @@ typedef struct sgl_buffer {
     GLenum usage;
     uint32_t backend_handle;
     uint32_t data_offset;
+    void *map_pointer;   /* CPU address of the mapped range while mapped, NULL otherwise */
+    GLintptr map_offset; /* Mapped range (EXT_map_buffer_range; whole buffer for OES_mapbuffer) */
+    GLsizeiptr map_length;
+    GLbitfield map_access;
+    GLenum index_type;   /* Element type index_min/max were built for, 0 if unknown or stale */
+    GLuint index_min;    /* Smallest/largest index in the buffer as index_type */
+    GLuint index_max;
+    GLuint index_shadow; /* Internal buffer holding the u16-widened GL_UNSIGNED_BYTE indices */
+    uint32_t revision;   /* Changes whenever data_offset may have moved */
 } sgl_buffer_t;
 
 /* Shader object */
@@ -78,6 +90,7 @@ typedef struct sgl_shader {
     GLenum type;
     bool compiled;
     bool needs_transpile;   /* true if source is GLSL ES 1.00 (deferred to link time) */
+    bool delete_pending;    /* glDeleteShader while attached: freed when the last program lets go */
     uint32_t backend_handle;
     uint32_t code_offset;
     uint32_t code_size;
@@ -109,12 +122,31 @@ typedef struct sgl_attrib_binding {
 /* Active uniform info (populated when glGetUniformLocation succeeds) */
 typedef struct sgl_active_uniform_info {
     char name[SGL_ATTRIB_NAME_MAX];
+    uint32_t hash;      /* Name hash for the location cache */
     GLint location;
     GLenum type;        /* GL_FLOAT, GL_FLOAT_VEC2, ..., GL_FLOAT_MAT4, GL_INT, etc. */
     GLint size;         /* 1 for non-arrays */
     bool active;
 } sgl_active_uniform_info_t;
 
+/* Packed uniform laid out by glLinkProgram */
+typedef struct sgl_link_uniform {
+    char name[SGL_UNIFORM_NAME_MAX];
+    int32_t stage;
+    int32_t binding;
+    int32_t byte_offset;
+} sgl_link_uniform_t;
+
+/* Uniform layout derived at link time, kept for glGetProgramBinaryOES */
+typedef struct sgl_link_reflection {
+    int32_t packed_ubo_sizes[2][SGL_MAX_PACKED_UBOS];  /* [stage][binding], 0 = unused */
+    int num_uniforms;
+    sgl_link_uniform_t uniforms[];
+} sgl_link_reflection_t;
+
+/* Open-addressed glGetUniformLocation cache over active_uniforms (power of two) */
+#define SGL_UNIFORM_CACHE_SLOTS 64
+
 /* Program object */
 typedef struct sgl_program {
     bool used;
@@ -135,6 +167,14 @@ typedef struct sgl_program {
     /* Active uniform tracking (populated by glGetUniformLocation) */
     sgl_active_uniform_info_t active_uniforms[SGL_MAX_UNIFORMS * 2]; /* VS + FS */
     int num_active_uniforms;
+    int8_t uniform_cache[SGL_UNIFORM_CACHE_SLOTS];  /* active_uniforms index + 1, 0 = empty */
+    uint32_t uniform_cache_generation;              /* Uniform registry generation it was built at */
+    /* Packed uniforms laid out by the last link (NULL for precompiled shaders) */
+    sgl_link_reflection_t *link_reflection;
+    /* Background link still to be finished on the GL thread (gl_shader.c) */
+    struct sgl_link_job *link_job;
+    uint32_t revision;  /* Changes on every link */
+    char *bundle_name;  /* Name in the shader bundle it was loaded from, NULL otherwise */
 } sgl_program_t;
 
 /* Texture object */
@@ -143,18 +183,23 @@ typedef struct sgl_texture {
     GLenum target;
     GLsizei width, height;
     GLenum internal_format;
+    GLenum type;        /* Level 0 pixel type (16-bit types are stored natively) */
     uint32_t backend_handle;
     /* Sampler parameters */
     GLenum min_filter;
     GLenum mag_filter;
     GLenum wrap_s;
     GLenum wrap_t;
+    bool params_dirty;  /* Sampler params not yet forwarded to the backend */
+    uint32_t revision;  /* Changes on (re)specification and sampler param changes */
 } sgl_texture_t;
 
 /* Framebuffer object */
 typedef struct sgl_framebuffer {
     bool used;
-    GLuint color_attachment;    /* Texture ID */
+    GLuint color_attachments[SGL_MAX_DRAW_BUFFERS];  /* Texture IDs, GL_COLOR_ATTACHMENTi */
+    GLenum color_textargets[SGL_MAX_DRAW_BUFFERS];   /* GL_TEXTURE_2D or the cubemap face rendered to */
+    uint8_t draw_buffers;       /* glDrawBuffersEXT: bit i draws to GL_COLOR_ATTACHMENTi */
     GLuint depth_attachment;    /* Renderbuffer ID or 0 */
     GLuint stencil_attachment;  /* Renderbuffer ID or 0 */
     uint32_t backend_handle;
@@ -181,7 +226,44 @@ typedef struct sgl_vertex_attrib {
     const void *pointer;
     GLuint buffer;  /* Bound VBO or 0 for client array */
     uint32_t buffer_offset;  /* GPU buffer offset (computed before draw) */
+    GLuint divisor;  /* Instances per element (ANGLE_instanced_arrays), 0 = per vertex */
     GLfloat current_value[4]; /* Constant value when array is disabled (default: 0,0,0,1) */
 } sgl_vertex_attrib_t;
 
+/* Client array tracked for promotion to a buffer (gl_client_array.c).
+ * Covers [pointer, pointer + size); interleaved attributes within one
+ * stride of pointer share the entry. */
+typedef struct sgl_client_array {
+    const void *pointer;       /* NULL = free entry */
+    GLsizei stride;            /* Effective stride (heuristic entries) */
+    uint32_t size;             /* Bytes covered */
+    uint32_t fingerprint;      /* Sampled hash of the covered bytes */
+    GLuint frame;              /* Frame the fingerprint was last checked in */
+    GLuint frames_unchanged;   /* Consecutive frames seen with the same fingerprint */
+    GLuint buffer;             /* Buffer holding the copy, 0 while streamed */
+    bool marked;               /* sglMarkClientArrayStatic region, never fingerprinted */
+} sgl_client_array_t;
+
+/* Vertex array object (OES_vertex_array_object).
+ * The bound VAO's state lives in the context (vertex_attribs, bound_element_buffer);
+ * it is parked here while another VAO is bound. current_value is context state
+ * and is not saved. */
+typedef struct sgl_vertex_array {
+    bool used;
+    bool bound_once;       /* Name becomes a VAO on first bind (glIsVertexArrayOES) */
+    sgl_vertex_attrib_t attribs[SGL_MAX_ATTRIBS];
+    GLuint element_buffer;
+    bool layout_dirty;     /* Attribute layout changed since the backend cached it */
+} sgl_vertex_array_t;
+
+/* Query object (EXT_disjoint_timer_query, EXT_occlusion_query_boolean) */
+typedef struct sgl_query {
+    bool used;
+    bool begun_once;        /* Name becomes a query on first begin (glIsQueryEXT) */
+    GLenum target;
+    uint32_t backend_handle;
+    bool result_valid;      /* result holds the last ended query's value */
+    uint64_t result;
+} sgl_query_t;
+
 #endif /* SGL_GL_TYPES_H */
@@ -7,8 +7,53 @@
 #include <string.h>
 #include <stdlib.h>
 
+/* Take a name from a table and clear its record; NULL when out of memory */
+static void *sgl_res_mgr_take(sgl_resource_manager_t *mgr, sgl_table_t *t, GLuint *id) {
+    sgl_lock(&mgr->lock);
+    *id = sgl_table_alloc(t);
+    sgl_unlock(&mgr->lock);
+    if (*id == 0) return NULL;
+    void *rec = sgl_table_get(t, *id);
+    memset(rec, 0, t->item_size);
+    return rec;
+}
+
+/* Return a name taken with sgl_res_mgr_take */
+static void sgl_res_mgr_release(sgl_resource_manager_t *mgr, sgl_table_t *t, GLuint id) {
+    sgl_lock(&mgr->lock);
+    sgl_table_release(t, id);
+    sgl_unlock(&mgr->lock);
+}
+
+/* Every record starts with its bool used flag */
+static void *sgl_res_mgr_lookup(const sgl_table_t *t, GLuint id) {
+    bool *used = (bool *)sgl_table_get(t, id);
+    return (id > 0 && used && *used) ? used : NULL;
+}
+
 void sgl_res_mgr_init(sgl_resource_manager_t *mgr) {
     memset(mgr, 0, sizeof(sgl_resource_manager_t));
+    sgl_table_init(&mgr->buffers, sizeof(sgl_buffer_t));
+    sgl_table_init(&mgr->shaders, sizeof(sgl_shader_t));
+    sgl_table_init(&mgr->programs, sizeof(sgl_program_t));
+    sgl_table_init(&mgr->textures, sizeof(sgl_texture_t));
+    sgl_table_init(&mgr->framebuffers, sizeof(sgl_framebuffer_t));
+    sgl_table_init(&mgr->renderbuffers, sizeof(sgl_renderbuffer_t));
+    sgl_table_init(&mgr->vertex_arrays, sizeof(sgl_vertex_array_t));
+    sgl_lock_init(&mgr->lock);
+}
+
+void sgl_res_mgr_shutdown(sgl_resource_manager_t *mgr) {
+    for (GLuint i = 1; i < sgl_table_end(&mgr->shaders); i++) sgl_res_mgr_free_shader(mgr, i);
+    for (GLuint i = 1; i < sgl_table_end(&mgr->programs); i++) sgl_res_mgr_free_program(mgr, i);
+    sgl_table_destroy(&mgr->buffers);
+    sgl_table_destroy(&mgr->shaders);
+    sgl_table_destroy(&mgr->programs);
+    sgl_table_destroy(&mgr->textures);
+    sgl_table_destroy(&mgr->framebuffers);
+    sgl_table_destroy(&mgr->renderbuffers);
+    sgl_table_destroy(&mgr->vertex_arrays);
+    sgl_lock_destroy(&mgr->lock);
 }
 
 /* ============================================================================
@@ -16,27 +61,24 @@ void sgl_res_mgr_init(sgl_resource_manager_t *mgr) {
  * ============================================================================ */
 
 GLuint sgl_res_mgr_alloc_buffer(sgl_resource_manager_t *mgr) {
-    for (GLuint i = 1; i < SGL_MAX_BUFFERS; i++) {
-        if (!mgr->buffers[i].used) {
-            memset(&mgr->buffers[i], 0, sizeof(sgl_buffer_t));
-            mgr->buffers[i].used = true;
-            return i;
-        }
-    }
-    return 0;
+    GLuint id;
+    sgl_buffer_t *buf = (sgl_buffer_t *)sgl_res_mgr_take(mgr, &mgr->buffers, &id);
+    if (!buf) return 0;
+    buf->used = true;
+    buf->revision = sgl_res_mgr_next_revision(mgr);
+    return id;
 }
 
 void sgl_res_mgr_free_buffer(sgl_resource_manager_t *mgr, GLuint id) {
-    if (id > 0 && id < SGL_MAX_BUFFERS && mgr->buffers[id].used) {
-        mgr->buffers[id].used = false;
+    sgl_buffer_t *buf = (sgl_buffer_t *)sgl_res_mgr_lookup(&mgr->buffers, id);
+    if (buf) {
+        buf->used = false;
+        sgl_res_mgr_release(mgr, &mgr->buffers, id);
     }
 }
 
 sgl_buffer_t *sgl_res_mgr_get_buffer(sgl_resource_manager_t *mgr, GLuint id) {
-    if (id > 0 && id < SGL_MAX_BUFFERS && mgr->buffers[id].used) {
-        return &mgr->buffers[id];
-    }
-    return NULL;
+    return (sgl_buffer_t *)sgl_res_mgr_lookup(&mgr->buffers, id);
 }
 
 /* ============================================================================
@@ -44,36 +86,28 @@ sgl_buffer_t *sgl_res_mgr_get_buffer(sgl_resource_manager_t *mgr, GLuint id) {
  * ============================================================================ */
 
 GLuint sgl_res_mgr_alloc_shader(sgl_resource_manager_t *mgr, GLenum type) {
-    for (GLuint i = 1; i < SGL_MAX_SHADERS; i++) {
-        if (!mgr->shaders[i].used) {
-            memset(&mgr->shaders[i], 0, sizeof(sgl_shader_t));
-            mgr->shaders[i].used = true;
-            mgr->shaders[i].type = type;
-            return i;
-        }
-    }
-    return 0;
+    GLuint id;
+    sgl_shader_t *sh = (sgl_shader_t *)sgl_res_mgr_take(mgr, &mgr->shaders, &id);
+    if (!sh) return 0;
+    sh->used = true;
+    sh->type = type;
+    return id;
 }
 
 void sgl_res_mgr_free_shader(sgl_resource_manager_t *mgr, GLuint id) {
-    if (id > 0 && id < SGL_MAX_SHADERS && mgr->shaders[id].used) {
-        if (mgr->shaders[id].source) {
-            free(mgr->shaders[id].source);
-            mgr->shaders[id].source = NULL;
-        }
-        if (mgr->shaders[id].info_log) {
-            free(mgr->shaders[id].info_log);
-            mgr->shaders[id].info_log = NULL;
-        }
-        mgr->shaders[id].used = false;
+    sgl_shader_t *sh = (sgl_shader_t *)sgl_res_mgr_lookup(&mgr->shaders, id);
+    if (sh) {
+        free(sh->source);
+        sh->source = NULL;
+        free(sh->info_log);
+        sh->info_log = NULL;
+        sh->used = false;
+        sgl_res_mgr_release(mgr, &mgr->shaders, id);
     }
 }
 
 sgl_shader_t *sgl_res_mgr_get_shader(sgl_resource_manager_t *mgr, GLuint id) {
-    if (id > 0 && id < SGL_MAX_SHADERS && mgr->shaders[id].used) {
-        return &mgr->shaders[id];
-    }
-    return NULL;
+    return (sgl_shader_t *)sgl_res_mgr_lookup(&mgr->shaders, id);
 }
 
 /* ============================================================================
@@ -81,27 +115,38 @@ sgl_shader_t *sgl_res_mgr_get_shader(sgl_resource_manager_t *mgr, GLuint id) {
  * ============================================================================ */
 
 GLuint sgl_res_mgr_alloc_program(sgl_resource_manager_t *mgr) {
-    for (GLuint i = 1; i < SGL_MAX_PROGRAMS; i++) {
-        if (!mgr->programs[i].used) {
-            memset(&mgr->programs[i], 0, sizeof(sgl_program_t));
-            mgr->programs[i].used = true;
-            return i;
-        }
-    }
-    return 0;
+    GLuint id;
+    sgl_program_t *prog = (sgl_program_t *)sgl_res_mgr_take(mgr, &mgr->programs, &id);
+    if (!prog) return 0;
+    prog->used = true;
+    prog->revision = sgl_res_mgr_next_revision(mgr);
+    return id;
 }
 
 void sgl_res_mgr_free_program(sgl_resource_manager_t *mgr, GLuint id) {
-    if (id > 0 && id < SGL_MAX_PROGRAMS && mgr->programs[id].used) {
-        mgr->programs[id].used = false;
+    sgl_program_t *prog = (sgl_program_t *)sgl_res_mgr_lookup(&mgr->programs, id);
+    if (prog) {
+        free(prog->link_reflection);
+        prog->link_reflection = NULL;
+        free(prog->bundle_name);
+        prog->bundle_name = NULL;
+        for (int i = 0; i < SGL_MAX_PACKED_UBOS; i++) {
+            free(prog->packed_vertex[i].data);
+            free(prog->packed_fragment[i].data);
+        }
+        memset(prog->packed_vertex, 0, sizeof(prog->packed_vertex));
+        memset(prog->packed_fragment, 0, sizeof(prog->packed_fragment));
+        prog->used = false;
+        sgl_res_mgr_release(mgr, &mgr->programs, id);
     }
 }
 
 sgl_program_t *sgl_res_mgr_get_program(sgl_resource_manager_t *mgr, GLuint id) {
-    if (id > 0 && id < SGL_MAX_PROGRAMS && mgr->programs[id].used) {
-        return &mgr->programs[id];
-    }
-    return NULL;
+    return (sgl_program_t *)sgl_res_mgr_lookup(&mgr->programs, id);
+}
+
+GLuint sgl_res_mgr_program_end(const sgl_resource_manager_t *mgr) {
+    return mgr->programs.next_handle;
 }
 
 /* ============================================================================
@@ -109,32 +154,34 @@ sgl_program_t *sgl_res_mgr_get_program(sgl_resource_manager_t *mgr, GLuint id) {
  * ============================================================================ */
 
 GLuint sgl_res_mgr_alloc_texture(sgl_resource_manager_t *mgr) {
-    for (GLuint i = 1; i < SGL_MAX_TEXTURES; i++) {
-        if (!mgr->textures[i].used) {
-            memset(&mgr->textures[i], 0, sizeof(sgl_texture_t));
-            mgr->textures[i].used = true;
-            /* OpenGL defaults for texture parameters */
-            mgr->textures[i].min_filter = GL_NEAREST_MIPMAP_LINEAR;
-            mgr->textures[i].mag_filter = GL_LINEAR;
-            mgr->textures[i].wrap_s = GL_REPEAT;
-            mgr->textures[i].wrap_t = GL_REPEAT;
-            return i;
-        }
-    }
-    return 0;
+    GLuint id;
+    sgl_texture_t *tex = (sgl_texture_t *)sgl_res_mgr_take(mgr, &mgr->textures, &id);
+    if (!tex) return 0;
+    tex->used = true;
+    tex->revision = sgl_res_mgr_next_revision(mgr);
+    /* OpenGL defaults for texture parameters */
+    tex->min_filter = GL_NEAREST_MIPMAP_LINEAR;
+    tex->mag_filter = GL_LINEAR;
+    tex->wrap_s = GL_REPEAT;
+    tex->wrap_t = GL_REPEAT;
+    tex->params_dirty = true;
+    return id;
 }
 
 void sgl_res_mgr_free_texture(sgl_resource_manager_t *mgr, GLuint id) {
-    if (id > 0 && id < SGL_MAX_TEXTURES && mgr->textures[id].used) {
-        mgr->textures[id].used = false;
+    sgl_texture_t *tex = (sgl_texture_t *)sgl_res_mgr_lookup(&mgr->textures, id);
+    if (tex) {
+        tex->used = false;
+        sgl_res_mgr_release(mgr, &mgr->textures, id);
     }
 }
 
 sgl_texture_t *sgl_res_mgr_get_texture(sgl_resource_manager_t *mgr, GLuint id) {
-    if (id > 0 && id < SGL_MAX_TEXTURES && mgr->textures[id].used) {
-        return &mgr->textures[id];
-    }
-    return NULL;
+    return (sgl_texture_t *)sgl_res_mgr_lookup(&mgr->textures, id);
+}
+
+GLuint sgl_res_mgr_texture_end(const sgl_resource_manager_t *mgr) {
+    return mgr->textures.next_handle;
 }
 
 /* ============================================================================
@@ -142,27 +189,24 @@ sgl_texture_t *sgl_res_mgr_get_texture(sgl_resource_manager_t *mgr, GLuint id) {
  * ============================================================================ */
 
 GLuint sgl_res_mgr_alloc_framebuffer(sgl_resource_manager_t *mgr) {
-    for (GLuint i = 1; i < SGL_MAX_FRAMEBUFFERS; i++) {
-        if (!mgr->framebuffers[i].used) {
-            memset(&mgr->framebuffers[i], 0, sizeof(sgl_framebuffer_t));
-            mgr->framebuffers[i].used = true;
-            return i;
-        }
-    }
-    return 0;
+    GLuint id;
+    sgl_framebuffer_t *fbo = (sgl_framebuffer_t *)sgl_res_mgr_take(mgr, &mgr->framebuffers, &id);
+    if (!fbo) return 0;
+    fbo->used = true;
+    fbo->draw_buffers = 1;  /* GL_COLOR_ATTACHMENT0 only */
+    return id;
 }
 
 void sgl_res_mgr_free_framebuffer(sgl_resource_manager_t *mgr, GLuint id) {
-    if (id > 0 && id < SGL_MAX_FRAMEBUFFERS && mgr->framebuffers[id].used) {
-        mgr->framebuffers[id].used = false;
+    sgl_framebuffer_t *fbo = (sgl_framebuffer_t *)sgl_res_mgr_lookup(&mgr->framebuffers, id);
+    if (fbo) {
+        fbo->used = false;
+        sgl_res_mgr_release(mgr, &mgr->framebuffers, id);
     }
 }
 
 sgl_framebuffer_t *sgl_res_mgr_get_framebuffer(sgl_resource_manager_t *mgr, GLuint id) {
-    if (id > 0 && id < SGL_MAX_FRAMEBUFFERS && mgr->framebuffers[id].used) {
-        return &mgr->framebuffers[id];
-    }
-    return NULL;
+    return (sgl_framebuffer_t *)sgl_res_mgr_lookup(&mgr->framebuffers, id);
 }
 
 /* ============================================================================
@@ -170,25 +214,76 @@ sgl_framebuffer_t *sgl_res_mgr_get_framebuffer(sgl_resource_manager_t *mgr, GLui
  * ============================================================================ */
 
 GLuint sgl_res_mgr_alloc_renderbuffer(sgl_resource_manager_t *mgr) {
-    for (GLuint i = 1; i < SGL_MAX_RENDERBUFFERS; i++) {
-        if (!mgr->renderbuffers[i].used) {
-            memset(&mgr->renderbuffers[i], 0, sizeof(sgl_renderbuffer_t));
-            mgr->renderbuffers[i].used = true;
-            return i;
-        }
-    }
-    return 0;
+    GLuint id;
+    sgl_renderbuffer_t *rb = (sgl_renderbuffer_t *)sgl_res_mgr_take(mgr, &mgr->renderbuffers, &id);
+    if (!rb) return 0;
+    rb->used = true;
+    return id;
 }
 
 void sgl_res_mgr_free_renderbuffer(sgl_resource_manager_t *mgr, GLuint id) {
-    if (id > 0 && id < SGL_MAX_RENDERBUFFERS && mgr->renderbuffers[id].used) {
-        mgr->renderbuffers[id].used = false;
+    sgl_renderbuffer_t *rb = (sgl_renderbuffer_t *)sgl_res_mgr_lookup(&mgr->renderbuffers, id);
+    if (rb) {
+        rb->used = false;
+        sgl_res_mgr_release(mgr, &mgr->renderbuffers, id);
     }
 }
 
 sgl_renderbuffer_t *sgl_res_mgr_get_renderbuffer(sgl_resource_manager_t *mgr, GLuint id) {
-    if (id > 0 && id < SGL_MAX_RENDERBUFFERS && mgr->renderbuffers[id].used) {
-        return &mgr->renderbuffers[id];
+    return (sgl_renderbuffer_t *)sgl_res_mgr_lookup(&mgr->renderbuffers, id);
+}
+
+/* ============================================================================
+ * Vertex Array Operations
+ * ============================================================================ */
+
+GLuint sgl_res_mgr_alloc_vertex_array(sgl_resource_manager_t *mgr) {
+    GLuint id;
+    sgl_vertex_array_t *vao = (sgl_vertex_array_t *)sgl_res_mgr_take(mgr, &mgr->vertex_arrays, &id);
+    if (!vao) return 0;
+    vao->used = true;
+    return id;
+}
+
+void sgl_res_mgr_free_vertex_array(sgl_resource_manager_t *mgr, GLuint id) {
+    sgl_vertex_array_t *vao = (sgl_vertex_array_t *)sgl_res_mgr_lookup(&mgr->vertex_arrays, id);
+    if (vao) {
+        vao->used = false;
+        sgl_res_mgr_release(mgr, &mgr->vertex_arrays, id);
+    }
+}
+
+sgl_vertex_array_t *sgl_res_mgr_get_vertex_array(sgl_resource_manager_t *mgr, GLuint id) {
+    return (sgl_vertex_array_t *)sgl_res_mgr_lookup(&mgr->vertex_arrays, id);
+}
+
+/* ============================================================================
+ * Query Operations
+ * ============================================================================ */
+
+GLuint sgl_res_mgr_alloc_query(sgl_resource_manager_t *mgr) {
+    GLuint id = 0;
+    sgl_lock(&mgr->lock);
+    for (GLuint i = 1; i < SGL_MAX_QUERIES && id == 0; i++) {
+        if (!mgr->queries[i].used) {
+            memset(&mgr->queries[i], 0, sizeof(sgl_query_t));
+            mgr->queries[i].used = true;
+            id = i;
+        }
+    }
+    sgl_unlock(&mgr->lock);
+    return id;
+}
+
+void sgl_res_mgr_free_query(sgl_resource_manager_t *mgr, GLuint id) {
+    if (id > 0 && id < SGL_MAX_QUERIES && mgr->queries[id].used) {
+        mgr->queries[id].used = false;
+    }
+}
+
+sgl_query_t *sgl_res_mgr_get_query(sgl_resource_manager_t *mgr, GLuint id) {
+    if (id > 0 && id < SGL_MAX_QUERIES && mgr->queries[id].used) {
+        return &mgr->queries[id];
     }
     return NULL;
 }
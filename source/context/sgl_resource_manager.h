@@ -7,19 +7,40 @@
 #define SGL_RESOURCE_MANAGER_H
 
 #include "sgl_gl_types.h"
+#include "../util/sgl_table.h"
+#include "../util/sgl_lock.h"
 
 typedef struct sgl_resource_manager {
-    sgl_buffer_t buffers[SGL_MAX_BUFFERS];
-    sgl_shader_t shaders[SGL_MAX_SHADERS];
-    sgl_program_t programs[SGL_MAX_PROGRAMS];
-    sgl_texture_t textures[SGL_MAX_TEXTURES];
-    sgl_framebuffer_t framebuffers[SGL_MAX_FRAMEBUFFERS];
-    sgl_renderbuffer_t renderbuffers[SGL_MAX_RENDERBUFFERS];
+    /* Growable tables of sgl_buffer_t, sgl_shader_t, ... indexed by GL name */
+    sgl_table_t buffers;
+    sgl_table_t shaders;
+    sgl_table_t programs;
+    sgl_table_t textures;
+    sgl_table_t framebuffers;
+    sgl_table_t renderbuffers;
+    sgl_table_t vertex_arrays;
+    sgl_query_t queries[SGL_MAX_QUERIES];   /* Query names index the backend's report memory */
+    uint32_t revision;                      /* Last revision handed out (sgl_res_mgr_next_revision) */
+
+    /* Share group: every context created sharing objects uses the same
+     * manager. Names are allocated and released under lock, since the
+     * contexts may be current on different threads. */
+    uint32_t share_count;                   /* Contexts using the manager */
+    sgl_lock_t lock;
 } sgl_resource_manager_t;
 
 /* Initialize resource manager */
 void sgl_res_mgr_init(sgl_resource_manager_t *mgr);
 
+/* Free the heap storage of every live object (the pools themselves are embedded) */
+void sgl_res_mgr_shutdown(sgl_resource_manager_t *mgr);
+
+/* Revision for a buffer, program or texture that was created or re-specified.
+ * Command lists remember the revisions they were recorded with (gl_recorder.c). */
+static inline uint32_t sgl_res_mgr_next_revision(sgl_resource_manager_t *mgr) {
+    return __atomic_add_fetch(&mgr->revision, 1, __ATOMIC_RELAXED);
+}
+
 /* Buffer operations */
 GLuint sgl_res_mgr_alloc_buffer(sgl_resource_manager_t *mgr);
 void sgl_res_mgr_free_buffer(sgl_resource_manager_t *mgr, GLuint id);
@@ -34,11 +55,13 @@ sgl_shader_t *sgl_res_mgr_get_shader(sgl_resource_manager_t *mgr, GLuint id);
 GLuint sgl_res_mgr_alloc_program(sgl_resource_manager_t *mgr);
 void sgl_res_mgr_free_program(sgl_resource_manager_t *mgr, GLuint id);
 sgl_program_t *sgl_res_mgr_get_program(sgl_resource_manager_t *mgr, GLuint id);
+GLuint sgl_res_mgr_program_end(const sgl_resource_manager_t *mgr);  /* Names are below this */
 
 /* Texture operations */
 GLuint sgl_res_mgr_alloc_texture(sgl_resource_manager_t *mgr);
 void sgl_res_mgr_free_texture(sgl_resource_manager_t *mgr, GLuint id);
 sgl_texture_t *sgl_res_mgr_get_texture(sgl_resource_manager_t *mgr, GLuint id);
+GLuint sgl_res_mgr_texture_end(const sgl_resource_manager_t *mgr);  /* Names are below this */
 
 /* Framebuffer operations */
 GLuint sgl_res_mgr_alloc_framebuffer(sgl_resource_manager_t *mgr);
@@ -50,4 +73,14 @@ GLuint sgl_res_mgr_alloc_renderbuffer(sgl_resource_manager_t *mgr);
 void sgl_res_mgr_free_renderbuffer(sgl_resource_manager_t *mgr, GLuint id);
 sgl_renderbuffer_t *sgl_res_mgr_get_renderbuffer(sgl_resource_manager_t *mgr, GLuint id);
 
+/* Vertex array operations */
+GLuint sgl_res_mgr_alloc_vertex_array(sgl_resource_manager_t *mgr);
+void sgl_res_mgr_free_vertex_array(sgl_resource_manager_t *mgr, GLuint id);
+sgl_vertex_array_t *sgl_res_mgr_get_vertex_array(sgl_resource_manager_t *mgr, GLuint id);
+
+/* Query operations */
+GLuint sgl_res_mgr_alloc_query(sgl_resource_manager_t *mgr);
+void sgl_res_mgr_free_query(sgl_resource_manager_t *mgr, GLuint id);
+sgl_query_t *sgl_res_mgr_get_query(sgl_resource_manager_t *mgr, GLuint id);
+
 #endif /* SGL_RESOURCE_MANAGER_H */
@@ -52,3 +52,16 @@ bool sgl_state_blend_set_equation(sgl_state_blend_t *state,
     state->equation_alpha = alpha;
     return true;
 }
+
+bool sgl_state_blend_set_color(sgl_state_blend_t *state,
+                                GLfloat r, GLfloat g, GLfloat b, GLfloat a) {
+    if (state->color[0] == r && state->color[1] == g &&
+        state->color[2] == b && state->color[3] == a) {
+        return false;
+    }
+    state->color[0] = r;
+    state->color[1] = g;
+    state->color[2] = b;
+    state->color[3] = a;
+    return true;
+}
@@ -27,5 +27,7 @@ bool sgl_state_blend_set_func(sgl_state_blend_t *state,
                                GLenum src_alpha, GLenum dst_alpha);
 bool sgl_state_blend_set_equation(sgl_state_blend_t *state,
                                    GLenum rgb, GLenum alpha);
+bool sgl_state_blend_set_color(sgl_state_blend_t *state,
+                                GLfloat r, GLfloat g, GLfloat b, GLfloat a);
 
 #endif /* SGL_STATE_BLEND_H */
@@ -0,0 +1,60 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * Fence Sync Objects
+ */
+
+#include "sgl_sync.h"
+#include "../util/sgl_log.h"
+
+static sgl_sync_t g_syncs[SGL_MAX_SYNCS];
+
+sgl_sync_t *sgl_sync_create(sgl_backend_t *be) {
+    if (!be || !be->ops->create_sync) return NULL;
+
+    /* Contexts of a share group create syncs from different threads */
+    for (int i = 0; i < SGL_MAX_SYNCS; i++) {
+        sgl_sync_t *s = &g_syncs[i];
+        if (__atomic_exchange_n(&s->used, true, __ATOMIC_ACQUIRE)) continue;
+
+        s->handle = be->ops->create_sync(be);
+        if (s->handle == 0) {
+            __atomic_store_n(&s->used, false, __ATOMIC_RELEASE);
+            return NULL;
+        }
+        s->backend = be;
+        return s;
+    }
+    SGL_ERROR_CORE("sync: all %d sync objects in use", SGL_MAX_SYNCS);
+    return NULL;
+}
+
+sgl_sync_t *sgl_sync_lookup(const void *sync) {
+    for (int i = 0; i < SGL_MAX_SYNCS; i++) {
+        if (sync == &g_syncs[i]) return g_syncs[i].used ? &g_syncs[i] : NULL;
+    }
+    return NULL;
+}
+
+void sgl_sync_delete(sgl_sync_t *sync) {
+    if (!sync || !sync->used) return;
+    if (sync->backend && sync->backend->ops->delete_sync) {
+        sync->backend->ops->delete_sync(sync->backend, sync->handle);
+    }
+    sync->handle = 0;
+    sync->backend = NULL;
+    __atomic_store_n(&sync->used, false, __ATOMIC_RELEASE);
+}
+
+bool sgl_sync_wait(sgl_sync_t *sync, uint64_t timeout_ns) {
+    if (!sync || !sync->backend) return true;
+    return sync->backend->ops->wait_sync(sync->backend, sync->handle, timeout_ns);
+}
+
+void sgl_sync_release_backend(sgl_backend_t *be) {
+    for (int i = 0; i < SGL_MAX_SYNCS; i++) {
+        if (g_syncs[i].used && g_syncs[i].backend == be) {
+            be->ops->delete_sync(be, g_syncs[i].handle);
+            g_syncs[i].backend = NULL;
+        }
+    }
+}
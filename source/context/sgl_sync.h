@@ -0,0 +1,40 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * Fence Sync Objects
+ *
+ * One pool backs both GLsync (GL_APPLE_sync) and EGLSyncKHR
+ * (EGL_KHR_fence_sync): a sync is a pointer into it, remembering the
+ * backend that made the fence so it can be waited on from any thread or
+ * context. The backend submits the work recorded before the fence at
+ * creation, so a wait never depends on a later flush.
+ */
+
+#ifndef SGL_SYNC_H
+#define SGL_SYNC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sgl_gl_types.h"
+#include "../backend/sgl_backend.h"
+
+typedef struct sgl_sync {
+    bool used;
+    sgl_backend_t *backend;     /* Backend of the context that made the fence */
+    sgl_handle_t handle;        /* Backend sync handle */
+} sgl_sync_t;
+
+/* Fence all work recorded so far on a backend; NULL if the pool or backend is out */
+sgl_sync_t *sgl_sync_create(sgl_backend_t *be);
+
+/* The sync a GLsync/EGLSyncKHR value names, NULL if it is not a live sync */
+sgl_sync_t *sgl_sync_lookup(const void *sync);
+
+void sgl_sync_delete(sgl_sync_t *sync);
+
+/* Wait up to timeout_ns (0 polls, UINT64_MAX forever); true once signaled */
+bool sgl_sync_wait(sgl_sync_t *sync, uint64_t timeout_ns);
+
+/* Drop the syncs of a backend about to be destroyed (waits return signaled) */
+void sgl_sync_release_backend(sgl_backend_t *be);
+
+#endif /* SGL_SYNC_H */
@@ -6,6 +6,10 @@
  */
 
 #include "egl_internal.h"
+#include "util/sgl_log.h"
+#include "context/sgl_sync.h"
+#include <EGL/eglext.h>
+#include <GLES2/gl2sgl.h>
 #include <string.h>
 #include <stdio.h>
 
@@ -17,6 +21,12 @@ void sgl_egl_set_error(EGLint error) {
     g_sgl.last_error = error;
 }
 
+/* Depth-stencil image a swapchain slot renders with, NULL without depth */
+static DkImage *sgl_surface_depth_image(sgl_surface *surf, int slot) {
+    int index = surf->shared_depth ? 0 : slot;
+    return surf->depthbuffer_memblocks[index] ? &surf->depthbuffers[index] : NULL;
+}
+
 /*
  * Ensure frame is ready for rendering - called at start of frame (e.g., from glClear).
  * This implements the deko_basic pattern of acquiring at frame START, not end.
@@ -27,6 +37,9 @@ void sgl_ensure_frame_ready(void) {
         return;
     }
 
+    /* Recorders draw into the frame sglBeginRecorder made ready */
+    if (ctx->recorder) return;
+
     sgl_surface_t *surf = ctx->draw_surface;
     if (!surf->need_acquire) {
         return;
@@ -36,6 +49,7 @@ void sgl_ensure_frame_ready(void) {
     if (!dk) return;
 
     /* Acquire next framebuffer (blocks until available) */
+    uint64_t wait_start = armGetSystemTick();
     int slot = dkQueueAcquireImage(dk->queue, surf->swapchain);
     surf->current_slot = slot;
     surf->need_acquire = false;
@@ -45,128 +59,43 @@ void sgl_ensure_frame_ready(void) {
     if (ctx->backend && ctx->backend->ops->wait_fence) {
         ctx->backend->ops->wait_fence(ctx->backend, slot);
     }
+    g_sgl.acquire_wait_us = (uint32_t)(armTicksToNs(armGetSystemTick() - wait_start) / 1000);
 
-    /* Begin frame in backend */
-    if (ctx->backend && ctx->backend->ops->begin_frame) {
-        ctx->backend->ops->begin_frame(ctx->backend, slot);
-    }
-
-    /* Bind render target - always bind default first to set up backend state */
-    DkImageView colorView;
-    dkImageViewDefaults(&colorView, &surf->framebuffers[slot]);
-
-    if (surf->depthbuffer_memblocks[slot]) {
-        DkImageView depthView;
-        dkImageViewDefaults(&depthView, &surf->depthbuffers[slot]);
-        dkCmdBufBindRenderTarget(dk->cmdbuf, &colorView, &depthView);
-    } else {
-        dkCmdBufBindRenderTarget(dk->cmdbuf, &colorView, NULL);
-    }
-
-    /* Store framebuffer info in backend - per-slot depth buffers */
+    /* Store framebuffer info in backend - per-slot (or shared) depth buffers */
     dk->framebuffers = surf->framebuffers;
     for (int i = 0; i < SGL_FB_NUM; i++) {
-        dk->depth_images[i] = surf->depthbuffer_memblocks[i] ? &surf->depthbuffers[i] : NULL;
+        dk->depth_images[i] = sgl_surface_depth_image(surf, i);
     }
-    dk->num_framebuffers = SGL_FB_NUM;
+    dk->num_framebuffers = surf->num_framebuffers;
     dk->swapchain = surf->swapchain;
     dk->fb_width = surf->width;
     dk->fb_height = surf->height;
 
+    /* Begin frame in backend. It binds the default render target first to set
+     * up backend state: the swapchain image, or the internal target when
+     * rendering below the surface size (sglSetRenderResolution). */
+    if (ctx->backend && ctx->backend->ops->begin_frame) {
+        ctx->backend->ops->begin_frame(ctx->backend, slot);
+    }
+
     /* CRITICAL FIX: If an FBO is bound, re-bind it as render target.
      * We had to bind the default FB first to set up backend state,
      * but if user had an FBO bound, we need to restore that binding. */
     if (ctx->bound_framebuffer != 0 && ctx->backend->ops->bind_framebuffer) {
-        sgl_framebuffer_t *fbo = sgl_res_mgr_get_framebuffer(&ctx->res_mgr, ctx->bound_framebuffer);
-        if (fbo && fbo->color_attachment != 0) {
+        sgl_framebuffer_t *fbo = sgl_res_mgr_get_framebuffer(ctx->res_mgr, ctx->bound_framebuffer);
+        if (fbo && (fbo->color_attachments[0] != 0 || fbo->depth_attachment != 0)) {
             ctx->backend->ops->bind_framebuffer(ctx->backend, ctx->bound_framebuffer,
-                                                 fbo->color_attachment, fbo->depth_attachment);
+                                                 fbo->color_attachments[0],
+                                                 fbo->depth_is_renderbuffer ? fbo->depth_attachment : 0);
         }
     }
 
-    /* Set viewport and scissor */
-    DkViewport viewport = {
-        (float)ctx->viewport_state.viewport_x,
-        (float)ctx->viewport_state.viewport_y,
-        (float)ctx->viewport_state.viewport_width,
-        (float)ctx->viewport_state.viewport_height,
-        ctx->viewport_state.depth_near, ctx->viewport_state.depth_far
-    };
-    DkScissor scissor = {
-        (uint32_t)ctx->viewport_state.scissor_x,
-        (uint32_t)ctx->viewport_state.scissor_y,
-        (uint32_t)ctx->viewport_state.scissor_width,
-        (uint32_t)ctx->viewport_state.scissor_height
-    };
-    dkCmdBufSetViewports(dk->cmdbuf, 0, &viewport, 1);
-    dkCmdBufSetScissors(dk->cmdbuf, 0, &scissor, 1);
-
     /* Re-apply all GL state to the new command buffer.
      * This is CRITICAL because each frame uses a different cmdbuf slot,
      * and state bindings are recorded per-cmdbuf. Without this, only
-     * the first frame would have correct state (e.g., depth test, culling). */
-
-    /* Apply raster state (face culling) */
-    if (ctx->backend->ops->apply_raster) {
-        sgl_raster_state_t rs;
-        rs.cull_enabled = ctx->raster_state.cull_enabled;
-        rs.cull_mode = ctx->raster_state.cull_mode;
-        rs.front_face = ctx->raster_state.front_face;
-        ctx->backend->ops->apply_raster(ctx->backend, &rs);
-    }
-
-    /* Apply combined depth-stencil state (avoids overwrite issues) */
-    if (ctx->backend->ops->apply_depth_stencil) {
-        sgl_depth_stencil_state_t dss;
-        dss.depth_test_enabled = ctx->depth_state.depth_test_enabled;
-        dss.depth_write_enabled = ctx->depth_state.depth_write_enabled;
-        dss.depth_func = ctx->depth_state.depth_func;
-        dss.depth_clear_value = ctx->depth_state.clear_depth;
-        dss.stencil_test_enabled = ctx->depth_state.stencil_test_enabled;
-        dss.stencil_front.func = ctx->depth_state.front.func;
-        dss.stencil_front.ref = ctx->depth_state.front.ref;
-        dss.stencil_front.func_mask = ctx->depth_state.front.func_mask;
-        dss.stencil_front.write_mask = ctx->depth_state.front.write_mask;
-        dss.stencil_front.fail_op = ctx->depth_state.front.fail_op;
-        dss.stencil_front.zfail_op = ctx->depth_state.front.zfail_op;
-        dss.stencil_front.zpass_op = ctx->depth_state.front.zpass_op;
-        dss.stencil_back.func = ctx->depth_state.back.func;
-        dss.stencil_back.ref = ctx->depth_state.back.ref;
-        dss.stencil_back.func_mask = ctx->depth_state.back.func_mask;
-        dss.stencil_back.write_mask = ctx->depth_state.back.write_mask;
-        dss.stencil_back.fail_op = ctx->depth_state.back.fail_op;
-        dss.stencil_back.zfail_op = ctx->depth_state.back.zfail_op;
-        dss.stencil_back.zpass_op = ctx->depth_state.back.zpass_op;
-        dss.stencil_clear_value = ctx->depth_state.clear_stencil;
-        ctx->backend->ops->apply_depth_stencil(ctx->backend, &dss);
-    }
-
-    /* Apply blend state */
-    if (ctx->backend->ops->apply_blend) {
-        sgl_blend_state_t bs;
-        bs.enabled = ctx->blend_state.enabled;
-        bs.src_rgb = ctx->blend_state.src_rgb;
-        bs.dst_rgb = ctx->blend_state.dst_rgb;
-        bs.src_alpha = ctx->blend_state.src_alpha;
-        bs.dst_alpha = ctx->blend_state.dst_alpha;
-        bs.equation_rgb = ctx->blend_state.equation_rgb;
-        bs.equation_alpha = ctx->blend_state.equation_alpha;
-        ctx->backend->ops->apply_blend(ctx->backend, &bs);
-    }
-
-    /* Apply color mask */
-    if (ctx->backend->ops->apply_color_mask) {
-        sgl_color_state_t cs;
-        cs.mask[0] = ctx->color_state.mask[0];
-        cs.mask[1] = ctx->color_state.mask[1];
-        cs.mask[2] = ctx->color_state.mask[2];
-        cs.mask[3] = ctx->color_state.mask[3];
-        cs.clear_color[0] = ctx->color_state.clear_color[0];
-        cs.clear_color[1] = ctx->color_state.clear_color[1];
-        cs.clear_color[2] = ctx->color_state.clear_color[2];
-        cs.clear_color[3] = ctx->color_state.clear_color[3];
-        ctx->backend->ops->apply_color_mask(ctx->backend, &cs);
-    }
+     * the first frame would have correct state (e.g., depth test, culling).
+     * Marking everything dirty makes the next draw re-emit every group. */
+    sgl_context_invalidate_state(ctx);
 }
 
 /* ============================================================================
@@ -241,12 +170,34 @@ EGLAPI EGLBoolean EGLAPIENTRY eglInitialize(EGLDisplay dpy, EGLint *major, EGLin
     display->minor_version = 4;
     display->initialized = true;
 
+    /* Log messages are written by a background thread from here on */
+    sgl_log_init();
+
     if (major) *major = display->major_version;
     if (minor) *minor = display->minor_version;
 
     return EGL_TRUE;
 }
 
+/* Destroy a context; its share group's backend goes with the last context */
+static void sgl_egl_destroy_context(sgl_context_t *ctx) {
+    int group = (int)(ctx->res_mgr - g_sgl.res_mgrs);
+    sgl_backend_t *backend = g_sgl.backends[group];
+
+    if (ctx->res_mgr->share_count == 1 && backend) {
+        dk_backend_data_t *dk = (dk_backend_data_t *)backend->impl_data;
+        if (dk && dk->queue) {
+            dkQueueWaitIdle(dk->queue);
+        }
+        sgl_sync_release_backend(backend);
+        sgl_context_destroy(ctx);
+        dk_backend_destroy(backend);
+        g_sgl.backends[group] = NULL;
+        return;
+    }
+    sgl_context_destroy(ctx);
+}
+
 EGLAPI EGLBoolean EGLAPIENTRY eglTerminate(EGLDisplay dpy) {
     sgl_display *display = (sgl_display *)dpy;
 
@@ -260,17 +211,10 @@ EGLAPI EGLBoolean EGLAPIENTRY eglTerminate(EGLDisplay dpy) {
     }
 
     /* Destroy all contexts and backends */
+    sgl_context_make_current(NULL, false);
     for (int i = 0; i < SGL_MAX_CONTEXTS; i++) {
         if (g_sgl.contexts[i].used) {
-            if (g_sgl.backends[i]) {
-                dk_backend_data_t *dk = (dk_backend_data_t *)g_sgl.backends[i]->impl_data;
-                if (dk && dk->queue) {
-                    dkQueueWaitIdle(dk->queue);
-                }
-                dk_backend_destroy(g_sgl.backends[i]);
-                g_sgl.backends[i] = NULL;
-            }
-            sgl_context_destroy(&g_sgl.contexts[i]);
+            sgl_egl_destroy_context(&g_sgl.contexts[i]);
         }
     }
 
@@ -293,9 +237,8 @@ EGLAPI EGLBoolean EGLAPIENTRY eglTerminate(EGLDisplay dpy) {
     }
 
     display->initialized = false;
-    sgl_set_current_context(NULL);
-    g_sgl.current_context = NULL;
-    g_sgl.current_display = NULL;
+
+    sgl_log_shutdown();
 
     return EGL_TRUE;
 }
@@ -311,7 +254,7 @@ EGLAPI const char * EGLAPIENTRY eglQueryString(EGLDisplay dpy, EGLint name) {
     switch (name) {
         case EGL_VENDOR:      return "SwitchGLES";
         case EGL_VERSION:     return "1.4 SwitchGLES";
-        case EGL_EXTENSIONS:  return "";
+        case EGL_EXTENSIONS:  return "EGL_KHR_fence_sync";
         case EGL_CLIENT_APIS: return "OpenGL_ES";
         default:
             sgl_egl_set_error(EGL_BAD_PARAMETER);
@@ -465,7 +408,6 @@ EGLAPI EGLSurface EGLAPIENTRY eglCreateWindowSurface(EGLDisplay dpy, EGLConfig c
                                                       const EGLint *attrib_list) {
     sgl_display *display = (sgl_display *)dpy;
     sgl_config *cfg = (sgl_config *)config;
-    (void)attrib_list;
 
     if (display != &g_sgl.display || !display->initialized) {
         sgl_egl_set_error(EGL_BAD_DISPLAY);
@@ -489,6 +431,14 @@ EGLAPI EGLSurface EGLAPIENTRY eglCreateWindowSurface(EGLDisplay dpy, EGLConfig c
     memset(surf, 0, sizeof(sgl_surface));
     surf->width = SGL_FB_WIDTH;
     surf->height = SGL_FB_HEIGHT;
+    surf->num_framebuffers = g_sgl.swapchain_images ? g_sgl.swapchain_images : SGL_FB_NUM;
+    surf->shared_depth = true;
+
+    for (const EGLint *attr = attrib_list; attr && attr[0] != EGL_NONE; attr += 2) {
+        if (attr[0] == EGL_SHARED_DEPTH_BUFFER_SGL) {
+            surf->shared_depth = attr[1] != EGL_FALSE;
+        }
+    }
 
     /* Create framebuffer layout */
     DkImageLayoutMaker imageLayoutMaker;
@@ -507,7 +457,7 @@ EGLAPI EGLSurface EGLAPIENTRY eglCreateWindowSurface(EGLDisplay dpy, EGLConfig c
 
     /* Create framebuffer memory block */
     DkMemBlockMaker memBlockMaker;
-    dkMemBlockMakerDefaults(&memBlockMaker, display->device, SGL_FB_NUM * fbSize);
+    dkMemBlockMakerDefaults(&memBlockMaker, display->device, surf->num_framebuffers * fbSize);
     memBlockMaker.flags = DkMemBlockFlags_GpuCached | DkMemBlockFlags_Image;
     surf->framebuffer_memblock = dkMemBlockCreate(&memBlockMaker);
 
@@ -518,12 +468,15 @@ EGLAPI EGLSurface EGLAPIENTRY eglCreateWindowSurface(EGLDisplay dpy, EGLConfig c
 
     /* Initialize framebuffer images */
     DkImage const *swapchainImages[SGL_FB_NUM];
-    for (int i = 0; i < SGL_FB_NUM; i++) {
+    for (int i = 0; i < surf->num_framebuffers; i++) {
         swapchainImages[i] = &surf->framebuffers[i];
         dkImageInitialize(&surf->framebuffers[i], &fbLayout, surf->framebuffer_memblock, i * fbSize);
     }
 
-    /* Create depth buffers if needed - ONE PER FRAMEBUFFER SLOT for proper sync */
+    /* Create depth buffers if needed. Slots are rendered in submission order on
+     * one queue and depth is not kept across swaps (EGL_BUFFER_DESTROYED), so
+     * by default they share one; EGL_SHARED_DEPTH_BUFFER_SGL = EGL_FALSE gives
+     * each slot its own. */
     if (cfg->depth_size > 0) {
         DkImageLayoutMaker depthLayoutMaker;
         dkImageLayoutMakerDefaults(&depthLayoutMaker, display->device);
@@ -539,8 +492,8 @@ EGLAPI EGLSurface EGLAPIENTRY eglCreateWindowSurface(EGLDisplay dpy, EGLConfig c
         uint32_t depthAlign = dkImageLayoutGetAlignment(&depthLayout);
         depthSize = (depthSize + depthAlign - 1) & ~(depthAlign - 1);
 
-        /* Create one depth buffer per framebuffer slot */
-        for (int i = 0; i < SGL_FB_NUM; i++) {
+        int num_depth = surf->shared_depth ? 1 : surf->num_framebuffers;
+        for (int i = 0; i < num_depth; i++) {
             dkMemBlockMakerDefaults(&memBlockMaker, display->device, depthSize);
             memBlockMaker.flags = DkMemBlockFlags_GpuCached | DkMemBlockFlags_Image;
             surf->depthbuffer_memblocks[i] = dkMemBlockCreate(&memBlockMaker);
@@ -564,7 +517,8 @@ EGLAPI EGLSurface EGLAPIENTRY eglCreateWindowSurface(EGLDisplay dpy, EGLConfig c
     NWindow *nwin = win ? (NWindow *)win : nwindowGetDefault();
 
     DkSwapchainMaker swapchainMaker;
-    dkSwapchainMakerDefaults(&swapchainMaker, display->device, nwin, swapchainImages, SGL_FB_NUM);
+    dkSwapchainMakerDefaults(&swapchainMaker, display->device, nwin, swapchainImages,
+                             surf->num_framebuffers);
     surf->swapchain = dkSwapchainCreate(&swapchainMaker);
 
     if (!surf->swapchain) {
@@ -637,6 +591,7 @@ EGLAPI EGLBoolean EGLAPIENTRY eglQuerySurface(EGLDisplay dpy, EGLSurface surface
         case EGL_LARGEST_PBUFFER: *value = EGL_FALSE; break;
         case EGL_RENDER_BUFFER: *value = EGL_BACK_BUFFER; break;
         case EGL_SWAP_BEHAVIOR: *value = EGL_BUFFER_DESTROYED; break;
+        case EGL_SHARED_DEPTH_BUFFER_SGL: *value = surf->shared_depth ? EGL_TRUE : EGL_FALSE; break;
         default:
             sgl_egl_set_error(EGL_BAD_ATTRIBUTE);
             return EGL_FALSE;
@@ -653,32 +608,49 @@ EGLAPI EGLContext EGLAPIENTRY eglCreateContext(EGLDisplay dpy, EGLConfig config,
                                                 EGLContext share_context,
                                                 const EGLint *attrib_list) {
     sgl_display *display = (sgl_display *)dpy;
+    sgl_context_t *share = (sgl_context_t *)share_context;
     (void)config;
-    (void)share_context;
 
     if (display != &g_sgl.display || !display->initialized) {
         sgl_egl_set_error(EGL_BAD_DISPLAY);
         return EGL_NO_CONTEXT;
     }
 
+    if (share && !share->used) {
+        sgl_egl_set_error(EGL_BAD_CONTEXT);
+        return EGL_NO_CONTEXT;
+    }
+
     EGLint client_version = 1;
+    sgl_heap_config_t heaps = g_sgl.heap_config;
+    bool bad_size = false;
     if (attrib_list) {
         for (int i = 0; attrib_list[i] != EGL_NONE; i += 2) {
-            if (attrib_list[i] == EGL_CONTEXT_CLIENT_VERSION) {
-                client_version = attrib_list[i+1];
+            EGLint value = attrib_list[i+1];
+            switch (attrib_list[i]) {
+                case EGL_CONTEXT_CLIENT_VERSION: client_version = value; break;
+                case EGL_HEAP_CODE_SIZE_SGL:     heaps.code_size = (GLuint)value; break;
+                case EGL_HEAP_DATA_SIZE_SGL:     heaps.data_size = (GLuint)value; break;
+                case EGL_HEAP_TEXTURE_SIZE_SGL:  heaps.texture_size = (GLuint)value; break;
+                case EGL_HEAP_STAGING_SIZE_SGL:  heaps.staging_size = (GLuint)value; break;
+                case EGL_HEAP_COMMAND_SIZE_SGL:  heaps.cmd_size = (GLuint)value; break;
+                case EGL_HEAP_FIXED_SIZE_SGL:    heaps.fixed_size = value ? GL_TRUE : GL_FALSE; break;
+                default: continue;
             }
+            if (value < 0) bad_size = true;
         }
     }
 
-    if (client_version != 2) {
+    if (client_version != 2 || bad_size) {
         sgl_egl_set_error(EGL_BAD_ATTRIBUTE);
         return EGL_NO_CONTEXT;
     }
 
-    /* Find free context slot */
+    /* Find free context slot. A new share group also needs the slot's
+     * resource manager, which stays taken while any context of its group lives */
     int ctx_idx = -1;
     for (int i = 0; i < SGL_MAX_CONTEXTS; i++) {
-        if (!g_sgl.contexts[i].used) {
+        if (!g_sgl.contexts[i].used && (share || g_sgl.res_mgrs[i].share_count == 0)) {
             ctx_idx = i;
             break;
         }
@@ -690,27 +662,34 @@ EGLAPI EGLContext EGLAPIENTRY eglCreateContext(EGLDisplay dpy, EGLConfig config,
     }
 
     sgl_context_t *ctx = &g_sgl.contexts[ctx_idx];
+    sgl_backend_t *backend;
 
-    /* Initialize context */
-    sgl_context_init(ctx);
-    ctx->client_version = client_version;
+    if (share) {
+        /* Join the share group: its objects, backend and GPU queue */
+        backend = share->backend;
+        backend->ops->share(backend);
+    } else {
+        /* Create backend */
+        backend = dk_backend_create(display->device);
+        if (!backend) {
+            sgl_egl_set_error(EGL_BAD_ALLOC);
+            return EGL_NO_CONTEXT;
+        }
 
-    /* Create backend */
-    sgl_backend_t *backend = dk_backend_create(display->device);
-    if (!backend) {
-        sgl_egl_set_error(EGL_BAD_ALLOC);
-        return EGL_NO_CONTEXT;
+        /* Initialize backend */
+        if (backend->ops->init(backend, display->device, &heaps) != 0) {
+            dk_backend_destroy(backend);
+            sgl_egl_set_error(EGL_BAD_ALLOC);
+            return EGL_NO_CONTEXT;
+        }
+        g_sgl.backends[ctx_idx] = backend;
     }
 
-    /* Initialize backend */
-    if (backend->ops->init(backend, display->device) != 0) {
-        dk_backend_destroy(backend);
-        sgl_egl_set_error(EGL_BAD_ALLOC);
-        return EGL_NO_CONTEXT;
-    }
+    /* Initialize context */
+    sgl_context_init(ctx, share ? share->res_mgr : &g_sgl.res_mgrs[ctx_idx]);
+    ctx->client_version = client_version;
 
     ctx->backend = backend;
-    g_sgl.backends[ctx_idx] = backend;
     ctx->used = true;
 
     /* Initialize GL state to defaults */
@@ -734,20 +713,10 @@ EGLAPI EGLBoolean EGLAPIENTRY eglDestroyContext(EGLDisplay dpy, EGLContext conte
     }
 
     if (sgl_get_current_context() == ctx) {
-        sgl_set_current_context(NULL);
-        g_sgl.current_context = NULL;
+        sgl_context_make_current(NULL, false);
     }
 
-    /* Find and destroy backend */
-    for (int i = 0; i < SGL_MAX_CONTEXTS; i++) {
-        if (&g_sgl.contexts[i] == ctx && g_sgl.backends[i]) {
-            dk_backend_destroy(g_sgl.backends[i]);
-            g_sgl.backends[i] = NULL;
-            break;
-        }
-    }
-
-    sgl_context_destroy(ctx);
+    sgl_egl_destroy_context(ctx);
     return EGL_TRUE;
 }
 
@@ -764,9 +733,7 @@ EGLAPI EGLBoolean EGLAPIENTRY eglMakeCurrent(EGLDisplay dpy, EGLSurface draw,
     }
 
     if (context == EGL_NO_CONTEXT) {
-        sgl_set_current_context(NULL);
-        g_sgl.current_context = NULL;
-        g_sgl.current_display = NULL;
+        sgl_context_make_current(NULL, false);
         return EGL_TRUE;
     }
 
@@ -775,13 +742,15 @@ EGLAPI EGLBoolean EGLAPIENTRY eglMakeCurrent(EGLDisplay dpy, EGLSurface draw,
         return EGL_FALSE;
     }
 
+    /* Current on another thread; without a surface, a shared context uploads */
+    if (!sgl_context_make_current(ctx, draw != EGL_NO_SURFACE)) {
+        sgl_egl_set_error(EGL_BAD_ACCESS);
+        return EGL_FALSE;
+    }
+
     ctx->draw_surface = draw_surf;
     ctx->read_surface = read_surf;
 
-    sgl_set_current_context(ctx);
-    g_sgl.current_context = ctx;
-    g_sgl.current_display = display;
-
     /* Get backend */
     dk_backend_data_t *dk = ctx->backend ? (dk_backend_data_t *)ctx->backend->impl_data : NULL;
     if (!dk) {
@@ -789,13 +758,13 @@ EGLAPI EGLBoolean EGLAPIENTRY eglMakeCurrent(EGLDisplay dpy, EGLSurface draw,
         return EGL_FALSE;
     }
 
-    /* Store framebuffer info - per-slot depth buffers */
+    /* Store framebuffer info - per-slot (or shared) depth buffers */
     if (draw_surf) {
         dk->framebuffers = draw_surf->framebuffers;
         for (int i = 0; i < SGL_FB_NUM; i++) {
-            dk->depth_images[i] = draw_surf->depthbuffer_memblocks[i] ? &draw_surf->depthbuffers[i] : NULL;
+            dk->depth_images[i] = sgl_surface_depth_image(draw_surf, i);
         }
-        dk->num_framebuffers = SGL_FB_NUM;
+        dk->num_framebuffers = draw_surf->num_framebuffers;
         dk->swapchain = draw_surf->swapchain;
         dk->fb_width = draw_surf->width;
         dk->fb_height = draw_surf->height;
@@ -808,22 +777,10 @@ EGLAPI EGLBoolean EGLAPIENTRY eglMakeCurrent(EGLDisplay dpy, EGLSurface draw,
         draw_surf->current_slot = slot;
         draw_surf->need_acquire = false;
 
-        /* Begin frame */
+        /* Begin frame - binds the default render target */
         if (ctx->backend->ops->begin_frame) {
             ctx->backend->ops->begin_frame(ctx->backend, slot);
         }
-
-        /* Bind render target */
-        DkImageView colorView;
-        dkImageViewDefaults(&colorView, &draw_surf->framebuffers[slot]);
-
-        if (draw_surf->depthbuffer_memblocks[slot]) {
-            DkImageView depthView;
-            dkImageViewDefaults(&depthView, &draw_surf->depthbuffers[slot]);
-            dkCmdBufBindRenderTarget(dk->cmdbuf, &colorView, &depthView);
-        } else {
-            dkCmdBufBindRenderTarget(dk->cmdbuf, &colorView, NULL);
-        }
     }
 
     return EGL_TRUE;
@@ -859,6 +816,9 @@ EGLAPI EGLBoolean EGLAPIENTRY eglSwapBuffers(EGLDisplay dpy, EGLSurface surface)
         return EGL_FALSE;
     }
 
+    sgl_context_flush_deferred(ctx);
+    sgl_context_capture_swap(ctx);
+
     /* If no rendering happened since last swap (need_acquire still true),
        skip the swap - the previous frame is still displayed */
     if (surf->need_acquire) {
@@ -877,8 +837,20 @@ EGLAPI EGLBoolean EGLAPIENTRY eglSwapBuffers(EGLDisplay dpy, EGLSurface surface)
         ctx->backend->ops->present(ctx->backend, slot);
     }
 
+    /* Low latency: let the GPU drain before the application samples input for
+     * the next frame. The fence stays active; the slot's next wait_fence
+     * returns immediately and recycles the cmdbuf as usual. */
+    if (g_sgl.frame_pacing == SGL_FRAME_PACING_LOW_LATENCY && slot >= 0 && dk->fence_active[slot]) {
+        uint64_t wait_start = armGetSystemTick();
+        dkFenceWait(&dk->fences[slot], -1);
+        g_sgl.gpu_wait_us = (uint32_t)(armTicksToNs(armGetSystemTick() - wait_start) / 1000);
+    } else {
+        g_sgl.gpu_wait_us = 0;
+    }
+
     /* Mark that we need to acquire at start of next frame */
     surf->need_acquire = true;
+    ctx->frame_count++;  /* Ages promoted client arrays (gl_client_array.c) */
 
     return EGL_TRUE;
 }
@@ -905,6 +877,51 @@ EGLAPI EGLBoolean EGLAPIENTRY eglSwapInterval(EGLDisplay dpy, EGLint interval) {
     return EGL_TRUE;
 }
 
+/* ============================================================================
+ * Frame Pacing (sglSetFramePacing)
+ * ============================================================================ */
+
+GL_APICALL void GL_APIENTRY sglSetFramePacing(GLint swapchain_images, GLenum mode) {
+    if (swapchain_images != 0 && (swapchain_images < 2 || swapchain_images > SGL_FB_NUM)) return;
+    if (mode != SGL_FRAME_PACING_THROUGHPUT && mode != SGL_FRAME_PACING_LOW_LATENCY) return;
+    g_sgl.swapchain_images = swapchain_images;
+    g_sgl.frame_pacing = mode;
+}
+
+GL_APICALL void GL_APIENTRY sglGetFrameLatency(GLuint *swapchain_images, GLuint *queued_frames,
+                                               GLuint *acquire_wait_us, GLuint *gpu_wait_us) {
+    sgl_context_t *ctx = sgl_get_current_context();
+    int images = g_sgl.swapchain_images ? g_sgl.swapchain_images : SGL_FB_NUM;
+    if (ctx && ctx->draw_surface) images = ctx->draw_surface->num_framebuffers;
+
+    if (swapchain_images) *swapchain_images = (GLuint)images;
+    if (queued_frames) {
+        *queued_frames = g_sgl.frame_pacing == SGL_FRAME_PACING_LOW_LATENCY ? 0 : (GLuint)(images - 1);
+    }
+    if (acquire_wait_us) *acquire_wait_us = g_sgl.acquire_wait_us;
+    if (gpu_wait_us) *gpu_wait_us = g_sgl.gpu_wait_us;
+}
+
+/* ============================================================================
+ * Heap Sizes (sglSetHeapConfig)
+ * ============================================================================ */
+
+GL_APICALL void GL_APIENTRY sglSetHeapConfig(const sgl_heap_config_t *config) {
+    if (config) {
+        g_sgl.heap_config = *config;
+    } else {
+        memset(&g_sgl.heap_config, 0, sizeof(g_sgl.heap_config));
+    }
+}
+
+/* ============================================================================
+ * Logging (sglSetLogOutput)
+ * ============================================================================ */
+
+GL_APICALL GLboolean GL_APIENTRY sglSetLogOutput(const GLchar *path) {
+    return sgl_log_set_output(path) ? GL_TRUE : GL_FALSE;
+}
+
 /* ============================================================================
  * EGL Query Functions
  * ============================================================================ */
@@ -914,7 +931,8 @@ EGLAPI EGLContext EGLAPIENTRY eglGetCurrentContext(void) {
 }
 
 EGLAPI EGLDisplay EGLAPIENTRY eglGetCurrentDisplay(void) {
-    return (EGLDisplay)g_sgl.current_display;
+    /* There is one display, current on every thread with a current context */
+    return sgl_get_current_context() ? (EGLDisplay)&g_sgl.display : EGL_NO_DISPLAY;
 }
 
 EGLAPI EGLSurface EGLAPIENTRY eglGetCurrentSurface(EGLint readdraw) {
@@ -1024,6 +1042,88 @@ EGLAPI EGLBoolean EGLAPIENTRY eglReleaseTexImage(EGLDisplay dpy, EGLSurface surf
     return EGL_FALSE;
 }
 
+/* ============================================================================
+ * EGL_KHR_fence_sync
+ *
+ * Fences share the GL_APPLE_sync pool (context/sgl_sync.h). Creating one
+ * submits the current context's work without waiting, so a wait never
+ * needs EGL_SYNC_FLUSH_COMMANDS_BIT_KHR to make progress.
+ * ============================================================================ */
+
+static bool sgl_egl_check_display(EGLDisplay dpy) {
+    sgl_display *display = (sgl_display *)dpy;
+    if (display != &g_sgl.display || !display->initialized) {
+        sgl_egl_set_error(EGL_BAD_DISPLAY);
+        return false;
+    }
+    return true;
+}
+
+EGLAPI EGLSyncKHR EGLAPIENTRY eglCreateSyncKHR(EGLDisplay dpy, EGLenum type, const EGLint *attrib_list) {
+    if (!sgl_egl_check_display(dpy)) return EGL_NO_SYNC_KHR;
+    if (type != EGL_SYNC_FENCE_KHR || (attrib_list && attrib_list[0] != EGL_NONE)) {
+        sgl_egl_set_error(EGL_BAD_ATTRIBUTE);
+        return EGL_NO_SYNC_KHR;
+    }
+
+    sgl_context_t *ctx = sgl_get_current_context();
+    if (!ctx || !ctx->backend || ctx->recorder) {
+        sgl_egl_set_error(EGL_BAD_MATCH);
+        return EGL_NO_SYNC_KHR;
+    }
+
+    sgl_ensure_frame_ready();
+    sgl_sync_t *sync = sgl_sync_create(ctx->backend);
+    if (!sync) {
+        sgl_egl_set_error(EGL_BAD_ALLOC);
+        return EGL_NO_SYNC_KHR;
+    }
+    return (EGLSyncKHR)sync;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglDestroySyncKHR(EGLDisplay dpy, EGLSyncKHR sync) {
+    if (!sgl_egl_check_display(dpy)) return EGL_FALSE;
+    sgl_sync_t *s = sgl_sync_lookup(sync);
+    if (!s) {
+        sgl_egl_set_error(EGL_BAD_PARAMETER);
+        return EGL_FALSE;
+    }
+    sgl_sync_delete(s);
+    return EGL_TRUE;
+}
+
+EGLAPI EGLint EGLAPIENTRY eglClientWaitSyncKHR(EGLDisplay dpy, EGLSyncKHR sync, EGLint flags, EGLTimeKHR timeout) {
+    (void)flags;
+    if (!sgl_egl_check_display(dpy)) return EGL_FALSE;
+    sgl_sync_t *s = sgl_sync_lookup(sync);
+    if (!s) {
+        sgl_egl_set_error(EGL_BAD_PARAMETER);
+        return EGL_FALSE;
+    }
+    return sgl_sync_wait(s, timeout) ? EGL_CONDITION_SATISFIED_KHR : EGL_TIMEOUT_EXPIRED_KHR;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglGetSyncAttribKHR(EGLDisplay dpy, EGLSyncKHR sync, EGLint attribute, EGLint *value) {
+    if (!sgl_egl_check_display(dpy)) return EGL_FALSE;
+    sgl_sync_t *s = sgl_sync_lookup(sync);
+    if (!s || !value) {
+        sgl_egl_set_error(EGL_BAD_PARAMETER);
+        return EGL_FALSE;
+    }
+
+    switch (attribute) {
+        case EGL_SYNC_TYPE_KHR:      *value = EGL_SYNC_FENCE_KHR; break;
+        case EGL_SYNC_CONDITION_KHR: *value = EGL_SYNC_PRIOR_COMMANDS_COMPLETE_KHR; break;
+        case EGL_SYNC_STATUS_KHR:
+            *value = sgl_sync_wait(s, 0) ? EGL_SIGNALED_KHR : EGL_UNSIGNALED_KHR;
+            break;
+        default:
+            sgl_egl_set_error(EGL_BAD_ATTRIBUTE);
+            return EGL_FALSE;
+    }
+    return EGL_TRUE;
+}
+
 /* ============================================================================
  * eglGetProcAddress - GL function pointer dispatch table
  *
@@ -1034,8 +1134,66 @@ EGLAPI EGLBoolean EGLAPIENTRY eglReleaseTexImage(EGLDisplay dpy, EGLSurface surf
 GL_APICALL void GL_APIENTRY glFogf(GLenum pname, GLfloat param);
 GL_APICALL void GL_APIENTRY glFogfv(GLenum pname, const GLfloat *params);
 GL_APICALL void GL_APIENTRY glBlitFramebuffer(GLint, GLint, GLint, GLint, GLint, GLint, GLint, GLint, GLbitfield, GLenum);
+GL_APICALL void GL_APIENTRY glBlitFramebufferANGLE(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1,
+                                                    GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1,
+                                                    GLbitfield mask, GLenum filter);
+GL_APICALL void GL_APIENTRY glBlitFramebufferNV(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1,
+                                                 GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1,
+                                                 GLbitfield mask, GLenum filter);
+GL_APICALL void GL_APIENTRY glDrawBuffersEXT(GLsizei n, const GLenum *bufs);
+GL_APICALL void GL_APIENTRY glDiscardFramebufferEXT(GLenum target, GLsizei numAttachments,
+                                                     const GLenum *attachments);
 GL_APICALL void GL_APIENTRY glRenderbufferStorageMultisample(GLenum, GLsizei, GLenum, GLsizei, GLsizei);
 GL_APICALL const GLubyte *GL_APIENTRY glGetStringi(GLenum name, GLuint index);
+GL_APICALL void GL_APIENTRY glGenVertexArraysOES(GLsizei n, GLuint *arrays);
+GL_APICALL void GL_APIENTRY glBindVertexArrayOES(GLuint array);
+GL_APICALL void GL_APIENTRY glDeleteVertexArraysOES(GLsizei n, const GLuint *arrays);
+GL_APICALL GLboolean GL_APIENTRY glIsVertexArrayOES(GLuint array);
+GL_APICALL void *GL_APIENTRY glMapBufferOES(GLenum target, GLenum access);
+GL_APICALL GLboolean GL_APIENTRY glUnmapBufferOES(GLenum target);
+GL_APICALL void GL_APIENTRY glGetBufferPointervOES(GLenum target, GLenum pname, void **params);
+GL_APICALL void *GL_APIENTRY glMapBufferRangeEXT(GLenum target, GLintptr offset, GLsizeiptr length,
+                                                 GLbitfield access);
+GL_APICALL void GL_APIENTRY glFlushMappedBufferRangeEXT(GLenum target, GLintptr offset, GLsizeiptr length);
+GL_APICALL void GL_APIENTRY glGetProgramBinaryOES(GLuint program, GLsizei bufSize, GLsizei *length,
+                                                   GLenum *binaryFormat, void *binary);
+GL_APICALL void GL_APIENTRY glProgramBinaryOES(GLuint program, GLenum binaryFormat,
+                                                const void *binary, GLint length);
+GL_APICALL void GL_APIENTRY glMaxShaderCompilerThreadsKHR(GLuint count);
+GL_APICALL void GL_APIENTRY glMultiDrawArraysEXT(GLenum mode, const GLint *first, const GLsizei *count,
+                                                  GLsizei primcount);
+GL_APICALL void GL_APIENTRY glMultiDrawElementsEXT(GLenum mode, const GLsizei *count, GLenum type,
+                                                    const void *const *indices, GLsizei primcount);
+GL_APICALL void GL_APIENTRY glVertexAttribDivisorANGLE(GLuint index, GLuint divisor);
+GL_APICALL void GL_APIENTRY glDrawArraysInstancedANGLE(GLenum mode, GLint first, GLsizei count,
+                                                        GLsizei primcount);
+GL_APICALL void GL_APIENTRY glDrawElementsInstancedANGLE(GLenum mode, GLsizei count, GLenum type,
+                                                          const void *indices, GLsizei primcount);
+GL_APICALL void GL_APIENTRY glVertexAttribDivisorEXT(GLuint index, GLuint divisor);
+GL_APICALL void GL_APIENTRY glDrawArraysInstancedEXT(GLenum mode, GLint start, GLsizei count,
+                                                      GLsizei primcount);
+GL_APICALL void GL_APIENTRY glDrawElementsInstancedEXT(GLenum mode, GLsizei count, GLenum type,
+                                                        const void *indices, GLsizei primcount);
+GL_APICALL void GL_APIENTRY glGenQueriesEXT(GLsizei n, GLuint *ids);
+GL_APICALL void GL_APIENTRY glDeleteQueriesEXT(GLsizei n, const GLuint *ids);
+GL_APICALL GLboolean GL_APIENTRY glIsQueryEXT(GLuint id);
+GL_APICALL void GL_APIENTRY glBeginQueryEXT(GLenum target, GLuint id);
+GL_APICALL void GL_APIENTRY glEndQueryEXT(GLenum target);
+GL_APICALL void GL_APIENTRY glQueryCounterEXT(GLuint id, GLenum target);
+GL_APICALL void GL_APIENTRY glGetQueryivEXT(GLenum target, GLenum pname, GLint *params);
+GL_APICALL void GL_APIENTRY glGetQueryObjectivEXT(GLuint id, GLenum pname, GLint *params);
+GL_APICALL void GL_APIENTRY glGetQueryObjectuivEXT(GLuint id, GLenum pname, GLuint *params);
+GL_APICALL void GL_APIENTRY glGetQueryObjecti64vEXT(GLuint id, GLenum pname, GLint64 *params);
+GL_APICALL void GL_APIENTRY glGetQueryObjectui64vEXT(GLuint id, GLenum pname, GLuint64 *params);
+GL_APICALL void GL_APIENTRY glGetInteger64vEXT(GLenum pname, GLint64 *params);
+GL_APICALL GLsync GL_APIENTRY glFenceSyncAPPLE(GLenum condition, GLbitfield flags);
+GL_APICALL GLboolean GL_APIENTRY glIsSyncAPPLE(GLsync sync);
+GL_APICALL void GL_APIENTRY glDeleteSyncAPPLE(GLsync sync);
+GL_APICALL GLenum GL_APIENTRY glClientWaitSyncAPPLE(GLsync sync, GLbitfield flags, GLuint64 timeout);
+GL_APICALL void GL_APIENTRY glWaitSyncAPPLE(GLsync sync, GLbitfield flags, GLuint64 timeout);
+GL_APICALL void GL_APIENTRY glGetInteger64vAPPLE(GLenum pname, GLint64 *params);
+GL_APICALL void GL_APIENTRY glGetSyncivAPPLE(GLsync sync, GLenum pname, GLsizei bufSize,
+                                              GLsizei *length, GLint *values);
 
 typedef struct {
     const char *name;
@@ -1207,6 +1365,81 @@ static const sgl_proc_entry_t s_proc_table[] = {
     PROC_ENTRY(glGetRenderbufferParameteriv),
     PROC_ENTRY(glGetAttachedShaders),
 
+    /* GL_OES_vertex_array_object */
+    PROC_ENTRY(glGenVertexArraysOES),
+    PROC_ENTRY(glBindVertexArrayOES),
+    PROC_ENTRY(glDeleteVertexArraysOES),
+    PROC_ENTRY(glIsVertexArrayOES),
+
+    /* GL_OES_mapbuffer */
+    PROC_ENTRY(glMapBufferOES),
+    PROC_ENTRY(glUnmapBufferOES),
+    PROC_ENTRY(glGetBufferPointervOES),
+
+    /* GL_EXT_map_buffer_range */
+    PROC_ENTRY(glMapBufferRangeEXT),
+    PROC_ENTRY(glFlushMappedBufferRangeEXT),
+
+    /* GL_OES_get_program_binary */
+    PROC_ENTRY(glGetProgramBinaryOES),
+    PROC_ENTRY(glProgramBinaryOES),
+
+    /* GL_KHR_parallel_shader_compile */
+    PROC_ENTRY(glMaxShaderCompilerThreadsKHR),
+
+    /* GL_ANGLE_instanced_arrays */
+    PROC_ENTRY(glVertexAttribDivisorANGLE),
+    PROC_ENTRY(glDrawArraysInstancedANGLE),
+    PROC_ENTRY(glDrawElementsInstancedANGLE),
+
+    /* GL_EXT_instanced_arrays / GL_EXT_draw_instanced */
+    PROC_ENTRY(glVertexAttribDivisorEXT),
+    PROC_ENTRY(glDrawArraysInstancedEXT),
+    PROC_ENTRY(glDrawElementsInstancedEXT),
+
+    /* GL_EXT_multi_draw_arrays */
+    PROC_ENTRY(glMultiDrawArraysEXT),
+    PROC_ENTRY(glMultiDrawElementsEXT),
+
+    /* GL_EXT_disjoint_timer_query */
+    PROC_ENTRY(glGenQueriesEXT),
+    PROC_ENTRY(glDeleteQueriesEXT),
+    PROC_ENTRY(glIsQueryEXT),
+    PROC_ENTRY(glBeginQueryEXT),
+    PROC_ENTRY(glEndQueryEXT),
+    PROC_ENTRY(glQueryCounterEXT),
+    PROC_ENTRY(glGetQueryivEXT),
+    PROC_ENTRY(glGetQueryObjectivEXT),
+    PROC_ENTRY(glGetQueryObjectuivEXT),
+    PROC_ENTRY(glGetQueryObjecti64vEXT),
+    PROC_ENTRY(glGetQueryObjectui64vEXT),
+    PROC_ENTRY(glGetInteger64vEXT),
+
+    /* GL_APPLE_sync */
+    PROC_ENTRY(glFenceSyncAPPLE),
+    PROC_ENTRY(glIsSyncAPPLE),
+    PROC_ENTRY(glDeleteSyncAPPLE),
+    PROC_ENTRY(glClientWaitSyncAPPLE),
+    PROC_ENTRY(glWaitSyncAPPLE),
+    PROC_ENTRY(glGetInteger64vAPPLE),
+    PROC_ENTRY(glGetSyncivAPPLE),
+
+    /* GL_ANGLE_framebuffer_blit, GL_NV_framebuffer_blit */
+    PROC_ENTRY(glBlitFramebufferANGLE),
+    PROC_ENTRY(glBlitFramebufferNV),
+
+    /* GL_EXT_draw_buffers */
+    PROC_ENTRY(glDrawBuffersEXT),
+
+    /* GL_EXT_discard_framebuffer */
+    PROC_ENTRY(glDiscardFramebufferEXT),
+
+    /* EGL_KHR_fence_sync */
+    PROC_ENTRY(eglCreateSyncKHR),
+    PROC_ENTRY(eglDestroySyncKHR),
+    PROC_ENTRY(eglClientWaitSyncKHR),
+    PROC_ENTRY(eglGetSyncAttribKHR),
+
     { NULL, NULL }
 };
 
@@ -58,10 +58,12 @@ typedef struct sgl_surface {
     /* Framebuffer memory and images */
     DkMemBlock framebuffer_memblock;
     DkImage framebuffers[SGL_FB_NUM];
+    int num_framebuffers;   /* Swapchain images in use (2 or SGL_FB_NUM) */
 
-    /* Depth buffers - one per framebuffer slot for proper synchronization */
+    /* Depth buffers - index 0 only when shared_depth, otherwise one per slot */
     DkMemBlock depthbuffer_memblocks[SGL_FB_NUM];
     DkImage depthbuffers[SGL_FB_NUM];
+    bool shared_depth;      /* All slots render with depthbuffers[0] (EGL_SHARED_DEPTH_BUFFER_SGL) */
 
     /* Current framebuffer slot */
     int current_slot;
@@ -87,12 +89,20 @@ typedef struct {
     /* Contexts pool - now using new sgl_context_t */
     sgl_context_t contexts[SGL_MAX_CONTEXTS];
 
-    /* Backends pool - one per context */
+    /* GL object pools - one per share group */
+    sgl_resource_manager_t res_mgrs[SGL_MAX_CONTEXTS];
+
+    /* Backends pool - one per share group, at its resource manager's slot */
     sgl_backend_t *backends[SGL_MAX_CONTEXTS];
 
-    /* Current context */
-    sgl_context_t *current_context;
-    sgl_display *current_display;
+    /* Frame pacing (sglSetFramePacing); 0 = defaults */
+    int swapchain_images;       /* For surfaces created from now on */
+    GLenum frame_pacing;
+    uint32_t acquire_wait_us;   /* Last frame: blocked in acquire + slot fence */
+    uint32_t gpu_wait_us;       /* Last frame: blocked waiting for the GPU at swap */
+
+    /* Heap sizes for backends created from now on (sglSetHeapConfig); 0 = defaults */
+    sgl_heap_config_t heap_config;
 
     /* Predefined configs */
     sgl_config configs[2]; /* RGBA8, RGBA8+D24S8 */
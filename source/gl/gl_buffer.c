@@ -4,8 +4,188 @@
  */
 
 #include "gl_common.h"
+#include "../util/sgl_index.h"
+#include <stdlib.h>
 #include <string.h>
 
+GLuint *sgl_buffer_binding(sgl_context_t *ctx, GLenum target) {
+    switch (target) {
+        case GL_ARRAY_BUFFER:           return &ctx->bound_array_buffer;
+        case GL_ELEMENT_ARRAY_BUFFER:   return &ctx->bound_element_buffer;
+        case GL_PIXEL_PACK_BUFFER_NV:   return &ctx->bound_pixel_pack_buffer;
+        default:                        return NULL;
+    }
+}
+
+/* ============================================================================
+ * Element Buffer Index Metadata
+ *
+ * An element buffer remembers the [min, max] index of its contents for the
+ * type it is drawn with, so glDrawElements can size client vertex arrays
+ * without scanning indices on every draw. GL_UNSIGNED_BYTE buffers also keep
+ * a copy widened to 16 bits in an internal buffer (Maxwell has no 8-bit
+ * index format), and draws read that copy instead.
+ *
+ * The index type is only known once a draw names it, so the first draw builds
+ * the metadata by reading the buffer back. After that, glBufferData and
+ * glBufferSubData rebuild it from the data being uploaded. Mapping for write
+ * marks it stale until the next draw.
+ * ============================================================================ */
+
+#define SGL_INDEX_SCAN_CHUNK 256
+
+static uint32_t sgl_index_size(GLenum type) {
+    return type == GL_UNSIGNED_INT ? 4 : type == GL_UNSIGNED_SHORT ? 2 : 1;
+}
+
+/* Min/max of count indices (count > 0), through a small stack buffer */
+static void sgl_index_scan(GLenum type, const void *src, uint32_t count,
+                           uint32_t *out_min, uint32_t *out_max) {
+    uint32_t tmp[SGL_INDEX_SCAN_CHUNK];
+    uint32_t lo = 0xFFFFFFFFu, hi = 0;
+
+    for (uint32_t i = 0; i < count; i += SGL_INDEX_SCAN_CHUNK) {
+        uint32_t n = count - i < SGL_INDEX_SCAN_CHUNK ? count - i : SGL_INDEX_SCAN_CHUNK;
+        uint32_t a, b;
+        if (type == GL_UNSIGNED_BYTE) {
+            sgl_index_widen_u8((uint16_t *)tmp, (const uint8_t *)src + i, n, &a, &b);
+        } else if (type == GL_UNSIGNED_SHORT) {
+            sgl_index_copy_u16((uint16_t *)tmp, (const uint16_t *)src + i, n, &a, &b);
+        } else {
+            sgl_index_copy_u32(tmp, (const uint32_t *)src + i, n, &a, &b);
+        }
+        if (a < lo) lo = a;
+        if (b > hi) hi = b;
+    }
+    *out_min = lo;
+    *out_max = hi;
+}
+
+static void sgl_buffer_drop_index_shadow(sgl_context_t *ctx, sgl_buffer_t *buf) {
+    if (buf->index_shadow == 0) return;
+    if (ctx->backend && ctx->backend->ops->delete_buffer) {
+        ctx->backend->ops->delete_buffer(ctx->backend, buf->index_shadow);
+    }
+    sgl_res_mgr_free_buffer(ctx->res_mgr, buf->index_shadow);
+    buf->index_shadow = 0;
+}
+
+/* Widen count u8 indices into the shadow at element 'first'. New storage
+ * (respecified or orphaned) replaces the shadow's range, as it does the
+ * buffer's own. */
+static bool sgl_buffer_store_index_shadow(sgl_context_t *ctx, sgl_buffer_t *buf, uint32_t first,
+                                          const uint8_t *src, uint32_t count, bool new_storage,
+                                          uint32_t *out_min, uint32_t *out_max) {
+    if (!ctx->backend->ops->buffer_data || !ctx->backend->ops->buffer_sub_data) return false;
+
+    uint16_t *wide = (uint16_t *)malloc((size_t)count * sizeof(uint16_t));
+    if (!wide) return false;
+    sgl_index_widen_u8(wide, src, count, out_min, out_max);
+
+    if (buf->index_shadow == 0) {
+        buf->index_shadow = sgl_res_mgr_alloc_buffer(ctx->res_mgr);
+        new_storage = true;
+    }
+    sgl_buffer_t *shadow = GET_BUFFER(buf->index_shadow);
+    bool ok = shadow != NULL;
+    if (ok && new_storage) {
+        /* Sized for the whole buffer; a partial upload fills the rest later */
+        shadow->target = GL_ELEMENT_ARRAY_BUFFER;
+        shadow->size = buf->size * (GLsizeiptr)sizeof(uint16_t);
+        shadow->usage = buf->usage;
+        shadow->data_offset = ctx->backend->ops->buffer_data(ctx->backend, buf->index_shadow,
+                                                             GL_ELEMENT_ARRAY_BUFFER,
+                                                             shadow->size, NULL, buf->usage);
+        ok = shadow->data_offset != 0;
+    }
+    if (ok) {
+        ctx->backend->ops->buffer_sub_data(ctx->backend, buf->index_shadow,
+                                           shadow->data_offset + first * (uint32_t)sizeof(uint16_t),
+                                           (GLsizeiptr)count * (GLsizeiptr)sizeof(uint16_t), wide);
+    }
+    free(wide);
+    if (!ok) sgl_buffer_drop_index_shadow(ctx, buf);
+    return ok;
+}
+
+/* Bring the index metadata up to date with size bytes of data written at
+ * offset (data NULL: contents unknown). Leaves it stale when it cannot. */
+static void sgl_buffer_update_indices(sgl_context_t *ctx, sgl_buffer_t *buf, GLintptr offset,
+                                      GLsizeiptr size, const void *data, bool new_storage) {
+    GLenum type = buf->index_type;
+    if (type == 0) return;
+    buf->index_type = 0;
+
+    uint32_t isize = sgl_index_size(type);
+    bool whole = offset == 0 && size == buf->size;
+    if (!data || ctx->recorder || (offset % isize) != 0 || (!whole && (size % isize) != 0)) return;
+
+    uint32_t count = (uint32_t)(size / isize);
+    uint32_t lo = 0, hi = 0;
+    if (count > 0) {
+        if (type == GL_UNSIGNED_BYTE) {
+            if (!sgl_buffer_store_index_shadow(ctx, buf, (uint32_t)offset, (const uint8_t *)data,
+                                               count, new_storage, &lo, &hi)) {
+                return;
+            }
+        } else {
+            sgl_index_scan(type, data, count, &lo, &hi);
+        }
+    }
+
+    /* Indices overwritten by a partial update may have been the extremes, so
+     * the range only grows until the next whole-buffer upload */
+    if (!whole) {
+        if (buf->index_min < lo) lo = buf->index_min;
+        if (buf->index_max > hi) hi = buf->index_max;
+    }
+    buf->index_type = type;
+    buf->index_min = lo;
+    buf->index_max = hi;
+}
+
+uint32_t sgl_element_buffer_locate(sgl_context_t *ctx, GLuint name, GLenum type, uintptr_t offset,
+                                   GLsizei count, bool exact, GLenum *draw_type,
+                                   GLuint *out_min, GLuint *out_max) {
+    sgl_buffer_t *buf = GET_BUFFER(name);
+    if (!buf) return 0;
+
+    if (buf->index_type != type) {
+        /* First draw with this type (or contents changed behind our back):
+         * build from the buffer memory */
+        if (ctx->recorder || buf->map_pointer || buf->size == 0 || !ctx->backend->ops->map_buffer) {
+            return 0;
+        }
+        const void *data = ctx->backend->ops->map_buffer(ctx->backend, name);
+        if (!data) return 0;
+        buf->index_type = type;
+        sgl_buffer_update_indices(ctx, buf, 0, buf->size, data, true);
+        if (buf->index_type != type) return 0;
+    }
+
+    uint32_t isize = sgl_index_size(type);
+    uint64_t end = (uint64_t)offset + (uint64_t)count * isize;
+    *out_min = buf->index_min;
+    *out_max = buf->index_max;
+    if (exact && end <= (uint64_t)buf->size && (offset != 0 || end != (uint64_t)buf->size)) {
+        /* Part of the buffer feeding client arrays: its own range keeps the
+         * vertex copy within what the draw reads */
+        const uint8_t *base = (const uint8_t *)ctx->backend->ops->map_buffer(ctx->backend, name);
+        if (base && count > 0) {
+            sgl_index_scan(type, base + offset, (uint32_t)count, out_min, out_max);
+        }
+    }
+
+    if (type == GL_UNSIGNED_BYTE) {
+        sgl_buffer_t *shadow = GET_BUFFER(buf->index_shadow);
+        if (!shadow) return 0;
+        *draw_type = GL_UNSIGNED_SHORT;
+        return shadow->data_offset + (uint32_t)offset * (uint32_t)sizeof(uint16_t);
+    }
+    *draw_type = type;
+    return buf->data_offset + (uint32_t)offset;
+}
+
 GL_APICALL void GL_APIENTRY glGenBuffers(GLsizei n, GLuint *buffers) {
     GET_CTX();
 
@@ -15,18 +195,20 @@ GL_APICALL void GL_APIENTRY glGenBuffers(GLsizei n, GLuint *buffers) {
     }
 
     for (GLsizei i = 0; i < n; i++) {
-        buffers[i] = sgl_res_mgr_alloc_buffer(&ctx->res_mgr);
+        buffers[i] = sgl_res_mgr_alloc_buffer(ctx->res_mgr);
         if (buffers[i] == 0) {
             sgl_set_error(ctx, GL_OUT_OF_MEMORY);
             return;
         }
     }
 
+    SGL_CAPTURE_DATA(SGL_TRACE_GEN_BUFFERS, buffers, (uint32_t)n * 4, (uint32_t)n);
     SGL_TRACE_BUFFER("glGenBuffers(%d)", n);
 }
 
 GL_APICALL void GL_APIENTRY glDeleteBuffers(GLsizei n, const GLuint *buffers) {
     GET_CTX();
+    sgl_flush_deferred(ctx);
 
     if (n < 0) { sgl_set_error(ctx, GL_INVALID_VALUE); return; }
     if (!buffers) return;
@@ -37,10 +219,19 @@ GL_APICALL void GL_APIENTRY glDeleteBuffers(GLsizei n, const GLuint *buffers) {
 
         if (ctx->bound_array_buffer == id) ctx->bound_array_buffer = 0;
         if (ctx->bound_element_buffer == id) ctx->bound_element_buffer = 0;
+        if (ctx->bound_pixel_pack_buffer == id) ctx->bound_pixel_pack_buffer = 0;
+
+        /* Let the backend recycle the buffer's GPU range */
+        sgl_buffer_t *buf = GET_BUFFER(id);
+        if (buf) sgl_buffer_drop_index_shadow(ctx, buf);
+        if (buf && ctx->backend && ctx->backend->ops->delete_buffer) {
+            ctx->backend->ops->delete_buffer(ctx->backend, id);
+        }
 
-        sgl_res_mgr_free_buffer(&ctx->res_mgr, id);
+        sgl_res_mgr_free_buffer(ctx->res_mgr, id);
     }
 
+    SGL_CAPTURE_DATA(SGL_TRACE_DELETE_BUFFERS, buffers, (uint32_t)n * 4, (uint32_t)n);
     SGL_TRACE_BUFFER("glDeleteBuffers(%d)", n);
 }
 
@@ -57,35 +248,30 @@ GL_APICALL void GL_APIENTRY glBindBuffer(GLenum target, GLuint buffer) {
         return;
     }
 
-    switch (target) {
-        case GL_ARRAY_BUFFER:
-            ctx->bound_array_buffer = buffer;
-            if (buffer) {
-                sgl_buffer_t *buf = GET_BUFFER(buffer);
-                if (buf) buf->target = target;
-            }
-            break;
-        case GL_ELEMENT_ARRAY_BUFFER:
-            ctx->bound_element_buffer = buffer;
-            if (buffer) {
-                sgl_buffer_t *buf = GET_BUFFER(buffer);
-                if (buf) buf->target = target;
-            }
-            break;
-        default:
-            sgl_set_error(ctx, GL_INVALID_ENUM);
-            return;
+    GLuint *binding = sgl_buffer_binding(ctx, target);
+    if (!binding) {
+        sgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+
+    *binding = buffer;
+    if (buffer) {
+        sgl_buffer_t *buf = GET_BUFFER(buffer);
+        if (buf) buf->target = target;
     }
 
+    SGL_CAPTURE(SGL_TRACE_BIND_BUFFER, target, buffer);
     SGL_TRACE_BUFFER("glBindBuffer(0x%X, %u)", target, buffer);
 }
 
 GL_APICALL void GL_APIENTRY glBufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage) {
     GET_CTX();
     CHECK_BACKEND();
+    sgl_flush_deferred(ctx);
 
     /* Validate target */
-    if (target != GL_ARRAY_BUFFER && target != GL_ELEMENT_ARRAY_BUFFER) {
+    GLuint *binding = sgl_buffer_binding(ctx, target);
+    if (!binding) {
         sgl_set_error(ctx, GL_INVALID_ENUM);
         return;
     }
@@ -102,13 +288,18 @@ GL_APICALL void GL_APIENTRY glBufferData(GLenum target, GLsizeiptr size, const v
         return;
     }
 
-    GLuint buffer_id = (target == GL_ARRAY_BUFFER) ? ctx->bound_array_buffer : ctx->bound_element_buffer;
+    GLuint buffer_id = *binding;
     sgl_buffer_t *buf = GET_BUFFER(buffer_id);
     if (!buf) {
         sgl_set_error(ctx, GL_INVALID_OPERATION);
         return;
     }
 
+    SGL_CAPTURE_DATA(SGL_TRACE_BUFFER_DATA, data, (uint32_t)size, target, (uint32_t)size, usage);
+
+    /* Respecifying storage implicitly unmaps */
+    buf->map_pointer = NULL;
+
     /* Update GL-level buffer state */
     buf->size = size;
     buf->usage = usage;
@@ -116,11 +307,13 @@ GL_APICALL void GL_APIENTRY glBufferData(GLenum target, GLsizeiptr size, const v
     /* Delegate to backend for actual GPU memory allocation and upload */
     if (ctx->backend->ops->buffer_data) {
         buf->data_offset = ctx->backend->ops->buffer_data(ctx->backend, buffer_id, target, size, data, usage);
+        buf->revision = sgl_res_mgr_next_revision(ctx->res_mgr);
         if (buf->data_offset == 0 && size > 0) {
             sgl_set_error(ctx, GL_OUT_OF_MEMORY);
             return;
         }
     }
+    sgl_buffer_update_indices(ctx, buf, 0, size, data, true);
 
     SGL_TRACE_BUFFER("glBufferData(0x%X, %zu, usage=0x%X, offset=%u)", target, (size_t)size, usage, buf->data_offset);
 }
@@ -128,18 +321,20 @@ GL_APICALL void GL_APIENTRY glBufferData(GLenum target, GLsizeiptr size, const v
 GL_APICALL void GL_APIENTRY glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data) {
     GET_CTX();
     CHECK_BACKEND();
+    sgl_flush_deferred(ctx);
 
     if (!data) return;
 
     /* Validate target */
-    if (target != GL_ARRAY_BUFFER && target != GL_ELEMENT_ARRAY_BUFFER) {
+    GLuint *binding = sgl_buffer_binding(ctx, target);
+    if (!binding) {
         sgl_set_error(ctx, GL_INVALID_ENUM);
         return;
     }
 
-    GLuint buffer_id = (target == GL_ARRAY_BUFFER) ? ctx->bound_array_buffer : ctx->bound_element_buffer;
+    GLuint buffer_id = *binding;
     sgl_buffer_t *buf = GET_BUFFER(buffer_id);
-    if (!buf) {
+    if (!buf || buf->map_pointer) {
         sgl_set_error(ctx, GL_INVALID_OPERATION);
         return;
     }
@@ -149,13 +344,226 @@ GL_APICALL void GL_APIENTRY glBufferSubData(GLenum target, GLintptr offset, GLsi
         return;
     }
 
-    /* Delegate to backend for actual data write */
+    SGL_CAPTURE_DATA(SGL_TRACE_BUFFER_SUB_DATA, data, (uint32_t)size, target, (uint32_t)offset,
+                     (uint32_t)size);
+
+    /* A full-size update of a dynamic/stream buffer orphans it: the backend
+     * hands out a fresh range so in-flight frames keep reading the old data */
+    if (offset == 0 && size == buf->size && size > 0 &&
+        (buf->usage == GL_DYNAMIC_DRAW || buf->usage == GL_STREAM_DRAW) &&
+        ctx->backend->ops->buffer_data) {
+        buf->data_offset = ctx->backend->ops->buffer_data(ctx->backend, buffer_id, target,
+                                                          size, data, buf->usage);
+        buf->revision = sgl_res_mgr_next_revision(ctx->res_mgr);
+        if (buf->data_offset == 0) {
+            sgl_set_error(ctx, GL_OUT_OF_MEMORY);
+            return;
+        }
+        sgl_buffer_update_indices(ctx, buf, 0, size, data, true);
+        SGL_TRACE_BUFFER("glBufferSubData(0x%X, full size %zu) orphaned, offset=%u",
+                         target, (size_t)size, buf->data_offset);
+        return;
+    }
+
+    /* A partial update writes in place: draws already recorded from this
+     * range see the new bytes, as with an unsynchronized map */
     if (ctx->backend->ops->buffer_sub_data) {
         ctx->backend->ops->buffer_sub_data(ctx->backend, buffer_id,
                                            buf->data_offset + (uint32_t)offset, size, data);
     }
+    sgl_buffer_update_indices(ctx, buf, offset, size, data, false);
 
     SGL_TRACE_BUFFER("glBufferSubData(0x%X, %td, %zu)", target, offset, (size_t)size);
 }
 
+/* ============================================================================
+ * Buffer Mapping (GL_OES_mapbuffer, GL_EXT_map_buffer_range)
+ *
+ * Buffers live in CPU-visible GPU memory, so mapping returns a pointer into
+ * the buffer's current range. Mapping a pixel pack buffer waits for the
+ * glReadPixels copies recorded into it (normally already complete when the
+ * buffer is mapped a frame or two later).
+ *
+ * Like glBufferSubData, a mapped write lands in place without waiting for
+ * draws still reading the buffer, so GL_MAP_UNSYNCHRONIZED_BIT is how every
+ * map behaves; GL_MAP_INVALIDATE_BUFFER_BIT (or invalidating the whole
+ * range) orphans the buffer first so frames in flight keep the old data.
+ * The memory is CPU-uncached, so explicit flushes have nothing to do.
+ * ============================================================================ */
+
+#define SGL_MAP_ACCESS_BITS (GL_MAP_READ_BIT_EXT | GL_MAP_WRITE_BIT_EXT | \
+                             GL_MAP_INVALIDATE_RANGE_BIT_EXT | GL_MAP_INVALIDATE_BUFFER_BIT_EXT | \
+                             GL_MAP_FLUSH_EXPLICIT_BIT_EXT | GL_MAP_UNSYNCHRONIZED_BIT_EXT)
+
+GL_APICALL void *GL_APIENTRY glMapBufferRangeEXT(GLenum target, GLintptr offset, GLsizeiptr length,
+                                                 GLbitfield access) {
+    GET_CTX_RET(NULL);
+    sgl_flush_deferred(ctx);
+
+    GLuint *binding = sgl_buffer_binding(ctx, target);
+    if (!binding) {
+        sgl_set_error(ctx, GL_INVALID_ENUM);
+        return NULL;
+    }
+
+    sgl_buffer_t *buf = GET_BUFFER(*binding);
+    if (!buf) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return NULL;
+    }
+
+    if (offset < 0 || length <= 0 || offset + length > buf->size || (access & ~SGL_MAP_ACCESS_BITS)) {
+        sgl_set_error(ctx, GL_INVALID_VALUE);
+        return NULL;
+    }
+
+    bool read = (access & GL_MAP_READ_BIT_EXT) != 0;
+    bool write = (access & GL_MAP_WRITE_BIT_EXT) != 0;
+    if ((!read && !write) ||
+        (read && (access & (GL_MAP_INVALIDATE_RANGE_BIT_EXT | GL_MAP_INVALIDATE_BUFFER_BIT_EXT |
+                            GL_MAP_UNSYNCHRONIZED_BIT_EXT))) ||
+        (!write && (access & GL_MAP_FLUSH_EXPLICIT_BIT_EXT)) ||
+        buf->map_pointer || !ctx->backend || !ctx->backend->ops->map_buffer) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return NULL;
+    }
+
+    /* Discarding every byte: take a fresh range instead of writing over data
+     * the GPU may still read (stream usage always renames in the backend) */
+    bool whole = offset == 0 && length == buf->size;
+    if ((access & GL_MAP_INVALIDATE_BUFFER_BIT_EXT) ||
+        (whole && (access & GL_MAP_INVALIDATE_RANGE_BIT_EXT))) {
+        if (ctx->backend->ops->buffer_data) {
+            buf->data_offset = ctx->backend->ops->buffer_data(ctx->backend, *binding, target,
+                                                              buf->size, NULL, GL_STREAM_DRAW);
+            buf->revision = sgl_res_mgr_next_revision(ctx->res_mgr);
+            if (buf->data_offset == 0) {
+                sgl_set_error(ctx, GL_OUT_OF_MEMORY);
+                return NULL;
+            }
+        }
+    }
+
+    uint8_t *base = (uint8_t *)ctx->backend->ops->map_buffer(ctx->backend, *binding);
+    if (!base) {
+        sgl_set_error(ctx, GL_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    buf->map_pointer = base + offset;
+    if (write) buf->index_type = 0;  /* Rebuilt by the next draw */
+    buf->map_offset = offset;
+    buf->map_length = length;
+    buf->map_access = access;
+
+    SGL_TRACE_BUFFER("glMapBufferRangeEXT(0x%X, %td, %td, 0x%X) buffer=%u",
+                     target, offset, length, access, *binding);
+    return buf->map_pointer;
+}
+
+GL_APICALL void GL_APIENTRY glFlushMappedBufferRangeEXT(GLenum target, GLintptr offset, GLsizeiptr length) {
+    GET_CTX();
+
+    GLuint *binding = sgl_buffer_binding(ctx, target);
+    if (!binding) {
+        sgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+
+    sgl_buffer_t *buf = GET_BUFFER(*binding);
+    if (!buf || !buf->map_pointer || !(buf->map_access & GL_MAP_FLUSH_EXPLICIT_BIT_EXT)) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+
+    /* Offsets are relative to the mapped range */
+    if (offset < 0 || length < 0 || offset + length > buf->map_length) {
+        sgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+
+    /* CPU writes go straight to uncached memory - nothing to flush */
+    SGL_TRACE_BUFFER("glFlushMappedBufferRangeEXT(0x%X, %td, %td)", target, offset, length);
+}
+
+GL_APICALL void *GL_APIENTRY glMapBufferOES(GLenum target, GLenum access) {
+    GET_CTX_RET(NULL);
+    sgl_flush_deferred(ctx);
+
+    GLuint *binding = sgl_buffer_binding(ctx, target);
+    if (!binding || access != GL_WRITE_ONLY_OES) {
+        sgl_set_error(ctx, GL_INVALID_ENUM);
+        return NULL;
+    }
+
+    sgl_buffer_t *buf = GET_BUFFER(*binding);
+    if (!buf || buf->map_pointer || buf->size == 0 || !ctx->backend ||
+        !ctx->backend->ops->map_buffer) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return NULL;
+    }
+
+    buf->map_pointer = ctx->backend->ops->map_buffer(ctx->backend, *binding);
+    if (!buf->map_pointer) {
+        sgl_set_error(ctx, GL_OUT_OF_MEMORY);
+        return NULL;
+    }
+    buf->index_type = 0;  /* Rebuilt by the next draw */
+    buf->map_offset = 0;
+    buf->map_length = buf->size;
+    buf->map_access = GL_MAP_WRITE_BIT_EXT;
+
+    SGL_TRACE_BUFFER("glMapBufferOES(0x%X) buffer=%u", target, *binding);
+    return buf->map_pointer;
+}
+
+GL_APICALL GLboolean GL_APIENTRY glUnmapBufferOES(GLenum target) {
+    GET_CTX_RET(GL_FALSE);
+    sgl_flush_deferred(ctx);
+
+    GLuint *binding = sgl_buffer_binding(ctx, target);
+    if (!binding) {
+        sgl_set_error(ctx, GL_INVALID_ENUM);
+        return GL_FALSE;
+    }
+
+    sgl_buffer_t *buf = GET_BUFFER(*binding);
+    if (!buf || !buf->map_pointer) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return GL_FALSE;
+    }
+
+    /* The trace sees what was written through the mapping as a glBufferSubData */
+    if (buf->map_access & GL_MAP_WRITE_BIT_EXT) {
+        SGL_CAPTURE_DATA(SGL_TRACE_BUFFER_SUB_DATA, buf->map_pointer, (uint32_t)buf->map_length,
+                         target, (uint32_t)buf->map_offset, (uint32_t)buf->map_length);
+    }
+
+    /* CPU writes go straight to uncached memory - nothing to flush */
+    buf->map_pointer = NULL;
+
+    SGL_TRACE_BUFFER("glUnmapBufferOES(0x%X) buffer=%u", target, *binding);
+    return GL_TRUE;
+}
+
+GL_APICALL void GL_APIENTRY glGetBufferPointervOES(GLenum target, GLenum pname, void **params) {
+    GET_CTX();
+
+    if (!params) return;
+
+    GLuint *binding = sgl_buffer_binding(ctx, target);
+    if (!binding || pname != GL_BUFFER_MAP_POINTER_OES) {
+        sgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+
+    sgl_buffer_t *buf = GET_BUFFER(*binding);
+    if (!buf) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+
+    *params = buf->map_pointer;
+}
+
 /* Note: glGetBufferParameteriv is in gl_query.c */
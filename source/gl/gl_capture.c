@@ -0,0 +1,142 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * GL Layer - Call Stream Capture
+ *
+ * sglBeginCapture(path) makes the current context write every captured
+ * entry point (the calls listed in sgl_trace.h) into a binary trace,
+ * together with the client data the call read, until sglEndCapture. Each
+ * eglSwapBuffers ends a frame. The trace is played back by sglReplay*
+ * (gl_replay.c), on the device or on the host's null backend.
+ *
+ * Client vertex arrays are only read at draw time, so their contents are
+ * recorded just before each draw for the vertex range it reads; mapped
+ * buffer writes are recorded as a glBufferSubData when the buffer is
+ * unmapped.
+ */
+
+#include "gl_common.h"
+#include "../util/sgl_pixel.h"
+#include <GLES2/gl2sgl.h>
+
+GL_APICALL GLboolean GL_APIENTRY sglBeginCapture(const GLchar *path) {
+    GET_CTX_RET(GL_FALSE);
+
+    if (ctx->capture || ctx->recorder) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return GL_FALSE;
+    }
+
+    ctx->capture = sgl_trace_create(path);
+    if (!ctx->capture) {
+        SGL_ERROR_CORE("sglBeginCapture: cannot create %s", path ? path : "(null)");
+        return GL_FALSE;
+    }
+
+    SGL_INFO(SGL_LOG_CAT_CORE, "[CORE] Capturing GL calls to %s", path);
+    return GL_TRUE;
+}
+
+GL_APICALL void GL_APIENTRY sglEndCapture(void) {
+    GET_CTX();
+
+    if (!ctx->capture) return;
+
+    SGL_INFO(SGL_LOG_CAT_CORE, "[CORE] Capture ended after %llu bytes",
+             (unsigned long long)sgl_trace_bytes(ctx->capture));
+    sgl_trace_close(ctx->capture);
+    ctx->capture = NULL;
+}
+
+void sgl_capture_call(sgl_context_t *ctx, uint32_t op, const uint32_t *args, uint32_t argc,
+                      const void *blob, uint32_t blob_size) {
+    if (!sgl_trace_write(ctx->capture, op, args, argc, blob, blob_size)) {
+        /* Out of space or storage removed: stop instead of failing every call */
+        SGL_ERROR_CORE("Capture write failed, capture stopped");
+        sgl_trace_close(ctx->capture);
+        ctx->capture = NULL;
+    }
+}
+
+uint32_t sgl_capture_pixels_size(sgl_context_t *ctx, GLsizei width, GLsizei height,
+                                 GLenum format, GLenum type) {
+    if (width <= 0 || height <= 0) return 0;
+    uint32_t stride = sgl_pixel_unpack_stride((uint32_t)width, format, type, ctx->unpack_alignment);
+    /* The last row is not padded to the alignment */
+    return stride * (uint32_t)(height - 1) + (uint32_t)width * sgl_pixel_src_bpp(format, type);
+}
+
+/* Record the contents of the enabled client arrays for vertices [0, vertices)
+ * and the given number of instances */
+static void sgl_capture_client_arrays(sgl_context_t *ctx, uint32_t vertices, GLsizei instances) {
+    for (int i = 0; i < SGL_MAX_ATTRIBS; i++) {
+        const sgl_vertex_attrib_t *attr = &ctx->vertex_attribs[i];
+        if (!attr->enabled || attr->buffer != 0 || !attr->pointer) continue;
+
+        uint32_t elements = attr->divisor > 0
+            ? ((uint32_t)instances + attr->divisor - 1) / attr->divisor
+            : vertices;
+        if (elements == 0) continue;
+
+        uint32_t elem = sgl_attrib_bytes(attr);
+        uint32_t stride = attr->stride ? (uint32_t)attr->stride : elem;
+        uint32_t size = (elements - 1) * stride + elem;
+        SGL_CAPTURE_DATA(SGL_TRACE_CLIENT_ARRAY, attr->pointer, size,
+                         (uint32_t)i, (uint32_t)attr->size, attr->type, attr->normalized,
+                         (uint32_t)attr->stride);
+    }
+}
+
+void sgl_capture_draw_arrays(sgl_context_t *ctx, GLenum mode, GLint first, GLsizei count,
+                             GLsizei instances) {
+    sgl_capture_client_arrays(ctx, (uint32_t)first + (uint32_t)count, instances);
+    SGL_CAPTURE(SGL_TRACE_DRAW_ARRAYS, mode, (uint32_t)first, (uint32_t)count, (uint32_t)instances);
+}
+
+static uint32_t sgl_index_size(GLenum type) {
+    return type == GL_UNSIGNED_INT ? 4 : type == GL_UNSIGNED_SHORT ? 2 : 1;
+}
+
+/* Highest index of count client-side indices */
+static GLuint sgl_max_client_index(const void *indices, GLenum type, GLsizei count) {
+    GLuint max = 0;
+    for (GLsizei i = 0; i < count; i++) {
+        GLuint index = type == GL_UNSIGNED_INT   ? ((const GLuint *)indices)[i]
+                     : type == GL_UNSIGNED_SHORT ? ((const GLushort *)indices)[i]
+                                                 : ((const GLubyte *)indices)[i];
+        if (index > max) max = index;
+    }
+    return max;
+}
+
+void sgl_capture_draw_elements(sgl_context_t *ctx, GLenum mode, GLsizei count, GLenum type,
+                               const void *indices, GLsizei instances) {
+    bool client_indices = ctx->bound_element_buffer == 0;
+
+    /* Client arrays are recorded up to the highest index drawn */
+    bool client_arrays = false;
+    for (int i = 0; i < SGL_MAX_ATTRIBS && !client_arrays; i++) {
+        const sgl_vertex_attrib_t *attr = &ctx->vertex_attribs[i];
+        client_arrays = attr->enabled && attr->buffer == 0 && attr->pointer;
+    }
+    if (client_arrays) {
+        GLuint max_index = (GLuint)count - 1;
+        if (client_indices) {
+            if (indices) max_index = sgl_max_client_index(indices, type, count);
+        } else {
+            GLenum draw_type;
+            GLuint min_index;
+            sgl_element_buffer_locate(ctx, ctx->bound_element_buffer, type, (uintptr_t)indices,
+                                      count, true, &draw_type, &min_index, &max_index);
+        }
+        sgl_capture_client_arrays(ctx, max_index + 1, instances);
+    }
+
+    if (client_indices) {
+        SGL_CAPTURE_DATA(SGL_TRACE_DRAW_ELEMENTS, indices,
+                         indices ? (uint32_t)count * sgl_index_size(type) : 0,
+                         mode, (uint32_t)count, type, 0, (uint32_t)instances);
+    } else {
+        SGL_CAPTURE(SGL_TRACE_DRAW_ELEMENTS, mode, (uint32_t)count, type,
+                    (uint32_t)(uintptr_t)indices, (uint32_t)instances);
+    }
+}
@@ -5,66 +5,81 @@
 
 #include "gl_common.h"
 #include <stdio.h>
+#include <string.h>
 
 /* Note: glGetError is in gl_query.c */
 
 GL_APICALL void GL_APIENTRY glClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
     GET_CTX();
     sgl_state_color_set_clear(&ctx->color_state, red, green, blue, alpha);
+    SGL_CAPTURE(SGL_TRACE_CLEAR_COLOR, sgl_capture_float(red), sgl_capture_float(green),
+                sgl_capture_float(blue), sgl_capture_float(alpha));
     SGL_TRACE_STATE("glClearColor(%.2f, %.2f, %.2f, %.2f)", red, green, blue, alpha);
 }
 
 GL_APICALL void GL_APIENTRY glClearDepthf(GLfloat depth) {
     GET_CTX();
     sgl_state_depth_set_clear(&ctx->depth_state, depth);
+    SGL_CAPTURE(SGL_TRACE_CLEAR_DEPTHF, sgl_capture_float(depth));
     SGL_TRACE_STATE("glClearDepthf(%.2f)", depth);
 }
 
 GL_APICALL void GL_APIENTRY glClearStencil(GLint s) {
     GET_CTX();
     sgl_state_stencil_set_clear(&ctx->depth_state, s);
+    SGL_CAPTURE(SGL_TRACE_CLEAR_STENCIL, (uint32_t)s);
     SGL_TRACE_STATE("glClearStencil(%d)", s);
 }
 
+/*
+ * glClear is deferred to the first draw, or to whatever else must see the
+ * cleared buffers (sgl_flush_deferred). Clears with no draw between them are
+ * merged: each buffer keeps the value it was last cleared to, and the backend
+ * clears color, depth and stencil in one operation.
+ */
+void sgl_clear_resolve(sgl_context_t *ctx) {
+    GLbitfield mask = ctx->pending_clear;
+    ctx->pending_clear = 0;
+
+    if (ctx->backend->ops->clear) {
+        ctx->backend->ops->clear(ctx->backend, mask, ctx->pending_clear_color,
+                                 ctx->pending_clear_depth, ctx->pending_clear_stencil);
+    }
+
+    /* The backend clear overrides scissor and (for depth/stencil) binds its own
+     * depth-stencil state - have the next draw re-emit both */
+    sgl_context_mark_dirty(ctx, SGL_DIRTY_SCISSOR);
+    if (mask & (GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT)) {
+        sgl_context_mark_dirty(ctx, SGL_DIRTY_DEPTH_STENCIL);
+    }
+    SGL_TRACE_DRAW("clear resolved mask=0x%X", mask);
+}
+
+void sgl_context_flush_deferred(sgl_context_t *ctx) {
+    if (ctx) sgl_flush_deferred(ctx);
+}
+
 GL_APICALL void GL_APIENTRY glClear(GLbitfield mask) {
     sgl_ensure_frame_ready();
     GET_CTX();
     CHECK_BACKEND();
+    sgl_draw_sort_flush(ctx);
 
-    /* Delegate to backend for actual clear operations */
-    if (ctx->backend->ops->clear) {
-        ctx->backend->ops->clear(ctx->backend, mask,
-                                  ctx->color_state.clear_color,
-                                  ctx->depth_state.clear_depth,
-                                  ctx->depth_state.clear_stencil);
-    }
+    SGL_CAPTURE(SGL_TRACE_CLEAR, mask);
+
+    /* Upload-only contexts have nothing to clear */
+    if (ctx->upload_only) return;
 
-    /* Re-apply combined depth-stencil state after clear if stencil was cleared
-     * This uses the combined function to avoid overwriting depth state */
-    if ((mask & GL_STENCIL_BUFFER_BIT) && ctx->backend->ops->apply_depth_stencil) {
-        sgl_depth_stencil_state_t dss;
-        dss.depth_test_enabled = ctx->depth_state.depth_test_enabled;
-        dss.depth_write_enabled = ctx->depth_state.depth_write_enabled;
-        dss.depth_func = ctx->depth_state.depth_func;
-        dss.depth_clear_value = ctx->depth_state.clear_depth;
-        dss.stencil_test_enabled = ctx->depth_state.stencil_test_enabled;
-        dss.stencil_front.func = ctx->depth_state.front.func;
-        dss.stencil_front.ref = ctx->depth_state.front.ref;
-        dss.stencil_front.func_mask = ctx->depth_state.front.func_mask;
-        dss.stencil_front.write_mask = ctx->depth_state.front.write_mask;
-        dss.stencil_front.fail_op = ctx->depth_state.front.fail_op;
-        dss.stencil_front.zfail_op = ctx->depth_state.front.zfail_op;
-        dss.stencil_front.zpass_op = ctx->depth_state.front.zpass_op;
-        dss.stencil_back.func = ctx->depth_state.back.func;
-        dss.stencil_back.ref = ctx->depth_state.back.ref;
-        dss.stencil_back.func_mask = ctx->depth_state.back.func_mask;
-        dss.stencil_back.write_mask = ctx->depth_state.back.write_mask;
-        dss.stencil_back.fail_op = ctx->depth_state.back.fail_op;
-        dss.stencil_back.zfail_op = ctx->depth_state.back.zfail_op;
-        dss.stencil_back.zpass_op = ctx->depth_state.back.zpass_op;
-        dss.stencil_clear_value = ctx->depth_state.clear_stencil;
-        ctx->backend->ops->apply_depth_stencil(ctx->backend, &dss);
+    mask &= GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT;
+    if (mask & GL_COLOR_BUFFER_BIT) {
+        memcpy(ctx->pending_clear_color, ctx->color_state.clear_color, sizeof(ctx->pending_clear_color));
     }
+    if (mask & GL_DEPTH_BUFFER_BIT) ctx->pending_clear_depth = ctx->depth_state.clear_depth;
+    if (mask & GL_STENCIL_BUFFER_BIT) ctx->pending_clear_stencil = ctx->depth_state.clear_stencil;
+    ctx->pending_clear |= mask;
+
+    /* A recorder's stream is replayed elsewhere: its clears stay in place */
+    if (ctx->recorder && ctx->pending_clear) sgl_clear_resolve(ctx);
 }
 
 GL_APICALL void GL_APIENTRY glViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
@@ -77,17 +92,11 @@ GL_APICALL void GL_APIENTRY glViewport(GLint x, GLint y, GLsizei width, GLsizei
     }
 
     if (sgl_state_viewport_set(&ctx->viewport_state, x, y, width, height)) {
-        /* Apply via backend */
-        if (ctx->backend->ops->apply_viewport) {
-            sgl_viewport_state_t vs = {
-                x, y, width, height,
-                ctx->viewport_state.depth_near,
-                ctx->viewport_state.depth_far
-            };
-            ctx->backend->ops->apply_viewport(ctx->backend, &vs);
-        }
+        /* Scissor follows the viewport rect while the scissor test is off */
+        sgl_context_mark_dirty(ctx, SGL_DIRTY_VIEWPORT | SGL_DIRTY_SCISSOR);
     }
 
+    SGL_CAPTURE(SGL_TRACE_VIEWPORT, (uint32_t)x, (uint32_t)y, (uint32_t)width, (uint32_t)height);
     SGL_TRACE_STATE("glViewport(%d, %d, %d, %d)", x, y, width, height);
 }
 
@@ -101,13 +110,10 @@ GL_APICALL void GL_APIENTRY glScissor(GLint x, GLint y, GLsizei width, GLsizei h
     }
 
     if (sgl_state_scissor_set(&ctx->viewport_state, x, y, width, height)) {
-        /* Apply via backend */
-        if (ctx->backend->ops->apply_scissor) {
-            sgl_scissor_state_t ss = { x, y, width, height, true };
-            ctx->backend->ops->apply_scissor(ctx->backend, &ss);
-        }
+        sgl_context_mark_dirty(ctx, SGL_DIRTY_SCISSOR);
     }
 
+    SGL_CAPTURE(SGL_TRACE_SCISSOR, (uint32_t)x, (uint32_t)y, (uint32_t)width, (uint32_t)height);
     SGL_TRACE_STATE("glScissor(%d, %d, %d, %d)", x, y, width, height);
 }
 
@@ -116,18 +122,9 @@ GL_APICALL void GL_APIENTRY glDepthRangef(GLfloat nearVal, GLfloat farVal) {
     CHECK_BACKEND();
 
     if (sgl_state_viewport_set_depth_range(&ctx->viewport_state, nearVal, farVal)) {
-        /* Apply via backend */
-        if (ctx->backend->ops->apply_viewport) {
-            sgl_viewport_state_t vs = {
-                ctx->viewport_state.viewport_x,
-                ctx->viewport_state.viewport_y,
-                ctx->viewport_state.viewport_width,
-                ctx->viewport_state.viewport_height,
-                nearVal, farVal
-            };
-            ctx->backend->ops->apply_viewport(ctx->backend, &vs);
-        }
+        sgl_context_mark_dirty(ctx, SGL_DIRTY_VIEWPORT);
     }
 
+    SGL_CAPTURE(SGL_TRACE_DEPTH_RANGEF, sgl_capture_float(nearVal), sgl_capture_float(farVal));
     SGL_TRACE_STATE("glDepthRangef(%.2f, %.2f)", nearVal, farVal);
 }
@@ -0,0 +1,229 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * GL Layer - Client Array Promotion
+ *
+ * Client-side vertex arrays are copied into per-frame GPU memory on every
+ * draw. Ports of older engines often draw static geometry that way, so the
+ * same data is copied again each frame. Two opt-in ways avoid the copies:
+ *
+ * - sglMarkClientArrayStatic(pointer, size) declares a region unchanging.
+ *   It is uploaded into a buffer the first time a draw reads it and bound
+ *   from there until it is marked again (re-upload) or unmarked.
+ * - sglSetClientArrayPromotion(frames) tracks client arrays by (pointer,
+ *   stride). Once per frame an array's sampled fingerprint is checked; an
+ *   array seen unchanged for that many frames is uploaded, and demoted
+ *   again when its fingerprint changes or a draw reads past its copy.
+ *
+ * The fingerprint samples at most SGL_FINGERPRINT_SAMPLES words, so writes
+ * between samples or within a frame go unnoticed. This is why promotion is
+ * off by default.
+ */
+
+#include "gl_common.h"
+#include <GLES2/gl2sgl.h>
+#include <string.h>
+
+#define SGL_FINGERPRINT_SAMPLES 64
+
+uint32_t sgl_attrib_bytes(const sgl_vertex_attrib_t *attr) {
+    switch (attr->type) {
+        case GL_BYTE:
+        case GL_UNSIGNED_BYTE:
+            return (uint32_t)attr->size;
+        case GL_SHORT:
+        case GL_UNSIGNED_SHORT:
+        case GL_HALF_FLOAT_OES:
+            return (uint32_t)attr->size * 2;
+        case GL_INT_2_10_10_10_REV:
+        case GL_UNSIGNED_INT_2_10_10_10_REV:
+            return 4;
+        default:
+            return (uint32_t)attr->size * 4;
+    }
+}
+
+/* FNV-1a over evenly spaced 8-byte words of [pointer, pointer + size) */
+static uint32_t sgl_fingerprint(const void *pointer, uint32_t size) {
+    const uint8_t *data = (const uint8_t *)pointer;
+    uint32_t hash = 2166136261u ^ size;
+    uint32_t words = size / 8;
+    uint32_t step = words > SGL_FINGERPRINT_SAMPLES ? words / SGL_FINGERPRINT_SAMPLES : 1;
+
+    for (uint32_t w = 0; w < words; w += step) {
+        uint64_t v;
+        memcpy(&v, data + (size_t)w * 8, sizeof(v));
+        hash = (hash ^ (uint32_t)v) * 16777619u;
+        hash = (hash ^ (uint32_t)(v >> 32)) * 16777619u;
+    }
+    for (uint32_t i = words * 8; i < size; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static void sgl_client_array_drop_buffer(sgl_context_t *ctx, sgl_client_array_t *e) {
+    if (e->buffer == 0) return;
+    if (ctx->backend && ctx->backend->ops->delete_buffer) {
+        ctx->backend->ops->delete_buffer(ctx->backend, e->buffer);
+    }
+    sgl_res_mgr_free_buffer(ctx->res_mgr, e->buffer);
+    e->buffer = 0;
+}
+
+static void sgl_client_array_release(sgl_context_t *ctx, sgl_client_array_t *e) {
+    sgl_client_array_drop_buffer(ctx, e);
+    memset(e, 0, sizeof(*e));
+    ctx->client_array_count--;
+}
+
+/* Copy the entry's bytes into a buffer of its own */
+static bool sgl_client_array_upload(sgl_context_t *ctx, sgl_client_array_t *e) {
+    if (!ctx->backend->ops->buffer_data) return false;
+
+    GLuint name = sgl_res_mgr_alloc_buffer(ctx->res_mgr);
+    sgl_buffer_t *buf = GET_BUFFER(name);
+    if (!buf) return false;
+
+    buf->target = GL_ARRAY_BUFFER;
+    buf->size = e->size;
+    buf->usage = GL_STATIC_DRAW;
+    buf->data_offset = ctx->backend->ops->buffer_data(ctx->backend, name, GL_ARRAY_BUFFER,
+                                                      e->size, e->pointer, GL_STATIC_DRAW);
+    if (buf->data_offset == 0) {
+        sgl_res_mgr_free_buffer(ctx->res_mgr, name);
+        return false;
+    }
+
+    e->buffer = name;
+    SGL_TRACE_VERTEX("client array %p (%u bytes) promoted to buffer %u", e->pointer, e->size, name);
+    return true;
+}
+
+static sgl_client_array_t *sgl_client_array_alloc(sgl_context_t *ctx) {
+    sgl_client_array_t *oldest = NULL;
+    for (int i = 0; i < SGL_MAX_CLIENT_ARRAYS; i++) {
+        sgl_client_array_t *e = &ctx->client_arrays[i];
+        if (!e->pointer) {
+            ctx->client_array_count++;
+            return e;
+        }
+        if (!e->marked && (!oldest || e->frame < oldest->frame)) oldest = e;
+    }
+    if (!oldest) return NULL;  /* All entries are marked regions */
+
+    sgl_client_array_drop_buffer(ctx, oldest);
+    memset(oldest, 0, sizeof(*oldest));
+    return oldest;
+}
+
+void sgl_client_array_promote(sgl_context_t *ctx, sgl_vertex_attrib_t *attr, GLsizei elements) {
+    if (ctx->client_array_count == 0 && ctx->client_array_promote_frames == 0) return;
+    if (ctx->recorder || elements <= 0) return;  /* Recorders cannot create buffers */
+
+    const uint8_t *ptr = (const uint8_t *)attr->pointer;
+    uint32_t elem = sgl_attrib_bytes(attr);
+    uint32_t stride = attr->stride ? (uint32_t)attr->stride : elem;
+    /* Interleaved attributes lie within one stride of the array start, so
+     * elements * stride bytes from there cover all of them */
+    uint32_t extent = (uint32_t)elements * stride;
+
+    sgl_client_array_t *found = NULL;
+    uint64_t end = 0;  /* Last byte read + 1, relative to the entry */
+    for (int i = 0; i < SGL_MAX_CLIENT_ARRAYS && !found; i++) {
+        sgl_client_array_t *e = &ctx->client_arrays[i];
+        if (!e->pointer || ptr < (const uint8_t *)e->pointer) continue;
+        uint64_t offset = (uint64_t)(ptr - (const uint8_t *)e->pointer);
+        end = offset + (uint64_t)(elements - 1) * stride + elem;
+        if (e->marked ? end <= e->size : (e->stride == (GLsizei)stride && offset < stride)) {
+            found = e;
+        }
+    }
+
+    if (found && found->marked) {
+        if (!found->buffer && !sgl_client_array_upload(ctx, found)) return;
+    } else {
+        if (ctx->client_array_promote_frames == 0) return;
+
+        if (!found) {
+            found = sgl_client_array_alloc(ctx);
+            if (!found) return;
+            found->pointer = ptr;
+            found->stride = (GLsizei)stride;
+            found->size = extent;
+            found->fingerprint = sgl_fingerprint(ptr, extent);
+            found->frame = ctx->frame_count;
+            return;
+        }
+
+        if (end > found->size) {
+            /* Drawn further than the tracked extent: start counting again */
+            sgl_client_array_drop_buffer(ctx, found);
+            found->size = (uint32_t)end;
+            found->fingerprint = sgl_fingerprint(found->pointer, found->size);
+            found->frames_unchanged = 0;
+            found->frame = ctx->frame_count;
+            return;
+        }
+
+        if (found->frame != ctx->frame_count) {
+            found->frame = ctx->frame_count;
+            uint32_t fingerprint = sgl_fingerprint(found->pointer, found->size);
+            if (fingerprint != found->fingerprint) {
+                sgl_client_array_drop_buffer(ctx, found);
+                found->fingerprint = fingerprint;
+                found->frames_unchanged = 0;
+            } else {
+                found->frames_unchanged++;
+            }
+        }
+
+        if (!found->buffer) {
+            if (found->frames_unchanged < ctx->client_array_promote_frames) return;
+            if (!sgl_client_array_upload(ctx, found)) return;
+        }
+    }
+
+    attr->buffer = found->buffer;
+    attr->pointer = (const void *)(uintptr_t)(ptr - (const uint8_t *)found->pointer);
+}
+
+GL_APICALL void GL_APIENTRY sglMarkClientArrayStatic(const void *pointer, GLsizeiptr size) {
+    GET_CTX();
+
+    if (!pointer || size < 0) {
+        sgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+
+    /* Marking again re-uploads, marking with size 0 forgets the region */
+    for (int i = 0; i < SGL_MAX_CLIENT_ARRAYS; i++) {
+        sgl_client_array_t *e = &ctx->client_arrays[i];
+        if (e->pointer == pointer) sgl_client_array_release(ctx, e);
+    }
+    if (size == 0) return;
+
+    sgl_client_array_t *e = sgl_client_array_alloc(ctx);
+    if (!e) {
+        sgl_set_error(ctx, GL_OUT_OF_MEMORY);
+        return;
+    }
+    e->pointer = pointer;
+    e->size = (uint32_t)size;
+    e->marked = true;
+
+    SGL_TRACE_VERTEX("sglMarkClientArrayStatic(%p, %zu)", pointer, (size_t)size);
+}
+
+GL_APICALL void GL_APIENTRY sglSetClientArrayPromotion(GLuint frames) {
+    GET_CTX();
+
+    ctx->client_array_promote_frames = frames;
+
+    /* Turning the heuristic off streams its arrays again */
+    if (frames == 0) {
+        for (int i = 0; i < SGL_MAX_CLIENT_ARRAYS; i++) {
+            sgl_client_array_t *e = &ctx->client_arrays[i];
+            if (e->pointer && !e->marked) sgl_client_array_release(ctx, e);
+        }
+    }
+}
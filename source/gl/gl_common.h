@@ -14,6 +14,8 @@
 #include "../context/sgl_context.h"
 #include "../backend/sgl_backend.h"
 #include "../util/sgl_log.h"
+#include "../util/sgl_trace.h"
+#include <string.h>
 
 /* Get current context with error check */
 #define GET_CTX() \
@@ -32,19 +34,136 @@
     if (!ctx->backend || !ctx->backend->ops) { return (ret); }
 
 /* Resource access macros */
-#define GET_BUFFER(id) sgl_res_mgr_get_buffer(&ctx->res_mgr, id)
-#define GET_TEXTURE(id) sgl_res_mgr_get_texture(&ctx->res_mgr, id)
-#define GET_SHADER(id) sgl_res_mgr_get_shader(&ctx->res_mgr, id)
-#define GET_PROGRAM(id) sgl_res_mgr_get_program(&ctx->res_mgr, id)
-#define GET_FRAMEBUFFER(id) sgl_res_mgr_get_framebuffer(&ctx->res_mgr, id)
-#define GET_RENDERBUFFER(id) sgl_res_mgr_get_renderbuffer(&ctx->res_mgr, id)
+#define GET_BUFFER(id) sgl_res_mgr_get_buffer(ctx->res_mgr, id)
+#define GET_TEXTURE(id) sgl_res_mgr_get_texture(ctx->res_mgr, id)
+#define GET_SHADER(id) sgl_res_mgr_get_shader(ctx->res_mgr, id)
+#define GET_PROGRAM(id) (ctx->recorder ? sgl_recorder_program(ctx, id) \
+                                       : sgl_res_mgr_get_program(ctx->res_mgr, id))
+#define GET_FRAMEBUFFER(id) sgl_res_mgr_get_framebuffer(ctx->res_mgr, id)
+#define GET_RENDERBUFFER(id) sgl_res_mgr_get_renderbuffer(ctx->res_mgr, id)
+#define GET_VERTEX_ARRAY(id) sgl_res_mgr_get_vertex_array(ctx->res_mgr, id)
+#define GET_QUERY(id) sgl_res_mgr_get_query(ctx->res_mgr, id)
 
 /* Trace macros are already defined in sgl_log.h */
 
 /* Ensure frame is ready for rendering */
 extern void sgl_ensure_frame_ready(void);
 
+/* Emit dirty GL state groups to the backend (gl_state.c) */
+void sgl_apply_dirty_state(sgl_context_t *ctx);
+
+/* Binding point for a buffer target, NULL if the target is invalid (gl_buffer.c) */
+GLuint *sgl_buffer_binding(sgl_context_t *ctx, GLenum target);
+
+/* Locate count indices of the given type at byte offset 'offset' of element
+ * buffer 'name'. Returns their data offset and the type to draw them as
+ * (GL_UNSIGNED_BYTE indices come from a 16-bit copy), and the [min, max]
+ * index they reference: the cached range of the whole buffer, or with exact
+ * set, that of the indices drawn. Returns 0 when the buffer's index data
+ * cannot be read, e.g. while mapped (gl_buffer.c) */
+uint32_t sgl_element_buffer_locate(sgl_context_t *ctx, GLuint name, GLenum type, uintptr_t offset,
+                                   GLsizei count, bool exact, GLenum *draw_type,
+                                   GLuint *out_min, GLuint *out_max);
+
+/* Point an enabled client array attribute at its promoted buffer, if it has
+ * one, for a draw reading elements [0, elements) (gl_client_array.c) */
+void sgl_client_array_promote(sgl_context_t *ctx, sgl_vertex_attrib_t *attr, GLsizei elements);
+
+/* Bytes one element of an attribute occupies (gl_client_array.c) */
+uint32_t sgl_attrib_bytes(const sgl_vertex_attrib_t *attr);
+
+/* Mark the bound VAO's attribute layout as changed (gl_vertex.c) */
+void sgl_vertex_layout_changed(sgl_context_t *ctx);
+
+/* GL_DEPTH_COMPONENT or GL_DEPTH_STENCIL_OES texture format (gl_texture.c) */
+bool sgl_is_depth_format(GLenum format);
+
+/* Forward a texture's changed sampler params to the backend (gl_draw.c) */
+void sgl_flush_texture_params(sgl_context_t *ctx, GLuint tex_id, sgl_texture_t *tex);
+
+/* Can the backend cache the bound VAO's layout (gl_draw.c) */
+bool sgl_vertex_layout_cacheable(const sgl_context_t *ctx);
+
+/* Buffer a draw while sglSetDrawSortMode is on. False if it must be drawn
+ * now, after the buffered draws were emitted (gl_draw_sort.c) */
+bool sgl_draw_sort_arrays(sgl_context_t *ctx, GLenum mode, GLint first, GLsizei count,
+                          GLsizei instances);
+bool sgl_draw_sort_elements(sgl_context_t *ctx, GLenum mode, GLsizei count, GLenum type,
+                            const void *indices, GLsizei instances);
+
+/* Emit the buffered draws, sorted (gl_draw_sort.c) */
+void sgl_draw_sort_emit(sgl_context_t *ctx);
+
+static inline void sgl_draw_sort_flush(sgl_context_t *ctx) {
+    if (ctx->draw_sort) sgl_draw_sort_emit(ctx);
+}
+
+/* Record the glClear deferred in ctx->pending_clear (gl_clear.c) */
+void sgl_clear_resolve(sgl_context_t *ctx);
+
+/* Call before anything the deferred clear and buffered draws must precede,
+ * or that changes the buffers, textures, programs or framebuffers they use.
+ * A pending clear comes first: glClear emits the buffered draws. */
+static inline void sgl_flush_deferred(sgl_context_t *ctx) {
+    if (ctx->pending_clear) sgl_clear_resolve(ctx);
+    if (ctx->draw_sort) sgl_draw_sort_emit(ctx);
+}
+
+/* A recorder's private copy of a program, NULL if invalid (gl_recorder.c) */
+sgl_program_t *sgl_recorder_program(sgl_context_t *ctx, GLuint id);
+
+/* Remember the objects the next draw uses while recording a command list (gl_recorder.c) */
+void sgl_recorder_note_draw(sgl_context_t *ctx);
+
 /* Bind program and uniforms before drawing (calls backend) */
 bool sgl_bind_program_for_draw(sgl_context_t *ctx, GLuint program_id);
 
+/* Complete a background glLinkProgram, waiting for it if needed (gl_shader.c) */
+void sgl_program_finish_link(sgl_context_t *ctx, GLuint program, sgl_program_t *prog);
+
+/* Forget tracked uniforms and cached locations before a (re)link (gl_uniform.c) */
+void sgl_program_reset_uniforms(sgl_program_t *prog);
+
+/* Current GL_MAX_SHADER_COMPILER_THREADS_KHR value (gl_shader.c) */
+GLint sgl_max_shader_compiler_threads(void);
+
+/* ============================================================================
+ * Call Stream Capture (gl_capture.c)
+ *
+ * While sglBeginCapture is active on a context, its entry points append a
+ * record once the call took effect. Arguments are 32-bit words: pass floats
+ * through sgl_capture_float and buffer offsets as (uint32_t)(uintptr_t).
+ * ============================================================================ */
+
+void sgl_capture_call(sgl_context_t *ctx, uint32_t op, const uint32_t *args, uint32_t argc,
+                      const void *blob, uint32_t blob_size);
+
+static inline uint32_t sgl_capture_float(GLfloat value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+#define SGL_CAPTURE(op, ...) \
+    SGL_CAPTURE_DATA(op, NULL, 0, __VA_ARGS__)
+
+#define SGL_CAPTURE_DATA(op, blob, blob_size, ...) \
+    do { \
+        if (ctx->capture) { \
+            const uint32_t capture_args_[] = { __VA_ARGS__ }; \
+            sgl_capture_call(ctx, op, capture_args_, sizeof(capture_args_) / sizeof(uint32_t), \
+                             blob, blob_size); \
+        } \
+    } while (0)
+
+/* Bytes of client pixel data glTexImage2D/glTexSubImage2D read */
+uint32_t sgl_capture_pixels_size(sgl_context_t *ctx, GLsizei width, GLsizei height,
+                                 GLenum format, GLenum type);
+
+/* Record a draw with the client arrays and indices it reads */
+void sgl_capture_draw_arrays(sgl_context_t *ctx, GLenum mode, GLint first, GLsizei count,
+                             GLsizei instances);
+void sgl_capture_draw_elements(sgl_context_t *ctx, GLenum mode, GLsizei count, GLenum type,
+                               const void *indices, GLsizei instances);
+
 #endif /* GL_COMMON_H */
@@ -10,116 +10,34 @@
 #include <string.h>
 #include <stdio.h>
 
+/* Forward sampler params only when they changed (or the texture was
+ * re-specified), the backend caches the sampler descriptor per texture */
+void sgl_flush_texture_params(sgl_context_t *ctx, GLuint tex_id, sgl_texture_t *tex) {
+    if (!tex->params_dirty || !ctx->backend->ops->texture_parameter) return;
+
+    GLenum target = tex->target ? tex->target : GL_TEXTURE_2D;
+    ctx->backend->ops->texture_parameter(ctx->backend, tex_id, target, GL_TEXTURE_MIN_FILTER, tex->min_filter);
+    ctx->backend->ops->texture_parameter(ctx->backend, tex_id, target, GL_TEXTURE_MAG_FILTER, tex->mag_filter);
+    ctx->backend->ops->texture_parameter(ctx->backend, tex_id, target, GL_TEXTURE_WRAP_S, tex->wrap_s);
+    ctx->backend->ops->texture_parameter(ctx->backend, tex_id, target, GL_TEXTURE_WRAP_T, tex->wrap_t);
+    tex->params_dirty = false;
+}
+
 /* Prepare state before draw - delegates to backend */
 static void sgl_prepare_draw(sgl_context_t *ctx) {
     if (!ctx->backend || !ctx->backend->ops) return;
 
-    /* Apply viewport - MUST be set before drawing */
-    if (ctx->backend->ops->apply_viewport) {
-        sgl_viewport_state_t vs = {
-            ctx->viewport_state.viewport_x,
-            ctx->viewport_state.viewport_y,
-            ctx->viewport_state.viewport_width,
-            ctx->viewport_state.viewport_height,
-            ctx->viewport_state.depth_near,
-            ctx->viewport_state.depth_far
-        };
-        ctx->backend->ops->apply_viewport(ctx->backend, &vs);
-    }
-
-    /* Apply combined depth-stencil state (avoids overwrite issues) */
-    if (ctx->backend->ops->apply_depth_stencil) {
-        sgl_depth_stencil_state_t dss;
-        /* Depth state */
-        dss.depth_test_enabled = ctx->depth_state.depth_test_enabled;
-        dss.depth_write_enabled = ctx->depth_state.depth_write_enabled;
-        dss.depth_func = ctx->depth_state.depth_func;
-        dss.depth_clear_value = ctx->depth_state.clear_depth;
-        /* Stencil state */
-        dss.stencil_test_enabled = ctx->depth_state.stencil_test_enabled;
-        dss.stencil_front.func = ctx->depth_state.front.func;
-        dss.stencil_front.ref = ctx->depth_state.front.ref;
-        dss.stencil_front.func_mask = ctx->depth_state.front.func_mask;
-        dss.stencil_front.write_mask = ctx->depth_state.front.write_mask;
-        dss.stencil_front.fail_op = ctx->depth_state.front.fail_op;
-        dss.stencil_front.zfail_op = ctx->depth_state.front.zfail_op;
-        dss.stencil_front.zpass_op = ctx->depth_state.front.zpass_op;
-        dss.stencil_back.func = ctx->depth_state.back.func;
-        dss.stencil_back.ref = ctx->depth_state.back.ref;
-        dss.stencil_back.func_mask = ctx->depth_state.back.func_mask;
-        dss.stencil_back.write_mask = ctx->depth_state.back.write_mask;
-        dss.stencil_back.fail_op = ctx->depth_state.back.fail_op;
-        dss.stencil_back.zfail_op = ctx->depth_state.back.zfail_op;
-        dss.stencil_back.zpass_op = ctx->depth_state.back.zpass_op;
-        dss.stencil_clear_value = ctx->depth_state.clear_stencil;
-        ctx->backend->ops->apply_depth_stencil(ctx->backend, &dss);
-    } else {
-        /* Fallback to separate calls if combined not available */
-        if (ctx->backend->ops->apply_depth) {
-            sgl_depth_state_t ds = {
-                ctx->depth_state.depth_test_enabled,
-                ctx->depth_state.depth_write_enabled,
-                ctx->depth_state.depth_func,
-                ctx->depth_state.clear_depth
-            };
-            ctx->backend->ops->apply_depth(ctx->backend, &ds);
-        }
-    }
+    /* A frame may start with a draw rather than a clear */
+    sgl_ensure_frame_ready();
 
-    /* Apply blend state */
-    if (ctx->backend->ops->apply_blend) {
-        sgl_blend_state_t bs;
-        bs.enabled = ctx->blend_state.enabled;
-        bs.src_rgb = ctx->blend_state.src_rgb;
-        bs.dst_rgb = ctx->blend_state.dst_rgb;
-        bs.src_alpha = ctx->blend_state.src_alpha;
-        bs.dst_alpha = ctx->blend_state.dst_alpha;
-        bs.equation_rgb = ctx->blend_state.equation_rgb;
-        bs.equation_alpha = ctx->blend_state.equation_alpha;
-        ctx->backend->ops->apply_blend(ctx->backend, &bs);
-    }
-
-    /* Apply raster state (culling) */
-    if (ctx->backend->ops->apply_raster) {
-        sgl_raster_state_t rs;
-        rs.cull_enabled = ctx->raster_state.cull_enabled;
-        rs.cull_mode = ctx->raster_state.cull_mode;
-        rs.front_face = ctx->raster_state.front_face;
-        ctx->backend->ops->apply_raster(ctx->backend, &rs);
-    }
-
-    /* Apply color mask */
-    if (ctx->backend->ops->apply_color_mask) {
-        sgl_color_state_t cs;
-        cs.mask[0] = ctx->color_state.mask[0];
-        cs.mask[1] = ctx->color_state.mask[1];
-        cs.mask[2] = ctx->color_state.mask[2];
-        cs.mask[3] = ctx->color_state.mask[3];
-        cs.clear_color[0] = ctx->color_state.clear_color[0];
-        cs.clear_color[1] = ctx->color_state.clear_color[1];
-        cs.clear_color[2] = ctx->color_state.clear_color[2];
-        cs.clear_color[3] = ctx->color_state.clear_color[3];
-        ctx->backend->ops->apply_color_mask(ctx->backend, &cs);
-    }
-
-    /* Apply scissor state */
-    if (ctx->backend->ops->apply_scissor) {
-        sgl_scissor_state_t ss;
-        if (ctx->viewport_state.scissor_enabled) {
-            ss.x = ctx->viewport_state.scissor_x;
-            ss.y = ctx->viewport_state.scissor_y;
-            ss.width = ctx->viewport_state.scissor_width;
-            ss.height = ctx->viewport_state.scissor_height;
-        } else {
-            /* Scissor disabled - use full viewport */
-            ss.x = ctx->viewport_state.viewport_x;
-            ss.y = ctx->viewport_state.viewport_y;
-            ss.width = ctx->viewport_state.viewport_width;
-            ss.height = ctx->viewport_state.viewport_height;
-        }
-        ss.enabled = ctx->viewport_state.scissor_enabled;
-        ctx->backend->ops->apply_scissor(ctx->backend, &ss);
-    }
+    /* The first draw after glClear records it */
+    if (ctx->pending_clear) sgl_clear_resolve(ctx);
+
+    /* Emit only the state groups that changed since the last draw */
+    sgl_apply_dirty_state(ctx);
+
+    /* Command lists are only replayed while what they drew with is unchanged */
+    if (ctx->recorder) sgl_recorder_note_draw(ctx);
 
     /* Bind program with shaders FIRST (textures must be bound AFTER shaders in deko3d) */
     if (ctx->current_program > 0) {
@@ -133,13 +51,9 @@ static void sgl_prepare_draw(sgl_context_t *ctx) {
             if (tex_id > 0) {
                 sgl_texture_t *tex = GET_TEXTURE(tex_id);
                 if (tex && tex->used) {
-                    /* Pass texture params to backend for sampler creation */
-                    GLenum target = tex->target ? tex->target : GL_TEXTURE_2D;
-                    if (ctx->backend->ops->texture_parameter) {
-                        ctx->backend->ops->texture_parameter(ctx->backend, tex_id, target, GL_TEXTURE_MIN_FILTER, tex->min_filter);
-                        ctx->backend->ops->texture_parameter(ctx->backend, tex_id, target, GL_TEXTURE_MAG_FILTER, tex->mag_filter);
-                        ctx->backend->ops->texture_parameter(ctx->backend, tex_id, target, GL_TEXTURE_WRAP_S, tex->wrap_s);
-                        ctx->backend->ops->texture_parameter(ctx->backend, tex_id, target, GL_TEXTURE_WRAP_T, tex->wrap_t);
+                    /* Recorders rely on sglBeginRecorder having forwarded the params */
+                    if (!ctx->recorder) {
+                        sgl_flush_texture_params(ctx, tex_id, tex);
                     }
                     ctx->backend->ops->bind_texture(ctx->backend, unit, tex_id);
                 }
@@ -148,24 +62,76 @@ static void sgl_prepare_draw(sgl_context_t *ctx) {
     }
 }
 
-GL_APICALL void GL_APIENTRY glDrawArrays(GLenum mode, GLint first, GLsizei count) {
-    GET_CTX();
-    CHECK_BACKEND();
+/* A VAO layout can be cached by the backend when every attribute up to the
+ * last enabled one is enabled and sourced from a VBO (no per-draw copies) */
+bool sgl_vertex_layout_cacheable(const sgl_context_t *ctx) {
+    int last = -1;
+    for (int i = 0; i < SGL_MAX_ATTRIBS; i++) {
+        if (ctx->vertex_attribs[i].enabled) last = i;
+    }
+    if (last < 0) return false;
+    for (int i = 0; i <= last; i++) {
+        if (!ctx->vertex_attribs[i].enabled || ctx->vertex_attribs[i].buffer == 0) {
+            return false;
+        }
+    }
+    return true;
+}
 
-    if (count < 0 || first < 0) {
-        sgl_set_error(ctx, GL_INVALID_VALUE);
+/* Bind vertex attributes for a draw covering vertices [first, first + count)
+ * of each of the given number of instances.
+ * A cacheable bound VAO is handed to the backend as a whole - it keeps the
+ * deko3d vertex state per VAO and emits nothing when the same VAO is drawn
+ * again. Otherwise attributes are rebuilt for this draw. */
+static void sgl_bind_vertex_state(sgl_context_t *ctx, GLint first, GLsizei count, GLsizei instances) {
+    if (ctx->bound_vertex_array != 0 && ctx->backend->ops->bind_vertex_array &&
+        sgl_vertex_layout_cacheable(ctx)) {
+        ctx->backend->ops->bind_vertex_array(ctx->backend, ctx->bound_vertex_array,
+                                             ctx->vertex_attribs, SGL_MAX_ATTRIBS,
+                                             ctx->vertex_layout_dirty);
+        ctx->vertex_layout_dirty = false;
         return;
     }
 
-    if (count == 0) return;
+    if (!ctx->backend->ops->bind_vertex_attribs) return;
 
-    /* No program bound */
-    if (ctx->current_program == 0) {
-        sgl_set_error(ctx, GL_INVALID_OPERATION);
-        return;
+    /* Prepare vertex attributes with buffer offsets */
+    sgl_vertex_attrib_t prepared_attribs[SGL_MAX_ATTRIBS];
+    memcpy(prepared_attribs, ctx->vertex_attribs, sizeof(prepared_attribs));
+
+    for (int i = 0; i < SGL_MAX_ATTRIBS; i++) {
+        sgl_vertex_attrib_t *attr = &prepared_attribs[i];
+        if (attr->enabled && attr->buffer == 0 && attr->pointer) {
+            /* Static client arrays may be served from a buffer instead */
+            GLsizei elements = attr->divisor > 0
+                ? (GLsizei)(((GLuint)instances + attr->divisor - 1) / attr->divisor)
+                : first + count;
+            sgl_client_array_promote(ctx, attr, elements);
+        }
+        if (attr->enabled && attr->buffer > 0) {
+            sgl_buffer_t *buf = GET_BUFFER(attr->buffer);
+            if (buf) {
+                /* Compute GPU offset: buffer's data_offset + pointer offset */
+                attr->buffer_offset = buf->data_offset + (uint32_t)(uintptr_t)attr->pointer;
+            }
+        }
     }
 
-    /* Validate mode */
+    ctx->backend->ops->bind_vertex_attribs(ctx->backend, prepared_attribs,
+                                           SGL_MAX_ATTRIBS, first, count, instances);
+}
+
+/* Any enabled per-vertex attribute sourced from client memory? Only those
+ * copies depend on the vertex range a draw is bound with. */
+static bool sgl_uses_client_arrays(const sgl_context_t *ctx) {
+    for (int i = 0; i < SGL_MAX_ATTRIBS; i++) {
+        const sgl_vertex_attrib_t *attr = &ctx->vertex_attribs[i];
+        if (attr->enabled && attr->buffer == 0 && attr->pointer && attr->divisor == 0) return true;
+    }
+    return false;
+}
+
+static bool sgl_valid_draw_mode(GLenum mode) {
     switch (mode) {
         case GL_POINTS:
         case GL_LINES:
@@ -174,54 +140,64 @@ GL_APICALL void GL_APIENTRY glDrawArrays(GLenum mode, GLint first, GLsizei count
         case GL_TRIANGLES:
         case GL_TRIANGLE_STRIP:
         case GL_TRIANGLE_FAN:
-            break;
+            return true;
         default:
-            sgl_set_error(ctx, GL_INVALID_ENUM);
-            return;
+            return false;
     }
+}
 
-    /* Prepare state */
-    sgl_prepare_draw(ctx);
+static void sgl_draw_arrays(sgl_context_t *ctx, GLenum mode, GLint first, GLsizei count,
+                            GLsizei instances) {
+    if (count < 0 || first < 0 || instances < 0) {
+        sgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
 
-    /* Prepare vertex attributes with buffer offsets */
-    sgl_vertex_attrib_t prepared_attribs[SGL_MAX_ATTRIBS];
-    memcpy(prepared_attribs, ctx->vertex_attribs, sizeof(prepared_attribs));
+    if (count == 0 || instances == 0) return;
 
-    for (int i = 0; i < SGL_MAX_ATTRIBS; i++) {
-        sgl_vertex_attrib_t *attr = &prepared_attribs[i];
-        if (attr->enabled && attr->buffer > 0) {
-            sgl_buffer_t *buf = GET_BUFFER(attr->buffer);
-            if (buf) {
-                /* Compute GPU offset: buffer's data_offset + pointer offset */
-                attr->buffer_offset = buf->data_offset + (uint32_t)(uintptr_t)attr->pointer;
-            }
-        }
+    /* No program bound */
+    if (ctx->current_program == 0) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
     }
 
-    /* Bind vertex attributes via backend */
-    if (ctx->backend->ops->bind_vertex_attribs) {
-        ctx->backend->ops->bind_vertex_attribs(ctx->backend, prepared_attribs,
-                                               SGL_MAX_ATTRIBS, first, count);
+    /* Validate mode */
+    if (!sgl_valid_draw_mode(mode)) {
+        sgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
     }
 
+    if (ctx->capture) sgl_capture_draw_arrays(ctx, mode, first, count, instances);
+
+    /* Occluded by sglBeginConditionalRender, or an upload-only context */
+    if (ctx->conditional_skip || ctx->upload_only) return;
+
+    /* Buffered by sglSetDrawSortMode, drawn later in state order */
+    if (ctx->draw_sort && sgl_draw_sort_arrays(ctx, mode, first, count, instances)) return;
+
+    /* Prepare state */
+    sgl_prepare_draw(ctx);
+
+    /* Bind vertex attributes via backend */
+    sgl_bind_vertex_state(ctx, first, count, instances);
+
     /* Draw via backend */
     if (ctx->backend->ops->draw_arrays) {
-        ctx->backend->ops->draw_arrays(ctx->backend, mode, first, count);
+        ctx->backend->ops->draw_arrays(ctx->backend, mode, first, count, instances);
     }
 
-    SGL_TRACE_DRAW("glDrawArrays(mode=0x%X, first=%d, count=%d)", mode, first, count);
+    SGL_TRACE_DRAW("glDrawArrays(mode=0x%X, first=%d, count=%d, instances=%d)",
+                   mode, first, count, instances);
 }
 
-GL_APICALL void GL_APIENTRY glDrawElements(GLenum mode, GLsizei count, GLenum type, const void *indices) {
-    GET_CTX();
-    CHECK_BACKEND();
-
-    if (count < 0) {
+static void sgl_draw_elements(sgl_context_t *ctx, GLenum mode, GLsizei count, GLenum type,
+                              const void *indices, GLsizei instances) {
+    if (count < 0 || instances < 0) {
         sgl_set_error(ctx, GL_INVALID_VALUE);
         return;
     }
 
-    if (count == 0) return;
+    if (count == 0 || instances == 0) return;
 
     /* No program bound */
     if (ctx->current_program == 0) {
@@ -230,18 +206,9 @@ GL_APICALL void GL_APIENTRY glDrawElements(GLenum mode, GLsizei count, GLenum ty
     }
 
     /* Validate mode */
-    switch (mode) {
-        case GL_POINTS:
-        case GL_LINES:
-        case GL_LINE_LOOP:
-        case GL_LINE_STRIP:
-        case GL_TRIANGLES:
-        case GL_TRIANGLE_STRIP:
-        case GL_TRIANGLE_FAN:
-            break;
-        default:
-            sgl_set_error(ctx, GL_INVALID_ENUM);
-            return;
+    if (!sgl_valid_draw_mode(mode)) {
+        sgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
     }
 
     /* Validate type */
@@ -255,72 +222,316 @@ GL_APICALL void GL_APIENTRY glDrawElements(GLenum mode, GLsizei count, GLenum ty
             return;
     }
 
-    /* Prepare state */
-    sgl_prepare_draw(ctx);
+    if (ctx->capture) sgl_capture_draw_elements(ctx, mode, count, type, indices, instances);
 
-    /* Prepare vertex attributes with buffer offsets */
-    sgl_vertex_attrib_t prepared_attribs[SGL_MAX_ATTRIBS];
-    memcpy(prepared_attribs, ctx->vertex_attribs, sizeof(prepared_attribs));
+    /* Occluded by sglBeginConditionalRender, or an upload-only context */
+    if (ctx->conditional_skip || ctx->upload_only) return;
 
-    for (int i = 0; i < SGL_MAX_ATTRIBS; i++) {
-        sgl_vertex_attrib_t *attr = &prepared_attribs[i];
-        if (attr->enabled && attr->buffer > 0) {
-            sgl_buffer_t *buf = GET_BUFFER(attr->buffer);
-            if (buf) {
-                /* Compute GPU offset: buffer's data_offset + pointer offset */
-                attr->buffer_offset = buf->data_offset + (uint32_t)(uintptr_t)attr->pointer;
-            }
-        }
-    }
+    /* Buffered by sglSetDrawSortMode, drawn later in state order */
+    if (ctx->draw_sort && sgl_draw_sort_elements(ctx, mode, count, type, indices, instances)) return;
 
-    /* Compute actual vertex count needed for client-side array allocation.
+    /* Prepare state */
+    sgl_prepare_draw(ctx);
+
+    /* Compute the vertex range needed for client-side array allocation.
      * For glDrawElements, 'count' is the number of INDICES, not vertices.
-     * When using client-side vertex arrays, we need max_vertex_index + 1
-     * to avoid reading past the end of the vertex arrays. */
-    GLsizei vertex_count = count;  /* Default: use index count (safe for VBOs) */
+     * Client-side indices are staged by the backend in the same pass that finds
+     * their [min, max] range, so only the referenced vertices are copied. */
+    GLint first_vertex = 0;
+    GLsizei vertex_count = count;  /* Fallback: the index count */
+    GLenum draw_type = type;
+    uint32_t ebo_data_offset = 0;
     if (ctx->bound_element_buffer == 0 && indices != NULL) {
-        /* Client-side indices: scan for max vertex index */
-        GLuint max_idx = 0;
-        if (type == GL_UNSIGNED_BYTE) {
-            const GLubyte *idx8 = (const GLubyte *)indices;
-            for (GLsizei i = 0; i < count; i++) {
-                if (idx8[i] > max_idx) max_idx = idx8[i];
-            }
-        } else if (type == GL_UNSIGNED_SHORT) {
-            const GLushort *idx16 = (const GLushort *)indices;
-            for (GLsizei i = 0; i < count; i++) {
-                if (idx16[i] > max_idx) max_idx = idx16[i];
+        if (ctx->backend->ops->upload_indices) {
+            GLuint min_idx, max_idx;
+            ebo_data_offset = ctx->backend->ops->upload_indices(ctx->backend, type, indices, count,
+                                                                &draw_type, &min_idx, &max_idx);
+            if (ebo_data_offset == 0) {
+                return;  /* Out of client array memory (reported by the backend) */
             }
-        } else if (type == GL_UNSIGNED_INT) {
-            const GLuint *idx32 = (const GLuint *)indices;
-            for (GLsizei i = 0; i < count; i++) {
-                if (idx32[i] > max_idx) max_idx = idx32[i];
+            first_vertex = (GLint)min_idx;
+            vertex_count = (GLsizei)(max_idx - min_idx + 1);
+        }
+    } else if (ctx->bound_element_buffer > 0) {
+        /* indices is an offset into the bound EBO, whose cached index range
+         * stands in for the per-draw scan */
+        GLuint min_idx, max_idx;
+        ebo_data_offset = sgl_element_buffer_locate(ctx, ctx->bound_element_buffer, type,
+                                                    (uintptr_t)indices, count,
+                                                    sgl_uses_client_arrays(ctx),
+                                                    &draw_type, &min_idx, &max_idx);
+        if (ebo_data_offset != 0) {
+            first_vertex = (GLint)min_idx;
+            vertex_count = (GLsizei)(max_idx - min_idx + 1);
+        } else {
+            sgl_buffer_t *ebo_buf = GET_BUFFER(ctx->bound_element_buffer);
+            if (ebo_buf) {
+                ebo_data_offset = ebo_buf->data_offset + (uint32_t)(uintptr_t)indices;
             }
         }
-        vertex_count = (GLsizei)(max_idx + 1);
     }
 
     /* Bind vertex attributes via backend */
-    if (ctx->backend->ops->bind_vertex_attribs) {
-        ctx->backend->ops->bind_vertex_attribs(ctx->backend, prepared_attribs,
-                                               SGL_MAX_ATTRIBS, 0, vertex_count);
+    sgl_bind_vertex_state(ctx, first_vertex, vertex_count, instances);
+
+    /* Draw elements via backend - ebo_data_offset locates EBO or staged indices */
+    if (ctx->backend->ops->draw_elements) {
+        ctx->backend->ops->draw_elements(ctx->backend, mode, count, draw_type,
+                                         indices, ebo_data_offset, instances);
     }
 
-    /* Compute index buffer offset if EBO is bound */
-    uint32_t ebo_data_offset = 0;
-    if (ctx->bound_element_buffer > 0) {
-        sgl_buffer_t *ebo_buf = GET_BUFFER(ctx->bound_element_buffer);
-        if (ebo_buf) {
-            /* indices is an offset into the bound EBO */
-            ebo_data_offset = ebo_buf->data_offset + (uint32_t)(uintptr_t)indices;
+    SGL_TRACE_DRAW("glDrawElements(mode=0x%X, count=%d, type=0x%X, instances=%d)",
+                   mode, count, type, instances);
+}
+
+GL_APICALL void GL_APIENTRY glDrawArrays(GLenum mode, GLint first, GLsizei count) {
+    GET_CTX();
+    CHECK_BACKEND();
+    sgl_draw_arrays(ctx, mode, first, count, 1);
+}
+
+GL_APICALL void GL_APIENTRY glDrawElements(GLenum mode, GLsizei count, GLenum type, const void *indices) {
+    GET_CTX();
+    CHECK_BACKEND();
+    sgl_draw_elements(ctx, mode, count, type, indices, 1);
+}
+
+/* ============================================================================
+ * Instanced Draws (GL_ANGLE_instanced_arrays / GL_EXT_draw_instanced)
+ * ============================================================================ */
+
+GL_APICALL void GL_APIENTRY glDrawArraysInstancedANGLE(GLenum mode, GLint first, GLsizei count,
+                                                        GLsizei primcount) {
+    GET_CTX();
+    CHECK_BACKEND();
+    sgl_draw_arrays(ctx, mode, first, count, primcount);
+}
+
+GL_APICALL void GL_APIENTRY glDrawElementsInstancedANGLE(GLenum mode, GLsizei count, GLenum type,
+                                                          const void *indices, GLsizei primcount) {
+    GET_CTX();
+    CHECK_BACKEND();
+    sgl_draw_elements(ctx, mode, count, type, indices, primcount);
+}
+
+GL_APICALL void GL_APIENTRY glDrawArraysInstancedEXT(GLenum mode, GLint start, GLsizei count,
+                                                      GLsizei primcount) {
+    glDrawArraysInstancedANGLE(mode, start, count, primcount);
+}
+
+GL_APICALL void GL_APIENTRY glDrawElementsInstancedEXT(GLenum mode, GLsizei count, GLenum type,
+                                                        const void *indices, GLsizei primcount) {
+    glDrawElementsInstancedANGLE(mode, count, type, indices, primcount);
+}
+
+/* ============================================================================
+ * Multi Draws (GL_EXT_multi_draw_arrays / sglMultiDraw*)
+ *
+ * Program, textures and vertex state are bound once for the whole batch and
+ * the backend records one draw per entry. Client arrays are copied once for
+ * the union of the vertex ranges of a batch.
+ * ============================================================================ */
+
+#define SGL_MULTI_DRAW_BATCH 64  /* Element draws whose index offsets are staged together */
+
+static bool sgl_validate_multi_draw(sgl_context_t *ctx, GLenum mode, GLsizei drawcount) {
+    if (drawcount < 0) {
+        sgl_set_error(ctx, GL_INVALID_VALUE);
+        return false;
+    }
+    if (!sgl_valid_draw_mode(mode)) {
+        sgl_set_error(ctx, GL_INVALID_ENUM);
+        return false;
+    }
+    if (ctx->current_program == 0) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return false;
+    }
+    return true;
+}
+
+/* Per-draw offsets must start a SGL_UNIFORM_ALIGNMENT-aligned window inside
+ * the current program's packed UBO [stage][binding] */
+static bool sgl_validate_uniform_offsets(sgl_context_t *ctx, GLint stage, GLint binding,
+                                         const GLuint *offsets, GLsizei drawcount) {
+    if (stage < 0 || stage > 1 || binding < 0 || binding >= SGL_MAX_PACKED_UBOS || !offsets) {
+        sgl_set_error(ctx, GL_INVALID_VALUE);
+        return false;
+    }
+    sgl_program_t *prog = GET_PROGRAM(ctx->current_program);
+    const sgl_packed_ubo_t *packed = NULL;
+    if (prog) {
+        packed = (stage == 0) ? &prog->packed_vertex[binding] : &prog->packed_fragment[binding];
+    }
+    if (!packed || !packed->valid || packed->size == 0) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return false;
+    }
+    for (GLsizei i = 0; i < drawcount; i++) {
+        if ((offsets[i] & (SGL_UNIFORM_ALIGNMENT - 1)) != 0 || offsets[i] >= packed->size) {
+            sgl_set_error(ctx, GL_INVALID_VALUE);
+            return false;
         }
     }
+    return true;
+}
 
-    /* Draw elements via backend - pass ebo_data_offset, backend will copy client indices if ebo=0 */
-    if (ctx->backend->ops->draw_elements) {
-        ctx->backend->ops->draw_elements(ctx->backend, mode, count, type,
-                                         indices, ebo_data_offset);
+static void sgl_multi_draw_arrays(sgl_context_t *ctx, GLenum mode, const GLint *first,
+                                  const GLsizei *count, GLsizei drawcount,
+                                  GLint ubo_stage, GLint ubo_binding, const GLuint *ubo_offsets) {
+    if (!sgl_validate_multi_draw(ctx, mode, drawcount)) return;
+    if (drawcount == 0 || !first || !count) return;
+
+    /* Union of the vertex ranges, for the client array copy */
+    GLint lo = 0;
+    GLint hi = 0;
+    bool any = false;
+    for (GLsizei i = 0; i < drawcount; i++) {
+        if (first[i] < 0 || count[i] < 0) {
+            sgl_set_error(ctx, GL_INVALID_VALUE);
+            return;
+        }
+        if (count[i] == 0) continue;
+        if (!any || first[i] < lo) lo = first[i];
+        if (!any || first[i] + count[i] > hi) hi = first[i] + count[i];
+        any = true;
+    }
+    if (ubo_offsets && !sgl_validate_uniform_offsets(ctx, ubo_stage, ubo_binding, ubo_offsets, drawcount)) {
+        return;
+    }
+    if (!any || !ctx->backend->ops->multi_draw_arrays || ctx->conditional_skip || ctx->upload_only) return;
+
+    sgl_draw_sort_flush(ctx);
+    sgl_prepare_draw(ctx);
+    sgl_bind_vertex_state(ctx, lo, hi - lo, 1);
+    ctx->backend->ops->multi_draw_arrays(ctx->backend, mode, first, count, drawcount,
+                                         ubo_stage, ubo_binding, ubo_offsets);
+
+    SGL_TRACE_DRAW("glMultiDrawArrays(mode=0x%X, drawcount=%d)", mode, drawcount);
+}
+
+static void sgl_multi_draw_elements(sgl_context_t *ctx, GLenum mode, const GLsizei *count,
+                                    GLenum type, const void *const *indices, GLsizei drawcount,
+                                    GLint ubo_stage, GLint ubo_binding, const GLuint *ubo_offsets) {
+    if (!sgl_validate_multi_draw(ctx, mode, drawcount)) return;
+    switch (type) {
+        case GL_UNSIGNED_BYTE:
+        case GL_UNSIGNED_SHORT:
+        case GL_UNSIGNED_INT:
+            break;
+        default:
+            sgl_set_error(ctx, GL_INVALID_ENUM);
+            return;
+    }
+    if (drawcount == 0 || !count || !indices) return;
+    for (GLsizei i = 0; i < drawcount; i++) {
+        if (count[i] < 0) {
+            sgl_set_error(ctx, GL_INVALID_VALUE);
+            return;
+        }
+    }
+    if (ubo_offsets && !sgl_validate_uniform_offsets(ctx, ubo_stage, ubo_binding, ubo_offsets, drawcount)) {
+        return;
+    }
+    if (!ctx->backend->ops->multi_draw_elements || ctx->conditional_skip || ctx->upload_only) return;
+
+    sgl_buffer_t *ebo_buf = NULL;
+    if (ctx->bound_element_buffer > 0) {
+        ebo_buf = GET_BUFFER(ctx->bound_element_buffer);
+        if (!ebo_buf) return;
+    } else if (!ctx->backend->ops->upload_indices) {
+        return;
+    }
+
+    sgl_draw_sort_flush(ctx);
+    sgl_prepare_draw(ctx);
+    bool exact = ebo_buf && sgl_uses_client_arrays(ctx);
+
+    for (GLsizei base = 0; base < drawcount; base += SGL_MULTI_DRAW_BATCH) {
+        GLsizei n = drawcount - base;
+        if (n > SGL_MULTI_DRAW_BATCH) n = SGL_MULTI_DRAW_BATCH;
+
+        GLsizei counts[SGL_MULTI_DRAW_BATCH];
+        uint32_t offsets[SGL_MULTI_DRAW_BATCH];
+        GLenum draw_type = type;
+        GLuint lo = 0xFFFFFFFFu;
+        GLuint hi = 0;
+        GLsizei max_count = 0;
+
+        /* Locate (or stage) each draw's indices; as in glDrawElements, they
+         * give the vertex range unless the EBO's index data cannot be read */
+        for (GLsizei i = 0; i < n; i++) {
+            counts[i] = count[base + i];
+            offsets[i] = 0;
+            if (counts[i] == 0) continue;
+            const void *ind = indices[base + i];
+            if (ebo_buf) {
+                GLuint min_idx, max_idx;
+                offsets[i] = sgl_element_buffer_locate(ctx, ctx->bound_element_buffer, type,
+                                                       (uintptr_t)ind, counts[i], exact,
+                                                       &draw_type, &min_idx, &max_idx);
+                if (offsets[i] != 0) {
+                    if (min_idx < lo) lo = min_idx;
+                    if (max_idx > hi) hi = max_idx;
+                } else {
+                    offsets[i] = ebo_buf->data_offset + (uint32_t)(uintptr_t)ind;
+                    if (counts[i] > max_count) max_count = counts[i];
+                }
+            } else if (ind) {
+                GLuint min_idx, max_idx;
+                offsets[i] = ctx->backend->ops->upload_indices(ctx->backend, type, ind, counts[i],
+                                                               &draw_type, &min_idx, &max_idx);
+                if (offsets[i] == 0) continue;  /* Out of client array memory (reported by the backend) */
+                if (min_idx < lo) lo = min_idx;
+                if (max_idx > hi) hi = max_idx;
+            }
+        }
+
+        if (max_count > 0) {
+            /* Some EBO ranges unknown: cover [0, max(count, hi + 1)) */
+            if (lo <= hi && (GLsizei)(hi + 1) > max_count) max_count = (GLsizei)(hi + 1);
+            sgl_bind_vertex_state(ctx, 0, max_count, 1);
+        } else {
+            if (lo > hi) continue;
+            sgl_bind_vertex_state(ctx, (GLint)lo, (GLsizei)(hi - lo + 1), 1);
+        }
+
+        ctx->backend->ops->multi_draw_elements(ctx->backend, mode, counts, draw_type, offsets, n,
+                                               ubo_stage, ubo_binding,
+                                               ubo_offsets ? ubo_offsets + base : NULL);
     }
 
-    SGL_TRACE_DRAW("glDrawElements(mode=0x%X, count=%d, type=0x%X)", mode, count, type);
+    SGL_TRACE_DRAW("glMultiDrawElements(mode=0x%X, type=0x%X, drawcount=%d)", mode, type, drawcount);
+}
+
+GL_APICALL void GL_APIENTRY glMultiDrawArraysEXT(GLenum mode, const GLint *first, const GLsizei *count,
+                                                  GLsizei primcount) {
+    GET_CTX();
+    CHECK_BACKEND();
+    sgl_multi_draw_arrays(ctx, mode, first, count, primcount, 0, 0, NULL);
+}
+
+GL_APICALL void GL_APIENTRY glMultiDrawElementsEXT(GLenum mode, const GLsizei *count, GLenum type,
+                                                    const void *const *indices, GLsizei primcount) {
+    GET_CTX();
+    CHECK_BACKEND();
+    sgl_multi_draw_elements(ctx, mode, count, type, indices, primcount, 0, 0, NULL);
+}
+
+GL_APICALL void GL_APIENTRY sglMultiDrawArrays(GLenum mode, const GLint *first, const GLsizei *count,
+                                                GLsizei drawcount, GLint stage, GLint binding,
+                                                const GLuint *uniform_offsets) {
+    GET_CTX();
+    CHECK_BACKEND();
+    sgl_multi_draw_arrays(ctx, mode, first, count, drawcount, stage, binding, uniform_offsets);
+}
+
+GL_APICALL void GL_APIENTRY sglMultiDrawElements(GLenum mode, const GLsizei *count, GLenum type,
+                                                  const void *const *indices, GLsizei drawcount,
+                                                  GLint stage, GLint binding,
+                                                  const GLuint *uniform_offsets) {
+    GET_CTX();
+    CHECK_BACKEND();
+    sgl_multi_draw_elements(ctx, mode, count, type, indices, drawcount, stage, binding,
+                            uniform_offsets);
 }
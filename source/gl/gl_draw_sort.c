@@ -0,0 +1,592 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * GL Layer - Draw Sorting (sglSetDrawSortMode)
+ *
+ * Engines written for GLES2 often draw in scene order, switching program
+ * and textures on almost every draw. With sorting on, opaque draws are
+ * buffered as packets instead of recorded, then emitted ordered by program,
+ * textures and vertex layout (and the sglSetDrawSortDepth hint), so that the
+ * backend's bind caches skip most of the changes.
+ *
+ * - A draw is buffered when the depth test decides its order: blending and
+ *   stencil test off, depth test and depth writes on with a LESS or GREATER
+ *   func, every enabled attribute and the indices in buffers. With
+ *   LEQUAL/GEQUAL the last draw at equal depth wins, and multipass or decal
+ *   rendering depends on it. Any other draw emits the buffer first and is
+ *   drawn in place.
+ * - This is not exact: with LESS/GREATER the first draw at equal depth
+ *   wins, so reordering changes coplanar fragments. That is why sorting is
+ *   opt-in (SGL_DRAW_SORT_NONE by default).
+ * - Buffered draws form a run sharing one fixed-function state: a draw
+ *   after a state change emits the run before it starts the next one. Each
+ *   packet keeps its own program, textures, vertex attributes and uniforms.
+ * - Uniforms are snapshotted per packet: legacy bindings by their arena
+ *   slot, which the next write replaces instead of overwriting, packed UBOs
+ *   by copying their data. Draws of a program whose uniforms did not change
+ *   share the previous snapshot.
+ * - Whatever must follow the buffered draws or changes what they read (clears,
+ *   framebuffer changes, buffer, texture and program updates, reads, syncs,
+ *   queries, eglSwapBuffers) emits them first (sgl_flush_deferred).
+ *
+ * IMPORTANT: This file must NOT include deko3d.h or use any dk*() calls!
+ */
+
+#include "gl_common.h"
+#include <GLES2/gl2sgl.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SGL_DRAW_SORT_MAX_DRAWS  1024  /* Packets per run; a full buffer is emitted */
+
+typedef struct sgl_draw_packet {
+    uint64_t key;
+    GLuint program;
+    GLuint textures[SGL_MAX_TEXTURE_UNITS];
+    GLuint vertex_array;     /* Cacheable VAO, 0 = attributes bound per draw */
+    uint32_t attribs;        /* Attribute snapshot index */
+    uint32_t uniforms;       /* Uniform snapshot byte offset */
+    bool elements;
+    GLenum mode;
+    GLenum type;             /* Type the indices are drawn as */
+    const void *indices;
+    uint32_t ebo_offset;
+    GLint first;             /* First vertex (arrays) or first referenced vertex */
+    GLsizei count;           /* Vertices (arrays) or indices */
+    GLsizei vertex_count;
+    GLsizei instances;
+} sgl_draw_packet_t;
+
+typedef struct sgl_draw_order {
+    uint64_t key;
+    uint32_t packet;
+} sgl_draw_order_t;
+
+/* Uniform snapshot: a header, the valid legacy bindings, then each valid
+ * packed UBO's header and data (padded to 4 bytes) */
+typedef struct sgl_draw_uniforms {
+    uint16_t legacy_count;
+    uint16_t packed_count;
+} sgl_draw_uniforms_t;
+
+typedef struct sgl_draw_legacy_uniform {
+    uint8_t stage;
+    uint8_t index;
+    uint16_t reserved;
+    uint32_t offset;
+    uint32_t size;
+    uint32_t data_size;
+} sgl_draw_legacy_uniform_t;
+
+typedef struct sgl_draw_packed_uniform {
+    uint8_t stage;
+    uint8_t binding;
+    uint16_t reserved;
+    uint32_t size;
+} sgl_draw_packed_uniform_t;
+
+struct sgl_draw_sort {
+    GLenum mode;                     /* SGL_DRAW_SORT_STATE or SGL_DRAW_SORT_DEPTH */
+    uint16_t depth;                  /* sglSetDrawSortDepth as a sortable key */
+
+    sgl_draw_packet_t packets[SGL_DRAW_SORT_MAX_DRAWS];
+    sgl_draw_order_t order[SGL_DRAW_SORT_MAX_DRAWS];
+    uint32_t count;
+
+    sgl_vertex_attrib_t (*attribs)[SGL_MAX_ATTRIBS];
+    uint32_t attrib_count;
+    uint32_t attrib_capacity;
+
+    uint8_t *uniforms;
+    uint32_t uniform_size;
+    uint32_t uniform_capacity;
+    GLuint last_program;             /* Program and offset of the newest uniform snapshot */
+    uint32_t last_uniforms;
+
+    /* Fixed-function state of the run, re-emitted if the backend lost it */
+    uint32_t state_generation;
+    sgl_state_blend_t blend_state;
+    sgl_state_depth_t depth_state;
+    sgl_state_raster_t raster_state;
+    sgl_state_viewport_t viewport_state;
+    sgl_state_color_t color_state;
+
+    /* Bindings handed to the backend while emitting */
+    uint32_t loaded_uniforms;
+    sgl_uniform_binding_t vertex_uniforms[SGL_MAX_UNIFORMS];
+    sgl_uniform_binding_t fragment_uniforms[SGL_MAX_UNIFORMS];
+    sgl_packed_ubo_t packed_vertex[SGL_MAX_PACKED_UBOS];
+    sgl_packed_ubo_t packed_fragment[SGL_MAX_PACKED_UBOS];
+};
+
+void sgl_draw_sort_destroy(sgl_draw_sort_t *sort) {
+    if (!sort) return;
+    free(sort->attribs);
+    free(sort->uniforms);
+    free(sort);
+}
+
+/* ============================================================================
+ * Capture
+ * ============================================================================ */
+
+/* Opaque draws whose order the depth test decides, but for equal depths, from
+ * buffers only */
+static bool sgl_draw_sortable(const sgl_context_t *ctx, bool elements) {
+    const sgl_state_depth_t *ds = &ctx->depth_state;
+    if (ctx->blend_state.enabled || ds->stencil_test_enabled) return false;
+    if (!ds->depth_test_enabled || !ds->depth_write_enabled) return false;
+    if (ds->depth_func != GL_LESS && ds->depth_func != GL_GREATER) return false;
+
+    if (elements && ctx->bound_element_buffer == 0) return false;
+    for (int i = 0; i < SGL_MAX_ATTRIBS; i++) {
+        if (ctx->vertex_attribs[i].enabled && ctx->vertex_attribs[i].buffer == 0) return false;
+    }
+    return true;
+}
+
+static bool sgl_draw_sort_reserve(void **data, uint32_t *capacity, uint32_t needed, size_t item_size) {
+    if (needed <= *capacity) return true;
+    uint32_t capacity_new = *capacity ? *capacity : 16;
+    while (capacity_new < needed) capacity_new *= 2;
+    void *data_new = realloc(*data, (size_t)capacity_new * item_size);
+    if (!data_new) return false;
+    *data = data_new;
+    *capacity = capacity_new;
+    return true;
+}
+
+static bool sgl_program_uniforms_dirty(const sgl_program_t *prog) {
+    for (int i = 0; i < SGL_MAX_PACKED_UBOS; i++) {
+        if (prog->packed_vertex[i].dirty || prog->packed_fragment[i].dirty) return true;
+    }
+    for (int i = 0; i < SGL_MAX_UNIFORMS; i++) {
+        if (prog->vertex_uniforms[i].dirty || prog->fragment_uniforms[i].dirty) return true;
+    }
+    return false;
+}
+
+/* Snapshot the program's uniforms, or share the newest snapshot when this
+ * program made it and nothing was written since. Clears the dirty flags
+ * like a bind would: the next legacy write takes a fresh arena slot. */
+static bool sgl_draw_sort_snapshot_uniforms(sgl_draw_sort_t *sort, GLuint program,
+                                            sgl_program_t *prog, uint32_t *out) {
+    if (sort->uniform_size > 0 && sort->last_program == program && !sgl_program_uniforms_dirty(prog)) {
+        *out = sort->last_uniforms;
+        return true;
+    }
+
+    uint32_t size = sizeof(sgl_draw_uniforms_t);
+    for (int stage = 0; stage < 2; stage++) {
+        const sgl_uniform_binding_t *ub = stage == 0 ? prog->vertex_uniforms : prog->fragment_uniforms;
+        const sgl_packed_ubo_t *packed = stage == 0 ? prog->packed_vertex : prog->packed_fragment;
+        for (int i = 0; i < SGL_MAX_UNIFORMS; i++) {
+            if (ub[i].valid && ub[i].size > 0) size += sizeof(sgl_draw_legacy_uniform_t);
+        }
+        for (int i = 0; i < SGL_MAX_PACKED_UBOS; i++) {
+            if (packed[i].valid && packed[i].size > 0) {
+                size += sizeof(sgl_draw_packed_uniform_t) + SGL_ALIGN_UP(packed[i].size, 4);
+            }
+        }
+    }
+    if (!sgl_draw_sort_reserve((void **)&sort->uniforms, &sort->uniform_capacity,
+                               sort->uniform_size + size, 1)) {
+        return false;
+    }
+
+    uint32_t offset = sort->uniform_size;
+    uint8_t *p = sort->uniforms + offset;
+    sgl_draw_uniforms_t *hdr = (sgl_draw_uniforms_t *)p;
+    hdr->legacy_count = 0;
+    hdr->packed_count = 0;
+    p += sizeof(*hdr);
+
+    for (int stage = 0; stage < 2; stage++) {
+        sgl_uniform_binding_t *ub = stage == 0 ? prog->vertex_uniforms : prog->fragment_uniforms;
+        for (int i = 0; i < SGL_MAX_UNIFORMS; i++) {
+            ub[i].dirty = false;
+            if (!ub[i].valid || ub[i].size == 0) continue;
+            sgl_draw_legacy_uniform_t *lu = (sgl_draw_legacy_uniform_t *)p;
+            lu->stage = (uint8_t)stage;
+            lu->index = (uint8_t)i;
+            lu->reserved = 0;
+            lu->offset = ub[i].offset;
+            lu->size = ub[i].size;
+            lu->data_size = ub[i].data_size;
+            p += sizeof(*lu);
+            hdr->legacy_count++;
+        }
+    }
+    for (int stage = 0; stage < 2; stage++) {
+        sgl_packed_ubo_t *packed = stage == 0 ? prog->packed_vertex : prog->packed_fragment;
+        for (int i = 0; i < SGL_MAX_PACKED_UBOS; i++) {
+            packed[i].dirty = false;
+            if (!packed[i].valid || packed[i].size == 0) continue;
+            sgl_draw_packed_uniform_t *pu = (sgl_draw_packed_uniform_t *)p;
+            pu->stage = (uint8_t)stage;
+            pu->binding = (uint8_t)i;
+            pu->reserved = 0;
+            pu->size = packed[i].size;
+            memcpy(pu + 1, packed[i].data, packed[i].size);
+            p += sizeof(*pu) + SGL_ALIGN_UP(packed[i].size, 4);
+            hdr->packed_count++;
+        }
+    }
+
+    sort->uniform_size += size;
+    sort->last_program = program;
+    sort->last_uniforms = offset;
+    *out = offset;
+    return true;
+}
+
+/* Attributes with their buffer offsets resolved; consecutive draws with the
+ * same attributes share one snapshot */
+static bool sgl_draw_sort_snapshot_attribs(sgl_context_t *ctx, sgl_draw_sort_t *sort, uint32_t *out) {
+    sgl_vertex_attrib_t attribs[SGL_MAX_ATTRIBS];
+    memcpy(attribs, ctx->vertex_attribs, sizeof(attribs));
+    for (int i = 0; i < SGL_MAX_ATTRIBS; i++) {
+        if (!attribs[i].enabled) continue;
+        sgl_buffer_t *buf = GET_BUFFER(attribs[i].buffer);
+        if (buf) attribs[i].buffer_offset = buf->data_offset + (uint32_t)(uintptr_t)attribs[i].pointer;
+    }
+
+    if (sort->attrib_count > 0 &&
+        memcmp(sort->attribs[sort->attrib_count - 1], attribs, sizeof(attribs)) == 0) {
+        *out = sort->attrib_count - 1;
+        return true;
+    }
+    if (!sgl_draw_sort_reserve((void **)&sort->attribs, &sort->attrib_capacity,
+                               sort->attrib_count + 1, sizeof(attribs))) {
+        return false;
+    }
+    memcpy(sort->attribs[sort->attrib_count], attribs, sizeof(attribs));
+    *out = sort->attrib_count++;
+    return true;
+}
+
+static uint16_t sgl_draw_sort_textures_key(const GLuint *textures) {
+    uint32_t hash = 2166136261u;
+    for (int unit = 0; unit < SGL_MAX_TEXTURE_UNITS; unit++) {
+        hash = (hash ^ textures[unit]) * 16777619u;
+    }
+    return (uint16_t)(hash ^ (hash >> 16));
+}
+
+/* Start a packet for the current draw, NULL if it must be drawn in place
+ * (the buffered draws were emitted then) */
+static sgl_draw_packet_t *sgl_draw_sort_begin(sgl_context_t *ctx, bool elements) {
+    sgl_draw_sort_t *sort = ctx->draw_sort;
+    sgl_backend_t *be = ctx->backend;
+
+    sgl_program_t *prog = GET_PROGRAM(ctx->current_program);
+    if (prog) sgl_program_finish_link(ctx, ctx->current_program, prog);
+    if (!prog || !prog->linked || !sgl_draw_sortable(ctx, elements)) {
+        sgl_draw_sort_emit(ctx);
+        return NULL;
+    }
+
+    bool cacheable = ctx->bound_vertex_array != 0 && be->ops->bind_vertex_array &&
+                     sgl_vertex_layout_cacheable(ctx);
+
+    /* A run shares one fixed-function state; the backend caches one layout
+     * per VAO, so draws buffered with the old layout go first */
+    uint32_t gen = be->ops->get_state_generation ? be->ops->get_state_generation(be) : 0;
+    if (ctx->dirty_state || gen != sort->state_generation || sort->count == SGL_DRAW_SORT_MAX_DRAWS ||
+        (cacheable && ctx->vertex_layout_dirty)) {
+        sgl_draw_sort_emit(ctx);
+    }
+    if (sort->count == 0) {
+        sgl_ensure_frame_ready();
+        if (ctx->pending_clear) sgl_clear_resolve(ctx);
+        sgl_apply_dirty_state(ctx);
+        sort->state_generation = be->ops->get_state_generation ? be->ops->get_state_generation(be) : 0;
+        sort->blend_state = ctx->blend_state;
+        sort->depth_state = ctx->depth_state;
+        sort->raster_state = ctx->raster_state;
+        sort->viewport_state = ctx->viewport_state;
+        sort->color_state = ctx->color_state;
+    }
+    if (cacheable && ctx->vertex_layout_dirty) {
+        be->ops->bind_vertex_array(be, ctx->bound_vertex_array, ctx->vertex_attribs, SGL_MAX_ATTRIBS, true);
+        ctx->vertex_layout_dirty = false;
+    }
+
+    sgl_draw_packet_t *p = &sort->packets[sort->count];
+    if (!sgl_draw_sort_snapshot_attribs(ctx, sort, &p->attribs) ||
+        !sgl_draw_sort_snapshot_uniforms(sort, ctx->current_program, prog, &p->uniforms)) {
+        sgl_draw_sort_emit(ctx);
+        return NULL;
+    }
+
+    for (GLuint unit = 0; unit < SGL_MAX_TEXTURE_UNITS; unit++) {
+        GLuint tex_id = ctx->bound_textures[unit];
+        sgl_texture_t *tex = tex_id ? GET_TEXTURE(tex_id) : NULL;
+        if (tex && tex->used) sgl_flush_texture_params(ctx, tex_id, tex);
+        p->textures[unit] = (tex && tex->used) ? tex_id : 0;
+    }
+    p->program = ctx->current_program;
+    p->vertex_array = cacheable ? ctx->bound_vertex_array : 0;
+    p->elements = elements;
+
+    uint64_t state = ((uint64_t)(p->program & 0xFFFF) << 32) |
+                     ((uint64_t)sgl_draw_sort_textures_key(p->textures) << 16) |
+                     (p->vertex_array ? (p->vertex_array & 0x7FFF) : (0x8000 | (p->attribs & 0x7FFF)));
+    p->key = sort->mode == SGL_DRAW_SORT_DEPTH ? ((uint64_t)sort->depth << 48) | state
+                                               : (state << 16) | sort->depth;
+    return p;
+}
+
+bool sgl_draw_sort_arrays(sgl_context_t *ctx, GLenum mode, GLint first, GLsizei count,
+                          GLsizei instances) {
+    sgl_draw_packet_t *p = sgl_draw_sort_begin(ctx, false);
+    if (!p) return false;
+
+    p->mode = mode;
+    p->type = 0;
+    p->indices = NULL;
+    p->ebo_offset = 0;
+    p->first = first;
+    p->count = count;
+    p->vertex_count = count;
+    p->instances = instances;
+    ctx->draw_sort->count++;
+    return true;
+}
+
+bool sgl_draw_sort_elements(sgl_context_t *ctx, GLenum mode, GLsizei count, GLenum type,
+                            const void *indices, GLsizei instances) {
+    sgl_buffer_t *ebo_buf = GET_BUFFER(ctx->bound_element_buffer);
+    if (!ebo_buf) {
+        sgl_draw_sort_emit(ctx);
+        return false;
+    }
+    sgl_draw_packet_t *p = sgl_draw_sort_begin(ctx, true);
+    if (!p) return false;
+
+    /* As in glDrawElements; no client arrays, so the buffer's cached range will do */
+    GLuint min_idx, max_idx;
+    GLenum draw_type = type;
+    uint32_t offset = sgl_element_buffer_locate(ctx, ctx->bound_element_buffer, type,
+                                                (uintptr_t)indices, count, false,
+                                                &draw_type, &min_idx, &max_idx);
+    if (offset != 0) {
+        p->first = (GLint)min_idx;
+        p->vertex_count = (GLsizei)(max_idx - min_idx + 1);
+    } else {
+        offset = ebo_buf->data_offset + (uint32_t)(uintptr_t)indices;
+        p->first = 0;
+        p->vertex_count = count;
+    }
+    p->mode = mode;
+    p->type = draw_type;
+    p->indices = indices;
+    p->ebo_offset = offset;
+    p->count = count;
+    p->instances = instances;
+    ctx->draw_sort->count++;
+    return true;
+}
+
+/* ============================================================================
+ * Emit
+ * ============================================================================ */
+
+static int sgl_draw_order_compare(const void *a, const void *b) {
+    const sgl_draw_order_t *x = (const sgl_draw_order_t *)a;
+    const sgl_draw_order_t *y = (const sgl_draw_order_t *)b;
+    if (x->key != y->key) return x->key < y->key ? -1 : 1;
+    return x->packet < y->packet ? -1 : (x->packet > y->packet);  /* Stable: submission order */
+}
+
+/* Point the bindings handed to the backend at a uniform snapshot. Packed
+ * UBOs are pushed in full, except when the previous draw had the same
+ * snapshot: the backend's copy holds it already. */
+static void sgl_draw_sort_load_uniforms(sgl_draw_sort_t *sort, uint32_t offset) {
+    if (offset == sort->loaded_uniforms) {
+        for (int i = 0; i < SGL_MAX_PACKED_UBOS; i++) {
+            sort->packed_vertex[i].dirty = false;
+            sort->packed_fragment[i].dirty = false;
+        }
+        return;
+    }
+    sort->loaded_uniforms = offset;
+    memset(sort->vertex_uniforms, 0, sizeof(sort->vertex_uniforms));
+    memset(sort->fragment_uniforms, 0, sizeof(sort->fragment_uniforms));
+    memset(sort->packed_vertex, 0, sizeof(sort->packed_vertex));
+    memset(sort->packed_fragment, 0, sizeof(sort->packed_fragment));
+
+    const uint8_t *p = sort->uniforms + offset;
+    const sgl_draw_uniforms_t *hdr = (const sgl_draw_uniforms_t *)p;
+    p += sizeof(*hdr);
+    for (uint32_t i = 0; i < hdr->legacy_count; i++) {
+        const sgl_draw_legacy_uniform_t *lu = (const sgl_draw_legacy_uniform_t *)p;
+        sgl_uniform_binding_t *ub = lu->stage == 0 ? &sort->vertex_uniforms[lu->index]
+                                                   : &sort->fragment_uniforms[lu->index];
+        ub->valid = true;
+        ub->offset = lu->offset;
+        ub->size = lu->size;
+        ub->data_size = lu->data_size;
+        p += sizeof(*lu);
+    }
+    for (uint32_t i = 0; i < hdr->packed_count; i++) {
+        const sgl_draw_packed_uniform_t *pu = (const sgl_draw_packed_uniform_t *)p;
+        sgl_packed_ubo_t *packed = pu->stage == 0 ? &sort->packed_vertex[pu->binding]
+                                                  : &sort->packed_fragment[pu->binding];
+        packed->data = (uint8_t *)(pu + 1);
+        packed->capacity = pu->size;
+        packed->size = pu->size;
+        packed->valid = true;
+        packed->dirty = true;
+        packed->dirty_begin = 0;
+        packed->dirty_end = pu->size;
+        p += sizeof(*pu) + SGL_ALIGN_UP(pu->size, 4);
+    }
+}
+
+/* The backend lost the run's state (its command buffer was reset): emit it
+ * again from the copy taken when the run started */
+static void sgl_draw_sort_restore_state(sgl_context_t *ctx, sgl_draw_sort_t *sort) {
+    sgl_state_blend_t blend_state = ctx->blend_state;
+    sgl_state_depth_t depth_state = ctx->depth_state;
+    sgl_state_raster_t raster_state = ctx->raster_state;
+    sgl_state_viewport_t viewport_state = ctx->viewport_state;
+    sgl_state_color_t color_state = ctx->color_state;
+
+    ctx->blend_state = sort->blend_state;
+    ctx->depth_state = sort->depth_state;
+    ctx->raster_state = sort->raster_state;
+    ctx->viewport_state = sort->viewport_state;
+    ctx->color_state = sort->color_state;
+    sgl_context_invalidate_state(ctx);
+    sgl_apply_dirty_state(ctx);
+
+    ctx->blend_state = blend_state;
+    ctx->depth_state = depth_state;
+    ctx->raster_state = raster_state;
+    ctx->viewport_state = viewport_state;
+    ctx->color_state = color_state;
+    sgl_context_invalidate_state(ctx);
+}
+
+void sgl_draw_sort_emit(sgl_context_t *ctx) {
+    sgl_draw_sort_t *sort = ctx->draw_sort;
+    if (!sort || sort->count == 0) return;
+    sgl_backend_t *be = ctx->backend;
+    uint32_t count = sort->count;
+    sort->count = 0;
+
+    if (be->ops->get_state_generation && be->ops->get_state_generation(be) != sort->state_generation) {
+        sgl_draw_sort_restore_state(ctx, sort);
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        sort->order[i].key = sort->packets[i].key;
+        sort->order[i].packet = i;
+    }
+    qsort(sort->order, count, sizeof(sort->order[0]), sgl_draw_order_compare);
+
+    sort->loaded_uniforms = UINT32_MAX;
+    for (uint32_t i = 0; i < count; i++) {
+        const sgl_draw_packet_t *p = &sort->packets[sort->order[i].packet];
+        const sgl_vertex_attrib_t *attribs = sort->attribs[p->attribs];
+
+        sgl_program_t *prog = GET_PROGRAM(p->program);
+        if (prog && be->ops->bind_program) {
+            sgl_draw_sort_load_uniforms(sort, p->uniforms);
+            be->ops->bind_program(be, p->program, prog->vertex_shader, prog->fragment_shader,
+                                  sort->vertex_uniforms, sort->fragment_uniforms, SGL_MAX_UNIFORMS,
+                                  sort->packed_vertex, sort->packed_fragment, SGL_MAX_PACKED_UBOS);
+        }
+        if (be->ops->bind_texture) {
+            for (GLuint unit = 0; unit < SGL_MAX_TEXTURE_UNITS; unit++) {
+                if (p->textures[unit]) be->ops->bind_texture(be, unit, p->textures[unit]);
+            }
+        }
+
+        if (p->vertex_array) {
+            be->ops->bind_vertex_array(be, p->vertex_array, attribs, SGL_MAX_ATTRIBS, false);
+        } else if (be->ops->bind_vertex_attribs) {
+            be->ops->bind_vertex_attribs(be, attribs, SGL_MAX_ATTRIBS, p->first, p->vertex_count,
+                                         p->instances);
+        }
+
+        if (!p->elements) {
+            if (be->ops->draw_arrays) be->ops->draw_arrays(be, p->mode, p->first, p->count, p->instances);
+        } else if (be->ops->draw_elements) {
+            be->ops->draw_elements(be, p->mode, p->count, p->type, p->indices, p->ebo_offset,
+                                   p->instances);
+        }
+    }
+
+    /* The backend's packed UBO copies hold whichever snapshot went last, not
+     * necessarily the newest: the next bind of these programs pushes in full */
+    GLuint last = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        GLuint program = sort->packets[sort->order[i].packet].program;
+        if (program == last) continue;
+        last = program;
+        sgl_program_t *prog = GET_PROGRAM(program);
+        if (!prog) continue;
+        for (int b = 0; b < SGL_MAX_PACKED_UBOS; b++) {
+            sgl_packed_ubo_t *ubos[2] = { &prog->packed_vertex[b], &prog->packed_fragment[b] };
+            for (int s = 0; s < 2; s++) {
+                if (!ubos[s]->valid || ubos[s]->size == 0) continue;
+                ubos[s]->dirty = true;
+                ubos[s]->dirty_begin = 0;
+                ubos[s]->dirty_end = ubos[s]->size;
+            }
+        }
+    }
+
+    sort->attrib_count = 0;
+    sort->uniform_size = 0;
+    sort->last_program = 0;
+
+    SGL_TRACE_DRAW("draw sort: emitted %u draws", count);
+}
+
+/* ============================================================================
+ * API
+ * ============================================================================ */
+
+GL_APICALL void GL_APIENTRY sglSetDrawSortMode(GLenum mode) {
+    GET_CTX();
+    CHECK_BACKEND();
+
+    if (mode != SGL_DRAW_SORT_NONE && mode != SGL_DRAW_SORT_STATE && mode != SGL_DRAW_SORT_DEPTH) {
+        sgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    if (ctx->recorder) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+
+    sgl_draw_sort_emit(ctx);
+    if (mode == SGL_DRAW_SORT_NONE) {
+        sgl_draw_sort_destroy(ctx->draw_sort);
+        ctx->draw_sort = NULL;
+    } else {
+        if (!ctx->draw_sort) {
+            ctx->draw_sort = (sgl_draw_sort_t *)calloc(1, sizeof(sgl_draw_sort_t));
+            if (!ctx->draw_sort) {
+                sgl_set_error(ctx, GL_OUT_OF_MEMORY);
+                return;
+            }
+        }
+        ctx->draw_sort->mode = mode;
+    }
+
+    SGL_TRACE_DRAW("sglSetDrawSortMode(%u)", mode);
+}
+
+GL_APICALL void GL_APIENTRY sglSetDrawSortDepth(GLfloat depth) {
+    GET_CTX();
+    if (!ctx->draw_sort) return;
+
+    /* IEEE floats compare like integers once negative values are flipped */
+    uint32_t bits;
+    memcpy(&bits, &depth, sizeof(bits));
+    bits ^= (bits & 0x80000000u) ? 0xFFFFFFFFu : 0x80000000u;
+    ctx->draw_sort->depth = (uint16_t)(bits >> 16);
+}
@@ -4,9 +4,33 @@
  */
 
 #include "gl_common.h"
+#include <GLES2/gl2sgl.h>
+#include <string.h>
 
 /* GL 3.0+ constants now defined in gl2ext.h */
 
+/* Framebuffer bound to target (GL_READ_FRAMEBUFFER reads the read binding) */
+static GLuint sgl_framebuffer_binding(const sgl_context_t *ctx, GLenum target) {
+    return target == GL_READ_FRAMEBUFFER ? ctx->bound_read_framebuffer : ctx->bound_framebuffer;
+}
+
+/* Make a framebuffer the backend's render target with its attachments */
+static void sgl_framebuffer_bind_backend(sgl_context_t *ctx, GLuint framebuffer) {
+    if (!ctx->backend || !ctx->backend->ops->bind_framebuffer) return;
+
+    sgl_handle_t color_tex = 0;
+    sgl_handle_t depth_rb = 0;
+    if (framebuffer != 0) {
+        sgl_framebuffer_t *fbo = GET_FRAMEBUFFER(framebuffer);
+        if (fbo) {
+            color_tex = fbo->color_attachments[0];
+            /* Depth textures reach the backend through framebuffer_texture */
+            depth_rb = fbo->depth_is_renderbuffer ? fbo->depth_attachment : 0;
+        }
+    }
+    ctx->backend->ops->bind_framebuffer(ctx->backend, framebuffer, color_tex, depth_rb);
+}
+
 /* Framebuffer Objects */
 
 GL_APICALL void GL_APIENTRY glGenFramebuffers(GLsizei n, GLuint *framebuffers) {
@@ -18,18 +42,20 @@ GL_APICALL void GL_APIENTRY glGenFramebuffers(GLsizei n, GLuint *framebuffers) {
     }
 
     for (GLsizei i = 0; i < n; i++) {
-        framebuffers[i] = sgl_res_mgr_alloc_framebuffer(&ctx->res_mgr);
+        framebuffers[i] = sgl_res_mgr_alloc_framebuffer(ctx->res_mgr);
         if (framebuffers[i] == 0) {
             sgl_set_error(ctx, GL_OUT_OF_MEMORY);
             return;
         }
     }
 
+    SGL_CAPTURE_DATA(SGL_TRACE_GEN_FRAMEBUFFERS, framebuffers, (uint32_t)n * 4, (uint32_t)n);
     SGL_TRACE_FBO("glGenFramebuffers(%d)", n);
 }
 
 GL_APICALL void GL_APIENTRY glDeleteFramebuffers(GLsizei n, const GLuint *framebuffers) {
     GET_CTX();
+    sgl_flush_deferred(ctx);
 
     if (n < 0) { sgl_set_error(ctx, GL_INVALID_VALUE); return; }
     if (!framebuffers) return;
@@ -38,17 +64,22 @@ GL_APICALL void GL_APIENTRY glDeleteFramebuffers(GLsizei n, const GLuint *frameb
         GLuint id = framebuffers[i];
         if (id == 0) continue;
 
+        if (ctx->bound_read_framebuffer == id) {
+            ctx->bound_read_framebuffer = 0;
+        }
         if (ctx->bound_framebuffer == id) {
             ctx->bound_framebuffer = 0;
+            sgl_context_mark_dirty(ctx, SGL_DIRTY_VIEWPORT | SGL_DIRTY_SCISSOR);
             /* Rebind default framebuffer via backend */
             if (ctx->backend && ctx->backend->ops->bind_framebuffer) {
                 ctx->backend->ops->bind_framebuffer(ctx->backend, 0, 0, 0);
             }
         }
 
-        sgl_res_mgr_free_framebuffer(&ctx->res_mgr, id);
+        sgl_res_mgr_free_framebuffer(ctx->res_mgr, id);
     }
 
+    SGL_CAPTURE_DATA(SGL_TRACE_DELETE_FRAMEBUFFERS, framebuffers, (uint32_t)n * 4, (uint32_t)n);
     SGL_TRACE_FBO("glDeleteFramebuffers(%d)", n);
 }
 
@@ -62,6 +93,7 @@ GL_APICALL void GL_APIENTRY glBindFramebuffer(GLenum target, GLuint framebuffer)
 
     GET_CTX();
     CHECK_BACKEND();
+    sgl_flush_deferred(ctx);
 
     if (target != GL_FRAMEBUFFER && target != GL_READ_FRAMEBUFFER && target != GL_DRAW_FRAMEBUFFER) {
         sgl_set_error(ctx, GL_INVALID_ENUM);
@@ -73,26 +105,27 @@ GL_APICALL void GL_APIENTRY glBindFramebuffer(GLenum target, GLuint framebuffer)
         return;
     }
 
-    /* Insert barrier when switching render targets */
-    if (ctx->bound_framebuffer != framebuffer && ctx->backend->ops->insert_barrier) {
-        ctx->backend->ops->insert_barrier(ctx->backend);
+    SGL_CAPTURE(SGL_TRACE_BIND_FRAMEBUFFER, target, framebuffer);
+
+    /* The read binding is only a source for glBlitFramebuffer and glReadPixels */
+    if (target != GL_DRAW_FRAMEBUFFER) {
+        ctx->bound_read_framebuffer = framebuffer;
+    }
+    if (target == GL_READ_FRAMEBUFFER) {
+        SGL_TRACE_FBO("glBindFramebuffer(0x%X, %u)", target, framebuffer);
+        return;
+    }
+
+    /* The backend scales default framebuffer viewports (sglSetRenderResolution) */
+    if ((framebuffer == 0) != (ctx->bound_framebuffer == 0)) {
+        sgl_context_mark_dirty(ctx, SGL_DIRTY_VIEWPORT | SGL_DIRTY_SCISSOR);
     }
 
+    /* No barrier here - the backend tracks render target hazards */
     ctx->bound_framebuffer = framebuffer;
 
     /* Delegate render target switch to backend */
-    if (ctx->backend->ops->bind_framebuffer) {
-        sgl_handle_t color_tex = 0;
-        sgl_handle_t depth_rb = 0;
-        if (framebuffer != 0) {
-            sgl_framebuffer_t *fbo = GET_FRAMEBUFFER(framebuffer);
-            if (fbo) {
-                color_tex = fbo->color_attachment;
-                depth_rb = fbo->depth_attachment;
-            }
-        }
-        ctx->backend->ops->bind_framebuffer(ctx->backend, framebuffer, color_tex, depth_rb);
-    }
+    sgl_framebuffer_bind_backend(ctx, framebuffer);
 
     SGL_TRACE_FBO("glBindFramebuffer(0x%X, %u)", target, framebuffer);
 }
@@ -100,6 +133,7 @@ GL_APICALL void GL_APIENTRY glBindFramebuffer(GLenum target, GLuint framebuffer)
 GL_APICALL void GL_APIENTRY glFramebufferTexture2D(GLenum target, GLenum attachment,
                                                      GLenum textarget, GLuint texture, GLint level) {
     GET_CTX();
+    sgl_flush_deferred(ctx);
 
     if (target != GL_FRAMEBUFFER && target != GL_READ_FRAMEBUFFER && target != GL_DRAW_FRAMEBUFFER) {
         sgl_set_error(ctx, GL_INVALID_ENUM);
@@ -122,33 +156,50 @@ GL_APICALL void GL_APIENTRY glFramebufferTexture2D(GLenum target, GLenum attachm
         }
     }
 
-    if (ctx->bound_framebuffer == 0) {
+    GLuint framebuffer = sgl_framebuffer_binding(ctx, target);
+    if (framebuffer == 0) {
         sgl_set_error(ctx, GL_INVALID_OPERATION);
         return;
     }
 
-    sgl_framebuffer_t *fbo = GET_FRAMEBUFFER(ctx->bound_framebuffer);
+    sgl_framebuffer_t *fbo = GET_FRAMEBUFFER(framebuffer);
     if (!fbo) {
         sgl_set_error(ctx, GL_INVALID_OPERATION);
         return;
     }
 
+    SGL_CAPTURE(SGL_TRACE_FRAMEBUFFER_TEXTURE_2D, target, attachment, textarget, texture, (uint32_t)level);
+
+    /* GL_COLOR_ATTACHMENT0..3 (GL_EXT_draw_buffers) */
+    if (attachment >= GL_COLOR_ATTACHMENT0 &&
+        attachment < GL_COLOR_ATTACHMENT0 + SGL_MAX_DRAW_BUFFERS) {
+        GLuint index = attachment - GL_COLOR_ATTACHMENT0;
+        fbo->color_attachments[index] = texture;
+        fbo->color_textargets[index] = texture ? textarget : GL_NONE;
+        /* The backend needs the texture and cubemap face before the rebind */
+        if (ctx->backend && ctx->backend->ops->framebuffer_texture) {
+            ctx->backend->ops->framebuffer_texture(ctx->backend, framebuffer,
+                                                    attachment, textarget, texture, level);
+        }
+        /* Update render target binding immediately */
+        if (framebuffer == ctx->bound_framebuffer) {
+            sgl_framebuffer_bind_backend(ctx, framebuffer);
+        }
+        SGL_TRACE_FBO("glFramebufferTexture2D(attachment=0x%X, texture=%u)", attachment, texture);
+        return;
+    }
+
     switch (attachment) {
-        case GL_COLOR_ATTACHMENT0:
-            fbo->color_attachment = texture;
-            /* Update render target binding immediately */
-            if (ctx->backend && ctx->backend->ops->bind_framebuffer) {
-                ctx->backend->ops->bind_framebuffer(ctx->backend, ctx->bound_framebuffer,
-                                                     texture, fbo->depth_attachment);
-            }
-            break;
         case GL_DEPTH_ATTACHMENT:
             fbo->depth_attachment = texture;
-            fbo->depth_is_renderbuffer = false;  /* texture attachment */
+            fbo->depth_is_renderbuffer = false;  /* texture attachment (GL_OES_depth_texture) */
+            if (ctx->backend && ctx->backend->ops->framebuffer_texture) {
+                ctx->backend->ops->framebuffer_texture(ctx->backend, framebuffer,
+                                                        attachment, textarget, texture, level);
+            }
             /* Re-bind to update depth attachment */
-            if (ctx->backend && ctx->backend->ops->bind_framebuffer && fbo->color_attachment) {
-                ctx->backend->ops->bind_framebuffer(ctx->backend, ctx->bound_framebuffer,
-                                                     fbo->color_attachment, texture);
+            if (framebuffer == ctx->bound_framebuffer) {
+                sgl_framebuffer_bind_backend(ctx, framebuffer);
             }
             break;
         case GL_STENCIL_ATTACHMENT:
@@ -163,6 +214,38 @@ GL_APICALL void GL_APIENTRY glFramebufferTexture2D(GLenum target, GLenum attachm
     SGL_TRACE_FBO("glFramebufferTexture2D(attachment=0x%X, texture=%u)", attachment, texture);
 }
 
+/* Check one attachment for glCheckFramebufferStatus: a usable image of the
+ * right kind (depth textures only on depth/stencil attachment points), the
+ * same size as those checked before it */
+static GLenum sgl_attachment_status(sgl_context_t *ctx, GLuint id, bool is_renderbuffer, bool depth,
+                                    bool *any, GLsizei *width, GLsizei *height) {
+    GLsizei w, h;
+    if (is_renderbuffer) {
+        sgl_renderbuffer_t *rb = GET_RENDERBUFFER(id);
+        if (!rb || !rb->used) {
+            return GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT;
+        }
+        w = rb->width;
+        h = rb->height;
+    } else {
+        sgl_texture_t *tex = GET_TEXTURE(id);
+        if (!tex || !tex->used || tex->width == 0 || tex->height == 0 ||
+            sgl_is_depth_format(tex->internal_format) != depth) {
+            return GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT;
+        }
+        w = tex->width;
+        h = tex->height;
+    }
+
+    if (*any && (w != *width || h != *height)) {
+        return GL_FRAMEBUFFER_INCOMPLETE_DIMENSIONS;
+    }
+    *any = true;
+    *width = w;
+    *height = h;
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
 GL_APICALL GLenum GL_APIENTRY glCheckFramebufferStatus(GLenum target) {
     GET_CTX_RET(0);
 
@@ -171,62 +254,49 @@ GL_APICALL GLenum GL_APIENTRY glCheckFramebufferStatus(GLenum target) {
         return 0;
     }
 
-    if (ctx->bound_framebuffer == 0) {
+    GLuint framebuffer = sgl_framebuffer_binding(ctx, target);
+    if (framebuffer == 0) {
         return GL_FRAMEBUFFER_COMPLETE;  /* Default framebuffer always complete */
     }
 
-    sgl_framebuffer_t *fbo = GET_FRAMEBUFFER(ctx->bound_framebuffer);
+    sgl_framebuffer_t *fbo = GET_FRAMEBUFFER(framebuffer);
     if (!fbo) {
         return GL_FRAMEBUFFER_UNDEFINED;
     }
 
-    /* Check if we have at least one color attachment */
-    if (fbo->color_attachment == 0) {
-        return GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT;
-    }
-
-    /* Verify the color attachment is a valid texture with dimensions */
-    sgl_texture_t *tex = GET_TEXTURE(fbo->color_attachment);
-    if (!tex || !tex->used) {
-        return GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT;
-    }
-    if (tex->width == 0 || tex->height == 0) {
-        return GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT;
+    /* Every attachment present is complete and all share one size. Depth-only
+     * FBOs (shadow maps) are fine; color attachments start at attachment 0. */
+    GLsizei width = 0, height = 0;
+    bool any = false;
+    for (int i = 0; i < SGL_MAX_DRAW_BUFFERS; i++) {
+        if (fbo->color_attachments[i] == 0) continue;
+        if (i > 0 && fbo->color_attachments[0] == 0) {
+            return GL_FRAMEBUFFER_UNSUPPORTED;
+        }
+        GLenum status = sgl_attachment_status(ctx, fbo->color_attachments[i], false, false,
+                                              &any, &width, &height);
+        if (status != GL_FRAMEBUFFER_COMPLETE) return status;
     }
 
-    /* Verify depth attachment if present */
     if (fbo->depth_attachment != 0) {
-        if (fbo->depth_is_renderbuffer) {
-            sgl_renderbuffer_t *rb = GET_RENDERBUFFER(fbo->depth_attachment);
-            if (!rb || !rb->used) {
-                return GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT;
-            }
-            /* Check dimension match */
-            if (rb->width != tex->width || rb->height != tex->height) {
-                return GL_FRAMEBUFFER_INCOMPLETE_DIMENSIONS;
-            }
-        } else {
-            sgl_texture_t *depth_tex = GET_TEXTURE(fbo->depth_attachment);
-            if (!depth_tex || !depth_tex->used) {
-                return GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT;
-            }
-            if (depth_tex->width != tex->width || depth_tex->height != tex->height) {
-                return GL_FRAMEBUFFER_INCOMPLETE_DIMENSIONS;
-            }
-        }
+        GLenum status = sgl_attachment_status(ctx, fbo->depth_attachment, fbo->depth_is_renderbuffer,
+                                              true, &any, &width, &height);
+        if (status != GL_FRAMEBUFFER_COMPLETE) return status;
     }
 
-    /* Verify stencil attachment if present */
     if (fbo->stencil_attachment != 0) {
-        if (fbo->stencil_is_renderbuffer) {
-            sgl_renderbuffer_t *rb = GET_RENDERBUFFER(fbo->stencil_attachment);
-            if (!rb || !rb->used) {
-                return GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT;
-            }
-            if (rb->width != tex->width || rb->height != tex->height) {
-                return GL_FRAMEBUFFER_INCOMPLETE_DIMENSIONS;
-            }
+        /* A stencil texture is the depth-stencil texture on the depth attachment too */
+        if (!fbo->stencil_is_renderbuffer &&
+            (fbo->depth_is_renderbuffer || fbo->stencil_attachment != fbo->depth_attachment)) {
+            return GL_FRAMEBUFFER_UNSUPPORTED;
         }
+        GLenum status = sgl_attachment_status(ctx, fbo->stencil_attachment, fbo->stencil_is_renderbuffer,
+                                              true, &any, &width, &height);
+        if (status != GL_FRAMEBUFFER_COMPLETE) return status;
+    }
+
+    if (!any) {
+        return GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT;
     }
 
     fbo->is_complete = true;
@@ -236,6 +306,7 @@ GL_APICALL GLenum GL_APIENTRY glCheckFramebufferStatus(GLenum target) {
 GL_APICALL void GL_APIENTRY glFramebufferRenderbuffer(GLenum target, GLenum attachment,
                                                         GLenum renderbuffertarget, GLuint renderbuffer) {
     GET_CTX();
+    sgl_flush_deferred(ctx);
     (void)renderbuffertarget;
 
     if (target != GL_FRAMEBUFFER && target != GL_READ_FRAMEBUFFER && target != GL_DRAW_FRAMEBUFFER) {
@@ -243,12 +314,13 @@ GL_APICALL void GL_APIENTRY glFramebufferRenderbuffer(GLenum target, GLenum atta
         return;
     }
 
-    if (ctx->bound_framebuffer == 0) {
+    GLuint framebuffer = sgl_framebuffer_binding(ctx, target);
+    if (framebuffer == 0) {
         sgl_set_error(ctx, GL_INVALID_OPERATION);
         return;
     }
 
-    sgl_framebuffer_t *fbo = GET_FRAMEBUFFER(ctx->bound_framebuffer);
+    sgl_framebuffer_t *fbo = GET_FRAMEBUFFER(framebuffer);
     if (!fbo) {
         sgl_set_error(ctx, GL_INVALID_OPERATION);
         return;
@@ -258,11 +330,6 @@ GL_APICALL void GL_APIENTRY glFramebufferRenderbuffer(GLenum target, GLenum atta
         case GL_DEPTH_ATTACHMENT:
             fbo->depth_attachment = renderbuffer;
             fbo->depth_is_renderbuffer = true;
-            /* Re-bind to update depth attachment */
-            if (ctx->backend && ctx->backend->ops->bind_framebuffer && fbo->color_attachment) {
-                ctx->backend->ops->bind_framebuffer(ctx->backend, ctx->bound_framebuffer,
-                                                     fbo->color_attachment, renderbuffer);
-            }
             break;
         case GL_STENCIL_ATTACHMENT:
             fbo->stencil_attachment = renderbuffer;
@@ -273,17 +340,24 @@ GL_APICALL void GL_APIENTRY glFramebufferRenderbuffer(GLenum target, GLenum atta
             fbo->stencil_attachment = renderbuffer;
             fbo->depth_is_renderbuffer = true;
             fbo->stencil_is_renderbuffer = true;
-            /* Re-bind to update depth attachment */
-            if (ctx->backend && ctx->backend->ops->bind_framebuffer && fbo->color_attachment) {
-                ctx->backend->ops->bind_framebuffer(ctx->backend, ctx->bound_framebuffer,
-                                                     fbo->color_attachment, renderbuffer);
-            }
             break;
         default:
             sgl_set_error(ctx, GL_INVALID_ENUM);
             return;
     }
 
+    /* A renderbuffer replaces any depth texture; re-bind to update the depth attachment */
+    if (attachment != GL_STENCIL_ATTACHMENT) {
+        if (ctx->backend && ctx->backend->ops->framebuffer_texture) {
+            ctx->backend->ops->framebuffer_texture(ctx->backend, framebuffer,
+                                                    GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+        }
+        if (framebuffer == ctx->bound_framebuffer) {
+            sgl_framebuffer_bind_backend(ctx, framebuffer);
+        }
+    }
+
+    SGL_CAPTURE(SGL_TRACE_FRAMEBUFFER_RENDERBUFFER, target, attachment, renderbuffertarget, renderbuffer);
     SGL_TRACE_FBO("glFramebufferRenderbuffer(attachment=0x%X, rb=%u)", attachment, renderbuffer);
 }
 
@@ -296,21 +370,27 @@ GL_APICALL void GL_APIENTRY glGetFramebufferAttachmentParameteriv(GLenum target,
         return;
     }
 
-    if (ctx->bound_framebuffer == 0) {
+    GLuint framebuffer = sgl_framebuffer_binding(ctx, target);
+    if (framebuffer == 0) {
         *params = 0;
         return;
     }
 
-    sgl_framebuffer_t *fbo = GET_FRAMEBUFFER(ctx->bound_framebuffer);
+    sgl_framebuffer_t *fbo = GET_FRAMEBUFFER(framebuffer);
     if (!fbo) {
         *params = 0;
         return;
     }
 
     GLuint obj = 0;
+    GLenum textarget = GL_TEXTURE_2D;
     switch (attachment) {
         case GL_COLOR_ATTACHMENT0:
-            obj = fbo->color_attachment;
+        case GL_COLOR_ATTACHMENT1_EXT:
+        case GL_COLOR_ATTACHMENT2_EXT:
+        case GL_COLOR_ATTACHMENT3_EXT:
+            obj = fbo->color_attachments[attachment - GL_COLOR_ATTACHMENT0];
+            textarget = fbo->color_textargets[attachment - GL_COLOR_ATTACHMENT0];
             break;
         case GL_DEPTH_ATTACHMENT:
             obj = fbo->depth_attachment;
@@ -330,7 +410,7 @@ GL_APICALL void GL_APIENTRY glGetFramebufferAttachmentParameteriv(GLenum target,
     } else if (attachment == GL_STENCIL_ATTACHMENT) {
         is_renderbuffer = fbo->stencil_is_renderbuffer;
     }
-    /* GL_COLOR_ATTACHMENT0 is always a texture in our implementation */
+    /* Color attachments are always textures in our implementation */
 
     switch (pname) {
         case GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE:
@@ -349,7 +429,8 @@ GL_APICALL void GL_APIENTRY glGetFramebufferAttachmentParameteriv(GLenum target,
             *params = 0;
             break;
         case GL_FRAMEBUFFER_ATTACHMENT_TEXTURE_CUBE_MAP_FACE:
-            *params = 0;  /* Always 0 for non-cubemap attachments */
+            /* 0 for non-cubemap attachments */
+            *params = (obj != 0 && !is_renderbuffer && textarget != GL_TEXTURE_2D) ? (GLint)textarget : 0;
             break;
         default:
             sgl_set_error(ctx, GL_INVALID_ENUM);
@@ -357,6 +438,59 @@ GL_APICALL void GL_APIENTRY glGetFramebufferAttachmentParameteriv(GLenum target,
     }
 }
 
+/* Draw Buffers (GL_EXT_draw_buffers) */
+
+GL_APICALL void GL_APIENTRY glDrawBuffersEXT(GLsizei n, const GLenum *bufs) {
+    GET_CTX();
+    CHECK_BACKEND();
+    sgl_flush_deferred(ctx);
+
+    if (n < 0 || n > SGL_MAX_DRAW_BUFFERS || (n > 0 && !bufs)) {
+        sgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+
+    /* Default framebuffer: one buffer, GL_BACK or GL_NONE */
+    uint8_t mask = 0;
+    if (ctx->bound_framebuffer == 0) {
+        if (n != 1 || (bufs[0] != GL_BACK && bufs[0] != GL_NONE)) {
+            sgl_set_error(ctx, GL_INVALID_OPERATION);
+            return;
+        }
+        mask = bufs[0] == GL_BACK ? 1 : 0;
+    } else {
+        /* FBO: entry i is GL_COLOR_ATTACHMENTi or GL_NONE */
+        for (GLsizei i = 0; i < n; i++) {
+            if (bufs[i] == GL_NONE) continue;
+            if (bufs[i] == GL_BACK ||
+                bufs[i] < GL_COLOR_ATTACHMENT0 || bufs[i] >= GL_COLOR_ATTACHMENT0 + SGL_MAX_DRAW_BUFFERS) {
+                sgl_set_error(ctx, bufs[i] == GL_BACK ? GL_INVALID_OPERATION : GL_INVALID_ENUM);
+                return;
+            }
+            if (bufs[i] != GL_COLOR_ATTACHMENT0 + (GLenum)i) {
+                sgl_set_error(ctx, GL_INVALID_OPERATION);
+                return;
+            }
+            mask |= (uint8_t)(1u << i);
+        }
+    }
+
+    SGL_CAPTURE_DATA(SGL_TRACE_DRAW_BUFFERS, bufs, (uint32_t)n * 4, (uint32_t)n);
+
+    sgl_framebuffer_t *fbo = ctx->bound_framebuffer ? GET_FRAMEBUFFER(ctx->bound_framebuffer) : NULL;
+    uint8_t *current = fbo ? &fbo->draw_buffers : &ctx->default_draw_buffers;
+    if (*current == mask) return;
+    *current = mask;
+
+    /* Takes effect at the next bind: rebind the render target now */
+    if (ctx->backend->ops->draw_buffers) {
+        ctx->backend->ops->draw_buffers(ctx->backend, ctx->bound_framebuffer, mask);
+    }
+    sgl_framebuffer_bind_backend(ctx, ctx->bound_framebuffer);
+
+    SGL_TRACE_FBO("glDrawBuffersEXT(fbo %u, mask 0x%X)", ctx->bound_framebuffer, mask);
+}
+
 /* Renderbuffer Objects */
 
 GL_APICALL void GL_APIENTRY glGenRenderbuffers(GLsizei n, GLuint *renderbuffers) {
@@ -368,18 +502,20 @@ GL_APICALL void GL_APIENTRY glGenRenderbuffers(GLsizei n, GLuint *renderbuffers)
     }
 
     for (GLsizei i = 0; i < n; i++) {
-        renderbuffers[i] = sgl_res_mgr_alloc_renderbuffer(&ctx->res_mgr);
+        renderbuffers[i] = sgl_res_mgr_alloc_renderbuffer(ctx->res_mgr);
         if (renderbuffers[i] == 0) {
             sgl_set_error(ctx, GL_OUT_OF_MEMORY);
             return;
         }
     }
 
+    SGL_CAPTURE_DATA(SGL_TRACE_GEN_RENDERBUFFERS, renderbuffers, (uint32_t)n * 4, (uint32_t)n);
     SGL_TRACE_FBO("glGenRenderbuffers(%d)", n);
 }
 
 GL_APICALL void GL_APIENTRY glDeleteRenderbuffers(GLsizei n, const GLuint *renderbuffers) {
     GET_CTX();
+    sgl_flush_deferred(ctx);
 
     if (n < 0) { sgl_set_error(ctx, GL_INVALID_VALUE); return; }
     if (!renderbuffers) return;
@@ -392,9 +528,10 @@ GL_APICALL void GL_APIENTRY glDeleteRenderbuffers(GLsizei n, const GLuint *rende
             ctx->bound_renderbuffer = 0;
         }
 
-        sgl_res_mgr_free_renderbuffer(&ctx->res_mgr, id);
+        sgl_res_mgr_free_renderbuffer(ctx->res_mgr, id);
     }
 
+    SGL_CAPTURE_DATA(SGL_TRACE_DELETE_RENDERBUFFERS, renderbuffers, (uint32_t)n * 4, (uint32_t)n);
     SGL_TRACE_FBO("glDeleteRenderbuffers(%d)", n);
 }
 
@@ -418,6 +555,7 @@ GL_APICALL void GL_APIENTRY glBindRenderbuffer(GLenum target, GLuint renderbuffe
 
     ctx->bound_renderbuffer = renderbuffer;
 
+    SGL_CAPTURE(SGL_TRACE_BIND_RENDERBUFFER, target, renderbuffer);
     SGL_TRACE_FBO("glBindRenderbuffer(%u)", renderbuffer);
 }
 
@@ -425,6 +563,7 @@ GL_APICALL void GL_APIENTRY glRenderbufferStorage(GLenum target, GLenum internal
                                                     GLsizei width, GLsizei height) {
     GET_CTX();
     CHECK_BACKEND();
+    sgl_flush_deferred(ctx);
 
     if (target != GL_RENDERBUFFER) {
         sgl_set_error(ctx, GL_INVALID_ENUM);
@@ -471,6 +610,7 @@ GL_APICALL void GL_APIENTRY glRenderbufferStorage(GLenum target, GLenum internal
                                                  internalformat, width, height);
     }
 
+    SGL_CAPTURE(SGL_TRACE_RENDERBUFFER_STORAGE, target, internalformat, (uint32_t)width, (uint32_t)height);
     SGL_TRACE_FBO("glRenderbufferStorage(format=0x%X, %dx%d)", internalformat, width, height);
 }
 
@@ -523,24 +663,44 @@ GL_APICALL void GL_APIENTRY glGetRenderbufferParameteriv(GLenum target, GLenum p
 
 /* ReadPixels */
 
-GL_APICALL void GL_APIENTRY glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height,
-                                          GLenum format, GLenum type, void *pixels) {
-    GET_CTX();
-    CHECK_BACKEND();
-
+static void sgl_read_pixels(sgl_context_t *ctx, GLint x, GLint y, GLsizei width, GLsizei height,
+                            GLenum format, GLenum type, void *pixels) {
     if (width < 0 || height < 0) {
         sgl_set_error(ctx, GL_INVALID_VALUE);
         return;
     }
-    if (!pixels || width == 0 || height == 0) {
-        return;  /* No-op per spec */
-    }
-
     if (format != GL_RGBA || type != GL_UNSIGNED_BYTE) {
         sgl_set_error(ctx, GL_INVALID_ENUM);
         return;
     }
 
+    /* Pixel pack buffer bound: pixels is an offset into it. The copy is
+     * recorded into the frame and completes on its fence - no stall here. */
+    if (ctx->bound_pixel_pack_buffer != 0) {
+        sgl_buffer_t *buf = GET_BUFFER(ctx->bound_pixel_pack_buffer);
+        uintptr_t offset = (uintptr_t)pixels;
+        size_t size = (size_t)width * (size_t)height * 4;
+        if (!buf || buf->map_pointer || offset + size > (size_t)buf->size) {
+            sgl_set_error(ctx, GL_INVALID_OPERATION);
+            return;
+        }
+        if (width == 0 || height == 0) return;
+
+        if (ctx->backend->ops->read_pixels_to_buffer) {
+            ctx->backend->ops->read_pixels_to_buffer(ctx->backend, x, y, width, height,
+                                                     format, type,
+                                                     ctx->bound_pixel_pack_buffer,
+                                                     (uint32_t)offset);
+        }
+        SGL_TRACE_FBO("glReadPixels(%d,%d %dx%d) -> pack buffer %u+%u",
+                      x, y, width, height, ctx->bound_pixel_pack_buffer, (uint32_t)offset);
+        return;
+    }
+
+    if (!pixels || width == 0 || height == 0) {
+        return;  /* No-op per spec */
+    }
+
     /* Delegate to backend for actual GPU readback */
     if (ctx->backend->ops->read_pixels) {
         ctx->backend->ops->read_pixels(ctx->backend, x, y, width, height, format, type, pixels);
@@ -549,17 +709,169 @@ GL_APICALL void GL_APIENTRY glReadPixels(GLint x, GLint y, GLsizei width, GLsize
     SGL_TRACE_FBO("glReadPixels(%d,%d %dx%d)", x, y, width, height);
 }
 
-/* Blit framebuffer stub (needed by Spearmint for MSAA resolve, no-op without MSAA) */
+GL_APICALL void GL_APIENTRY glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height,
+                                          GLenum format, GLenum type, void *pixels) {
+    GET_CTX();
+    CHECK_BACKEND();
+    sgl_flush_deferred(ctx);
+
+    SGL_CAPTURE(SGL_TRACE_READ_PIXELS, (uint32_t)x, (uint32_t)y, (uint32_t)width, (uint32_t)height, format,
+                type, (uint32_t)(uintptr_t)pixels, ctx->bound_pixel_pack_buffer != 0);
+
+    /* The backend reads its render target: switch to the read binding for
+     * the copy when it differs from the draw binding */
+    bool read_other = ctx->bound_read_framebuffer != ctx->bound_framebuffer;
+    if (read_other) {
+        sgl_framebuffer_bind_backend(ctx, ctx->bound_read_framebuffer);
+    }
+    sgl_read_pixels(ctx, x, y, width, height, format, type, pixels);
+    if (read_other) {
+        sgl_framebuffer_bind_backend(ctx, ctx->bound_framebuffer);
+    }
+}
+
+/* Blit Framebuffer (GL_ANGLE_framebuffer_blit, GL_NV_framebuffer_blit) */
+
+/* Color attachment texture of a framebuffer, 0 for the default one */
+static bool sgl_blit_color(sgl_context_t *ctx, GLuint framebuffer, GLuint *color) {
+    *color = 0;
+    if (framebuffer == 0) return true;
+
+    sgl_framebuffer_t *fbo = GET_FRAMEBUFFER(framebuffer);
+    if (!fbo || fbo->color_attachments[0] == 0) return false;
+    sgl_texture_t *tex = GET_TEXTURE(fbo->color_attachments[0]);
+    if (!tex || !tex->used || tex->width == 0 || tex->height == 0) return false;
+
+    *color = fbo->color_attachments[0];
+    return true;
+}
 
 GL_APICALL void GL_APIENTRY glBlitFramebuffer(
     GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1,
     GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1,
     GLbitfield mask, GLenum filter)
 {
-    (void)srcX0; (void)srcY0; (void)srcX1; (void)srcY1;
-    (void)dstX0; (void)dstY0; (void)dstX1; (void)dstY1;
-    (void)mask; (void)filter;
-    /* No MSAA support - no-op */
+    sgl_ensure_frame_ready();
+
+    GET_CTX();
+    CHECK_BACKEND();
+    sgl_flush_deferred(ctx);
+
+    if (mask & ~(GLbitfield)(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT)) {
+        sgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    if (filter != GL_NEAREST && filter != GL_LINEAR) {
+        sgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    if ((mask & (GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT)) && filter != GL_NEAREST) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+    if (ctx->bound_read_framebuffer == ctx->bound_framebuffer) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+
+    GLuint read_color, draw_color;
+    if (!sgl_blit_color(ctx, ctx->bound_read_framebuffer, &read_color) ||
+        !sgl_blit_color(ctx, ctx->bound_framebuffer, &draw_color)) {
+        sgl_set_error(ctx, GL_INVALID_FRAMEBUFFER_OPERATION);
+        return;
+    }
+
+    SGL_CAPTURE(SGL_TRACE_BLIT_FRAMEBUFFER, (uint32_t)srcX0, (uint32_t)srcY0, (uint32_t)srcX1, (uint32_t)srcY1,
+                (uint32_t)dstX0, (uint32_t)dstY0, (uint32_t)dstX1, (uint32_t)dstY1, mask, filter);
+
+    /* Depth and stencil are not copied: the 2D engine only blits color */
+    if (!(mask & GL_COLOR_BUFFER_BIT)) return;
+
+    const GLint src[4] = { srcX0, srcY0, srcX1, srcY1 };
+    const GLint dst[4] = { dstX0, dstY0, dstX1, dstY1 };
+    if (ctx->backend->ops->blit_framebuffer &&
+        !ctx->backend->ops->blit_framebuffer(ctx->backend, ctx->bound_read_framebuffer, read_color,
+                                             src, dst, filter)) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+
+    SGL_TRACE_FBO("glBlitFramebuffer(fbo %u (%d,%d)-(%d,%d) -> fbo %u (%d,%d)-(%d,%d), 0x%X)",
+                  ctx->bound_read_framebuffer, srcX0, srcY0, srcX1, srcY1,
+                  ctx->bound_framebuffer, dstX0, dstY0, dstX1, dstY1, filter);
+}
+
+GL_APICALL void GL_APIENTRY glBlitFramebufferANGLE(
+    GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1,
+    GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1,
+    GLbitfield mask, GLenum filter)
+{
+    glBlitFramebuffer(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+}
+
+GL_APICALL void GL_APIENTRY glBlitFramebufferNV(
+    GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1,
+    GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1,
+    GLbitfield mask, GLenum filter)
+{
+    glBlitFramebuffer(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+}
+
+/* Discard Framebuffer (GL_EXT_discard_framebuffer) */
+
+GL_APICALL void GL_APIENTRY glDiscardFramebufferEXT(GLenum target, GLsizei numAttachments,
+                                                    const GLenum *attachments) {
+    GET_CTX();
+    CHECK_BACKEND();
+    sgl_flush_deferred(ctx);
+
+    if (target != GL_FRAMEBUFFER) {
+        sgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    if (numAttachments < 0 || (numAttachments > 0 && !attachments)) {
+        sgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+
+    /* FBOs name attachment points, the default framebuffer names buffers */
+    bool is_default = ctx->bound_framebuffer == 0;
+    uint32_t color_mask = 0;
+    bool depth = false, stencil = false;
+    for (GLsizei i = 0; i < numAttachments; i++) {
+        GLenum a = attachments[i];
+        if (is_default ? a == GL_COLOR_EXT : a == GL_COLOR_ATTACHMENT0) {
+            color_mask |= 1u;
+        } else if (!is_default && a > GL_COLOR_ATTACHMENT0 &&
+                   a < GL_COLOR_ATTACHMENT0 + SGL_MAX_DRAW_BUFFERS) {
+            color_mask |= 1u << (a - GL_COLOR_ATTACHMENT0);
+        } else if (a == (is_default ? GL_DEPTH_EXT : GL_DEPTH_ATTACHMENT)) {
+            depth = true;
+        } else if (a == (is_default ? GL_STENCIL_EXT : GL_STENCIL_ATTACHMENT)) {
+            stencil = true;
+        } else {
+            sgl_set_error(ctx, GL_INVALID_ENUM);
+            return;
+        }
+    }
+
+    SGL_CAPTURE_DATA(SGL_TRACE_DISCARD_FRAMEBUFFER, attachments, (uint32_t)numAttachments * 4, target,
+                     (uint32_t)numAttachments);
+
+    /* Depth and stencil live in one image: drop it only when the stencil
+     * contents go too, or when no stencil is attached alongside the depth */
+    bool depth_stencil = depth && stencil;
+    if (!is_default && depth && !stencil) {
+        sgl_framebuffer_t *fbo = GET_FRAMEBUFFER(ctx->bound_framebuffer);
+        depth_stencil = fbo && fbo->stencil_attachment != fbo->depth_attachment;
+    }
+
+    if ((color_mask || depth_stencil) && ctx->backend->ops->discard_framebuffer) {
+        ctx->backend->ops->discard_framebuffer(ctx->backend, color_mask, depth_stencil);
+    }
+
+    SGL_TRACE_FBO("glDiscardFramebufferEXT(fbo %u, color 0x%X, depth_stencil %d)",
+                  ctx->bound_framebuffer, color_mask, depth_stencil);
 }
 
 /* Multisample renderbuffer stub (falls back to non-multisampled storage) */
@@ -571,3 +883,115 @@ GL_APICALL void GL_APIENTRY glRenderbufferStorageMultisample(
     (void)samples;
     glRenderbufferStorage(target, internalformat, width, height);
 }
+
+/*
+ * sglGetBarrierStats - Number of GPU barriers recorded since init
+ */
+GL_APICALL void GL_APIENTRY sglGetBarrierStats(GLuint *full, GLuint *fragments, GLuint *tiles) {
+    GET_CTX();
+    CHECK_BACKEND();
+
+    uint32_t f = 0, fr = 0, t = 0;
+    if (ctx->backend->ops->get_barrier_stats) {
+        ctx->backend->ops->get_barrier_stats(ctx->backend, &f, &fr, &t);
+    }
+    if (full) *full = f;
+    if (fragments) *fragments = fr;
+    if (tiles) *tiles = t;
+}
+
+/*
+ * sglGetCommandMemoryStats - Command memory high-water mark and pool size
+ */
+GL_APICALL void GL_APIENTRY sglGetCommandMemoryStats(GLuint *peak, GLuint *pooled) {
+    GET_CTX();
+    CHECK_BACKEND();
+
+    uint32_t p = 0, c = 0;
+    if (ctx->backend->ops->get_cmd_mem_stats) {
+        ctx->backend->ops->get_cmd_mem_stats(ctx->backend, &p, &c);
+    }
+    if (peak) *peak = p;
+    if (pooled) *pooled = c;
+}
+
+/*
+ * sglGetFrameStats - Backend counters of the last completed frame
+ */
+GL_APICALL void GL_APIENTRY sglGetFrameStats(sgl_frame_stats_t *stats) {
+    GET_CTX();
+    CHECK_BACKEND();
+
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (ctx->backend->ops->get_frame_stats) {
+        ctx->backend->ops->get_frame_stats(ctx->backend, stats);
+    }
+}
+
+/*
+ * sglGetMemoryStats - Usage of every GPU memory heap
+ */
+GL_APICALL void GL_APIENTRY sglGetMemoryStats(sgl_memory_stats_t *stats) {
+    GET_CTX();
+    CHECK_BACKEND();
+
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (ctx->backend->ops->get_memory_stats) {
+        ctx->backend->ops->get_memory_stats(ctx->backend, stats);
+    }
+}
+
+/*
+ * sglSetRenderResolution - Render the default framebuffer below the surface size
+ */
+GL_APICALL void GL_APIENTRY sglSetRenderResolution(GLsizei width, GLsizei height) {
+    GET_CTX();
+    CHECK_BACKEND();
+    sgl_flush_deferred(ctx);
+
+    if (width < 0 || height < 0 || (width == 0) != (height == 0)) {
+        sgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    if (ctx->backend->ops->set_render_resolution) {
+        ctx->backend->ops->set_render_resolution(ctx->backend, width, height);
+    }
+
+    SGL_TRACE_FBO("sglSetRenderResolution(%d, %d)", width, height);
+}
+
+/*
+ * sglSetDynamicResolution - Scale the render resolution with GPU frame time
+ */
+GL_APICALL void GL_APIENTRY sglSetDynamicResolution(GLuint target_gpu_us, GLfloat min_scale) {
+    GET_CTX();
+    CHECK_BACKEND();
+    sgl_flush_deferred(ctx);
+
+    if (target_gpu_us != 0 && !(min_scale > 0.0f && min_scale <= 1.0f)) {
+        sgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    if (ctx->backend->ops->set_dynamic_resolution) {
+        ctx->backend->ops->set_dynamic_resolution(ctx->backend, (uint64_t)target_gpu_us * 1000, min_scale);
+    }
+
+    SGL_TRACE_FBO("sglSetDynamicResolution(%u us, %.2f)", target_gpu_us, min_scale);
+}
+
+/*
+ * sglGetRenderResolution - Size the default framebuffer renders at this frame
+ */
+GL_APICALL void GL_APIENTRY sglGetRenderResolution(GLint *width, GLint *height) {
+    GET_CTX();
+    CHECK_BACKEND();
+
+    GLsizei w = 0, h = 0;
+    if (ctx->backend->ops->get_render_resolution) {
+        ctx->backend->ops->get_render_resolution(ctx->backend, &w, &h);
+    }
+    if (width) *width = w;
+    if (height) *height = h;
+}
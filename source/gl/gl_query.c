@@ -4,6 +4,7 @@
  */
 
 #include "gl_common.h"
+#include <GLES2/gl2sgl.h>
 #include <string.h>
 #include <stdio.h>
 
@@ -75,11 +76,31 @@ GL_APICALL const GLubyte *GL_APIENTRY glGetString(GLenum name) {
                 "GL_OES_packed_depth_stencil "
                 "GL_OES_element_index_uint "
                 "GL_OES_texture_npot "
+                "GL_OES_vertex_array_object "
+                "GL_OES_vertex_half_float "
+                "GL_ANGLE_instanced_arrays "
+                "GL_EXT_instanced_arrays "
+                "GL_EXT_draw_instanced "
+                "GL_EXT_multi_draw_arrays "
+                "GL_EXT_disjoint_timer_query "
+                "GL_EXT_occlusion_query_boolean "
+                "GL_OES_mapbuffer "
+                "GL_EXT_map_buffer_range "
+                "GL_APPLE_sync "
+                "GL_ANGLE_framebuffer_blit "
+                "GL_NV_framebuffer_blit "
+                "GL_EXT_draw_buffers "
+                "GL_EXT_discard_framebuffer "
+                "GL_OES_depth_texture "
+                "GL_NV_pixel_buffer_object "
+                "GL_OES_get_program_binary "
+                "GL_KHR_parallel_shader_compile "
                 "GL_OES_compressed_ETC1_RGB8_texture "
                 "GL_EXT_blend_minmax "
                 "GL_EXT_texture_compression_s3tc "
                 "GL_KHR_texture_compression_astc_ldr "
-                "GL_OES_standard_derivatives";
+                "GL_OES_standard_derivatives "
+                "GL_NVX_gpu_memory_info";
         default:
             return NULL;
     }
@@ -87,6 +108,35 @@ GL_APICALL const GLubyte *GL_APIENTRY glGetString(GLenum name) {
 
 /* Integer Queries */
 
+/* GL_NVX_gpu_memory_info: totals over every heap of sglGetMemoryStats, in KB */
+static GLint sgl_gpu_memory_info(sgl_context_t *ctx, GLenum pname) {
+    sgl_memory_stats_t stats;
+    memset(&stats, 0, sizeof(stats));
+    if (ctx->backend && ctx->backend->ops->get_memory_stats) {
+        ctx->backend->ops->get_memory_stats(ctx->backend, &stats);
+    }
+
+    uint64_t capacity = 0, free_bytes = 0, failed = 0;
+    for (int i = 0; i < SGL_MEMORY_HEAP_COUNT; i++) {
+        const sgl_memory_heap_stats_t *h = &stats.heaps[i];
+        capacity += h->capacity;
+        free_bytes += h->capacity > h->used ? h->capacity - h->used : 0;
+        failed += h->failed_allocs;
+    }
+
+    switch (pname) {
+        case GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX:
+        case GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX:
+            return (GLint)(capacity / 1024);
+        case GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX:
+            return (GLint)(free_bytes / 1024);
+        case GL_GPU_MEMORY_INFO_EVICTION_COUNT_NVX:
+            return (GLint)failed;
+        default:
+            return 0;   /* Nothing is ever evicted */
+    }
+}
+
 GL_APICALL void GL_APIENTRY glGetIntegerv(GLenum pname, GLint *params) {
     GET_CTX();
 
@@ -128,6 +178,19 @@ GL_APICALL void GL_APIENTRY glGetIntegerv(GLenum pname, GLint *params) {
         case GL_MAX_RENDERBUFFER_SIZE:
             *params = 8192;
             break;
+        case GL_MAX_SHADER_COMPILER_THREADS_KHR:
+            *params = sgl_max_shader_compiler_threads();
+            break;
+        case GL_GPU_DISJOINT_EXT:
+            *params = 0;  /* The GPU timer never jumps */
+            break;
+        case GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX:
+        case GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX:
+        case GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX:
+        case GL_GPU_MEMORY_INFO_EVICTION_COUNT_NVX:
+        case GL_GPU_MEMORY_INFO_EVICTED_MEMORY_NVX:
+            *params = sgl_gpu_memory_info(ctx, pname);
+            break;
 
         /* Current state */
         case GL_VIEWPORT:
@@ -171,6 +234,12 @@ GL_APICALL void GL_APIENTRY glGetIntegerv(GLenum pname, GLint *params) {
         case GL_SHADER_BINARY_FORMATS:
             *params = GL_DKSH_BINARY_FORMAT_NX;
             break;
+        case GL_NUM_PROGRAM_BINARY_FORMATS_OES:
+            *params = 1;
+            break;
+        case GL_PROGRAM_BINARY_FORMATS_OES:
+            *params = GL_SGL_PROGRAM_BINARY_FORMAT_NX;
+            break;
 
         /* Bindings */
         case GL_ARRAY_BUFFER_BINDING:
@@ -179,9 +248,18 @@ GL_APICALL void GL_APIENTRY glGetIntegerv(GLenum pname, GLint *params) {
         case GL_ELEMENT_ARRAY_BUFFER_BINDING:
             *params = ctx->bound_element_buffer;
             break;
+        case GL_VERTEX_ARRAY_BINDING_OES:
+            *params = ctx->bound_vertex_array;
+            break;
+        case GL_PIXEL_PACK_BUFFER_BINDING_NV:
+            *params = ctx->bound_pixel_pack_buffer;
+            break;
         case GL_FRAMEBUFFER_BINDING:
             *params = ctx->bound_framebuffer;
             break;
+        case GL_READ_FRAMEBUFFER_BINDING_ANGLE:
+            *params = ctx->bound_read_framebuffer;
+            break;
         case GL_RENDERBUFFER_BINDING:
             *params = ctx->bound_renderbuffer;
             break;
@@ -324,8 +402,23 @@ GL_APICALL void GL_APIENTRY glGetIntegerv(GLenum pname, GLint *params) {
             *params = 0;     /* No MSAA */
             break;
         case GL_MAX_COLOR_ATTACHMENTS:
-            *params = 1;
+        case GL_MAX_DRAW_BUFFERS_EXT:
+            *params = SGL_MAX_DRAW_BUFFERS;
+            break;
+        case GL_DRAW_BUFFER0_EXT:
+        case GL_DRAW_BUFFER1_EXT:
+        case GL_DRAW_BUFFER2_EXT:
+        case GL_DRAW_BUFFER3_EXT: {
+            GLuint index = pname - GL_DRAW_BUFFER0_EXT;
+            sgl_framebuffer_t *fbo = ctx->bound_framebuffer ?
+                GET_FRAMEBUFFER(ctx->bound_framebuffer) : NULL;
+            if (fbo) {
+                *params = (fbo->draw_buffers & (1u << index)) ? (GLint)(GL_COLOR_ATTACHMENT0 + index) : GL_NONE;
+            } else {
+                *params = (index == 0 && ctx->default_draw_buffers) ? GL_BACK : GL_NONE;
+            }
             break;
+        }
         case GL_NUM_EXTENSIONS:
             *params = 0;     /* Use glGetString(GL_EXTENSIONS) instead */
             break;
@@ -432,6 +525,8 @@ GL_APICALL void GL_APIENTRY glGetFloatv(GLenum pname, GLfloat *params) {
 
 GL_APICALL void GL_APIENTRY glFlush(void) {
     GET_CTX();
+    sgl_flush_deferred(ctx);
+    if (ctx->capture) sgl_capture_call(ctx, SGL_TRACE_FLUSH, NULL, 0, NULL, 0);
     if (ctx->backend && ctx->backend->ops->flush) {
         ctx->backend->ops->flush(ctx->backend);
     }
@@ -439,6 +534,8 @@ GL_APICALL void GL_APIENTRY glFlush(void) {
 
 GL_APICALL void GL_APIENTRY glFinish(void) {
     GET_CTX();
+    sgl_flush_deferred(ctx);
+    if (ctx->capture) sgl_capture_call(ctx, SGL_TRACE_FINISH, NULL, 0, NULL, 0);
     if (ctx->backend && ctx->backend->ops->finish) {
         ctx->backend->ops->finish(ctx->backend);
     }
@@ -476,6 +573,7 @@ GL_APICALL void GL_APIENTRY glLineWidth(GLfloat width) {
     }
 
     ctx->raster_state.line_width = width;
+    SGL_CAPTURE(SGL_TRACE_LINE_WIDTH, sgl_capture_float(width));
 }
 
 /* Polygon Offset */
@@ -485,12 +583,9 @@ GL_APICALL void GL_APIENTRY glPolygonOffset(GLfloat factor, GLfloat units) {
 
     ctx->raster_state.polygon_offset_factor = factor;
     ctx->raster_state.polygon_offset_units = units;
+    sgl_context_mark_dirty(ctx, SGL_DIRTY_DEPTH_BIAS);
 
-    /* Apply to backend */
-    if (ctx->backend && ctx->backend->ops->set_depth_bias) {
-        ctx->backend->ops->set_depth_bias(ctx->backend, factor, units);
-    }
-
+    SGL_CAPTURE(SGL_TRACE_POLYGON_OFFSET, sgl_capture_float(factor), sgl_capture_float(units));
     SGL_TRACE_STATE("glPolygonOffset(%.2f, %.2f)", factor, units);
 }
 
@@ -511,11 +606,16 @@ GL_APICALL void GL_APIENTRY glPixelStorei(GLenum pname, GLint param) {
             break;
         case GL_UNPACK_ALIGNMENT:
             ctx->unpack_alignment = param;
+            if (ctx->backend && ctx->backend->ops->pixel_store) {
+                ctx->backend->ops->pixel_store(ctx->backend, pname, param);
+            }
             break;
         default:
             sgl_set_error(ctx, GL_INVALID_ENUM);
-            break;
+            return;
     }
+
+    SGL_CAPTURE(SGL_TRACE_PIXEL_STOREI, pname, (uint32_t)param);
 }
 
 /* Buffer Queries */
@@ -525,15 +625,12 @@ GL_APICALL void GL_APIENTRY glGetBufferParameteriv(GLenum target, GLenum pname,
 
     if (!params) return;
 
-    GLuint buffer_id = 0;
-    if (target == GL_ARRAY_BUFFER) {
-        buffer_id = ctx->bound_array_buffer;
-    } else if (target == GL_ELEMENT_ARRAY_BUFFER) {
-        buffer_id = ctx->bound_element_buffer;
-    } else {
+    GLuint *binding = sgl_buffer_binding(ctx, target);
+    if (!binding) {
         sgl_set_error(ctx, GL_INVALID_ENUM);
         return;
     }
+    GLuint buffer_id = *binding;
 
     if (buffer_id == 0) {
         sgl_set_error(ctx, GL_INVALID_OPERATION);
@@ -553,6 +650,12 @@ GL_APICALL void GL_APIENTRY glGetBufferParameteriv(GLenum target, GLenum pname,
         case GL_BUFFER_USAGE:
             *params = buf->usage;
             break;
+        case GL_BUFFER_ACCESS_OES:
+            *params = GL_WRITE_ONLY_OES;
+            break;
+        case GL_BUFFER_MAPPED_OES:
+            *params = buf->map_pointer ? GL_TRUE : GL_FALSE;
+            break;
         default:
             sgl_set_error(ctx, GL_INVALID_ENUM);
             break;
@@ -0,0 +1,361 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * GL Layer - Query Objects (EXT_disjoint_timer_query, EXT_occlusion_query_boolean)
+ *
+ * Queries record GPU counter reports into the main command buffer. Results
+ * are readable once the submission holding them has finished; checking
+ * GL_QUERY_RESULT_AVAILABLE_EXT never blocks, so a title can read last
+ * frame's timings without stalling. The backend keeps the results of the
+ * last few begin/end pairs, which sglBeginConditionalRender uses to skip
+ * draws behind an occluder without waiting on the GPU. Queries cannot be
+ * used while recording on a worker thread (sglBeginRecorder).
+ *
+ * IMPORTANT: This file must NOT include deko3d.h or use any dk*() calls!
+ * All GPU operations go through ctx->backend->ops->xxx()
+ */
+
+#include "gl_common.h"
+#include <GLES2/gl2sgl.h>
+#include <string.h>
+
+/* Active query for a begin/end target, NULL if the target is invalid.
+ * Both occlusion targets share one binding: only one can be active. */
+static GLuint *sgl_query_binding(sgl_context_t *ctx, GLenum target) {
+    switch (target) {
+        case GL_TIME_ELAPSED_EXT:
+            return &ctx->active_time_query;
+        case GL_ANY_SAMPLES_PASSED_EXT:
+        case GL_ANY_SAMPLES_PASSED_CONSERVATIVE_EXT:
+            return &ctx->active_occlusion_query;
+        default:
+            return NULL;
+    }
+}
+
+static bool sgl_query_is_active(sgl_context_t *ctx, GLuint id) {
+    return id != 0 && (ctx->active_time_query == id || ctx->active_occlusion_query == id);
+}
+
+static bool sgl_query_is_occlusion(const sgl_query_t *q) {
+    return q->target == GL_ANY_SAMPLES_PASSED_EXT ||
+           q->target == GL_ANY_SAMPLES_PASSED_CONSERVATIVE_EXT;
+}
+
+/* The backend object is made when the query is first used */
+static bool sgl_query_prepare(sgl_context_t *ctx, sgl_query_t *q, GLenum target) {
+    if (q->backend_handle == 0) {
+        if (!ctx->backend->ops->create_query) return false;
+        q->backend_handle = ctx->backend->ops->create_query(ctx->backend);
+        if (q->backend_handle == 0) {
+            sgl_set_error(ctx, GL_OUT_OF_MEMORY);
+            return false;
+        }
+    }
+    q->begun_once = true;
+    q->target = target;
+    q->result_valid = false;
+    return true;
+}
+
+/* ============================================================================
+ * Query Objects
+ * ============================================================================ */
+
+GL_APICALL void GL_APIENTRY glGenQueriesEXT(GLsizei n, GLuint *ids) {
+    GET_CTX();
+
+    if (n < 0) { sgl_set_error(ctx, GL_INVALID_VALUE); return; }
+    if (!ids) return;
+
+    for (GLsizei i = 0; i < n; i++) {
+        ids[i] = sgl_res_mgr_alloc_query(ctx->res_mgr);
+        if (ids[i] == 0) {
+            sgl_set_error(ctx, GL_OUT_OF_MEMORY);
+            return;
+        }
+    }
+
+    SGL_TRACE_CORE("glGenQueriesEXT(%d)", n);
+}
+
+GL_APICALL void GL_APIENTRY glDeleteQueriesEXT(GLsizei n, const GLuint *ids) {
+    GET_CTX();
+    sgl_flush_deferred(ctx);
+
+    if (n < 0) { sgl_set_error(ctx, GL_INVALID_VALUE); return; }
+    if (!ids) return;
+
+    for (GLsizei i = 0; i < n; i++) {
+        sgl_query_t *q = GET_QUERY(ids[i]);
+        if (!q) continue;
+
+        /* Deleting an active query ends it */
+        if (sgl_query_is_active(ctx, ids[i])) {
+            *sgl_query_binding(ctx, q->target) = 0;
+        }
+        if (q->backend_handle && ctx->backend && ctx->backend->ops->delete_query) {
+            ctx->backend->ops->delete_query(ctx->backend, q->backend_handle);
+        }
+        sgl_res_mgr_free_query(ctx->res_mgr, ids[i]);
+    }
+
+    SGL_TRACE_CORE("glDeleteQueriesEXT(%d)", n);
+}
+
+GL_APICALL GLboolean GL_APIENTRY glIsQueryEXT(GLuint id) {
+    GET_CTX_RET(GL_FALSE);
+
+    sgl_query_t *q = GET_QUERY(id);
+    return (q && q->begun_once) ? GL_TRUE : GL_FALSE;
+}
+
+/* ============================================================================
+ * Recording
+ * ============================================================================ */
+
+GL_APICALL void GL_APIENTRY glBeginQueryEXT(GLenum target, GLuint id) {
+    GET_CTX();
+    CHECK_BACKEND();
+    sgl_flush_deferred(ctx);
+
+    GLuint *active = sgl_query_binding(ctx, target);
+    if (!active) {
+        sgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    sgl_query_t *q = GET_QUERY(id);
+    if (!q || *active != 0 || sgl_query_is_active(ctx, id) || ctx->recorder ||
+        (q->begun_once && q->target != target)) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+
+    sgl_ensure_frame_ready();
+    if (!sgl_query_prepare(ctx, q, target)) return;
+    ctx->backend->ops->begin_query(ctx->backend, q->backend_handle, target);
+    *active = id;
+
+    SGL_TRACE_CORE("glBeginQueryEXT(0x%X, %u)", target, id);
+}
+
+GL_APICALL void GL_APIENTRY glEndQueryEXT(GLenum target) {
+    GET_CTX();
+    CHECK_BACKEND();
+    sgl_flush_deferred(ctx);
+
+    GLuint *active = sgl_query_binding(ctx, target);
+    if (!active) {
+        sgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    sgl_query_t *q = GET_QUERY(*active);
+    if (!q || ctx->recorder) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+
+    sgl_ensure_frame_ready();
+    ctx->backend->ops->end_query(ctx->backend, q->backend_handle);
+    *active = 0;
+
+    SGL_TRACE_CORE("glEndQueryEXT(0x%X)", target);
+}
+
+GL_APICALL void GL_APIENTRY glQueryCounterEXT(GLuint id, GLenum target) {
+    GET_CTX();
+    CHECK_BACKEND();
+    sgl_flush_deferred(ctx);
+
+    if (target != GL_TIMESTAMP_EXT) {
+        sgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+    sgl_query_t *q = GET_QUERY(id);
+    if (!q || sgl_query_is_active(ctx, id) || ctx->recorder ||
+        (q->begun_once && q->target != target)) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+
+    sgl_ensure_frame_ready();
+    if (!sgl_query_prepare(ctx, q, target)) return;
+    ctx->backend->ops->query_counter(ctx->backend, q->backend_handle);
+
+    SGL_TRACE_CORE("glQueryCounterEXT(%u)", id);
+}
+
+/* ============================================================================
+ * Results
+ * ============================================================================ */
+
+GL_APICALL void GL_APIENTRY glGetQueryivEXT(GLenum target, GLenum pname, GLint *params) {
+    GET_CTX();
+
+    if (!params) return;
+    GLuint *active = sgl_query_binding(ctx, target);
+    if (!active && target != GL_TIMESTAMP_EXT) {
+        sgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+
+    switch (pname) {
+        case GL_CURRENT_QUERY_EXT: {
+            sgl_query_t *q = active ? GET_QUERY(*active) : NULL;
+            *params = (q && q->target == target) ? (GLint)*active : 0;
+            break;
+        }
+        case GL_QUERY_COUNTER_BITS_EXT:
+            /* EXT_occlusion_query_boolean has no counter bits */
+            *params = (target == GL_TIME_ELAPSED_EXT || target == GL_TIMESTAMP_EXT) ? 64 : 0;
+            break;
+        default:
+            sgl_set_error(ctx, GL_INVALID_ENUM);
+            break;
+    }
+}
+
+/* Shared by the glGetQueryObject*vEXT variants; false on error */
+static bool sgl_get_query_object(sgl_context_t *ctx, GLuint id, GLenum pname, uint64_t *value) {
+    if (pname != GL_QUERY_RESULT_EXT && pname != GL_QUERY_RESULT_AVAILABLE_EXT) {
+        sgl_set_error(ctx, GL_INVALID_ENUM);
+        return false;
+    }
+    sgl_query_t *q = GET_QUERY(id);
+    if (!q || !q->begun_once || sgl_query_is_active(ctx, id) || ctx->recorder) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return false;
+    }
+    if (!ctx->backend || !ctx->backend->ops || !ctx->backend->ops->get_query_result) {
+        *value = (pname == GL_QUERY_RESULT_AVAILABLE_EXT) ? GL_TRUE : 0;
+        return true;
+    }
+
+    if (!q->result_valid) {
+        bool wait = (pname == GL_QUERY_RESULT_EXT);
+        q->result_valid = ctx->backend->ops->get_query_result(ctx->backend, q->backend_handle,
+                                                              wait, &q->result);
+    }
+    if (pname == GL_QUERY_RESULT_AVAILABLE_EXT) {
+        *value = q->result_valid ? GL_TRUE : GL_FALSE;
+    } else if (sgl_query_is_occlusion(q)) {
+        *value = (q->result_valid && q->result > 0) ? GL_TRUE : GL_FALSE;
+    } else {
+        *value = q->result_valid ? q->result : 0;
+    }
+    return true;
+}
+
+GL_APICALL void GL_APIENTRY glGetQueryObjectivEXT(GLuint id, GLenum pname, GLint *params) {
+    GET_CTX();
+    uint64_t value;
+    if (params && sgl_get_query_object(ctx, id, pname, &value)) {
+        *params = value > 0x7FFFFFFF ? 0x7FFFFFFF : (GLint)value;
+    }
+}
+
+GL_APICALL void GL_APIENTRY glGetQueryObjectuivEXT(GLuint id, GLenum pname, GLuint *params) {
+    GET_CTX();
+    uint64_t value;
+    if (params && sgl_get_query_object(ctx, id, pname, &value)) {
+        *params = value > 0xFFFFFFFF ? 0xFFFFFFFF : (GLuint)value;
+    }
+}
+
+GL_APICALL void GL_APIENTRY glGetQueryObjecti64vEXT(GLuint id, GLenum pname, GLint64 *params) {
+    GET_CTX();
+    uint64_t value;
+    if (params && sgl_get_query_object(ctx, id, pname, &value)) {
+        *params = (GLint64)value;
+    }
+}
+
+GL_APICALL void GL_APIENTRY glGetQueryObjectui64vEXT(GLuint id, GLenum pname, GLuint64 *params) {
+    GET_CTX();
+    uint64_t value;
+    if (params && sgl_get_query_object(ctx, id, pname, &value)) {
+        *params = (GLuint64)value;
+    }
+}
+
+GL_APICALL void GL_APIENTRY glGetInteger64vEXT(GLenum pname, GLint64 *params) {
+    GET_CTX();
+
+    if (!params) return;
+    if (pname != GL_TIMESTAMP_EXT) {
+        /* Single-valued state only; room for the widest glGetIntegerv result */
+        GLint values[64] = {0};
+        glGetIntegerv(pname, values);
+        *params = values[0];
+        return;
+    }
+
+    /* Synchronous: drains the GPU queue, prefer glQueryCounterEXT per frame */
+    *params = 0;
+    if (ctx->recorder) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+    if (ctx->backend && ctx->backend->ops && ctx->backend->ops->get_gpu_timestamp) {
+        sgl_ensure_frame_ready();
+        *params = (GLint64)ctx->backend->ops->get_gpu_timestamp(ctx->backend);
+    }
+}
+
+/* ============================================================================
+ * Conditional Rendering (SwitchGLES extension)
+ * ============================================================================ */
+
+/* Newest finished result of a query, without waiting */
+static bool sgl_query_last_result(sgl_context_t *ctx, sgl_query_t *q, uint64_t *result) {
+    if (q->backend_handle == 0 || !ctx->backend || !ctx->backend->ops ||
+        !ctx->backend->ops->get_last_query_result) {
+        return false;
+    }
+    return ctx->backend->ops->get_last_query_result(ctx->backend, q->backend_handle, result);
+}
+
+GL_APICALL GLboolean GL_APIENTRY sglGetQueryLastResult(GLuint id, GLuint64 *result) {
+    GET_CTX_RET(GL_FALSE);
+
+    sgl_query_t *q = GET_QUERY(id);
+    if (!q || !q->begun_once || ctx->recorder) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return GL_FALSE;
+    }
+
+    uint64_t value;
+    if (!sgl_query_last_result(ctx, q, &value)) return GL_FALSE;
+    if (result) *result = (GLuint64)value;
+    return GL_TRUE;
+}
+
+GL_APICALL void GL_APIENTRY sglBeginConditionalRender(GLuint id) {
+    GET_CTX();
+
+    sgl_query_t *q = GET_QUERY(id);
+    if (!q || !q->begun_once || !sgl_query_is_occlusion(q) ||
+        ctx->conditional_query != 0 || ctx->recorder) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+
+    /* Decided once, from whatever result is already there: no result yet draws */
+    uint64_t samples;
+    ctx->conditional_query = id;
+    ctx->conditional_skip = sgl_query_last_result(ctx, q, &samples) && samples == 0;
+
+    SGL_TRACE_CORE("sglBeginConditionalRender(%u) skip=%d", id, ctx->conditional_skip);
+}
+
+GL_APICALL void GL_APIENTRY sglEndConditionalRender(void) {
+    GET_CTX();
+
+    if (ctx->conditional_query == 0 || ctx->recorder) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+    ctx->conditional_query = 0;
+    ctx->conditional_skip = false;
+
+    SGL_TRACE_CORE("sglEndConditionalRender()");
+}
@@ -0,0 +1,510 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * GL Layer - Command Recorders (sglCreateRecorder)
+ *
+ * A recorder lets a worker thread issue GL draw calls into a command list
+ * of its own. sglBeginRecorder snapshots the GL thread's context into the
+ * recorder; the worker makes that copy current for itself and records.
+ * The copy shares the resource manager with the GL thread, so objects are
+ * read-only while recording. Programs are the exception: uniform writes
+ * land in a per-recorder clone made on first use.
+ *
+ * Command lists (sglBeginCommandList) use the same machinery on the GL
+ * thread: the context copy is current until sglEndCommandList, and the
+ * backend keeps what was recorded for any number of sglCallCommandList.
+ * State changes while recording only affect the list, uniforms are
+ * captured by value. Each draw notes the buffers, textures and program it
+ * used with their revisions; a call finding any of them deleted or
+ * re-specified since does nothing and returns GL_FALSE.
+ *
+ * IMPORTANT: This file must NOT include deko3d.h or use any dk*() calls!
+ * All GPU operations go through ctx->backend->ops->xxx()
+ */
+
+#include "gl_common.h"
+#include <GLES2/gl2sgl.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SGL_MAX_RECORDERS           8
+#define SGL_RECORDER_MAX_PROGRAMS   16   /* Distinct programs one recording can use */
+
+/* Object a command list was recorded with */
+enum { SGL_LIST_REF_BUFFER, SGL_LIST_REF_TEXTURE, SGL_LIST_REF_PROGRAM };
+
+typedef struct sgl_list_ref {
+    uint32_t kind;              /* SGL_LIST_REF_* */
+    GLuint id;
+    uint32_t revision;          /* Object revision while recording */
+} sgl_list_ref_t;
+
+typedef struct sgl_command_list {
+    bool used;
+    sgl_context_t *owner;       /* Context that recorded it */
+    sgl_handle_t handle;        /* Backend command list */
+    sgl_list_ref_t *refs;
+    int num_refs;
+    int ref_capacity;
+    bool refs_lost;             /* A reference could not be stored: never valid */
+} sgl_command_list_t;
+
+struct sgl_recorder {
+    bool used;
+    sgl_context_t *owner;       /* Context that created it */
+    sgl_handle_t handle;        /* Backend recorder */
+    sgl_context_t ctx;          /* Context copy made current on the worker */
+    GLuint program_ids[SGL_RECORDER_MAX_PROGRAMS];
+    sgl_program_t *programs[SGL_RECORDER_MAX_PROGRAMS];  /* Kept across recordings */
+    int num_programs;           /* Clones valid in the current recording */
+    sgl_command_list_t *list;   /* Command list being recorded, NULL for worker recorders */
+};
+
+static sgl_recorder_t s_recorders[SGL_MAX_RECORDERS];
+static sgl_recorder_t s_list_recorder;     /* Records every command list in turn */
+static sgl_table_t s_command_lists;         /* sgl_command_list_t by name */
+
+static sgl_recorder_t *sgl_recorder_get(sgl_context_t *ctx, GLuint id) {
+    if (id == 0 || id > SGL_MAX_RECORDERS) return NULL;
+    sgl_recorder_t *r = &s_recorders[id - 1];
+    return (r->used && r->owner == ctx) ? r : NULL;
+}
+
+/* ============================================================================
+ * Program Clones
+ * ============================================================================ */
+
+/* Legacy bindings point into the GL thread's uniform arena; give each valid
+ * one a slot in the recorder's arena holding its first element */
+static void sgl_recorder_rebind_uniforms(sgl_context_t *ctx, sgl_uniform_binding_t *uniforms) {
+    for (int i = 0; i < SGL_MAX_UNIFORMS; i++) {
+        sgl_uniform_binding_t *ub = &uniforms[i];
+        if (!ub->valid) continue;
+
+        ub->offset = ctx->backend->ops->alloc_uniform(ctx->backend, ub->size);
+        uint8_t data[64];
+        memset(data, 0, sizeof(data));
+        memcpy(data, ub->shadow, ub->shadow_size);
+        uint32_t size = ub->data_size < sizeof(data) ? ub->data_size : sizeof(data);
+        ctx->backend->ops->write_uniform(ctx->backend, ub->offset, data, size);
+        ub->dirty = true;
+    }
+}
+
+sgl_program_t *sgl_recorder_program(sgl_context_t *ctx, GLuint id) {
+    sgl_recorder_t *r = ctx->recorder;
+    for (int i = 0; i < r->num_programs; i++) {
+        if (r->program_ids[i] == id) return r->programs[i];
+    }
+
+    sgl_program_t *shared = sgl_res_mgr_get_program(ctx->res_mgr, id);
+    if (!shared) return NULL;
+    if (r->num_programs == SGL_RECORDER_MAX_PROGRAMS) {
+        SGL_ERROR_SHADER("recorder: more than %d programs in one recording", SGL_RECORDER_MAX_PROGRAMS);
+        return NULL;
+    }
+
+    int slot = r->num_programs;
+    if (!r->programs[slot]) {
+        r->programs[slot] = (sgl_program_t *)malloc(sizeof(sgl_program_t));
+        if (!r->programs[slot]) return NULL;
+    }
+    sgl_program_t *prog = r->programs[slot];
+    memcpy(prog, shared, sizeof(*prog));
+    prog->link_job = NULL;  /* Finished by sglBeginRecorder */
+
+    /* Every packed UBO is pushed in full by the recorder's first draw */
+    if (ctx->backend->ops->alloc_uniform && ctx->backend->ops->write_uniform) {
+        sgl_recorder_rebind_uniforms(ctx, prog->vertex_uniforms);
+        sgl_recorder_rebind_uniforms(ctx, prog->fragment_uniforms);
+    }
+
+    r->program_ids[slot] = id;
+    r->num_programs++;
+    return prog;
+}
+
+/* ============================================================================
+ * Recording Setup
+ * ============================================================================ */
+
+/* Everything a recording could otherwise end up doing on the GL thread's behalf */
+static void sgl_recorder_prepare(sgl_context_t *ctx) {
+    sgl_ensure_frame_ready();
+    for (GLuint id = 1; id < sgl_res_mgr_program_end(ctx->res_mgr); id++) {
+        sgl_program_t *prog = sgl_res_mgr_get_program(ctx->res_mgr, id);
+        if (prog && prog->link_job) {
+            sgl_program_finish_link(ctx, id, prog);
+        }
+    }
+    for (GLuint id = 1; id < sgl_res_mgr_texture_end(ctx->res_mgr); id++) {
+        sgl_texture_t *tex = GET_TEXTURE(id);
+        if (tex && tex->used) {
+            sgl_flush_texture_params(ctx, id, tex);
+        }
+    }
+}
+
+/* The recording starts from the GL thread's current state */
+static void sgl_recorder_snapshot(sgl_recorder_t *r, const sgl_context_t *ctx) {
+    memcpy(&r->ctx, ctx, sizeof(r->ctx));
+    r->ctx.recorder = r;
+    r->ctx.capture = NULL;  /* Recorded calls are not captured */
+    r->ctx.draw_sort = NULL;  /* Nor sorted */
+    r->ctx.pending_clear = 0;
+    r->ctx.error = GL_NO_ERROR;
+    r->ctx.dirty_state = SGL_DIRTY_ALL;
+    r->ctx.backend_state_generation = 0;
+    r->ctx.vertex_layout_dirty = true;
+    r->num_programs = 0;
+}
+
+/* ============================================================================
+ * Recorder API
+ * ============================================================================ */
+
+GL_APICALL GLuint GL_APIENTRY sglCreateRecorder(void) {
+    GET_CTX_RET(0);
+    CHECK_BACKEND_RET(0);
+
+    if (ctx->recorder) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return 0;
+    }
+    if (!ctx->backend->ops->create_recorder) return 0;
+
+    int index = 0;
+    while (index < SGL_MAX_RECORDERS && s_recorders[index].used) index++;
+    if (index == SGL_MAX_RECORDERS) {
+        sgl_set_error(ctx, GL_OUT_OF_MEMORY);
+        return 0;
+    }
+
+    sgl_handle_t handle = ctx->backend->ops->create_recorder(ctx->backend);
+    if (handle == 0) {
+        sgl_set_error(ctx, GL_OUT_OF_MEMORY);
+        return 0;
+    }
+
+    sgl_recorder_t *r = &s_recorders[index];
+    memset(r, 0, sizeof(*r));
+    r->used = true;
+    r->owner = ctx;
+    r->handle = handle;
+
+    SGL_TRACE_CORE("sglCreateRecorder() -> %d", index + 1);
+    return (GLuint)(index + 1);
+}
+
+GL_APICALL void GL_APIENTRY sglDeleteRecorder(GLuint recorder) {
+    GET_CTX();
+    CHECK_BACKEND();
+
+    if (ctx->recorder) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+    sgl_recorder_t *r = sgl_recorder_get(ctx, recorder);
+    if (!r) return;
+
+    if (ctx->backend->ops->delete_recorder) {
+        ctx->backend->ops->delete_recorder(ctx->backend, r->handle);
+    }
+    for (int i = 0; i < SGL_RECORDER_MAX_PROGRAMS; i++) {
+        free(r->programs[i]);
+    }
+    memset(r, 0, sizeof(*r));
+
+    SGL_TRACE_CORE("sglDeleteRecorder(%u)", recorder);
+}
+
+GL_APICALL GLboolean GL_APIENTRY sglBeginRecorder(GLuint recorder) {
+    GET_CTX_RET(GL_FALSE);
+    CHECK_BACKEND_RET(GL_FALSE);
+    sgl_flush_deferred(ctx);
+
+    if (ctx->recorder) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return GL_FALSE;
+    }
+    sgl_recorder_t *r = sgl_recorder_get(ctx, recorder);
+    if (!r) {
+        sgl_set_error(ctx, GL_INVALID_VALUE);
+        return GL_FALSE;
+    }
+    if (!ctx->backend->ops->begin_recorder) return GL_FALSE;
+
+    sgl_recorder_prepare(ctx);
+    if (!ctx->backend->ops->begin_recorder(ctx->backend, r->handle)) {
+        return GL_FALSE;
+    }
+    sgl_recorder_snapshot(r, ctx);
+
+    SGL_TRACE_CORE("sglBeginRecorder(%u)", recorder);
+    return GL_TRUE;
+}
+
+GL_APICALL void GL_APIENTRY sglRecorderMakeCurrent(GLuint recorder) {
+    /* The GL thread's context owns the recorders, even when called from a worker */
+    sgl_set_thread_context(NULL);
+    GET_CTX();
+    CHECK_BACKEND();
+
+    sgl_recorder_t *r = NULL;
+    if (recorder != 0) {
+        r = sgl_recorder_get(ctx, recorder);
+        if (!r) {
+            sgl_set_error(ctx, GL_INVALID_VALUE);
+            return;
+        }
+    }
+
+    if (ctx->backend->ops->attach_recorder) {
+        ctx->backend->ops->attach_recorder(ctx->backend, r ? r->handle : 0);
+    }
+    sgl_set_thread_context(r ? &r->ctx : NULL);
+
+    SGL_TRACE_CORE("sglRecorderMakeCurrent(%u)", recorder);
+}
+
+GL_APICALL void GL_APIENTRY sglSubmitRecorders(GLsizei count, const GLuint *recorders) {
+    GET_CTX();
+    CHECK_BACKEND();
+    sgl_flush_deferred(ctx);
+
+    if (ctx->recorder) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+    if (count < 0) {
+        sgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    if (count == 0 || !recorders || !ctx->backend->ops->submit_recorders) return;
+
+    sgl_handle_t handles[SGL_MAX_RECORDERS];
+    int num = 0;
+    for (GLsizei i = 0; i < count && num < SGL_MAX_RECORDERS; i++) {
+        sgl_recorder_t *r = sgl_recorder_get(ctx, recorders[i]);
+        if (!r) {
+            sgl_set_error(ctx, GL_INVALID_VALUE);
+            return;
+        }
+        handles[num++] = r->handle;
+    }
+
+    ctx->backend->ops->submit_recorders(ctx->backend, handles, num);
+
+    /* The recorders changed the GPU state under us */
+    sgl_context_invalidate_state(ctx);
+
+    SGL_TRACE_CORE("sglSubmitRecorders(%d)", count);
+}
+
+/* ============================================================================
+ * Command Lists
+ * ============================================================================ */
+
+static sgl_command_list_t *sgl_command_list_get(sgl_context_t *ctx, GLuint name) {
+    if (name == 0 || s_command_lists.item_size == 0) return NULL;
+    sgl_command_list_t *list = (sgl_command_list_t *)sgl_table_get(&s_command_lists, name);
+    return (list && list->used && list->owner == ctx) ? list : NULL;
+}
+
+static void sgl_command_list_free(sgl_context_t *ctx, GLuint name, sgl_command_list_t *list) {
+    if (ctx->backend->ops->delete_cmdlist) {
+        ctx->backend->ops->delete_cmdlist(ctx->backend, list->handle);
+    }
+    free(list->refs);
+    memset(list, 0, sizeof(*list));
+    sgl_table_release(&s_command_lists, name);
+}
+
+static void sgl_command_list_ref(sgl_command_list_t *list, uint32_t kind, GLuint id, uint32_t revision) {
+    for (int i = 0; i < list->num_refs; i++) {
+        if (list->refs[i].kind == kind && list->refs[i].id == id) return;
+    }
+    if (list->num_refs == list->ref_capacity) {
+        int capacity = list->ref_capacity ? list->ref_capacity * 2 : 16;
+        sgl_list_ref_t *refs = (sgl_list_ref_t *)realloc(list->refs, (size_t)capacity * sizeof(*refs));
+        if (!refs) {
+            list->refs_lost = true;
+            return;
+        }
+        list->refs = refs;
+        list->ref_capacity = capacity;
+    }
+    sgl_list_ref_t *ref = &list->refs[list->num_refs++];
+    ref->kind = kind;
+    ref->id = id;
+    ref->revision = revision;
+}
+
+void sgl_recorder_note_draw(sgl_context_t *ctx) {
+    sgl_command_list_t *list = ctx->recorder->list;
+    if (!list) return;
+
+    sgl_program_t *prog = sgl_res_mgr_get_program(ctx->res_mgr, ctx->current_program);
+    if (prog) {
+        sgl_command_list_ref(list, SGL_LIST_REF_PROGRAM, ctx->current_program, prog->revision);
+    }
+    for (GLuint unit = 0; unit < SGL_MAX_TEXTURE_UNITS; unit++) {
+        sgl_texture_t *tex = GET_TEXTURE(ctx->bound_textures[unit]);
+        if (tex) {
+            sgl_command_list_ref(list, SGL_LIST_REF_TEXTURE, ctx->bound_textures[unit], tex->revision);
+        }
+    }
+    for (int i = 0; i < SGL_MAX_ATTRIBS; i++) {
+        const sgl_vertex_attrib_t *attr = &ctx->vertex_attribs[i];
+        sgl_buffer_t *buf = attr->enabled ? GET_BUFFER(attr->buffer) : NULL;
+        if (buf) {
+            sgl_command_list_ref(list, SGL_LIST_REF_BUFFER, attr->buffer, buf->revision);
+        }
+    }
+    sgl_buffer_t *ebo = GET_BUFFER(ctx->bound_element_buffer);
+    if (ebo) {
+        sgl_command_list_ref(list, SGL_LIST_REF_BUFFER, ctx->bound_element_buffer, ebo->revision);
+    }
+}
+
+/* Every object the list was recorded with still exists unchanged */
+static bool sgl_command_list_current(sgl_context_t *ctx, const sgl_command_list_t *list) {
+    if (list->refs_lost) return false;
+    for (int i = 0; i < list->num_refs; i++) {
+        const sgl_list_ref_t *ref = &list->refs[i];
+        uint32_t revision = 0;
+        if (ref->kind == SGL_LIST_REF_BUFFER) {
+            sgl_buffer_t *buf = GET_BUFFER(ref->id);
+            if (buf) revision = buf->revision;
+        } else if (ref->kind == SGL_LIST_REF_TEXTURE) {
+            sgl_texture_t *tex = GET_TEXTURE(ref->id);
+            if (tex) revision = tex->revision;
+        } else {
+            sgl_program_t *prog = sgl_res_mgr_get_program(ctx->res_mgr, ref->id);
+            if (prog && prog->linked) revision = prog->revision;
+        }
+        if (revision != ref->revision) return false;
+    }
+    return true;
+}
+
+GL_APICALL GLuint GL_APIENTRY sglBeginCommandList(void) {
+    GET_CTX_RET(0);
+    CHECK_BACKEND_RET(0);
+    sgl_flush_deferred(ctx);
+
+    if (ctx->recorder) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return 0;
+    }
+    if (!ctx->backend->ops->begin_cmdlist) return 0;
+
+    if (s_command_lists.item_size == 0) {
+        sgl_table_init(&s_command_lists, sizeof(sgl_command_list_t));
+    }
+    GLuint name = sgl_table_alloc(&s_command_lists);
+    sgl_command_list_t *list = name ? (sgl_command_list_t *)sgl_table_get(&s_command_lists, name) : NULL;
+    if (!list) {
+        if (name) sgl_table_release(&s_command_lists, name);
+        sgl_set_error(ctx, GL_OUT_OF_MEMORY);
+        return 0;
+    }
+
+    sgl_recorder_prepare(ctx);
+    sgl_handle_t handle = ctx->backend->ops->begin_cmdlist(ctx->backend);
+    if (handle == 0) {
+        sgl_table_release(&s_command_lists, name);
+        sgl_set_error(ctx, GL_OUT_OF_MEMORY);
+        return 0;
+    }
+
+    memset(list, 0, sizeof(*list));
+    list->used = true;
+    list->owner = ctx;
+    list->handle = handle;
+
+    sgl_recorder_t *r = &s_list_recorder;
+    sgl_recorder_snapshot(r, ctx);
+    r->list = list;
+    sgl_set_thread_context(&r->ctx);
+
+    SGL_TRACE_CORE("sglBeginCommandList() -> %u", name);
+    return name;
+}
+
+GL_APICALL GLboolean GL_APIENTRY sglEndCommandList(void) {
+    GET_CTX_RET(GL_FALSE);
+    CHECK_BACKEND_RET(GL_FALSE);
+
+    sgl_recorder_t *r = ctx->recorder;
+    if (!r || !r->list) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return GL_FALSE;
+    }
+
+    sgl_command_list_t *list = r->list;
+    sgl_context_t *owner = list->owner;
+    bool ok = ctx->backend->ops->end_cmdlist &&
+              ctx->backend->ops->end_cmdlist(ctx->backend, list->handle);
+    r->list = NULL;
+    sgl_set_thread_context(NULL);
+
+    /* Errors raised while recording belong to the application's context */
+    sgl_set_error(owner, r->ctx.error);
+
+    /* The list keeps its name until deleted, but never replays */
+    if (!ok) {
+        list->refs_lost = true;
+        sgl_set_error(owner, GL_OUT_OF_MEMORY);
+        return GL_FALSE;
+    }
+
+    SGL_TRACE_CORE("sglEndCommandList() - %d references", list->num_refs);
+    return GL_TRUE;
+}
+
+GL_APICALL GLboolean GL_APIENTRY sglCallCommandList(GLuint list) {
+    GET_CTX_RET(GL_FALSE);
+    CHECK_BACKEND_RET(GL_FALSE);
+    sgl_flush_deferred(ctx);
+
+    if (ctx->recorder) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return GL_FALSE;
+    }
+    sgl_command_list_t *l = sgl_command_list_get(ctx, list);
+    if (!l) {
+        sgl_set_error(ctx, GL_INVALID_VALUE);
+        return GL_FALSE;
+    }
+    if (!sgl_command_list_current(ctx, l) || !ctx->backend->ops->call_cmdlist) {
+        SGL_TRACE_CORE("sglCallCommandList(%u) - stale", list);
+        return GL_FALSE;
+    }
+
+    /* Occluded by sglBeginConditionalRender: the list's draws are skipped */
+    if (ctx->conditional_skip) return GL_TRUE;
+
+    sgl_ensure_frame_ready();
+    ctx->backend->ops->call_cmdlist(ctx->backend, l->handle);
+
+    /* The list changed the GPU state under us */
+    sgl_context_invalidate_state(ctx);
+
+    SGL_TRACE_CORE("sglCallCommandList(%u)", list);
+    return GL_TRUE;
+}
+
+GL_APICALL void GL_APIENTRY sglDeleteCommandList(GLuint list) {
+    GET_CTX();
+    CHECK_BACKEND();
+
+    if (ctx->recorder) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+    sgl_command_list_t *l = sgl_command_list_get(ctx, list);
+    if (!l) return;
+
+    sgl_command_list_free(ctx, list, l);
+    SGL_TRACE_CORE("sglDeleteCommandList(%u)", list);
+}
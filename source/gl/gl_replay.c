@@ -0,0 +1,594 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * GL Layer - Call Stream Replay (sglReplayOpen)
+ *
+ * Plays a trace written by sglBeginCapture (gl_capture.c) back through the
+ * public GL entry points of the current context, one frame per
+ * sglReplayFrame, timing every call on the CPU. Object names in the trace
+ * are those of the capturing context; the replay creates its own objects
+ * and keeps a map per object kind. Uniform locations are not mapped: the
+ * same program sources link to the same locations, which the recorded
+ * glGetUniformLocation results are checked against.
+ *
+ * IMPORTANT: This file must NOT include deko3d.h or use any dk*() calls!
+ * All GPU operations go through ctx->backend->ops->xxx()
+ */
+
+#define GL_GLEXT_PROTOTYPES
+#include "gl_common.h"
+#include "../util/sgl_pixel.h"
+#include <GLES2/gl2sgl.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SWITCH__
+#include <switch.h>
+#else
+#include <time.h>
+#endif
+
+/* Object kinds with a name map */
+enum {
+    SGL_REPLAY_BUFFER,
+    SGL_REPLAY_TEXTURE,
+    SGL_REPLAY_SHADER,
+    SGL_REPLAY_PROGRAM,
+    SGL_REPLAY_FRAMEBUFFER,
+    SGL_REPLAY_RENDERBUFFER,
+    SGL_REPLAY_VERTEX_ARRAY,
+    SGL_REPLAY_KIND_COUNT
+};
+
+typedef struct sgl_replay_names {
+    GLuint *map;                /* Captured name -> replay name, 0 = none */
+    uint32_t capacity;
+} sgl_replay_names_t;
+
+struct sgl_replay {
+    sgl_trace_t *trace;
+    sgl_replay_callback_t callback;
+    void *user;
+
+    GLuint frame;
+    bool finished;
+    sgl_replay_names_t names[SGL_REPLAY_KIND_COUNT];
+    GLuint array_buffer;        /* GL_ARRAY_BUFFER binding of the replay (captured name) */
+
+    void *client_arrays[SGL_MAX_ATTRIBS];  /* Copies of the recorded client array contents */
+    uint32_t client_sizes[SGL_MAX_ATTRIBS];
+    void *scratch;              /* Name lists and glReadPixels destinations */
+    uint32_t scratch_size;
+
+    GLuint location_mismatches;
+    bool unknown_warned;
+};
+
+static uint64_t sgl_replay_now_ns(void) {
+#ifdef __SWITCH__
+    return armTicksToNs(armGetSystemTick());
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static inline GLfloat sgl_replay_float(uint32_t word) {
+    GLfloat f;
+    memcpy(&f, &word, sizeof(f));
+    return f;
+}
+
+/* Grow a buffer to at least size bytes; false (buffer unchanged) on failure */
+static bool sgl_replay_reserve(void **buf, uint32_t *capacity, uint32_t size) {
+    if (size <= *capacity) return true;
+    uint32_t grown = *capacity ? *capacity : 4096;
+    while (grown < size) grown = grown * 2 > grown ? grown * 2 : size;
+    void *p = realloc(*buf, grown);
+    if (!p) return false;
+    *buf = p;
+    *capacity = grown;
+    return true;
+}
+
+static void *sgl_replay_scratch(sgl_replay_t *r, uint32_t size) {
+    return sgl_replay_reserve(&r->scratch, &r->scratch_size, size) ? r->scratch : NULL;
+}
+
+/* ============================================================================
+ * Name Maps
+ * ============================================================================ */
+
+static void sgl_replay_set_name(sgl_replay_t *r, int kind, GLuint captured, GLuint name) {
+    sgl_replay_names_t *names = &r->names[kind];
+    if (captured == 0) return;
+    if (captured >= names->capacity) {
+        uint32_t capacity = names->capacity ? names->capacity : 64;
+        while (capacity <= captured) capacity *= 2;
+        GLuint *map = (GLuint *)realloc(names->map, capacity * sizeof(GLuint));
+        if (!map) return;
+        memset(map + names->capacity, 0, (capacity - names->capacity) * sizeof(GLuint));
+        names->map = map;
+        names->capacity = capacity;
+    }
+    names->map[captured] = name;
+}
+
+static void sgl_replay_gen(int kind, GLsizei n, GLuint *out) {
+    switch (kind) {
+        case SGL_REPLAY_BUFFER:       glGenBuffers(n, out); break;
+        case SGL_REPLAY_TEXTURE:      glGenTextures(n, out); break;
+        case SGL_REPLAY_FRAMEBUFFER:  glGenFramebuffers(n, out); break;
+        case SGL_REPLAY_RENDERBUFFER: glGenRenderbuffers(n, out); break;
+        case SGL_REPLAY_VERTEX_ARRAY: glGenVertexArraysOES(n, out); break;
+        default: memset(out, 0, (size_t)n * sizeof(GLuint)); break;
+    }
+}
+
+static void sgl_replay_delete(int kind, GLsizei n, const GLuint *names) {
+    switch (kind) {
+        case SGL_REPLAY_BUFFER:       glDeleteBuffers(n, names); break;
+        case SGL_REPLAY_TEXTURE:      glDeleteTextures(n, names); break;
+        case SGL_REPLAY_FRAMEBUFFER:  glDeleteFramebuffers(n, names); break;
+        case SGL_REPLAY_RENDERBUFFER: glDeleteRenderbuffers(n, names); break;
+        case SGL_REPLAY_VERTEX_ARRAY: glDeleteVertexArraysOES(n, names); break;
+        case SGL_REPLAY_SHADER:
+            for (GLsizei i = 0; i < n; i++) glDeleteShader(names[i]);
+            break;
+        case SGL_REPLAY_PROGRAM:
+            for (GLsizei i = 0; i < n; i++) glDeleteProgram(names[i]);
+            break;
+    }
+}
+
+/* Replay name of a captured one. GLES2 lets a bind create a name that was
+ * never generated; such names get an object of their own here too. */
+static GLuint sgl_replay_name(sgl_replay_t *r, int kind, GLuint captured) {
+    if (captured == 0) return 0;
+    const sgl_replay_names_t *names = &r->names[kind];
+    if (captured < names->capacity && names->map[captured]) return names->map[captured];
+    if (kind == SGL_REPLAY_SHADER || kind == SGL_REPLAY_PROGRAM) return 0;
+
+    GLuint name = 0;
+    sgl_replay_gen(kind, 1, &name);
+    sgl_replay_set_name(r, kind, captured, name);
+    return name;
+}
+
+static void sgl_replay_gen_names(sgl_replay_t *r, int kind, const sgl_trace_record_t *rec) {
+    GLsizei n = (GLsizei)rec->args[0];
+    if (n <= 0 || rec->blob_size < (uint32_t)n * 4) return;
+    GLuint *names = (GLuint *)sgl_replay_scratch(r, (uint32_t)n * 4);
+    if (!names) return;
+
+    sgl_replay_gen(kind, n, names);
+    const GLuint *captured = (const GLuint *)rec->blob;
+    for (GLsizei i = 0; i < n; i++) sgl_replay_set_name(r, kind, captured[i], names[i]);
+}
+
+static void sgl_replay_delete_names(sgl_replay_t *r, int kind, const sgl_trace_record_t *rec) {
+    GLsizei n = (GLsizei)rec->args[0];
+    if (n <= 0 || rec->blob_size < (uint32_t)n * 4) return;
+    GLuint *names = (GLuint *)sgl_replay_scratch(r, (uint32_t)n * 4);
+    if (!names) return;
+
+    const GLuint *captured = (const GLuint *)rec->blob;
+    GLsizei count = 0;
+    for (GLsizei i = 0; i < n; i++) {
+        const sgl_replay_names_t *map = &r->names[kind];
+        if (captured[i] == 0 || captured[i] >= map->capacity || !map->map[captured[i]]) continue;
+        names[count++] = map->map[captured[i]];
+        map->map[captured[i]] = 0;
+    }
+    if (count > 0) sgl_replay_delete(kind, count, names);
+}
+
+/* ============================================================================
+ * Calls
+ * ============================================================================ */
+
+/* Client arrays are given to GL from the replay's copy of the recorded
+ * contents, with no array buffer bound while the pointer is set */
+static void sgl_replay_client_array(sgl_replay_t *r, const sgl_trace_record_t *rec) {
+    GLuint index = rec->args[0];
+    if (index >= SGL_MAX_ATTRIBS) return;
+    if (!sgl_replay_reserve(&r->client_arrays[index], &r->client_sizes[index], rec->blob_size)) return;
+    if (rec->blob_size) memcpy(r->client_arrays[index], rec->blob, rec->blob_size);
+
+    if (r->array_buffer) glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glVertexAttribPointer(index, (GLint)rec->args[1], rec->args[2], (GLboolean)rec->args[3],
+                          (GLsizei)rec->args[4], r->client_arrays[index]);
+    if (r->array_buffer) {
+        glBindBuffer(GL_ARRAY_BUFFER, sgl_replay_name(r, SGL_REPLAY_BUFFER, r->array_buffer));
+    }
+}
+
+static void sgl_replay_uniform(const sgl_trace_record_t *rec) {
+    GLint location = (GLint)rec->args[0];
+    GLsizei count = (GLsizei)rec->args[2];
+    if (rec->blob_size < (uint32_t)count * rec->args[1] * 4) return;
+
+    if (rec->op == SGL_TRACE_UNIFORMFV) {
+        const GLfloat *v = (const GLfloat *)rec->blob;
+        switch (rec->args[1]) {
+            case 1: glUniform1fv(location, count, v); break;
+            case 2: glUniform2fv(location, count, v); break;
+            case 3: glUniform3fv(location, count, v); break;
+            case 4: glUniform4fv(location, count, v); break;
+        }
+    } else {
+        const GLint *v = (const GLint *)rec->blob;
+        switch (rec->args[1]) {
+            case 1: glUniform1iv(location, count, v); break;
+            case 2: glUniform2iv(location, count, v); break;
+            case 3: glUniform3iv(location, count, v); break;
+            case 4: glUniform4iv(location, count, v); break;
+        }
+    }
+}
+
+static void sgl_replay_uniform_matrix(const sgl_trace_record_t *rec) {
+    GLint location = (GLint)rec->args[0];
+    GLuint dim = rec->args[1];
+    GLsizei count = (GLsizei)rec->args[2];
+    GLboolean transpose = (GLboolean)rec->args[3];
+    if (rec->blob_size < (uint32_t)count * dim * dim * 4) return;
+
+    const GLfloat *v = (const GLfloat *)rec->blob;
+    switch (dim) {
+        case 2: glUniformMatrix2fv(location, count, transpose, v); break;
+        case 3: glUniformMatrix3fv(location, count, transpose, v); break;
+        case 4: glUniformMatrix4fv(location, count, transpose, v); break;
+    }
+}
+
+static void sgl_replay_uniform_location(sgl_replay_t *r, const sgl_trace_record_t *rec) {
+    const GLchar *name = (const GLchar *)rec->blob;
+    if (!name || rec->blob_size == 0 || name[rec->blob_size - 1] != '\0') return;
+
+    GLint location = glGetUniformLocation(sgl_replay_name(r, SGL_REPLAY_PROGRAM, rec->args[0]), name);
+    if (location != (GLint)rec->args[1]) {
+        if (r->location_mismatches++ == 0) {
+            SGL_WARN(SGL_LOG_CAT_CORE, "[CORE] Replay: uniform %s is at %d, captured at %d",
+                     name, location, (GLint)rec->args[1]);
+        }
+    }
+}
+
+static void sgl_replay_read_pixels(sgl_replay_t *r, const sgl_trace_record_t *rec) {
+    GLsizei width = (GLsizei)rec->args[2];
+    GLsizei height = (GLsizei)rec->args[3];
+    GLenum format = rec->args[4];
+    GLenum type = rec->args[5];
+    void *pixels;
+
+    if (rec->args[7]) {
+        /* Into the pixel pack buffer, at the captured offset */
+        pixels = (void *)(uintptr_t)rec->args[6];
+    } else {
+        if (width <= 0 || height <= 0) return;
+        /* Rows padded to the largest pack alignment fit any alignment */
+        uint32_t stride = sgl_pixel_unpack_stride((uint32_t)width, format, type, 8);
+        if (stride == 0) return;
+        pixels = sgl_replay_scratch(r, stride * (uint32_t)height);
+        if (!pixels) return;
+    }
+    glReadPixels((GLint)rec->args[0], (GLint)rec->args[1], width, height, format, type, pixels);
+}
+
+/* Issue one recorded call. Arguments are listed per opcode as captured. */
+static void sgl_replay_call(sgl_replay_t *r, const sgl_trace_record_t *rec) {
+    const uint32_t *a = rec->args;
+
+    switch (rec->op) {
+        case SGL_TRACE_SWAP: break;     /* The caller presents */
+
+        /* State */
+        case SGL_TRACE_ENABLE:                  glEnable(a[0]); break;
+        case SGL_TRACE_DISABLE:                 glDisable(a[0]); break;
+        case SGL_TRACE_DEPTH_FUNC:              glDepthFunc(a[0]); break;
+        case SGL_TRACE_DEPTH_MASK:              glDepthMask((GLboolean)a[0]); break;
+        case SGL_TRACE_DEPTH_RANGEF:            glDepthRangef(sgl_replay_float(a[0]), sgl_replay_float(a[1])); break;
+        case SGL_TRACE_BLEND_FUNC:              glBlendFunc(a[0], a[1]); break;
+        case SGL_TRACE_BLEND_FUNC_SEPARATE:     glBlendFuncSeparate(a[0], a[1], a[2], a[3]); break;
+        case SGL_TRACE_BLEND_EQUATION:          glBlendEquation(a[0]); break;
+        case SGL_TRACE_BLEND_EQUATION_SEPARATE: glBlendEquationSeparate(a[0], a[1]); break;
+        case SGL_TRACE_BLEND_COLOR:
+            glBlendColor(sgl_replay_float(a[0]), sgl_replay_float(a[1]),
+                         sgl_replay_float(a[2]), sgl_replay_float(a[3]));
+            break;
+        case SGL_TRACE_CULL_FACE:               glCullFace(a[0]); break;
+        case SGL_TRACE_FRONT_FACE:              glFrontFace(a[0]); break;
+        case SGL_TRACE_COLOR_MASK:
+            glColorMask((GLboolean)a[0], (GLboolean)a[1], (GLboolean)a[2], (GLboolean)a[3]);
+            break;
+        case SGL_TRACE_STENCIL_FUNC_SEPARATE:   glStencilFuncSeparate(a[0], a[1], (GLint)a[2], a[3]); break;
+        case SGL_TRACE_STENCIL_MASK_SEPARATE:   glStencilMaskSeparate(a[0], a[1]); break;
+        case SGL_TRACE_STENCIL_OP_SEPARATE:     glStencilOpSeparate(a[0], a[1], a[2], a[3]); break;
+        case SGL_TRACE_VIEWPORT:
+            glViewport((GLint)a[0], (GLint)a[1], (GLsizei)a[2], (GLsizei)a[3]);
+            break;
+        case SGL_TRACE_SCISSOR:
+            glScissor((GLint)a[0], (GLint)a[1], (GLsizei)a[2], (GLsizei)a[3]);
+            break;
+        case SGL_TRACE_LINE_WIDTH:              glLineWidth(sgl_replay_float(a[0])); break;
+        case SGL_TRACE_POLYGON_OFFSET:          glPolygonOffset(sgl_replay_float(a[0]), sgl_replay_float(a[1])); break;
+        case SGL_TRACE_PIXEL_STOREI:            glPixelStorei(a[0], (GLint)a[1]); break;
+
+        /* Clears and synchronization */
+        case SGL_TRACE_CLEAR_COLOR:
+            glClearColor(sgl_replay_float(a[0]), sgl_replay_float(a[1]),
+                         sgl_replay_float(a[2]), sgl_replay_float(a[3]));
+            break;
+        case SGL_TRACE_CLEAR_DEPTHF:            glClearDepthf(sgl_replay_float(a[0])); break;
+        case SGL_TRACE_CLEAR_STENCIL:           glClearStencil((GLint)a[0]); break;
+        case SGL_TRACE_CLEAR:                   glClear(a[0]); break;
+        case SGL_TRACE_FLUSH:                   glFlush(); break;
+        case SGL_TRACE_FINISH:                  glFinish(); break;
+
+        /* Buffers: n + names blob; target, name; target, size, usage + data;
+         * target, offset, size + data */
+        case SGL_TRACE_GEN_BUFFERS:             sgl_replay_gen_names(r, SGL_REPLAY_BUFFER, rec); break;
+        case SGL_TRACE_DELETE_BUFFERS:          sgl_replay_delete_names(r, SGL_REPLAY_BUFFER, rec); break;
+        case SGL_TRACE_BIND_BUFFER:
+            if (a[0] == GL_ARRAY_BUFFER) r->array_buffer = a[1];
+            glBindBuffer(a[0], sgl_replay_name(r, SGL_REPLAY_BUFFER, a[1]));
+            break;
+        case SGL_TRACE_BUFFER_DATA:             glBufferData(a[0], (GLsizeiptr)a[1], rec->blob, a[2]); break;
+        case SGL_TRACE_BUFFER_SUB_DATA:
+            if (rec->blob) glBufferSubData(a[0], (GLintptr)a[1], (GLsizeiptr)a[2], rec->blob);
+            break;
+
+        /* Textures: the image calls carry their glTexImage2D-style arguments
+         * in order, with the pixels as the blob */
+        case SGL_TRACE_GEN_TEXTURES:            sgl_replay_gen_names(r, SGL_REPLAY_TEXTURE, rec); break;
+        case SGL_TRACE_DELETE_TEXTURES:         sgl_replay_delete_names(r, SGL_REPLAY_TEXTURE, rec); break;
+        case SGL_TRACE_ACTIVE_TEXTURE:          glActiveTexture(a[0]); break;
+        case SGL_TRACE_BIND_TEXTURE:            glBindTexture(a[0], sgl_replay_name(r, SGL_REPLAY_TEXTURE, a[1])); break;
+        case SGL_TRACE_TEX_IMAGE_2D:
+            glTexImage2D(a[0], (GLint)a[1], (GLint)a[2], (GLsizei)a[3], (GLsizei)a[4], (GLint)a[5],
+                         a[6], a[7], rec->blob);
+            break;
+        case SGL_TRACE_TEX_SUB_IMAGE_2D:
+            glTexSubImage2D(a[0], (GLint)a[1], (GLint)a[2], (GLint)a[3], (GLsizei)a[4], (GLsizei)a[5],
+                            a[6], a[7], rec->blob);
+            break;
+        case SGL_TRACE_COMPRESSED_TEX_IMAGE_2D:
+            glCompressedTexImage2D(a[0], (GLint)a[1], a[2], (GLsizei)a[3], (GLsizei)a[4], (GLint)a[5],
+                                   (GLsizei)a[6], rec->blob);
+            break;
+        case SGL_TRACE_COMPRESSED_TEX_SUB_IMAGE_2D:
+            glCompressedTexSubImage2D(a[0], (GLint)a[1], (GLint)a[2], (GLint)a[3], (GLsizei)a[4],
+                                      (GLsizei)a[5], a[6], (GLsizei)a[7], rec->blob);
+            break;
+        case SGL_TRACE_COPY_TEX_IMAGE_2D:
+            glCopyTexImage2D(a[0], (GLint)a[1], a[2], (GLint)a[3], (GLint)a[4], (GLsizei)a[5],
+                             (GLsizei)a[6], (GLint)a[7]);
+            break;
+        case SGL_TRACE_COPY_TEX_SUB_IMAGE_2D:
+            glCopyTexSubImage2D(a[0], (GLint)a[1], (GLint)a[2], (GLint)a[3], (GLint)a[4], (GLint)a[5],
+                                (GLsizei)a[6], (GLsizei)a[7]);
+            break;
+        case SGL_TRACE_TEX_PARAMETERI:          glTexParameteri(a[0], a[1], (GLint)a[2]); break;
+        case SGL_TRACE_GENERATE_MIPMAP:         glGenerateMipmap(a[0]); break;
+
+        /* Shaders and programs: objects are created with the captured name
+         * as the last argument; sources and names are blobs */
+        case SGL_TRACE_CREATE_SHADER:
+            sgl_replay_set_name(r, SGL_REPLAY_SHADER, a[1], glCreateShader(a[0]));
+            break;
+        case SGL_TRACE_DELETE_SHADER:
+        case SGL_TRACE_DELETE_PROGRAM: {
+            int kind = rec->op == SGL_TRACE_DELETE_SHADER ? SGL_REPLAY_SHADER : SGL_REPLAY_PROGRAM;
+            GLuint name = sgl_replay_name(r, kind, a[0]);
+            if (name) sgl_replay_delete(kind, 1, &name);
+            sgl_replay_set_name(r, kind, a[0], 0);
+            break;
+        }
+        case SGL_TRACE_SHADER_SOURCE: {
+            const GLchar *source = (const GLchar *)rec->blob;
+            GLint length = (GLint)rec->blob_size;
+            glShaderSource(sgl_replay_name(r, SGL_REPLAY_SHADER, a[0]), 1, &source, &length);
+            break;
+        }
+        case SGL_TRACE_COMPILE_SHADER:          glCompileShader(sgl_replay_name(r, SGL_REPLAY_SHADER, a[0])); break;
+        case SGL_TRACE_CREATE_PROGRAM:
+            sgl_replay_set_name(r, SGL_REPLAY_PROGRAM, a[0], glCreateProgram());
+            break;
+        case SGL_TRACE_ATTACH_SHADER:
+            glAttachShader(sgl_replay_name(r, SGL_REPLAY_PROGRAM, a[0]),
+                           sgl_replay_name(r, SGL_REPLAY_SHADER, a[1]));
+            break;
+        case SGL_TRACE_BIND_ATTRIB_LOCATION:
+            if (rec->blob_size && ((const GLchar *)rec->blob)[rec->blob_size - 1] == '\0') {
+                glBindAttribLocation(sgl_replay_name(r, SGL_REPLAY_PROGRAM, a[0]), a[1],
+                                     (const GLchar *)rec->blob);
+            }
+            break;
+        case SGL_TRACE_LINK_PROGRAM:            glLinkProgram(sgl_replay_name(r, SGL_REPLAY_PROGRAM, a[0])); break;
+        case SGL_TRACE_USE_PROGRAM:             glUseProgram(sgl_replay_name(r, SGL_REPLAY_PROGRAM, a[0])); break;
+        case SGL_TRACE_GET_UNIFORM_LOCATION:    sgl_replay_uniform_location(r, rec); break;
+        /* location, components, count + values */
+        case SGL_TRACE_UNIFORMFV:
+        case SGL_TRACE_UNIFORMIV:               sgl_replay_uniform(rec); break;
+        /* location, dimension, count, transpose + values */
+        case SGL_TRACE_UNIFORM_MATRIXFV:        sgl_replay_uniform_matrix(rec); break;
+
+        /* Vertex input */
+        case SGL_TRACE_ENABLE_VERTEX_ATTRIB_ARRAY:  glEnableVertexAttribArray(a[0]); break;
+        case SGL_TRACE_DISABLE_VERTEX_ATTRIB_ARRAY: glDisableVertexAttribArray(a[0]); break;
+        case SGL_TRACE_VERTEX_ATTRIB_POINTER:
+            /* index, size, type, normalized, stride, offset, client. Client
+             * pointers are set by the CLIENT_ARRAY record of each draw. */
+            if (!a[6]) {
+                glVertexAttribPointer(a[0], (GLint)a[1], a[2], (GLboolean)a[3], (GLsizei)a[4],
+                                      (const void *)(uintptr_t)a[5]);
+            }
+            break;
+        case SGL_TRACE_VERTEX_ATTRIB_DIVISOR:   glVertexAttribDivisorANGLE(a[0], a[1]); break;
+        case SGL_TRACE_VERTEX_ATTRIB4F:
+            glVertexAttrib4f(a[0], sgl_replay_float(a[1]), sgl_replay_float(a[2]),
+                             sgl_replay_float(a[3]), sgl_replay_float(a[4]));
+            break;
+        case SGL_TRACE_CLIENT_ARRAY:            sgl_replay_client_array(r, rec); break;
+        case SGL_TRACE_GEN_VERTEX_ARRAYS:       sgl_replay_gen_names(r, SGL_REPLAY_VERTEX_ARRAY, rec); break;
+        case SGL_TRACE_DELETE_VERTEX_ARRAYS:    sgl_replay_delete_names(r, SGL_REPLAY_VERTEX_ARRAY, rec); break;
+        case SGL_TRACE_BIND_VERTEX_ARRAY:
+            glBindVertexArrayOES(sgl_replay_name(r, SGL_REPLAY_VERTEX_ARRAY, a[0]));
+            break;
+
+        /* Framebuffers */
+        case SGL_TRACE_GEN_FRAMEBUFFERS:        sgl_replay_gen_names(r, SGL_REPLAY_FRAMEBUFFER, rec); break;
+        case SGL_TRACE_DELETE_FRAMEBUFFERS:     sgl_replay_delete_names(r, SGL_REPLAY_FRAMEBUFFER, rec); break;
+        case SGL_TRACE_BIND_FRAMEBUFFER:
+            glBindFramebuffer(a[0], sgl_replay_name(r, SGL_REPLAY_FRAMEBUFFER, a[1]));
+            break;
+        case SGL_TRACE_FRAMEBUFFER_TEXTURE_2D:
+            glFramebufferTexture2D(a[0], a[1], a[2], sgl_replay_name(r, SGL_REPLAY_TEXTURE, a[3]), (GLint)a[4]);
+            break;
+        case SGL_TRACE_FRAMEBUFFER_RENDERBUFFER:
+            glFramebufferRenderbuffer(a[0], a[1], a[2], sgl_replay_name(r, SGL_REPLAY_RENDERBUFFER, a[3]));
+            break;
+        case SGL_TRACE_GEN_RENDERBUFFERS:       sgl_replay_gen_names(r, SGL_REPLAY_RENDERBUFFER, rec); break;
+        case SGL_TRACE_DELETE_RENDERBUFFERS:    sgl_replay_delete_names(r, SGL_REPLAY_RENDERBUFFER, rec); break;
+        case SGL_TRACE_BIND_RENDERBUFFER:
+            glBindRenderbuffer(a[0], sgl_replay_name(r, SGL_REPLAY_RENDERBUFFER, a[1]));
+            break;
+        case SGL_TRACE_RENDERBUFFER_STORAGE:
+            glRenderbufferStorage(a[0], a[1], (GLsizei)a[2], (GLsizei)a[3]);
+            break;
+        case SGL_TRACE_DRAW_BUFFERS:
+            if (rec->blob_size >= a[0] * 4) glDrawBuffersEXT((GLsizei)a[0], (const GLenum *)rec->blob);
+            break;
+        case SGL_TRACE_DISCARD_FRAMEBUFFER:
+            if (rec->blob_size >= a[1] * 4) {
+                glDiscardFramebufferEXT(a[0], (GLsizei)a[1], (const GLenum *)rec->blob);
+            }
+            break;
+        case SGL_TRACE_BLIT_FRAMEBUFFER:
+            glBlitFramebufferANGLE((GLint)a[0], (GLint)a[1], (GLint)a[2], (GLint)a[3], (GLint)a[4],
+                                   (GLint)a[5], (GLint)a[6], (GLint)a[7], a[8], a[9]);
+            break;
+        /* x, y, width, height, format, type, pack buffer offset, pack buffer bound */
+        case SGL_TRACE_READ_PIXELS:             sgl_replay_read_pixels(r, rec); break;
+
+        /* Draws: mode, first, count, instances; mode, count, type, buffer
+         * offset, instances with client indices as the blob */
+        case SGL_TRACE_DRAW_ARRAYS:
+            if (a[3] > 1) glDrawArraysInstancedANGLE(a[0], (GLint)a[1], (GLsizei)a[2], (GLsizei)a[3]);
+            else glDrawArrays(a[0], (GLint)a[1], (GLsizei)a[2]);
+            break;
+        case SGL_TRACE_DRAW_ELEMENTS: {
+            const void *indices = rec->blob ? rec->blob : (const void *)(uintptr_t)a[3];
+            if (a[4] > 1) glDrawElementsInstancedANGLE(a[0], (GLsizei)a[1], a[2], indices, (GLsizei)a[4]);
+            else glDrawElements(a[0], (GLsizei)a[1], a[2], indices);
+            break;
+        }
+
+        default:
+            if (!r->unknown_warned) {
+                SGL_WARN(SGL_LOG_CAT_CORE, "[CORE] Replay: skipping unknown opcode %u", rec->op);
+                r->unknown_warned = true;
+            }
+            break;
+    }
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+GL_APICALL sgl_replay_t *GL_APIENTRY sglReplayOpen(const GLchar *path) {
+    sgl_trace_t *trace = sgl_trace_open(path);
+    if (!trace) {
+        SGL_ERROR_CORE("sglReplayOpen: %s is not a readable trace", path ? path : "(null)");
+        return NULL;
+    }
+
+    sgl_replay_t *r = (sgl_replay_t *)calloc(1, sizeof(*r));
+    if (!r) {
+        sgl_trace_close(trace);
+        return NULL;
+    }
+    r->trace = trace;
+    return r;
+}
+
+GL_APICALL void GL_APIENTRY sglReplaySetCallback(sgl_replay_t *replay, sgl_replay_callback_t callback,
+                                                 void *user) {
+    if (!replay) return;
+    replay->callback = callback;
+    replay->user = user;
+}
+
+GL_APICALL GLboolean GL_APIENTRY sglReplayFrame(sgl_replay_t *replay, sgl_replay_stats_t *stats) {
+    if (stats) memset(stats, 0, sizeof(*stats));
+    if (!replay || replay->finished || !sgl_get_current_context()) return GL_FALSE;
+
+    sgl_replay_stats_t frame = { .frame = replay->frame };
+    uint64_t start_bytes = sgl_trace_bytes(replay->trace);
+    sgl_trace_record_t rec;
+
+    for (;;) {
+        memset(&rec, 0, sizeof(rec));  /* Missing arguments read as 0 */
+        if (!sgl_trace_read(replay->trace, &rec)) {
+            replay->finished = true;
+            break;
+        }
+
+        bool draw = rec.op == SGL_TRACE_DRAW_ARRAYS || rec.op == SGL_TRACE_DRAW_ELEMENTS;
+        uint64_t t0 = sgl_replay_now_ns();
+        sgl_replay_call(replay, &rec);
+        uint64_t ns = sgl_replay_now_ns() - t0;
+
+        if (replay->callback) {
+            sgl_replay_call_t call = {
+                .name = sgl_trace_op_name(rec.op),
+                .frame = replay->frame,
+                .call = frame.calls,
+                .draw = draw ? GL_TRUE : GL_FALSE,
+                .cpu_ns = ns,
+            };
+            replay->callback(&call, replay->user);
+        }
+
+        frame.calls++;
+        frame.cpu_ns += ns;
+        if (draw) {
+            frame.draws++;
+            frame.draw_ns += ns;
+        }
+        if (rec.op == SGL_TRACE_SWAP) break;
+    }
+
+    frame.bytes = sgl_trace_bytes(replay->trace) - start_bytes;
+    if (frame.calls == 0) return GL_FALSE;
+
+    replay->frame++;
+    if (stats) *stats = frame;
+    return GL_TRUE;
+}
+
+GL_APICALL void GL_APIENTRY sglReplayClose(sgl_replay_t *replay) {
+    if (!replay) return;
+
+    /* Objects the replay created go with it, if their context is current */
+    if (sgl_get_current_context()) {
+        for (int kind = 0; kind < SGL_REPLAY_KIND_COUNT; kind++) {
+            sgl_replay_names_t *names = &replay->names[kind];
+            for (uint32_t i = 0; i < names->capacity; i++) {
+                if (names->map[i]) sgl_replay_delete(kind, 1, &names->map[i]);
+            }
+        }
+    }
+    if (replay->location_mismatches) {
+        SGL_WARN(SGL_LOG_CAT_CORE, "[CORE] Replay: %u uniform locations differed from the capture",
+                 replay->location_mismatches);
+    }
+
+    for (int kind = 0; kind < SGL_REPLAY_KIND_COUNT; kind++) free(replay->names[kind].map);
+    for (int i = 0; i < SGL_MAX_ATTRIBS; i++) free(replay->client_arrays[i]);
+    free(replay->scratch);
+    sgl_trace_close(replay->trace);
+    free(replay);
+}
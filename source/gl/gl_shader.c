@@ -6,16 +6,28 @@
 #include "gl_common.h"
 #include <string.h>
 #include <stdlib.h>
+#include "../util/sgl_bundle.h"
+#include "../util/sgl_shader_cache.h"
+#include "../util/sgl_work_queue.h"
 
 #ifdef SGL_ENABLE_RUNTIME_COMPILER
+#ifndef SGL_NULL_SHADER_COMPILER
 #include <libuam.h>
 #include <malloc.h>  /* memalign — needed for 256-byte aligned DKSH buffer */
+#else
+#include <stdio.h>
+#include <unistd.h>  /* unlink: SGL_UAM compiles through temporary files */
+#endif
 #include "../transpiler/glsl_transpiler.h"
-/* Forward-declare packed uniform API (defined in gl_uniform.c, declared in gl2sgl.h) */
-extern GLboolean sglRegisterPackedUniform(const GLchar *name, GLint stage, GLint binding, GLint byte_offset);
-extern void sglSetPackedUBOSize(GLint stage, GLint binding, GLint size);
 #endif
 
+/* Link Reflection */
+
+static sgl_link_reflection_t *sgl_alloc_link_reflection(int num_uniforms) {
+    return (sgl_link_reflection_t *)calloc(1, sizeof(sgl_link_reflection_t) +
+                                           (size_t)num_uniforms * sizeof(sgl_link_uniform_t));
+}
+
 /* Shader Objects */
 
 GL_APICALL GLuint GL_APIENTRY glCreateShader(GLenum type) {
@@ -26,20 +38,49 @@ GL_APICALL GLuint GL_APIENTRY glCreateShader(GLenum type) {
         return 0;
     }
 
-    GLuint id = sgl_res_mgr_alloc_shader(&ctx->res_mgr, type);
+    GLuint id = sgl_res_mgr_alloc_shader(ctx->res_mgr, type);
     if (id == 0) {
         sgl_set_error(ctx, GL_OUT_OF_MEMORY);
         return 0;
     }
 
+    SGL_CAPTURE(SGL_TRACE_CREATE_SHADER, type, id);
     SGL_TRACE_SHADER("glCreateShader(0x%X) = %u", type, id);
     return id;
 }
 
+/* Is the shader name attached to a program other than 'except'? */
+static bool sgl_shader_attached(sgl_context_t *ctx, GLuint shader, GLuint except) {
+    for (GLuint i = 1; i < sgl_table_end(&ctx->res_mgr->programs); i++) {
+        sgl_program_t *prog = GET_PROGRAM(i);
+        if (prog && i != except && (prog->vertex_shader == shader || prog->fragment_shader == shader)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Free a deleted shader once no program other than 'except' has it attached.
+ * Until then its name stays reserved, so programs can relink from it and a
+ * new shader cannot take over their attachment. */
+static void sgl_shader_release(sgl_context_t *ctx, GLuint shader, GLuint except) {
+    sgl_shader_t *sh = shader ? GET_SHADER(shader) : NULL;
+    if (!sh || !sh->delete_pending || sgl_shader_attached(ctx, shader, except)) return;
+    sgl_res_mgr_free_shader(ctx->res_mgr, shader);
+    if (ctx->backend && ctx->backend->ops->delete_shader) {
+        ctx->backend->ops->delete_shader(ctx->backend, shader);
+    }
+}
+
 GL_APICALL void GL_APIENTRY glDeleteShader(GLuint shader) {
     GET_CTX();
     if (shader == 0) return;
-    sgl_res_mgr_free_shader(&ctx->res_mgr, shader);
+    sgl_shader_t *sh = GET_SHADER(shader);
+    if (sh) {
+        sh->delete_pending = true;
+        sgl_shader_release(ctx, shader, 0);
+    }
+    SGL_CAPTURE(SGL_TRACE_DELETE_SHADER, shader);
     SGL_TRACE_SHADER("glDeleteShader(%u)", shader);
 }
 
@@ -104,76 +145,574 @@ GL_APICALL void GL_APIENTRY glShaderSource(GLuint shader, GLsizei count, const G
     sh->compiled = false;
     sh->needs_transpile = false;
 
+    SGL_CAPTURE_DATA(SGL_TRACE_SHADER_SOURCE, sh->source, (uint32_t)total, shader);
     SGL_TRACE_SHADER("glShaderSource(%u, %d) - %zu bytes", shader, count, total);
 }
 
 #ifdef SGL_ENABLE_RUNTIME_COMPILER
 /*
- * sgl_compile_glsl460 - Compile GLSL 4.60 source to DKSH and load into backend.
- *
- * Shared helper used by both glCompileShader (for direct GLSL 460 source)
- * and glLinkProgram (for transpiled ES 1.00 → 460 source).
+ * sgl_compile_dksh - Compile GLSL 4.60 source to a DKSH blob.
  *
- * Returns true on success. Sets sh->info_log on failure.
+ * Returns a 256-byte aligned buffer (caller frees) and its size, or NULL
+ * with *info_log set. Compiler warnings are kept in *info_log. Touches no
+ * GL or backend state, so it may run on a compile worker.
  */
-static bool sgl_compile_glsl460(sgl_context_t *ctx, GLuint shader_id,
-                                 sgl_shader_t *sh, const char *glsl_source) {
+#ifdef SGL_NULL_SHADER_COMPILER
+/* Contents of a file (NUL terminated, size without it), NULL if unreadable */
+static char *sgl_read_host_file(const char *path, size_t *out_size) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return NULL;
+    size_t cap = 4096, len = 0, n;
+    char *data = (char *)malloc(cap);
+    while (data && (n = fread(data + len, 1, cap - len - 1, fp)) > 0) {
+        len += n;
+        if (cap - len == 1) {
+            char *grown = (char *)realloc(data, cap * 2);
+            if (!grown) free(data);
+            data = grown;
+            cap *= 2;
+        }
+    }
+    fclose(fp);
+    if (data) data[len] = '\0';
+    *out_size = len;
+    return data;
+}
+
+/*
+ * Host builds with SGL_UAM naming a uam executable: compile for real by
+ * running it on a temporary file. This is how tools/shader_bundle produces
+ * device DKSH without libuam in the host library. The disk cache key does
+ * not cover the variable; the bundle builder runs with the cache disabled.
+ */
+static void *sgl_compile_dksh_uam(const char *uam, GLenum type, const char *glsl_source,
+                                  size_t *out_size, char **info_log) {
+    char src_path[] = "/tmp/sgl_uam_XXXXXX";
+    int fd = mkstemp(src_path);
+    if (fd < 0) {
+        *info_log = strdup("ERROR: Cannot create a temporary file for uam\n");
+        return NULL;
+    }
+    FILE *fp = fdopen(fd, "wb");
+    bool written = fp && fputs(glsl_source, fp) >= 0;
+    if (fp) fclose(fp);
+    else close(fd);
+
+    char dksh_path[sizeof(src_path) + 8], log_path[sizeof(src_path) + 8], cmd[1024];
+    snprintf(dksh_path, sizeof(dksh_path), "%s.dksh", src_path);
+    snprintf(log_path, sizeof(log_path), "%s.log", src_path);
+    snprintf(cmd, sizeof(cmd), "'%s' -s %s '%s' -o '%s' > '%s' 2>&1", uam,
+             type == GL_VERTEX_SHADER ? "vert" : "frag", src_path, dksh_path, log_path);
+
+    void *dksh = NULL;
+    if (written && system(cmd) == 0) dksh = sgl_read_host_file(dksh_path, out_size);
+    if (!dksh) {
+        size_t log_size;
+        char *log = sgl_read_host_file(log_path, &log_size);
+        *info_log = log && log[0] ? log : strdup("ERROR: uam failed\n");
+        if (*info_log != log) free(log);
+    }
+    unlink(src_path);
+    unlink(dksh_path);
+    unlink(log_path);
+    return dksh;
+}
+
+/* Host builds (null backend): the "DKSH" is the GLSL 4.60 text itself */
+static void *sgl_compile_dksh(GLenum type, const char *glsl_source, size_t *out_size,
+                              char **info_log) {
+    if (type != GL_VERTEX_SHADER && type != GL_FRAGMENT_SHADER) {
+        *info_log = strdup("ERROR: Unsupported shader type\n");
+        return NULL;
+    }
+    const char *uam = getenv("SGL_UAM");
+    if (uam && uam[0]) return sgl_compile_dksh_uam(uam, type, glsl_source, out_size, info_log);
+
+    size_t len = strlen(glsl_source) + 1;
+    void *blob = malloc(len);
+    if (!blob) {
+        *info_log = strdup("ERROR: Out of memory for compiled shader\n");
+        return NULL;
+    }
+    memcpy(blob, glsl_source, len);
+    *out_size = len;
+    return blob;
+}
+#else
+static void *sgl_compile_dksh(GLenum type, const char *glsl_source, size_t *out_size,
+                              char **info_log) {
     DkStage stage;
-    if (sh->type == GL_VERTEX_SHADER) {
+    if (type == GL_VERTEX_SHADER) {
         stage = DkStage_Vertex;
-    } else if (sh->type == GL_FRAGMENT_SHADER) {
+    } else if (type == GL_FRAGMENT_SHADER) {
         stage = DkStage_Fragment;
     } else {
-        sh->info_log = strdup("ERROR: Unsupported shader type\n");
-        return false;
+        *info_log = strdup("ERROR: Unsupported shader type\n");
+        return NULL;
     }
 
     uam_compiler *compiler = uam_create_compiler(stage);
     if (!compiler) {
-        sh->info_log = strdup("ERROR: Failed to create shader compiler\n");
-        return false;
+        *info_log = strdup("ERROR: Failed to create shader compiler\n");
+        return NULL;
     }
 
-    bool result = false;
+    void *dksh = NULL;
 
     if (uam_compile_dksh(compiler, glsl_source)) {
         size_t dksh_size = uam_get_code_size(compiler);
 
-        SGL_TRACE_SHADER("RT compile shader %u: DKSH size=%zu align256=%d GPRs=%d",
-                         shader_id, dksh_size, (int)(dksh_size % 256), uam_get_num_gprs(compiler));
+        SGL_TRACE_SHADER("RT compile: DKSH size=%zu align256=%d GPRs=%d",
+                         dksh_size, (int)(dksh_size % 256), uam_get_num_gprs(compiler));
 
         /* CRITICAL: Buffer MUST be 256-byte aligned for libuam's pa256(). */
         size_t alloc_size = SGL_ALIGN_UP(dksh_size, SGL_PAGE_ALIGNMENT);
-        void *dksh = memalign(256, alloc_size);
+        dksh = memalign(256, alloc_size);
         if (dksh) {
             memset(dksh, 0, alloc_size);
             uam_write_code(compiler, dksh);
-
-            if (ctx->backend && ctx->backend->ops->load_shader_binary) {
-                result = ctx->backend->ops->load_shader_binary(
-                    ctx->backend, shader_id, dksh, dksh_size);
-            } else {
-                sh->info_log = strdup("ERROR: Backend does not support shader loading\n");
-            }
-
-            free(dksh);
+            *out_size = dksh_size;
         } else {
-            sh->info_log = strdup("ERROR: Out of memory for compiled shader\n");
+            *info_log = strdup("ERROR: Out of memory for compiled shader\n");
         }
 
         const char *log = uam_get_error_log(compiler);
-        if (log && log[0] != '\0' && !sh->info_log) {
-            sh->info_log = strdup(log);
+        if (log && log[0] != '\0' && !*info_log) {
+            *info_log = strdup(log);
         }
     } else {
         const char *log = uam_get_error_log(compiler);
-        sh->info_log = (log && log[0]) ? strdup(log) : strdup("ERROR: Compilation failed\n");
+        *info_log = (log && log[0]) ? strdup(log) : strdup("ERROR: Compilation failed\n");
     }
 
     uam_free_compiler(compiler);
+    return dksh;
+}
+#endif /* SGL_NULL_SHADER_COMPILER */
+
+/* Load a DKSH blob into the backend at the shader's handle */
+static bool sgl_load_dksh(sgl_context_t *ctx, GLuint shader_id, sgl_shader_t *sh,
+                          const void *dksh, size_t size) {
+    if (!ctx->backend || !ctx->backend->ops->load_shader_binary) {
+        if (!sh->info_log) sh->info_log = strdup("ERROR: Backend does not support shader loading\n");
+        return false;
+    }
+    return ctx->backend->ops->load_shader_binary(ctx->backend, shader_id, dksh, size);
+}
+
+/*
+ * sgl_compile_glsl460 - Compile GLSL 4.60 source to DKSH and load into backend.
+ *
+ * Used by glCompileShader for direct GLSL 460 source; glLinkProgram goes
+ * through sgl_build_stage so transpiled shaders can be cached and built
+ * off the GL thread.
+ *
+ * Returns true on success. Sets sh->info_log on failure.
+ */
+static bool sgl_compile_glsl460(sgl_context_t *ctx, GLuint shader_id,
+                                 sgl_shader_t *sh, const char *glsl_source) {
+    size_t dksh_size = 0;
+    void *dksh = sgl_compile_dksh(sh->type, glsl_source, &dksh_size, &sh->info_log);
+    if (!dksh) return false;
+
+    bool result = sgl_load_dksh(ctx, shader_id, sh, dksh, dksh_size);
+    free(dksh);
     return result;
 }
 
+/* Output of building one transpiled stage */
+typedef struct {
+    glslt_result_t reflection;  /* output already released */
+    void *dksh;                 /* malloc'd DKSH code */
+    size_t dksh_size;
+    char *info_log;             /* Errors or compiler warnings */
+} sgl_stage_build_t;
+
+/* ============================================================================
+ * Shader Disk Cache
+ *
+ * A transpiled ES 1.00 stage is cached under a hash of everything that
+ * shapes its DKSH: stage, source, transpiler options (attrib and varying
+ * locations, bindings) and the transpiler/compiler versions. The entry
+ * stores the reflection glLinkProgram needs after compiling, so a hit
+ * skips both glslt_transpile and libuam.
+ *
+ * Payload: sgl_cache_stage_t, then num_uniforms + num_attributes +
+ * num_varyings sgl_cache_symbol_t records, then the DKSH code.
+ * ============================================================================ */
+
+typedef struct {
+    char    name[GLSLT_MAX_NAME];
+    int32_t value;  /* UBO offset for uniforms, location otherwise */
+} sgl_cache_symbol_t;
+
+typedef struct {
+    uint32_t dksh_size;
+    int32_t  ubo_total_size;
+    int32_t  num_uniforms;
+    int32_t  num_attributes;
+    int32_t  num_varyings;
+} sgl_cache_stage_t;
+
+static uint64_t sgl_hash_string(uint64_t h, const char *str) {
+    /* Include the terminator so adjacent strings cannot run together */
+    return sgl_hash64(h, str, strlen(str) + 1);
+}
+
+static uint64_t sgl_hash_int(uint64_t h, int32_t value) {
+    return sgl_hash64(h, &value, sizeof(value));
+}
+
+static uint64_t sgl_stage_cache_key(const char *source, glslt_stage_t stage,
+                                    const glslt_options_t *opts) {
+    uint64_t h = SGL_HASH64_INIT;
+    h = sgl_hash_int(h, GLSLT_VERSION);
+    h = sgl_hash_int(h, SGL_SHADER_CACHE_COMPILER_VERSION);
+    h = sgl_hash_int(h, (int32_t)stage);
+    h = sgl_hash_int(h, opts->target_version);
+    h = sgl_hash_int(h, opts->ubo_binding);
+    h = sgl_hash_int(h, opts->sampler_binding_start);
+    h = sgl_hash_int(h, opts->optimize_uniforms);
+    for (int i = 0; i < opts->num_attrib_locations; i++) {
+        h = sgl_hash_string(h, opts->attrib_locations[i].name);
+        h = sgl_hash_int(h, opts->attrib_locations[i].location);
+    }
+    h = sgl_hash_int(h, -1);  /* Separates attrib from varying bindings */
+    for (int i = 0; i < opts->num_varying_locations; i++) {
+        h = sgl_hash_string(h, opts->varying_locations[i].name);
+        h = sgl_hash_int(h, opts->varying_locations[i].location);
+    }
+    return sgl_hash_string(h, source);
+}
+
+static void sgl_cache_put_symbol(sgl_cache_symbol_t *sym, const char *name, int value) {
+    memset(sym, 0, sizeof(*sym));
+    strncpy(sym->name, name, GLSLT_MAX_NAME - 1);
+    sym->value = value;
+}
+
+static void sgl_stage_cache_store(uint64_t key, const glslt_result_t *result,
+                                  const void *dksh, size_t dksh_size) {
+    if (!sgl_shader_cache_enabled()) return;
+
+    int num_symbols = result->num_uniforms + result->num_attributes + result->num_varyings;
+    size_t size = sizeof(sgl_cache_stage_t) + num_symbols * sizeof(sgl_cache_symbol_t) + dksh_size;
+    uint8_t *payload = (uint8_t *)malloc(size);
+    if (!payload) return;
+
+    sgl_cache_stage_t *hdr = (sgl_cache_stage_t *)payload;
+    hdr->dksh_size = (uint32_t)dksh_size;
+    hdr->ubo_total_size = result->ubo_total_size;
+    hdr->num_uniforms = result->num_uniforms;
+    hdr->num_attributes = result->num_attributes;
+    hdr->num_varyings = result->num_varyings;
+
+    sgl_cache_symbol_t *sym = (sgl_cache_symbol_t *)(hdr + 1);
+    for (int i = 0; i < result->num_uniforms; i++) {
+        sgl_cache_put_symbol(sym++, result->uniforms[i].name, result->uniforms[i].offset);
+    }
+    for (int i = 0; i < result->num_attributes; i++) {
+        sgl_cache_put_symbol(sym++, result->attributes[i].name, result->attributes[i].location);
+    }
+    for (int i = 0; i < result->num_varyings; i++) {
+        sgl_cache_put_symbol(sym++, result->varyings[i].name, result->varyings[i].location);
+    }
+    memcpy(sym, dksh, dksh_size);
+
+    if (!sgl_shader_cache_store(key, payload, size)) {
+        SGL_TRACE_SHADER("shader cache: failed to store %016llx", (unsigned long long)key);
+    }
+    free(payload);
+}
+
+/*
+ * Look up a stage in the disk cache. On a hit out receives the cached
+ * reflection (output stays NULL) and a malloc'd copy of the DKSH.
+ */
+static bool sgl_stage_cache_load(uint64_t key, sgl_stage_build_t *out) {
+    size_t size = 0;
+    uint8_t *payload = (uint8_t *)sgl_shader_cache_load(key, &size);
+    if (!payload) return false;
+
+    const sgl_cache_stage_t *hdr = (const sgl_cache_stage_t *)payload;
+    bool valid = size >= sizeof(*hdr) &&
+                 hdr->num_uniforms >= 0 && hdr->num_uniforms <= GLSLT_MAX_UNIFORMS &&
+                 hdr->num_attributes >= 0 && hdr->num_attributes <= GLSLT_MAX_ATTRIBUTES &&
+                 hdr->num_varyings >= 0 && hdr->num_varyings <= GLSLT_MAX_VARYINGS;
+    size_t num_symbols = valid ? (size_t)(hdr->num_uniforms + hdr->num_attributes + hdr->num_varyings) : 0;
+    const sgl_cache_symbol_t *sym = (const sgl_cache_symbol_t *)(hdr + 1);
+    const uint8_t *dksh = (const uint8_t *)(sym + num_symbols);
+    valid = valid && hdr->dksh_size > 0 && (size_t)(dksh - payload) + hdr->dksh_size == size;
+
+    out->dksh = valid ? malloc(hdr->dksh_size) : NULL;
+    if (!out->dksh) {
+        SGL_TRACE_SHADER("shader cache: rejected entry %016llx", (unsigned long long)key);
+        free(payload);
+        return false;
+    }
+    memcpy(out->dksh, dksh, hdr->dksh_size);
+    out->dksh_size = hdr->dksh_size;
+
+    glslt_result_t *result = &out->reflection;
+    memset(result, 0, sizeof(*result));
+    result->success = 1;
+    result->ubo_total_size = hdr->ubo_total_size;
+    result->num_uniforms = hdr->num_uniforms;
+    result->num_attributes = hdr->num_attributes;
+    result->num_varyings = hdr->num_varyings;
+    for (int i = 0; i < hdr->num_uniforms; i++, sym++) {
+        memcpy(result->uniforms[i].name, sym->name, GLSLT_MAX_NAME);
+        result->uniforms[i].offset = sym->value;
+    }
+    for (int i = 0; i < hdr->num_attributes; i++, sym++) {
+        memcpy(result->attributes[i].name, sym->name, GLSLT_MAX_NAME);
+        result->attributes[i].location = sym->value;
+    }
+    for (int i = 0; i < hdr->num_varyings; i++, sym++) {
+        memcpy(result->varyings[i].name, sym->name, GLSLT_MAX_NAME);
+        result->varyings[i].location = sym->value;
+    }
+
+    free(payload);
+    return true;
+}
+
+/* Record one stage's transpiled uniforms, packed into the UBO at ubo_binding.
+ * Uniforms the stage never references keep byte_offset -1. */
+static void sgl_reflect_stage(sgl_link_reflection_t *r, int stage, int ubo_binding,
+                              const glslt_result_t *result) {
+    if (result->num_uniforms == 0) return;
+    r->packed_ubo_sizes[stage][ubo_binding] = result->ubo_total_size;
+    for (int i = 0; i < result->num_uniforms; i++) {
+        sgl_link_uniform_t *u = &r->uniforms[r->num_uniforms++];
+        strncpy(u->name, result->uniforms[i].name, SGL_UNIFORM_NAME_MAX - 1);
+        u->stage = stage;
+        u->binding = ubo_binding;
+        u->byte_offset = result->uniforms[i].offset;
+    }
+}
+
+/*
+ * sgl_build_stage - Transpile and compile one ES 1.00 stage at link time.
+ *
+ * Consults the disk cache first; on a miss runs glslt_transpile and libuam
+ * and stores the result. Only reads its arguments and writes out, so it is
+ * safe on a compile worker; loading the DKSH is left to the GL thread.
+ * Returns false with out->info_log set on failure. Release out with
+ * sgl_stage_build_free().
+ */
+static bool sgl_build_stage(const char *source, GLenum type, glslt_stage_t stage,
+                            const glslt_options_t *opts, sgl_stage_build_t *out) {
+    uint64_t key = sgl_stage_cache_key(source, stage, opts);
+    if (sgl_stage_cache_load(key, out)) {
+        SGL_TRACE_SHADER("stage %d: cache hit %016llx", (int)stage, (unsigned long long)key);
+        return true;
+    }
+
+    out->reflection = glslt_transpile(source, stage, opts);
+    if (!out->reflection.success) {
+        SGL_TRACE_SHADER("stage %d: transpile failed: %s", (int)stage, out->reflection.error);
+        out->info_log = strdup(out->reflection.error);
+        return false;
+    }
+    SGL_TRACE_SHADER("stage %d transpiled: %d uniforms, %d samplers, %d attribs, %d varyings",
+                     (int)stage, out->reflection.num_uniforms, out->reflection.num_samplers,
+                     out->reflection.num_attributes, out->reflection.num_varyings);
+
+    out->dksh = sgl_compile_dksh(type, out->reflection.output, &out->dksh_size, &out->info_log);
+    glslt_result_free(&out->reflection);  /* GLSL 4.60 text is not needed past libuam */
+    if (!out->dksh) return false;
+
+    sgl_stage_cache_store(key, &out->reflection, out->dksh, out->dksh_size);
+    return true;
+}
+
+static void sgl_stage_build_free(sgl_stage_build_t *build) {
+    glslt_result_free(&build->reflection);
+    free(build->dksh);
+    free(build->info_log);
+    memset(build, 0, sizeof(*build));
+}
+
+/* ============================================================================
+ * Background Linking (GL_KHR_parallel_shader_compile)
+ *
+ * glLinkProgram snapshots the ES 1.00 sources and transpiler options into
+ * an sgl_link_job_t and queues it on the compile workers. The job only
+ * transpiles and compiles; everything that touches shared state (code
+ * memory, link reflection, program bindings) happens in
+ * sgl_program_finish_link on the GL thread, the first time the program is
+ * used or queried. GL_COMPLETION_STATUS_KHR polls without finishing.
+ * ============================================================================ */
+
+typedef struct sgl_link_job {
+    sgl_work_t work;                /* Must be first */
+    GLuint vertex_shader;           /* Shaders attached at link, for info logs */
+    GLuint fragment_shader;
+    char *vs_source;                /* NULL when the stage is not transpiled */
+    char *fs_source;
+    glslt_options_t vs_opts;
+    sgl_stage_build_t vs;
+    sgl_stage_build_t fs;
+    bool ok;
+} sgl_link_job_t;
+
+static int s_compile_threads = -1;  /* -1 until the first link starts the default */
+
+static void sgl_link_job_run(sgl_work_t *work) {
+    sgl_link_job_t *job = (sgl_link_job_t *)work;
+
+    job->vs.reflection.success = 1;  /* Defaults for a stage that is not transpiled */
+    job->fs.reflection.success = 1;
+
+    if (job->vs_source &&
+        !sgl_build_stage(job->vs_source, GL_VERTEX_SHADER, GLSLT_VERTEX, &job->vs_opts, &job->vs)) {
+        job->ok = false;
+        return;
+    }
+
+    if (job->fs_source) {
+        glslt_options_t fs_opts;
+        glslt_options_init(&fs_opts);
+        fs_opts.optimize_uniforms = 1;
+
+        /* Pass VS varying locations so FS uses matching locations */
+        for (int i = 0; i < job->vs.reflection.num_varyings; i++) {
+            glslt_set_varying_location(&fs_opts,
+                job->vs.reflection.varyings[i].name,
+                job->vs.reflection.varyings[i].location);
+        }
+
+        if (!sgl_build_stage(job->fs_source, GL_FRAGMENT_SHADER, GLSLT_FRAGMENT, &fs_opts, &job->fs)) {
+            job->ok = false;
+            return;
+        }
+    }
+
+    job->ok = true;
+}
+
+static void sgl_link_job_free(sgl_link_job_t *job) {
+    sgl_stage_build_free(&job->vs);
+    sgl_stage_build_free(&job->fs);
+    free(job->vs_source);
+    free(job->fs_source);
+    free(job);
+}
+
+/*
+ * Hand a stage's info log to its shader object. The shader may have been
+ * deleted since glLinkProgram; its ID is only trusted while it still holds
+ * deferred ES 1.00 source.
+ */
+static sgl_shader_t *sgl_link_job_shader(sgl_context_t *ctx, GLuint id, sgl_stage_build_t *build) {
+    sgl_shader_t *sh = id ? GET_SHADER(id) : NULL;
+    if (!sh || !sh->needs_transpile) return NULL;
+    if (build->info_log) {
+        free(sh->info_log);
+        sh->info_log = build->info_log;
+        build->info_log = NULL;
+    }
+    return sh;
+}
+
+/* Load a finished job's code and reflection into the program */
+static bool sgl_link_job_apply(sgl_context_t *ctx, GLuint program, sgl_program_t *prog,
+                               sgl_link_job_t *job) {
+    sgl_shader_t *vs_sh = sgl_link_job_shader(ctx, job->vertex_shader, &job->vs);
+    sgl_shader_t *fs_sh = sgl_link_job_shader(ctx, job->fragment_shader, &job->fs);
+    if (!job->ok) {
+        /* Report the failing stage as not compiled; the FS never ran if the VS failed */
+        bool vs_failed = job->vs_source && !job->vs.dksh;
+        if (vs_sh && vs_failed) vs_sh->compiled = false;
+        if (fs_sh && !vs_failed && job->fs_source && !job->fs.dksh) fs_sh->compiled = false;
+        return false;
+    }
+    if (!ctx->backend) return false;
+
+    if (job->vs_source && job->fs_source) {
+        /* Both stages built here: load straight into the program slots */
+        if (!ctx->backend->ops->load_program_binary ||
+            !ctx->backend->ops->load_program_binary(ctx->backend, program,
+                                                    job->vs.dksh, job->vs.dksh_size,
+                                                    job->fs.dksh, job->fs.dksh_size)) {
+            return false;
+        }
+    } else {
+        /* One transpiled stage next to a precompiled one: go through the shader handle */
+        sgl_shader_t *sh = job->vs_source ? vs_sh : fs_sh;
+        GLuint id = job->vs_source ? job->vertex_shader : job->fragment_shader;
+        sgl_stage_build_t *build = job->vs_source ? &job->vs : &job->fs;
+        if (!sh || !sgl_load_dksh(ctx, id, sh, build->dksh, build->dksh_size)) return false;
+        sh->needs_transpile = false;
+
+        if (ctx->backend->ops->link_program &&
+            !ctx->backend->ops->link_program(ctx->backend, program,
+                                             prog->vertex_shader, prog->fragment_shader)) {
+            return false;
+        }
+    }
+
+    /* Keep the transpiler's packed layout on the program; glGetUniformLocation
+     * resolves against it (VS and FS uniforms each go to a packed UBO at binding 0) */
+    const glslt_result_t *vs_result = &job->vs.reflection;
+    const glslt_result_t *fs_result = &job->fs.reflection;
+    free(prog->link_reflection);
+    prog->link_reflection = sgl_alloc_link_reflection(vs_result->num_uniforms + fs_result->num_uniforms);
+    if (!prog->link_reflection) {
+        sgl_set_error(ctx, GL_OUT_OF_MEMORY);
+        return false;
+    }
+    sgl_reflect_stage(prog->link_reflection, 0, job->vs_opts.ubo_binding, vs_result);
+    sgl_reflect_stage(prog->link_reflection, 1, 0, fs_result);
+    SGL_TRACE_SHADER("reflected %d VS uniforms (UBO size=%d), %d FS uniforms (UBO size=%d)",
+                     vs_result->num_uniforms, vs_result->ubo_total_size,
+                     fs_result->num_uniforms, fs_result->ubo_total_size);
+
+    /* Register attrib bindings from transpiler result into program */
+    for (int i = 0; i < vs_result->num_attributes; i++) {
+        bool found = false;
+        for (int j = 0; j < prog->num_attrib_bindings; j++) {
+            if (strcmp(prog->attrib_bindings[j].name,
+                       vs_result->attributes[i].name) == 0) {
+                prog->attrib_bindings[j].index = vs_result->attributes[i].location;
+                found = true;
+                break;
+            }
+        }
+        if (!found && prog->num_attrib_bindings < SGL_MAX_ATTRIBS) {
+            int slot = prog->num_attrib_bindings++;
+            strncpy(prog->attrib_bindings[slot].name,
+                    vs_result->attributes[i].name, SGL_ATTRIB_NAME_MAX - 1);
+            prog->attrib_bindings[slot].name[SGL_ATTRIB_NAME_MAX - 1] = '\0';
+            prog->attrib_bindings[slot].index = vs_result->attributes[i].location;
+            prog->attrib_bindings[slot].used = true;
+        }
+    }
+    return true;
+}
+
+/* True while a queued link is still being built */
+static bool sgl_program_link_pending(const sgl_program_t *prog) {
+    return prog->link_job && !sgl_work_is_done(&prog->link_job->work);
+}
+
+/* Throw away a pending job (re-link, program binary load, delete) */
+static void sgl_program_discard_link(sgl_program_t *prog) {
+    sgl_link_job_t *job = prog->link_job;
+    if (!job) return;
+    prog->link_job = NULL;
+    sgl_work_wait(&job->work);
+    sgl_link_job_free(job);
+}
+
+/* Start the default worker count the first time a link is queued */
+static void sgl_compile_threads_init(void) {
+    if (s_compile_threads >= 0) return;
+    s_compile_threads = SGL_WORK_QUEUE_MAX_THREADS;
+    sgl_work_queue_set_threads(s_compile_threads);
+}
+
 /*
  * Detect if shader source is GLSL ES 1.00 (needs transpilation).
  * Returns true if #version 100, or if no #version but source contains
@@ -205,6 +744,15 @@ static bool sgl_is_es100_source(const char *source) {
 
     return false;
 }
+#else
+static bool sgl_program_link_pending(const sgl_program_t *prog) {
+    (void)prog;
+    return false;
+}
+
+static void sgl_program_discard_link(sgl_program_t *prog) {
+    (void)prog;
+}
 #endif /* SGL_ENABLE_RUNTIME_COMPILER */
 
 GL_APICALL void GL_APIENTRY glCompileShader(GLuint shader) {
@@ -215,6 +763,8 @@ GL_APICALL void GL_APIENTRY glCompileShader(GLuint shader) {
         return;
     }
 
+    SGL_CAPTURE(SGL_TRACE_COMPILE_SHADER, shader);
+
     /* Free previous info log */
     if (sh->info_log) {
         free(sh->info_log);
@@ -268,7 +818,7 @@ GL_APICALL void GL_APIENTRY glGetShaderiv(GLuint shader, GLenum pname, GLint *pa
             *params = sh->compiled ? GL_TRUE : GL_FALSE;
             break;
         case GL_DELETE_STATUS:
-            *params = GL_FALSE;
+            *params = sh->delete_pending ? GL_TRUE : GL_FALSE;
             break;
         case GL_INFO_LOG_LENGTH:
             *params = sh->info_log ? (GLint)(strlen(sh->info_log) + 1) : 0;
@@ -276,6 +826,10 @@ GL_APICALL void GL_APIENTRY glGetShaderiv(GLuint shader, GLenum pname, GLint *pa
         case GL_SHADER_SOURCE_LENGTH:
             *params = sh->source ? (GLint)(strlen(sh->source) + 1) : 0;
             break;
+        case GL_COMPLETION_STATUS_KHR:
+            /* Compilation is synchronous or deferred to link time */
+            *params = GL_TRUE;
+            break;
         default:
             sgl_set_error(ctx, GL_INVALID_ENUM);
             break;
@@ -337,25 +891,37 @@ GL_APICALL void GL_APIENTRY glGetShaderSource(GLuint shader, GLsizei bufSize, GL
 GL_APICALL GLuint GL_APIENTRY glCreateProgram(void) {
     GET_CTX_RET(0);
 
-    GLuint id = sgl_res_mgr_alloc_program(&ctx->res_mgr);
+    GLuint id = sgl_res_mgr_alloc_program(ctx->res_mgr);
     if (id == 0) {
         sgl_set_error(ctx, GL_OUT_OF_MEMORY);
         return 0;
     }
 
+    SGL_CAPTURE(SGL_TRACE_CREATE_PROGRAM, id);
     SGL_TRACE_SHADER("glCreateProgram() = %u", id);
     return id;
 }
 
 GL_APICALL void GL_APIENTRY glDeleteProgram(GLuint program) {
     GET_CTX();
+    sgl_flush_deferred(ctx);
     if (program == 0) return;
 
     if (ctx->current_program == program) {
         ctx->current_program = 0;
     }
 
-    sgl_res_mgr_free_program(&ctx->res_mgr, program);
+    sgl_program_t *prog = GET_PROGRAM(program);
+    if (prog) {
+        sgl_program_discard_link(prog);
+        sgl_shader_release(ctx, prog->vertex_shader, program);
+        sgl_shader_release(ctx, prog->fragment_shader, program);
+        if (ctx->backend && ctx->backend->ops->delete_program) {
+            ctx->backend->ops->delete_program(ctx->backend, program);
+        }
+    }
+    sgl_res_mgr_free_program(ctx->res_mgr, program);
+    SGL_CAPTURE(SGL_TRACE_DELETE_PROGRAM, program);
     SGL_TRACE_SHADER("glDeleteProgram(%u)", program);
 }
 
@@ -375,12 +941,18 @@ GL_APICALL void GL_APIENTRY glAttachShader(GLuint program, GLuint shader) {
         return;
     }
 
+    /* A deleted shader this one replaces may have been its last attachment */
+    GLuint replaced = 0;
     if (sh->type == GL_VERTEX_SHADER) {
+        replaced = prog->vertex_shader;
         prog->vertex_shader = shader;
     } else if (sh->type == GL_FRAGMENT_SHADER) {
+        replaced = prog->fragment_shader;
         prog->fragment_shader = shader;
     }
+    if (replaced != shader) sgl_shader_release(ctx, replaced, 0);
 
+    SGL_CAPTURE(SGL_TRACE_ATTACH_SHADER, program, shader);
     SGL_TRACE_SHADER("glAttachShader(%u, %u)", program, shader);
 }
 
@@ -395,12 +967,14 @@ GL_APICALL void GL_APIENTRY glDetachShader(GLuint program, GLuint shader) {
 
     if (prog->vertex_shader == shader) prog->vertex_shader = 0;
     if (prog->fragment_shader == shader) prog->fragment_shader = 0;
+    sgl_shader_release(ctx, shader, 0);
 
     SGL_TRACE_SHADER("glDetachShader(%u, %u)", program, shader);
 }
 
 GL_APICALL void GL_APIENTRY glLinkProgram(GLuint program) {
     GET_CTX();
+    sgl_flush_deferred(ctx);
 
     sgl_program_t *prog = GET_PROGRAM(program);
     if (!prog) {
@@ -408,165 +982,76 @@ GL_APICALL void GL_APIENTRY glLinkProgram(GLuint program) {
         return;
     }
 
+    SGL_CAPTURE(SGL_TRACE_LINK_PROGRAM, program);
+
+    /* Locations handed out for the previous link no longer apply */
+    sgl_program_reset_uniforms(prog);
+    prog->revision = sgl_res_mgr_next_revision(ctx->res_mgr);
+
 #ifdef SGL_ENABLE_RUNTIME_COMPILER
+    /* A re-link supersedes whatever the previous one was still building */
+    sgl_program_discard_link(prog);
+
     /* Check if any attached shader needs transpilation (GLSL ES 1.00 → 4.60) */
     sgl_shader_t *vs_sh = prog->vertex_shader ? GET_SHADER(prog->vertex_shader) : NULL;
     sgl_shader_t *fs_sh = prog->fragment_shader ? GET_SHADER(prog->fragment_shader) : NULL;
-    bool needs_transpile = (vs_sh && vs_sh->needs_transpile) ||
-                           (fs_sh && fs_sh->needs_transpile);
-
-    if (needs_transpile) {
-        SGL_TRACE_SHADER("transpiling ES 1.00 shaders for program %u", program);
-
-        /* 1. Set up transpiler options with attrib bindings from glBindAttribLocation */
-        glslt_options_t vs_opts;
-        glslt_options_init(&vs_opts);
+    bool vs_transpile = vs_sh && vs_sh->needs_transpile && vs_sh->source;
+    bool fs_transpile = fs_sh && fs_sh->needs_transpile && fs_sh->source;
+
+    if (vs_transpile || fs_transpile) {
+        sgl_link_job_t *job = (sgl_link_job_t *)calloc(1, sizeof(sgl_link_job_t));
+        if (!job) {
+            sgl_set_error(ctx, GL_OUT_OF_MEMORY);
+            prog->linked = false;
+            return;
+        }
+        job->work.run = sgl_link_job_run;
+        job->vertex_shader = prog->vertex_shader;
+        job->fragment_shader = prog->fragment_shader;
+
+        /* Snapshot the sources: the application may change them right after linking */
+        job->vs_source = vs_transpile ? strdup(vs_sh->source) : NULL;
+        job->fs_source = fs_transpile ? strdup(fs_sh->source) : NULL;
+        if ((vs_transpile && !job->vs_source) || (fs_transpile && !job->fs_source)) {
+            sgl_link_job_free(job);
+            sgl_set_error(ctx, GL_OUT_OF_MEMORY);
+            prog->linked = false;
+            return;
+        }
 
+        /* Transpiler options with attrib bindings from glBindAttribLocation */
+        glslt_options_init(&job->vs_opts);
+        job->vs_opts.optimize_uniforms = 1;
         for (int i = 0; i < prog->num_attrib_bindings; i++) {
             if (prog->attrib_bindings[i].used) {
-                glslt_set_attrib_location(&vs_opts,
+                glslt_set_attrib_location(&job->vs_opts,
                     prog->attrib_bindings[i].name,
                     (int)prog->attrib_bindings[i].index);
             }
         }
 
-        /* 2. Transpile vertex shader */
-        glslt_result_t vs_result;
-        memset(&vs_result, 0, sizeof(vs_result));
-        vs_result.success = 1; /* default to success if no VS to transpile */
-
-        if (vs_sh && vs_sh->needs_transpile && vs_sh->source) {
-            vs_result = glslt_transpile(vs_sh->source, GLSLT_VERTEX, &vs_opts);
-            if (!vs_result.success) {
-                SGL_TRACE_SHADER("VS transpile failed: %s", vs_result.error);
-                if (vs_sh->info_log) free(vs_sh->info_log);
-                vs_sh->info_log = strdup(vs_result.error);
-                vs_sh->compiled = false;
-                prog->linked = false;
-                glslt_result_free(&vs_result);
-                SGL_TRACE_SHADER("glLinkProgram(%u) - VS transpile FAILED", program);
-                return;
-            }
-            SGL_TRACE_SHADER("VS transpiled: %d uniforms, %d samplers, %d attribs, %d varyings",
-                             vs_result.num_uniforms, vs_result.num_samplers,
-                             vs_result.num_attributes, vs_result.num_varyings);
-        }
-
-        /* 3. Transpile fragment shader (pass VS varying locations for consistency) */
-        glslt_result_t fs_result;
-        memset(&fs_result, 0, sizeof(fs_result));
-        fs_result.success = 1;
-
-        if (fs_sh && fs_sh->needs_transpile && fs_sh->source) {
-            glslt_options_t fs_opts;
-            glslt_options_init(&fs_opts);
-
-            /* Pass VS varying locations so FS uses matching locations */
-            for (int i = 0; i < vs_result.num_varyings; i++) {
-                glslt_set_varying_location(&fs_opts,
-                    vs_result.varyings[i].name,
-                    vs_result.varyings[i].location);
-            }
-
-            fs_result = glslt_transpile(fs_sh->source, GLSLT_FRAGMENT, &fs_opts);
-            if (!fs_result.success) {
-                SGL_TRACE_SHADER("FS transpile failed: %s", fs_result.error);
-                if (fs_sh->info_log) free(fs_sh->info_log);
-                fs_sh->info_log = strdup(fs_result.error);
-                fs_sh->compiled = false;
-                prog->linked = false;
-                glslt_result_free(&vs_result);
-                glslt_result_free(&fs_result);
-                SGL_TRACE_SHADER("glLinkProgram(%u) - FS transpile FAILED", program);
-                return;
-            }
-            SGL_TRACE_SHADER("FS transpiled: %d uniforms, %d samplers, %d varyings",
-                             fs_result.num_uniforms, fs_result.num_samplers, fs_result.num_varyings);
-        }
-
-        /* 4. Compile transpiled GLSL 4.60 → DKSH via libuam */
-        if (vs_sh && vs_sh->needs_transpile && vs_result.output) {
-            if (vs_sh->info_log) { free(vs_sh->info_log); vs_sh->info_log = NULL; }
-            vs_sh->compiled = sgl_compile_glsl460(ctx, prog->vertex_shader,
-                                                   vs_sh, vs_result.output);
-            if (!vs_sh->compiled) {
-                SGL_TRACE_SHADER("VS compile failed after transpile");
-                prog->linked = false;
-                glslt_result_free(&vs_result);
-                glslt_result_free(&fs_result);
-                SGL_TRACE_SHADER("glLinkProgram(%u) - VS compile FAILED", program);
-                return;
-            }
-            vs_sh->needs_transpile = false;
-        }
+        prog->linked = false;
+        prog->link_job = job;
 
-        if (fs_sh && fs_sh->needs_transpile && fs_result.output) {
-            if (fs_sh->info_log) { free(fs_sh->info_log); fs_sh->info_log = NULL; }
-            fs_sh->compiled = sgl_compile_glsl460(ctx, prog->fragment_shader,
-                                                   fs_sh, fs_result.output);
-            if (!fs_sh->compiled) {
-                SGL_TRACE_SHADER("FS compile failed after transpile");
-                prog->linked = false;
-                glslt_result_free(&vs_result);
-                glslt_result_free(&fs_result);
-                SGL_TRACE_SHADER("glLinkProgram(%u) - FS compile FAILED", program);
-                return;
-            }
-            fs_sh->needs_transpile = false;
-        }
-
-        /* 5. Auto-register uniforms from transpiler reflection data */
-        /* VS uniforms → packed UBO at VS binding 0 */
-        if (vs_result.num_uniforms > 0) {
-            sglSetPackedUBOSize(0, vs_opts.ubo_binding, vs_result.ubo_total_size);
-            for (int i = 0; i < vs_result.num_uniforms; i++) {
-                sglRegisterPackedUniform(vs_result.uniforms[i].name,
-                                         0, vs_opts.ubo_binding,
-                                         vs_result.uniforms[i].offset);
-            }
-            SGL_TRACE_SHADER("registered %d VS uniforms (UBO size=%d)",
-                             vs_result.num_uniforms, vs_result.ubo_total_size);
-        }
-        /* FS uniforms → packed UBO at FS binding 0 */
-        if (fs_result.num_uniforms > 0) {
-            sglSetPackedUBOSize(1, 0, fs_result.ubo_total_size);
-            for (int i = 0; i < fs_result.num_uniforms; i++) {
-                sglRegisterPackedUniform(fs_result.uniforms[i].name,
-                                         1, 0,
-                                         fs_result.uniforms[i].offset);
-            }
-            SGL_TRACE_SHADER("registered %d FS uniforms (UBO size=%d)",
-                             fs_result.num_uniforms, fs_result.ubo_total_size);
-        }
-
-        /* 6. Register attrib bindings from transpiler result into program */
-        for (int i = 0; i < vs_result.num_attributes; i++) {
-            bool found = false;
-            for (int j = 0; j < prog->num_attrib_bindings; j++) {
-                if (strcmp(prog->attrib_bindings[j].name,
-                           vs_result.attributes[i].name) == 0) {
-                    prog->attrib_bindings[j].index = vs_result.attributes[i].location;
-                    found = true;
-                    break;
-                }
-            }
-            if (!found && prog->num_attrib_bindings < SGL_MAX_ATTRIBS) {
-                int slot = prog->num_attrib_bindings++;
-                strncpy(prog->attrib_bindings[slot].name,
-                        vs_result.attributes[i].name, SGL_ATTRIB_NAME_MAX - 1);
-                prog->attrib_bindings[slot].name[SGL_ATTRIB_NAME_MAX - 1] = '\0';
-                prog->attrib_bindings[slot].index = vs_result.attributes[i].location;
-                prog->attrib_bindings[slot].used = true;
-            }
+        if (vs_transpile && fs_transpile) {
+            sgl_compile_threads_init();
+            sgl_work_submit(&job->work);
+            SGL_TRACE_SHADER("glLinkProgram(%u) - queued (%d workers)", program, sgl_work_queue_threads());
+        } else {
+            /* The precompiled stage lives in its shader handle, which the
+             * application may delete once this returns: finish now */
+            sgl_link_job_run(&job->work);
+            job->work.done = true;
+            sgl_program_finish_link(ctx, program, prog);
         }
-
-        glslt_result_free(&vs_result);
-        glslt_result_free(&fs_result);
-
-        SGL_TRACE_SHADER("transpilation complete for program %u", program);
+        return;
     }
 #endif /* SGL_ENABLE_RUNTIME_COMPILER */
 
+    /* Precompiled stages: uniforms come from the application's registrations */
+    free(prog->link_reflection);
+    prog->link_reflection = NULL;
+
     /* Call backend to copy shader data to per-program storage.
      * This prevents issues when shader IDs are reused after glDeleteShader. */
     bool link_ok = true;
@@ -579,6 +1064,50 @@ GL_APICALL void GL_APIENTRY glLinkProgram(GLuint program) {
     SGL_TRACE_SHADER("glLinkProgram(%u) - %s", program, link_ok ? "OK" : "FAILED");
 }
 
+/*
+ * sgl_program_finish_link - Complete a background link on the GL thread.
+ *
+ * Waits for the compile job if it is still running, then loads its code
+ * and records its uniform layout and attributes. No-op when nothing is pending.
+ */
+void sgl_program_finish_link(sgl_context_t *ctx, GLuint program, sgl_program_t *prog) {
+#ifdef SGL_ENABLE_RUNTIME_COMPILER
+    sgl_link_job_t *job = prog->link_job;
+    if (!job) return;
+    prog->link_job = NULL;
+
+    sgl_work_wait(&job->work);
+    prog->linked = sgl_link_job_apply(ctx, program, prog, job);
+    sgl_link_job_free(job);
+    SGL_TRACE_SHADER("glLinkProgram(%u) - %s", program, prog->linked ? "OK" : "FAILED");
+#else
+    (void)ctx;
+    (void)program;
+    (void)prog;
+#endif
+}
+
+/*
+ * glMaxShaderCompilerThreadsKHR - Number of background compile workers.
+ * 0 links synchronously; anything above the spare core count is clamped.
+ */
+GL_APICALL void GL_APIENTRY glMaxShaderCompilerThreadsKHR(GLuint count) {
+#ifdef SGL_ENABLE_RUNTIME_COMPILER
+    if (count > SGL_WORK_QUEUE_MAX_THREADS) count = SGL_WORK_QUEUE_MAX_THREADS;
+    s_compile_threads = (int)count;
+    sgl_work_queue_set_threads(s_compile_threads);
+#endif
+    SGL_TRACE_SHADER("glMaxShaderCompilerThreadsKHR(%u)", count);
+}
+
+GLint sgl_max_shader_compiler_threads(void) {
+#ifdef SGL_ENABLE_RUNTIME_COMPILER
+    return s_compile_threads < 0 ? SGL_WORK_QUEUE_MAX_THREADS : s_compile_threads;
+#else
+    return 0;
+#endif
+}
+
 GL_APICALL void GL_APIENTRY glUseProgram(GLuint program) {
     GET_CTX();
 
@@ -596,9 +1125,266 @@ GL_APICALL void GL_APIENTRY glUseProgram(GLuint program) {
         }
     }
 
+    SGL_CAPTURE(SGL_TRACE_USE_PROGRAM, program);
     SGL_TRACE_SHADER("glUseProgram(%u)", program);
 }
 
+/* ============================================================================
+ * Program Binaries (GL_OES_get_program_binary)
+ *
+ * Layout of GL_SGL_PROGRAM_BINARY_FORMAT_NX:
+ *   sgl_program_binary_header_t
+ *   num_uniforms x sgl_link_uniform_t     (packed uniform layout)
+ *   num_attribs x sgl_program_binary_attrib_t
+ *   vertex DKSH, fragment DKSH
+ *
+ * Loading one is a copy into code memory plus the program's uniform layout;
+ * libuam and the transpiler are not involved. Programs linked from
+ * precompiled DKSH carry no uniform layout (the application registers those
+ * itself).
+ * ============================================================================ */
+
+#define SGL_PROGRAM_BINARY_MAGIC    0x50474C53u  /* "SGLP" */
+#define SGL_PROGRAM_BINARY_VERSION  1u
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t code_size[2];
+    int32_t  packed_ubo_sizes[2][SGL_MAX_PACKED_UBOS];
+    uint32_t num_uniforms;
+    uint32_t num_attribs;
+} sgl_program_binary_header_t;
+
+typedef struct {
+    char     name[SGL_ATTRIB_NAME_MAX];
+    uint32_t index;
+} sgl_program_binary_attrib_t;
+
+/* Size of the binary for a linked program, 0 if it cannot be saved */
+static GLsizei sgl_program_binary_size(sgl_context_t *ctx, GLuint program, sgl_program_t *prog,
+                                       const void *code[2], uint32_t code_size[2]) {
+    if (!prog->linked || !ctx->backend || !ctx->backend->ops->get_program_code) return 0;
+    for (int stage = 0; stage < 2; stage++) {
+        if (!ctx->backend->ops->get_program_code(ctx->backend, program, stage,
+                                                 &code[stage], &code_size[stage])) {
+            return 0;
+        }
+    }
+
+    int num_attribs = 0;
+    for (int i = 0; i < prog->num_attrib_bindings; i++) {
+        if (prog->attrib_bindings[i].used) num_attribs++;
+    }
+    int num_uniforms = prog->link_reflection ? prog->link_reflection->num_uniforms : 0;
+
+    return (GLsizei)(sizeof(sgl_program_binary_header_t) +
+                     num_uniforms * sizeof(sgl_link_uniform_t) +
+                     num_attribs * sizeof(sgl_program_binary_attrib_t) +
+                     code_size[0] + code_size[1]);
+}
+
+GL_APICALL void GL_APIENTRY glGetProgramBinaryOES(GLuint program, GLsizei bufSize, GLsizei *length,
+                                                   GLenum *binaryFormat, void *binary) {
+    GET_CTX();
+
+    sgl_program_t *prog = GET_PROGRAM(program);
+    if (!prog) {
+        sgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    sgl_program_finish_link(ctx, program, prog);
+
+    const void *code[2];
+    uint32_t code_size[2];
+    GLsizei size = sgl_program_binary_size(ctx, program, prog, code, code_size);
+    if (size == 0 || bufSize < size || !binary) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        if (length) *length = 0;
+        return;
+    }
+
+    uint8_t *out = (uint8_t *)binary;
+    sgl_program_binary_header_t *hdr = (sgl_program_binary_header_t *)out;
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->magic = SGL_PROGRAM_BINARY_MAGIC;
+    hdr->version = SGL_PROGRAM_BINARY_VERSION;
+    hdr->code_size[0] = code_size[0];
+    hdr->code_size[1] = code_size[1];
+    out += sizeof(*hdr);
+
+    const sgl_link_reflection_t *r = prog->link_reflection;
+    if (r) {
+        memcpy(hdr->packed_ubo_sizes, r->packed_ubo_sizes, sizeof(hdr->packed_ubo_sizes));
+        hdr->num_uniforms = (uint32_t)r->num_uniforms;
+        memcpy(out, r->uniforms, r->num_uniforms * sizeof(sgl_link_uniform_t));
+        out += r->num_uniforms * sizeof(sgl_link_uniform_t);
+    }
+
+    for (int i = 0; i < prog->num_attrib_bindings; i++) {
+        if (!prog->attrib_bindings[i].used) continue;
+        sgl_program_binary_attrib_t attrib;
+        memset(&attrib, 0, sizeof(attrib));
+        memcpy(attrib.name, prog->attrib_bindings[i].name, SGL_ATTRIB_NAME_MAX);
+        attrib.index = prog->attrib_bindings[i].index;
+        memcpy(out, &attrib, sizeof(attrib));
+        out += sizeof(attrib);
+        hdr->num_attribs++;
+    }
+
+    memcpy(out, code[0], code_size[0]);
+    out += code_size[0];
+    memcpy(out, code[1], code_size[1]);
+
+    if (length) *length = size;
+    if (binaryFormat) *binaryFormat = GL_SGL_PROGRAM_BINARY_FORMAT_NX;
+    SGL_TRACE_SHADER("glGetProgramBinaryOES(%u) - %d bytes", program, size);
+}
+
+GL_APICALL void GL_APIENTRY glProgramBinaryOES(GLuint program, GLenum binaryFormat,
+                                                const void *binary, GLint length) {
+    GET_CTX();
+    sgl_flush_deferred(ctx);
+
+    sgl_program_t *prog = GET_PROGRAM(program);
+    if (!prog) {
+        sgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+    if (binaryFormat != GL_SGL_PROGRAM_BINARY_FORMAT_NX) {
+        sgl_set_error(ctx, GL_INVALID_ENUM);
+        return;
+    }
+
+    /* A binary that does not load leaves the program unlinked, without a GL error */
+    sgl_program_discard_link(prog);
+    prog->linked = false;
+    prog->revision = sgl_res_mgr_next_revision(ctx->res_mgr);
+
+    const uint8_t *in = (const uint8_t *)binary;
+    const sgl_program_binary_header_t *hdr = (const sgl_program_binary_header_t *)in;
+    if (!binary || length < (GLint)sizeof(*hdr) ||
+        hdr->magic != SGL_PROGRAM_BINARY_MAGIC || hdr->version != SGL_PROGRAM_BINARY_VERSION ||
+        hdr->num_attribs > SGL_MAX_ATTRIBS || hdr->num_uniforms > SGL_MAX_UNIFORMS * 2) {
+        SGL_TRACE_SHADER("glProgramBinaryOES(%u) - bad header", program);
+        return;
+    }
+
+    size_t expected = sizeof(*hdr) +
+                      hdr->num_uniforms * sizeof(sgl_link_uniform_t) +
+                      hdr->num_attribs * sizeof(sgl_program_binary_attrib_t) +
+                      (size_t)hdr->code_size[0] + hdr->code_size[1];
+    if ((size_t)length != expected) {
+        SGL_TRACE_SHADER("glProgramBinaryOES(%u) - size mismatch (%d != %zu)", program, length, expected);
+        return;
+    }
+
+    const sgl_link_uniform_t *uniforms = (const sgl_link_uniform_t *)(hdr + 1);
+    const sgl_program_binary_attrib_t *attribs =
+        (const sgl_program_binary_attrib_t *)(uniforms + hdr->num_uniforms);
+    const uint8_t *vs_code = (const uint8_t *)(attribs + hdr->num_attribs);
+    const uint8_t *fs_code = vs_code + hdr->code_size[0];
+
+    if (!ctx->backend || !ctx->backend->ops->load_program_binary ||
+        !ctx->backend->ops->load_program_binary(ctx->backend, program,
+                                                vs_code, hdr->code_size[0],
+                                                fs_code, hdr->code_size[1])) {
+        SGL_TRACE_SHADER("glProgramBinaryOES(%u) - backend rejected code", program);
+        return;
+    }
+
+    sgl_link_reflection_t *r = sgl_alloc_link_reflection((int)hdr->num_uniforms);
+    if (!r) {
+        sgl_set_error(ctx, GL_OUT_OF_MEMORY);
+        return;
+    }
+    memcpy(r->packed_ubo_sizes, hdr->packed_ubo_sizes, sizeof(r->packed_ubo_sizes));
+    r->num_uniforms = (int)hdr->num_uniforms;
+    memcpy(r->uniforms, uniforms, hdr->num_uniforms * sizeof(sgl_link_uniform_t));
+    for (int i = 0; i < r->num_uniforms; i++) {
+        r->uniforms[i].name[SGL_UNIFORM_NAME_MAX - 1] = '\0';
+    }
+    free(prog->link_reflection);
+    prog->link_reflection = r;
+    sgl_program_reset_uniforms(prog);
+
+    memset(prog->attrib_bindings, 0, sizeof(prog->attrib_bindings));
+    prog->num_attrib_bindings = (int)hdr->num_attribs;
+    for (uint32_t i = 0; i < hdr->num_attribs; i++) {
+        memcpy(prog->attrib_bindings[i].name, attribs[i].name, SGL_ATTRIB_NAME_MAX);
+        prog->attrib_bindings[i].name[SGL_ATTRIB_NAME_MAX - 1] = '\0';
+        prog->attrib_bindings[i].index = attribs[i].index;
+        prog->attrib_bindings[i].used = true;
+    }
+
+    prog->linked = true;
+    SGL_TRACE_SHADER("glProgramBinaryOES(%u) - %d bytes, %u uniforms, %u attribs",
+                     program, length, hdr->num_uniforms, hdr->num_attribs);
+}
+
+/* ============================================================================
+ * Shader Bundles (sgl_bundle.h)
+ *
+ * Every entry is a program binary; loading a bundle is one file read plus a
+ * glProgramBinaryOES per entry. Programs remember their bundle name, so
+ * loading a bundle again reloads the programs of the same names in place.
+ * ============================================================================ */
+
+/* Program loaded from a bundle entry of this name, 0 if none */
+static GLuint sgl_find_bundle_program(sgl_context_t *ctx, const char *name) {
+    GLuint end = sgl_res_mgr_program_end(ctx->res_mgr);
+    for (GLuint id = 1; id < end; id++) {
+        sgl_program_t *prog = GET_PROGRAM(id);
+        if (prog && prog->bundle_name && strcmp(prog->bundle_name, name) == 0) return id;
+    }
+    return 0;
+}
+
+GL_APICALL GLint GL_APIENTRY sglLoadShaderBundle(const GLchar *path) {
+    GET_CTX_RET(-1);
+    sgl_flush_deferred(ctx);
+
+    sgl_bundle_t *bundle = sgl_bundle_open(path);
+    if (!bundle) {
+        SGL_ERROR_SHADER("sglLoadShaderBundle: cannot read %s", path ? path : "(null)");
+        return -1;
+    }
+
+    GLint loaded = 0;
+    uint32_t count = sgl_bundle_count(bundle);
+    for (uint32_t i = 0; i < count; i++) {
+        sgl_bundle_entry_t entry;
+        sgl_bundle_entry(bundle, i, &entry);
+
+        GLuint program = sgl_find_bundle_program(ctx, entry.name);
+        if (program == 0) program = glCreateProgram();
+        sgl_program_t *prog = GET_PROGRAM(program);
+        if (!prog) break;  /* Out of names; glCreateProgram raised the error */
+
+        if (!prog->bundle_name) prog->bundle_name = strdup(entry.name);
+        glProgramBinaryOES(program, entry.format, entry.binary, (GLint)entry.size);
+        if (prog->linked) {
+            loaded++;
+        } else {
+            /* Built for another library version, or damaged */
+            SGL_WARN(SGL_LOG_CAT_SHADER, "[SHADER] %s: program %s did not load", path, entry.name);
+        }
+    }
+
+    sgl_bundle_close(bundle);
+    SGL_INFO(SGL_LOG_CAT_SHADER, "[SHADER] Loaded %d of %u programs from %s", loaded, count, path);
+    return loaded;
+}
+
+GL_APICALL GLuint GL_APIENTRY sglGetShaderBundleProgram(const GLchar *name) {
+    GET_CTX_RET(0);
+    if (!name) return 0;
+
+    GLuint program = sgl_find_bundle_program(ctx, name);
+    sgl_program_t *prog = program ? GET_PROGRAM(program) : NULL;
+    return prog && prog->linked ? program : 0;
+}
+
 GL_APICALL void GL_APIENTRY glGetProgramiv(GLuint program, GLenum pname, GLint *params) {
     GET_CTX();
     if (!params) return;
@@ -609,6 +1395,12 @@ GL_APICALL void GL_APIENTRY glGetProgramiv(GLuint program, GLenum pname, GLint *
         return;
     }
 
+    if (pname == GL_COMPLETION_STATUS_KHR) {
+        *params = sgl_program_link_pending(prog) ? GL_FALSE : GL_TRUE;
+        return;
+    }
+    sgl_program_finish_link(ctx, program, prog);
+
     switch (pname) {
         case GL_LINK_STATUS:
             *params = prog->linked ? GL_TRUE : GL_FALSE;
@@ -622,6 +1414,12 @@ GL_APICALL void GL_APIENTRY glGetProgramiv(GLuint program, GLenum pname, GLint *
         case GL_INFO_LOG_LENGTH:
             *params = 0;
             break;
+        case GL_PROGRAM_BINARY_LENGTH_OES: {
+            const void *code[2];
+            uint32_t code_size[2];
+            *params = sgl_program_binary_size(ctx, program, prog, code, code_size);
+            break;
+        }
         case GL_ATTACHED_SHADERS:
             *params = (prog->vertex_shader ? 1 : 0) + (prog->fragment_shader ? 1 : 0);
             break;
@@ -669,6 +1467,7 @@ GL_APICALL void GL_APIENTRY glGetProgramInfoLog(GLuint program, GLsizei bufSize,
         if (infoLog && bufSize > 0) infoLog[0] = '\0';
         return;
     }
+    sgl_program_finish_link(ctx, program, prog);
 
     /* Precompiled DKSH shaders: link always succeeds, no error log */
     if (length) *length = 0;
@@ -682,6 +1481,8 @@ GL_APICALL void GL_APIENTRY glValidateProgram(GLuint program) {
         sgl_set_error(ctx, GL_INVALID_VALUE);
         return;
     }
+    sgl_program_finish_link(ctx, program, prog);
+
     /* Validation status is queried via glGetProgramiv(GL_VALIDATE_STATUS)
      * For precompiled DKSH shaders, linked programs are always valid. */
     prog->validated = prog->linked;
@@ -709,12 +1510,20 @@ GL_APICALL void GL_APIENTRY glGetAttachedShaders(GLuint program, GLsizei maxCoun
     if (count) *count = n;
 }
 
+/*
+ * sglSetShaderCachePath - Directory for the runtime compiler's disk cache
+ */
+GL_APICALL void GL_APIENTRY sglSetShaderCachePath(const GLchar *path) {
+    sgl_shader_cache_set_path(path);
+    SGL_TRACE_SHADER("sglSetShaderCachePath(%s)", path ? path : "(disabled)");
+}
+
 /* Load pre-compiled shader from file - delegates to backend */
 bool sgl_load_shader_from_file(GLuint shader_id, const char *path) {
     sgl_context_t *ctx = sgl_get_current_context();
     if (!ctx || !ctx->backend || !ctx->backend->ops) return false;
 
-    sgl_shader_t *shader = sgl_res_mgr_get_shader(&ctx->res_mgr, shader_id);
+    sgl_shader_t *shader = sgl_res_mgr_get_shader(ctx->res_mgr, shader_id);
     if (!shader) return false;
 
     /* Call backend to load shader */
@@ -733,8 +1542,10 @@ bool sgl_load_shader_from_file(GLuint shader_id, const char *path) {
 bool sgl_bind_program_for_draw(sgl_context_t *ctx, GLuint program_id) {
     if (!ctx || !ctx->backend || !ctx->backend->ops) return false;
 
-    sgl_program_t *prog = sgl_res_mgr_get_program(&ctx->res_mgr, program_id);
-    if (!prog || !prog->linked) return false;
+    sgl_program_t *prog = GET_PROGRAM(program_id);
+    if (!prog) return false;
+    sgl_program_finish_link(ctx, program_id, prog);  /* Blocks only if still compiling */
+    if (!prog->linked) return false;
 
     /* Call backend to bind program with uniforms and shader handles */
     if (ctx->backend->ops->bind_program) {
@@ -749,5 +1560,16 @@ bool sgl_bind_program_for_draw(sgl_context_t *ctx, GLuint program_id) {
                                         SGL_MAX_PACKED_UBOS);
     }
 
+    /* The backend has the current contents now; unchanged UBOs are reused next draw,
+     * the next legacy uniform write gets a fresh slot */
+    for (int i = 0; i < SGL_MAX_PACKED_UBOS; i++) {
+        prog->packed_vertex[i].dirty = false;
+        prog->packed_fragment[i].dirty = false;
+    }
+    for (int i = 0; i < SGL_MAX_UNIFORMS; i++) {
+        prog->vertex_uniforms[i].dirty = false;
+        prog->fragment_uniforms[i].dirty = false;
+    }
+
     return true;
 }
@@ -5,28 +5,45 @@
 
 #include "gl_common.h"
 
-/* Apply blend state to backend */
-static void apply_blend(sgl_context_t *ctx) {
-    if (ctx->backend && ctx->backend->ops->apply_blend) {
-        sgl_blend_state_t bs;
-        bs.enabled = ctx->blend_state.enabled;
-        bs.src_rgb = ctx->blend_state.src_rgb;
-        bs.dst_rgb = ctx->blend_state.dst_rgb;
-        bs.src_alpha = ctx->blend_state.src_alpha;
-        bs.dst_alpha = ctx->blend_state.dst_alpha;
-        bs.equation_rgb = ctx->blend_state.equation_rgb;
-        bs.equation_alpha = ctx->blend_state.equation_alpha;
-        bs.color[0] = ctx->blend_state.color[0];
-        bs.color[1] = ctx->blend_state.color[1];
-        bs.color[2] = ctx->blend_state.color[2];
-        bs.color[3] = ctx->blend_state.color[3];
-        ctx->backend->ops->apply_blend(ctx->backend, &bs);
+/* ---- Dirty State Emission ---- */
+
+static void emit_viewport(sgl_context_t *ctx) {
+    if (ctx->backend->ops->apply_viewport) {
+        sgl_viewport_state_t vs = {
+            ctx->viewport_state.viewport_x,
+            ctx->viewport_state.viewport_y,
+            ctx->viewport_state.viewport_width,
+            ctx->viewport_state.viewport_height,
+            ctx->viewport_state.depth_near,
+            ctx->viewport_state.depth_far
+        };
+        ctx->backend->ops->apply_viewport(ctx->backend, &vs);
+    }
+}
+
+static void emit_scissor(sgl_context_t *ctx) {
+    if (ctx->backend->ops->apply_scissor) {
+        sgl_scissor_state_t ss;
+        if (ctx->viewport_state.scissor_enabled) {
+            ss.x = ctx->viewport_state.scissor_x;
+            ss.y = ctx->viewport_state.scissor_y;
+            ss.width = ctx->viewport_state.scissor_width;
+            ss.height = ctx->viewport_state.scissor_height;
+        } else {
+            /* Scissor disabled - use full viewport */
+            ss.x = ctx->viewport_state.viewport_x;
+            ss.y = ctx->viewport_state.viewport_y;
+            ss.width = ctx->viewport_state.viewport_width;
+            ss.height = ctx->viewport_state.viewport_height;
+        }
+        ss.enabled = ctx->viewport_state.scissor_enabled;
+        ctx->backend->ops->apply_scissor(ctx->backend, &ss);
     }
 }
 
-/* Apply combined depth-stencil state to backend (preferred - avoids overwrite issues) */
-static void apply_depth_stencil(sgl_context_t *ctx) {
-    if (ctx->backend && ctx->backend->ops->apply_depth_stencil) {
+/* Combined depth-stencil state (preferred - avoids overwrite issues) */
+static void emit_depth_stencil(sgl_context_t *ctx) {
+    if (ctx->backend->ops->apply_depth_stencil) {
         sgl_depth_stencil_state_t dss;
         /* Depth state */
         dss.depth_test_enabled = ctx->depth_state.depth_test_enabled;
@@ -51,21 +68,38 @@ static void apply_depth_stencil(sgl_context_t *ctx) {
         dss.stencil_back.zpass_op = ctx->depth_state.back.zpass_op;
         dss.stencil_clear_value = ctx->depth_state.clear_stencil;
         ctx->backend->ops->apply_depth_stencil(ctx->backend, &dss);
+    } else if (ctx->backend->ops->apply_depth) {
+        /* Fallback to separate calls if combined not available */
+        sgl_depth_state_t ds = {
+            ctx->depth_state.depth_test_enabled,
+            ctx->depth_state.depth_write_enabled,
+            ctx->depth_state.depth_func,
+            ctx->depth_state.clear_depth
+        };
+        ctx->backend->ops->apply_depth(ctx->backend, &ds);
     }
 }
 
-/* Legacy separate apply functions - now just call the combined version */
-static void apply_depth(sgl_context_t *ctx) {
-    apply_depth_stencil(ctx);
-}
-
-static void apply_stencil(sgl_context_t *ctx) {
-    apply_depth_stencil(ctx);
+static void emit_blend(sgl_context_t *ctx) {
+    if (ctx->backend->ops->apply_blend) {
+        sgl_blend_state_t bs;
+        bs.enabled = ctx->blend_state.enabled;
+        bs.src_rgb = ctx->blend_state.src_rgb;
+        bs.dst_rgb = ctx->blend_state.dst_rgb;
+        bs.src_alpha = ctx->blend_state.src_alpha;
+        bs.dst_alpha = ctx->blend_state.dst_alpha;
+        bs.equation_rgb = ctx->blend_state.equation_rgb;
+        bs.equation_alpha = ctx->blend_state.equation_alpha;
+        bs.color[0] = ctx->blend_state.color[0];
+        bs.color[1] = ctx->blend_state.color[1];
+        bs.color[2] = ctx->blend_state.color[2];
+        bs.color[3] = ctx->blend_state.color[3];
+        ctx->backend->ops->apply_blend(ctx->backend, &bs);
+    }
 }
 
-/* Apply raster state to backend */
-static void apply_raster(sgl_context_t *ctx) {
-    if (ctx->backend && ctx->backend->ops->apply_raster) {
+static void emit_raster(sgl_context_t *ctx) {
+    if (ctx->backend->ops->apply_raster) {
         sgl_raster_state_t rs;
         rs.cull_enabled = ctx->raster_state.cull_enabled;
         rs.cull_mode = ctx->raster_state.cull_mode;
@@ -74,9 +108,8 @@ static void apply_raster(sgl_context_t *ctx) {
     }
 }
 
-/* Apply color mask to backend */
-static void apply_color_mask(sgl_context_t *ctx) {
-    if (ctx->backend && ctx->backend->ops->apply_color_mask) {
+static void emit_color_mask(sgl_context_t *ctx) {
+    if (ctx->backend->ops->apply_color_mask) {
         sgl_color_state_t cs;
         cs.mask[0] = ctx->color_state.mask[0];
         cs.mask[1] = ctx->color_state.mask[1];
@@ -90,6 +123,50 @@ static void apply_color_mask(sgl_context_t *ctx) {
     }
 }
 
+static void emit_depth_bias(sgl_context_t *ctx) {
+    if (ctx->backend->ops->set_depth_bias) {
+        if (ctx->raster_state.polygon_offset_fill_enabled) {
+            ctx->backend->ops->set_depth_bias(ctx->backend,
+                ctx->raster_state.polygon_offset_factor,
+                ctx->raster_state.polygon_offset_units);
+        } else {
+            ctx->backend->ops->set_depth_bias(ctx->backend, 0.0f, 0.0f);
+        }
+    }
+}
+
+/*
+ * Emit only the state groups that changed since the last draw.
+ * If the backend reset its command buffer since we last looked, everything
+ * recorded so far is gone and all groups are considered dirty.
+ */
+void sgl_apply_dirty_state(sgl_context_t *ctx) {
+    if (!ctx->backend || !ctx->backend->ops) return;
+
+    if (ctx->backend->ops->get_state_generation) {
+        uint32_t gen = ctx->backend->ops->get_state_generation(ctx->backend);
+        if (gen != ctx->backend_state_generation) {
+            ctx->backend_state_generation = gen;
+            ctx->dirty_state = SGL_DIRTY_ALL;
+        }
+    }
+
+    uint32_t dirty = ctx->dirty_state;
+    if (!dirty) return;
+
+    if (dirty & SGL_DIRTY_VIEWPORT)      emit_viewport(ctx);
+    if (dirty & SGL_DIRTY_DEPTH_STENCIL) emit_depth_stencil(ctx);
+    if (dirty & SGL_DIRTY_BLEND)         emit_blend(ctx);
+    if (dirty & SGL_DIRTY_RASTER)        emit_raster(ctx);
+    if (dirty & SGL_DIRTY_COLOR_MASK)    emit_color_mask(ctx);
+    if (dirty & SGL_DIRTY_SCISSOR)       emit_scissor(ctx);
+    if (dirty & SGL_DIRTY_DEPTH_BIAS)    emit_depth_bias(ctx);
+
+    ctx->dirty_state = 0;
+
+    SGL_TRACE_STATE("apply_dirty_state mask=0x%X", dirty);
+}
+
 /* Enable/Disable */
 
 GL_APICALL void GL_APIENTRY glEnable(GLenum cap) {
@@ -98,35 +175,32 @@ GL_APICALL void GL_APIENTRY glEnable(GLenum cap) {
     switch (cap) {
         case GL_DEPTH_TEST:
             if (sgl_state_depth_set_test_enabled(&ctx->depth_state, true)) {
-                apply_depth(ctx);
+                sgl_context_mark_dirty(ctx, SGL_DIRTY_DEPTH_STENCIL);
             }
             break;
         case GL_STENCIL_TEST:
             if (sgl_state_stencil_set_test_enabled(&ctx->depth_state, true)) {
-                apply_stencil(ctx);
+                sgl_context_mark_dirty(ctx, SGL_DIRTY_DEPTH_STENCIL);
             }
             break;
         case GL_BLEND:
             if (sgl_state_blend_set_enabled(&ctx->blend_state, true)) {
-                apply_blend(ctx);
+                sgl_context_mark_dirty(ctx, SGL_DIRTY_BLEND);
             }
             break;
         case GL_CULL_FACE:
             if (sgl_state_raster_set_cull_enabled(&ctx->raster_state, true)) {
-                apply_raster(ctx);
+                sgl_context_mark_dirty(ctx, SGL_DIRTY_RASTER);
             }
             break;
         case GL_SCISSOR_TEST:
-            sgl_state_scissor_set_enabled(&ctx->viewport_state, true);
+            if (sgl_state_scissor_set_enabled(&ctx->viewport_state, true)) {
+                sgl_context_mark_dirty(ctx, SGL_DIRTY_SCISSOR);
+            }
             break;
         case GL_POLYGON_OFFSET_FILL:
             ctx->raster_state.polygon_offset_fill_enabled = true;
-            /* Apply current offset values */
-            if (ctx->backend && ctx->backend->ops->set_depth_bias) {
-                ctx->backend->ops->set_depth_bias(ctx->backend,
-                    ctx->raster_state.polygon_offset_factor,
-                    ctx->raster_state.polygon_offset_units);
-            }
+            sgl_context_mark_dirty(ctx, SGL_DIRTY_DEPTH_BIAS);
             break;
         case GL_DITHER:
             ctx->dither_enabled = true;
@@ -142,6 +216,7 @@ GL_APICALL void GL_APIENTRY glEnable(GLenum cap) {
             return;
     }
 
+    SGL_CAPTURE(SGL_TRACE_ENABLE, cap);
     SGL_TRACE_STATE("glEnable(0x%X)", cap);
 }
 
@@ -151,33 +226,32 @@ GL_APICALL void GL_APIENTRY glDisable(GLenum cap) {
     switch (cap) {
         case GL_DEPTH_TEST:
             if (sgl_state_depth_set_test_enabled(&ctx->depth_state, false)) {
-                apply_depth(ctx);
+                sgl_context_mark_dirty(ctx, SGL_DIRTY_DEPTH_STENCIL);
             }
             break;
         case GL_STENCIL_TEST:
             if (sgl_state_stencil_set_test_enabled(&ctx->depth_state, false)) {
-                apply_stencil(ctx);
+                sgl_context_mark_dirty(ctx, SGL_DIRTY_DEPTH_STENCIL);
             }
             break;
         case GL_BLEND:
             if (sgl_state_blend_set_enabled(&ctx->blend_state, false)) {
-                apply_blend(ctx);
+                sgl_context_mark_dirty(ctx, SGL_DIRTY_BLEND);
             }
             break;
         case GL_CULL_FACE:
             if (sgl_state_raster_set_cull_enabled(&ctx->raster_state, false)) {
-                apply_raster(ctx);
+                sgl_context_mark_dirty(ctx, SGL_DIRTY_RASTER);
             }
             break;
         case GL_SCISSOR_TEST:
-            sgl_state_scissor_set_enabled(&ctx->viewport_state, false);
+            if (sgl_state_scissor_set_enabled(&ctx->viewport_state, false)) {
+                sgl_context_mark_dirty(ctx, SGL_DIRTY_SCISSOR);
+            }
             break;
         case GL_POLYGON_OFFSET_FILL:
             ctx->raster_state.polygon_offset_fill_enabled = false;
-            /* Disable depth bias */
-            if (ctx->backend && ctx->backend->ops->set_depth_bias) {
-                ctx->backend->ops->set_depth_bias(ctx->backend, 0.0f, 0.0f);
-            }
+            sgl_context_mark_dirty(ctx, SGL_DIRTY_DEPTH_BIAS);
             break;
         case GL_DITHER:
             ctx->dither_enabled = false;
@@ -193,6 +267,7 @@ GL_APICALL void GL_APIENTRY glDisable(GLenum cap) {
             return;
     }
 
+    SGL_CAPTURE(SGL_TRACE_DISABLE, cap);
     SGL_TRACE_STATE("glDisable(0x%X)", cap);
 }
 
@@ -259,16 +334,18 @@ GL_APICALL void GL_APIENTRY glDepthFunc(GLenum func) {
         return;
     }
     if (sgl_state_depth_set_func(&ctx->depth_state, func)) {
-        apply_depth(ctx);
+        sgl_context_mark_dirty(ctx, SGL_DIRTY_DEPTH_STENCIL);
     }
+    SGL_CAPTURE(SGL_TRACE_DEPTH_FUNC, func);
     SGL_TRACE_STATE("glDepthFunc(0x%X)", func);
 }
 
 GL_APICALL void GL_APIENTRY glDepthMask(GLboolean flag) {
     GET_CTX();
     if (sgl_state_depth_set_write_enabled(&ctx->depth_state, flag != 0)) {
-        apply_depth(ctx);
+        sgl_context_mark_dirty(ctx, SGL_DIRTY_DEPTH_STENCIL);
     }
+    SGL_CAPTURE(SGL_TRACE_DEPTH_MASK, flag);
     SGL_TRACE_STATE("glDepthMask(%d)", flag);
 }
 
@@ -281,8 +358,9 @@ GL_APICALL void GL_APIENTRY glBlendFunc(GLenum sfactor, GLenum dfactor) {
         return;
     }
     if (sgl_state_blend_set_func(&ctx->blend_state, sfactor, dfactor, sfactor, dfactor)) {
-        apply_blend(ctx);
+        sgl_context_mark_dirty(ctx, SGL_DIRTY_BLEND);
     }
+    SGL_CAPTURE(SGL_TRACE_BLEND_FUNC, sfactor, dfactor);
     SGL_TRACE_STATE("glBlendFunc(0x%X, 0x%X)", sfactor, dfactor);
 }
 
@@ -294,8 +372,9 @@ GL_APICALL void GL_APIENTRY glBlendFuncSeparate(GLenum srcRGB, GLenum dstRGB, GL
         return;
     }
     if (sgl_state_blend_set_func(&ctx->blend_state, srcRGB, dstRGB, srcAlpha, dstAlpha)) {
-        apply_blend(ctx);
+        sgl_context_mark_dirty(ctx, SGL_DIRTY_BLEND);
     }
+    SGL_CAPTURE(SGL_TRACE_BLEND_FUNC_SEPARATE, srcRGB, dstRGB, srcAlpha, dstAlpha);
     SGL_TRACE_STATE("glBlendFuncSeparate(0x%X, 0x%X, 0x%X, 0x%X)", srcRGB, dstRGB, srcAlpha, dstAlpha);
 }
 
@@ -306,8 +385,9 @@ GL_APICALL void GL_APIENTRY glBlendEquation(GLenum mode) {
         return;
     }
     if (sgl_state_blend_set_equation(&ctx->blend_state, mode, mode)) {
-        apply_blend(ctx);
+        sgl_context_mark_dirty(ctx, SGL_DIRTY_BLEND);
     }
+    SGL_CAPTURE(SGL_TRACE_BLEND_EQUATION, mode);
     SGL_TRACE_STATE("glBlendEquation(0x%X)", mode);
 }
 
@@ -318,18 +398,19 @@ GL_APICALL void GL_APIENTRY glBlendEquationSeparate(GLenum modeRGB, GLenum modeA
         return;
     }
     if (sgl_state_blend_set_equation(&ctx->blend_state, modeRGB, modeAlpha)) {
-        apply_blend(ctx);
+        sgl_context_mark_dirty(ctx, SGL_DIRTY_BLEND);
     }
+    SGL_CAPTURE(SGL_TRACE_BLEND_EQUATION_SEPARATE, modeRGB, modeAlpha);
     SGL_TRACE_STATE("glBlendEquationSeparate(0x%X, 0x%X)", modeRGB, modeAlpha);
 }
 
 GL_APICALL void GL_APIENTRY glBlendColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
     GET_CTX();
-    ctx->blend_state.color[0] = red;
-    ctx->blend_state.color[1] = green;
-    ctx->blend_state.color[2] = blue;
-    ctx->blend_state.color[3] = alpha;
-    apply_blend(ctx);
+    if (sgl_state_blend_set_color(&ctx->blend_state, red, green, blue, alpha)) {
+        sgl_context_mark_dirty(ctx, SGL_DIRTY_BLEND);
+    }
+    SGL_CAPTURE(SGL_TRACE_BLEND_COLOR, sgl_capture_float(red), sgl_capture_float(green),
+                sgl_capture_float(blue), sgl_capture_float(alpha));
     SGL_TRACE_STATE("glBlendColor(%.2f, %.2f, %.2f, %.2f)", red, green, blue, alpha);
 }
 
@@ -342,8 +423,9 @@ GL_APICALL void GL_APIENTRY glCullFace(GLenum mode) {
         return;
     }
     if (sgl_state_raster_set_cull_mode(&ctx->raster_state, mode)) {
-        apply_raster(ctx);
+        sgl_context_mark_dirty(ctx, SGL_DIRTY_RASTER);
     }
+    SGL_CAPTURE(SGL_TRACE_CULL_FACE, mode);
     SGL_TRACE_STATE("glCullFace(0x%X)", mode);
 }
 
@@ -354,8 +436,9 @@ GL_APICALL void GL_APIENTRY glFrontFace(GLenum mode) {
         return;
     }
     if (sgl_state_raster_set_front_face(&ctx->raster_state, mode)) {
-        apply_raster(ctx);
+        sgl_context_mark_dirty(ctx, SGL_DIRTY_RASTER);
     }
+    SGL_CAPTURE(SGL_TRACE_FRONT_FACE, mode);
     SGL_TRACE_STATE("glFrontFace(0x%X)", mode);
 }
 
@@ -365,8 +448,9 @@ GL_APICALL void GL_APIENTRY glColorMask(GLboolean red, GLboolean green, GLboolea
     GET_CTX();
     if (sgl_state_color_set_mask(&ctx->color_state, red != 0, green != 0,
                                   blue != 0, alpha != 0)) {
-        apply_color_mask(ctx);
+        sgl_context_mark_dirty(ctx, SGL_DIRTY_COLOR_MASK);
     }
+    SGL_CAPTURE(SGL_TRACE_COLOR_MASK, red, green, blue, alpha);
     SGL_TRACE_STATE("glColorMask(%d, %d, %d, %d)", red, green, blue, alpha);
 }
 
@@ -378,8 +462,10 @@ GL_APICALL void GL_APIENTRY glStencilFunc(GLenum func, GLint ref, GLuint mask) {
         sgl_set_error(ctx, GL_INVALID_ENUM);
         return;
     }
-    sgl_state_stencil_set_func(&ctx->depth_state, GL_FRONT_AND_BACK, func, ref, mask);
-    apply_stencil(ctx);
+    if (sgl_state_stencil_set_func(&ctx->depth_state, GL_FRONT_AND_BACK, func, ref, mask)) {
+        sgl_context_mark_dirty(ctx, SGL_DIRTY_DEPTH_STENCIL);
+    }
+    SGL_CAPTURE(SGL_TRACE_STENCIL_FUNC_SEPARATE, GL_FRONT_AND_BACK, func, (uint32_t)ref, mask);
     SGL_TRACE_STATE("glStencilFunc(0x%X, %d, 0x%X)", func, ref, mask);
 }
 
@@ -393,15 +479,19 @@ GL_APICALL void GL_APIENTRY glStencilFuncSeparate(GLenum face, GLenum func, GLin
         sgl_set_error(ctx, GL_INVALID_ENUM);
         return;
     }
-    sgl_state_stencil_set_func(&ctx->depth_state, face, func, ref, mask);
-    apply_stencil(ctx);
+    if (sgl_state_stencil_set_func(&ctx->depth_state, face, func, ref, mask)) {
+        sgl_context_mark_dirty(ctx, SGL_DIRTY_DEPTH_STENCIL);
+    }
+    SGL_CAPTURE(SGL_TRACE_STENCIL_FUNC_SEPARATE, face, func, (uint32_t)ref, mask);
     SGL_TRACE_STATE("glStencilFuncSeparate(0x%X, 0x%X, %d, 0x%X)", face, func, ref, mask);
 }
 
 GL_APICALL void GL_APIENTRY glStencilMask(GLuint mask) {
     GET_CTX();
-    sgl_state_stencil_set_write_mask(&ctx->depth_state, GL_FRONT_AND_BACK, mask);
-    apply_stencil(ctx);
+    if (sgl_state_stencil_set_write_mask(&ctx->depth_state, GL_FRONT_AND_BACK, mask)) {
+        sgl_context_mark_dirty(ctx, SGL_DIRTY_DEPTH_STENCIL);
+    }
+    SGL_CAPTURE(SGL_TRACE_STENCIL_MASK_SEPARATE, GL_FRONT_AND_BACK, mask);
     SGL_TRACE_STATE("glStencilMask(0x%X)", mask);
 }
 
@@ -411,8 +501,10 @@ GL_APICALL void GL_APIENTRY glStencilMaskSeparate(GLenum face, GLuint mask) {
         sgl_set_error(ctx, GL_INVALID_ENUM);
         return;
     }
-    sgl_state_stencil_set_write_mask(&ctx->depth_state, face, mask);
-    apply_stencil(ctx);
+    if (sgl_state_stencil_set_write_mask(&ctx->depth_state, face, mask)) {
+        sgl_context_mark_dirty(ctx, SGL_DIRTY_DEPTH_STENCIL);
+    }
+    SGL_CAPTURE(SGL_TRACE_STENCIL_MASK_SEPARATE, face, mask);
     SGL_TRACE_STATE("glStencilMaskSeparate(0x%X, 0x%X)", face, mask);
 }
 
@@ -422,8 +514,10 @@ GL_APICALL void GL_APIENTRY glStencilOp(GLenum fail, GLenum zfail, GLenum zpass)
         sgl_set_error(ctx, GL_INVALID_ENUM);
         return;
     }
-    sgl_state_stencil_set_op(&ctx->depth_state, GL_FRONT_AND_BACK, fail, zfail, zpass);
-    apply_stencil(ctx);
+    if (sgl_state_stencil_set_op(&ctx->depth_state, GL_FRONT_AND_BACK, fail, zfail, zpass)) {
+        sgl_context_mark_dirty(ctx, SGL_DIRTY_DEPTH_STENCIL);
+    }
+    SGL_CAPTURE(SGL_TRACE_STENCIL_OP_SEPARATE, GL_FRONT_AND_BACK, fail, zfail, zpass);
     SGL_TRACE_STATE("glStencilOp(0x%X, 0x%X, 0x%X)", fail, zfail, zpass);
 }
 
@@ -437,7 +531,9 @@ GL_APICALL void GL_APIENTRY glStencilOpSeparate(GLenum face, GLenum sfail, GLenu
         sgl_set_error(ctx, GL_INVALID_ENUM);
         return;
     }
-    sgl_state_stencil_set_op(&ctx->depth_state, face, sfail, dpfail, dppass);
-    apply_stencil(ctx);
+    if (sgl_state_stencil_set_op(&ctx->depth_state, face, sfail, dpfail, dppass)) {
+        sgl_context_mark_dirty(ctx, SGL_DIRTY_DEPTH_STENCIL);
+    }
+    SGL_CAPTURE(SGL_TRACE_STENCIL_OP_SEPARATE, face, sfail, dpfail, dppass);
     SGL_TRACE_STATE("glStencilOpSeparate(0x%X, 0x%X, 0x%X, 0x%X)", face, sfail, dpfail, dppass);
 }
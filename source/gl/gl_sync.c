@@ -0,0 +1,144 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * GL Layer - Fence Sync Objects (GL_APPLE_sync)
+ *
+ * glFenceSyncAPPLE submits the work recorded so far (without waiting) and
+ * returns a fence the CPU can wait on, so streaming code can wait for one
+ * upload or readback instead of draining the queue with glFinish. Syncs
+ * live in the same pool as EGL_KHR_fence_sync objects (sgl_sync.h).
+ * Everything runs on one GPU queue in order, so glWaitSyncAPPLE has
+ * nothing to wait for. Fences cannot be made while recording on a worker
+ * thread (sglBeginRecorder).
+ *
+ * IMPORTANT: This file must NOT include deko3d.h or use any dk*() calls!
+ * All GPU operations go through ctx->backend->ops->xxx()
+ */
+
+#include "gl_common.h"
+#include "../context/sgl_sync.h"
+
+GL_APICALL void GL_APIENTRY glGetInteger64vEXT(GLenum pname, GLint64 *params);
+
+/* A GLsync the caller passed, or NULL with GL_INVALID_VALUE set */
+static sgl_sync_t *sgl_sync_get(sgl_context_t *ctx, GLsync sync) {
+    sgl_sync_t *s = sgl_sync_lookup(sync);
+    if (!s) sgl_set_error(ctx, GL_INVALID_VALUE);
+    return s;
+}
+
+GL_APICALL GLsync GL_APIENTRY glFenceSyncAPPLE(GLenum condition, GLbitfield flags) {
+    GET_CTX_RET(NULL);
+    CHECK_BACKEND_RET(NULL);
+    sgl_flush_deferred(ctx);
+
+    if (condition != GL_SYNC_GPU_COMMANDS_COMPLETE_APPLE) {
+        sgl_set_error(ctx, GL_INVALID_ENUM);
+        return NULL;
+    }
+    if (flags != 0) {
+        sgl_set_error(ctx, GL_INVALID_VALUE);
+        return NULL;
+    }
+    if (ctx->recorder) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return NULL;
+    }
+
+    sgl_ensure_frame_ready();
+    sgl_sync_t *s = sgl_sync_create(ctx->backend);
+    if (!s) {
+        sgl_set_error(ctx, GL_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    SGL_TRACE_CORE("glFenceSyncAPPLE() -> %p", (void *)s);
+    return (GLsync)s;
+}
+
+GL_APICALL GLboolean GL_APIENTRY glIsSyncAPPLE(GLsync sync) {
+    GET_CTX_RET(GL_FALSE);
+    return sgl_sync_lookup(sync) ? GL_TRUE : GL_FALSE;
+}
+
+GL_APICALL void GL_APIENTRY glDeleteSyncAPPLE(GLsync sync) {
+    GET_CTX();
+
+    if (!sync) return;
+    sgl_sync_t *s = sgl_sync_get(ctx, sync);
+    if (!s) return;
+    sgl_sync_delete(s);
+
+    SGL_TRACE_CORE("glDeleteSyncAPPLE(%p)", (void *)sync);
+}
+
+GL_APICALL GLenum GL_APIENTRY glClientWaitSyncAPPLE(GLsync sync, GLbitfield flags, GLuint64 timeout) {
+    GET_CTX_RET(GL_WAIT_FAILED_APPLE);
+    sgl_flush_deferred(ctx);
+
+    sgl_sync_t *s = sgl_sync_get(ctx, sync);
+    if (!s) return GL_WAIT_FAILED_APPLE;
+    if (flags & ~GL_SYNC_FLUSH_COMMANDS_BIT_APPLE) {
+        sgl_set_error(ctx, GL_INVALID_VALUE);
+        return GL_WAIT_FAILED_APPLE;
+    }
+
+    /* The fence was submitted when it was made: the flush bit has nothing to do */
+    if (sgl_sync_wait(s, 0)) return GL_ALREADY_SIGNALED_APPLE;
+    if (timeout == 0) return GL_TIMEOUT_EXPIRED_APPLE;
+
+    GLenum result = sgl_sync_wait(s, timeout) ? GL_CONDITION_SATISFIED_APPLE
+                                              : GL_TIMEOUT_EXPIRED_APPLE;
+    SGL_TRACE_CORE("glClientWaitSyncAPPLE(%p, %llu) -> 0x%X", (void *)sync,
+                   (unsigned long long)timeout, result);
+    return result;
+}
+
+GL_APICALL void GL_APIENTRY glWaitSyncAPPLE(GLsync sync, GLbitfield flags, GLuint64 timeout) {
+    GET_CTX();
+    sgl_flush_deferred(ctx);
+
+    if (!sgl_sync_get(ctx, sync)) return;
+    if (flags != 0 || timeout != GL_TIMEOUT_IGNORED_APPLE) {
+        sgl_set_error(ctx, GL_INVALID_VALUE);
+    }
+}
+
+GL_APICALL void GL_APIENTRY glGetInteger64vAPPLE(GLenum pname, GLint64 *params) {
+    GET_CTX();
+
+    if (!params) return;
+    if (pname == GL_MAX_SERVER_WAIT_TIMEOUT_APPLE) {
+        /* glWaitSyncAPPLE only accepts GL_TIMEOUT_IGNORED_APPLE */
+        *params = 0;
+        return;
+    }
+    glGetInteger64vEXT(pname, params);
+}
+
+GL_APICALL void GL_APIENTRY glGetSyncivAPPLE(GLsync sync, GLenum pname, GLsizei bufSize,
+                                              GLsizei *length, GLint *values) {
+    GET_CTX();
+
+    sgl_sync_t *s = sgl_sync_get(ctx, sync);
+    if (!s) return;
+    if (bufSize < 0) {
+        sgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+
+    GLint value;
+    switch (pname) {
+        case GL_OBJECT_TYPE_APPLE:      value = GL_SYNC_FENCE_APPLE; break;
+        case GL_SYNC_CONDITION_APPLE:   value = GL_SYNC_GPU_COMMANDS_COMPLETE_APPLE; break;
+        case GL_SYNC_FLAGS_APPLE:       value = 0; break;
+        case GL_SYNC_STATUS_APPLE:
+            value = sgl_sync_wait(s, 0) ? GL_SIGNALED_APPLE : GL_UNSIGNALED_APPLE;
+            break;
+        default:
+            sgl_set_error(ctx, GL_INVALID_ENUM);
+            return;
+    }
+
+    if (bufSize >= 1 && values) values[0] = value;
+    if (length) *length = bufSize >= 1 ? 1 : 0;
+}
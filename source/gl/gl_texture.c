@@ -4,58 +4,12 @@
  */
 
 #include "gl_common.h"
+#include "../util/sgl_texfile.h"
 
 /* Compute expected imageSize for compressed textures.
  * Returns 0 if the format is unknown (caller should skip validation). */
 static GLsizei sgl_compressed_image_size(GLenum format, GLsizei width, GLsizei height) {
-    /* All block-compressed formats use ceil(dim / blockW) * ceil(dim / blockH) * bytesPerBlock */
-    int bw = 4, bh = 4, bpb = 0;
-
-    switch (format) {
-        /* 8 bytes/block, 4x4 */
-        case GL_ETC1_RGB8_OES:
-        case GL_COMPRESSED_RGB8_ETC2:
-        case GL_COMPRESSED_SRGB8_ETC2:
-        case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
-        case GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
-        case GL_COMPRESSED_R11_EAC:
-        case GL_COMPRESSED_SIGNED_R11_EAC:
-        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
-        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
-            bpb = 8; break;
-
-        /* 16 bytes/block, 4x4 */
-        case GL_COMPRESSED_RGBA8_ETC2_EAC:
-        case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
-        case GL_COMPRESSED_RG11_EAC:
-        case GL_COMPRESSED_SIGNED_RG11_EAC:
-        case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
-        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
-            bpb = 16; break;
-
-        /* ASTC — all 16 bytes/block, varying block sizes */
-        case GL_COMPRESSED_RGBA_ASTC_4x4_KHR:   bw=4;  bh=4;  bpb=16; break;
-        case GL_COMPRESSED_RGBA_ASTC_5x4_KHR:   bw=5;  bh=4;  bpb=16; break;
-        case GL_COMPRESSED_RGBA_ASTC_5x5_KHR:   bw=5;  bh=5;  bpb=16; break;
-        case GL_COMPRESSED_RGBA_ASTC_6x5_KHR:   bw=6;  bh=5;  bpb=16; break;
-        case GL_COMPRESSED_RGBA_ASTC_6x6_KHR:   bw=6;  bh=6;  bpb=16; break;
-        case GL_COMPRESSED_RGBA_ASTC_8x5_KHR:   bw=8;  bh=5;  bpb=16; break;
-        case GL_COMPRESSED_RGBA_ASTC_8x6_KHR:   bw=8;  bh=6;  bpb=16; break;
-        case GL_COMPRESSED_RGBA_ASTC_8x8_KHR:   bw=8;  bh=8;  bpb=16; break;
-        case GL_COMPRESSED_RGBA_ASTC_10x5_KHR:  bw=10; bh=5;  bpb=16; break;
-        case GL_COMPRESSED_RGBA_ASTC_10x6_KHR:  bw=10; bh=6;  bpb=16; break;
-        case GL_COMPRESSED_RGBA_ASTC_10x8_KHR:  bw=10; bh=8;  bpb=16; break;
-        case GL_COMPRESSED_RGBA_ASTC_10x10_KHR: bw=10; bh=10; bpb=16; break;
-        case GL_COMPRESSED_RGBA_ASTC_12x10_KHR: bw=12; bh=10; bpb=16; break;
-        case GL_COMPRESSED_RGBA_ASTC_12x12_KHR: bw=12; bh=12; bpb=16; break;
-
-        default:
-            return 0; /* Unknown format — skip validation */
-    }
-
-    int blocks_w = (width + bw - 1) / bw;
-    int blocks_h = (height + bh - 1) / bh;
-    return (GLsizei)(blocks_w * blocks_h * bpb);
+    return (GLsizei)sgl_compressed_level_size(format, (uint32_t)width, (uint32_t)height);
 }
 
 /* Validate GLES2 format/type combinations per Table 3.4 of the GLES2 spec.
@@ -73,11 +27,39 @@ static bool sgl_validate_tex_format_type(GLenum format, GLenum type) {
         case GL_LUMINANCE:
         case GL_ALPHA:
             return type == GL_UNSIGNED_BYTE;
+        case GL_DEPTH_COMPONENT:   /* GL_OES_depth_texture */
+            return type == GL_UNSIGNED_SHORT || type == GL_UNSIGNED_INT;
+        case GL_DEPTH_STENCIL_OES: /* GL_OES_packed_depth_stencil */
+            return type == GL_UNSIGNED_INT_24_8_OES;
         default:
             return false;
     }
 }
 
+bool sgl_is_depth_format(GLenum format) {
+    return format == GL_DEPTH_COMPONENT || format == GL_DEPTH_STENCIL_OES;
+}
+
+/* Size of a dimension at a mip level, 0 past the end of the texture's chain */
+static GLsizei sgl_mip_dim(const sgl_texture_t *tex, GLsizei dim, GLint level) {
+    GLsizei largest = tex->width > tex->height ? tex->width : tex->height;
+    if (level >= 31 || (largest >> level) == 0) return 0;
+    return (dim >> level) > 0 ? dim >> level : 1;
+}
+
+static bool sgl_is_packed16_type(GLenum type) {
+    return type == GL_UNSIGNED_SHORT_5_6_5 ||
+           type == GL_UNSIGNED_SHORT_4_4_4_4 ||
+           type == GL_UNSIGNED_SHORT_5_5_5_1;
+}
+
+/* Sampler params must be forwarded again; command lists that bound the
+ * texture hold its old descriptor handle */
+static void sgl_texture_changed(sgl_context_t *ctx, sgl_texture_t *tex) {
+    tex->params_dirty = true;
+    tex->revision = sgl_res_mgr_next_revision(ctx->res_mgr);
+}
+
 GL_APICALL void GL_APIENTRY glGenTextures(GLsizei n, GLuint *textures) {
     GET_CTX();
 
@@ -87,18 +69,20 @@ GL_APICALL void GL_APIENTRY glGenTextures(GLsizei n, GLuint *textures) {
     }
 
     for (GLsizei i = 0; i < n; i++) {
-        textures[i] = sgl_res_mgr_alloc_texture(&ctx->res_mgr);
+        textures[i] = sgl_res_mgr_alloc_texture(ctx->res_mgr);
         if (textures[i] == 0) {
             sgl_set_error(ctx, GL_OUT_OF_MEMORY);
             return;
         }
     }
 
+    SGL_CAPTURE_DATA(SGL_TRACE_GEN_TEXTURES, textures, (uint32_t)n * 4, (uint32_t)n);
     SGL_TRACE_TEXTURE("glGenTextures(%d)", n);
 }
 
 GL_APICALL void GL_APIENTRY glDeleteTextures(GLsizei n, const GLuint *textures) {
     GET_CTX();
+    sgl_flush_deferred(ctx);
 
     if (n < 0) { sgl_set_error(ctx, GL_INVALID_VALUE); return; }
     if (!textures) return;
@@ -113,9 +97,15 @@ GL_APICALL void GL_APIENTRY glDeleteTextures(GLsizei n, const GLuint *textures)
             }
         }
 
-        sgl_res_mgr_free_texture(&ctx->res_mgr, id);
+        /* Let the backend recycle the texture's GPU storage */
+        if (GET_TEXTURE(id) && ctx->backend && ctx->backend->ops->delete_texture) {
+            ctx->backend->ops->delete_texture(ctx->backend, id);
+        }
+
+        sgl_res_mgr_free_texture(ctx->res_mgr, id);
     }
 
+    SGL_CAPTURE_DATA(SGL_TRACE_DELETE_TEXTURES, textures, (uint32_t)n * 4, (uint32_t)n);
     SGL_TRACE_TEXTURE("glDeleteTextures(%d)", n);
 }
 
@@ -133,6 +123,7 @@ GL_APICALL void GL_APIENTRY glActiveTexture(GLenum texture) {
     }
 
     ctx->active_texture_unit = texture - GL_TEXTURE0;
+    SGL_CAPTURE(SGL_TRACE_ACTIVE_TEXTURE, texture);
     SGL_TRACE_TEXTURE("glActiveTexture(GL_TEXTURE%d)", ctx->active_texture_unit);
 }
 
@@ -152,6 +143,7 @@ GL_APICALL void GL_APIENTRY glBindTexture(GLenum target, GLuint texture) {
 
     ctx->bound_textures[ctx->active_texture_unit] = texture;
 
+    SGL_CAPTURE(SGL_TRACE_BIND_TEXTURE, target, texture);
     SGL_TRACE_TEXTURE("glBindTexture(0x%X, %u)", target, texture);
 }
 
@@ -169,6 +161,7 @@ GL_APICALL void GL_APIENTRY glTexImage2D(GLenum target, GLint level, GLint inter
 
     GET_CTX();
     CHECK_BACKEND();
+    sgl_flush_deferred(ctx);
 
     /* Validate target: GL_TEXTURE_2D or one of the cubemap face targets */
     if (target != GL_TEXTURE_2D && !sgl_is_cubemap_face(target)) {
@@ -218,6 +211,12 @@ GL_APICALL void GL_APIENTRY glTexImage2D(GLenum target, GLint level, GLint inter
         return;
     }
 
+    /* Depth textures: 2D, single level */
+    if (sgl_is_depth_format(format) && (target != GL_TEXTURE_2D || level != 0)) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+
     /* Empty texture - silently return */
     if (width == 0 || height == 0) {
         return;
@@ -233,9 +232,13 @@ GL_APICALL void GL_APIENTRY glTexImage2D(GLenum target, GLint level, GLint inter
 
     /* Update GL-level texture state */
     tex->used = true;  /* Mark texture as used (important for draw-time binding) */
-    tex->width = width;
-    tex->height = height;
-    tex->internal_format = internalformat;
+    if (level == 0) {
+        /* Mip levels share the level 0 size and format */
+        tex->width = width;
+        tex->height = height;
+        tex->internal_format = internalformat;
+        tex->type = type;
+    }
     /* For cubemap faces, store the parent cubemap target */
     if (sgl_is_cubemap_face(target)) {
         tex->target = GL_TEXTURE_CUBE_MAP;
@@ -249,8 +252,13 @@ GL_APICALL void GL_APIENTRY glTexImage2D(GLenum target, GLint level, GLint inter
                                             target, level, internalformat,
                                             width, height, border,
                                             format, type, pixels);
+        sgl_texture_changed(ctx, tex);  /* Backend resets sampler params on (re)specification */
     }
 
+    SGL_CAPTURE_DATA(SGL_TRACE_TEX_IMAGE_2D, pixels,
+                     sgl_capture_pixels_size(ctx, width, height, format, type), target, (uint32_t)level,
+                     (uint32_t)internalformat, (uint32_t)width, (uint32_t)height, (uint32_t)border,
+                     format, type);
     SGL_TRACE_TEXTURE("glTexImage2D(target=0x%X, %dx%d, format=0x%X)", target, width, height, format);
 }
 
@@ -262,6 +270,7 @@ GL_APICALL void GL_APIENTRY glTexSubImage2D(GLenum target, GLint level, GLint xo
 
     GET_CTX();
     CHECK_BACKEND();
+    sgl_flush_deferred(ctx);
 
     if (target != GL_TEXTURE_2D && !sgl_is_cubemap_face(target)) {
         sgl_set_error(ctx, GL_INVALID_ENUM);
@@ -291,10 +300,22 @@ GL_APICALL void GL_APIENTRY glTexSubImage2D(GLenum target, GLint level, GLint xo
         return;
     }
 
-    /* Bounds checking: offsets + size must fit within texture */
+    /* Depth data only goes to depth textures and back */
+    if (sgl_is_depth_format(format) != sgl_is_depth_format(tex->internal_format)) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+
+    /* 16-bit textures keep their packed layout, so the type must match */
+    if (type != tex->type && (sgl_is_packed16_type(type) || sgl_is_packed16_type(tex->type))) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+
+    /* Bounds checking: offsets + size must fit within the level */
     if (xoffset < 0 || yoffset < 0 ||
-        xoffset + width > (GLsizei)tex->width ||
-        yoffset + height > (GLsizei)tex->height) {
+        xoffset + width > sgl_mip_dim(tex, tex->width, level) ||
+        yoffset + height > sgl_mip_dim(tex, tex->height, level)) {
         sgl_set_error(ctx, GL_INVALID_VALUE);
         return;
     }
@@ -308,6 +329,9 @@ GL_APICALL void GL_APIENTRY glTexSubImage2D(GLenum target, GLint level, GLint xo
                                                  format, type, pixels);
     }
 
+    SGL_CAPTURE_DATA(SGL_TRACE_TEX_SUB_IMAGE_2D, pixels,
+                     sgl_capture_pixels_size(ctx, width, height, format, type), target, (uint32_t)level,
+                     (uint32_t)xoffset, (uint32_t)yoffset, (uint32_t)width, (uint32_t)height, format, type);
     SGL_TRACE_TEXTURE("glTexSubImage2D(offset=%d,%d size=%dx%d)", xoffset, yoffset, width, height);
 }
 
@@ -326,6 +350,7 @@ GL_APICALL void GL_APIENTRY glTexParameterfv(GLenum target, GLenum pname, const
 
 GL_APICALL void GL_APIENTRY glTexParameteri(GLenum target, GLenum pname, GLint param) {
     GET_CTX();
+    sgl_flush_deferred(ctx);
 
     if (target != GL_TEXTURE_2D && target != GL_TEXTURE_CUBE_MAP) {
         sgl_set_error(ctx, GL_INVALID_ENUM);
@@ -347,34 +372,47 @@ GL_APICALL void GL_APIENTRY glTexParameteri(GLenum target, GLenum pname, GLint p
                 sgl_set_error(ctx, GL_INVALID_ENUM);
                 return;
             }
-            tex->min_filter = (GLenum)param;
+            if (tex->min_filter != (GLenum)param) {
+                tex->min_filter = (GLenum)param;
+                sgl_texture_changed(ctx, tex);
+            }
             break;
         case GL_TEXTURE_MAG_FILTER:
             if (param != GL_NEAREST && param != GL_LINEAR) {
                 sgl_set_error(ctx, GL_INVALID_ENUM);
                 return;
             }
-            tex->mag_filter = (GLenum)param;
+            if (tex->mag_filter != (GLenum)param) {
+                tex->mag_filter = (GLenum)param;
+                sgl_texture_changed(ctx, tex);
+            }
             break;
         case GL_TEXTURE_WRAP_S:
             if (param != GL_REPEAT && param != GL_CLAMP_TO_EDGE && param != GL_MIRRORED_REPEAT) {
                 sgl_set_error(ctx, GL_INVALID_ENUM);
                 return;
             }
-            tex->wrap_s = (GLenum)param;
+            if (tex->wrap_s != (GLenum)param) {
+                tex->wrap_s = (GLenum)param;
+                sgl_texture_changed(ctx, tex);
+            }
             break;
         case GL_TEXTURE_WRAP_T:
             if (param != GL_REPEAT && param != GL_CLAMP_TO_EDGE && param != GL_MIRRORED_REPEAT) {
                 sgl_set_error(ctx, GL_INVALID_ENUM);
                 return;
             }
-            tex->wrap_t = (GLenum)param;
+            if (tex->wrap_t != (GLenum)param) {
+                tex->wrap_t = (GLenum)param;
+                sgl_texture_changed(ctx, tex);
+            }
             break;
         default:
             sgl_set_error(ctx, GL_INVALID_ENUM);
             return;
     }
 
+    SGL_CAPTURE(SGL_TRACE_TEX_PARAMETERI, target, pname, (uint32_t)param);
     SGL_TRACE_TEXTURE("glTexParameteri(0x%X, 0x%X, %d)", target, pname, param);
 }
 
@@ -397,7 +435,7 @@ GL_APICALL void GL_APIENTRY glGetTexParameterfv(GLenum target, GLenum pname, GLf
     }
 
     GLuint tex_id = ctx->bound_textures[ctx->active_texture_unit];
-    sgl_texture_t *tex = (tex_id > 0) ? sgl_res_mgr_get_texture(&ctx->res_mgr, tex_id) : NULL;
+    sgl_texture_t *tex = (tex_id > 0) ? sgl_res_mgr_get_texture(ctx->res_mgr, tex_id) : NULL;
     if (!tex) {
         sgl_set_error(ctx, GL_INVALID_OPERATION);
         return;
@@ -424,7 +462,7 @@ GL_APICALL void GL_APIENTRY glGetTexParameteriv(GLenum target, GLenum pname, GLi
     }
 
     GLuint tex_id = ctx->bound_textures[ctx->active_texture_unit];
-    sgl_texture_t *tex = (tex_id > 0) ? sgl_res_mgr_get_texture(&ctx->res_mgr, tex_id) : NULL;
+    sgl_texture_t *tex = (tex_id > 0) ? sgl_res_mgr_get_texture(ctx->res_mgr, tex_id) : NULL;
     if (!tex) {
         sgl_set_error(ctx, GL_INVALID_OPERATION);
         return;
@@ -446,6 +484,7 @@ GL_APICALL void GL_APIENTRY glGenerateMipmap(GLenum target) {
 
     GET_CTX();
     CHECK_BACKEND();
+    sgl_flush_deferred(ctx);
 
     if (target != GL_TEXTURE_2D && target != GL_TEXTURE_CUBE_MAP) {
         sgl_set_error(ctx, GL_INVALID_ENUM);
@@ -460,7 +499,7 @@ GL_APICALL void GL_APIENTRY glGenerateMipmap(GLenum target) {
     }
 
     sgl_texture_t *tex = GET_TEXTURE(tex_id);
-    if (!tex || tex->width == 0 || tex->height == 0) {
+    if (!tex || tex->width == 0 || tex->height == 0 || sgl_is_depth_format(tex->internal_format)) {
         sgl_set_error(ctx, GL_INVALID_OPERATION);
         return;
     }
@@ -470,6 +509,7 @@ GL_APICALL void GL_APIENTRY glGenerateMipmap(GLenum target) {
         ctx->backend->ops->generate_mipmap(ctx->backend, tex_id);
     }
 
+    SGL_CAPTURE(SGL_TRACE_GENERATE_MIPMAP, target);
     SGL_TRACE_TEXTURE("glGenerateMipmap(0x%X) tex=%u", target, tex_id);
 }
 
@@ -477,6 +517,7 @@ GL_APICALL void GL_APIENTRY glCopyTexImage2D(GLenum target, GLint level, GLenum
                                               GLint x, GLint y, GLsizei width, GLsizei height, GLint border) {
     GET_CTX();
     CHECK_BACKEND();
+    sgl_flush_deferred(ctx);
 
     /* GLES2: border must be 0 */
     if (border != 0) {
@@ -494,6 +535,12 @@ GL_APICALL void GL_APIENTRY glCopyTexImage2D(GLenum target, GLint level, GLenum
         return;
     }
 
+    /* Depth textures cannot be copied into (GL_OES_depth_texture) */
+    if (sgl_is_depth_format(internalformat)) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+
     if (width <= 0 || height <= 0) {
         return;
     }
@@ -510,6 +557,7 @@ GL_APICALL void GL_APIENTRY glCopyTexImage2D(GLenum target, GLint level, GLenum
     tex->width = width;
     tex->height = height;
     tex->internal_format = internalformat;
+    tex->type = GL_UNSIGNED_BYTE;
     tex->target = sgl_is_cubemap_face(target) ? GL_TEXTURE_CUBE_MAP : target;
 
     /* Delegate to backend */
@@ -517,8 +565,11 @@ GL_APICALL void GL_APIENTRY glCopyTexImage2D(GLenum target, GLint level, GLenum
         ctx->backend->ops->copy_tex_image_2d(ctx->backend, tex_id,
                                               target, level, internalformat,
                                               x, y, width, height);
+        sgl_texture_changed(ctx, tex);  /* Backend resets sampler params on (re)specification */
     }
 
+    SGL_CAPTURE(SGL_TRACE_COPY_TEX_IMAGE_2D, target, (uint32_t)level, internalformat, (uint32_t)x,
+                (uint32_t)y, (uint32_t)width, (uint32_t)height, (uint32_t)border);
     SGL_TRACE_TEXTURE("glCopyTexImage2D(target=0x%X, %dx%d from (%d,%d))", target, width, height, x, y);
 }
 
@@ -526,6 +577,7 @@ GL_APICALL void GL_APIENTRY glCopyTexSubImage2D(GLenum target, GLint level, GLin
                                                  GLint x, GLint y, GLsizei width, GLsizei height) {
     GET_CTX();
     CHECK_BACKEND();
+    sgl_flush_deferred(ctx);
 
     if (target != GL_TEXTURE_2D && !sgl_is_cubemap_face(target)) {
         sgl_set_error(ctx, GL_INVALID_ENUM);
@@ -543,7 +595,7 @@ GL_APICALL void GL_APIENTRY glCopyTexSubImage2D(GLenum target, GLint level, GLin
 
     GLuint tex_id = ctx->bound_textures[ctx->active_texture_unit];
     sgl_texture_t *tex = GET_TEXTURE(tex_id);
-    if (!tex || tex_id == 0) {
+    if (!tex || tex_id == 0 || sgl_is_depth_format(tex->internal_format)) {
         sgl_set_error(ctx, GL_INVALID_OPERATION);
         return;
     }
@@ -564,6 +616,8 @@ GL_APICALL void GL_APIENTRY glCopyTexSubImage2D(GLenum target, GLint level, GLin
                                                   x, y, width, height);
     }
 
+    SGL_CAPTURE(SGL_TRACE_COPY_TEX_SUB_IMAGE_2D, target, (uint32_t)level, (uint32_t)xoffset,
+                (uint32_t)yoffset, (uint32_t)x, (uint32_t)y, (uint32_t)width, (uint32_t)height);
     SGL_TRACE_TEXTURE("glCopyTexSubImage2D(offset=%d,%d from (%d,%d) %dx%d)",
                       xoffset, yoffset, x, y, width, height);
 }
@@ -578,6 +632,7 @@ GL_APICALL void GL_APIENTRY glCompressedTexImage2D(GLenum target, GLint level, G
 
     GET_CTX();
     CHECK_BACKEND();
+    sgl_flush_deferred(ctx);
 
     /* Validate target: GL_TEXTURE_2D or cubemap face */
     if (target != GL_TEXTURE_2D && !sgl_is_cubemap_face(target)) {
@@ -632,6 +687,7 @@ GL_APICALL void GL_APIENTRY glCompressedTexImage2D(GLenum target, GLint level, G
     tex->width = width;
     tex->height = height;
     tex->internal_format = internalformat;
+    tex->type = 0;
     tex->target = sgl_is_cubemap_face(target) ? GL_TEXTURE_CUBE_MAP : target;
 
     /* Delegate to backend for actual GPU texture creation and upload */
@@ -640,8 +696,12 @@ GL_APICALL void GL_APIENTRY glCompressedTexImage2D(GLenum target, GLint level, G
                                                         target, level, internalformat,
                                                         width, height,
                                                         imageSize, data);
+        sgl_texture_changed(ctx, tex);  /* Backend resets sampler params on (re)specification */
     }
 
+    SGL_CAPTURE_DATA(SGL_TRACE_COMPRESSED_TEX_IMAGE_2D, data, (uint32_t)imageSize, target,
+                     (uint32_t)level, internalformat, (uint32_t)width, (uint32_t)height, (uint32_t)border,
+                     (uint32_t)imageSize);
     SGL_TRACE_TEXTURE("glCompressedTexImage2D(target=0x%X, %dx%d, format=0x%X, size=%d)",
                       target, width, height, internalformat, imageSize);
 }
@@ -654,6 +714,7 @@ GL_APICALL void GL_APIENTRY glCompressedTexSubImage2D(GLenum target, GLint level
 
     GET_CTX();
     CHECK_BACKEND();
+    sgl_flush_deferred(ctx);
 
     if (target != GL_TEXTURE_2D && !sgl_is_cubemap_face(target)) {
         sgl_set_error(ctx, GL_INVALID_ENUM);
@@ -699,5 +760,118 @@ GL_APICALL void GL_APIENTRY glCompressedTexSubImage2D(GLenum target, GLint level
                                                             format, imageSize, data);
     }
 
+    SGL_CAPTURE_DATA(SGL_TRACE_COMPRESSED_TEX_SUB_IMAGE_2D, data, (uint32_t)imageSize, target,
+                     (uint32_t)level, (uint32_t)xoffset, (uint32_t)yoffset, (uint32_t)width,
+                     (uint32_t)height, format, (uint32_t)imageSize);
     SGL_TRACE_TEXTURE("glCompressedTexSubImage2D(offset=%d,%d size=%dx%d)", xoffset, yoffset, width, height);
 }
+
+/* ============================================================================
+ * sglTexImageFromFile - streamed compressed texture loading
+ * ============================================================================ */
+
+typedef struct sgl_texfile_reader {
+    FILE *fp;
+    const sgl_texfile_t *info;
+    uint64_t pos;               /* Current file position (avoids redundant seeks) */
+} sgl_texfile_reader_t;
+
+static bool sgl_texfile_read(void *user, GLint level, uint32_t offset, void *dst, uint32_t size) {
+    sgl_texfile_reader_t *r = (sgl_texfile_reader_t *)user;
+    uint64_t pos = r->info->level_offset[level] + offset;
+    if (pos != r->pos && fseek(r->fp, (long)pos, SEEK_SET) != 0) {
+        return false;
+    }
+    size_t n = fread(dst, 1, size, r->fp);
+    r->pos = pos + n;
+    return n == size;
+}
+
+GL_APICALL GLboolean GL_APIENTRY sglTexImageFromFile(GLenum target, const GLchar *path) {
+    /* Ensure frame is ready before GPU work */
+    sgl_ensure_frame_ready();
+
+    GET_CTX_RET(GL_FALSE);
+    CHECK_BACKEND_RET(GL_FALSE);
+    sgl_flush_deferred(ctx);
+
+    if (target != GL_TEXTURE_2D) {
+        sgl_set_error(ctx, GL_INVALID_ENUM);
+        return GL_FALSE;
+    }
+
+    GLuint tex_id = ctx->bound_textures[ctx->active_texture_unit];
+    sgl_texture_t *tex = GET_TEXTURE(tex_id);
+    if (!tex || tex_id == 0 || !path || !ctx->backend->ops->compressed_texture_stream) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return GL_FALSE;
+    }
+
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        SGL_ERROR_TEXTURE("sglTexImageFromFile: cannot open %s", path);
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return GL_FALSE;
+    }
+
+    sgl_texfile_t info;
+    if (!sgl_texfile_parse(fp, &info) || info.width > 8192 || info.height > 8192) {
+        SGL_ERROR_TEXTURE("sglTexImageFromFile: %s is not a supported 2D texture container", path);
+        fclose(fp);
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return GL_FALSE;
+    }
+
+    tex->used = true;
+    tex->width = (GLsizei)info.width;
+    tex->height = (GLsizei)info.height;
+    tex->internal_format = info.internalformat;
+    tex->type = 0;
+    tex->target = target;
+
+    sgl_texfile_reader_t reader = { fp, &info, UINT64_MAX };
+    bool ok = ctx->backend->ops->compressed_texture_stream(ctx->backend, tex_id, info.internalformat,
+                                                           (GLsizei)info.width, (GLsizei)info.height,
+                                                           (GLint)info.levels, sgl_texfile_read, &reader);
+    sgl_texture_changed(ctx, tex);  /* Backend resets sampler params on (re)specification */
+    fclose(fp);
+
+    if (!ok) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+    }
+
+    SGL_TRACE_TEXTURE("sglTexImageFromFile(%s) %ux%u format=0x%X levels=%u ok=%d",
+                      path, info.width, info.height, info.internalformat, info.levels, ok);
+    return ok ? GL_TRUE : GL_FALSE;
+}
+
+/*
+ * sglCompactTextureHeap - Defragment GPU texture memory
+ */
+GL_APICALL void GL_APIENTRY sglCompactTextureHeap(void) {
+    GET_CTX();
+    CHECK_BACKEND();
+    sgl_flush_deferred(ctx);
+
+    if (ctx->backend->ops->compact_texture_heap) {
+        ctx->backend->ops->compact_texture_heap(ctx->backend);
+    }
+
+    SGL_TRACE_TEXTURE("sglCompactTextureHeap()");
+}
+
+/*
+ * sglSetTransferQueue - Run texture uploads on a copy-only GPU queue
+ */
+GL_APICALL GLboolean GL_APIENTRY sglSetTransferQueue(GLboolean enable) {
+    GET_CTX_RET(GL_FALSE);
+    CHECK_BACKEND_RET(GL_FALSE);
+
+    bool active = false;
+    if (ctx->backend->ops->set_transfer_queue) {
+        active = ctx->backend->ops->set_transfer_queue(ctx->backend, enable != GL_FALSE);
+    }
+
+    SGL_TRACE_TEXTURE("sglSetTransferQueue(%d) -> %d", enable, active);
+    return active ? GL_TRUE : GL_FALSE;
+}
@@ -6,6 +6,7 @@
 #include "gl_common.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 /*
  * ============================================================================
@@ -17,70 +18,86 @@
  */
 
 #define SGL_MAX_REGISTERED_UNIFORMS 256
-#define SGL_UNIFORM_NAME_MAX 64
+#define SGL_REGISTRY_HASH_SLOTS     512   /* Power of two, 2x the entry count */
 
 typedef struct {
     char name[SGL_UNIFORM_NAME_MAX];
+    uint32_t hash;
     int stage;       /* 0 = vertex, 1 = fragment */
     int binding;
     int byte_offset; /* -1 for legacy, >=0 for packed */
-    bool used;
 } sgl_uniform_entry_t;
 
 static sgl_uniform_entry_t s_registered_uniforms[SGL_MAX_REGISTERED_UNIFORMS];
 static int s_registered_count = 0;
-static bool s_registry_initialized = false;
+
+/* Open-addressed index into s_registered_uniforms (slot + 1, 0 = empty) */
+static int16_t s_registry_hash[SGL_REGISTRY_HASH_SLOTS];
+
+/* Bumped on every registry change; programs drop cached locations when it moves */
+static uint32_t s_registry_generation = 1;
 
 /* Packed UBO size registry (set via sglSetPackedUBOSize, applied to programs at glGetUniformLocation time) */
 static int s_packed_ubo_sizes[2][SGL_MAX_PACKED_UBOS]; /* [stage][binding] = size in bytes */
 
-/*
- * sglRegisterUniform - Register a uniform name to a specific shader binding
- */
-GL_APICALL GLboolean GL_APIENTRY sglRegisterUniform(const GLchar *name, GLint stage, GLint binding) {
-    if (!name || stage < 0 || stage > 1 || binding < 0 || binding >= SGL_MAX_UNIFORMS) {
-        return GL_FALSE;
-    }
-
-    size_t len = strlen(name);
-    if (len == 0 || len >= SGL_UNIFORM_NAME_MAX) {
-        return GL_FALSE;
+/* FNV-1a; uniform names are short, so this is cheaper than one strcmp chain */
+static uint32_t sgl_uniform_name_hash(const char *name) {
+    uint32_t h = 0x811c9dc5u;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+        h ^= *p;
+        h *= 0x01000193u;
     }
+    return h;
+}
 
-    /* Check if already registered - update if so */
-    for (int i = 0; i < s_registered_count; i++) {
-        if (s_registered_uniforms[i].used &&
-            strcmp(s_registered_uniforms[i].name, name) == 0) {
-            s_registered_uniforms[i].stage = stage;
-            s_registered_uniforms[i].binding = binding;
-            s_registered_uniforms[i].byte_offset = -1; /* legacy mode */
-            return GL_TRUE;
+static int sgl_registry_find(const char *name, uint32_t hash) {
+    for (uint32_t i = hash & (SGL_REGISTRY_HASH_SLOTS - 1);; i = (i + 1) & (SGL_REGISTRY_HASH_SLOTS - 1)) {
+        int slot = s_registry_hash[i] - 1;
+        if (slot < 0) return -1;
+        if (s_registered_uniforms[slot].hash == hash &&
+            strcmp(s_registered_uniforms[slot].name, name) == 0) {
+            return slot;
         }
     }
+}
 
-    /* Find empty slot or add new entry */
-    int slot = -1;
-    for (int i = 0; i < s_registered_count; i++) {
-        if (!s_registered_uniforms[i].used) {
-            slot = i;
-            break;
-        }
-    }
+/* Find or add the entry for name; NULL if the name is invalid or the registry is full */
+static sgl_uniform_entry_t *sgl_registry_insert(const GLchar *name) {
+    size_t len = strlen(name);
+    if (len == 0 || len >= SGL_UNIFORM_NAME_MAX) return NULL;
+
+    uint32_t hash = sgl_uniform_name_hash(name);
+    int slot = sgl_registry_find(name, hash);
     if (slot < 0) {
-        if (s_registered_count >= SGL_MAX_REGISTERED_UNIFORMS) {
-            return GL_FALSE;
-        }
+        if (s_registered_count >= SGL_MAX_REGISTERED_UNIFORMS) return NULL;
         slot = s_registered_count++;
+
+        uint32_t i = hash & (SGL_REGISTRY_HASH_SLOTS - 1);
+        while (s_registry_hash[i] != 0) i = (i + 1) & (SGL_REGISTRY_HASH_SLOTS - 1);
+        s_registry_hash[i] = (int16_t)(slot + 1);
+
+        memcpy(s_registered_uniforms[slot].name, name, len + 1);
+        s_registered_uniforms[slot].hash = hash;
+    }
+
+    s_registry_generation++;
+    return &s_registered_uniforms[slot];
+}
+
+/*
+ * sglRegisterUniform - Register a uniform name to a specific shader binding
+ */
+GL_APICALL GLboolean GL_APIENTRY sglRegisterUniform(const GLchar *name, GLint stage, GLint binding) {
+    if (!name || stage < 0 || stage > 1 || binding < 0 || binding >= SGL_MAX_UNIFORMS) {
+        return GL_FALSE;
     }
 
-    strncpy(s_registered_uniforms[slot].name, name, SGL_UNIFORM_NAME_MAX - 1);
-    s_registered_uniforms[slot].name[SGL_UNIFORM_NAME_MAX - 1] = '\0';
-    s_registered_uniforms[slot].stage = stage;
-    s_registered_uniforms[slot].binding = binding;
-    s_registered_uniforms[slot].byte_offset = -1; /* legacy mode */
-    s_registered_uniforms[slot].used = true;
-    s_registry_initialized = true;
+    sgl_uniform_entry_t *entry = sgl_registry_insert(name);
+    if (!entry) return GL_FALSE;
 
+    entry->stage = stage;
+    entry->binding = binding;
+    entry->byte_offset = -1; /* legacy mode */
     return GL_TRUE;
 }
 
@@ -88,12 +105,11 @@ GL_APICALL GLboolean GL_APIENTRY sglRegisterUniform(const GLchar *name, GLint st
  * sglClearUniformRegistry - Clear all user-registered uniform mappings
  */
 GL_APICALL void GL_APIENTRY sglClearUniformRegistry(void) {
-    for (int i = 0; i < s_registered_count; i++) {
-        s_registered_uniforms[i].used = false;
-    }
     s_registered_count = 0;
+    memset(s_registry_hash, 0, sizeof(s_registry_hash));
     /* Clear packed UBO sizes */
     memset(s_packed_ubo_sizes, 0, sizeof(s_packed_ubo_sizes));
+    s_registry_generation++;
     /* Note: built-in mappings are still available via hardcoded checks */
 }
 
@@ -105,6 +121,7 @@ GL_APICALL void GL_APIENTRY sglSetPackedUBOSize(GLint stage, GLint binding, GLin
     if (binding < 0 || binding >= SGL_MAX_PACKED_UBOS) return;
     if (size < 0 || size > SGL_MAX_PACKED_UBO_SIZE) return;
     s_packed_ubo_sizes[stage][binding] = size;
+    s_registry_generation++;
 }
 
 /*
@@ -118,83 +135,258 @@ GL_APICALL GLboolean GL_APIENTRY sglRegisterPackedUniform(const GLchar *name,
     if (binding < 0 || binding >= SGL_MAX_PACKED_UBOS) return GL_FALSE;
     if (byte_offset < 0 || byte_offset >= SGL_MAX_PACKED_UBO_SIZE) return GL_FALSE;
 
-    size_t len = strlen(name);
-    if (len == 0 || len >= SGL_UNIFORM_NAME_MAX) return GL_FALSE;
-
-    /* Check if already registered - update if so */
-    for (int i = 0; i < s_registered_count; i++) {
-        if (s_registered_uniforms[i].used &&
-            strcmp(s_registered_uniforms[i].name, name) == 0) {
-            s_registered_uniforms[i].stage = stage;
-            s_registered_uniforms[i].binding = binding;
-            s_registered_uniforms[i].byte_offset = byte_offset;
-            return GL_TRUE;
-        }
-    }
+    sgl_uniform_entry_t *entry = sgl_registry_insert(name);
+    if (!entry) return GL_FALSE;
 
-    /* Find empty slot or add new entry */
-    int slot = -1;
-    for (int i = 0; i < s_registered_count; i++) {
-        if (!s_registered_uniforms[i].used) {
-            slot = i;
-            break;
-        }
-    }
-    if (slot < 0) {
-        if (s_registered_count >= SGL_MAX_REGISTERED_UNIFORMS) return GL_FALSE;
-        slot = s_registered_count++;
-    }
+    entry->stage = stage;
+    entry->binding = binding;
+    entry->byte_offset = byte_offset;
+    return GL_TRUE;
+}
+
+/*
+ * sglGetUniformArenaStats - Uniform memory used this frame, peak and capacity
+ */
+GL_APICALL void GL_APIENTRY sglGetUniformArenaStats(GLuint *used, GLuint *high_water, GLuint *capacity) {
+    GET_CTX();
+    CHECK_BACKEND();
 
-    strncpy(s_registered_uniforms[slot].name, name, SGL_UNIFORM_NAME_MAX - 1);
-    s_registered_uniforms[slot].name[SGL_UNIFORM_NAME_MAX - 1] = '\0';
-    s_registered_uniforms[slot].stage = stage;
-    s_registered_uniforms[slot].binding = binding;
-    s_registered_uniforms[slot].byte_offset = byte_offset;
-    s_registered_uniforms[slot].used = true;
-    s_registry_initialized = true;
+    uint32_t u = 0, hw = 0, cap = 0;
+    if (ctx->backend->ops->get_uniform_stats) {
+        ctx->backend->ops->get_uniform_stats(ctx->backend, &u, &hw, &cap);
+    }
+    if (used) *used = u;
+    if (high_water) *high_water = hw;
+    if (capacity) *capacity = cap;
+}
 
-    return GL_TRUE;
+static GLint sgl_packed_location(int stage, int binding, int byte_offset) {
+    return (GLint)(SGL_LOC_PACKED_FLAG |
+           ((unsigned)stage << SGL_LOC_STAGE_SHIFT) |
+           ((unsigned)binding << SGL_LOC_BINDING_SHIFT) |
+           (unsigned)byte_offset);
 }
 
 /*
- * Check user-registered uniforms first.
+ * Check user-registered uniforms.
  * Returns legacy encoding (stage << 16 | binding) or
  * packed encoding (1 << 31 | stage << 24 | binding << 16 | byte_offset).
  */
-static GLint lookup_registered_uniform(const GLchar *name) {
-    if (!s_registry_initialized) return -1;
-
-    for (int i = 0; i < s_registered_count; i++) {
-        if (s_registered_uniforms[i].used &&
-            strcmp(s_registered_uniforms[i].name, name) == 0) {
-            if (s_registered_uniforms[i].byte_offset >= 0) {
-                /* Packed mode encoding */
-                return (GLint)(SGL_LOC_PACKED_FLAG |
-                       ((unsigned)s_registered_uniforms[i].stage << SGL_LOC_STAGE_SHIFT) |
-                       ((unsigned)s_registered_uniforms[i].binding << SGL_LOC_BINDING_SHIFT) |
-                       (unsigned)s_registered_uniforms[i].byte_offset);
-            } else {
-                /* Legacy encoding */
-                return (s_registered_uniforms[i].stage << 16) | s_registered_uniforms[i].binding;
+static GLint lookup_registered_uniform(const GLchar *name, uint32_t hash) {
+    int slot = sgl_registry_find(name, hash);
+    if (slot < 0) return -1;
+
+    const sgl_uniform_entry_t *e = &s_registered_uniforms[slot];
+    if (e->byte_offset >= 0) {
+        return sgl_packed_location(e->stage, e->binding, e->byte_offset);
+    }
+    return (e->stage << 16) | e->binding;
+}
+
+/*
+ * Check the uniforms the transpiler laid out for this program at link
+ * time. These are per program, so two programs can pack the same name at
+ * different offsets.
+ */
+/*
+ * Location of a uniform in the reflected layout. A uniform declared in both
+ * stages resolves to the first stage that references it. Returns false if
+ * the program does not declare the name; a declared uniform no stage
+ * references (left out of the layout by the transpiler) gives -1.
+ */
+static bool lookup_program_uniform(const sgl_program_t *prog, const GLchar *name, GLint *loc) {
+    const sgl_link_reflection_t *r = prog->link_reflection;
+    bool declared = false;
+    *loc = -1;
+    if (!r) return false;
+    for (int i = 0; i < r->num_uniforms; i++) {
+        if (strcmp(r->uniforms[i].name, name) != 0) continue;
+        declared = true;
+        if (r->uniforms[i].byte_offset >= 0) {
+            *loc = sgl_packed_location(r->uniforms[i].stage, r->uniforms[i].binding,
+                                       r->uniforms[i].byte_offset);
+            return true;
+        }
+    }
+    return declared;
+}
+
+/* Widen the range of a packed UBO the next bind has to push */
+static void sgl_packed_mark_dirty(sgl_packed_ubo_t *packed, uint32_t offset, uint32_t size) {
+    uint32_t end = offset + size;
+    if (!packed->dirty) {
+        packed->dirty = true;
+        packed->dirty_begin = offset;
+        packed->dirty_end = end;
+        return;
+    }
+    if (offset < packed->dirty_begin) packed->dirty_begin = offset;
+    if (end > packed->dirty_end) packed->dirty_end = end;
+}
+
+/* Size a program's packed shadow buffer the first time a location in it is handed out */
+static void sgl_configure_packed_ubo(sgl_program_t *prog, GLint location, int ubo_size) {
+    int stage = (location >> SGL_LOC_STAGE_SHIFT) & SGL_LOC_STAGE_MASK;
+    int binding = (location >> SGL_LOC_BINDING_SHIFT) & SGL_LOC_BINDING_MASK;
+    if (binding >= SGL_MAX_PACKED_UBOS) return;
+
+    sgl_packed_ubo_t *packed = (stage == 0)
+        ? &prog->packed_vertex[binding]
+        : &prog->packed_fragment[binding];
+    if (packed->valid && packed->size == (uint32_t)ubo_size) return;
+    if (ubo_size > 0 && ubo_size <= SGL_MAX_PACKED_UBO_SIZE) {
+        if ((uint32_t)ubo_size > packed->capacity) {
+            uint8_t *data = (uint8_t *)realloc(packed->data, ubo_size);
+            if (!data) {
+                SGL_ERROR_UNIFORM("packed UBO %d/%d: out of memory for %d bytes", stage, binding, ubo_size);
+                return;
             }
+            packed->data = data;
+            packed->capacity = ubo_size;
         }
+        packed->size = ubo_size;
+        packed->valid = true;
+        packed->dirty = false;
+        memset(packed->data, 0, ubo_size);
+        sgl_packed_mark_dirty(packed, 0, ubo_size);
     }
-    return -1;
+}
+
+/* Built-in uniform names used by the bundled precompiled shaders and examples */
+typedef struct {
+    const char *name;
+    GLint location;     /* (stage << 16) | binding */
+    GLenum type;
+} sgl_builtin_uniform_t;
+
+static const sgl_builtin_uniform_t s_builtin_uniforms[] = {
+    /* ========== BUILT-IN VERTEX STAGE UNIFORMS ========== */
+
+    /* Vertex binding 0: matrices and scale */
+    { "u_mvp",                     (0 << 16) | 0, GL_FLOAT_MAT4 },
+    { "Transforms",                (0 << 16) | 0, GL_FLOAT_MAT4 },
+    { "u_modelViewProj",           (0 << 16) | 0, GL_FLOAT_MAT4 },
+    { "u_mvpMatrix",               (0 << 16) | 0, GL_FLOAT_MAT4 },
+    { "u_matrix",                  (0 << 16) | 0, GL_FLOAT_MAT4 },
+    { "u_projection",              (0 << 16) | 0, GL_FLOAT_MAT4 },  /* SDL_Renderer */
+    { "u_testScale",               (0 << 16) | 0, GL_FLOAT_MAT4 },
+    { "ModelViewProjectionMatrix", (0 << 16) | 0, GL_FLOAT_MAT4 },  /* es2gears */
+
+    /* Vertex binding 1: offset vec2/vec4 or NormalMatrix or Model matrix */
+    { "u_offset",                  (0 << 16) | 1, GL_FLOAT_MAT4 },
+    { "u_normalMatrix",            (0 << 16) | 1, GL_FLOAT_MAT4 },
+    { "u_testOffset2",             (0 << 16) | 1, GL_FLOAT_MAT4 },
+    { "u_model",                   (0 << 16) | 1, GL_FLOAT_MAT4 },  /* PBR model matrix */
+    { "Model",                     (0 << 16) | 1, GL_FLOAT_MAT4 },  /* UBO block name */
+    { "ModelMatrix",               (0 << 16) | 1, GL_FLOAT_MAT4 },  /* blinn_phong block name */
+    { "NormalMatrix",              (0 << 16) | 1, GL_FLOAT_MAT4 },  /* es2gears */
+
+    /* Vertex binding 2: offset3 vec3 or LightSourcePosition */
+    { "u_testOffset3",             (0 << 16) | 2, GL_FLOAT_VEC4 },
+    { "LightSourcePosition",       (0 << 16) | 2, GL_FLOAT_VEC4 },  /* es2gears */
+
+    /* Vertex binding 3: mat2 or MaterialColor */
+    { "u_testMat2",                (0 << 16) | 3, GL_FLOAT_VEC4 },
+    { "MaterialColor",             (0 << 16) | 3, GL_FLOAT_VEC4 },  /* es2gears */
+
+    /* Vertex binding 4: mat3 */
+    { "u_testMat3",                (0 << 16) | 4, GL_FLOAT_MAT3 },
+
+    /* ========== BUILT-IN FRAGMENT STAGE UNIFORMS ========== */
+
+    /* Fragment binding 0: color vec4 or alpha float or blend */
+    { "u_color",                   (1 << 16) | 0, GL_FLOAT_VEC4 },
+    { "FragUniforms",              (1 << 16) | 0, GL_FLOAT_VEC4 },
+    { "u_baseColor",               (1 << 16) | 0, GL_FLOAT_VEC4 },
+    { "u_testAlpha",               (1 << 16) | 0, GL_FLOAT_VEC4 },
+    { "u_blend",                   (1 << 16) | 0, GL_FLOAT_VEC4 },
+
+    /* Fragment binding 1: vec2/vec4 or time or Material block (skybox) */
+    { "u_testVec2",                (1 << 16) | 1, GL_FLOAT_VEC4 },
+    { "u_alpha",                   (1 << 16) | 1, GL_FLOAT_VEC4 },
+    { "u_time",                    (1 << 16) | 1, GL_FLOAT_VEC4 },
+    { "Material",                  (1 << 16) | 1, GL_FLOAT_VEC4 },  /* UBO block name for skybox */
+
+    /* Fragment binding 2: vec3/vec4 or mode or material params (PBR) */
+    { "u_testVec3",                (1 << 16) | 2, GL_FLOAT_VEC4 },
+    { "u_mode",                    (1 << 16) | 2, GL_FLOAT_VEC4 },
+    { "u_material",                (1 << 16) | 2, GL_FLOAT_VEC4 },  /* PBR material params */
+    { "u_light",                   (1 << 16) | 2, GL_FLOAT_VEC4 },  /* Blinn-Phong light uniform */
+    { "LightParams",               (1 << 16) | 2, GL_FLOAT_VEC4 },  /* Blinn-Phong light UBO block */
+
+    /* Fragment binding 3: vec4 */
+    { "u_testVec4",                (1 << 16) | 3, GL_FLOAT_VEC4 },
+
+    /* Fragment binding 4: int mode (for alluniform shader) */
+    { "u_testMode",                (1 << 16) | 4, GL_INT },
+
+    /* Fragment bindings 5-7: ivec2, ivec3, ivec4 */
+    { "u_testIvec2",               (1 << 16) | 5, GL_INT_VEC2 },
+    { "u_testIvec3",               (1 << 16) | 6, GL_INT_VEC3 },
+    { "u_testIvec4",               (1 << 16) | 7, GL_INT_VEC4 },
+
+    { NULL, -1, 0 }
+};
+
+static const sgl_builtin_uniform_t *lookup_builtin_uniform(const GLchar *name) {
+    for (const sgl_builtin_uniform_t *b = s_builtin_uniforms; b->name; b++) {
+        if (strcmp(b->name, name) == 0) return b;
+    }
+    return NULL;
+}
+
+/*
+ * Per-program location cache. prog->uniform_cache is an open-addressed
+ * index into prog->active_uniforms, so a repeated glGetUniformLocation is
+ * one hash probe and one strcmp. Any registry change invalidates it.
+ */
+static GLint sgl_uniform_cache_lookup(sgl_program_t *prog, const GLchar *name, uint32_t hash) {
+    if (prog->uniform_cache_generation != s_registry_generation) {
+        memset(prog->uniform_cache, 0, sizeof(prog->uniform_cache));
+        prog->uniform_cache_generation = s_registry_generation;
+        return -1;
+    }
+    for (uint32_t i = hash & (SGL_UNIFORM_CACHE_SLOTS - 1);; i = (i + 1) & (SGL_UNIFORM_CACHE_SLOTS - 1)) {
+        int slot = prog->uniform_cache[i] - 1;
+        if (slot < 0) return -1;
+        const sgl_active_uniform_info_t *u = &prog->active_uniforms[slot];
+        if (u->hash == hash && strcmp(u->name, name) == 0) return u->location;
+    }
+}
+
+static void sgl_uniform_cache_insert(sgl_program_t *prog, int slot) {
+    uint32_t i = prog->active_uniforms[slot].hash & (SGL_UNIFORM_CACHE_SLOTS - 1);
+    while (prog->uniform_cache[i] != 0) {
+        if (prog->uniform_cache[i] == slot + 1) return;
+        i = (i + 1) & (SGL_UNIFORM_CACHE_SLOTS - 1);
+    }
+    prog->uniform_cache[i] = (int8_t)(slot + 1);
+}
+
+void sgl_program_reset_uniforms(sgl_program_t *prog) {
+    memset(prog->active_uniforms, 0, sizeof(prog->active_uniforms));
+    prog->num_active_uniforms = 0;
+    memset(prog->uniform_cache, 0, sizeof(prog->uniform_cache));
+    prog->uniform_cache_generation = 0;
 }
 
 /*
  * Track a uniform as "active" in the program when glGetUniformLocation returns a valid location.
- * This is used by glGetActiveUniform and glGetProgramiv(GL_ACTIVE_UNIFORMS).
+ * This is used by glGetActiveUniform and glGetProgramiv(GL_ACTIVE_UNIFORMS), and
+ * backs the location cache.
  */
-static void sgl_track_active_uniform(sgl_program_t *prog, const GLchar *name,
+static void sgl_track_active_uniform(sgl_program_t *prog, const GLchar *name, uint32_t hash,
                                       GLint location, GLenum type, GLint size) {
     if (!prog || !name) return;
 
-    /* Check if already tracked */
+    /* Check if already tracked (the cache was invalidated): refresh it */
     for (int i = 0; i < prog->num_active_uniforms; i++) {
         if (prog->active_uniforms[i].active &&
             strcmp(prog->active_uniforms[i].name, name) == 0) {
-            return; /* Already tracked */
+            prog->active_uniforms[i].location = location;
+            prog->active_uniforms[i].type = type;
+            sgl_uniform_cache_insert(prog, i);
+            return;
         }
     }
 
@@ -205,174 +397,76 @@ static void sgl_track_active_uniform(sgl_program_t *prog, const GLchar *name,
         if (len >= SGL_ATTRIB_NAME_MAX) len = SGL_ATTRIB_NAME_MAX - 1;
         memcpy(prog->active_uniforms[slot].name, name, len);
         prog->active_uniforms[slot].name[len] = '\0';
+        prog->active_uniforms[slot].hash = hash;
         prog->active_uniforms[slot].location = location;
         prog->active_uniforms[slot].type = type;
         prog->active_uniforms[slot].size = size;
         prog->active_uniforms[slot].active = true;
+        if (len == strlen(name)) sgl_uniform_cache_insert(prog, slot);
     }
 }
 
-GL_APICALL GLint GL_APIENTRY glGetUniformLocation(GLuint program, const GLchar *name) {
-    GET_CTX_RET(-1);
-
+static GLint sgl_uniform_location(sgl_context_t *ctx, GLuint program, const GLchar *name) {
     if (program == 0 || !name) return -1;
 
     sgl_program_t *prog = GET_PROGRAM(program);
+    if (prog) sgl_program_finish_link(ctx, program, prog);
     if (!prog || !prog->linked) return -1;
 
+    uint32_t hash = sgl_uniform_name_hash(name);
+    GLint loc = sgl_uniform_cache_lookup(prog, name, hash);
+    if (loc != -1) return loc;
+
+    /* Transpiled programs: the layout reflected at link time */
+    if (lookup_program_uniform(prog, name, &loc)) {
+        /* Declared but unreferenced: inactive, -1 per the GL spec */
+        if (loc == -1) return -1;
+        int stage = (loc >> SGL_LOC_STAGE_SHIFT) & SGL_LOC_STAGE_MASK;
+        int binding = (loc >> SGL_LOC_BINDING_SHIFT) & SGL_LOC_BINDING_MASK;
+        sgl_configure_packed_ubo(prog, loc, prog->link_reflection->packed_ubo_sizes[stage][binding]);
+        sgl_track_active_uniform(prog, name, hash, loc, GL_FLOAT_VEC4, 1);
+        return loc;
+    }
+
     /*
      * For pre-compiled deko3d shaders with std140 uniform blocks:
      * Location = (stage << 16) | binding
      * Stage: 0 = vertex, 1 = fragment
      */
 
-    /* Check user-registered uniforms FIRST (allows overriding built-ins) */
-    GLint registered = lookup_registered_uniform(name);
-    if (registered != -1) {
+    /* Check user-registered uniforms before built-ins (allows overriding them) */
+    loc = lookup_registered_uniform(name, hash);
+    if (loc != -1) {
         /* If packed mode, configure the program's packed UBO size */
-        if (registered & SGL_LOC_PACKED_FLAG) {
-            int stage = (registered >> SGL_LOC_STAGE_SHIFT) & SGL_LOC_STAGE_MASK;
-            int binding = (registered >> SGL_LOC_BINDING_SHIFT) & SGL_LOC_BINDING_MASK;
-            sgl_packed_ubo_t *packed = (stage == 0)
-                ? &prog->packed_vertex[binding]
-                : &prog->packed_fragment[binding];
-            if (!packed->valid) {
-                int ubo_size = s_packed_ubo_sizes[stage][binding];
-                if (ubo_size > 0 && ubo_size <= SGL_MAX_PACKED_UBO_SIZE) {
-                    packed->size = ubo_size;
-                    packed->valid = true;
-                    packed->dirty = false;
-                    memset(packed->data, 0, ubo_size);
-                }
-            }
+        if (loc & SGL_LOC_PACKED_FLAG) {
+            int stage = (loc >> SGL_LOC_STAGE_SHIFT) & SGL_LOC_STAGE_MASK;
+            int binding = (loc >> SGL_LOC_BINDING_SHIFT) & SGL_LOC_BINDING_MASK;
+            sgl_configure_packed_ubo(prog, loc, s_packed_ubo_sizes[stage][binding]);
         }
-        /* Track as active uniform */
-        sgl_track_active_uniform(prog, name, registered, GL_FLOAT_VEC4, 1);
-        return registered;
-    }
-
-    /* ========== BUILT-IN VERTEX STAGE UNIFORMS ========== */
-
-    /* Vertex binding 0: matrices and scale */
-    if (strcmp(name, "u_mvp") == 0 ||
-        strcmp(name, "Transforms") == 0 ||
-        strcmp(name, "u_modelViewProj") == 0 ||
-        strcmp(name, "u_mvpMatrix") == 0 ||
-        strcmp(name, "u_matrix") == 0 ||
-        strcmp(name, "u_projection") == 0 ||   /* SDL_Renderer */
-        strcmp(name, "u_testScale") == 0 ||
-        strcmp(name, "ModelViewProjectionMatrix") == 0) {  /* es2gears */
-        GLint loc = (0 << 16) | 0;
-        sgl_track_active_uniform(prog, name, loc, GL_FLOAT_MAT4, 1);
-        return loc;
-    }
-
-    /* Vertex binding 1: offset vec2/vec4 or NormalMatrix or Model matrix */
-    if (strcmp(name, "u_offset") == 0 ||
-        strcmp(name, "u_normalMatrix") == 0 ||
-        strcmp(name, "u_testOffset2") == 0 ||
-        strcmp(name, "u_model") == 0 ||        /* PBR model matrix */
-        strcmp(name, "Model") == 0 ||          /* UBO block name */
-        strcmp(name, "ModelMatrix") == 0 ||    /* blinn_phong block name */
-        strcmp(name, "NormalMatrix") == 0) {   /* es2gears */
-        GLint loc = (0 << 16) | 1;
-        sgl_track_active_uniform(prog, name, loc, GL_FLOAT_MAT4, 1);
-        return loc;
-    }
-
-    /* Vertex binding 2: offset3 vec3 or LightSourcePosition */
-    if (strcmp(name, "u_testOffset3") == 0 ||
-        strcmp(name, "LightSourcePosition") == 0) {  /* es2gears */
-        GLint loc = (0 << 16) | 2;
-        sgl_track_active_uniform(prog, name, loc, GL_FLOAT_VEC4, 1);
-        return loc;
-    }
-
-    /* Vertex binding 3: mat2 or MaterialColor */
-    if (strcmp(name, "u_testMat2") == 0 ||
-        strcmp(name, "MaterialColor") == 0) {  /* es2gears */
-        GLint loc = (0 << 16) | 3;
-        sgl_track_active_uniform(prog, name, loc, GL_FLOAT_VEC4, 1);
-        return loc;
-    }
-
-    /* Vertex binding 4: mat3 */
-    if (strcmp(name, "u_testMat3") == 0) {
-        GLint loc = (0 << 16) | 4;
-        sgl_track_active_uniform(prog, name, loc, GL_FLOAT_MAT3, 1);
-        return loc;
-    }
-
-    /* ========== BUILT-IN FRAGMENT STAGE UNIFORMS ========== */
-
-    /* Fragment binding 0: color vec4 or alpha float or blend */
-    if (strcmp(name, "u_color") == 0 ||
-        strcmp(name, "FragUniforms") == 0 ||
-        strcmp(name, "u_baseColor") == 0 ||
-        strcmp(name, "u_testAlpha") == 0 ||
-        strcmp(name, "u_blend") == 0) {
-        GLint loc = (1 << 16) | 0;
-        sgl_track_active_uniform(prog, name, loc, GL_FLOAT_VEC4, 1);
-        return loc;
-    }
-
-    /* Fragment binding 1: vec2/vec4 or time or Material block (skybox) */
-    if (strcmp(name, "u_testVec2") == 0 ||
-        strcmp(name, "u_alpha") == 0 ||
-        strcmp(name, "u_time") == 0 ||
-        strcmp(name, "Material") == 0) {       /* UBO block name for skybox */
-        GLint loc = (1 << 16) | 1;
-        sgl_track_active_uniform(prog, name, loc, GL_FLOAT_VEC4, 1);
-        return loc;
-    }
-
-    /* Fragment binding 2: vec3/vec4 or mode or material params (PBR) */
-    if (strcmp(name, "u_testVec3") == 0 ||
-        strcmp(name, "u_mode") == 0 ||
-        strcmp(name, "u_material") == 0 ||     /* PBR material params */
-        strcmp(name, "u_light") == 0 ||        /* Blinn-Phong light uniform */
-        strcmp(name, "LightParams") == 0) {    /* Blinn-Phong light UBO block */
-        GLint loc = (1 << 16) | 2;
-        sgl_track_active_uniform(prog, name, loc, GL_FLOAT_VEC4, 1);
+        sgl_track_active_uniform(prog, name, hash, loc, GL_FLOAT_VEC4, 1);
         return loc;
     }
 
-    /* Fragment binding 3: vec4 */
-    if (strcmp(name, "u_testVec4") == 0) {
-        GLint loc = (1 << 16) | 3;
-        sgl_track_active_uniform(prog, name, loc, GL_FLOAT_VEC4, 1);
-        return loc;
+    const sgl_builtin_uniform_t *builtin = lookup_builtin_uniform(name);
+    if (builtin) {
+        sgl_track_active_uniform(prog, name, hash, builtin->location, builtin->type, 1);
+        return builtin->location;
     }
 
-    /* Fragment binding 4: int mode (for alluniform shader) */
-    if (strcmp(name, "u_testMode") == 0) {
-        GLint loc = (1 << 16) | 4;
-        sgl_track_active_uniform(prog, name, loc, GL_INT, 1);
-        return loc;
-    }
-
-    /* Fragment binding 5: ivec2 */
-    if (strcmp(name, "u_testIvec2") == 0) {
-        GLint loc = (1 << 16) | 5;
-        sgl_track_active_uniform(prog, name, loc, GL_INT_VEC2, 1);
-        return loc;
-    }
+    return -1;
+}
 
-    /* Fragment binding 6: ivec3 */
-    if (strcmp(name, "u_testIvec3") == 0) {
-        GLint loc = (1 << 16) | 6;
-        sgl_track_active_uniform(prog, name, loc, GL_INT_VEC3, 1);
-        return loc;
-    }
+GL_APICALL GLint GL_APIENTRY glGetUniformLocation(GLuint program, const GLchar *name) {
+    GET_CTX_RET(-1);
 
-    /* Fragment binding 7: ivec4 */
-    if (strcmp(name, "u_testIvec4") == 0) {
-        GLint loc = (1 << 16) | 7;
-        sgl_track_active_uniform(prog, name, loc, GL_INT_VEC4, 1);
-        return loc;
+    GLint loc = sgl_uniform_location(ctx, program, name);
+    /* Replayed for its side effects (packed UBO setup) and to check that
+     * the replaying context hands out the same location */
+    if (name) {
+        SGL_CAPTURE_DATA(SGL_TRACE_GET_UNIFORM_LOCATION, name, (uint32_t)strlen(name) + 1,
+                         program, (uint32_t)loc);
     }
-
-    return -1;
+    return loc;
 }
 
 /*
@@ -419,6 +513,7 @@ GL_APICALL GLint GL_APIENTRY glGetAttribLocation(GLuint program, const GLchar *n
     if (program == 0 || !name) return -1;
 
     sgl_program_t *prog = GET_PROGRAM(program);
+    if (prog) sgl_program_finish_link(ctx, program, prog);
     if (!prog || !prog->linked) return -1;
 
     /* Check program-specific bindings first (from glBindAttribLocation) */
@@ -453,6 +548,8 @@ GL_APICALL void GL_APIENTRY glBindAttribLocation(GLuint program, GLuint index, c
         return;
     }
 
+    SGL_CAPTURE_DATA(SGL_TRACE_BIND_ATTRIB_LOCATION, name, (uint32_t)len + 1, program, index);
+
     /* Check if already bound - update if so */
     for (int i = 0; i < prog->num_attrib_bindings; i++) {
         if (prog->attrib_bindings[i].used &&
@@ -480,6 +577,7 @@ GL_APICALL void GL_APIENTRY glGetActiveAttrib(GLuint program, GLuint index, GLsi
     GET_CTX();
 
     sgl_program_t *prog = GET_PROGRAM(program);
+    if (prog) sgl_program_finish_link(ctx, program, prog);
     if (!prog || !prog->linked) {
         sgl_set_error(ctx, GL_INVALID_VALUE);
         return;
@@ -520,6 +618,7 @@ GL_APICALL void GL_APIENTRY glGetActiveUniform(GLuint program, GLuint index, GLs
     GET_CTX();
 
     sgl_program_t *prog = GET_PROGRAM(program);
+    if (prog) sgl_program_finish_link(ctx, program, prog);
     if (!prog || !prog->linked) {
         sgl_set_error(ctx, GL_INVALID_VALUE);
         return;
@@ -560,6 +659,7 @@ GL_APICALL void GL_APIENTRY glGetUniformfv(GLuint program, GLint location, GLflo
     if (!params || location == -1) return;
 
     sgl_program_t *prog = GET_PROGRAM(program);
+    if (prog) sgl_program_finish_link(ctx, program, prog);
     if (!prog || !prog->linked) {
         sgl_set_error(ctx, GL_INVALID_VALUE);
         return;
@@ -610,6 +710,7 @@ GL_APICALL void GL_APIENTRY glGetUniformiv(GLuint program, GLint location, GLint
     if (!params || location == -1) return;
 
     sgl_program_t *prog = GET_PROGRAM(program);
+    if (prog) sgl_program_finish_link(ctx, program, prog);
     if (!prog || !prog->linked) {
         sgl_set_error(ctx, GL_INVALID_VALUE);
         return;
@@ -654,11 +755,30 @@ GL_APICALL void GL_APIENTRY glGetUniformiv(GLuint program, GLint location, GLint
     }
 }
 
+/*
+ * Give a legacy uniform binding backend memory for the next draw. Every
+ * draw needs its own slot, but repeated writes to the same binding before
+ * the next draw reuse the slot reserved by the first one instead of taking
+ * another 256 bytes each. sgl_bind_program_for_draw clears dirty.
+ */
+static void sgl_uniform_reserve(sgl_context_t *ctx, sgl_uniform_binding_t *ub, uint32_t data_size) {
+    if (!ctx->backend->ops->alloc_uniform) return;
+
+    uint32_t aligned_size = SGL_ALIGN_UP(data_size, SGL_UNIFORM_ALIGNMENT);
+    if (!ub->valid || !ub->dirty || ub->size < aligned_size) {
+        ub->offset = ctx->backend->ops->alloc_uniform(ctx->backend, aligned_size);
+        ub->size = aligned_size;
+    }
+    ub->data_size = data_size;
+    ub->valid = true;
+    ub->dirty = true;
+}
+
 /*
  * Helper to set a float uniform (1-4 components)
  * std140 layout: all uniforms are padded to 16 bytes (vec4)
  *
- * IMPORTANT: We allocate a NEW offset for each glUniform call to avoid
+ * IMPORTANT: Each draw gets a NEW offset (see sgl_uniform_reserve) to avoid
  * data races when multiple draws use different values in the same frame.
  * pushConstants copies data to the GPU address, but if multiple draws
  * use the same address, later draws overwrite earlier ones before the
@@ -672,6 +792,9 @@ static void set_float_uniform(GLint location, int num_components, GLsizei count,
     sgl_program_t *prog = GET_PROGRAM(ctx->current_program);
     if (!prog) return;
 
+    SGL_CAPTURE_DATA(SGL_TRACE_UNIFORMFV, values, (uint32_t)(count * num_components) * 4, location,
+                     (uint32_t)num_components, (uint32_t)count);
+
     /* Packed mode: write directly to shadow buffer */
     if (location & SGL_LOC_PACKED_FLAG) {
         int stage = (location >> SGL_LOC_STAGE_SHIFT) & SGL_LOC_STAGE_MASK;
@@ -689,6 +812,7 @@ static void set_float_uniform(GLint location, int num_components, GLsizei count,
             uint32_t dataSize = num_components * sizeof(float);
             if (!packed->valid || offset + dataSize > packed->size) return;
             memcpy(packed->data + offset, values, dataSize);
+            sgl_packed_mark_dirty(packed, offset, dataSize);
         } else {
             /* Array: each element padded to vec4 (16 bytes) in std140 */
             uint32_t totalSize = count * 16;
@@ -700,8 +824,8 @@ static void set_float_uniform(GLint location, int num_components, GLsizei count,
                 }
                 memcpy(packed->data + offset + e * 16, elem, 16);
             }
+            sgl_packed_mark_dirty(packed, offset, totalSize);
         }
-        packed->dirty = true;
         return;
     }
 
@@ -718,17 +842,7 @@ static void set_float_uniform(GLint location, int num_components, GLsizei count,
 
     /* std140: each array element padded to 16 bytes (vec4) */
     uint32_t dataSize = clampedCount * 16;
-    uint32_t alignedSize = SGL_ALIGN_UP(dataSize, SGL_UNIFORM_ALIGNMENT);
-
-    /* ALWAYS allocate a new offset for each uniform write.
-     * This ensures each draw gets unique uniform data, preventing
-     * data races in the GPU command buffer. */
-    if (ctx->backend->ops->alloc_uniform) {
-        ub->offset = ctx->backend->ops->alloc_uniform(ctx->backend, alignedSize);
-        ub->size = alignedSize;
-        ub->data_size = dataSize;
-        ub->valid = true;
-    }
+    sgl_uniform_reserve(ctx, ub, dataSize);
 
     /* Write data via backend - pad each element to vec4 */
     if (ub->valid && ctx->backend->ops->write_uniform) {
@@ -782,7 +896,7 @@ GL_APICALL void GL_APIENTRY glUniform4f(GLint location, GLfloat v0, GLfloat v1,
  * std140 layout: integers are also 4 bytes each, padded to 16 bytes
  * Note: For samplers (glUniform1i), the value is the texture unit index
  *
- * IMPORTANT: We allocate a NEW offset for each glUniform call to avoid
+ * IMPORTANT: Each draw gets a NEW offset (see sgl_uniform_reserve) to avoid
  * data races when multiple draws use different values in the same frame.
  */
 static void set_int_uniform(GLint location, int num_components, GLsizei count, const GLint *values) {
@@ -793,6 +907,9 @@ static void set_int_uniform(GLint location, int num_components, GLsizei count, c
     sgl_program_t *prog = GET_PROGRAM(ctx->current_program);
     if (!prog) return;
 
+    SGL_CAPTURE_DATA(SGL_TRACE_UNIFORMIV, values, (uint32_t)(count * num_components) * 4, location,
+                     (uint32_t)num_components, (uint32_t)count);
+
     /* Packed mode: write directly to shadow buffer */
     if (location & SGL_LOC_PACKED_FLAG) {
         int stage = (location >> SGL_LOC_STAGE_SHIFT) & SGL_LOC_STAGE_MASK;
@@ -810,6 +927,7 @@ static void set_int_uniform(GLint location, int num_components, GLsizei count, c
             uint32_t dataSize = num_components * sizeof(int32_t);
             if (!packed->valid || offset + dataSize > packed->size) return;
             memcpy(packed->data + offset, values, dataSize);
+            sgl_packed_mark_dirty(packed, offset, dataSize);
         } else {
             /* Array: each element padded to ivec4 (16 bytes) in std140 */
             uint32_t totalSize = count * 16;
@@ -821,8 +939,8 @@ static void set_int_uniform(GLint location, int num_components, GLsizei count, c
                 }
                 memcpy(packed->data + offset + e * 16, elem, 16);
             }
+            sgl_packed_mark_dirty(packed, offset, totalSize);
         }
-        packed->dirty = true;
         return;
     }
 
@@ -839,15 +957,7 @@ static void set_int_uniform(GLint location, int num_components, GLsizei count, c
 
     /* std140: each array element padded to 16 bytes (ivec4) */
     uint32_t dataSize = clampedCount * 16;
-    uint32_t alignedSize = SGL_ALIGN_UP(dataSize, SGL_UNIFORM_ALIGNMENT);
-
-    /* ALWAYS allocate new offset to avoid data races between draws */
-    if (ctx->backend->ops->alloc_uniform) {
-        ub->offset = ctx->backend->ops->alloc_uniform(ctx->backend, alignedSize);
-        ub->size = alignedSize;
-        ub->data_size = dataSize;
-        ub->valid = true;
-    }
+    sgl_uniform_reserve(ctx, ub, dataSize);
 
     /* Write data via backend - pad each element to ivec4 */
     if (ub->valid && ctx->backend->ops->write_uniform) {
@@ -965,6 +1075,9 @@ GL_APICALL void GL_APIENTRY glUniformMatrix2fv(GLint location, GLsizei count, GL
     sgl_program_t *prog = GET_PROGRAM(ctx->current_program);
     if (!prog || !prog->linked) return;
 
+    SGL_CAPTURE_DATA(SGL_TRACE_UNIFORM_MATRIXFV, value, (uint32_t)count * 16, location, 2, (uint32_t)count,
+                     transpose);
+
     /* Packed mode: write std140 mat2 to shadow buffer */
     if (location & SGL_LOC_PACKED_FLAG) {
         int stage = (location >> SGL_LOC_STAGE_SHIFT) & SGL_LOC_STAGE_MASK;
@@ -981,7 +1094,7 @@ GL_APICALL void GL_APIENTRY glUniformMatrix2fv(GLint location, GLsizei count, GL
             dst[0] = src[0]; dst[1] = src[1]; dst[2] = 0.0f; dst[3] = 0.0f;
             dst[4] = src[2]; dst[5] = src[3]; dst[6] = 0.0f; dst[7] = 0.0f;
         }
-        packed->dirty = true;
+        sgl_packed_mark_dirty(packed, offset, dataSize);
         SGL_TRACE_UNIFORM("glUniformMatrix2fv(packed loc=0x%X, count=%d)", location, count);
         return;
     }
@@ -995,15 +1108,7 @@ GL_APICALL void GL_APIENTRY glUniformMatrix2fv(GLint location, GLsizei count, GL
 
     /* mat2 in std140: 2 columns of vec4 (padded from vec2) = 32 bytes */
     uint32_t dataSize = 32 * count;
-    uint32_t alignedSize = SGL_ALIGN_UP(dataSize, SGL_UNIFORM_ALIGNMENT);
-
-    /* ALWAYS allocate new offset to avoid data races between draws */
-    if (ctx->backend->ops->alloc_uniform) {
-        ub->offset = ctx->backend->ops->alloc_uniform(ctx->backend, alignedSize);
-        ub->size = alignedSize;
-        ub->data_size = dataSize;
-        ub->valid = true;
-    }
+    sgl_uniform_reserve(ctx, ub, dataSize);
 
     if (ub->valid && ctx->backend->ops->write_uniform) {
         /* Convert mat2 (4 floats) to std140 layout (2 vec4 = 8 floats) */
@@ -1045,6 +1150,9 @@ GL_APICALL void GL_APIENTRY glUniformMatrix3fv(GLint location, GLsizei count, GL
     sgl_program_t *prog = GET_PROGRAM(ctx->current_program);
     if (!prog || !prog->linked) return;
 
+    SGL_CAPTURE_DATA(SGL_TRACE_UNIFORM_MATRIXFV, value, (uint32_t)count * 36, location, 3, (uint32_t)count,
+                     transpose);
+
     /* Packed mode: write std140 mat3 to shadow buffer */
     if (location & SGL_LOC_PACKED_FLAG) {
         int stage = (location >> SGL_LOC_STAGE_SHIFT) & SGL_LOC_STAGE_MASK;
@@ -1062,7 +1170,7 @@ GL_APICALL void GL_APIENTRY glUniformMatrix3fv(GLint location, GLsizei count, GL
             dst[4] = src[3]; dst[5] = src[4]; dst[6] = src[5]; dst[7] = 0.0f;
             dst[8] = src[6]; dst[9] = src[7]; dst[10] = src[8]; dst[11] = 0.0f;
         }
-        packed->dirty = true;
+        sgl_packed_mark_dirty(packed, offset, dataSize);
         SGL_TRACE_UNIFORM("glUniformMatrix3fv(packed loc=0x%X, count=%d)", location, count);
         return;
     }
@@ -1076,15 +1184,7 @@ GL_APICALL void GL_APIENTRY glUniformMatrix3fv(GLint location, GLsizei count, GL
 
     /* mat3 in std140: 3 columns of vec4 (padded from vec3) = 48 bytes */
     uint32_t dataSize = 48 * count;
-    uint32_t alignedSize = SGL_ALIGN_UP(dataSize, SGL_UNIFORM_ALIGNMENT);
-
-    /* ALWAYS allocate new offset to avoid data races between draws */
-    if (ctx->backend->ops->alloc_uniform) {
-        ub->offset = ctx->backend->ops->alloc_uniform(ctx->backend, alignedSize);
-        ub->size = alignedSize;
-        ub->data_size = dataSize;
-        ub->valid = true;
-    }
+    sgl_uniform_reserve(ctx, ub, dataSize);
 
     if (ub->valid && ctx->backend->ops->write_uniform) {
         /* Convert mat3 (9 floats) to std140 layout (3 vec4 = 12 floats) */
@@ -1127,6 +1227,9 @@ GL_APICALL void GL_APIENTRY glUniformMatrix4fv(GLint location, GLsizei count, GL
     sgl_program_t *prog = GET_PROGRAM(ctx->current_program);
     if (!prog || !prog->linked) return;
 
+    SGL_CAPTURE_DATA(SGL_TRACE_UNIFORM_MATRIXFV, value, (uint32_t)count * 64, location, 4, (uint32_t)count,
+                     transpose);
+
     /* Packed mode: write std140 mat4 to shadow buffer */
     if (location & SGL_LOC_PACKED_FLAG) {
         int stage = (location >> SGL_LOC_STAGE_SHIFT) & SGL_LOC_STAGE_MASK;
@@ -1138,7 +1241,7 @@ GL_APICALL void GL_APIENTRY glUniformMatrix4fv(GLint location, GLsizei count, GL
         uint32_t dataSize = 64 * count; /* mat4 std140: 4 vec4 = 64 bytes */
         if (!packed->valid || offset + dataSize > packed->size) return;
         memcpy(packed->data + offset, value, dataSize);
-        packed->dirty = true;
+        sgl_packed_mark_dirty(packed, offset, dataSize);
         SGL_TRACE_UNIFORM("glUniformMatrix4fv(packed loc=0x%X, count=%d)", location, count);
         return;
     }
@@ -1152,15 +1255,7 @@ GL_APICALL void GL_APIENTRY glUniformMatrix4fv(GLint location, GLsizei count, GL
 
     /* mat4 in std140: 4 columns of vec4 = 64 bytes */
     uint32_t data_size = 64 * count;
-    uint32_t aligned_size = SGL_ALIGN_UP(data_size, SGL_UNIFORM_ALIGNMENT);
-
-    /* ALWAYS allocate new offset to avoid data races between draws */
-    if (ctx->backend->ops->alloc_uniform) {
-        ub->offset = ctx->backend->ops->alloc_uniform(ctx->backend, aligned_size);
-        ub->size = aligned_size;
-        ub->data_size = data_size;
-        ub->valid = true;
-    }
+    sgl_uniform_reserve(ctx, ub, data_size);
 
     if (!ub->valid) return;
 
@@ -4,8 +4,13 @@
  */
 
 #include "gl_common.h"
+#include <GLES2/gl2sgl.h>
 #include <string.h>
 
+void sgl_vertex_layout_changed(sgl_context_t *ctx) {
+    ctx->vertex_layout_dirty = true;
+}
+
 GL_APICALL void GL_APIENTRY glEnableVertexAttribArray(GLuint index) {
     GET_CTX();
 
@@ -14,7 +19,11 @@ GL_APICALL void GL_APIENTRY glEnableVertexAttribArray(GLuint index) {
         return;
     }
 
-    ctx->vertex_attribs[index].enabled = true;
+    if (!ctx->vertex_attribs[index].enabled) {
+        ctx->vertex_attribs[index].enabled = true;
+        sgl_vertex_layout_changed(ctx);
+    }
+    SGL_CAPTURE(SGL_TRACE_ENABLE_VERTEX_ATTRIB_ARRAY, index);
     SGL_TRACE_VERTEX("glEnableVertexAttribArray(%u)", index);
 }
 
@@ -26,7 +35,11 @@ GL_APICALL void GL_APIENTRY glDisableVertexAttribArray(GLuint index) {
         return;
     }
 
-    ctx->vertex_attribs[index].enabled = false;
+    if (ctx->vertex_attribs[index].enabled) {
+        ctx->vertex_attribs[index].enabled = false;
+        sgl_vertex_layout_changed(ctx);
+    }
+    SGL_CAPTURE(SGL_TRACE_DISABLE_VERTEX_ATTRIB_ARRAY, index);
     SGL_TRACE_VERTEX("glDisableVertexAttribArray(%u)", index);
 }
 
@@ -47,6 +60,14 @@ GL_APICALL void GL_APIENTRY glVertexAttribPointer(GLuint index, GLint size, GLen
         case GL_UNSIGNED_SHORT:
         case GL_FLOAT:
         case GL_FIXED:
+        case GL_HALF_FLOAT_OES:     /* GL_OES_vertex_half_float */
+            break;
+        case GL_INT_2_10_10_10_REV:
+        case GL_UNSIGNED_INT_2_10_10_10_REV:
+            if (size != 4) {
+                sgl_set_error(ctx, GL_INVALID_OPERATION);
+                return;
+            }
             break;
         default:
             sgl_set_error(ctx, GL_INVALID_ENUM);
@@ -60,6 +81,11 @@ GL_APICALL void GL_APIENTRY glVertexAttribPointer(GLuint index, GLint size, GLen
     attr->stride = stride;
     attr->pointer = pointer;
     attr->buffer = ctx->bound_array_buffer;
+    sgl_vertex_layout_changed(ctx);
+
+    /* Client array contents are recorded by each draw (sgl_capture_draw_*) */
+    SGL_CAPTURE(SGL_TRACE_VERTEX_ATTRIB_POINTER, index, (uint32_t)size, type, normalized, (uint32_t)stride,
+                (uint32_t)(uintptr_t)pointer, ctx->bound_array_buffer == 0);
 
     SGL_TRACE_VERTEX("glVertexAttribPointer(%u, %d, 0x%X, %d, %d)", index, size, type, normalized, stride);
 }
@@ -93,6 +119,9 @@ GL_APICALL void GL_APIENTRY glGetVertexAttribfv(GLuint index, GLenum pname, GLfl
         case GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING:
             *params = (GLfloat)attr->buffer;
             break;
+        case GL_VERTEX_ATTRIB_ARRAY_DIVISOR_ANGLE:
+            *params = (GLfloat)attr->divisor;
+            break;
         case GL_CURRENT_VERTEX_ATTRIB:
             params[0] = attr->current_value[0];
             params[1] = attr->current_value[1];
@@ -134,6 +163,9 @@ GL_APICALL void GL_APIENTRY glGetVertexAttribiv(GLuint index, GLenum pname, GLin
         case GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING:
             *params = (GLint)attr->buffer;
             break;
+        case GL_VERTEX_ATTRIB_ARRAY_DIVISOR_ANGLE:
+            *params = (GLint)attr->divisor;
+            break;
         case GL_CURRENT_VERTEX_ATTRIB:
             params[0] = (GLint)attr->current_value[0];
             params[1] = (GLint)attr->current_value[1];
@@ -163,6 +195,12 @@ GL_APICALL void GL_APIENTRY glGetVertexAttribPointerv(GLuint index, GLenum pname
 }
 
 /* Vertex Attrib Constant Values */
+static void sgl_capture_attrib_value(sgl_context_t *ctx, GLuint index) {
+    const GLfloat *v = ctx->vertex_attribs[index].current_value;
+    SGL_CAPTURE(SGL_TRACE_VERTEX_ATTRIB4F, index, sgl_capture_float(v[0]), sgl_capture_float(v[1]),
+                sgl_capture_float(v[2]), sgl_capture_float(v[3]));
+}
+
 GL_APICALL void GL_APIENTRY glVertexAttrib1f(GLuint index, GLfloat x) {
     GET_CTX();
     if (index >= SGL_MAX_ATTRIBS) { sgl_set_error(ctx, GL_INVALID_VALUE); return; }
@@ -170,6 +208,7 @@ GL_APICALL void GL_APIENTRY glVertexAttrib1f(GLuint index, GLfloat x) {
     ctx->vertex_attribs[index].current_value[1] = 0.0f;
     ctx->vertex_attribs[index].current_value[2] = 0.0f;
     ctx->vertex_attribs[index].current_value[3] = 1.0f;
+    sgl_capture_attrib_value(ctx, index);
 }
 
 GL_APICALL void GL_APIENTRY glVertexAttrib2f(GLuint index, GLfloat x, GLfloat y) {
@@ -179,6 +218,7 @@ GL_APICALL void GL_APIENTRY glVertexAttrib2f(GLuint index, GLfloat x, GLfloat y)
     ctx->vertex_attribs[index].current_value[1] = y;
     ctx->vertex_attribs[index].current_value[2] = 0.0f;
     ctx->vertex_attribs[index].current_value[3] = 1.0f;
+    sgl_capture_attrib_value(ctx, index);
 }
 
 GL_APICALL void GL_APIENTRY glVertexAttrib3f(GLuint index, GLfloat x, GLfloat y, GLfloat z) {
@@ -188,6 +228,7 @@ GL_APICALL void GL_APIENTRY glVertexAttrib3f(GLuint index, GLfloat x, GLfloat y,
     ctx->vertex_attribs[index].current_value[1] = y;
     ctx->vertex_attribs[index].current_value[2] = z;
     ctx->vertex_attribs[index].current_value[3] = 1.0f;
+    sgl_capture_attrib_value(ctx, index);
 }
 
 GL_APICALL void GL_APIENTRY glVertexAttrib4f(GLuint index, GLfloat x, GLfloat y, GLfloat z, GLfloat w) {
@@ -197,6 +238,7 @@ GL_APICALL void GL_APIENTRY glVertexAttrib4f(GLuint index, GLfloat x, GLfloat y,
     ctx->vertex_attribs[index].current_value[1] = y;
     ctx->vertex_attribs[index].current_value[2] = z;
     ctx->vertex_attribs[index].current_value[3] = w;
+    sgl_capture_attrib_value(ctx, index);
 }
 
 GL_APICALL void GL_APIENTRY glVertexAttrib1fv(GLuint index, const GLfloat *v) {
@@ -218,3 +260,147 @@ GL_APICALL void GL_APIENTRY glVertexAttrib4fv(GLuint index, const GLfloat *v) {
     if (!v) return;
     glVertexAttrib4f(index, v[0], v[1], v[2], v[3]);
 }
+
+/* ============================================================================
+ * Instanced Arrays (GL_ANGLE_instanced_arrays / GL_EXT_instanced_arrays)
+ *
+ * The divisor is part of the attribute layout (VAO state); deko3d takes it
+ * directly as the vertex buffer's instance divisor.
+ * ============================================================================ */
+
+GL_APICALL void GL_APIENTRY glVertexAttribDivisorANGLE(GLuint index, GLuint divisor) {
+    GET_CTX();
+
+    if (index >= SGL_MAX_ATTRIBS) {
+        sgl_set_error(ctx, GL_INVALID_VALUE);
+        return;
+    }
+
+    if (ctx->vertex_attribs[index].divisor != divisor) {
+        ctx->vertex_attribs[index].divisor = divisor;
+        sgl_vertex_layout_changed(ctx);
+    }
+    SGL_CAPTURE(SGL_TRACE_VERTEX_ATTRIB_DIVISOR, index, divisor);
+    SGL_TRACE_VERTEX("glVertexAttribDivisorANGLE(%u, %u)", index, divisor);
+}
+
+GL_APICALL void GL_APIENTRY glVertexAttribDivisorEXT(GLuint index, GLuint divisor) {
+    glVertexAttribDivisorANGLE(index, divisor);
+}
+
+/* ============================================================================
+ * Vertex Array Objects (GL_OES_vertex_array_object)
+ *
+ * The bound VAO's state is kept in the context so the rest of the GL layer
+ * reads ctx->vertex_attribs / ctx->bound_element_buffer unchanged. Binding
+ * another VAO parks the current state in its object and loads the new one.
+ * The backend caches the deko3d vertex state of each VAO (see gl_draw.c).
+ * ============================================================================ */
+
+static sgl_vertex_array_t *sgl_vertex_array_storage(sgl_context_t *ctx, GLuint id) {
+    return id == 0 ? &ctx->default_vertex_array : GET_VERTEX_ARRAY(id);
+}
+
+GL_APICALL void GL_APIENTRY glGenVertexArraysOES(GLsizei n, GLuint *arrays) {
+    GET_CTX();
+
+    if (n < 0) { sgl_set_error(ctx, GL_INVALID_VALUE); return; }
+    if (!arrays) return;
+
+    for (GLsizei i = 0; i < n; i++) {
+        arrays[i] = sgl_res_mgr_alloc_vertex_array(ctx->res_mgr);
+        if (arrays[i] == 0) {
+            sgl_set_error(ctx, GL_OUT_OF_MEMORY);
+            return;
+        }
+    }
+
+    SGL_CAPTURE_DATA(SGL_TRACE_GEN_VERTEX_ARRAYS, arrays, (uint32_t)n * 4, (uint32_t)n);
+    SGL_TRACE_VERTEX("glGenVertexArraysOES(%d)", n);
+}
+
+GL_APICALL void GL_APIENTRY glBindVertexArrayOES(GLuint array) {
+    GET_CTX();
+
+    sgl_vertex_array_t *next = sgl_vertex_array_storage(ctx, array);
+    if (!next) {
+        sgl_set_error(ctx, GL_INVALID_OPERATION);
+        return;
+    }
+    if (array == ctx->bound_vertex_array) return;
+
+    /* Park the current VAO's state; a recorder only parks its own copy of VAO 0,
+     * named VAOs are shared with the GL thread and read-only while recording */
+    sgl_vertex_array_t *prev = sgl_vertex_array_storage(ctx, ctx->bound_vertex_array);
+    if (prev && (!ctx->recorder || ctx->bound_vertex_array == 0)) {
+        memcpy(prev->attribs, ctx->vertex_attribs, sizeof(prev->attribs));
+        prev->element_buffer = ctx->bound_element_buffer;
+        prev->layout_dirty = ctx->vertex_layout_dirty;
+    }
+
+    /* Load the new one (current attribute values stay context state) */
+    sgl_vertex_array_t fresh;
+    if (array != 0 && !next->bound_once) {
+        if (ctx->recorder) next = &fresh;
+        /* First bind creates the object with default state */
+        for (int i = 0; i < SGL_MAX_ATTRIBS; i++) {
+            next->attribs[i].enabled = false;
+            next->attribs[i].size = 4;
+            next->attribs[i].type = GL_FLOAT;
+            next->attribs[i].normalized = GL_FALSE;
+            next->attribs[i].stride = 0;
+            next->attribs[i].pointer = NULL;
+            next->attribs[i].buffer = 0;
+            next->attribs[i].buffer_offset = 0;
+            next->attribs[i].divisor = 0;
+        }
+        next->element_buffer = 0;
+        next->layout_dirty = true;
+        next->bound_once = true;
+    }
+    for (int i = 0; i < SGL_MAX_ATTRIBS; i++) {
+        GLfloat value[4];
+        memcpy(value, ctx->vertex_attribs[i].current_value, sizeof(value));
+        ctx->vertex_attribs[i] = next->attribs[i];
+        memcpy(ctx->vertex_attribs[i].current_value, value, sizeof(value));
+    }
+    ctx->bound_element_buffer = next->element_buffer;
+    ctx->vertex_layout_dirty = next->layout_dirty;
+    ctx->bound_vertex_array = array;
+
+    SGL_CAPTURE(SGL_TRACE_BIND_VERTEX_ARRAY, array);
+    SGL_TRACE_VERTEX("glBindVertexArrayOES(%u)", array);
+}
+
+GL_APICALL void GL_APIENTRY glDeleteVertexArraysOES(GLsizei n, const GLuint *arrays) {
+    GET_CTX();
+    sgl_flush_deferred(ctx);
+
+    if (n < 0) { sgl_set_error(ctx, GL_INVALID_VALUE); return; }
+    if (!arrays) return;
+
+    for (GLsizei i = 0; i < n; i++) {
+        GLuint id = arrays[i];
+        if (id == 0 || !GET_VERTEX_ARRAY(id)) continue;
+
+        /* Deleting the bound VAO reverts to the default one */
+        if (ctx->bound_vertex_array == id) {
+            glBindVertexArrayOES(0);
+        }
+
+        if (ctx->backend && ctx->backend->ops->delete_vertex_array) {
+            ctx->backend->ops->delete_vertex_array(ctx->backend, id);
+        }
+        sgl_res_mgr_free_vertex_array(ctx->res_mgr, id);
+    }
+
+    SGL_CAPTURE_DATA(SGL_TRACE_DELETE_VERTEX_ARRAYS, arrays, (uint32_t)n * 4, (uint32_t)n);
+    SGL_TRACE_VERTEX("glDeleteVertexArraysOES(%d)", n);
+}
+
+GL_APICALL GLboolean GL_APIENTRY glIsVertexArrayOES(GLuint array) {
+    GET_CTX_RET(GL_FALSE);
+
+    sgl_vertex_array_t *vao = GET_VERTEX_ARRAY(array);
+    return (vao && vao->bound_once) ? GL_TRUE : GL_FALSE;
+}
@@ -0,0 +1,625 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * Host EGL - EGL on top of the null backend
+ *
+ * Stands in for egl_impl.c in host builds (Makefile.host) so the GL layer
+ * can be run and profiled on a PC. Surfaces are just a size; swap ends the
+ * backend frame and the next GL call begins a new one, as on the device.
+ * Window surfaces take EGL_WIDTH/EGL_HEIGHT from the attribute list
+ * (default 1280x720) since there is no native window.
+ */
+
+#define _GNU_SOURCE
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+#include <GLES2/gl2sgl.h>
+#include <dlfcn.h>
+#include <string.h>
+
+#include "../context/sgl_context.h"
+#include "../context/sgl_sync.h"
+#include "../backend/null/null_backend.h"
+#include "../util/sgl_log.h"
+
+#define HOST_NUM_SLOTS 3
+
+struct sgl_surface {
+    bool used;
+    EGLint width;
+    EGLint height;
+    int current_slot;
+    bool need_acquire;
+    bool shared_depth;      /* EGL_SHARED_DEPTH_BUFFER_SGL (no depth buffers on the host) */
+};
+
+typedef struct {
+    bool initialized;
+} host_display_t;
+
+static struct {
+    EGLint last_error;
+    EGLenum current_api;
+    host_display_t display;
+    EGLint config_id;
+    sgl_surface_t surfaces[SGL_MAX_SURFACES];
+    sgl_context_t contexts[SGL_MAX_CONTEXTS];
+    sgl_resource_manager_t res_mgrs[SGL_MAX_CONTEXTS];
+    int swapchain_images;
+    GLenum frame_pacing;
+    sgl_heap_config_t heap_config;  /* sglSetHeapConfig */
+} g_host;
+
+static void host_set_error(EGLint error) {
+    g_host.last_error = error;
+}
+
+static bool host_check_display(EGLDisplay dpy) {
+    if (dpy != (EGLDisplay)&g_host.display || !g_host.display.initialized) {
+        host_set_error(EGL_BAD_DISPLAY);
+        return false;
+    }
+    return true;
+}
+
+static void host_begin_frame(sgl_context_t *ctx, sgl_surface_t *surf) {
+    int slot = ctx->backend->ops->acquire_image(ctx->backend);
+    surf->current_slot = slot;
+    surf->need_acquire = false;
+    ctx->backend->ops->wait_fence(ctx->backend, slot);
+    ctx->backend->ops->begin_frame(ctx->backend, slot);
+    sgl_context_invalidate_state(ctx);
+}
+
+/* The backend goes with the last context of its share group */
+static void host_destroy_context(sgl_context_t *ctx) {
+    sgl_backend_t *backend = ctx->backend;
+    bool last = ctx->res_mgr->share_count == 1;
+    if (last) sgl_sync_release_backend(backend);
+    sgl_context_destroy(ctx);
+    if (last) null_backend_destroy(backend);
+}
+
+/* Called by the GL layer at the start of a frame (see egl_impl.c) */
+void sgl_ensure_frame_ready(void) {
+    sgl_context_t *ctx = sgl_get_current_context();
+    if (!ctx || !ctx->draw_surface || !ctx->backend || ctx->recorder) return;
+    if (ctx->draw_surface->need_acquire) host_begin_frame(ctx, ctx->draw_surface);
+}
+
+/* ============================================================================
+ * Display and Configs
+ * ============================================================================ */
+
+EGLAPI EGLint EGLAPIENTRY eglGetError(void) {
+    EGLint error = g_host.last_error;
+    g_host.last_error = EGL_SUCCESS;
+    return error;
+}
+
+EGLAPI EGLDisplay EGLAPIENTRY eglGetDisplay(EGLNativeDisplayType display_id) {
+    (void)display_id;
+    return (EGLDisplay)&g_host.display;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglInitialize(EGLDisplay dpy, EGLint *major, EGLint *minor) {
+    if (dpy != (EGLDisplay)&g_host.display) {
+        host_set_error(EGL_BAD_DISPLAY);
+        return EGL_FALSE;
+    }
+    if (!g_host.display.initialized) {
+        g_host.display.initialized = true;
+        g_host.config_id = 1;
+        sgl_log_init();
+    }
+    if (major) *major = 1;
+    if (minor) *minor = 4;
+    return EGL_TRUE;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglTerminate(EGLDisplay dpy) {
+    if (dpy != (EGLDisplay)&g_host.display) {
+        host_set_error(EGL_BAD_DISPLAY);
+        return EGL_FALSE;
+    }
+    if (!g_host.display.initialized) return EGL_TRUE;
+
+    sgl_context_make_current(NULL, false);
+    for (int i = 0; i < SGL_MAX_CONTEXTS; i++) {
+        if (g_host.contexts[i].used) host_destroy_context(&g_host.contexts[i]);
+    }
+    memset(g_host.surfaces, 0, sizeof(g_host.surfaces));
+
+    g_host.display.initialized = false;
+    sgl_log_shutdown();
+    return EGL_TRUE;
+}
+
+EGLAPI const char * EGLAPIENTRY eglQueryString(EGLDisplay dpy, EGLint name) {
+    if (!host_check_display(dpy)) return NULL;
+    switch (name) {
+        case EGL_VENDOR:      return "SwitchGLES";
+        case EGL_VERSION:     return "1.4 SwitchGLES (host)";
+        case EGL_EXTENSIONS:  return "EGL_KHR_fence_sync";
+        case EGL_CLIENT_APIS: return "OpenGL_ES";
+        default:
+            host_set_error(EGL_BAD_PARAMETER);
+            return NULL;
+    }
+}
+
+/* One RGBA8 + D24S8 config that matches any request */
+EGLAPI EGLBoolean EGLAPIENTRY eglGetConfigs(EGLDisplay dpy, EGLConfig *configs,
+                                             EGLint config_size, EGLint *num_config) {
+    if (!host_check_display(dpy)) return EGL_FALSE;
+    if (!num_config) {
+        host_set_error(EGL_BAD_PARAMETER);
+        return EGL_FALSE;
+    }
+    *num_config = (configs && config_size < 1) ? 0 : 1;
+    if (configs && config_size > 0) configs[0] = (EGLConfig)&g_host.config_id;
+    return EGL_TRUE;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglChooseConfig(EGLDisplay dpy, const EGLint *attrib_list,
+                                               EGLConfig *configs, EGLint config_size,
+                                               EGLint *num_config) {
+    (void)attrib_list;
+    return eglGetConfigs(dpy, configs, config_size, num_config);
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglGetConfigAttrib(EGLDisplay dpy, EGLConfig config,
+                                                  EGLint attribute, EGLint *value) {
+    (void)config;
+    if (!host_check_display(dpy)) return EGL_FALSE;
+    if (!value) {
+        host_set_error(EGL_BAD_PARAMETER);
+        return EGL_FALSE;
+    }
+    switch (attribute) {
+        case EGL_CONFIG_ID:       *value = 1; break;
+        case EGL_RED_SIZE:
+        case EGL_GREEN_SIZE:
+        case EGL_BLUE_SIZE:
+        case EGL_ALPHA_SIZE:      *value = 8; break;
+        case EGL_BUFFER_SIZE:     *value = 32; break;
+        case EGL_DEPTH_SIZE:      *value = 24; break;
+        case EGL_STENCIL_SIZE:    *value = 8; break;
+        case EGL_SAMPLES:
+        case EGL_SAMPLE_BUFFERS:  *value = 0; break;
+        case EGL_SURFACE_TYPE:    *value = EGL_WINDOW_BIT | EGL_PBUFFER_BIT; break;
+        case EGL_RENDERABLE_TYPE: *value = EGL_OPENGL_ES2_BIT; break;
+        default:
+            host_set_error(EGL_BAD_ATTRIBUTE);
+            return EGL_FALSE;
+    }
+    return EGL_TRUE;
+}
+
+/* ============================================================================
+ * Surfaces
+ * ============================================================================ */
+
+static EGLSurface host_create_surface(EGLDisplay dpy, const EGLint *attrib_list) {
+    if (!host_check_display(dpy)) return EGL_NO_SURFACE;
+
+    sgl_surface_t *surf = NULL;
+    for (int i = 0; i < SGL_MAX_SURFACES && !surf; i++) {
+        if (!g_host.surfaces[i].used) surf = &g_host.surfaces[i];
+    }
+    if (!surf) {
+        host_set_error(EGL_BAD_ALLOC);
+        return EGL_NO_SURFACE;
+    }
+
+    surf->width = 1280;
+    surf->height = 720;
+    surf->shared_depth = true;
+    for (int i = 0; attrib_list && attrib_list[i] != EGL_NONE; i += 2) {
+        if (attrib_list[i] == EGL_WIDTH) surf->width = attrib_list[i + 1];
+        if (attrib_list[i] == EGL_HEIGHT) surf->height = attrib_list[i + 1];
+        if (attrib_list[i] == EGL_SHARED_DEPTH_BUFFER_SGL) surf->shared_depth = attrib_list[i + 1] != EGL_FALSE;
+    }
+    surf->used = true;
+    surf->current_slot = 0;
+    surf->need_acquire = true;
+    return (EGLSurface)surf;
+}
+
+EGLAPI EGLSurface EGLAPIENTRY eglCreateWindowSurface(EGLDisplay dpy, EGLConfig config,
+                                                      EGLNativeWindowType win,
+                                                      const EGLint *attrib_list) {
+    (void)config;
+    (void)win;
+    return host_create_surface(dpy, attrib_list);
+}
+
+EGLAPI EGLSurface EGLAPIENTRY eglCreatePbufferSurface(EGLDisplay dpy, EGLConfig config,
+                                                       const EGLint *attrib_list) {
+    (void)config;
+    return host_create_surface(dpy, attrib_list);
+}
+
+EGLAPI EGLSurface EGLAPIENTRY eglCreatePixmapSurface(EGLDisplay dpy, EGLConfig config,
+                                                      EGLNativePixmapType pixmap,
+                                                      const EGLint *attrib_list) {
+    (void)dpy; (void)config; (void)pixmap; (void)attrib_list;
+    host_set_error(EGL_BAD_NATIVE_PIXMAP);
+    return EGL_NO_SURFACE;
+}
+
+EGLAPI EGLSurface EGLAPIENTRY eglCreatePbufferFromClientBuffer(EGLDisplay dpy, EGLenum buftype,
+                                                                EGLClientBuffer buffer, EGLConfig config,
+                                                                const EGLint *attrib_list) {
+    (void)dpy; (void)buftype; (void)buffer; (void)config; (void)attrib_list;
+    host_set_error(EGL_BAD_PARAMETER);
+    return EGL_NO_SURFACE;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglDestroySurface(EGLDisplay dpy, EGLSurface surface) {
+    sgl_surface_t *surf = (sgl_surface_t *)surface;
+    if (!host_check_display(dpy)) return EGL_FALSE;
+    if (!surf || !surf->used) {
+        host_set_error(EGL_BAD_SURFACE);
+        return EGL_FALSE;
+    }
+    memset(surf, 0, sizeof(*surf));
+    return EGL_TRUE;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglQuerySurface(EGLDisplay dpy, EGLSurface surface,
+                                               EGLint attribute, EGLint *value) {
+    sgl_surface_t *surf = (sgl_surface_t *)surface;
+    if (!host_check_display(dpy)) return EGL_FALSE;
+    if (!surf || !surf->used || !value) {
+        host_set_error(EGL_BAD_SURFACE);
+        return EGL_FALSE;
+    }
+    switch (attribute) {
+        case EGL_WIDTH:         *value = surf->width; break;
+        case EGL_HEIGHT:        *value = surf->height; break;
+        case EGL_CONFIG_ID:     *value = 1; break;
+        case EGL_RENDER_BUFFER: *value = EGL_BACK_BUFFER; break;
+        case EGL_SWAP_BEHAVIOR: *value = EGL_BUFFER_DESTROYED; break;
+        case EGL_SHARED_DEPTH_BUFFER_SGL: *value = surf->shared_depth ? EGL_TRUE : EGL_FALSE; break;
+        default:
+            host_set_error(EGL_BAD_ATTRIBUTE);
+            return EGL_FALSE;
+    }
+    return EGL_TRUE;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglSurfaceAttrib(EGLDisplay dpy, EGLSurface surface,
+                                                EGLint attribute, EGLint value) {
+    (void)dpy; (void)surface; (void)attribute; (void)value;
+    return EGL_TRUE;
+}
+
+/* ============================================================================
+ * Contexts
+ * ============================================================================ */
+
+EGLAPI EGLContext EGLAPIENTRY eglCreateContext(EGLDisplay dpy, EGLConfig config,
+                                                EGLContext share_context,
+                                                const EGLint *attrib_list) {
+    (void)config;
+    if (!host_check_display(dpy)) return EGL_NO_CONTEXT;
+
+    sgl_context_t *share = (sgl_context_t *)share_context;
+    if (share && !share->used) {
+        host_set_error(EGL_BAD_CONTEXT);
+        return EGL_NO_CONTEXT;
+    }
+
+    EGLint client_version = 1;
+    sgl_heap_config_t heaps = g_host.heap_config;
+    bool bad_size = false;
+    for (int i = 0; attrib_list && attrib_list[i] != EGL_NONE; i += 2) {
+        EGLint value = attrib_list[i + 1];
+        switch (attrib_list[i]) {
+            case EGL_CONTEXT_CLIENT_VERSION: client_version = value; break;
+            case EGL_HEAP_CODE_SIZE_SGL:     heaps.code_size = (GLuint)value; break;
+            case EGL_HEAP_DATA_SIZE_SGL:     heaps.data_size = (GLuint)value; break;
+            case EGL_HEAP_TEXTURE_SIZE_SGL:  heaps.texture_size = (GLuint)value; break;
+            case EGL_HEAP_STAGING_SIZE_SGL:  heaps.staging_size = (GLuint)value; break;
+            case EGL_HEAP_COMMAND_SIZE_SGL:  heaps.cmd_size = (GLuint)value; break;
+            case EGL_HEAP_FIXED_SIZE_SGL:    heaps.fixed_size = value ? GL_TRUE : GL_FALSE; break;
+            default: continue;
+        }
+        if (value < 0) bad_size = true;
+    }
+    if (client_version != 2 || bad_size) {
+        host_set_error(EGL_BAD_ATTRIBUTE);
+        return EGL_NO_CONTEXT;
+    }
+
+    /* A slot's resource manager stays taken while its share group lives */
+    int ctx_idx = -1;
+    for (int i = 0; i < SGL_MAX_CONTEXTS && ctx_idx < 0; i++) {
+        if (!g_host.contexts[i].used && (share || g_host.res_mgrs[i].share_count == 0)) ctx_idx = i;
+    }
+    if (ctx_idx < 0) {
+        host_set_error(EGL_BAD_ALLOC);
+        return EGL_NO_CONTEXT;
+    }
+
+    sgl_backend_t *backend;
+    if (share) {
+        backend = share->backend;
+        backend->ops->share(backend);
+    } else {
+        backend = null_backend_create();
+        if (!backend || backend->ops->init(backend, NULL, &heaps) != 0) {
+            null_backend_destroy(backend);
+            host_set_error(EGL_BAD_ALLOC);
+            return EGL_NO_CONTEXT;
+        }
+    }
+
+    sgl_context_t *ctx = &g_host.contexts[ctx_idx];
+    sgl_context_init(ctx, share ? share->res_mgr : &g_host.res_mgrs[ctx_idx]);
+    ctx->client_version = client_version;
+
+    ctx->backend = backend;
+    ctx->used = true;
+    sgl_context_init_state(ctx);
+    return (EGLContext)ctx;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglDestroyContext(EGLDisplay dpy, EGLContext context) {
+    sgl_context_t *ctx = (sgl_context_t *)context;
+    if (!host_check_display(dpy)) return EGL_FALSE;
+    if (!ctx || !ctx->used) {
+        host_set_error(EGL_BAD_CONTEXT);
+        return EGL_FALSE;
+    }
+    if (sgl_get_current_context() == ctx) sgl_context_make_current(NULL, false);
+
+    host_destroy_context(ctx);
+    return EGL_TRUE;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglMakeCurrent(EGLDisplay dpy, EGLSurface draw,
+                                              EGLSurface read, EGLContext context) {
+    sgl_context_t *ctx = (sgl_context_t *)context;
+    if (!host_check_display(dpy)) return EGL_FALSE;
+
+    if (context == EGL_NO_CONTEXT) {
+        sgl_context_make_current(NULL, false);
+        return EGL_TRUE;
+    }
+    if (!ctx->used) {
+        host_set_error(EGL_BAD_CONTEXT);
+        return EGL_FALSE;
+    }
+    if (!sgl_context_make_current(ctx, draw != EGL_NO_SURFACE)) {
+        host_set_error(EGL_BAD_ACCESS);
+        return EGL_FALSE;
+    }
+
+    ctx->draw_surface = (sgl_surface_t *)draw;
+    ctx->read_surface = (sgl_surface_t *)read;
+
+    if (ctx->draw_surface) host_begin_frame(ctx, ctx->draw_surface);
+    return EGL_TRUE;
+}
+
+EGLAPI EGLContext EGLAPIENTRY eglGetCurrentContext(void) {
+    return (EGLContext)sgl_get_current_context();
+}
+
+EGLAPI EGLDisplay EGLAPIENTRY eglGetCurrentDisplay(void) {
+    return sgl_get_current_context() ? (EGLDisplay)&g_host.display : EGL_NO_DISPLAY;
+}
+
+EGLAPI EGLSurface EGLAPIENTRY eglGetCurrentSurface(EGLint readdraw) {
+    sgl_context_t *ctx = sgl_get_current_context();
+    if (!ctx) return EGL_NO_SURFACE;
+    if (readdraw == EGL_DRAW) return (EGLSurface)ctx->draw_surface;
+    if (readdraw == EGL_READ) return (EGLSurface)ctx->read_surface;
+    host_set_error(EGL_BAD_PARAMETER);
+    return EGL_NO_SURFACE;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglQueryContext(EGLDisplay dpy, EGLContext context,
+                                               EGLint attribute, EGLint *value) {
+    sgl_context_t *ctx = (sgl_context_t *)context;
+    if (!host_check_display(dpy)) return EGL_FALSE;
+    if (!ctx || !ctx->used || !value) {
+        host_set_error(EGL_BAD_CONTEXT);
+        return EGL_FALSE;
+    }
+    switch (attribute) {
+        case EGL_CONFIG_ID:              *value = 1; break;
+        case EGL_CONTEXT_CLIENT_TYPE:    *value = EGL_OPENGL_ES_API; break;
+        case EGL_CONTEXT_CLIENT_VERSION: *value = ctx->client_version; break;
+        case EGL_RENDER_BUFFER:          *value = EGL_BACK_BUFFER; break;
+        default:
+            host_set_error(EGL_BAD_ATTRIBUTE);
+            return EGL_FALSE;
+    }
+    return EGL_TRUE;
+}
+
+/* ============================================================================
+ * Swap
+ * ============================================================================ */
+
+EGLAPI EGLBoolean EGLAPIENTRY eglSwapBuffers(EGLDisplay dpy, EGLSurface surface) {
+    sgl_surface_t *surf = (sgl_surface_t *)surface;
+    if (!host_check_display(dpy)) return EGL_FALSE;
+    if (!surf || !surf->used) {
+        host_set_error(EGL_BAD_SURFACE);
+        return EGL_FALSE;
+    }
+
+    sgl_context_t *ctx = sgl_get_current_context();
+    if (!ctx || !ctx->backend) {
+        host_set_error(EGL_BAD_CONTEXT);
+        return EGL_FALSE;
+    }
+    sgl_context_flush_deferred(ctx);
+    sgl_context_capture_swap(ctx);
+    if (surf->need_acquire) return EGL_TRUE;
+
+    ctx->backend->ops->end_frame(ctx->backend, surf->current_slot);
+    ctx->backend->ops->present(ctx->backend, surf->current_slot);
+    surf->need_acquire = true;
+    ctx->frame_count++;
+    return EGL_TRUE;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglSwapInterval(EGLDisplay dpy, EGLint interval) {
+    (void)interval;
+    return host_check_display(dpy) ? EGL_TRUE : EGL_FALSE;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglCopyBuffers(EGLDisplay dpy, EGLSurface surface,
+                                              EGLNativePixmapType target) {
+    (void)dpy; (void)surface; (void)target;
+    host_set_error(EGL_BAD_NATIVE_PIXMAP);
+    return EGL_FALSE;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglBindTexImage(EGLDisplay dpy, EGLSurface surface, EGLint buffer) {
+    (void)dpy; (void)surface; (void)buffer;
+    host_set_error(EGL_BAD_SURFACE);
+    return EGL_FALSE;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglReleaseTexImage(EGLDisplay dpy, EGLSurface surface, EGLint buffer) {
+    (void)dpy; (void)surface; (void)buffer;
+    host_set_error(EGL_BAD_SURFACE);
+    return EGL_FALSE;
+}
+
+/* ============================================================================
+ * API / Threads
+ * ============================================================================ */
+
+EGLAPI EGLBoolean EGLAPIENTRY eglBindAPI(EGLenum api) {
+    if (api != EGL_OPENGL_ES_API) {
+        host_set_error(EGL_BAD_PARAMETER);
+        return EGL_FALSE;
+    }
+    g_host.current_api = api;
+    return EGL_TRUE;
+}
+
+EGLAPI EGLenum EGLAPIENTRY eglQueryAPI(void) {
+    return g_host.current_api ? g_host.current_api : EGL_OPENGL_ES_API;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglWaitClient(void) { return EGL_TRUE; }
+EGLAPI EGLBoolean EGLAPIENTRY eglWaitGL(void) { return EGL_TRUE; }
+EGLAPI EGLBoolean EGLAPIENTRY eglWaitNative(EGLint engine) { (void)engine; return EGL_TRUE; }
+EGLAPI EGLBoolean EGLAPIENTRY eglReleaseThread(void) { return EGL_TRUE; }
+
+/* ============================================================================
+ * EGL_KHR_fence_sync (fences share the GL_APPLE_sync pool, as on the device)
+ * ============================================================================ */
+
+EGLAPI EGLSyncKHR EGLAPIENTRY eglCreateSyncKHR(EGLDisplay dpy, EGLenum type, const EGLint *attrib_list) {
+    if (!host_check_display(dpy)) return EGL_NO_SYNC_KHR;
+    if (type != EGL_SYNC_FENCE_KHR || (attrib_list && attrib_list[0] != EGL_NONE)) {
+        host_set_error(EGL_BAD_ATTRIBUTE);
+        return EGL_NO_SYNC_KHR;
+    }
+
+    sgl_context_t *ctx = sgl_get_current_context();
+    if (!ctx || !ctx->backend || ctx->recorder) {
+        host_set_error(EGL_BAD_MATCH);
+        return EGL_NO_SYNC_KHR;
+    }
+
+    sgl_ensure_frame_ready();
+    sgl_sync_t *sync = sgl_sync_create(ctx->backend);
+    if (!sync) {
+        host_set_error(EGL_BAD_ALLOC);
+        return EGL_NO_SYNC_KHR;
+    }
+    return (EGLSyncKHR)sync;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglDestroySyncKHR(EGLDisplay dpy, EGLSyncKHR sync) {
+    if (!host_check_display(dpy)) return EGL_FALSE;
+    sgl_sync_t *s = sgl_sync_lookup(sync);
+    if (!s) {
+        host_set_error(EGL_BAD_PARAMETER);
+        return EGL_FALSE;
+    }
+    sgl_sync_delete(s);
+    return EGL_TRUE;
+}
+
+EGLAPI EGLint EGLAPIENTRY eglClientWaitSyncKHR(EGLDisplay dpy, EGLSyncKHR sync, EGLint flags, EGLTimeKHR timeout) {
+    (void)flags;
+    if (!host_check_display(dpy)) return EGL_FALSE;
+    sgl_sync_t *s = sgl_sync_lookup(sync);
+    if (!s) {
+        host_set_error(EGL_BAD_PARAMETER);
+        return EGL_FALSE;
+    }
+    return sgl_sync_wait(s, timeout) ? EGL_CONDITION_SATISFIED_KHR : EGL_TIMEOUT_EXPIRED_KHR;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglGetSyncAttribKHR(EGLDisplay dpy, EGLSyncKHR sync, EGLint attribute, EGLint *value) {
+    if (!host_check_display(dpy)) return EGL_FALSE;
+    sgl_sync_t *s = sgl_sync_lookup(sync);
+    if (!s || !value) {
+        host_set_error(EGL_BAD_PARAMETER);
+        return EGL_FALSE;
+    }
+
+    switch (attribute) {
+        case EGL_SYNC_TYPE_KHR:      *value = EGL_SYNC_FENCE_KHR; break;
+        case EGL_SYNC_CONDITION_KHR: *value = EGL_SYNC_PRIOR_COMMANDS_COMPLETE_KHR; break;
+        case EGL_SYNC_STATUS_KHR:
+            *value = sgl_sync_wait(s, 0) ? EGL_SIGNALED_KHR : EGL_UNSIGNALED_KHR;
+            break;
+        default:
+            host_set_error(EGL_BAD_ATTRIBUTE);
+            return EGL_FALSE;
+    }
+    return EGL_TRUE;
+}
+
+/* Every GL and EGL entry point is an exported symbol of the executable (-rdynamic) */
+EGLAPI __eglMustCastToProperFunctionPointerType EGLAPIENTRY eglGetProcAddress(const char *procname) {
+    if (!procname || (strncmp(procname, "gl", 2) != 0 && strncmp(procname, "egl", 3) != 0)) return NULL;
+    return (__eglMustCastToProperFunctionPointerType)dlsym(RTLD_DEFAULT, procname);
+}
+
+/* ============================================================================
+ * SwitchGLES Extensions implemented by egl_impl.c on the device
+ * ============================================================================ */
+
+GL_APICALL void GL_APIENTRY sglSetFramePacing(GLint swapchain_images, GLenum mode) {
+    if (swapchain_images != 0 && (swapchain_images < 2 || swapchain_images > HOST_NUM_SLOTS)) return;
+    if (mode != SGL_FRAME_PACING_THROUGHPUT && mode != SGL_FRAME_PACING_LOW_LATENCY) return;
+    g_host.swapchain_images = swapchain_images;
+    g_host.frame_pacing = mode;
+}
+
+GL_APICALL void GL_APIENTRY sglGetFrameLatency(GLuint *swapchain_images, GLuint *queued_frames,
+                                               GLuint *acquire_wait_us, GLuint *gpu_wait_us) {
+    int images = g_host.swapchain_images ? g_host.swapchain_images : HOST_NUM_SLOTS;
+    if (swapchain_images) *swapchain_images = (GLuint)images;
+    if (queued_frames) {
+        *queued_frames = g_host.frame_pacing == SGL_FRAME_PACING_LOW_LATENCY ? 0 : (GLuint)(images - 1);
+    }
+    if (acquire_wait_us) *acquire_wait_us = 0;
+    if (gpu_wait_us) *gpu_wait_us = 0;
+}
+
+GL_APICALL void GL_APIENTRY sglSetHeapConfig(const sgl_heap_config_t *config) {
+    if (config) {
+        g_host.heap_config = *config;
+    } else {
+        memset(&g_host.heap_config, 0, sizeof(g_host.heap_config));
+    }
+}
+
+GL_APICALL GLboolean GL_APIENTRY sglSetLogOutput(const GLchar *path) {
+    return sgl_log_set_output(path) ? GL_TRUE : GL_FALSE;
+}
@@ -29,8 +29,8 @@ typedef struct {
     int   cap;
 } strbuf_t;
 
-static void sb_init(strbuf_t *sb) {
-    sb->cap = 4096;
+static void sb_init_cap(strbuf_t *sb, int cap) {
+    sb->cap = cap;
     sb->buf = (char *)malloc(sb->cap);
     sb->len = 0;
     if (sb->buf) sb->buf[0] = '\0';
@@ -43,11 +43,15 @@ static void sb_ensure(strbuf_t *sb, int extra) {
     }
 }
 
+static void sb_append_n(strbuf_t *sb, const char *str, int len) {
+    sb_ensure(sb, len);
+    memcpy(sb->buf + sb->len, str, len);
+    sb->len += len;
+    sb->buf[sb->len] = '\0';
+}
+
 static void sb_append(strbuf_t *sb, const char *str) {
-    int slen = (int)strlen(str);
-    sb_ensure(sb, slen);
-    memcpy(sb->buf + sb->len, str, slen + 1);
-    sb->len += slen;
+    sb_append_n(sb, str, (int)strlen(str));
 }
 
 static void sb_printf(strbuf_t *sb, const char *fmt, ...) {
@@ -92,13 +96,6 @@ static const type_info_t s_types[] = {
     { NULL, 0, 0, 0, 0 }
 };
 
-static const type_info_t *find_type_info(const char *name) {
-    for (const type_info_t *t = s_types; t->name; t++) {
-        if (strcmp(t->name, name) == 0) return t;
-    }
-    return NULL;
-}
-
 static const type_info_t *find_type_info_by_enum(glslt_type_t type) {
     for (const type_info_t *t = s_types; t->name; t++) {
         if (t->type == type) return t;
@@ -134,50 +131,6 @@ static const char *skip_ws(const char *p) {
     return p;
 }
 
-static const char *read_word(const char *p, char *out, int out_size) {
-    const char *start = p;
-    int i = 0;
-    while (*p && is_ident_char(*p) && i < out_size - 1) {
-        out[i++] = *p++;
-    }
-    out[i] = '\0';
-    return (i > 0) ? p : start;
-}
-
-/* Check if string starts with a word (not part of a longer identifier) */
-static int starts_with_word(const char *str, const char *word) {
-    int len = (int)strlen(word);
-    if (strncmp(str, word, len) != 0) return 0;
-    if (is_ident_char(str[len])) return 0;
-    return 1;
-}
-
-/* Replace all occurrences of 'old' with 'new' respecting word boundaries */
-static void replace_word(const char *input, const char *old_word,
-                         const char *new_word, char *out, int out_size) {
-    int old_len = (int)strlen(old_word);
-    int new_len = (int)strlen(new_word);
-    const char *p = input;
-    char *o = out;
-    char *end = out + out_size - 1;
-
-    while (*p && o < end) {
-        if (strncmp(p, old_word, old_len) == 0) {
-            int left_ok = (p == input) || !is_ident_char(*(p - 1));
-            int right_ok = !is_ident_char(*(p + old_len));
-            if (left_ok && right_ok) {
-                if (o + new_len >= end) break;
-                memcpy(o, new_word, new_len);
-                o += new_len;
-                p += old_len;
-                continue;
-            }
-        }
-        *o++ = *p++;
-    }
-    *o = '\0';
-}
-
 /* qsort comparator for sorting by name */
 static int cmp_by_name_uniform(const void *a, const void *b) {
     return strcmp(((const glslt_uniform_t *)a)->name,
@@ -200,58 +153,118 @@ static int cmp_by_location_varying(const void *a, const void *b) {
 }
 
 /* ========================================================================== */
-/*  Line extraction                                                            */
+/*  Lexer                                                                      */
 /* ========================================================================== */
 
-/* Extract one line from source (up to \n or \0). Returns length copied. */
-static int extract_line(const char *src, char *line, int line_size) {
-    int i = 0;
-    while (src[i] && src[i] != '\n' && src[i] != '\r' && i < line_size - 1) {
-        line[i] = src[i];
-        i++;
+/*
+ * The source is scanned once as a token stream. Tokens point into the
+ * source; nothing is copied until it is written to the output. Whitespace,
+ * newlines and comments are tokens too, so body text that needs no rewrite
+ * is copied through unchanged.
+ */
+
+typedef enum {
+    TOK_EOF = 0,
+    TOK_IDENT,
+    TOK_NUMBER,
+    TOK_PUNCT,
+    TOK_SPACE,
+    TOK_NEWLINE,
+    TOK_COMMENT,      /* // to end of line, or a whole block comment */
+    TOK_DIRECTIVE     /* # line, including backslash-continued lines */
+} tok_kind_t;
+
+typedef struct {
+    tok_kind_t  kind;
+    const char *start;
+    int         len;
+} token_t;
+
+typedef struct {
+    const char *p;
+    int         at_line_start;  /* only whitespace since the last newline */
+} lexer_t;
+
+static int is_ident_start(char c) {
+    return isalpha((unsigned char)c) || c == '_';
+}
+
+static token_t lex_next(lexer_t *lx) {
+    token_t t;
+    const char *p = lx->p;
+    t.start = p;
+
+    if (*p == '\0') {
+        t.kind = TOK_EOF;
+    } else if (*p == '\n' || *p == '\r') {
+        if (p[0] == '\r' && p[1] == '\n') p++;
+        p++;
+        t.kind = TOK_NEWLINE;
+    } else if (*p == ' ' || *p == '\t' || *p == '\f' || *p == '\v') {
+        while (*p == ' ' || *p == '\t' || *p == '\f' || *p == '\v') p++;
+        t.kind = TOK_SPACE;
+    } else if (p[0] == '/' && p[1] == '/') {
+        while (*p && *p != '\n' && *p != '\r') p++;
+        t.kind = TOK_COMMENT;
+    } else if (p[0] == '/' && p[1] == '*') {
+        p += 2;
+        while (*p && !(p[0] == '*' && p[1] == '/')) p++;
+        if (*p) p += 2;
+        t.kind = TOK_COMMENT;
+    } else if (*p == '#' && lx->at_line_start) {
+        while (*p) {
+            if (*p == '\\' && (p[1] == '\n' || p[1] == '\r')) {
+                p++;
+                if (p[0] == '\r' && p[1] == '\n') p++;
+                p++;
+                continue;
+            }
+            if (*p == '\n' || *p == '\r') break;
+            p++;
+        }
+        t.kind = TOK_DIRECTIVE;
+    } else if (is_ident_start(*p)) {
+        while (is_ident_char(*p)) p++;
+        t.kind = TOK_IDENT;
+    } else if (isdigit((unsigned char)*p) || (p[0] == '.' && isdigit((unsigned char)p[1]))) {
+        while (is_ident_char(*p) || *p == '.' ||
+               ((*p == '+' || *p == '-') && (p[-1] == 'e' || p[-1] == 'E'))) p++;
+        t.kind = TOK_NUMBER;
+    } else {
+        p++;
+        t.kind = TOK_PUNCT;
     }
-    line[i] = '\0';
-    return i;
+
+    t.len = (int)(p - t.start);
+    lx->p = p;
+    if (t.kind == TOK_NEWLINE) lx->at_line_start = 1;
+    else if (t.kind != TOK_SPACE) lx->at_line_start = 0;
+    return t;
 }
 
-/* Advance pointer past the current line (past \n or \r\n) */
-static const char *next_line(const char *p) {
-    while (*p && *p != '\n' && *p != '\r') p++;
-    if (*p == '\r') p++;
-    if (*p == '\n') p++;
-    return p;
+/* Next token that is not whitespace, a newline or a comment */
+static token_t lex_significant(lexer_t *lx) {
+    token_t t;
+    do {
+        t = lex_next(lx);
+    } while (t.kind == TOK_SPACE || t.kind == TOK_NEWLINE || t.kind == TOK_COMMENT);
+    return t;
 }
 
-/* Strip single-line comment for parsing (does not modify original) */
-static void strip_comment(const char *line, char *out, int out_size) {
-    int i = 0;
-    (void)0;
-    while (line[i] && i < out_size - 1) {
-        if (line[i] == '/' && line[i + 1] == '/') break;
-        out[i] = line[i];
-        i++;
-    }
-    out[i] = '\0';
-    /* Trim trailing whitespace */
-    while (i > 0 && isspace((unsigned char)out[i - 1])) out[--i] = '\0';
+static int tok_is(const token_t *t, const char *word) {
+    int len = (int)strlen(word);
+    return t->len == len && strncmp(t->start, word, len) == 0;
+}
+
+static int tok_is_punct(const token_t *t, char c) {
+    return t->kind == TOK_PUNCT && t->start[0] == c;
 }
 
 /* ========================================================================== */
 /*  Declaration parsing                                                        */
 /* ========================================================================== */
 
-typedef enum {
-    DECL_NONE = 0,
-    DECL_VERSION,
-    DECL_PRECISION,
-    DECL_ATTRIBUTE,
-    DECL_VARYING,
-    DECL_UNIFORM,
-    DECL_EXTENSION
-} decl_kind_t;
-
 typedef struct {
-    decl_kind_t   kind;
     glslt_type_t  type;
     int           is_sampler;
     char          names[8][GLSLT_MAX_NAME]; /* supports multiple names: uniform float a, b; */
@@ -259,135 +272,67 @@ typedef struct {
     int           num_names;
 } parsed_decl_t;
 
-/* Skip optional precision qualifier (lowp, mediump, highp) */
-static const char *skip_precision(const char *p) {
-    p = skip_ws(p);
-    if (starts_with_word(p, "lowp"))    return skip_ws(p + 4);
-    if (starts_with_word(p, "mediump")) return skip_ws(p + 7);
-    if (starts_with_word(p, "highp"))   return skip_ws(p + 5);
-    return p;
+static const type_info_t *find_type_token(const token_t *t) {
+    if (t->kind != TOK_IDENT) return NULL;
+    for (const type_info_t *ti = s_types; ti->name; ti++) {
+        if (tok_is(t, ti->name)) return ti;
+    }
+    return NULL;
 }
 
-/* Parse: type name[, name2, ...]; from current position */
-static int parse_type_and_names(const char *p, parsed_decl_t *decl) {
-    p = skip_precision(p);
+/*
+ * Parse "[precision] type name[N], name2, ...;" following a storage
+ * qualifier. The declaration may span lines and contain comments. On
+ * success the lexer is left after the ';'.
+ */
+static int parse_declaration(lexer_t *lx, parsed_decl_t *decl) {
+    memset(decl, 0, sizeof(*decl));
 
-    /* Read type */
-    char type_str[64];
-    const char *after_type = read_word(p, type_str, sizeof(type_str));
-    if (after_type == p) return 0;
+    token_t t = lex_significant(lx);
+    if (tok_is(&t, "lowp") || tok_is(&t, "mediump") || tok_is(&t, "highp")) {
+        t = lex_significant(lx);
+    }
 
-    const type_info_t *ti = find_type_info(type_str);
+    const type_info_t *ti = find_type_token(&t);
     if (!ti) {
         /* Unknown token before type — may be an unexpanded precision macro. Skip and retry. */
-        p = skip_ws(after_type);
-        after_type = read_word(p, type_str, sizeof(type_str));
-        if (after_type == p) return 0;
-        ti = find_type_info(type_str);
+        if (t.kind != TOK_IDENT) return 0;
+        t = lex_significant(lx);
+        ti = find_type_token(&t);
         if (!ti) return 0;
     }
-
     decl->type = ti->type;
     decl->is_sampler = ti->is_sampler;
-    decl->num_names = 0;
-    p = skip_ws(after_type);
-
-    /* Read names (comma-separated) */
-    while (*p && *p != ';' && decl->num_names < 8) {
-        char name[GLSLT_MAX_NAME];
-        const char *after_name = read_word(p, name, sizeof(name));
-        if (after_name == p) break;
-
-        strncpy(decl->names[decl->num_names], name, GLSLT_MAX_NAME - 1);
-        decl->names[decl->num_names][GLSLT_MAX_NAME - 1] = '\0';
-        decl->array_sizes[decl->num_names] = 0;
 
-        p = skip_ws(after_name);
-
-        /* Check for array: [N] */
-        if (*p == '[') {
-            p++;
-            int arr_size = 0;
-            while (*p >= '0' && *p <= '9') {
-                arr_size = arr_size * 10 + (*p - '0');
-                p++;
-            }
-            if (*p == ']') p++;
-            decl->array_sizes[decl->num_names] = arr_size;
-            p = skip_ws(p);
+    /* Read names (comma-separated) up to the terminating ';' */
+    for (;;) {
+        t = lex_significant(lx);
+        if (t.kind != TOK_IDENT || t.len >= GLSLT_MAX_NAME || decl->num_names >= 8) return 0;
+        memcpy(decl->names[decl->num_names], t.start, t.len);
+        decl->names[decl->num_names][t.len] = '\0';
+
+        t = lex_significant(lx);
+        if (tok_is_punct(&t, '[')) {
+            t = lex_significant(lx);
+            if (t.kind != TOK_NUMBER) return 0;
+            decl->array_sizes[decl->num_names] = atoi(t.start);
+            t = lex_significant(lx);
+            if (!tok_is_punct(&t, ']')) return 0;
+            t = lex_significant(lx);
         }
-
         decl->num_names++;
-        if (*p == ',') { p++; p = skip_ws(p); }
-    }
-
-    return decl->num_names > 0;
-}
-
-/* Parse a single line. Returns the declaration kind or DECL_NONE. */
-static decl_kind_t parse_line(const char *raw_line, parsed_decl_t *decl) {
-    char line[MAX_LINE_LEN];
-    strip_comment(raw_line, line, sizeof(line));
-
-    memset(decl, 0, sizeof(*decl));
-    const char *p = skip_ws(line);
-
-    if (*p == '\0') return DECL_NONE;
-
-    /* #version */
-    if (strncmp(p, "#version", 8) == 0) {
-        decl->kind = DECL_VERSION;
-        return DECL_VERSION;
-    }
-
-    /* #extension */
-    if (strncmp(p, "#extension", 10) == 0) {
-        decl->kind = DECL_EXTENSION;
-        return DECL_EXTENSION;
-    }
-
-    /* Other preprocessor directives (#ifdef, #define, #else, #endif, etc.)
-     * Typically precision-related macros — strip them as precision is
-     * irrelevant in GLSL 460 core profile. */
-    if (*p == '#') {
-        decl->kind = DECL_PRECISION;
-        return DECL_PRECISION;
-    }
 
-    /* precision */
-    if (starts_with_word(p, "precision")) {
-        decl->kind = DECL_PRECISION;
-        return DECL_PRECISION;
-    }
-
-    /* attribute */
-    if (starts_with_word(p, "attribute")) {
-        p = skip_ws(p + 9);
-        if (parse_type_and_names(p, decl)) {
-            decl->kind = DECL_ATTRIBUTE;
-            return DECL_ATTRIBUTE;
-        }
-    }
-
-    /* varying */
-    if (starts_with_word(p, "varying")) {
-        p = skip_ws(p + 7);
-        if (parse_type_and_names(p, decl)) {
-            decl->kind = DECL_VARYING;
-            return DECL_VARYING;
-        }
-    }
-
-    /* uniform */
-    if (starts_with_word(p, "uniform")) {
-        p = skip_ws(p + 7);
-        if (parse_type_and_names(p, decl)) {
-            decl->kind = DECL_UNIFORM;
-            return DECL_UNIFORM;
-        }
+        if (tok_is_punct(&t, ';')) return 1;
+        if (!tok_is_punct(&t, ',')) return 0;
     }
+}
 
-    return DECL_NONE;
+/* Skip a statement up to and including its ';' (precision statements) */
+static void skip_statement(lexer_t *lx) {
+    token_t t;
+    do {
+        t = lex_significant(lx);
+    } while (t.kind != TOK_EOF && !tok_is_punct(&t, ';'));
 }
 
 /* ========================================================================== */
@@ -426,6 +371,55 @@ static void compute_std140_layout(glslt_uniform_t *uniforms, int count,
     *out_total_size = (offset + 15) & ~15;
 }
 
+/* Packing class: 0 = whole 16-byte slots (vec4, matrices, arrays), 1 = vec3,
+ * 2 = vec2, 3 = scalar */
+static int uniform_pack_class(const glslt_uniform_t *u) {
+    const type_info_t *ti = find_type_info_by_enum(u->type);
+    if (!ti || u->array_size > 0 || ti->std140_size % 16 == 0) return 0;
+    if (ti->std140_size == 12) return 1;
+    if (ti->std140_size == 8) return 2;
+    return 3;
+}
+
+/*
+ * Reorder uniforms so compute_std140_layout pads as little as possible:
+ * 16-byte types first, then each vec3 followed by a scalar in its last
+ * four bytes, then vec2s and the remaining scalars. Within a class the
+ * incoming (alphabetical) order is kept, so the layout is deterministic.
+ */
+static void pack_uniforms(glslt_uniform_t *uniforms, int count) {
+    glslt_uniform_t packed[GLSLT_MAX_UNIFORMS];
+    unsigned char taken[GLSLT_MAX_UNIFORMS] = { 0 };
+    int n = 0;
+    int scalar = 0;  /* Next scalar to pair with a vec3 */
+
+    for (int i = 0; i < count; i++) {
+        if (uniform_pack_class(&uniforms[i]) == 0) {
+            packed[n++] = uniforms[i];
+            taken[i] = 1;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        if (uniform_pack_class(&uniforms[i]) != 1) continue;
+        packed[n++] = uniforms[i];
+        taken[i] = 1;
+        while (scalar < count && (taken[scalar] || uniform_pack_class(&uniforms[scalar]) != 3)) scalar++;
+        if (scalar < count) {
+            packed[n++] = uniforms[scalar];
+            taken[scalar] = 1;
+        }
+    }
+    for (int cls = 2; cls <= 3; cls++) {
+        for (int i = 0; i < count; i++) {
+            if (!taken[i] && uniform_pack_class(&uniforms[i]) == cls) {
+                packed[n++] = uniforms[i];
+                taken[i] = 1;
+            }
+        }
+    }
+    memcpy(uniforms, packed, (size_t)n * sizeof(glslt_uniform_t));
+}
+
 /* ========================================================================== */
 /*  Location/binding assignment                                                */
 /* ========================================================================== */
@@ -501,36 +495,95 @@ static void assign_varying_locations(glslt_varying_t *varyings, int count,
 /*  Body text replacements                                                     */
 /* ========================================================================== */
 
-static void apply_body_replacements(const char *line, char *out, int out_size,
-                                    glslt_stage_t stage) {
-    /* Chain of word-boundary-aware replacements.
-     * Order doesn't matter because word boundary checks prevent partial matches
-     * (e.g. "texture2D" won't match inside "texture2DProj"). */
-    char b1[MAX_LINE_LEN], b2[MAX_LINE_LEN];
-
-    replace_word(line,  "texture2DProjLod", "textureProjLod", b1, sizeof(b1));
-    replace_word(b1,    "texture2DProj",    "textureProj",    b2, sizeof(b2));
-    replace_word(b2,    "texture2DLod",     "textureLod",     b1, sizeof(b1));
-    replace_word(b1,    "textureCubeLod",   "textureLod",     b2, sizeof(b2));
-    replace_word(b2,    "texture2D",        "texture",        b1, sizeof(b1));
-    replace_word(b1,    "textureCube",      "texture",        b2, sizeof(b2));
-
-    if (stage == GLSLT_FRAGMENT) {
-        replace_word(b2, "gl_FragColor", "fragColor", b1, sizeof(b1));
-        /* gl_FragData[0] -> fragColor (simple text replacement) */
-        replace_word(b1, "gl_FragData[0]", "fragColor", out, out_size);
-    } else {
-        strncpy(out, b2, out_size);
-        out[out_size - 1] = '\0';
+typedef struct {
+    const char *from;
+    const char *to;
+} rename_t;
+
+/* Whole-token renames, so "texture2D" never matches inside "texture2DProj" */
+static const rename_t s_body_renames[] = {
+    { "texture2DProjLod", "textureProjLod" },
+    { "texture2DProj",    "textureProj" },
+    { "texture2DLod",     "textureLod" },
+    { "textureCubeLod",   "textureLod" },
+    { "texture2D",        "texture" },
+    { "textureCube",      "texture" },
+    { "gl_InstanceIDEXT", "gl_InstanceID" },     /* GL_EXT_draw_instanced */
+    { NULL, NULL }
+};
+
+static const char *find_body_rename(const token_t *t) {
+    for (const rename_t *r = s_body_renames; r->from; r++) {
+        if (tok_is(t, r->from)) return r->to;
     }
+    return NULL;
+}
+
+/*
+ * Match "[N]" (whitespace allowed) after gl_FragData with a literal N below
+ * GLSLT_MAX_DRAW_BUFFERS, advancing past it. Returns N, or -1.
+ */
+static int match_frag_data_index(lexer_t *lx) {
+    lexer_t peek = *lx;
+    token_t t = lex_significant(&peek);
+    if (!tok_is_punct(&t, '[')) return -1;
+    t = lex_significant(&peek);
+    if (t.kind != TOK_NUMBER || t.len != 1 || t.start[0] < '0' ||
+        t.start[0] >= '0' + GLSLT_MAX_DRAW_BUFFERS) {
+        return -1;
+    }
+    int index = t.start[0] - '0';
+    t = lex_significant(&peek);
+    if (!tok_is_punct(&t, ']')) return -1;
+    *lx = peek;
+    return index;
+}
+
+/*
+ * A declaration or directive was removed from the body. If it was alone on
+ * its line, drop the indentation before it and the rest of the line after
+ * it too, so the body does not fill up with blank lines.
+ */
+static void drop_line_remainder(strbuf_t *body, lexer_t *lx) {
+    int i = body->len;
+    while (i > 0 && (body->buf[i - 1] == ' ' || body->buf[i - 1] == '\t')) i--;
+    if (i > 0 && body->buf[i - 1] != '\n') return;
+
+    /* A trailing // comment belongs to the removed declaration */
+    lexer_t peek = *lx;
+    token_t t = lex_next(&peek);
+    if (t.kind == TOK_SPACE) t = lex_next(&peek);
+    if (t.kind == TOK_COMMENT && t.start[1] == '/') t = lex_next(&peek);
+    if (t.kind != TOK_NEWLINE && t.kind != TOK_EOF) return;
+
+    body->len = i;
+    body->buf[i] = '\0';
+    *lx = peek;
 }
 
 /* Check if an #extension line is for something core in GLSL 4.60 */
-static int is_core_extension(const char *line) {
+static int is_core_extension(const char *line, int len) {
     /* All ES 1.00 extensions are core in 4.60 */
-    if (strstr(line, "GL_OES_"))  return 1;
-    if (strstr(line, "GL_EXT_"))  return 1;
-    if (strstr(line, "GL_NV_"))   return 1;
+    static const char *const prefixes[] = { "GL_OES_", "GL_EXT_", "GL_NV_", NULL };
+    for (const char *const *pre = prefixes; *pre; pre++) {
+        int plen = (int)strlen(*pre);
+        for (int i = 0; i + plen <= len; i++) {
+            if (strncmp(line + i, *pre, plen) == 0) return 1;
+        }
+    }
+    return 0;
+}
+
+/* Keep only #extension directives for extensions that are not core in 4.60 */
+static int keep_directive(const token_t *t) {
+    const char *p = t->start + 1;
+    while (*p == ' ' || *p == '\t') p++;
+    if (strncmp(p, "extension", 9) == 0 && !is_ident_char(p[9])) {
+        return !is_core_extension(t->start, t->len);
+    }
+    /* #version, and other directives (#ifdef, #define, #else, #endif, etc.)
+     * Typically precision-related macros — strip them as precision is
+     * irrelevant in GLSL 460 core profile. */
     return 0;
 }
 
@@ -538,6 +591,71 @@ static int is_core_extension(const char *line) {
 /*  Main transpile function                                                    */
 /* ========================================================================== */
 
+typedef struct {
+    glslt_uniform_t   uniforms[GLSLT_MAX_UNIFORMS];
+    glslt_sampler_t   samplers[GLSLT_MAX_SAMPLERS];
+    glslt_attribute_t attributes[GLSLT_MAX_ATTRIBUTES];
+    glslt_varying_t   varyings[GLSLT_MAX_VARYINGS];
+    unsigned char     uniform_used[GLSLT_MAX_UNIFORMS];  /* Referenced in the body */
+    int nu, ns, na, nv;
+} decl_set_t;
+
+static void record_declaration(decl_set_t *d, const token_t *qualifier, const parsed_decl_t *decl) {
+    for (int i = 0; i < decl->num_names; i++) {
+        if (tok_is(qualifier, "attribute")) {
+            if (d->na >= GLSLT_MAX_ATTRIBUTES) continue;
+            glslt_attribute_t *a = &d->attributes[d->na++];
+            memcpy(a->name, decl->names[i], GLSLT_MAX_NAME);
+            a->type = decl->type;
+            a->location = -1;
+        } else if (tok_is(qualifier, "varying")) {
+            if (d->nv >= GLSLT_MAX_VARYINGS) continue;
+            glslt_varying_t *v = &d->varyings[d->nv++];
+            memcpy(v->name, decl->names[i], GLSLT_MAX_NAME);
+            v->type = decl->type;
+            v->location = -1;
+        } else if (decl->is_sampler) {
+            if (d->ns >= GLSLT_MAX_SAMPLERS) continue;
+            glslt_sampler_t *smp = &d->samplers[d->ns++];
+            memcpy(smp->name, decl->names[i], GLSLT_MAX_NAME);
+            smp->type = decl->type;
+            smp->binding = -1;
+        } else {
+            if (d->nu >= GLSLT_MAX_UNIFORMS) continue;
+            glslt_uniform_t *u = &d->uniforms[d->nu++];
+            memcpy(u->name, decl->names[i], GLSLT_MAX_NAME);
+            u->type = decl->type;
+            u->array_size = decl->array_sizes[i];
+            u->binding = -1;
+            u->offset = 0;
+            u->size = 0;
+        }
+    }
+}
+
+/* An identifier in the body: mark the uniform it names as referenced */
+static void mark_uniform_use(decl_set_t *d, const token_t *t) {
+    for (int i = 0; i < d->nu; i++) {
+        if (tok_is(t, d->uniforms[i].name)) {
+            d->uniform_used[i] = 1;
+            return;
+        }
+    }
+}
+
+/* Move unreferenced uniforms behind the referenced ones; returns how many
+ * are referenced */
+static int partition_used_uniforms(decl_set_t *d) {
+    glslt_uniform_t unused[GLSLT_MAX_UNIFORMS];
+    int n = 0, nu_unused = 0;
+    for (int i = 0; i < d->nu; i++) {
+        if (d->uniform_used[i]) d->uniforms[n++] = d->uniforms[i];
+        else unused[nu_unused++] = d->uniforms[i];
+    }
+    memcpy(d->uniforms + n, unused, (size_t)nu_unused * sizeof(glslt_uniform_t));
+    return n;
+}
+
 glslt_result_t glslt_transpile(const char *source, glslt_stage_t stage,
                                const glslt_options_t *opts) {
     glslt_result_t result;
@@ -570,263 +688,224 @@ glslt_result_t glslt_transpile(const char *source, glslt_stage_t stage,
         }
     }
 
-    /* ---- Pass 1: Collect declarations ---- */
+    /* ---- Single scan: collect declarations, rewrite the body ---- */
 
-    glslt_uniform_t  uniforms[GLSLT_MAX_UNIFORMS];
-    glslt_sampler_t  samplers[GLSLT_MAX_SAMPLERS];
-    glslt_attribute_t attributes[GLSLT_MAX_ATTRIBUTES];
-    glslt_varying_t  varyings[GLSLT_MAX_VARYINGS];
-    int nu = 0, ns = 0, na = 0, nv = 0;
+    /* Every rewrite shrinks or keeps its token, so the body never outgrows the source */
+    int src_len = (int)strlen(source);
+    strbuf_t body;
+    sb_init_cap(&body, src_len + 2);
+    if (!body.buf) {
+        snprintf(result.error, sizeof(result.error), "out of memory");
+        return result;
+    }
+
+    decl_set_t d;
+    d.nu = d.ns = d.na = d.nv = 0;
+    memset(d.uniform_used, 0, sizeof(d.uniform_used));
     int has_frag_color = 0;
-    int in_block_comment = 0;
-
-    const char *lp = source;
-    while (*lp) {
-        char line[MAX_LINE_LEN];
-        extract_line(lp, line, sizeof(line));
-
-        /* Track block comments */
-        {
-            const char *p = line;
-            while (*p) {
-                if (in_block_comment) {
-                    if (p[0] == '*' && p[1] == '/') {
-                        in_block_comment = 0;
-                        p += 2;
-                        continue;
-                    }
-                } else {
-                    if (p[0] == '/' && p[1] == '*') {
-                        in_block_comment = 1;
-                        p += 2;
-                        continue;
-                    }
+    unsigned frag_data_mask = 0;  /* gl_FragData[N], N >= 1 */
+    int depth = 0;  /* brace nesting; storage qualifiers only count at global scope */
+
+    lexer_t lx = { source, 1 };
+    for (;;) {
+        token_t t = lex_next(&lx);
+        if (t.kind == TOK_EOF) break;
+
+        switch (t.kind) {
+        case TOK_NEWLINE:
+            sb_append_n(&body, "\n", 1);  /* normalizes \r\n */
+            continue;
+
+        case TOK_DIRECTIVE:
+            if (keep_directive(&t)) {
+                sb_append_n(&body, t.start, t.len);
+            } else {
+                drop_line_remainder(&body, &lx);
+            }
+            continue;
+
+        case TOK_PUNCT:
+            if (t.start[0] == '{') depth++;
+            else if (t.start[0] == '}' && depth > 0) depth--;
+            break;
+
+        case TOK_IDENT:
+            if (depth == 0 && (tok_is(&t, "attribute") || tok_is(&t, "varying") ||
+                               tok_is(&t, "uniform"))) {
+                parsed_decl_t decl;
+                lexer_t after = lx;
+                if (parse_declaration(&after, &decl)) {
+                    record_declaration(&d, &t, &decl);
+                    lx = after;
+                    drop_line_remainder(&body, &lx);
+                    continue;
                 }
-                p++;
+                break;  /* Not something we rewrite (e.g. a struct uniform): keep as-is */
             }
-        }
-
-        if (!in_block_comment) {
-            parsed_decl_t decl;
-            decl_kind_t kind = parse_line(line, &decl);
-
-            switch (kind) {
-            case DECL_ATTRIBUTE:
-                for (int i = 0; i < decl.num_names && na < GLSLT_MAX_ATTRIBUTES; i++) {
-                    strncpy(attributes[na].name, decl.names[i], GLSLT_MAX_NAME - 1);
-                    attributes[na].type = decl.type;
-                    attributes[na].location = -1;
-                    na++;
+            if (tok_is(&t, "precision")) {
+                skip_statement(&lx);
+                drop_line_remainder(&body, &lx);
+                continue;
+            }
+            {
+                const char *to = find_body_rename(&t);
+                if (to) {
+                    sb_append(&body, to);
+                    continue;
                 }
-                break;
-
-            case DECL_VARYING:
-                for (int i = 0; i < decl.num_names && nv < GLSLT_MAX_VARYINGS; i++) {
-                    strncpy(varyings[nv].name, decl.names[i], GLSLT_MAX_NAME - 1);
-                    varyings[nv].type = decl.type;
-                    varyings[nv].location = -1;
-                    nv++;
+            }
+            if (stage == GLSLT_FRAGMENT) {
+                if (tok_is(&t, "gl_FragColor")) {
+                    has_frag_color = 1;
+                    sb_append(&body, "fragColor");
+                    continue;
                 }
-                break;
-
-            case DECL_UNIFORM:
-                for (int i = 0; i < decl.num_names; i++) {
-                    if (decl.is_sampler) {
-                        if (ns < GLSLT_MAX_SAMPLERS) {
-                            strncpy(samplers[ns].name, decl.names[i], GLSLT_MAX_NAME - 1);
-                            samplers[ns].type = decl.type;
-                            samplers[ns].binding = -1;
-                            ns++;
-                        }
-                    } else {
-                        if (nu < GLSLT_MAX_UNIFORMS) {
-                            strncpy(uniforms[nu].name, decl.names[i], GLSLT_MAX_NAME - 1);
-                            uniforms[nu].type = decl.type;
-                            uniforms[nu].array_size = decl.array_sizes[i];
-                            uniforms[nu].binding = -1;
-                            uniforms[nu].offset = 0;
-                            uniforms[nu].size = 0;
-                            nu++;
-                        }
+                if (tok_is(&t, "gl_FragData")) {
+                    /* gl_FragData[0] -> fragColor, gl_FragData[N] -> fragData_N */
+                    int index = match_frag_data_index(&lx);
+                    if (index == 0) {
+                        has_frag_color = 1;
+                        sb_append(&body, "fragColor");
+                        continue;
                     }
+                    if (index > 0) {
+                        frag_data_mask |= 1u << index;
+                        sb_printf(&body, "fragData_%d", index);
+                        continue;
+                    }
+                    has_frag_color = 1;
                 }
-                break;
-
-            default:
-                break;
             }
+            break;
 
-            /* Check for gl_FragColor / gl_FragData usage anywhere */
-            if (stage == GLSLT_FRAGMENT) {
-                if (strstr(line, "gl_FragColor") || strstr(line, "gl_FragData"))
-                    has_frag_color = 1;
-            }
+        default:
+            break;
         }
 
-        lp = next_line(lp);
+        if (t.kind == TOK_IDENT && opts->optimize_uniforms) mark_uniform_use(&d, &t);
+        sb_append_n(&body, t.start, t.len);
+    }
+
+    /* Body lines always end in a newline */
+    if (body.len > 0 && body.buf[body.len - 1] != '\n') {
+        sb_append_n(&body, "\n", 1);
     }
 
     /* ---- Process: assign locations, compute layout ---- */
 
     /* Attributes */
-    assign_attrib_locations(attributes, na, opts);
-    qsort(attributes, na, sizeof(glslt_attribute_t), cmp_by_location_attr);
+    assign_attrib_locations(d.attributes, d.na, opts);
+    qsort(d.attributes, d.na, sizeof(glslt_attribute_t), cmp_by_location_attr);
 
     /* Varyings */
-    assign_varying_locations(varyings, nv, opts);
-    qsort(varyings, nv, sizeof(glslt_varying_t), cmp_by_location_varying);
-
-    /* Uniforms: sort alphabetically, compute std140 layout */
-    qsort(uniforms, nu, sizeof(glslt_uniform_t), cmp_by_name_uniform);
+    assign_varying_locations(d.varyings, d.nv, opts);
+    qsort(d.varyings, d.nv, sizeof(glslt_varying_t), cmp_by_location_varying);
+
+    /* Uniforms: sort alphabetically, optionally drop the unreferenced ones
+     * and pack the rest, compute std140 layout */
+    int nu_block = opts->optimize_uniforms ? partition_used_uniforms(&d) : d.nu;
+    qsort(d.uniforms, nu_block, sizeof(glslt_uniform_t), cmp_by_name_uniform);
+    qsort(d.uniforms + nu_block, d.nu - nu_block, sizeof(glslt_uniform_t), cmp_by_name_uniform);
+    if (opts->optimize_uniforms) pack_uniforms(d.uniforms, nu_block);
     int ubo_total_size = 0;
-    compute_std140_layout(uniforms, nu, &ubo_total_size);
-    for (int i = 0; i < nu; i++)
-        uniforms[i].binding = opts->ubo_binding;
+    compute_std140_layout(d.uniforms, nu_block, &ubo_total_size);
+    for (int i = nu_block; i < d.nu; i++) {
+        d.uniforms[i].offset = -1;
+        d.uniforms[i].size = 0;
+    }
+    for (int i = 0; i < d.nu; i++)
+        d.uniforms[i].binding = opts->ubo_binding;
 
     /* Samplers: keep declaration order, assign bindings */
-    for (int i = 0; i < ns; i++)
-        samplers[i].binding = opts->sampler_binding_start + i;
+    for (int i = 0; i < d.ns; i++)
+        d.samplers[i].binding = opts->sampler_binding_start + i;
 
-    /* ---- Pass 2: Emit output ---- */
+    /* ---- Emit header, then the body in one copy ---- */
 
     strbuf_t sb;
-    sb_init(&sb);
+    sb_init_cap(&sb, 1024 + body.len);
+    if (!sb.buf) {
+        free(body.buf);
+        snprintf(result.error, sizeof(result.error), "out of memory");
+        return result;
+    }
 
     /* Version */
     sb_printf(&sb, "#version %d\n", opts->target_version);
 
     /* Attributes (vertex shader only) */
-    if (stage == GLSLT_VERTEX && na > 0) {
+    if (stage == GLSLT_VERTEX && d.na > 0) {
         sb_append(&sb, "\n");
-        for (int i = 0; i < na; i++) {
+        for (int i = 0; i < d.na; i++) {
             sb_printf(&sb, "layout(location = %d) in %s %s;\n",
-                      attributes[i].location,
-                      glslt_type_name(attributes[i].type),
-                      attributes[i].name);
+                      d.attributes[i].location,
+                      glslt_type_name(d.attributes[i].type),
+                      d.attributes[i].name);
         }
     }
 
     /* Varyings */
-    if (nv > 0) {
+    if (d.nv > 0) {
         sb_append(&sb, "\n");
         const char *dir = (stage == GLSLT_VERTEX) ? "out" : "in";
-        for (int i = 0; i < nv; i++) {
+        for (int i = 0; i < d.nv; i++) {
             sb_printf(&sb, "layout(location = %d) %s %s %s;\n",
-                      varyings[i].location, dir,
-                      glslt_type_name(varyings[i].type),
-                      varyings[i].name);
+                      d.varyings[i].location, dir,
+                      glslt_type_name(d.varyings[i].type),
+                      d.varyings[i].name);
         }
     }
 
     /* UBO block */
-    if (nu > 0) {
+    if (nu_block > 0) {
         sb_append(&sb, "\n");
         sb_printf(&sb, "layout(std140, binding = %d) uniform %sUniforms {\n",
                   opts->ubo_binding,
                   (stage == GLSLT_VERTEX) ? "Vertex" : "Fragment");
-        for (int i = 0; i < nu; i++) {
-            if (uniforms[i].array_size > 0) {
+        for (int i = 0; i < nu_block; i++) {
+            if (d.uniforms[i].array_size > 0) {
                 sb_printf(&sb, "    %s %s[%d];\n",
-                          glslt_type_name(uniforms[i].type),
-                          uniforms[i].name,
-                          uniforms[i].array_size);
+                          glslt_type_name(d.uniforms[i].type),
+                          d.uniforms[i].name,
+                          d.uniforms[i].array_size);
             } else {
                 sb_printf(&sb, "    %s %s;\n",
-                          glslt_type_name(uniforms[i].type),
-                          uniforms[i].name);
+                          glslt_type_name(d.uniforms[i].type),
+                          d.uniforms[i].name);
             }
         }
         sb_append(&sb, "};\n");
     }
 
     /* Samplers */
-    if (ns > 0) {
+    if (d.ns > 0) {
         sb_append(&sb, "\n");
-        for (int i = 0; i < ns; i++) {
+        for (int i = 0; i < d.ns; i++) {
             sb_printf(&sb, "layout(binding = %d) uniform %s %s;\n",
-                      samplers[i].binding,
-                      glslt_type_name(samplers[i].type),
-                      samplers[i].name);
+                      d.samplers[i].binding,
+                      glslt_type_name(d.samplers[i].type),
+                      d.samplers[i].name);
         }
     }
 
-    /* Fragment output */
-    if (stage == GLSLT_FRAGMENT && has_frag_color) {
-        sb_append(&sb, "\nlayout(location = 0) out vec4 fragColor;\n");
-    }
-
-    /* ---- Body: emit non-declaration lines with replacements ---- */
-
-    in_block_comment = 0;
-    int body_started = 0;
-    lp = source;
-    while (*lp) {
-        char line[MAX_LINE_LEN];
-        extract_line(lp, line, sizeof(line));
-
-        /* Track block comment state (must mirror pass 1) */
-        int line_in_comment = in_block_comment;
-        {
-            const char *p = line;
-            while (*p) {
-                if (in_block_comment) {
-                    if (p[0] == '*' && p[1] == '/') {
-                        in_block_comment = 0;
-                        p += 2;
-                        continue;
-                    }
-                } else {
-                    if (p[0] == '/' && p[1] == '*') {
-                        in_block_comment = 1;
-                        p += 2;
-                        continue;
-                    }
-                }
-                p++;
-            }
+    /* Fragment outputs, one location per draw buffer */
+    if (stage == GLSLT_FRAGMENT && (has_frag_color || frag_data_mask)) {
+        sb_append(&sb, "\n");
+        if (has_frag_color) {
+            sb_append(&sb, "layout(location = 0) out vec4 fragColor;\n");
         }
-
-        int emit = 1;
-
-        if (!line_in_comment) {
-            parsed_decl_t decl;
-            decl_kind_t kind = parse_line(line, &decl);
-
-            switch (kind) {
-            case DECL_VERSION:
-            case DECL_PRECISION:
-            case DECL_ATTRIBUTE:
-            case DECL_VARYING:
-            case DECL_UNIFORM:
-                emit = 0;
-                break;
-            case DECL_EXTENSION:
-                emit = !is_core_extension(line);
-                break;
-            default:
-                break;
+        for (int i = 1; i < GLSLT_MAX_DRAW_BUFFERS; i++) {
+            if (frag_data_mask & (1u << i)) {
+                sb_printf(&sb, "layout(location = %d) out vec4 fragData_%d;\n", i, i);
             }
         }
+    }
 
-        if (emit) {
-            if (!body_started) {
-                sb_append(&sb, "\n");
-                body_started = 1;
-            }
-
-            if (line_in_comment || line[0] == '\0') {
-                /* Inside block comment or empty line: emit as-is */
-                sb_append(&sb, line);
-            } else {
-                char replaced[MAX_LINE_LEN];
-                apply_body_replacements(line, replaced, sizeof(replaced), stage);
-                sb_append(&sb, replaced);
-            }
-            sb_append(&sb, "\n");
-        }
-
-        lp = next_line(lp);
+    if (body.len > 0) {
+        sb_append(&sb, "\n");
+        sb_append_n(&sb, body.buf, body.len);
     }
+    free(body.buf);
 
     /* ---- Fill result ---- */
 
@@ -835,19 +914,19 @@ glslt_result_t glslt_transpile(const char *source, glslt_stage_t stage,
     result.success = 1;
 
     /* Copy reflection data */
-    memcpy(result.uniforms, uniforms, nu * sizeof(glslt_uniform_t));
-    result.num_uniforms = nu;
+    memcpy(result.uniforms, d.uniforms, d.nu * sizeof(glslt_uniform_t));
+    result.num_uniforms = d.nu;
     result.ubo_binding = opts->ubo_binding;
     result.ubo_total_size = ubo_total_size;
 
-    memcpy(result.samplers, samplers, ns * sizeof(glslt_sampler_t));
-    result.num_samplers = ns;
+    memcpy(result.samplers, d.samplers, d.ns * sizeof(glslt_sampler_t));
+    result.num_samplers = d.ns;
 
-    memcpy(result.attributes, attributes, na * sizeof(glslt_attribute_t));
-    result.num_attributes = na;
+    memcpy(result.attributes, d.attributes, d.na * sizeof(glslt_attribute_t));
+    result.num_attributes = d.na;
 
-    memcpy(result.varyings, varyings, nv * sizeof(glslt_varying_t));
-    result.num_varyings = nv;
+    memcpy(result.varyings, d.varyings, d.nv * sizeof(glslt_varying_t));
+    result.num_varyings = d.nv;
 
     return result;
 }
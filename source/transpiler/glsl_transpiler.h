@@ -26,6 +26,11 @@
  *   textureCubeLod(...)       -> textureLod(...)
  *   #extension GL_OES_...     -> (removed, core in 4.60)
  *
+ * With optimize_uniforms set, uniforms the shader never references are left
+ * out of the block, and the rest are ordered to minimize std140 padding
+ * (16-byte types first, then each vec3 followed by a scalar, then vec2s and
+ * the remaining scalars) instead of alphabetically.
+ *
  * Reflection output:
  *   - Attributes: name, type, assigned location
  *   - Varyings:   name, type, assigned location
@@ -70,12 +75,16 @@ extern "C" {
 /*  Constants                                                                  */
 /* -------------------------------------------------------------------------- */
 
+/* Bump whenever the emitted GLSL changes (invalidates shader disk caches) */
+#define GLSLT_VERSION           4
+
 #define GLSLT_MAX_NAME          64
 #define GLSLT_MAX_UNIFORMS      64
 #define GLSLT_MAX_SAMPLERS      16
 #define GLSLT_MAX_ATTRIBUTES    16
 #define GLSLT_MAX_VARYINGS      32
 #define GLSLT_MAX_BINDINGS      32
+#define GLSLT_MAX_DRAW_BUFFERS  4   /* gl_FragData[0..3] (GL_EXT_draw_buffers) */
 
 /* -------------------------------------------------------------------------- */
 /*  Types                                                                      */
@@ -113,8 +122,9 @@ typedef struct {
     glslt_type_t  type;
     int           array_size;   /* 0 = scalar, >0 = array[N] */
     int           binding;      /* UBO binding number */
-    int           offset;       /* byte offset within UBO (std140) */
-    int           size;         /* byte size in UBO (std140) */
+    int           offset;       /* byte offset within UBO (std140), -1 if unreferenced
+                                   and left out by optimize_uniforms */
+    int           size;         /* byte size in UBO (std140), 0 if left out */
 } glslt_uniform_t;
 
 /* Reflected sampler */
@@ -146,6 +156,8 @@ typedef struct {
     int target_version;         /* GLSL version to emit (default: 460) */
     int ubo_binding;            /* binding number for the UBO (default: 0) */
     int sampler_binding_start;  /* first binding number for samplers (default: 0) */
+    int optimize_uniforms;      /* drop unreferenced uniforms, pack the rest for
+                                   minimal padding (default: 0) */
 
     /* Explicit attribute location bindings (from glBindAttribLocation) */
     struct { char name[GLSLT_MAX_NAME]; int location; } attrib_locations[GLSLT_MAX_BINDINGS];
@@ -165,7 +177,8 @@ typedef struct {
     char         *output;
     int           output_len;
 
-    /* Reflection: non-sampler uniforms (packed into one UBO) */
+    /* Reflection: non-sampler uniforms (packed into one UBO), in block order;
+     * uniforms left out by optimize_uniforms follow with offset -1 */
     glslt_uniform_t  uniforms[GLSLT_MAX_UNIFORMS];
     int               num_uniforms;
     int               ubo_binding;      /* which binding the UBO was assigned */
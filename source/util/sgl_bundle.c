@@ -0,0 +1,167 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * Shader Bundles
+ */
+
+#include "sgl_bundle.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SGL_BUNDLE_MAX_ENTRIES  4096
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+} sgl_bundle_header_t;
+
+typedef struct {
+    char     name[SGL_BUNDLE_NAME_MAX];
+    uint32_t format;
+    uint32_t size;
+} sgl_bundle_entry_header_t;
+
+struct sgl_bundle {
+    uint8_t *data;              /* The whole file */
+    uint32_t count;
+    const sgl_bundle_entry_header_t **entries;
+};
+
+struct sgl_bundle_writer {
+    FILE *fp;
+    uint32_t count;
+    bool failed;
+};
+
+/* Read a whole file; one read instead of one per entry is what makes loading cheap */
+static uint8_t *sgl_bundle_read_file(const char *path, size_t *out_size) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return NULL;
+
+    uint8_t *data = NULL;
+    long size = -1;
+    if (fseek(fp, 0, SEEK_END) == 0) size = ftell(fp);
+    if (size > 0 && fseek(fp, 0, SEEK_SET) == 0) {
+        data = (uint8_t *)malloc((size_t)size);
+        if (data && fread(data, (size_t)size, 1, fp) != 1) {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(fp);
+    *out_size = (size_t)size;
+    return data;
+}
+
+sgl_bundle_t *sgl_bundle_open(const char *path) {
+    if (!path || !path[0]) return NULL;
+
+    size_t size = 0;
+    uint8_t *data = sgl_bundle_read_file(path, &size);
+    if (!data) return NULL;
+
+    const sgl_bundle_header_t *hdr = (const sgl_bundle_header_t *)data;
+    if (size < sizeof(*hdr) || hdr->magic != SGL_BUNDLE_MAGIC ||
+        hdr->version != SGL_BUNDLE_VERSION || hdr->count > SGL_BUNDLE_MAX_ENTRIES) {
+        free(data);
+        return NULL;
+    }
+
+    sgl_bundle_t *bundle = (sgl_bundle_t *)calloc(1, sizeof(*bundle));
+    if (bundle) bundle->entries = (const sgl_bundle_entry_header_t **)calloc(hdr->count + 1,
+                                                                            sizeof(*bundle->entries));
+    if (!bundle || !bundle->entries) {
+        free(bundle);
+        free(data);
+        return NULL;
+    }
+    bundle->data = data;
+
+    /* Check every entry up front so sgl_bundle_entry() cannot read past the end */
+    size_t pos = sizeof(*hdr);
+    for (uint32_t i = 0; i < hdr->count; i++) {
+        const sgl_bundle_entry_header_t *e = (const sgl_bundle_entry_header_t *)(data + pos);
+        if (size - pos < sizeof(*e) || e->size > size - pos - sizeof(*e) ||
+            memchr(e->name, '\0', SGL_BUNDLE_NAME_MAX) == NULL) {
+            sgl_bundle_close(bundle);
+            return NULL;
+        }
+        bundle->entries[i] = e;
+        pos += sizeof(*e) + ((e->size + 3) & ~(size_t)3);
+        if (pos > size) pos = size;
+    }
+    bundle->count = hdr->count;
+    return bundle;
+}
+
+uint32_t sgl_bundle_count(const sgl_bundle_t *bundle) {
+    return bundle->count;
+}
+
+void sgl_bundle_entry(const sgl_bundle_t *bundle, uint32_t index, sgl_bundle_entry_t *entry) {
+    const sgl_bundle_entry_header_t *e = bundle->entries[index];
+    entry->name = e->name;
+    entry->format = e->format;
+    entry->size = e->size;
+    entry->binary = e + 1;
+}
+
+void sgl_bundle_close(sgl_bundle_t *bundle) {
+    if (!bundle) return;
+    free(bundle->entries);
+    free(bundle->data);
+    free(bundle);
+}
+
+sgl_bundle_writer_t *sgl_bundle_create(const char *path) {
+    if (!path || !path[0]) return NULL;
+
+    sgl_bundle_writer_t *writer = (sgl_bundle_writer_t *)calloc(1, sizeof(*writer));
+    if (!writer) return NULL;
+    writer->fp = fopen(path, "wb");
+    if (!writer->fp) {
+        free(writer);
+        return NULL;
+    }
+
+    /* The count is filled in by sgl_bundle_finish */
+    const sgl_bundle_header_t hdr = { SGL_BUNDLE_MAGIC, SGL_BUNDLE_VERSION, 0, 0 };
+    writer->failed = fwrite(&hdr, sizeof(hdr), 1, writer->fp) != 1;
+    return writer;
+}
+
+bool sgl_bundle_add(sgl_bundle_writer_t *writer, const char *name, uint32_t format,
+                    const void *binary, uint32_t size) {
+    if (writer->failed) return false;
+    if (!name || strlen(name) >= SGL_BUNDLE_NAME_MAX || writer->count == SGL_BUNDLE_MAX_ENTRIES)
+        return false;
+
+    sgl_bundle_entry_header_t e;
+    memset(&e, 0, sizeof(e));
+    strcpy(e.name, name);
+    e.format = format;
+    e.size = size;
+
+    static const uint8_t pad[4] = { 0 };
+    uint32_t pad_bytes = (4 - (size & 3)) & 3;
+    bool ok = fwrite(&e, sizeof(e), 1, writer->fp) == 1 &&
+              (size == 0 || fwrite(binary, size, 1, writer->fp) == 1) &&
+              (pad_bytes == 0 || fwrite(pad, pad_bytes, 1, writer->fp) == 1);
+    if (!ok) {
+        writer->failed = true;
+        return false;
+    }
+    writer->count++;
+    return true;
+}
+
+bool sgl_bundle_finish(sgl_bundle_writer_t *writer) {
+    bool ok = !writer->failed &&
+              fseek(writer->fp, offsetof(sgl_bundle_header_t, count), SEEK_SET) == 0 &&
+              fwrite(&writer->count, sizeof(writer->count), 1, writer->fp) == 1;
+    ok = fclose(writer->fp) == 0 && ok;
+    free(writer);
+    return ok;
+}
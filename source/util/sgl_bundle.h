@@ -0,0 +1,60 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * Shader Bundles
+ *
+ * File format written by the host bundle builder (tools/shader_bundle.c)
+ * and loaded by sglLoadShaderBundle(). A bundle is a header followed by
+ * named program binaries, each in the format of glGetProgramBinaryOES
+ * (GL_SGL_PROGRAM_BINARY_FORMAT_NX): both DKSH stages plus the uniform and
+ * attribute layout, so loading one needs neither the transpiler nor libuam.
+ *
+ * Layout (little endian, 4-byte aligned):
+ *   header       magic, version, entry count
+ *   per entry    name (SGL_BUNDLE_NAME_MAX bytes, NUL padded), binary
+ *                format, binary size, binary padded to a multiple of 4
+ */
+
+#ifndef SGL_BUNDLE_H
+#define SGL_BUNDLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SGL_BUNDLE_MAGIC     0x42474C53u  /* "SGLB" */
+#define SGL_BUNDLE_VERSION   1
+#define SGL_BUNDLE_NAME_MAX  64
+
+typedef struct sgl_bundle_entry {
+    const char *name;
+    uint32_t format;            /* GL_SGL_PROGRAM_BINARY_FORMAT_NX */
+    uint32_t size;
+    const void *binary;         /* Valid until sgl_bundle_close() */
+} sgl_bundle_entry_t;
+
+typedef struct sgl_bundle sgl_bundle_t;
+typedef struct sgl_bundle_writer sgl_bundle_writer_t;
+
+/* Read a whole bundle into memory (NULL if missing, not a bundle or damaged) */
+sgl_bundle_t *sgl_bundle_open(const char *path);
+
+/* Entry count of an open bundle */
+uint32_t sgl_bundle_count(const sgl_bundle_t *bundle);
+
+/* Entry at index (< sgl_bundle_count) */
+void sgl_bundle_entry(const sgl_bundle_t *bundle, uint32_t index, sgl_bundle_entry_t *entry);
+
+/* Release the bundle and every entry's memory; NULL is ignored */
+void sgl_bundle_close(sgl_bundle_t *bundle);
+
+/* Create a bundle file for writing (NULL if it cannot be created) */
+sgl_bundle_writer_t *sgl_bundle_create(const char *path);
+
+/* Append a binary. Names longer than SGL_BUNDLE_NAME_MAX - 1 are rejected. */
+bool sgl_bundle_add(sgl_bundle_writer_t *writer, const char *name, uint32_t format,
+                    const void *binary, uint32_t size);
+
+/* Write the entry count and close; false if any write failed */
+bool sgl_bundle_finish(sgl_bundle_writer_t *writer);
+
+#endif /* SGL_BUNDLE_H */
@@ -0,0 +1,96 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * Index Processing Kernels Implementation
+ *
+ * The NEON paths keep running min/max vectors next to the load/store and
+ * reduce them across lanes once at the end; the tail is handled scalar.
+ */
+
+#include "sgl_index.h"
+
+#if defined(__aarch64__) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#include <arm_neon.h>
+#define SGL_INDEX_NEON 1
+#endif
+
+void sgl_index_widen_u8(uint16_t *dst, const uint8_t *src, uint32_t count,
+                        uint32_t *out_min, uint32_t *out_max) {
+    uint32_t i = 0;
+    uint32_t lo = 0xFF, hi = 0;
+#ifdef SGL_INDEX_NEON
+    if (count >= 16) {
+        uint8x16_t vmin = vdupq_n_u8(0xFF), vmax = vdupq_n_u8(0);
+        for (; i + 16 <= count; i += 16) {
+            uint8x16_t v = vld1q_u8(src + i);
+            vmin = vminq_u8(vmin, v);
+            vmax = vmaxq_u8(vmax, v);
+            vst1q_u16(dst + i, vmovl_u8(vget_low_u8(v)));
+            vst1q_u16(dst + i + 8, vmovl_high_u8(v));
+        }
+        lo = vminvq_u8(vmin);
+        hi = vmaxvq_u8(vmax);
+    }
+#endif
+    for (; i < count; i++) {
+        uint32_t v = src[i];
+        dst[i] = (uint16_t)v;
+        if (v < lo) lo = v;
+        if (v > hi) hi = v;
+    }
+    *out_min = lo;
+    *out_max = hi;
+}
+
+void sgl_index_copy_u16(uint16_t *dst, const uint16_t *src, uint32_t count,
+                        uint32_t *out_min, uint32_t *out_max) {
+    uint32_t i = 0;
+    uint32_t lo = 0xFFFF, hi = 0;
+#ifdef SGL_INDEX_NEON
+    if (count >= 8) {
+        uint16x8_t vmin = vdupq_n_u16(0xFFFF), vmax = vdupq_n_u16(0);
+        for (; i + 8 <= count; i += 8) {
+            uint16x8_t v = vld1q_u16(src + i);
+            vmin = vminq_u16(vmin, v);
+            vmax = vmaxq_u16(vmax, v);
+            vst1q_u16(dst + i, v);
+        }
+        lo = vminvq_u16(vmin);
+        hi = vmaxvq_u16(vmax);
+    }
+#endif
+    for (; i < count; i++) {
+        uint32_t v = src[i];
+        dst[i] = (uint16_t)v;
+        if (v < lo) lo = v;
+        if (v > hi) hi = v;
+    }
+    *out_min = lo;
+    *out_max = hi;
+}
+
+void sgl_index_copy_u32(uint32_t *dst, const uint32_t *src, uint32_t count,
+                        uint32_t *out_min, uint32_t *out_max) {
+    uint32_t i = 0;
+    uint32_t lo = 0xFFFFFFFFu, hi = 0;
+#ifdef SGL_INDEX_NEON
+    if (count >= 4) {
+        uint32x4_t vmin = vdupq_n_u32(0xFFFFFFFFu), vmax = vdupq_n_u32(0);
+        for (; i + 4 <= count; i += 4) {
+            uint32x4_t v = vld1q_u32(src + i);
+            vmin = vminq_u32(vmin, v);
+            vmax = vmaxq_u32(vmax, v);
+            vst1q_u32(dst + i, v);
+        }
+        lo = vminvq_u32(vmin);
+        hi = vmaxvq_u32(vmax);
+    }
+#endif
+    for (; i < count; i++) {
+        uint32_t v = src[i];
+        dst[i] = v;
+        if (v < lo) lo = v;
+        if (v > hi) hi = v;
+    }
+    *out_min = lo;
+    *out_max = hi;
+}
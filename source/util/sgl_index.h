@@ -0,0 +1,28 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * Index Processing Kernels
+ *
+ * Single-pass copy of client-side element indices into GPU memory that also
+ * reports the referenced [min, max] vertex range. GL_UNSIGNED_BYTE indices
+ * are widened to 16 bits on the way (Maxwell has no 8-bit index format).
+ * Uses NEON on AArch64 and a scalar loop elsewhere.
+ */
+
+#ifndef SGL_INDEX_H
+#define SGL_INDEX_H
+
+#include <stdint.h>
+
+/* Widen u8 indices to u16 while tracking min/max (count > 0) */
+void sgl_index_widen_u8(uint16_t *dst, const uint8_t *src, uint32_t count,
+                        uint32_t *out_min, uint32_t *out_max);
+
+/* Copy u16 indices while tracking min/max (count > 0) */
+void sgl_index_copy_u16(uint16_t *dst, const uint16_t *src, uint32_t count,
+                        uint32_t *out_min, uint32_t *out_max);
+
+/* Copy u32 indices while tracking min/max (count > 0) */
+void sgl_index_copy_u32(uint32_t *dst, const uint32_t *src, uint32_t count,
+                        uint32_t *out_min, uint32_t *out_max);
+
+#endif /* SGL_INDEX_H */
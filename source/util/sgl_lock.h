@@ -0,0 +1,42 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * Share Group Locks
+ *
+ * Recursive lock for state the contexts of a share group reach from
+ * different threads: object names and the backend's allocators. It is never
+ * taken by draws or state changes. A libnx RMutex on the Switch, a recursive
+ * pthread mutex elsewhere (host builds).
+ */
+
+#ifndef SGL_LOCK_H
+#define SGL_LOCK_H
+
+#ifdef __SWITCH__
+#include <switch.h>
+
+typedef RMutex sgl_lock_t;
+
+static inline void sgl_lock_init(sgl_lock_t *lock) { rmutexInit(lock); }
+static inline void sgl_lock_destroy(sgl_lock_t *lock) { (void)lock; }
+static inline void sgl_lock(sgl_lock_t *lock) { rmutexLock(lock); }
+static inline void sgl_unlock(sgl_lock_t *lock) { rmutexUnlock(lock); }
+
+#else
+#include <pthread.h>
+
+typedef pthread_mutex_t sgl_lock_t;
+
+static inline void sgl_lock_init(sgl_lock_t *lock) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+static inline void sgl_lock_destroy(sgl_lock_t *lock) { pthread_mutex_destroy(lock); }
+static inline void sgl_lock(sgl_lock_t *lock) { pthread_mutex_lock(lock); }
+static inline void sgl_unlock(sgl_lock_t *lock) { pthread_mutex_unlock(lock); }
+
+#endif
+
+#endif /* SGL_LOCK_H */
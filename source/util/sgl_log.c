@@ -1,16 +1,40 @@
 /*
  * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
  * Logging Implementation
+ *
+ * Producers claim a ring entry with one CAS (bounded MPSC queue: each entry
+ * carries a sequence number telling whether it is free or filled), store the
+ * format pointer and the arguments it consumes, and publish it. No lock, no
+ * formatting and no I/O happen on the calling thread. When the ring is full
+ * the message is counted as dropped instead of waiting for the writer.
+ *
+ * Messages whose arguments do not fit an entry are formatted into it on the
+ * spot and marked preformatted.
  */
 
 #include "sgl_log.h"
 #include <stdio.h>
 #include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifdef __SWITCH__
+#include <switch.h>
+#endif
+
+#define SGL_LOG_RING_SIZE       1024            /* Power of two */
+#define SGL_LOG_MAX_ARGS        8
+#define SGL_LOG_STR_BYTES       96              /* %s copies, or a preformatted message */
+#define SGL_LOG_LINE_SIZE       512
+
+#define SGL_LOG_WRITER_STACK    (32 * 1024)
+#define SGL_LOG_WRITER_PRIORITY 0x3F            /* Lowest application priority */
+#define SGL_LOG_WRITER_CORE     2               /* Off the GL thread's core 0 */
+#define SGL_LOG_WRITER_SLEEP_NS 2000000ULL      /* Poll the ring every 2 ms */
 
 /* Log state */
-static sgl_log_level_t g_log_level = SGL_LOG_INFO;
-static uint32_t g_log_categories = SGL_LOG_CAT_ALL;
-static int g_log_initialized = 0;
+sgl_log_level_t sgl_log_min_level = SGL_LOG_INFO;
+uint32_t sgl_log_enabled_categories = SGL_LOG_CAT_ALL;
 
 /* Level names */
 static const char *level_names[] = {
@@ -21,40 +45,411 @@ static const char *level_names[] = {
     "ERROR"
 };
 
+typedef struct {
+    uint32_t seq;                   /* == pos: free, == pos + 1: filled */
+    uint8_t level;
+    uint8_t nargs;
+    uint16_t str_used;
+    const char *fmt;                /* NULL = message preformatted in strings */
+    uint64_t args[SGL_LOG_MAX_ARGS];
+    char strings[SGL_LOG_STR_BYTES];
+} sgl_log_entry_t;
+
+static sgl_log_entry_t s_ring[SGL_LOG_RING_SIZE];
+static uint32_t s_enqueue_pos = 0;
+static uint32_t s_dequeue_pos = 0;
+static uint32_t s_dropped = 0;
+static uint32_t s_dropped_reported = 0;
+static bool s_ring_ready = false;
+static bool s_async = false;        /* Writer thread is draining the ring */
+
+static FILE *s_output = NULL;       /* NULL = stdout */
+
+static FILE *sgl_log_out(void) {
+    return s_output ? s_output : stdout;
+}
+
+/* ============================================================================
+ * Format Parsing
+ * ============================================================================ */
+
+typedef enum {
+    SGL_LOG_ARG_NONE,       /* %% */
+    SGL_LOG_ARG_INT,
+    SGL_LOG_ARG_UINT,
+    SGL_LOG_ARG_DOUBLE,
+    SGL_LOG_ARG_PTR,
+    SGL_LOG_ARG_STR,
+    SGL_LOG_ARG_INVALID,    /* %n or unknown: format synchronously */
+} sgl_log_arg_t;
+
+typedef struct {
+    const char *end;        /* First character after the spec */
+    int star_args;          /* '*' width/precision ints before the value */
+    char length[3];         /* hh, h, l, ll, j, z, t, L */
+    char conv;
+    sgl_log_arg_t type;
+} sgl_log_spec_t;
+
+/* Parse the conversion spec starting after a '%' */
+static void sgl_log_parse_spec(const char *p, sgl_log_spec_t *spec) {
+    memset(spec, 0, sizeof(*spec));
+    while (*p && strchr("-+ #0", *p)) p++;
+    if (*p == '*') { spec->star_args++; p++; }
+    while (*p >= '0' && *p <= '9') p++;
+    if (*p == '.') {
+        p++;
+        if (*p == '*') { spec->star_args++; p++; }
+        while (*p >= '0' && *p <= '9') p++;
+    }
+    int n = 0;
+    while (*p && strchr("hljztL", *p) && n < 2) spec->length[n++] = *p++;
+
+    spec->conv = *p;
+    spec->end = *p ? p + 1 : p;
+    switch (*p) {
+        case '%': spec->type = SGL_LOG_ARG_NONE; break;
+        case 'd': case 'i': spec->type = SGL_LOG_ARG_INT; break;
+        case 'c': spec->type = SGL_LOG_ARG_INT; break;
+        case 'u': case 'x': case 'X': case 'o': spec->type = SGL_LOG_ARG_UINT; break;
+        case 'f': case 'F': case 'e': case 'E':
+        case 'g': case 'G': case 'a': case 'A': spec->type = SGL_LOG_ARG_DOUBLE; break;
+        case 'p': spec->type = SGL_LOG_ARG_PTR; break;
+        case 's': spec->type = SGL_LOG_ARG_STR; break;
+        default: spec->type = SGL_LOG_ARG_INVALID; break;
+    }
+}
+
+/* Read an integer argument as its promoted type, widened to 64 bits */
+static uint64_t sgl_log_read_int(va_list *ap, const sgl_log_spec_t *spec) {
+    bool is_signed = spec->type == SGL_LOG_ARG_INT;
+    const char *len = spec->length;
+    if (!strcmp(len, "ll")) {
+        return is_signed ? (uint64_t)va_arg(*ap, long long) : (uint64_t)va_arg(*ap, unsigned long long);
+    }
+    if (!strcmp(len, "l")) {
+        return is_signed ? (uint64_t)va_arg(*ap, long) : (uint64_t)va_arg(*ap, unsigned long);
+    }
+    if (!strcmp(len, "j")) return (uint64_t)va_arg(*ap, intmax_t);
+    if (!strcmp(len, "z")) return (uint64_t)va_arg(*ap, size_t);
+    if (!strcmp(len, "t")) return (uint64_t)va_arg(*ap, ptrdiff_t);
+
+    int v = va_arg(*ap, int);
+    if (!strcmp(len, "hh")) return is_signed ? (uint64_t)(signed char)v : (uint64_t)(unsigned char)v;
+    if (!strcmp(len, "h")) return is_signed ? (uint64_t)(short)v : (uint64_t)(unsigned short)v;
+    return is_signed ? (uint64_t)(int64_t)v : (uint64_t)(unsigned int)v;
+}
+
+/* Copy the arguments fmt consumes into the entry; false = they do not fit */
+static bool sgl_log_capture(sgl_log_entry_t *e, const char *fmt, va_list *ap) {
+    e->nargs = 0;
+    e->str_used = 0;
+    for (const char *p = fmt; *p; ) {
+        if (*p++ != '%') continue;
+        sgl_log_spec_t spec;
+        sgl_log_parse_spec(p, &spec);
+        p = spec.end;
+        if (spec.type == SGL_LOG_ARG_NONE) continue;
+        if (spec.type == SGL_LOG_ARG_INVALID) return false;
+        if (e->nargs + spec.star_args + 1 > SGL_LOG_MAX_ARGS) return false;
+
+        for (int i = 0; i < spec.star_args; i++) {
+            e->args[e->nargs++] = (uint64_t)(int64_t)va_arg(*ap, int);
+        }
+
+        uint64_t value;
+        switch (spec.type) {
+            case SGL_LOG_ARG_DOUBLE: {
+                double d = spec.length[0] == 'L' ? (double)va_arg(*ap, long double) : va_arg(*ap, double);
+                memcpy(&value, &d, sizeof(d));
+                break;
+            }
+            case SGL_LOG_ARG_PTR:
+                value = (uint64_t)(uintptr_t)va_arg(*ap, void *);
+                break;
+            case SGL_LOG_ARG_STR: {
+                const char *s = va_arg(*ap, const char *);
+                if (!s) s = "(null)";
+                size_t room = SGL_LOG_STR_BYTES - e->str_used;
+                if (room == 0) return false;
+                size_t len = strnlen(s, room - 1);
+                memcpy(e->strings + e->str_used, s, len);
+                e->strings[e->str_used + len] = '\0';
+                value = e->str_used;
+                e->str_used += (uint16_t)(len + 1);
+                break;
+            }
+            default:
+                value = sgl_log_read_int(ap, &spec);
+                break;
+        }
+        e->args[e->nargs++] = value;
+    }
+    return true;
+}
+
+/* Replay an entry's format with its captured arguments */
+static int sgl_log_render(const sgl_log_entry_t *e, char *out, size_t size) {
+    int pos = snprintf(out, size, "[SGL][%s] ", level_names[e->level]);
+    if (!e->fmt) {
+        return pos + snprintf(out + pos, size - pos, "%s", e->strings);
+    }
+
+    int arg = 0;
+    for (const char *p = e->fmt; *p && (size_t)pos < size - 1; ) {
+        if (*p != '%') {
+            out[pos++] = *p++;
+            continue;
+        }
+        const char *start = p++;
+        sgl_log_spec_t spec;
+        sgl_log_parse_spec(p, &spec);
+        p = spec.end;
+        if (spec.type == SGL_LOG_ARG_NONE) {
+            out[pos++] = '%';
+            continue;
+        }
+
+        /* Rebuild the spec without its length modifier, then add ours */
+        char spec_fmt[32];
+        size_t body = (size_t)(spec.end - start) - strlen(spec.length) - 1;
+        if (body >= sizeof(spec_fmt) - 4) body = sizeof(spec_fmt) - 4;
+        memcpy(spec_fmt, start, body);
+        size_t n = body;
+        if (spec.type == SGL_LOG_ARG_INT || spec.type == SGL_LOG_ARG_UINT) {
+            if (spec.conv != 'c') { spec_fmt[n++] = 'l'; spec_fmt[n++] = 'l'; }
+        }
+        spec_fmt[n++] = spec.conv;
+        spec_fmt[n] = '\0';
+
+        int stars[2] = { 0, 0 };
+        for (int i = 0; i < spec.star_args; i++) stars[i] = (int)(int64_t)e->args[arg++];
+        uint64_t v = e->args[arg++];
+        size_t room = size - pos;
+        int w;
+
+        #define SGL_LOG_EMIT(val) \
+            (spec.star_args == 0 ? snprintf(out + pos, room, spec_fmt, val) : \
+             spec.star_args == 1 ? snprintf(out + pos, room, spec_fmt, stars[0], val) : \
+                                   snprintf(out + pos, room, spec_fmt, stars[0], stars[1], val))
+        switch (spec.type) {
+            case SGL_LOG_ARG_DOUBLE: { double d; memcpy(&d, &v, sizeof(d)); w = SGL_LOG_EMIT(d); break; }
+            case SGL_LOG_ARG_PTR: w = SGL_LOG_EMIT((void *)(uintptr_t)v); break;
+            case SGL_LOG_ARG_STR: w = SGL_LOG_EMIT(e->strings + v); break;
+            case SGL_LOG_ARG_INT:
+                w = spec.conv == 'c' ? SGL_LOG_EMIT((int)v) : SGL_LOG_EMIT((long long)v);
+                break;
+            default: w = SGL_LOG_EMIT((unsigned long long)v); break;
+        }
+        #undef SGL_LOG_EMIT
+
+        if (w < 0) break;
+        pos += w;
+        if ((size_t)pos >= size) pos = (int)size - 1;
+    }
+    out[pos] = '\0';
+    return pos;
+}
+
+/* ============================================================================
+ * Ring Buffer
+ * ============================================================================ */
+
+static void sgl_log_ring_init(void) {
+    if (s_ring_ready) return;
+    for (uint32_t i = 0; i < SGL_LOG_RING_SIZE; i++) s_ring[i].seq = i;
+    s_ring_ready = true;
+}
+
+static bool sgl_log_enqueue(sgl_log_level_t level, const char *fmt, va_list ap) {
+    uint32_t pos = __atomic_load_n(&s_enqueue_pos, __ATOMIC_RELAXED);
+    sgl_log_entry_t *e;
+    for (;;) {
+        e = &s_ring[pos & (SGL_LOG_RING_SIZE - 1)];
+        uint32_t seq = __atomic_load_n(&e->seq, __ATOMIC_ACQUIRE);
+        int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&s_enqueue_pos, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            __atomic_add_fetch(&s_dropped, 1, __ATOMIC_RELAXED);
+            return false;
+        } else {
+            pos = __atomic_load_n(&s_enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+
+    e->level = (uint8_t)level;
+    e->fmt = fmt;
+    va_list copy;
+    va_copy(copy, ap);
+    bool captured = sgl_log_capture(e, fmt, &copy);
+    va_end(copy);
+    if (!captured) {
+        e->fmt = NULL;
+        vsnprintf(e->strings, sizeof(e->strings), fmt, ap);
+    }
+
+    __atomic_store_n(&e->seq, pos + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/* Write out every filled entry; single consumer. Returns entries written */
+static int sgl_log_drain(void) {
+    char line[SGL_LOG_LINE_SIZE];
+    FILE *out = sgl_log_out();
+    int written = 0;
+
+    for (;;) {
+        uint32_t pos = s_dequeue_pos;
+        sgl_log_entry_t *e = &s_ring[pos & (SGL_LOG_RING_SIZE - 1)];
+        if (__atomic_load_n(&e->seq, __ATOMIC_ACQUIRE) != pos + 1) break;
+
+        sgl_log_render(e, line, sizeof(line));
+        fputs(line, out);
+        fputc('\n', out);
+        written++;
+
+        __atomic_store_n(&e->seq, pos + SGL_LOG_RING_SIZE, __ATOMIC_RELEASE);
+        __atomic_store_n(&s_dequeue_pos, pos + 1, __ATOMIC_RELEASE);
+    }
+
+    uint32_t dropped = __atomic_load_n(&s_dropped, __ATOMIC_RELAXED);
+    if (dropped != s_dropped_reported) {
+        fprintf(out, "[SGL][WARN] %u log messages dropped (ring full)\n", dropped - s_dropped_reported);
+        s_dropped_reported = dropped;
+        written++;
+    }
+
+    if (written) fflush(out);
+    return written;
+}
+
+/* ============================================================================
+ * Writer Thread
+ * ============================================================================ */
+
+#ifdef __SWITCH__
+
+static Thread s_writer;
+static Mutex s_output_lock;         /* Held while draining and swapping s_output */
+static bool s_stopping = false;
+
+static void sgl_log_writer_main(void *arg) {
+    (void)arg;
+    while (!__atomic_load_n(&s_stopping, __ATOMIC_ACQUIRE)) {
+        mutexLock(&s_output_lock);
+        sgl_log_drain();
+        mutexUnlock(&s_output_lock);
+        svcSleepThread(SGL_LOG_WRITER_SLEEP_NS);
+    }
+    mutexLock(&s_output_lock);
+    sgl_log_drain();
+    mutexUnlock(&s_output_lock);
+}
+
+#endif
+
 void sgl_log_init(void) {
-    g_log_level = SGL_LOG_INFO;
-    g_log_categories = SGL_LOG_CAT_ALL;
-    g_log_initialized = 1;
+    sgl_log_ring_init();
+#ifdef __SWITCH__
+    if (s_async) return;
+    mutexInit(&s_output_lock);
+    s_stopping = false;
+    /* Core 2, shared with the last worker thread, which the lowest
+     * priority lets go first. The default core (-2) is the main thread's. */
+    if (R_FAILED(threadCreate(&s_writer, sgl_log_writer_main, NULL, NULL,
+                              SGL_LOG_WRITER_STACK, SGL_LOG_WRITER_PRIORITY, SGL_LOG_WRITER_CORE))) {
+        return;
+    }
+    if (R_FAILED(threadStart(&s_writer))) {
+        threadClose(&s_writer);
+        return;
+    }
+    __atomic_store_n(&s_async, true, __ATOMIC_RELEASE);
+#endif
+}
+
+void sgl_log_shutdown(void) {
+#ifdef __SWITCH__
+    if (!s_async) return;
+    __atomic_store_n(&s_stopping, true, __ATOMIC_RELEASE);
+    threadWaitForExit(&s_writer);
+    threadClose(&s_writer);
+    __atomic_store_n(&s_async, false, __ATOMIC_RELEASE);
+#endif
+    /* Messages racing the shutdown land in the ring; catch them synchronously */
+    sgl_log_drain();
+}
+
+void sgl_log_flush(void) {
+#ifdef __SWITCH__
+    if (__atomic_load_n(&s_async, __ATOMIC_ACQUIRE)) {
+        uint32_t target = __atomic_load_n(&s_enqueue_pos, __ATOMIC_ACQUIRE);
+        while ((int32_t)(__atomic_load_n(&s_dequeue_pos, __ATOMIC_ACQUIRE) - target) < 0) {
+            svcSleepThread(SGL_LOG_WRITER_SLEEP_NS / 2);
+        }
+        return;
+    }
+#endif
+    fflush(sgl_log_out());
 }
 
 void sgl_log_set_level(sgl_log_level_t level) {
-    g_log_level = level;
+    sgl_log_min_level = level;
 }
 
 void sgl_log_set_categories(uint32_t categories) {
-    g_log_categories = categories;
+    sgl_log_enabled_categories = categories;
+}
+
+bool sgl_log_set_output(const char *path) {
+    FILE *f = NULL;
+    if (path && path[0]) {
+        f = fopen(path, "a");
+        if (!f) return false;
+    }
+
+    /* Everything queued so far belongs to the old output */
+    sgl_log_flush();
+#ifdef __SWITCH__
+    bool async = __atomic_load_n(&s_async, __ATOMIC_ACQUIRE);
+    if (async) mutexLock(&s_output_lock);
+#endif
+    FILE *old = s_output;
+    s_output = f;
+    if (old) fclose(old);
+#ifdef __SWITCH__
+    if (async) mutexUnlock(&s_output_lock);
+#endif
+    return true;
 }
 
 void sgl_log(sgl_log_level_t level, sgl_log_category_t category,
              const char *fmt, ...) {
     /* Check if this message should be logged */
-    if (level < g_log_level) {
+    if (!sgl_log_enabled(level, category)) {
         return;
     }
 
-    if (!(g_log_categories & category)) {
+    va_list args;
+    va_start(args, fmt);
+
+    if (__atomic_load_n(&s_async, __ATOMIC_ACQUIRE)) {
+        sgl_log_enqueue(level, fmt, args);
+        va_end(args);
+        /* An error may precede a crash: make sure it reaches the output */
+        if (level >= SGL_LOG_ERROR) sgl_log_flush();
         return;
     }
 
-    /* Print level prefix */
-    printf("[SGL][%s] ", level_names[level]);
-
-    /* Print message */
-    va_list args;
-    va_start(args, fmt);
-    vprintf(fmt, args);
+    /* No writer thread: print on the calling thread */
+    FILE *out = sgl_log_out();
+    fprintf(out, "[SGL][%s] ", level_names[level]);
+    vfprintf(out, fmt, args);
     va_end(args);
-
-    printf("\n");
-    fflush(stdout);
+    fputc('\n', out);
+    fflush(out);
 }
@@ -1,12 +1,22 @@
 /*
  * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
  * Logging System
+ *
+ * Once sgl_log_init has started the writer thread, sgl_log only copies the
+ * format pointer and its arguments into a lock-free ring; the thread
+ * formats and writes them. Before that (and on the host) messages are
+ * printed on the calling thread.
+ *
+ * Trace sites of categories missing from SGL_TRACE_CATEGORIES compile to
+ * nothing, e.g. to profile a debug build without draw path tracing:
+ *   -DSGL_TRACE_CATEGORIES="(SGL_LOG_CAT_ALL & ~(SGL_LOG_CAT_DRAW | SGL_LOG_CAT_UNIFORM))"
  */
 
 #ifndef SGL_LOG_H
 #define SGL_LOG_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 /* Log levels */
 typedef enum {
@@ -33,24 +43,54 @@ typedef enum {
     SGL_LOG_CAT_ALL     = 0xFFFFFFFF
 } sgl_log_category_t;
 
-/* Initialize logging system */
+/* Categories whose trace sites are compiled in (see top of file) */
+#ifndef SGL_TRACE_CATEGORIES
+#define SGL_TRACE_CATEGORIES SGL_LOG_CAT_ALL
+#endif
+
+/* Start the writer thread (idempotent) */
 void sgl_log_init(void);
 
+/* Write out everything queued, then stop the writer thread */
+void sgl_log_shutdown(void);
+
+/* Block until every message queued so far has been written */
+void sgl_log_flush(void);
+
 /* Set minimum log level */
 void sgl_log_set_level(sgl_log_level_t level);
 
 /* Set enabled categories (bitmask) */
 void sgl_log_set_categories(uint32_t categories);
 
-/* Core logging function */
+/* Write to a file (appended) instead of stdout; NULL = stdout (nxlink) */
+bool sgl_log_set_output(const char *path);
+
+/* Core logging function. fmt must be a string literal: it is formatted
+ * later. %s arguments are copied into the record's 96-byte payload, which
+ * all of them share: longer strings are truncated, and a record whose
+ * strings do not fit is formatted at once, cut to 95 characters. */
 void sgl_log(sgl_log_level_t level, sgl_log_category_t category,
              const char *fmt, ...) __attribute__((format(printf, 3, 4)));
 
+/* Runtime filter, read inline so filtered-out sites skip the call */
+extern sgl_log_level_t sgl_log_min_level;
+extern uint32_t sgl_log_enabled_categories;
+
+static inline bool sgl_log_enabled(sgl_log_level_t level, uint32_t category) {
+    return level >= sgl_log_min_level && (sgl_log_enabled_categories & category);
+}
+
 /* Convenience macros */
 #ifdef SGL_DEBUG
 
-#define SGL_TRACE(cat, fmt, ...) sgl_log(SGL_LOG_TRACE, cat, fmt, ##__VA_ARGS__)
-#define SGL_DEBUG_LOG(cat, fmt, ...) sgl_log(SGL_LOG_DEBUG, cat, fmt, ##__VA_ARGS__)
+#define SGL_TRACE(cat, fmt, ...) \
+    do { \
+        if (((SGL_TRACE_CATEGORIES) & (cat)) && sgl_log_enabled(SGL_LOG_TRACE, cat)) \
+            sgl_log(SGL_LOG_TRACE, cat, fmt, ##__VA_ARGS__); \
+    } while (0)
+#define SGL_DEBUG_LOG(cat, fmt, ...) \
+    do { if (sgl_log_enabled(SGL_LOG_DEBUG, cat)) sgl_log(SGL_LOG_DEBUG, cat, fmt, ##__VA_ARGS__); } while (0)
 #define SGL_INFO(cat, fmt, ...) sgl_log(SGL_LOG_INFO, cat, fmt, ##__VA_ARGS__)
 
 /* Category-specific trace macros */
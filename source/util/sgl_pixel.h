@@ -0,0 +1,55 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * Pixel Conversion Kernels
+ *
+ * CPU-side conversion of client pixel data into the layouts stored by the
+ * GPU (RGB is widened to RGBA8888, packed 16-bit formats are stored as is).
+ * The 16-bit widening kernels turn those textures back into RGBA8888 for
+ * glReadPixels. Uses NEON on AArch64 and a portable scalar path elsewhere;
+ * the scalar kernels are always built so they can be benchmarked against
+ * the vector ones.
+ */
+
+#ifndef SGL_PIXEL_H
+#define SGL_PIXEL_H
+
+#include <GLES2/gl2.h>
+#include <stdint.h>
+
+/* Bytes per pixel of client data for a (format, type) pair */
+uint32_t sgl_pixel_src_bpp(GLenum format, GLenum type);
+
+/* Bytes per pixel of the converted data written by sgl_pixel_unpack() */
+uint32_t sgl_pixel_dst_bpp(GLenum format, GLenum type);
+
+/* Client row stride honouring GL_UNPACK_ALIGNMENT (1, 2, 4 or 8) */
+uint32_t sgl_pixel_unpack_stride(uint32_t width, GLenum format, GLenum type, GLint alignment);
+
+/*
+ * Convert a width x height client image into dst, one row every dst_stride
+ * bytes. Source rows are unpack_alignment-aligned as described by GLES2 3.6.
+ */
+void sgl_pixel_unpack(uint8_t *dst, uint32_t dst_stride, const void *src,
+                      uint32_t width, uint32_t height,
+                      GLenum format, GLenum type, GLint unpack_alignment);
+
+/* Pack RGBA8888 pixels into a 16-bit type (GL_UNSIGNED_SHORT_5_6_5,
+ * GL_UNSIGNED_SHORT_4_4_4_4 or GL_UNSIGNED_SHORT_5_5_5_1) */
+void sgl_pixel_pack_rgba8(uint8_t *dst, const uint8_t *src, uint32_t count, GLenum type);
+
+/* Widen count pixels of a 16-bit type to RGBA8888 (memcpy for GL_UNSIGNED_BYTE) */
+void sgl_pixel_widen_rgba8(uint8_t *dst, const uint8_t *src, uint32_t count, GLenum type);
+
+/* Row kernels (count = pixels); dispatch to NEON when available */
+void sgl_pixel_rgb8_to_rgba8(uint8_t *dst, const uint8_t *src, uint32_t count);
+void sgl_pixel_rgb565_to_rgba8(uint8_t *dst, const uint8_t *src, uint32_t count);
+void sgl_pixel_rgba4444_to_rgba8(uint8_t *dst, const uint8_t *src, uint32_t count);
+void sgl_pixel_rgba5551_to_rgba8(uint8_t *dst, const uint8_t *src, uint32_t count);
+
+/* Scalar reference kernels */
+void sgl_pixel_rgb8_to_rgba8_scalar(uint8_t *dst, const uint8_t *src, uint32_t count);
+void sgl_pixel_rgb565_to_rgba8_scalar(uint8_t *dst, const uint8_t *src, uint32_t count);
+void sgl_pixel_rgba4444_to_rgba8_scalar(uint8_t *dst, const uint8_t *src, uint32_t count);
+void sgl_pixel_rgba5551_to_rgba8_scalar(uint8_t *dst, const uint8_t *src, uint32_t count);
+
+#endif /* SGL_PIXEL_H */
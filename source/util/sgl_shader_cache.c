@@ -0,0 +1,155 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * Shader Disk Cache Implementation
+ *
+ * File layout: sgl_cache_header_t followed by the payload. The header
+ * repeats the key and carries a payload hash, so a colliding file name or
+ * a partially written file is treated as a miss.
+ */
+
+#include "sgl_shader_cache.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define SGL_CACHE_MAGIC     0x434C4753u  /* "SGLC" */
+#define SGL_CACHE_FORMAT    1u
+
+typedef struct {
+    uint32_t magic;
+    uint32_t format;
+    uint64_t key;
+    uint64_t payload_hash;
+    uint32_t payload_size;
+    uint32_t reserved;
+} sgl_cache_header_t;
+
+static char s_cache_path[SGL_SHADER_CACHE_PATH_MAX] = SGL_SHADER_CACHE_DEFAULT_PATH;
+static bool s_cache_dir_ready = false;
+
+uint64_t sgl_hash64(uint64_t h, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+void sgl_shader_cache_set_path(const char *path) {
+    /* A truncated directory could be another application's cache */
+    if (!path || strlen(path) >= SGL_SHADER_CACHE_PATH_MAX) path = "";
+    strcpy(s_cache_path, path);
+
+    /* Drop a trailing separator so entry paths do not get "//" */
+    size_t len = strlen(s_cache_path);
+    if (len > 0 && s_cache_path[len - 1] == '/') {
+        s_cache_path[len - 1] = '\0';
+    }
+    s_cache_dir_ready = false;
+}
+
+bool sgl_shader_cache_enabled(void) {
+    return s_cache_path[0] != '\0';
+}
+
+/* False if the name does not fit: a truncated one could alias another entry */
+static bool sgl_cache_entry_path(char *out, size_t out_size, uint64_t key, const char *suffix) {
+    int len = snprintf(out, out_size, "%s/%016llx.%s", s_cache_path, (unsigned long long)key, suffix);
+    return len >= 0 && (size_t)len < out_size;
+}
+
+/* mkdir -p: create each missing component of the cache path */
+static bool sgl_cache_make_dir(void) {
+    if (s_cache_dir_ready) return true;
+
+    char dir[SGL_SHADER_CACHE_PATH_MAX];
+    strcpy(dir, s_cache_path);
+
+    /* Skip the device prefix ("sdmc:/") */
+    char *p = strchr(dir, ':');
+    p = p ? p + 1 : dir;
+    if (*p == '/') p++;
+
+    for (;; p++) {
+        if (*p != '/' && *p != '\0') continue;
+        char saved = *p;
+        *p = '\0';
+        if (mkdir(dir, 0777) != 0 && errno != EEXIST) {
+            return false;
+        }
+        *p = saved;
+        if (saved == '\0') break;
+    }
+
+    s_cache_dir_ready = true;
+    return true;
+}
+
+void *sgl_shader_cache_load(uint64_t key, size_t *size) {
+    if (!sgl_shader_cache_enabled()) return NULL;
+
+    char path[SGL_SHADER_CACHE_PATH_MAX + 32];
+    if (!sgl_cache_entry_path(path, sizeof(path), key, "bin")) return NULL;
+
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+
+    sgl_cache_header_t header;
+    void *payload = NULL;
+    if (fread(&header, sizeof(header), 1, f) == 1 &&
+        header.magic == SGL_CACHE_MAGIC && header.format == SGL_CACHE_FORMAT &&
+        header.key == key && header.payload_size > 0) {
+        payload = malloc(header.payload_size);
+        if (payload && (fread(payload, 1, header.payload_size, f) != header.payload_size ||
+                        sgl_hash64(SGL_HASH64_INIT, payload, header.payload_size) != header.payload_hash)) {
+            free(payload);
+            payload = NULL;
+        }
+    }
+    fclose(f);
+
+    if (payload) *size = header.payload_size;
+    return payload;
+}
+
+bool sgl_shader_cache_store(uint64_t key, const void *data, size_t size) {
+    if (!sgl_shader_cache_enabled() || !data || size == 0 || size > UINT32_MAX) return false;
+    if (!sgl_cache_make_dir()) return false;
+
+    char path[SGL_SHADER_CACHE_PATH_MAX + 32];
+    char tmp[SGL_SHADER_CACHE_PATH_MAX + 32];
+    /* Stores may run on compile workers; give each its own temporary file */
+    static uint32_t s_tmp_serial = 0;
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), "tmp%u", (unsigned)__atomic_fetch_add(&s_tmp_serial, 1, __ATOMIC_RELAXED));
+    if (!sgl_cache_entry_path(path, sizeof(path), key, "bin") ||
+        !sgl_cache_entry_path(tmp, sizeof(tmp), key, suffix)) {
+        return false;
+    }
+
+    FILE *f = fopen(tmp, "wb");
+    if (!f) return false;
+
+    sgl_cache_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = SGL_CACHE_MAGIC;
+    header.format = SGL_CACHE_FORMAT;
+    header.key = key;
+    header.payload_hash = sgl_hash64(SGL_HASH64_INIT, data, size);
+    header.payload_size = (uint32_t)size;
+
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+              fwrite(data, 1, size, f) == size;
+    ok = (fclose(f) == 0) && ok;
+
+    /* rename() does not replace an existing file on every devoptab */
+    if (ok) {
+        remove(path);
+        ok = rename(tmp, path) == 0;
+    }
+    if (!ok) remove(tmp);
+    return ok;
+}
@@ -0,0 +1,55 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * Shader Disk Cache
+ *
+ * Content-addressed store for runtime-compiled shaders. Each entry is one
+ * file named after its 64-bit key and holds an opaque payload; the caller
+ * decides what goes in it (DKSH code plus reflection for glLinkProgram).
+ * Entries are written to a temporary file and renamed into place, so an
+ * interrupted write never leaves a truncated entry behind.
+ */
+
+#ifndef SGL_SHADER_CACHE_H
+#define SGL_SHADER_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __SWITCH__
+#define SGL_SHADER_CACHE_DEFAULT_PATH   "sdmc:/switch/.sgl_shader_cache"
+#else
+#define SGL_SHADER_CACHE_DEFAULT_PATH   ""  /* Host builds: disabled until sglSetShaderCachePath */
+#endif
+#define SGL_SHADER_CACHE_PATH_MAX       256
+
+/*
+ * Shader compiler revision folded into every key. Bump it when libuam is
+ * updated so stale DKSH is not reused.
+ */
+#ifndef SGL_SHADER_CACHE_COMPILER_VERSION
+#define SGL_SHADER_CACHE_COMPILER_VERSION 1
+#endif
+
+#define SGL_HASH64_INIT 0xcbf29ce484222325ull
+
+/* FNV-1a over data, continuing from h (start with SGL_HASH64_INIT) */
+uint64_t sgl_hash64(uint64_t h, const void *data, size_t len);
+
+/* Set the cache directory (created on first store). NULL, "" or a path of
+ * SGL_SHADER_CACHE_PATH_MAX characters or more disables. */
+void sgl_shader_cache_set_path(const char *path);
+
+/* True when a cache directory is configured */
+bool sgl_shader_cache_enabled(void);
+
+/*
+ * Load the payload stored under key. Returns a malloc'd buffer (caller frees)
+ * and its size, or NULL on a miss or a corrupt entry.
+ */
+void *sgl_shader_cache_load(uint64_t key, size_t *size);
+
+/* Store a payload under key, replacing any previous entry */
+bool sgl_shader_cache_store(uint64_t key, const void *data, size_t size);
+
+#endif /* SGL_SHADER_CACHE_H */
@@ -0,0 +1,74 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * Handle Tables Implementation
+ */
+
+#include "sgl_table.h"
+#include <stdlib.h>
+#include <string.h>
+
+void sgl_table_init(sgl_table_t *t, size_t item_size) {
+    memset(t, 0, sizeof(*t));
+    t->item_size = (uint32_t)item_size;
+    t->next_handle = 1;
+}
+
+void sgl_table_destroy(sgl_table_t *t) {
+    for (uint32_t i = 0; i < t->num_chunks; i++) {
+        free(t->chunks[i]);
+    }
+    free(t->chunks);
+    for (uint32_t i = 0; i < t->num_retired; i++) {
+        free(t->retired[i]);
+    }
+    free(t->free_list);
+    sgl_table_init(t, t->item_size);
+}
+
+void *sgl_table_ensure(sgl_table_t *t, uint32_t handle) {
+    uint32_t chunk = handle >> SGL_TABLE_CHUNK_SHIFT;
+
+    if (chunk >= t->num_chunks) {
+        /* Double the chunk directory; the chunks themselves stay put. The old
+         * directory is not freed: a concurrent lookup may still be reading it. */
+        uint32_t count = t->num_chunks ? t->num_chunks : 4;
+        while (count <= chunk) count *= 2;
+        if (t->chunks && t->num_retired == sizeof(t->retired) / sizeof(t->retired[0])) return NULL;
+        uint8_t **chunks = (uint8_t **)calloc(count, sizeof(uint8_t *));
+        if (!chunks) return NULL;
+        if (t->num_chunks) memcpy(chunks, t->chunks, t->num_chunks * sizeof(uint8_t *));
+        if (t->chunks) t->retired[t->num_retired++] = t->chunks;
+        __atomic_store_n(&t->chunks, chunks, __ATOMIC_RELEASE);
+        __atomic_store_n(&t->num_chunks, count, __ATOMIC_RELEASE);
+    }
+
+    uint8_t *base = t->chunks[chunk];
+    if (!base) {
+        base = (uint8_t *)calloc(SGL_TABLE_CHUNK, t->item_size);
+        if (!base) return NULL;
+        __atomic_store_n(&t->chunks[chunk], base, __ATOMIC_RELEASE);
+    }
+    return base + (size_t)(handle & (SGL_TABLE_CHUNK - 1)) * t->item_size;
+}
+
+uint32_t sgl_table_alloc(sgl_table_t *t) {
+    if (t->free_count > 0) {
+        return t->free_list[--t->free_count];
+    }
+    uint32_t handle = t->next_handle;
+    if (handle == 0 || !sgl_table_ensure(t, handle)) return 0;
+    t->next_handle++;
+    return handle;
+}
+
+void sgl_table_release(sgl_table_t *t, uint32_t handle) {
+    if (handle == 0 || handle >= t->next_handle) return;
+    if (t->free_count == t->free_capacity) {
+        uint32_t capacity = t->free_capacity ? t->free_capacity * 2 : SGL_TABLE_CHUNK;
+        uint32_t *list = (uint32_t *)realloc(t->free_list, capacity * sizeof(uint32_t));
+        if (!list) return;  /* The handle is leaked, not reused */
+        t->free_list = list;
+        t->free_capacity = capacity;
+    }
+    t->free_list[t->free_count++] = handle;
+}
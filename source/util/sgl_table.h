@@ -0,0 +1,70 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * Handle Tables
+ *
+ * Handle -> record tables that grow in chunks of SGL_TABLE_CHUNK records.
+ * Chunks never move once allocated, so record pointers stay valid while the
+ * table grows, and a lookup is a shift, a mask and two loads. Released
+ * handles go on a free list, so allocation is O(1). Handle 0 is reserved.
+ *
+ * The GL layer allocates names with sgl_table_alloc; the backend indexes its
+ * own records by those names with sgl_table_ensure and sgl_table_get.
+ *
+ * Lookups may run on other threads while the owning thread grows the table
+ * (recorder threads read backend records while the GL thread creates
+ * objects): a grown directory is published after its contents, and the old
+ * one is kept until sgl_table_destroy.
+ */
+
+#ifndef SGL_TABLE_H
+#define SGL_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SGL_TABLE_CHUNK_SHIFT   6
+#define SGL_TABLE_CHUNK         (1u << SGL_TABLE_CHUNK_SHIFT)   /* Records per chunk */
+
+typedef struct sgl_table {
+    uint8_t **chunks;           /* Zero-initialized on allocation, NULL = not yet used */
+    uint32_t num_chunks;        /* Entries in chunks[] */
+    uint8_t **retired[32];      /* Outgrown directories, still visible to concurrent lookups */
+    uint32_t num_retired;
+    uint32_t item_size;
+    uint32_t next_handle;       /* Lowest handle never handed out by sgl_table_alloc */
+    uint32_t *free_list;        /* Released handles, reused most recent first */
+    uint32_t free_count;
+    uint32_t free_capacity;
+} sgl_table_t;
+
+void sgl_table_init(sgl_table_t *t, size_t item_size);
+
+/* Free every chunk; the table is empty (and usable) afterwards */
+void sgl_table_destroy(sgl_table_t *t);
+
+/* Record of handle, or NULL if its chunk was never allocated */
+static inline void *sgl_table_get(const sgl_table_t *t, uint32_t handle) {
+    uint32_t chunk = handle >> SGL_TABLE_CHUNK_SHIFT;
+    if (chunk >= __atomic_load_n(&t->num_chunks, __ATOMIC_ACQUIRE)) return NULL;
+    uint8_t *base = __atomic_load_n(&t->chunks[chunk], __ATOMIC_ACQUIRE);
+    if (!base) return NULL;
+    return base + (size_t)(handle & (SGL_TABLE_CHUNK - 1)) * t->item_size;
+}
+
+/* Record of handle, allocating its (zeroed) chunk; NULL when out of memory */
+void *sgl_table_ensure(sgl_table_t *t, uint32_t handle);
+
+/* Take a free handle (> 0) and make sure its record exists; 0 when out of memory.
+ * The record keeps its previous contents, callers reinitialize it. */
+uint32_t sgl_table_alloc(sgl_table_t *t);
+
+/* Return a handle taken with sgl_table_alloc */
+void sgl_table_release(sgl_table_t *t, uint32_t handle);
+
+/* One past the highest handle that may have a record (for iteration) */
+static inline uint32_t sgl_table_end(const sgl_table_t *t) {
+    return t->num_chunks << SGL_TABLE_CHUNK_SHIFT;
+}
+
+#endif /* SGL_TABLE_H */
@@ -0,0 +1,260 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * Compressed Texture Containers Implementation
+ *
+ * All three containers are little-endian (KTX 1.1 files written big-endian
+ * are rejected). Level sizes are derived from the format and checked to be
+ * present in the file, so a truncated file fails here rather than mid-upload.
+ */
+
+#include "sgl_texfile.h"
+
+#include <GLES2/gl2ext.h>
+#include <string.h>
+
+/* ============================================================================
+ * Block Formats
+ * ============================================================================ */
+
+bool sgl_compressed_block_info(GLenum format, uint32_t *block_w, uint32_t *block_h,
+                               uint32_t *block_bytes) {
+    uint32_t bw = 4, bh = 4, bpb;
+
+    switch (format) {
+        /* 8 bytes/block, 4x4 */
+        case GL_ETC1_RGB8_OES:
+        case GL_COMPRESSED_RGB8_ETC2:
+        case GL_COMPRESSED_SRGB8_ETC2:
+        case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+        case GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+        case GL_COMPRESSED_R11_EAC:
+        case GL_COMPRESSED_SIGNED_R11_EAC:
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RED_RGTC1_EXT:
+        case GL_COMPRESSED_SIGNED_RED_RGTC1_EXT:
+            bpb = 8; break;
+
+        /* 16 bytes/block, 4x4 */
+        case GL_COMPRESSED_RGBA8_ETC2_EAC:
+        case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+        case GL_COMPRESSED_RG11_EAC:
+        case GL_COMPRESSED_SIGNED_RG11_EAC:
+        case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_RED_GREEN_RGTC2_EXT:
+        case GL_COMPRESSED_SIGNED_RED_GREEN_RGTC2_EXT:
+        case GL_COMPRESSED_RGBA_BPTC_UNORM_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM_EXT:
+        case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT_EXT:
+        case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT_EXT:
+            bpb = 16; break;
+
+        /* ASTC - all 16 bytes/block, varying block sizes */
+        case GL_COMPRESSED_RGBA_ASTC_4x4_KHR:   case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR:   bw=4;  bh=4;  bpb=16; break;
+        case GL_COMPRESSED_RGBA_ASTC_5x4_KHR:   case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_5x4_KHR:   bw=5;  bh=4;  bpb=16; break;
+        case GL_COMPRESSED_RGBA_ASTC_5x5_KHR:   case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_5x5_KHR:   bw=5;  bh=5;  bpb=16; break;
+        case GL_COMPRESSED_RGBA_ASTC_6x5_KHR:   case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_6x5_KHR:   bw=6;  bh=5;  bpb=16; break;
+        case GL_COMPRESSED_RGBA_ASTC_6x6_KHR:   case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_6x6_KHR:   bw=6;  bh=6;  bpb=16; break;
+        case GL_COMPRESSED_RGBA_ASTC_8x5_KHR:   case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_8x5_KHR:   bw=8;  bh=5;  bpb=16; break;
+        case GL_COMPRESSED_RGBA_ASTC_8x6_KHR:   case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_8x6_KHR:   bw=8;  bh=6;  bpb=16; break;
+        case GL_COMPRESSED_RGBA_ASTC_8x8_KHR:   case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_8x8_KHR:   bw=8;  bh=8;  bpb=16; break;
+        case GL_COMPRESSED_RGBA_ASTC_10x5_KHR:  case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_10x5_KHR:  bw=10; bh=5;  bpb=16; break;
+        case GL_COMPRESSED_RGBA_ASTC_10x6_KHR:  case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_10x6_KHR:  bw=10; bh=6;  bpb=16; break;
+        case GL_COMPRESSED_RGBA_ASTC_10x8_KHR:  case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_10x8_KHR:  bw=10; bh=8;  bpb=16; break;
+        case GL_COMPRESSED_RGBA_ASTC_10x10_KHR: case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_10x10_KHR: bw=10; bh=10; bpb=16; break;
+        case GL_COMPRESSED_RGBA_ASTC_12x10_KHR: case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_12x10_KHR: bw=12; bh=10; bpb=16; break;
+        case GL_COMPRESSED_RGBA_ASTC_12x12_KHR: case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_12x12_KHR: bw=12; bh=12; bpb=16; break;
+
+        default:
+            return false;
+    }
+
+    *block_w = bw;
+    *block_h = bh;
+    *block_bytes = bpb;
+    return true;
+}
+
+uint32_t sgl_compressed_level_size(GLenum format, uint32_t width, uint32_t height) {
+    uint32_t bw, bh, bpb;
+    if (!sgl_compressed_block_info(format, &bw, &bh, &bpb)) {
+        return 0;
+    }
+    return ((width + bw - 1) / bw) * ((height + bh - 1) / bh) * bpb;
+}
+
+/* ============================================================================
+ * Container Headers
+ * ============================================================================ */
+
+static const uint8_t s_ktx1_id[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+static const uint8_t s_ktx2_id[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+static const uint8_t s_astc_id[4]  = { 0x13, 0xAB, 0xA1, 0x5C };
+
+static uint32_t rd32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t rd64(const uint8_t *p) {
+    return (uint64_t)rd32(p) | ((uint64_t)rd32(p + 4) << 32);
+}
+
+static bool read_at(FILE *fp, uint64_t offset, void *dst, size_t size) {
+    return fseek(fp, (long)offset, SEEK_SET) == 0 && fread(dst, 1, size, fp) == size;
+}
+
+/* Map a Vulkan block format (KTX2 vkFormat) to its GL enum, 0 if unsupported */
+static GLenum sgl_texfile_vk_format(uint32_t vk) {
+    static const GLenum astc[28] = {
+        GL_COMPRESSED_RGBA_ASTC_4x4_KHR,   GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR,
+        GL_COMPRESSED_RGBA_ASTC_5x4_KHR,   GL_COMPRESSED_SRGB8_ALPHA8_ASTC_5x4_KHR,
+        GL_COMPRESSED_RGBA_ASTC_5x5_KHR,   GL_COMPRESSED_SRGB8_ALPHA8_ASTC_5x5_KHR,
+        GL_COMPRESSED_RGBA_ASTC_6x5_KHR,   GL_COMPRESSED_SRGB8_ALPHA8_ASTC_6x5_KHR,
+        GL_COMPRESSED_RGBA_ASTC_6x6_KHR,   GL_COMPRESSED_SRGB8_ALPHA8_ASTC_6x6_KHR,
+        GL_COMPRESSED_RGBA_ASTC_8x5_KHR,   GL_COMPRESSED_SRGB8_ALPHA8_ASTC_8x5_KHR,
+        GL_COMPRESSED_RGBA_ASTC_8x6_KHR,   GL_COMPRESSED_SRGB8_ALPHA8_ASTC_8x6_KHR,
+        GL_COMPRESSED_RGBA_ASTC_8x8_KHR,   GL_COMPRESSED_SRGB8_ALPHA8_ASTC_8x8_KHR,
+        GL_COMPRESSED_RGBA_ASTC_10x5_KHR,  GL_COMPRESSED_SRGB8_ALPHA8_ASTC_10x5_KHR,
+        GL_COMPRESSED_RGBA_ASTC_10x6_KHR,  GL_COMPRESSED_SRGB8_ALPHA8_ASTC_10x6_KHR,
+        GL_COMPRESSED_RGBA_ASTC_10x8_KHR,  GL_COMPRESSED_SRGB8_ALPHA8_ASTC_10x8_KHR,
+        GL_COMPRESSED_RGBA_ASTC_10x10_KHR, GL_COMPRESSED_SRGB8_ALPHA8_ASTC_10x10_KHR,
+        GL_COMPRESSED_RGBA_ASTC_12x10_KHR, GL_COMPRESSED_SRGB8_ALPHA8_ASTC_12x10_KHR,
+        GL_COMPRESSED_RGBA_ASTC_12x12_KHR, GL_COMPRESSED_SRGB8_ALPHA8_ASTC_12x12_KHR,
+    };
+    /* VK_FORMAT_BC1_RGB_UNORM_BLOCK (131) .. VK_FORMAT_EAC_R11G11_SNORM_BLOCK (156);
+     * sRGB S3TC has no deko3d format */
+    static const GLenum bc_etc[26] = {
+        GL_COMPRESSED_RGB_S3TC_DXT1_EXT,           0,
+        GL_COMPRESSED_RGBA_S3TC_DXT1_EXT,          0,
+        GL_COMPRESSED_RGBA_S3TC_DXT3_EXT,          0,
+        GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,          0,
+        GL_COMPRESSED_RED_RGTC1_EXT,               GL_COMPRESSED_SIGNED_RED_RGTC1_EXT,
+        GL_COMPRESSED_RED_GREEN_RGTC2_EXT,         GL_COMPRESSED_SIGNED_RED_GREEN_RGTC2_EXT,
+        GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT_EXT, GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT_EXT,
+        GL_COMPRESSED_RGBA_BPTC_UNORM_EXT,         GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM_EXT,
+        GL_COMPRESSED_RGB8_ETC2,                   GL_COMPRESSED_SRGB8_ETC2,
+        GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2, GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2,
+        GL_COMPRESSED_RGBA8_ETC2_EAC,              GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC,
+        GL_COMPRESSED_R11_EAC,                     GL_COMPRESSED_SIGNED_R11_EAC,
+        GL_COMPRESSED_RG11_EAC,                    GL_COMPRESSED_SIGNED_RG11_EAC,
+    };
+
+    if (vk >= 131 && vk < 131 + 26) return bc_etc[vk - 131];
+    if (vk >= 157 && vk < 157 + 28) return astc[vk - 157];
+    return 0;
+}
+
+/* KTX 1.1: 64-byte header, key/value data, then { imageSize, data, padding } per level */
+static bool sgl_texfile_parse_ktx1(FILE *fp, const uint8_t *h, sgl_texfile_t *out) {
+    if (rd32(h + 12) != 0x04030201) return false;       /* Big-endian file */
+    if (rd32(h + 16) != 0 || rd32(h + 24) != 0) return false;  /* glType/glFormat: compressed only */
+    if (rd32(h + 44) > 1) return false;                 /* pixelDepth */
+    if (rd32(h + 48) != 0) return false;                /* numberOfArrayElements */
+    if (rd32(h + 52) != 1) return false;                /* numberOfFaces */
+
+    out->internalformat = (GLenum)rd32(h + 28);
+    out->width = rd32(h + 36);
+    out->height = rd32(h + 40) ? rd32(h + 40) : 1;
+    out->levels = rd32(h + 56) ? rd32(h + 56) : 1;
+    if (out->levels > SGL_TEXFILE_MAX_LEVELS) return false;
+
+    uint64_t offset = 64 + (uint64_t)rd32(h + 60);
+    for (uint32_t level = 0; level < out->levels; level++) {
+        uint8_t size_field[4];
+        if (!read_at(fp, offset, size_field, sizeof(size_field))) return false;
+        uint32_t size = rd32(size_field);
+        out->level_offset[level] = offset + 4;
+        out->level_size[level] = size;
+        offset += 4 + ((size + 3) & ~3u);
+    }
+    return true;
+}
+
+/* KTX 2.0: 80-byte header followed by a { byteOffset, byteLength, uncompressed } level index */
+static bool sgl_texfile_parse_ktx2(FILE *fp, const uint8_t *h, sgl_texfile_t *out) {
+    if (rd32(h + 28) > 1) return false;                 /* pixelDepth */
+    if (rd32(h + 32) > 1) return false;                 /* layerCount */
+    if (rd32(h + 36) != 1) return false;                /* faceCount */
+    if (rd32(h + 44) != 0) return false;                /* supercompressionScheme */
+
+    out->internalformat = sgl_texfile_vk_format(rd32(h + 12));
+    out->width = rd32(h + 20);
+    out->height = rd32(h + 24) ? rd32(h + 24) : 1;
+    out->levels = rd32(h + 40) ? rd32(h + 40) : 1;
+    if (out->internalformat == 0 || out->levels > SGL_TEXFILE_MAX_LEVELS) return false;
+
+    uint8_t index[SGL_TEXFILE_MAX_LEVELS * 24];
+    if (!read_at(fp, 80, index, (size_t)out->levels * 24)) return false;
+    for (uint32_t level = 0; level < out->levels; level++) {
+        uint64_t length = rd64(index + level * 24 + 8);
+        if (length > UINT32_MAX) return false;
+        out->level_offset[level] = rd64(index + level * 24);
+        out->level_size[level] = (uint32_t)length;
+    }
+    return true;
+}
+
+/* .astc: 16-byte header (magic, block dims, 24-bit sizes), one level */
+static bool sgl_texfile_parse_astc(const uint8_t *h, sgl_texfile_t *out) {
+    static const uint8_t dims[14][2] = {
+        {4,4}, {5,4}, {5,5}, {6,5}, {6,6}, {8,5}, {8,6}, {8,8},
+        {10,5}, {10,6}, {10,8}, {10,10}, {12,10}, {12,12},
+    };
+    if (h[6] != 1) return false;                        /* 3D block */
+    uint32_t zsize = (uint32_t)h[13] | ((uint32_t)h[14] << 8) | ((uint32_t)h[15] << 16);
+    if (zsize != 1) return false;
+
+    out->internalformat = 0;
+    for (uint32_t i = 0; i < 14; i++) {
+        if (dims[i][0] == h[4] && dims[i][1] == h[5]) {
+            out->internalformat = GL_COMPRESSED_RGBA_ASTC_4x4_KHR + i;
+            break;
+        }
+    }
+    if (out->internalformat == 0) return false;
+
+    out->width = (uint32_t)h[7] | ((uint32_t)h[8] << 8) | ((uint32_t)h[9] << 16);
+    out->height = (uint32_t)h[10] | ((uint32_t)h[11] << 8) | ((uint32_t)h[12] << 16);
+    out->levels = 1;
+    out->level_offset[0] = 16;
+    out->level_size[0] = sgl_compressed_level_size(out->internalformat, out->width, out->height);
+    return true;
+}
+
+bool sgl_texfile_parse(FILE *fp, sgl_texfile_t *out) {
+    uint8_t h[80];
+    memset(out, 0, sizeof(*out));
+    memset(h, 0, sizeof(h));
+
+    if (!fp || fseek(fp, 0, SEEK_END) != 0) return false;
+    long file_size = ftell(fp);
+    if (file_size < 16 || !read_at(fp, 0, h, file_size < 80 ? (size_t)file_size : sizeof(h))) {
+        return false;
+    }
+
+    bool ok;
+    if (file_size >= 64 && memcmp(h, s_ktx1_id, sizeof(s_ktx1_id)) == 0) {
+        ok = sgl_texfile_parse_ktx1(fp, h, out);
+    } else if (file_size >= 80 && memcmp(h, s_ktx2_id, sizeof(s_ktx2_id)) == 0) {
+        ok = sgl_texfile_parse_ktx2(fp, h, out);
+    } else if (memcmp(h, s_astc_id, sizeof(s_astc_id)) == 0) {
+        ok = sgl_texfile_parse_astc(h, out);
+    } else {
+        ok = false;
+    }
+    if (!ok || out->width == 0 || out->height == 0) return false;
+
+    /* Every level must hold its full image and lie inside the file */
+    for (uint32_t level = 0; level < out->levels; level++) {
+        uint32_t w = out->width >> level ? out->width >> level : 1;
+        uint32_t h_level = out->height >> level ? out->height >> level : 1;
+        uint32_t expected = sgl_compressed_level_size(out->internalformat, w, h_level);
+        if (expected == 0 || out->level_size[level] < expected ||
+            out->level_offset[level] + expected > (uint64_t)file_size) {
+            return false;
+        }
+        out->level_size[level] = expected;
+    }
+    return true;
+}
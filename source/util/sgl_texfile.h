@@ -0,0 +1,47 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * Compressed Texture Containers
+ *
+ * Header parsing for the container files sglTexImageFromFile() loads
+ * straight into GPU staging memory: KTX 1.1, KTX 2.0 (no supercompression)
+ * and the ARM .astc format. Only the header and level index are read; the
+ * caller streams each level's bytes from the returned file offsets.
+ */
+
+#ifndef SGL_TEXFILE_H
+#define SGL_TEXFILE_H
+
+#include <GLES2/gl2.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define SGL_TEXFILE_MAX_LEVELS 16
+
+typedef struct sgl_texfile {
+    GLenum internalformat;          /* GL compressed format */
+    uint32_t width;
+    uint32_t height;
+    uint32_t levels;
+    uint64_t level_offset[SGL_TEXFILE_MAX_LEVELS];  /* File offset of each level */
+    uint32_t level_size[SGL_TEXFILE_MAX_LEVELS];    /* Bytes of each level */
+} sgl_texfile_t;
+
+/*
+ * Block footprint of a compressed format (block width/height in texels and
+ * bytes per block). Returns false for formats that are not block-compressed.
+ */
+bool sgl_compressed_block_info(GLenum format, uint32_t *block_w, uint32_t *block_h,
+                               uint32_t *block_bytes);
+
+/* Size in bytes of a width x height image of a compressed format (0 if unknown) */
+uint32_t sgl_compressed_level_size(GLenum format, uint32_t width, uint32_t height);
+
+/*
+ * Read a 2D container header from fp (any position; seeks to the start).
+ * Rejects arrays, cubemaps, 3D images, supercompressed KTX2 and formats
+ * without block info; level sizes are checked against the format.
+ */
+bool sgl_texfile_parse(FILE *fp, sgl_texfile_t *out);
+
+#endif /* SGL_TEXFILE_H */
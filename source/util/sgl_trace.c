@@ -0,0 +1,235 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * GL Call Stream Traces
+ */
+
+#include "sgl_trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Stdio buffer of a trace; SD card writes are far cheaper in large blocks */
+#define SGL_TRACE_IO_BUFFER (256 * 1024)
+
+struct sgl_trace {
+    FILE *fp;
+    char *io_buffer;
+    bool writing;
+    bool failed;
+    uint64_t bytes;
+    uint8_t *blob;              /* Reader: blob of the last record */
+    uint32_t blob_capacity;
+};
+
+static const char *const s_op_names[SGL_TRACE_OP_COUNT] = {
+    [SGL_TRACE_SWAP] = "eglSwapBuffers",
+    [SGL_TRACE_ENABLE] = "glEnable",
+    [SGL_TRACE_DISABLE] = "glDisable",
+    [SGL_TRACE_DEPTH_FUNC] = "glDepthFunc",
+    [SGL_TRACE_DEPTH_MASK] = "glDepthMask",
+    [SGL_TRACE_DEPTH_RANGEF] = "glDepthRangef",
+    [SGL_TRACE_BLEND_FUNC] = "glBlendFunc",
+    [SGL_TRACE_BLEND_FUNC_SEPARATE] = "glBlendFuncSeparate",
+    [SGL_TRACE_BLEND_EQUATION] = "glBlendEquation",
+    [SGL_TRACE_BLEND_EQUATION_SEPARATE] = "glBlendEquationSeparate",
+    [SGL_TRACE_BLEND_COLOR] = "glBlendColor",
+    [SGL_TRACE_CULL_FACE] = "glCullFace",
+    [SGL_TRACE_FRONT_FACE] = "glFrontFace",
+    [SGL_TRACE_COLOR_MASK] = "glColorMask",
+    [SGL_TRACE_STENCIL_FUNC_SEPARATE] = "glStencilFuncSeparate",
+    [SGL_TRACE_STENCIL_MASK_SEPARATE] = "glStencilMaskSeparate",
+    [SGL_TRACE_STENCIL_OP_SEPARATE] = "glStencilOpSeparate",
+    [SGL_TRACE_VIEWPORT] = "glViewport",
+    [SGL_TRACE_SCISSOR] = "glScissor",
+    [SGL_TRACE_LINE_WIDTH] = "glLineWidth",
+    [SGL_TRACE_POLYGON_OFFSET] = "glPolygonOffset",
+    [SGL_TRACE_PIXEL_STOREI] = "glPixelStorei",
+    [SGL_TRACE_CLEAR_COLOR] = "glClearColor",
+    [SGL_TRACE_CLEAR_DEPTHF] = "glClearDepthf",
+    [SGL_TRACE_CLEAR_STENCIL] = "glClearStencil",
+    [SGL_TRACE_CLEAR] = "glClear",
+    [SGL_TRACE_FLUSH] = "glFlush",
+    [SGL_TRACE_FINISH] = "glFinish",
+    [SGL_TRACE_GEN_BUFFERS] = "glGenBuffers",
+    [SGL_TRACE_DELETE_BUFFERS] = "glDeleteBuffers",
+    [SGL_TRACE_BIND_BUFFER] = "glBindBuffer",
+    [SGL_TRACE_BUFFER_DATA] = "glBufferData",
+    [SGL_TRACE_BUFFER_SUB_DATA] = "glBufferSubData",
+    [SGL_TRACE_GEN_TEXTURES] = "glGenTextures",
+    [SGL_TRACE_DELETE_TEXTURES] = "glDeleteTextures",
+    [SGL_TRACE_ACTIVE_TEXTURE] = "glActiveTexture",
+    [SGL_TRACE_BIND_TEXTURE] = "glBindTexture",
+    [SGL_TRACE_TEX_IMAGE_2D] = "glTexImage2D",
+    [SGL_TRACE_TEX_SUB_IMAGE_2D] = "glTexSubImage2D",
+    [SGL_TRACE_COMPRESSED_TEX_IMAGE_2D] = "glCompressedTexImage2D",
+    [SGL_TRACE_COMPRESSED_TEX_SUB_IMAGE_2D] = "glCompressedTexSubImage2D",
+    [SGL_TRACE_COPY_TEX_IMAGE_2D] = "glCopyTexImage2D",
+    [SGL_TRACE_COPY_TEX_SUB_IMAGE_2D] = "glCopyTexSubImage2D",
+    [SGL_TRACE_TEX_PARAMETERI] = "glTexParameteri",
+    [SGL_TRACE_GENERATE_MIPMAP] = "glGenerateMipmap",
+    [SGL_TRACE_CREATE_SHADER] = "glCreateShader",
+    [SGL_TRACE_DELETE_SHADER] = "glDeleteShader",
+    [SGL_TRACE_SHADER_SOURCE] = "glShaderSource",
+    [SGL_TRACE_COMPILE_SHADER] = "glCompileShader",
+    [SGL_TRACE_CREATE_PROGRAM] = "glCreateProgram",
+    [SGL_TRACE_DELETE_PROGRAM] = "glDeleteProgram",
+    [SGL_TRACE_ATTACH_SHADER] = "glAttachShader",
+    [SGL_TRACE_BIND_ATTRIB_LOCATION] = "glBindAttribLocation",
+    [SGL_TRACE_LINK_PROGRAM] = "glLinkProgram",
+    [SGL_TRACE_USE_PROGRAM] = "glUseProgram",
+    [SGL_TRACE_GET_UNIFORM_LOCATION] = "glGetUniformLocation",
+    [SGL_TRACE_UNIFORMFV] = "glUniformfv",
+    [SGL_TRACE_UNIFORMIV] = "glUniformiv",
+    [SGL_TRACE_UNIFORM_MATRIXFV] = "glUniformMatrixfv",
+    [SGL_TRACE_ENABLE_VERTEX_ATTRIB_ARRAY] = "glEnableVertexAttribArray",
+    [SGL_TRACE_DISABLE_VERTEX_ATTRIB_ARRAY] = "glDisableVertexAttribArray",
+    [SGL_TRACE_VERTEX_ATTRIB_POINTER] = "glVertexAttribPointer",
+    [SGL_TRACE_VERTEX_ATTRIB_DIVISOR] = "glVertexAttribDivisorANGLE",
+    [SGL_TRACE_VERTEX_ATTRIB4F] = "glVertexAttrib4f",
+    [SGL_TRACE_CLIENT_ARRAY] = "glVertexAttribPointer (client array)",
+    [SGL_TRACE_GEN_VERTEX_ARRAYS] = "glGenVertexArraysOES",
+    [SGL_TRACE_DELETE_VERTEX_ARRAYS] = "glDeleteVertexArraysOES",
+    [SGL_TRACE_BIND_VERTEX_ARRAY] = "glBindVertexArrayOES",
+    [SGL_TRACE_GEN_FRAMEBUFFERS] = "glGenFramebuffers",
+    [SGL_TRACE_DELETE_FRAMEBUFFERS] = "glDeleteFramebuffers",
+    [SGL_TRACE_BIND_FRAMEBUFFER] = "glBindFramebuffer",
+    [SGL_TRACE_FRAMEBUFFER_TEXTURE_2D] = "glFramebufferTexture2D",
+    [SGL_TRACE_FRAMEBUFFER_RENDERBUFFER] = "glFramebufferRenderbuffer",
+    [SGL_TRACE_GEN_RENDERBUFFERS] = "glGenRenderbuffers",
+    [SGL_TRACE_DELETE_RENDERBUFFERS] = "glDeleteRenderbuffers",
+    [SGL_TRACE_BIND_RENDERBUFFER] = "glBindRenderbuffer",
+    [SGL_TRACE_RENDERBUFFER_STORAGE] = "glRenderbufferStorage",
+    [SGL_TRACE_DRAW_BUFFERS] = "glDrawBuffersEXT",
+    [SGL_TRACE_DISCARD_FRAMEBUFFER] = "glDiscardFramebufferEXT",
+    [SGL_TRACE_BLIT_FRAMEBUFFER] = "glBlitFramebuffer",
+    [SGL_TRACE_READ_PIXELS] = "glReadPixels",
+    [SGL_TRACE_DRAW_ARRAYS] = "glDrawArrays",
+    [SGL_TRACE_DRAW_ELEMENTS] = "glDrawElements",
+};
+
+static sgl_trace_t *sgl_trace_alloc(const char *path, const char *mode) {
+    if (!path || !path[0]) return NULL;
+
+    sgl_trace_t *trace = (sgl_trace_t *)calloc(1, sizeof(*trace));
+    if (!trace) return NULL;
+
+    trace->fp = fopen(path, mode);
+    if (!trace->fp) {
+        free(trace);
+        return NULL;
+    }
+    trace->io_buffer = (char *)malloc(SGL_TRACE_IO_BUFFER);
+    if (trace->io_buffer) setvbuf(trace->fp, trace->io_buffer, _IOFBF, SGL_TRACE_IO_BUFFER);
+    return trace;
+}
+
+sgl_trace_t *sgl_trace_create(const char *path) {
+    sgl_trace_t *trace = sgl_trace_alloc(path, "wb");
+    if (!trace) return NULL;
+
+    trace->writing = true;
+    const uint32_t header[2] = { SGL_TRACE_MAGIC, SGL_TRACE_VERSION };
+    if (fwrite(header, sizeof(header), 1, trace->fp) != 1) {
+        sgl_trace_close(trace);
+        return NULL;
+    }
+    trace->bytes = sizeof(header);
+    return trace;
+}
+
+sgl_trace_t *sgl_trace_open(const char *path) {
+    sgl_trace_t *trace = sgl_trace_alloc(path, "rb");
+    if (!trace) return NULL;
+
+    uint32_t header[2];
+    if (fread(header, sizeof(header), 1, trace->fp) != 1 ||
+        header[0] != SGL_TRACE_MAGIC || header[1] != SGL_TRACE_VERSION) {
+        sgl_trace_close(trace);
+        return NULL;
+    }
+    trace->bytes = sizeof(header);
+    return trace;
+}
+
+void sgl_trace_close(sgl_trace_t *trace) {
+    if (!trace) return;
+    fclose(trace->fp);
+    free(trace->io_buffer);
+    free(trace->blob);
+    free(trace);
+}
+
+bool sgl_trace_write(sgl_trace_t *trace, uint32_t op, const uint32_t *args, uint32_t argc,
+                     const void *blob, uint32_t blob_size) {
+    if (trace->failed || argc > SGL_TRACE_MAX_ARGS) return false;
+
+    uint32_t head[2] = { op | argc << 8, blob_size };
+    size_t head_words = 1;
+    if (blob) {
+        head[0] |= SGL_TRACE_HAS_BLOB;
+        head_words = 2;
+    }
+
+    static const uint8_t pad[4] = { 0 };
+    uint32_t pad_bytes = blob ? (4 - (blob_size & 3)) & 3 : 0;
+    bool ok = fwrite(head, 4, head_words, trace->fp) == head_words &&
+              (argc == 0 || fwrite(args, 4, argc, trace->fp) == argc) &&
+              (!blob || blob_size == 0 || fwrite(blob, blob_size, 1, trace->fp) == 1) &&
+              (pad_bytes == 0 || fwrite(pad, pad_bytes, 1, trace->fp) == 1);
+    if (!ok) {
+        trace->failed = true;
+        return false;
+    }
+    trace->bytes += (head_words + argc) * 4 + (uint64_t)(blob ? blob_size + pad_bytes : 0);
+    return true;
+}
+
+bool sgl_trace_read(sgl_trace_t *trace, sgl_trace_record_t *rec) {
+    if (trace->writing || trace->failed) return false;
+
+    uint32_t head;
+    if (fread(&head, 4, 1, trace->fp) != 1) return false;
+
+    rec->op = head & 0xFF;
+    rec->argc = (head >> 8) & 0x7F;
+    rec->blob_size = 0;
+    rec->blob = NULL;
+    if (rec->op == 0 || rec->op >= SGL_TRACE_OP_COUNT || rec->argc > SGL_TRACE_MAX_ARGS) {
+        trace->failed = true;
+        return false;
+    }
+
+    bool ok = true;
+    if (head & SGL_TRACE_HAS_BLOB) ok = fread(&rec->blob_size, 4, 1, trace->fp) == 1;
+    if (ok && rec->argc) ok = fread(rec->args, 4, rec->argc, trace->fp) == rec->argc;
+
+    uint32_t padded = (rec->blob_size + 3) & ~3u;
+    if (ok && (head & SGL_TRACE_HAS_BLOB)) {
+        if (padded > trace->blob_capacity || !trace->blob) {
+            uint32_t capacity = padded > 4096 ? padded : 4096;
+            uint8_t *blob = (uint8_t *)realloc(trace->blob, capacity);
+            ok = blob != NULL;
+            if (ok) {
+                trace->blob = blob;
+                trace->blob_capacity = capacity;
+            }
+        }
+        ok = ok && (padded == 0 || fread(trace->blob, padded, 1, trace->fp) == 1);
+        rec->blob = trace->blob;
+    }
+    if (!ok) {
+        trace->failed = true;
+        return false;
+    }
+    trace->bytes += 4 + ((head & SGL_TRACE_HAS_BLOB) ? 4 : 0) + rec->argc * 4 + padded;
+    return true;
+}
+
+uint64_t sgl_trace_bytes(const sgl_trace_t *trace) {
+    return trace->bytes;
+}
+
+const char *sgl_trace_op_name(uint32_t op) {
+    const char *name = op < SGL_TRACE_OP_COUNT ? s_op_names[op] : NULL;
+    return name ? name : "unknown";
+}
@@ -0,0 +1,152 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * GL Call Stream Traces
+ *
+ * File format written by sglBeginCapture() and played back by sglReplay*.
+ * A trace is a header followed by one record per captured GL call: the
+ * opcode, the arguments as 32-bit words (floats bit-cast) and an optional
+ * blob with the client data the call read - buffer and texture contents,
+ * shader source, client vertex arrays and indices. Object names are those
+ * the capturing context generated; the replayer maps them to its own.
+ *
+ * Record layout (little endian, 4-byte aligned):
+ *   word 0       opcode | argc << 8 | SGL_TRACE_HAS_BLOB
+ *   [word 1]     blob size in bytes, with SGL_TRACE_HAS_BLOB
+ *   argc words   arguments
+ *   blob         padded to a multiple of 4 bytes
+ */
+
+#ifndef SGL_TRACE_H
+#define SGL_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SGL_TRACE_MAGIC     0x54474C53u  /* "SGLT" */
+#define SGL_TRACE_VERSION   1
+#define SGL_TRACE_MAX_ARGS  16
+#define SGL_TRACE_HAS_BLOB  (1u << 15)
+
+/* Captured calls; argument words are listed in gl_replay.c. Values are part
+ * of the file format: append new ones, never renumber. */
+typedef enum sgl_trace_op {
+    SGL_TRACE_SWAP = 1,                 /* eglSwapBuffers: ends a frame */
+    SGL_TRACE_ENABLE,
+    SGL_TRACE_DISABLE,
+    SGL_TRACE_DEPTH_FUNC,
+    SGL_TRACE_DEPTH_MASK,
+    SGL_TRACE_DEPTH_RANGEF,
+    SGL_TRACE_BLEND_FUNC,
+    SGL_TRACE_BLEND_FUNC_SEPARATE,
+    SGL_TRACE_BLEND_EQUATION,
+    SGL_TRACE_BLEND_EQUATION_SEPARATE,
+    SGL_TRACE_BLEND_COLOR,
+    SGL_TRACE_CULL_FACE,
+    SGL_TRACE_FRONT_FACE,
+    SGL_TRACE_COLOR_MASK,
+    SGL_TRACE_STENCIL_FUNC_SEPARATE,
+    SGL_TRACE_STENCIL_MASK_SEPARATE,
+    SGL_TRACE_STENCIL_OP_SEPARATE,
+    SGL_TRACE_VIEWPORT,
+    SGL_TRACE_SCISSOR,
+    SGL_TRACE_LINE_WIDTH,
+    SGL_TRACE_POLYGON_OFFSET,
+    SGL_TRACE_PIXEL_STOREI,
+    SGL_TRACE_CLEAR_COLOR,
+    SGL_TRACE_CLEAR_DEPTHF,
+    SGL_TRACE_CLEAR_STENCIL,
+    SGL_TRACE_CLEAR,
+    SGL_TRACE_FLUSH,
+    SGL_TRACE_FINISH,
+    SGL_TRACE_GEN_BUFFERS,
+    SGL_TRACE_DELETE_BUFFERS,
+    SGL_TRACE_BIND_BUFFER,
+    SGL_TRACE_BUFFER_DATA,
+    SGL_TRACE_BUFFER_SUB_DATA,
+    SGL_TRACE_GEN_TEXTURES,
+    SGL_TRACE_DELETE_TEXTURES,
+    SGL_TRACE_ACTIVE_TEXTURE,
+    SGL_TRACE_BIND_TEXTURE,
+    SGL_TRACE_TEX_IMAGE_2D,
+    SGL_TRACE_TEX_SUB_IMAGE_2D,
+    SGL_TRACE_COMPRESSED_TEX_IMAGE_2D,
+    SGL_TRACE_COMPRESSED_TEX_SUB_IMAGE_2D,
+    SGL_TRACE_COPY_TEX_IMAGE_2D,
+    SGL_TRACE_COPY_TEX_SUB_IMAGE_2D,
+    SGL_TRACE_TEX_PARAMETERI,
+    SGL_TRACE_GENERATE_MIPMAP,
+    SGL_TRACE_CREATE_SHADER,
+    SGL_TRACE_DELETE_SHADER,
+    SGL_TRACE_SHADER_SOURCE,
+    SGL_TRACE_COMPILE_SHADER,
+    SGL_TRACE_CREATE_PROGRAM,
+    SGL_TRACE_DELETE_PROGRAM,
+    SGL_TRACE_ATTACH_SHADER,
+    SGL_TRACE_BIND_ATTRIB_LOCATION,
+    SGL_TRACE_LINK_PROGRAM,
+    SGL_TRACE_USE_PROGRAM,
+    SGL_TRACE_GET_UNIFORM_LOCATION,
+    SGL_TRACE_UNIFORMFV,                /* glUniform{1234}f[v] */
+    SGL_TRACE_UNIFORMIV,                /* glUniform{1234}i[v] */
+    SGL_TRACE_UNIFORM_MATRIXFV,         /* glUniformMatrix{234}fv */
+    SGL_TRACE_ENABLE_VERTEX_ATTRIB_ARRAY,
+    SGL_TRACE_DISABLE_VERTEX_ATTRIB_ARRAY,
+    SGL_TRACE_VERTEX_ATTRIB_POINTER,
+    SGL_TRACE_VERTEX_ATTRIB_DIVISOR,
+    SGL_TRACE_VERTEX_ATTRIB4F,          /* glVertexAttrib{1234}f[v] */
+    SGL_TRACE_CLIENT_ARRAY,             /* Client array contents read by the next draw */
+    SGL_TRACE_GEN_VERTEX_ARRAYS,
+    SGL_TRACE_DELETE_VERTEX_ARRAYS,
+    SGL_TRACE_BIND_VERTEX_ARRAY,
+    SGL_TRACE_GEN_FRAMEBUFFERS,
+    SGL_TRACE_DELETE_FRAMEBUFFERS,
+    SGL_TRACE_BIND_FRAMEBUFFER,
+    SGL_TRACE_FRAMEBUFFER_TEXTURE_2D,
+    SGL_TRACE_FRAMEBUFFER_RENDERBUFFER,
+    SGL_TRACE_GEN_RENDERBUFFERS,
+    SGL_TRACE_DELETE_RENDERBUFFERS,
+    SGL_TRACE_BIND_RENDERBUFFER,
+    SGL_TRACE_RENDERBUFFER_STORAGE,
+    SGL_TRACE_DRAW_BUFFERS,
+    SGL_TRACE_DISCARD_FRAMEBUFFER,
+    SGL_TRACE_BLIT_FRAMEBUFFER,
+    SGL_TRACE_READ_PIXELS,
+    SGL_TRACE_DRAW_ARRAYS,              /* Also the instanced variants */
+    SGL_TRACE_DRAW_ELEMENTS,
+    SGL_TRACE_OP_COUNT
+} sgl_trace_op_t;
+
+typedef struct sgl_trace_record {
+    uint32_t op;
+    uint32_t argc;
+    uint32_t args[SGL_TRACE_MAX_ARGS];
+    uint32_t blob_size;
+    const void *blob;           /* Valid until the next sgl_trace_read(), NULL without one */
+} sgl_trace_record_t;
+
+typedef struct sgl_trace sgl_trace_t;
+
+/* Create a trace file for writing (NULL if it cannot be created) */
+sgl_trace_t *sgl_trace_create(const char *path);
+
+/* Open a trace file for reading (NULL if missing or not a trace) */
+sgl_trace_t *sgl_trace_open(const char *path);
+
+/* Flush (when writing) and close; NULL is ignored */
+void sgl_trace_close(sgl_trace_t *trace);
+
+/* Append a record. After the first failed write the trace drops every
+ * record and returns false. */
+bool sgl_trace_write(sgl_trace_t *trace, uint32_t op, const uint32_t *args, uint32_t argc,
+                     const void *blob, uint32_t blob_size);
+
+/* Read the next record; false at the end of the trace or on a damaged record */
+bool sgl_trace_read(sgl_trace_t *trace, sgl_trace_record_t *rec);
+
+/* Bytes written or read so far, header included */
+uint64_t sgl_trace_bytes(const sgl_trace_t *trace);
+
+/* GL entry point an opcode was captured from, e.g. "glDrawElements" */
+const char *sgl_trace_op_name(uint32_t op);
+
+#endif /* SGL_TRACE_H */
@@ -0,0 +1,198 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * Background Work Queue Implementation
+ *
+ * One mutex guards the queue and every job's queued/done flags; workers
+ * sleep on s_work_cv and waiters on s_done_cv.
+ */
+
+#include "sgl_work_queue.h"
+#include <stddef.h>
+
+#ifdef __SWITCH__
+#include <switch.h>
+
+#define SGL_WORKER_STACK_SIZE   (1024 * 1024)  /* libuam recursion is deep */
+#define SGL_WORKER_PRIORITY     0x3B           /* Below the default main thread (0x2C) */
+
+static Mutex s_lock;
+static CondVar s_work_cv;
+static CondVar s_done_cv;
+static bool s_initialized = false;
+
+static sgl_work_t *s_head = NULL;
+static sgl_work_t *s_tail = NULL;
+
+static Thread s_threads[SGL_WORK_QUEUE_MAX_THREADS];
+static int s_num_threads = 0;
+static bool s_stopping = false;
+
+static void sgl_work_queue_init(void) {
+    if (s_initialized) return;
+    mutexInit(&s_lock);
+    condvarInit(&s_work_cv);
+    condvarInit(&s_done_cv);
+    s_initialized = true;
+}
+
+/* Unlink the head job; call with s_lock held */
+static sgl_work_t *sgl_work_pop(void) {
+    sgl_work_t *work = s_head;
+    if (work) {
+        s_head = work->next;
+        if (!s_head) s_tail = NULL;
+        work->next = NULL;
+        work->queued = false;
+    }
+    return work;
+}
+
+/* Remove a specific job from the queue; call with s_lock held */
+static bool sgl_work_unlink(sgl_work_t *work) {
+    sgl_work_t **link = &s_head;
+    sgl_work_t *prev = NULL;
+    while (*link && *link != work) {
+        prev = *link;
+        link = &(*link)->next;
+    }
+    if (!*link) return false;
+
+    *link = work->next;
+    if (s_tail == work) s_tail = prev;
+    work->next = NULL;
+    work->queued = false;
+    return true;
+}
+
+static void sgl_work_finish(sgl_work_t *work) {
+    mutexLock(&s_lock);
+    work->done = true;
+    condvarWakeAll(&s_done_cv);
+    mutexUnlock(&s_lock);
+}
+
+static void sgl_worker_main(void *arg) {
+    (void)arg;
+    for (;;) {
+        mutexLock(&s_lock);
+        while (!s_head && !s_stopping) {
+            condvarWait(&s_work_cv, &s_lock);
+        }
+        sgl_work_t *work = sgl_work_pop();
+        mutexUnlock(&s_lock);
+
+        if (!work) break;  /* Stopping and drained */
+        work->run(work);
+        sgl_work_finish(work);
+    }
+}
+
+void sgl_work_queue_set_threads(int count) {
+    sgl_work_queue_init();
+    if (count < 0) count = 0;
+    if (count > SGL_WORK_QUEUE_MAX_THREADS) count = SGL_WORK_QUEUE_MAX_THREADS;
+    if (count == s_num_threads) return;
+
+    /* Stop everyone, then start the requested number fresh */
+    if (s_num_threads > 0) {
+        mutexLock(&s_lock);
+        s_stopping = true;
+        condvarWakeAll(&s_work_cv);
+        mutexUnlock(&s_lock);
+
+        for (int i = 0; i < s_num_threads; i++) {
+            threadWaitForExit(&s_threads[i]);
+            threadClose(&s_threads[i]);
+        }
+        s_num_threads = 0;
+        s_stopping = false;
+    }
+
+    for (int i = 0; i < count; i++) {
+        /* Core 0 runs the GL thread; workers take cores 1 and 2 */
+        if (R_FAILED(threadCreate(&s_threads[i], sgl_worker_main, NULL, NULL,
+                                  SGL_WORKER_STACK_SIZE, SGL_WORKER_PRIORITY, 1 + i))) {
+            break;
+        }
+        if (R_FAILED(threadStart(&s_threads[i]))) {
+            threadClose(&s_threads[i]);
+            break;
+        }
+        s_num_threads++;
+    }
+}
+
+int sgl_work_queue_threads(void) {
+    return s_num_threads;
+}
+
+void sgl_work_submit(sgl_work_t *work) {
+    work->next = NULL;
+    work->done = false;
+
+    if (s_num_threads == 0) {
+        work->queued = false;
+        work->run(work);
+        work->done = true;
+        return;
+    }
+
+    mutexLock(&s_lock);
+    work->queued = true;
+    if (s_tail) s_tail->next = work;
+    else s_head = work;
+    s_tail = work;
+    condvarWakeOne(&s_work_cv);
+    mutexUnlock(&s_lock);
+}
+
+/* Acquire pairs with the unlock in sgl_work_finish, so the job's results are visible */
+bool sgl_work_is_done(const sgl_work_t *work) {
+    return __atomic_load_n(&work->done, __ATOMIC_ACQUIRE);
+}
+
+void sgl_work_wait(sgl_work_t *work) {
+    if (sgl_work_is_done(work)) return;
+
+    mutexLock(&s_lock);
+    if (work->queued && sgl_work_unlink(work)) {
+        /* Nobody started it yet: cheaper to run it here than to wait */
+        mutexUnlock(&s_lock);
+        work->run(work);
+        sgl_work_finish(work);
+        return;
+    }
+    while (!work->done) {
+        condvarWait(&s_done_cv, &s_lock);
+    }
+    mutexUnlock(&s_lock);
+}
+
+#else /* !__SWITCH__ */
+
+/* No thread support: every job runs inline at submit */
+
+void sgl_work_queue_set_threads(int count) {
+    (void)count;
+}
+
+int sgl_work_queue_threads(void) {
+    return 0;
+}
+
+void sgl_work_submit(sgl_work_t *work) {
+    work->next = NULL;
+    work->queued = false;
+    work->run(work);
+    work->done = true;
+}
+
+bool sgl_work_is_done(const sgl_work_t *work) {
+    return work->done;
+}
+
+void sgl_work_wait(sgl_work_t *work) {
+    (void)work;
+}
+
+#endif /* __SWITCH__ */
@@ -0,0 +1,43 @@
+/*
+ * SwitchGLES - OpenGL ES 2.0 / EGL implementation for Nintendo Switch
+ * Background Work Queue
+ *
+ * FIFO of CPU-only jobs run by worker threads pinned to the application
+ * cores the GL thread does not use. Jobs must not touch GL or backend state.
+ * A job the caller waits on before any worker picked it up is run inline on
+ * the waiting thread instead. With zero workers (or no libnx threads),
+ * submitting runs the job immediately.
+ */
+
+#ifndef SGL_WORK_QUEUE_H
+#define SGL_WORK_QUEUE_H
+
+#include <stdbool.h>
+
+#define SGL_WORK_QUEUE_MAX_THREADS  2   /* Application cores 1 and 2 */
+
+typedef struct sgl_work sgl_work_t;
+
+struct sgl_work {
+    void (*run)(sgl_work_t *work);
+    sgl_work_t *next;           /* Queue link (owned by the queue) */
+    volatile bool queued;
+    volatile bool done;
+};
+
+/* Start or stop workers (clamped to SGL_WORK_QUEUE_MAX_THREADS). Stopping drains the queue first. */
+void sgl_work_queue_set_threads(int count);
+
+/* Number of running workers */
+int sgl_work_queue_threads(void);
+
+/* Queue a job (run must be set). Runs it inline when there are no workers. */
+void sgl_work_submit(sgl_work_t *work);
+
+/* Non-blocking completion check */
+bool sgl_work_is_done(const sgl_work_t *work);
+
+/* Block until the job has run, running it here if no worker has started it */
+void sgl_work_wait(sgl_work_t *work);
+
+#endif /* SGL_WORK_QUEUE_H */
@@ -0,0 +1,1630 @@
+/*
+ * bench_gl.c - GL-layer CPU cost per call, on the null backend
+ *
+ * Runs draw, state, uniform, uniform storage, client array promotion, element buffer, command list, link,
+ * shader bundle, object churn, memory stats, cubemap, packed attribute, fence, texture file, capture/replay
+ * and shared context scenarios through EGL + GLES2 with the null backend (nothing reaches
+ * a GPU), so the numbers are the cost of the GL layer itself: validation,
+ * state tracking, uniform packing, client array copies. Reports ns per call
+ * and the backend counters of the last frame (sglGetFrameStats). Exits non-zero if a GL error is raised or a counter
+ * is off, so it doubles as a smoke test.
+ *
+ * Build and run (Linux):
+ *   make -f Makefile.host build_host/bench_gl && build_host/bench_gl
+ * Profile:
+ *   perf record build_host/bench_gl
+ *   valgrind --tool=callgrind build_host/bench_gl
+ */
+
+#define GL_GLEXT_PROTOTYPES
+#define EGL_EGLEXT_PROTOTYPES
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <GLES2/gl2sgl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "util/sgl_bundle.h"  /* Bundles written the way tools/shader_bundle does */
+
+#define BENCH_FRAMES    50
+#define BENCH_DRAWS     2000
+#define BENCH_VERTS     256
+#define BENCH_LINKS     16
+#define BENCH_OBJECTS   4096    /* Well past the old fixed object limits */
+
+static int s_failures = 0;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void check_gl(const char *scenario) {
+    GLenum err = glGetError();
+    if (err != GL_NO_ERROR) {
+        printf("  FAIL %s: GL error 0x%04x\n", scenario, err);
+        s_failures++;
+    }
+}
+
+static const char *s_vs =
+    "attribute vec4 a_position;\n"
+    "attribute vec2 a_texcoord;\n"
+    "uniform mat4 u_mvp;\n"
+    "uniform vec4 u_offset;\n"
+    "varying vec2 v_texcoord;\n"
+    "void main() {\n"
+    "    v_texcoord = a_texcoord;\n"
+    "    gl_Position = u_mvp * a_position + u_offset;\n"
+    "}\n";
+
+static const char *s_fs =
+    "precision mediump float;\n"
+    "uniform vec4 u_color;\n"
+    "uniform vec4 u_tint[4];\n"
+    "varying vec2 v_texcoord;\n"
+    "void main() {\n"
+    "    gl_FragColor = u_color * u_tint[int(v_texcoord.x * 3.0)];\n"
+    "}\n";
+
+static GLuint compile(GLenum type, const char *src) {
+    GLuint sh = glCreateShader(type);
+    glShaderSource(sh, 1, &src, NULL);
+    glCompileShader(sh);
+    return sh;
+}
+
+static GLuint build_program(void) {
+    GLuint prog = glCreateProgram();
+    GLuint vs = compile(GL_VERTEX_SHADER, s_vs);
+    GLuint fs = compile(GL_FRAGMENT_SHADER, s_fs);
+    glAttachShader(prog, vs);
+    glAttachShader(prog, fs);
+    glBindAttribLocation(prog, 0, "a_position");
+    glBindAttribLocation(prog, 1, "a_texcoord");
+    glLinkProgram(prog);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+
+    GLint linked = 0;
+    glGetProgramiv(prog, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        char log[512] = "";
+        glGetProgramInfoLog(prog, sizeof(log), NULL, log);
+        printf("  FAIL link: %s\n", log);
+        s_failures++;
+    }
+    return prog;
+}
+
+/* ---- Scenarios ---- */
+
+typedef struct {
+    GLuint prog;
+    GLint u_mvp, u_offset, u_color, u_tint;
+    GLuint vbo;
+    float verts[BENCH_VERTS * 4];
+} bench_t;
+
+typedef void (*frame_fn)(bench_t *b, int frame);
+
+static void frame_draws_static(bench_t *b, int frame) {
+    (void)frame;
+    glBindBuffer(GL_ARRAY_BUFFER, b->vbo);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, (const void *)0);
+    for (int i = 0; i < BENCH_DRAWS; i++) glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+static void frame_draws_state(bench_t *b, int frame) {
+    (void)frame;
+    glBindBuffer(GL_ARRAY_BUFFER, b->vbo);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, (const void *)0);
+    for (int i = 0; i < BENCH_DRAWS; i++) {
+        if (i & 1) glEnable(GL_BLEND); else glDisable(GL_BLEND);
+        glDepthFunc((i & 2) ? GL_LESS : GL_LEQUAL);
+        glScissor(i & 63, 0, 256, 256);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+    glDisable(GL_BLEND);
+}
+
+static void frame_uniforms(bench_t *b, int frame) {
+    static float mvp[16] = {1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1};
+    static float tint[16];
+    glBindBuffer(GL_ARRAY_BUFFER, b->vbo);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, (const void *)0);
+    for (int i = 0; i < BENCH_DRAWS; i++) {
+        mvp[12] = (float)i;
+        tint[i & 15] = (float)frame;
+        glUniformMatrix4fv(b->u_mvp, 1, GL_FALSE, mvp);
+        glUniform4f(b->u_offset, (float)i, 0.0f, 0.0f, 0.0f);
+        glUniform4f(b->u_color, 1.0f, 0.5f, 0.25f, 1.0f);
+        glUniform4fv(b->u_tint, 4, tint);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+}
+
+static void frame_client_arrays(bench_t *b, int frame) {
+    (void)frame;
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, b->verts);
+    for (int i = 0; i < BENCH_DRAWS / 4; i++) glDrawArrays(GL_TRIANGLE_STRIP, 0, BENCH_VERTS);
+}
+
+static void frame_client_indices(bench_t *b, int frame) {
+    static GLushort indices[BENCH_VERTS];
+    (void)frame;
+    for (int i = 0; i < BENCH_VERTS; i++) indices[i] = (GLushort)(BENCH_VERTS - 1 - i);
+    glBindBuffer(GL_ARRAY_BUFFER, b->vbo);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, (const void *)0);
+    for (int i = 0; i < BENCH_DRAWS / 4; i++) {
+        glDrawElements(GL_TRIANGLE_STRIP, BENCH_VERTS, GL_UNSIGNED_SHORT, indices);
+    }
+}
+
+/* CPU-written vertices straight into buffer memory, orphaned every batch */
+static void frame_mapped_stream(bench_t *b, int frame) {
+    glBindBuffer(GL_ARRAY_BUFFER, b->vbo);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, (const void *)0);
+    for (int i = 0; i < BENCH_DRAWS / 4; i++) {
+        float *dst = (float *)glMapBufferRangeEXT(GL_ARRAY_BUFFER, 0, sizeof(b->verts),
+                                                  GL_MAP_WRITE_BIT_EXT | GL_MAP_INVALIDATE_BUFFER_BIT_EXT);
+        if (!dst) return;
+        for (int v = 0; v < BENCH_VERTS * 4; v++) dst[v] = b->verts[v] + (float)frame;
+        glUnmapBufferOES(GL_ARRAY_BUFFER);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, BENCH_VERTS);
+    }
+}
+
+typedef struct {
+    const char *name;
+    frame_fn frame;
+    GLuint draws;       /* Expected draws per frame */
+} scenario_t;
+
+static const scenario_t s_scenarios[] = {
+    { "draws_static",        frame_draws_static,   BENCH_DRAWS },
+    { "draws_state_changes", frame_draws_state,    BENCH_DRAWS },
+    { "uniform_heavy",       frame_uniforms,       BENCH_DRAWS },
+    { "client_arrays",       frame_client_arrays,  BENCH_DRAWS / 4 },
+    { "client_indices",      frame_client_indices, BENCH_DRAWS / 4 },
+    { "mapped_stream",       frame_mapped_stream,  BENCH_DRAWS / 4 },
+};
+
+static void run_scenario(EGLDisplay dpy, EGLSurface surf, bench_t *b, const scenario_t *s) {
+    uint64_t total = 0;
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        uint64_t start = now_ns();
+        glClear(GL_COLOR_BUFFER_BIT);
+        s->frame(b, f);
+        total += now_ns() - start;
+        eglSwapBuffers(dpy, surf);
+    }
+    check_gl(s->name);
+
+    sgl_frame_stats_t stats;
+    sglGetFrameStats(&stats);
+    if (stats.draws != s->draws) {
+        printf("  FAIL %s: %u draws counted, expected %u\n", s->name, stats.draws, s->draws);
+        s_failures++;
+    }
+
+    double per_frame = (double)total / BENCH_FRAMES;
+    printf("%-22s %9.1f ns/draw %10.1f us/frame  binds: vtx=%u shader=%u blend=%u ds=%u"
+           "  uniform_bytes=%u client_bytes=%u\n",
+           s->name, per_frame / s->draws, per_frame / 1000.0, stats.vertex_binds,
+           stats.shader_binds, stats.blend_binds, stats.depth_stencil_binds,
+           stats.uniform_bytes, stats.client_array_bytes);
+}
+
+/* Static client arrays: copied every frame until promoted to a buffer */
+static void run_client_promotion(EGLDisplay dpy, EGLSurface surf, bench_t *b) {
+    sgl_frame_stats_t stats;
+    GLuint copied[BENCH_FRAMES];
+    sglSetClientArrayPromotion(2);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, b->verts);
+
+    uint64_t total = 0;
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        /* A rewrite halfway through demotes the array until it settles again */
+        if (f == BENCH_FRAMES / 2) b->verts[0] += 1.0f;
+        uint64_t start = now_ns();
+        for (int i = 0; i < BENCH_DRAWS / 4; i++) glDrawArrays(GL_TRIANGLE_STRIP, 0, BENCH_VERTS);
+        total += now_ns() - start;
+        eglSwapBuffers(dpy, surf);
+        sglGetFrameStats(&stats);
+        copied[f] = stats.client_array_bytes;
+    }
+    check_gl("client_promoted");
+
+    if (copied[0] == 0 || copied[4] != 0 || copied[BENCH_FRAMES / 2] == 0 ||
+        copied[BENCH_FRAMES - 1] != 0) {
+        printf("  FAIL client_promoted: bytes copied %u, %u, %u, %u\n", copied[0], copied[4],
+               copied[BENCH_FRAMES / 2], copied[BENCH_FRAMES - 1]);
+        s_failures++;
+    }
+
+    sglSetClientArrayPromotion(0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, (const void *)0);
+    printf("%-22s %9.1f ns/draw (client arrays promoted after 2 unchanged frames)\n",
+           "client_promoted", (double)total / BENCH_FRAMES / (BENCH_DRAWS / 4));
+}
+
+/* 8-bit element buffer feeding client arrays: indices widened once, the
+ * vertex range taken from the buffer's cached [min, max] */
+static void run_element_buffer(EGLDisplay dpy, EGLSurface surf, bench_t *b) {
+    static const GLubyte indices[6] = { 4, 5, 6, 5, 6, 7 };
+    static const GLubyte patch[3] = { 0, 1, 2 };
+    const GLuint vertex_bytes = 4 * sizeof(float);
+    sgl_frame_stats_t stats;
+    GLuint ebo;
+
+    glGenBuffers(1, &ebo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, b->verts);
+
+    uint64_t total = 0;
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        uint64_t start = now_ns();
+        for (int i = 0; i < BENCH_DRAWS / 4; i++) {
+            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_BYTE, (const void *)0);
+        }
+        total += now_ns() - start;
+        eglSwapBuffers(dpy, surf);
+    }
+    sglGetFrameStats(&stats);
+    GLuint whole = stats.client_array_bytes;
+
+    /* An update at upload time; a draw of part of the buffer copies only the
+     * vertices its own indices reference */
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 3, sizeof(patch), patch);
+    glDrawElements(GL_TRIANGLES, 3, GL_UNSIGNED_BYTE, (const void *)3);
+    eglSwapBuffers(dpy, surf);
+    sglGetFrameStats(&stats);
+    check_gl("element_buffer_u8");
+
+    /* Vertices [0, 8) copied per draw (the null backend copies from 0) */
+    if (whole != (BENCH_DRAWS / 4) * 8 * vertex_bytes || stats.client_array_bytes != 3 * vertex_bytes) {
+        printf("  FAIL element_buffer_u8: bytes copied %u, %u\n", whole, stats.client_array_bytes);
+        s_failures++;
+    }
+
+    glDeleteBuffers(1, &ebo);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, (const void *)0);
+    printf("%-22s %9.1f ns/draw (u8 EBO + client arrays, range from cached metadata)\n",
+           "element_buffer_u8", (double)total / BENCH_FRAMES / (BENCH_DRAWS / 4));
+}
+
+/* A static draw sequence recorded once and replayed with one call per frame;
+ * re-specifying a buffer it drew from makes the list stale */
+static void run_command_list(EGLDisplay dpy, EGLSurface surf, bench_t *b) {
+    sgl_frame_stats_t stats;
+    GLint binding = -1;
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    uint64_t start = now_ns();
+    GLuint list = sglBeginCommandList();
+    glBindBuffer(GL_ARRAY_BUFFER, b->vbo);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, (const void *)0);
+    for (int i = 0; i < BENCH_DRAWS; i++) {
+        glUniform4f(b->u_color, (float)i, 0.0f, 0.0f, 1.0f);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+    GLboolean recorded = sglEndCommandList();
+    uint64_t record = now_ns() - start;
+    check_gl("command_list");
+
+    /* Bindings made while recording stay in the list */
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &binding);
+    if (list == 0 || !recorded || binding != 0) {
+        printf("  FAIL command_list: list %u, recorded %d, binding %d\n", list, recorded, binding);
+        s_failures++;
+    }
+
+    uint64_t total = 0;
+    GLboolean called = GL_TRUE;
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        start = now_ns();
+        called &= sglCallCommandList(list);
+        total += now_ns() - start;
+        eglSwapBuffers(dpy, surf);
+    }
+    sglGetFrameStats(&stats);
+
+    /* Re-specifying the buffer invalidates the list */
+    glBindBuffer(GL_ARRAY_BUFFER, b->vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(b->verts), b->verts, GL_STATIC_DRAW);
+    GLboolean stale = sglCallCommandList(list);
+    sglDeleteCommandList(list);
+    check_gl("command_list");
+
+    if (!called || stats.draws != BENCH_DRAWS || stale) {
+        printf("  FAIL command_list: called %d, %u draws counted, stale list called %d\n",
+               called, stats.draws, stale);
+        s_failures++;
+    }
+
+    sglEndCommandList();
+    if (glGetError() != GL_INVALID_OPERATION) {
+        printf("  FAIL command_list: sglEndCommandList outside a recording\n");
+        s_failures++;
+    }
+
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, (const void *)0);
+    printf("%-22s %9.1f us/call (%u draws, recorded in %.1f us)\n", "command_list",
+           (double)total / BENCH_FRAMES / 1000.0, BENCH_DRAWS, (double)record / 1000.0);
+}
+
+static void run_link(void) {
+    uint64_t start = now_ns();
+    GLuint progs[BENCH_LINKS];
+    for (int i = 0; i < BENCH_LINKS; i++) progs[i] = build_program();
+    uint64_t total = now_ns() - start;
+    for (int i = 0; i < BENCH_LINKS; i++) glDeleteProgram(progs[i]);
+    check_gl("link_program");
+    printf("%-22s %9.1f us/link (transpile + link, null compiler)\n",
+           "link_program", (double)total / BENCH_LINKS / 1000.0);
+}
+
+/* The code of a deleted precompiled shader is released once no program can
+ * relink from it, and not before */
+static GLuint code_used(void) {
+    sgl_memory_stats_t stats;
+    sglGetMemoryStats(&stats);
+    return stats.heaps[SGL_MEMORY_HEAP_CODE].used;
+}
+
+static void run_shader_release(bench_t *b) {
+    GLuint used[4];
+    GLint linked[2] = { 0, 0 }, relinked[2] = { 0, 0 };
+
+    /* Precompiled stages: the null backend takes any bytes as code */
+    static uint8_t code[2][256];
+    memset(code[0], 0x11, sizeof(code[0]));
+    memset(code[1], 0x22, sizeof(code[1]));
+
+    used[0] = code_used();
+    uint64_t start = now_ns();
+    GLuint vs = glCreateShader(GL_VERTEX_SHADER);
+    GLuint fs = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderBinary(1, &vs, 0, code[0], sizeof(code[0]));
+    glShaderBinary(1, &fs, 0, code[1], sizeof(code[1]));
+    GLuint prog[2];
+    for (int i = 0; i < 2; i++) {
+        prog[i] = glCreateProgram();
+        glAttachShader(prog[i], vs);
+        glAttachShader(prog[i], fs);
+        glLinkProgram(prog[i]);
+        glGetProgramiv(prog[i], GL_LINK_STATUS, &linked[i]);
+    }
+    used[1] = code_used();
+
+    /* Still attached to both programs: both can relink, and the names stay
+     * taken until the last program lets go */
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+    GLint pending = GL_FALSE;
+    glGetShaderiv(vs, GL_DELETE_STATUS, &pending);
+    GLuint fresh = glCreateShader(GL_VERTEX_SHADER);
+    bool reserved = pending && fresh != vs && fresh != fs;
+    glDeleteShader(fresh);
+    glLinkProgram(prog[0]);
+    glGetProgramiv(prog[0], GL_LINK_STATUS, &relinked[0]);
+    used[2] = code_used();
+
+    /* Still attached to the second one */
+    glDeleteProgram(prog[0]);
+    glLinkProgram(prog[1]);
+    glGetProgramiv(prog[1], GL_LINK_STATUS, &relinked[1]);
+    glDeleteProgram(prog[1]);
+    used[3] = code_used();
+    uint64_t total = now_ns() - start;
+
+    glUseProgram(b->prog);
+    check_gl("shader_release");
+
+    if (!linked[0] || !linked[1] || !relinked[0] || !relinked[1] || !reserved || glIsShader(vs) ||
+        used[1] != used[0] + 6 * 256 || used[2] != used[1] || used[3] != used[0]) {
+        printf("  FAIL shader_release: linked %d/%d, relinked %d/%d, reserved %d, code bytes %u -> %u -> %u -> %u\n",
+               linked[0], linked[1], relinked[0], relinked[1], reserved, used[0], used[1], used[2], used[3]);
+        s_failures++;
+    }
+    printf("%-22s %9.1f us/cycle (load, link twice, delete)\n", "shader_release",
+           (double)total / 1000.0);
+}
+
+/* Uniform storage is allocated when a program hands out its first location:
+ * values written before any draw read back, and a program reusing a deleted
+ * one's slot starts from zero */
+static void run_uniform_storage(bench_t *b) {
+    GLfloat color[4] = { 0 }, tint[4] = { 0 }, offset[4] = { 0 };
+    bool kept = true, zeroed = true;
+
+    uint64_t start = now_ns();
+    for (int i = 0; i < BENCH_LINKS; i++) {
+        GLuint prog = build_program();
+        glUseProgram(prog);
+        GLint u_offset = glGetUniformLocation(prog, "u_offset");
+        glGetUniformfv(prog, u_offset, offset);
+        zeroed &= offset[0] == 0.0f;
+        glUniform4f(u_offset, 9.0f, 0.0f, 0.0f, 0.0f);
+
+        GLint u_color = glGetUniformLocation(prog, "u_color");
+        glUniform4f(u_color, (float)i, 0.5f, 0.25f, 1.0f);
+        GLint u_tint = glGetUniformLocation(prog, "u_tint");
+        const GLfloat tints[8] = { 2.0f, 0.0f, 0.0f, 0.0f, 3.0f, 0.0f, 0.0f, 0.0f };
+        glUniform4fv(u_tint, 2, tints);
+        glGetUniformfv(prog, u_color, color);
+        glGetUniformfv(prog, u_tint, tint);
+        kept &= color[0] == (float)i && tint[0] == 2.0f;
+        glDeleteProgram(prog);
+    }
+    uint64_t total = now_ns() - start;
+    glUseProgram(b->prog);
+    check_gl("uniform_storage");
+
+    if (!kept || !zeroed) {
+        printf("  FAIL uniform_storage: read back u_color %.2f, u_tint %.2f, unset u_offset %.2f\n",
+               color[0], tint[0], offset[0]);
+        s_failures++;
+    }
+    printf("%-22s %9.1f us/program (link + first uniform writes)\n",
+           "uniform_storage", (double)total / BENCH_LINKS / 1000.0);
+}
+
+/* Programs saved into a bundle (sgl_bundle.h, as tools/shader_bundle writes
+ * it) and loaded back with sglLoadShaderBundle */
+static void run_shader_bundle(bench_t *b) {
+    static const char *path = "/tmp/bench_gl_shaders.sglb";
+    sgl_bundle_writer_t *writer = sgl_bundle_create(path);
+    GLint u_color = -1;
+    bool added = writer != NULL;
+    for (int i = 0; i < BENCH_LINKS && added; i++) {
+        static uint8_t binary[64 * 1024];
+        GLuint prog = build_program();
+        if (i == 0) u_color = glGetUniformLocation(prog, "u_color");
+        GLsizei length = 0;
+        GLenum format = 0;
+        glGetProgramBinaryOES(prog, sizeof(binary), &length, &format, binary);
+        char name[32];
+        snprintf(name, sizeof(name), "prog%d", i);
+        added = length > 0 && sgl_bundle_add(writer, name, format, binary, (uint32_t)length);
+        glDeleteProgram(prog);
+    }
+    if (!writer || !sgl_bundle_finish(writer) || !added) {
+        printf("  FAIL shader_bundle: cannot write %s\n", path);
+        s_failures++;
+        return;
+    }
+
+    uint64_t start = now_ns();
+    GLint loaded = sglLoadShaderBundle(path);
+    uint64_t total = now_ns() - start;
+
+    char past_end[32];
+    snprintf(past_end, sizeof(past_end), "prog%d", BENCH_LINKS);
+    GLuint prog = sglGetShaderBundleProgram("prog0");
+    if (loaded != BENCH_LINKS || !prog || sglGetShaderBundleProgram(past_end) != 0 ||
+        glGetUniformLocation(prog, "u_color") != u_color || glGetAttribLocation(prog, "a_texcoord") != 1) {
+        printf("  FAIL shader_bundle: %d programs loaded, prog0=%u\n", loaded, prog);
+        s_failures++;
+    }
+
+    /* A draw with a loaded program; a reload keeps the program names */
+    glUseProgram(prog);
+    glUniform4f(u_color, 1.0f, 0.5f, 0.25f, 1.0f);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    if (sglLoadShaderBundle(path) != BENCH_LINKS || sglGetShaderBundleProgram("prog0") != prog ||
+        sglLoadShaderBundle("/tmp/bench_gl_missing.sglb") != -1) {
+        printf("  FAIL shader_bundle: reload\n");
+        s_failures++;
+    }
+    for (int i = 0; i < BENCH_LINKS; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "prog%d", i);
+        glDeleteProgram(sglGetShaderBundleProgram(name));
+    }
+    if (sglGetShaderBundleProgram("prog0") != 0) {
+        printf("  FAIL shader_bundle: deleted program still found\n");
+        s_failures++;
+    }
+    remove(path);
+    check_gl("shader_bundle");
+
+    glUseProgram(b->prog);
+    printf("%-22s %9.1f us/program (bundle load, no transpile or compile)\n",
+           "shader_bundle", (double)total / BENCH_LINKS / 1000.0);
+}
+
+static void run_objects(void) {
+    static GLuint tex[BENCH_OBJECTS], buf[BENCH_OBJECTS];
+    static const GLubyte texel[4] = { 255, 255, 255, 255 };
+
+    uint64_t start = now_ns();
+    glGenTextures(BENCH_OBJECTS, tex);
+    glGenBuffers(BENCH_OBJECTS, buf);
+    for (int i = 0; i < BENCH_OBJECTS; i++) {
+        glBindTexture(GL_TEXTURE_2D, tex[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, texel);
+        glBindBuffer(GL_ARRAY_BUFFER, buf[i]);
+        glBufferData(GL_ARRAY_BUFFER, 16, NULL, GL_STATIC_DRAW);
+    }
+    glDeleteTextures(BENCH_OBJECTS, tex);
+    glDeleteBuffers(BENCH_OBJECTS, buf);
+    uint64_t total = now_ns() - start;
+    check_gl("object_churn");
+
+    for (int i = 0; i < BENCH_OBJECTS; i++) {
+        if (tex[i] == 0 || buf[i] == 0) {
+            printf("  FAIL object_churn: name %d not allocated\n", i);
+            s_failures++;
+            break;
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    printf("%-22s %9.1f ns/object (gen + specify + delete, texture and buffer)\n",
+           "object_churn", (double)total / (2 * BENCH_OBJECTS));
+}
+
+/* Buffer storage shows up in the buffer heap's usage and in the NVX totals */
+static void run_memory_stats(void) {
+    enum { COUNT = 4, SIZE = 64 * 1024 };
+    sgl_memory_stats_t before, during, after;
+    GLint avail_before = 0, avail_during = 0, total = 0;
+    GLuint buf[COUNT];
+
+    sglGetMemoryStats(&before);
+    glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &avail_before);
+    glGenBuffers(COUNT, buf);
+    for (int i = 0; i < COUNT; i++) {
+        glBindBuffer(GL_ARRAY_BUFFER, buf[i]);
+        glBufferData(GL_ARRAY_BUFFER, SIZE, NULL, GL_STATIC_DRAW);
+    }
+
+    uint64_t start = now_ns();
+    for (int i = 0; i < BENCH_LINKS; i++) sglGetMemoryStats(&during);
+    uint64_t elapsed = now_ns() - start;
+    glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &avail_during);
+    glGetIntegerv(GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX, &total);
+
+    glDeleteBuffers(COUNT, buf);
+    sglGetMemoryStats(&after);
+    check_gl("memory_stats");
+
+    const sgl_memory_heap_stats_t *h0 = &before.heaps[SGL_MEMORY_HEAP_BUFFER];
+    const sgl_memory_heap_stats_t *h1 = &during.heaps[SGL_MEMORY_HEAP_BUFFER];
+    const sgl_memory_heap_stats_t *h2 = &after.heaps[SGL_MEMORY_HEAP_BUFFER];
+    if (h1->used != h0->used + COUNT * SIZE || h1->peak < h1->used || h2->used != h0->used ||
+        h2->peak != h1->peak || h1->failed_allocs != 0 || h1->capacity == 0) {
+        printf("  FAIL memory_stats: buffer heap used %u -> %u -> %u, peak %u\n",
+               h0->used, h1->used, h2->used, h2->peak);
+        s_failures++;
+    }
+    if (avail_before - avail_during != COUNT * SIZE / 1024 || total < avail_before) {
+        printf("  FAIL memory_stats: NVX available %d -> %d KB of %d KB\n", avail_before, avail_during, total);
+        s_failures++;
+    }
+    printf("%-22s %9.1f ns/query (%d of %d KB available)\n",
+           "memory_stats", (double)elapsed / BENCH_LINKS, avail_before, total);
+}
+
+/* Dynamic environment map: render all six faces, then mip the cubemap, every frame */
+static void run_env_cubemap(void) {
+    GLuint cube, fbo;
+    glGenTextures(1, &cube);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, cube);
+    for (int face = 0; face < 6; face++) {
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGBA, 128, 128, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    }
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+    uint64_t start = now_ns();
+    for (int frame = 0; frame < BENCH_FRAMES; frame++) {
+        for (int face = 0; face < 6; face++) {
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                   GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, cube, 0);
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
+        glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    }
+    uint64_t total = now_ns() - start;
+    check_gl("env_cubemap");
+
+    GLint face = 0;
+    glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                          GL_FRAMEBUFFER_ATTACHMENT_TEXTURE_CUBE_MAP_FACE, &face);
+    if (face != GL_TEXTURE_CUBE_MAP_NEGATIVE_Z) {
+        printf("  FAIL env_cubemap: attachment face 0x%x\n", face);
+        s_failures++;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteTextures(1, &cube);
+    printf("%-22s %9.1f us/frame (6 face renders + glGenerateMipmap)\n",
+           "env_cubemap", (double)total / BENCH_FRAMES / 1000.0);
+}
+
+/* Bloom-style downsample chain: each level is a linear blit of the previous one */
+#define BLIT_LEVELS 5
+
+static void run_blit_chain(void) {
+    GLuint tex[BLIT_LEVELS], fbo[BLIT_LEVELS];
+    glGenTextures(BLIT_LEVELS, tex);
+    glGenFramebuffers(BLIT_LEVELS, fbo);
+    for (int i = 0; i < BLIT_LEVELS; i++) {
+        glBindTexture(GL_TEXTURE_2D, tex[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1280 >> (i + 1), 720 >> (i + 1), 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex[i], 0);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    uint64_t start = now_ns();
+    for (int frame = 0; frame < BENCH_FRAMES; frame++) {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        for (int i = 0; i < BLIT_LEVELS; i++) {
+            GLint src_w = 1280 >> i, src_h = 720 >> i;
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo[i]);
+            glBlitFramebufferANGLE(0, 0, src_w, src_h, 0, 0, src_w / 2, src_h / 2,
+                                   GL_COLOR_BUFFER_BIT, GL_LINEAR);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo[i]);
+        }
+    }
+    uint64_t total = now_ns() - start;
+    check_gl("blit_chain");
+
+    /* Separate read binding; blitting a framebuffer onto itself is an error */
+    GLint read = 0, draw = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING_ANGLE, &read);
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &draw);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo[BLIT_LEVELS - 1]);
+    glBlitFramebufferNV(0, 0, 1, 1, 0, 0, 1, 1, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    if ((GLuint)read != fbo[BLIT_LEVELS - 1] || (GLuint)draw != fbo[BLIT_LEVELS - 1] ||
+        glGetError() != GL_INVALID_OPERATION) {
+        printf("  FAIL blit_chain: bindings %d/%d or self blit accepted\n", read, draw);
+        s_failures++;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(BLIT_LEVELS, fbo);
+    glDeleteTextures(BLIT_LEVELS, tex);
+    printf("%-22s %9.1f us/frame (%d-level linear downsample)\n",
+           "blit_chain", (double)total / BENCH_FRAMES / 1000.0, BLIT_LEVELS);
+}
+
+/* Deferred G-buffer pass: four color attachments written by one draw,
+ * the two scratch ones discarded at the end of the pass */
+static void run_gbuffer(const bench_t *b) {
+    static const GLenum bufs[4] = {
+        GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1_EXT,
+        GL_COLOR_ATTACHMENT2_EXT, GL_COLOR_ATTACHMENT3_EXT
+    };
+    GLuint tex[4], fbo;
+    glGenTextures(4, tex);
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    for (int i = 0; i < 4; i++) {
+        glBindTexture(GL_TEXTURE_2D, tex[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 640, 360, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, bufs[i], GL_TEXTURE_2D, tex[i], 0);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDrawBuffersEXT(4, bufs);
+    glBindBuffer(GL_ARRAY_BUFFER, b->vbo);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, (const void *)0);
+
+    uint64_t start = now_ns();
+    for (int frame = 0; frame < BENCH_FRAMES; frame++) {
+        glClear(GL_COLOR_BUFFER_BIT);
+        for (int d = 0; d < BENCH_DRAWS; d++) {
+            glUniform4f(b->u_offset, (float)d, 0.0f, 0.0f, 0.0f);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+        }
+        glDiscardFramebufferEXT(GL_FRAMEBUFFER, 2, &bufs[2]);
+    }
+    uint64_t total = now_ns() - start;
+    check_gl("gbuffer");
+
+    /* FBOs take attachment points, not the default framebuffer's buffer names */
+    const GLenum color = GL_COLOR_EXT;
+    glDiscardFramebufferEXT(GL_FRAMEBUFFER, 1, &color);
+    if (glGetError() != GL_INVALID_ENUM) {
+        printf("  FAIL gbuffer: discard of GL_COLOR_EXT on an FBO accepted\n");
+        s_failures++;
+    }
+
+    /* Entry i must name attachment i; the default framebuffer takes GL_BACK only */
+    GLint draw3 = 0, max = 0;
+    glGetIntegerv(GL_DRAW_BUFFER3_EXT, &draw3);
+    glGetIntegerv(GL_MAX_DRAW_BUFFERS_EXT, &max);
+    const GLenum swapped[2] = { GL_COLOR_ATTACHMENT1_EXT, GL_COLOR_ATTACHMENT0 };
+    glDrawBuffersEXT(2, swapped);
+    GLenum err = glGetError();
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDrawBuffersEXT(1, bufs);
+    if (draw3 != GL_COLOR_ATTACHMENT3_EXT || max < 4 || err != GL_INVALID_OPERATION ||
+        glGetError() != GL_INVALID_OPERATION) {
+        printf("  FAIL gbuffer: draw buffer %d, max %d or bad lists accepted\n", draw3, max);
+        s_failures++;
+    }
+
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteTextures(4, tex);
+    printf("%-22s %9.1f us/frame (%d draws into 4 targets)\n",
+           "gbuffer", (double)total / BENCH_FRAMES / 1000.0, BENCH_DRAWS);
+}
+
+/* Shadow map: depth-only FBO rendered into, then sampled by the main pass */
+static void run_shadow_map(const bench_t *b) {
+    GLuint depth, fbo;
+    glGenTextures(1, &depth);
+    glBindTexture(GL_TEXTURE_2D, depth);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, 1024, 1024, 0,
+                 GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth, 0);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindBuffer(GL_ARRAY_BUFFER, b->vbo);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, (const void *)0);
+
+    uint64_t start = now_ns();
+    for (int frame = 0; frame < BENCH_FRAMES; frame++) {
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        for (int d = 0; d < BENCH_DRAWS / 2; d++) glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        for (int d = 0; d < BENCH_DRAWS / 2; d++) glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+    uint64_t total = now_ns() - start;
+    check_gl("shadow_map");
+
+    /* Depth textures have no mip chain and are not color attachments */
+    glGenerateMipmap(GL_TEXTURE_2D);
+    GLenum mip_err = glGetError();
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, depth, 0);
+    GLenum color_status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE || mip_err != GL_INVALID_OPERATION ||
+        color_status != GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT) {
+        printf("  FAIL shadow_map: status 0x%x, mipmap 0x%x, as color 0x%x\n",
+               status, mip_err, color_status);
+        s_failures++;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteTextures(1, &depth);
+    printf("%-22s %9.1f us/frame (depth-only pass + sampling pass)\n",
+           "shadow_map", (double)total / BENCH_FRAMES / 1000.0);
+}
+
+/* Compact meshes: half-float positions and 2_10_10_10 normals from one VBO */
+static void run_packed_attribs(const bench_t *b) {
+    glBindBuffer(GL_ARRAY_BUFFER, b->vbo);
+    glVertexAttribPointer(0, 4, GL_HALF_FLOAT_OES, GL_FALSE, 12, (const void *)0);
+    glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, 12, (const void *)8);
+    glEnableVertexAttribArray(1);
+
+    uint64_t start = now_ns();
+    for (int frame = 0; frame < BENCH_FRAMES; frame++) {
+        for (int d = 0; d < BENCH_DRAWS / 4; d++) glDrawArrays(GL_TRIANGLE_STRIP, 0, BENCH_VERTS / 3);
+    }
+    uint64_t total = now_ns() - start;
+    check_gl("packed_attribs");
+
+    /* Packed types always carry four components */
+    glVertexAttribPointer(1, 3, GL_UNSIGNED_INT_2_10_10_10_REV, GL_TRUE, 0, (const void *)0);
+    GLenum size_err = glGetError();
+    GLint type = 0;
+    glGetVertexAttribiv(1, GL_VERTEX_ATTRIB_ARRAY_TYPE, &type);
+    if (size_err != GL_INVALID_OPERATION || type != GL_INT_2_10_10_10_REV) {
+        printf("  FAIL packed_attribs: size 3 error 0x%x, type 0x%x\n", size_err, type);
+        s_failures++;
+    }
+
+    glDisableVertexAttribArray(1);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, (const void *)0);
+    printf("%-22s %9.1f us/frame (half-float + 2_10_10_10 attributes)\n",
+           "packed_attribs", (double)total / BENCH_FRAMES / 1000.0);
+}
+
+/* 16-bit textures keep their packed layout: updates must use the same type */
+static void run_packed_textures(void) {
+    static const GLenum formats[3] = { GL_RGB, GL_RGBA, GL_RGBA };
+    static const GLenum types[3] = { GL_UNSIGNED_SHORT_5_6_5, GL_UNSIGNED_SHORT_4_4_4_4,
+                                     GL_UNSIGNED_SHORT_5_5_5_1 };
+    static GLushort texels[64 * 64];
+    static GLubyte bytes[64 * 64 * 4];
+    GLuint tex[4];
+
+    glGenTextures(4, tex);
+    uint64_t start = now_ns();
+    for (int i = 0; i < 3; i++) {
+        glBindTexture(GL_TEXTURE_2D, tex[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, formats[i], 64, 64, 0, formats[i], types[i], texels);
+        for (int f = 0; f < BENCH_FRAMES; f++) {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 64, 64, formats[i], types[i], texels);
+        }
+    }
+    uint64_t total = now_ns() - start;
+    check_gl("packed_textures");
+
+    /* An 8-bit update of a 16-bit texture, and a 16-bit update of an 8-bit one */
+    glBindTexture(GL_TEXTURE_2D, tex[0]);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 8, 8, GL_RGB, GL_UNSIGNED_BYTE, bytes);
+    GLenum widened = glGetError();
+    glBindTexture(GL_TEXTURE_2D, tex[3]);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 64, 64, 0, GL_RGBA, GL_UNSIGNED_BYTE, bytes);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 8, 8, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, texels);
+    GLenum packed = glGetError();
+    if (widened != GL_INVALID_OPERATION || packed != GL_INVALID_OPERATION) {
+        printf("  FAIL packed_textures: mismatched updates raised 0x%x, 0x%x\n", widened, packed);
+        s_failures++;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDeleteTextures(4, tex);
+    printf("%-22s %9.1f ns/upload (64x64 565, 4444 and 5551 sub-images)\n", "packed_textures",
+           (double)total / (3 * BENCH_FRAMES));
+}
+
+/* Mip levels specified one by one: they keep the level 0 size, and updates
+ * are bounded by their own level's size */
+static void run_mip_levels(void) {
+    static GLubyte texels[64 * 32 * 4];
+    GLuint tex;
+    GLenum errors[4];
+
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    uint64_t start = now_ns();
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        for (int level = 0; level <= 6; level++) {
+            GLsizei w = 64 >> level, h = 32 >> level;
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, w, h ? h : 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+        }
+    }
+    uint64_t total = now_ns() - start;
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 64, 32, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+    glTexSubImage2D(GL_TEXTURE_2D, 1, 0, 0, 32, 16, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+    glTexSubImage2D(GL_TEXTURE_2D, 6, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+    check_gl("mip_levels");
+
+    glTexSubImage2D(GL_TEXTURE_2D, 1, 0, 0, 64, 32, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+    errors[0] = glGetError();
+    glTexSubImage2D(GL_TEXTURE_2D, 2, 8, 0, 16, 8, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+    errors[1] = glGetError();
+    glTexSubImage2D(GL_TEXTURE_2D, 5, 0, 0, 2, 2, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+    errors[2] = glGetError();
+    glTexSubImage2D(GL_TEXTURE_2D, 7, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+    errors[3] = glGetError();
+    for (int i = 0; i < 4; i++) {
+        if (errors[i] != GL_INVALID_VALUE) {
+            printf("  FAIL mip_levels: update %d past its level raised 0x%x\n", i, errors[i]);
+            s_failures++;
+        }
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDeleteTextures(1, &tex);
+    printf("%-22s %9.1f ns/level (64x32 chain specified level by level)\n", "mip_levels",
+           (double)total / (7 * BENCH_FRAMES));
+}
+
+static void run_syncs(EGLDisplay dpy) {
+    uint64_t start = now_ns();
+    for (int i = 0; i < BENCH_OBJECTS; i++) {
+        GLsync sync = glFenceSyncAPPLE(GL_SYNC_GPU_COMMANDS_COMPLETE_APPLE, 0);
+        GLenum r = glClientWaitSyncAPPLE(sync, GL_SYNC_FLUSH_COMMANDS_BIT_APPLE, GL_TIMEOUT_IGNORED_APPLE);
+        if (r != GL_ALREADY_SIGNALED_APPLE && r != GL_CONDITION_SATISFIED_APPLE) {
+            printf("  FAIL fence_sync: wait returned 0x%x\n", r);
+            s_failures++;
+            break;
+        }
+        glDeleteSyncAPPLE(sync);
+    }
+    uint64_t total = now_ns() - start;
+    check_gl("fence_sync");
+
+    /* Deleted syncs are gone; EGL fences come from the same pool */
+    GLsync sync = glFenceSyncAPPLE(GL_SYNC_GPU_COMMANDS_COMPLETE_APPLE, 0);
+    glDeleteSyncAPPLE(sync);
+    if (glIsSyncAPPLE(sync) || (glDeleteSyncAPPLE(sync), glGetError()) != GL_INVALID_VALUE) {
+        printf("  FAIL fence_sync: deleted sync still valid\n");
+        s_failures++;
+    }
+    EGLSyncKHR egl_sync = eglCreateSyncKHR(dpy, EGL_SYNC_FENCE_KHR, NULL);
+    EGLint status = 0;
+    if (egl_sync == EGL_NO_SYNC_KHR ||
+        eglClientWaitSyncKHR(dpy, egl_sync, 0, EGL_FOREVER_KHR) != EGL_CONDITION_SATISFIED_KHR ||
+        !eglGetSyncAttribKHR(dpy, egl_sync, EGL_SYNC_STATUS_KHR, &status) || status != EGL_SIGNALED_KHR ||
+        !eglDestroySyncKHR(dpy, egl_sync)) {
+        printf("  FAIL fence_sync: EGL fence (0x%04x)\n", eglGetError());
+        s_failures++;
+    }
+
+    printf("%-22s %9.1f ns/fence (create + client wait + delete)\n",
+           "fence_sync", (double)total / BENCH_OBJECTS);
+}
+
+/* Per-call callback of the capture_replay scenario */
+static void count_replayed_draws(const sgl_replay_call_t *call, void *user) {
+    if (call->draw) (*(GLuint *)user)++;
+}
+
+/* A small scene captured to a file for a few frames, then played back on
+ * the same context with its objects created anew */
+static void run_capture_replay(EGLDisplay dpy, EGLSurface surf, bench_t *b) {
+    static const char *path = "/tmp/bench_gl_trace.bin";
+    static const GLushort indices[6] = { 0, 1, 2, 2, 1, 3 };
+    static const float texcoords[8] = { 0, 0, 1, 0, 0, 1, 1, 1 };
+    static uint8_t texels[16 * 16 * 4];
+    const int frames = 4;
+    const GLuint draws = 17;    /* 16 buffer draws + 1 client array draw per frame */
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glUseProgram(0);
+    if (!sglBeginCapture(path) || sglBeginCapture(path) || glGetError() != GL_INVALID_OPERATION) {
+        printf("  FAIL capture_replay: sglBeginCapture\n");
+        s_failures++;
+        sglEndCapture();
+        return;
+    }
+
+    GLuint prog = build_program();
+    GLint u_mvp = glGetUniformLocation(prog, "u_mvp");
+    GLint u_color = glGetUniformLocation(prog, "u_color");
+    GLuint vbo, tex;
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(b->verts), b->verts, GL_STATIC_DRAW);
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 16, 16, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+
+    for (int f = 0; f < frames; f++) {
+        static const float mvp[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+        glClear(GL_COLOR_BUFFER_BIT);
+        glUseProgram(prog);
+        glUniformMatrix4fv(u_mvp, 1, GL_FALSE, mvp);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, (const void *)0);
+        for (int i = 0; i < 16; i++) {
+            glUniform4f(u_color, (float)i, (float)f, 0.0f, 1.0f);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, texcoords);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, b->verts);
+        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, indices);
+        glDisableVertexAttribArray(1);
+        eglSwapBuffers(dpy, surf);
+    }
+    glDeleteTextures(1, &tex);
+    glDeleteBuffers(1, &vbo);
+    glDeleteProgram(prog);
+    sglEndCapture();
+    check_gl("capture_replay");
+
+    /* Replay on the same context; the objects above are gone */
+    sgl_replay_t *replay = sglReplayOpen(path);
+    GLuint replayed = 0;
+    int played = 0;
+    uint64_t cpu_ns = 0;
+    sgl_replay_stats_t stats;
+    sglReplaySetCallback(replay, count_replayed_draws, &replayed);
+    while (sglReplayFrame(replay, &stats)) {
+        sgl_frame_stats_t frame;
+        eglSwapBuffers(dpy, surf);
+        sglGetFrameStats(&frame);
+        /* The deletes after the last swap replay as a final frame without draws */
+        if (stats.frame < (GLuint)frames && (stats.draws != draws || frame.draws != draws)) {
+            printf("  FAIL capture_replay: frame %u replayed %u draws, %u reached the backend\n",
+                   stats.frame, stats.draws, frame.draws);
+            s_failures++;
+        }
+        if (stats.frame < (GLuint)frames) cpu_ns += stats.cpu_ns;
+        played++;
+    }
+    sglReplayClose(replay);
+    check_gl("capture_replay");
+    remove(path);
+
+    if (!replay || played != frames + 1 || replayed != frames * draws) {
+        printf("  FAIL capture_replay: %d frames, %u draws replayed\n", played, replayed);
+        s_failures++;
+    }
+
+    glUseProgram(b->prog);
+    glBindBuffer(GL_ARRAY_BUFFER, b->vbo);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, (const void *)0);
+    printf("%-22s %9.1f us/frame (%u draws, CPU time of the replayed calls)\n",
+           "capture_replay", (double)cpu_ns / frames / 1000.0, draws);
+}
+
+/* Upload thread of the shared_upload scenario: a shared context current
+ * without a surface creates objects the main context then uses */
+typedef struct {
+    EGLDisplay dpy;
+    EGLContext ctx;
+    EGLContext main_ctx;
+    GLuint prog;
+    GLuint textures[64];
+    GLuint buffers[64];
+    uint64_t ns;
+    bool ok;
+} upload_job_t;
+
+static void *upload_thread(void *arg) {
+    upload_job_t *job = (upload_job_t *)arg;
+    static uint8_t texels[64 * 64 * 4];
+
+    /* The main context is current on the main thread */
+    if (eglMakeCurrent(job->dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, job->main_ctx) ||
+        eglGetError() != EGL_BAD_ACCESS) {
+        return NULL;
+    }
+    if (!eglMakeCurrent(job->dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, job->ctx) ||
+        eglGetCurrentContext() != job->ctx) {
+        return NULL;
+    }
+
+    uint64_t start = now_ns();
+    glGenTextures(64, job->textures);
+    glGenBuffers(64, job->buffers);
+    for (int i = 0; i < 64; i++) {
+        glBindTexture(GL_TEXTURE_2D, job->textures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 64, 64, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+        glBindBuffer(GL_ARRAY_BUFFER, job->buffers[i]);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(texels), texels, GL_STATIC_DRAW);
+    }
+    /* Draws and clears are dropped, not errors */
+    glUseProgram(job->prog);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glFinish();
+    job->ns = now_ns() - start;
+    job->ok = glGetError() == GL_NO_ERROR;
+
+    eglMakeCurrent(job->dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    return NULL;
+}
+
+static void run_shared_upload(EGLDisplay dpy, EGLConfig config, EGLContext main_ctx, bench_t *b) {
+    static const EGLint context_attribs[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
+    upload_job_t job = { .dpy = dpy, .main_ctx = main_ctx, .prog = b->prog };
+    job.ctx = eglCreateContext(dpy, config, main_ctx, context_attribs);
+    if (job.ctx == EGL_NO_CONTEXT) {
+        printf("  FAIL shared_upload: shared context (0x%04x)\n", eglGetError());
+        s_failures++;
+        return;
+    }
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, upload_thread, &job);
+    pthread_join(thread, NULL);
+    if (!job.ok) {
+        printf("  FAIL shared_upload: upload thread\n");
+        s_failures++;
+    }
+
+    /* The objects are the main context's too, and it still renders */
+    for (int i = 0; i < 64; i++) {
+        if (!glIsTexture(job.textures[i]) || !glIsBuffer(job.buffers[i])) {
+            printf("  FAIL shared_upload: object %d not shared\n", i);
+            s_failures++;
+            break;
+        }
+    }
+    if (eglGetCurrentContext() != main_ctx) {
+        printf("  FAIL shared_upload: main thread lost its context\n");
+        s_failures++;
+    }
+    glBindTexture(GL_TEXTURE_2D, job.textures[0]);
+    glBindBuffer(GL_ARRAY_BUFFER, b->vbo);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glDeleteTextures(64, job.textures);
+    glDeleteBuffers(64, job.buffers);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    check_gl("shared_upload");
+
+    /* Names outlive the shared context, the group outlives it too */
+    eglDestroyContext(dpy, job.ctx);
+    if (glIsTexture(b->prog) || !glIsProgram(b->prog)) {
+        printf("  FAIL shared_upload: share group torn down with the shared context\n");
+        s_failures++;
+    }
+
+    printf("%-22s %9.1f us/object (64 textures + 64 buffers on a shared context)\n",
+           "shared_upload", (double)job.ns / 1000.0 / 128);
+}
+
+/* Heap sizes: sglSetHeapConfig for every new context, EGL attributes per context */
+static void run_heap_config(EGLDisplay dpy, EGLConfig config, EGLSurface surf, EGLContext main_ctx) {
+    static const EGLint plain_attribs[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
+    static const EGLint sized_attribs[] = { EGL_CONTEXT_CLIENT_VERSION, 2,
+                                            EGL_HEAP_DATA_SIZE_SGL, 3 * 1024 * 1024,
+                                            EGL_HEAP_FIXED_SIZE_SGL, EGL_TRUE, EGL_NONE };
+    static const EGLint bad_attribs[] = { EGL_CONTEXT_CLIENT_VERSION, 2,
+                                          EGL_HEAP_TEXTURE_SIZE_SGL, -1, EGL_NONE };
+    const sgl_heap_config_t small = { .data_size = 2 * 1024 * 1024 };
+    const EGLint *attribs[2] = { plain_attribs, sized_attribs };
+    const GLuint expected[2] = { 2 * 1024 * 1024, 3 * 1024 * 1024 };
+
+    sglSetHeapConfig(&small);
+    uint64_t start = now_ns();
+    for (int i = 0; i < 2; i++) {
+        EGLContext ctx = eglCreateContext(dpy, config, EGL_NO_CONTEXT, attribs[i]);
+        sgl_memory_stats_t stats;
+        memset(&stats, 0, sizeof(stats));
+        if (ctx != EGL_NO_CONTEXT && eglMakeCurrent(dpy, surf, surf, ctx)) sglGetMemoryStats(&stats);
+        GLuint capacity = stats.heaps[SGL_MEMORY_HEAP_BUFFER].capacity;
+        if (capacity != expected[i]) {
+            printf("  FAIL heap_config: context %d buffer heap %u bytes, expected %u\n", i, capacity, expected[i]);
+            s_failures++;
+        }
+        eglMakeCurrent(dpy, surf, surf, main_ctx);
+        if (ctx != EGL_NO_CONTEXT) eglDestroyContext(dpy, ctx);
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    if (eglCreateContext(dpy, config, EGL_NO_CONTEXT, bad_attribs) != EGL_NO_CONTEXT ||
+        eglGetError() != EGL_BAD_ATTRIBUTE) {
+        printf("  FAIL heap_config: negative heap size accepted\n");
+        s_failures++;
+    }
+    sglSetHeapConfig(NULL);
+    check_gl("heap_config");
+
+    printf("%-22s %9.1f us/context (2 MB and 3 MB data heaps)\n", "heap_config", (double)elapsed / 1000.0 / 2);
+}
+
+/* EGL_SHARED_DEPTH_BUFFER_SGL: on by default, off on request, reported by
+ * eglQuerySurface (the host surfaces have no depth buffers to share) */
+static void run_surface_depth(EGLDisplay dpy, EGLConfig config, EGLSurface surf, EGLContext main_ctx) {
+    static const EGLint per_slot_attribs[] = { EGL_SHARED_DEPTH_BUFFER_SGL, EGL_FALSE, EGL_NONE };
+    const EGLint *attribs[2] = { NULL, per_slot_attribs };
+    const EGLint expected[2] = { EGL_TRUE, EGL_FALSE };
+
+    uint64_t start = now_ns();
+    for (int i = 0; i < 2; i++) {
+        EGLSurface window = eglCreateWindowSurface(dpy, config, (EGLNativeWindowType)0, attribs[i]);
+        EGLint shared = -1;
+        bool swapped = window != EGL_NO_SURFACE && eglMakeCurrent(dpy, window, window, main_ctx);
+        for (int f = 0; f < 3 && swapped; f++) {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            swapped = eglSwapBuffers(dpy, window);
+        }
+        eglMakeCurrent(dpy, surf, surf, main_ctx);
+        if (window == EGL_NO_SURFACE || !eglQuerySurface(dpy, window, EGL_SHARED_DEPTH_BUFFER_SGL, &shared) ||
+            shared != expected[i] || !swapped) {
+            printf("  FAIL surface_depth: surface %d shared depth %d, swapped %d\n", i, shared, swapped);
+            s_failures++;
+        }
+        if (window != EGL_NO_SURFACE) eglDestroySurface(dpy, window);
+    }
+    uint64_t elapsed = now_ns() - start;
+    check_gl("surface_depth");
+
+    printf("%-22s %9.1f us/surface (create, 3 frames, destroy)\n", "surface_depth",
+           (double)elapsed / 1000.0 / 2);
+}
+
+/* sglSetRenderResolution / sglSetDynamicResolution arguments and the size
+ * reported back; the backend scales default framebuffer viewports, so
+ * switching between an FBO and the default framebuffer re-emits them */
+static void run_render_resolution(EGLDisplay dpy, EGLSurface surf) {
+    GLint size[3][2];
+    GLenum errors[4];
+    sgl_frame_stats_t stats;
+
+    sglGetRenderResolution(&size[0][0], &size[0][1]);
+    sglSetRenderResolution(640, 360);
+    sglGetRenderResolution(&size[1][0], &size[1][1]);
+    sglSetRenderResolution(0, 360);
+    errors[0] = glGetError();
+    sglSetRenderResolution(-640, 360);
+    errors[1] = glGetError();
+    sglSetDynamicResolution(8000, 0.0f);
+    errors[2] = glGetError();
+    sglSetDynamicResolution(0, 0.0f);
+    errors[3] = glGetError();
+
+    GLuint tex, fbo;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 64, 64, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    /* Same viewport throughout: only the framebuffer switches re-emit it */
+    GLuint viewports[2];
+    uint64_t start = now_ns();
+    for (int f = 0; f < 2; f++) {
+        glClear(GL_COLOR_BUFFER_BIT);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        if (f == 1) {
+            glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        }
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        eglSwapBuffers(dpy, surf);
+        sglGetFrameStats(&stats);
+        viewports[f] = stats.viewport_binds;
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    sglSetRenderResolution(0, 0);
+    sglGetRenderResolution(&size[2][0], &size[2][1]);
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteTextures(1, &tex);
+    check_gl("render_resolution");
+
+    if (size[0][0] != 1280 || size[0][1] != 720 || size[1][0] != 640 || size[1][1] != 360 ||
+        size[2][0] != 1280 || size[2][1] != 720) {
+        printf("  FAIL render_resolution: sizes %dx%d, %dx%d, %dx%d\n", size[0][0], size[0][1],
+               size[1][0], size[1][1], size[2][0], size[2][1]);
+        s_failures++;
+    }
+    if (errors[0] != GL_INVALID_VALUE || errors[1] != GL_INVALID_VALUE ||
+        errors[2] != GL_INVALID_VALUE || errors[3] != GL_NO_ERROR) {
+        printf("  FAIL render_resolution: errors 0x%x 0x%x 0x%x 0x%x\n", errors[0], errors[1],
+               errors[2], errors[3]);
+        s_failures++;
+    }
+    if (viewports[1] != viewports[0] + 2) {
+        printf("  FAIL render_resolution: %u viewport binds without an FBO, %u with one\n",
+               viewports[0], viewports[1]);
+        s_failures++;
+    }
+    printf("%-22s %9.1f us/frame (default framebuffer at 640x360)\n", "render_resolution",
+           (double)elapsed / 1000.0 / 2);
+}
+
+/* sglSetTransferQueue: the null backend has no copy queue, uploads stay in the frame */
+static void run_transfer_queue(EGLDisplay dpy, EGLSurface surf, const bench_t *b) {
+    static uint8_t pixels[256 * 256 * 4];
+    GLuint textures[32];
+
+    GLboolean active = sglSetTransferQueue(GL_TRUE);
+    if (active) {
+        printf("  FAIL transfer_queue: null backend reports a transfer queue\n");
+        s_failures++;
+    }
+
+    glGenTextures(32, textures);
+    uint64_t start = now_ns();
+    for (int i = 0; i < 32; i++) {
+        glBindTexture(GL_TEXTURE_2D, textures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 256, 256, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    }
+    uint64_t elapsed = now_ns() - start;
+    glBindBuffer(GL_ARRAY_BUFFER, b->vbo);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    eglSwapBuffers(dpy, surf);
+
+    sgl_frame_stats_t stats;
+    sglGetFrameStats(&stats);
+    if (stats.transfer_copies != 0 || sglSetTransferQueue(GL_FALSE)) {
+        printf("  FAIL transfer_queue: %u copies on a queue that does not exist\n", stats.transfer_copies);
+        s_failures++;
+    }
+    glDeleteTextures(32, textures);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    check_gl("transfer_queue");
+
+    printf("%-22s %9.1f us/texture (256x256 RGBA, queue %s)\n", "transfer_queue",
+           (double)elapsed / 1000.0 / 32, active ? "on" : "unavailable");
+}
+
+/* Draws alternating two programs and four textures, drawn in order and
+ * with sglSetDrawSortMode: the sorted frame binds each program once */
+static void draw_sort_frame(EGLDisplay dpy, EGLSurface surf, const bench_t *b, GLuint prog2,
+                            const GLuint *textures, sgl_frame_stats_t *stats) {
+    glBindBuffer(GL_ARRAY_BUFFER, b->vbo);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, (const void *)0);
+    for (int i = 0; i < BENCH_DRAWS; i++) {
+        GLuint prog = (i & 1) ? prog2 : b->prog;
+        glUseProgram(prog);
+        glUniform4f(glGetUniformLocation(prog, "u_color"), (float)i, 0.0f, 0.0f, 1.0f);
+        glBindTexture(GL_TEXTURE_2D, textures[(i >> 1) & 3]);
+        sglSetDrawSortDepth((float)(BENCH_DRAWS - i));
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+    eglSwapBuffers(dpy, surf);
+    sglGetFrameStats(stats);
+}
+
+static void run_draw_sort(EGLDisplay dpy, EGLSurface surf, const bench_t *b) {
+    static const uint8_t pixel[4] = { 255, 255, 255, 255 };
+    GLuint prog2 = build_program();
+    GLuint textures[4];
+    glGenTextures(4, textures);
+    for (int i = 0; i < 4; i++) {
+        glBindTexture(GL_TEXTURE_2D, textures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+    }
+    glEnable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+
+    sgl_frame_stats_t in_order, sorted, by_depth;
+    draw_sort_frame(dpy, surf, b, prog2, textures, &in_order);
+    sglSetDrawSortMode(SGL_DRAW_SORT_STATE);
+    uint64_t start = now_ns();
+    draw_sort_frame(dpy, surf, b, prog2, textures, &sorted);
+    uint64_t elapsed = now_ns() - start;
+    sglSetDrawSortMode(SGL_DRAW_SORT_DEPTH);
+    draw_sort_frame(dpy, surf, b, prog2, textures, &by_depth);
+
+    /* Blended draws are drawn in place: nothing to sort */
+    glEnable(GL_BLEND);
+    sgl_frame_stats_t blended;
+    draw_sort_frame(dpy, surf, b, prog2, textures, &blended);
+    glDisable(GL_BLEND);
+    sglSetDrawSortMode(SGL_DRAW_SORT_NONE);
+
+    /* A run holds up to 1024 draws: per run, each program once and four textures each */
+    GLuint runs = (BENCH_DRAWS + 1023) / 1024;
+    if (sorted.draws != in_order.draws || by_depth.draws != in_order.draws ||
+        sorted.shader_binds > 2 * runs || sorted.texture_binds > 8 * runs ||
+        blended.shader_binds != in_order.shader_binds) {
+        printf("  FAIL draw_sort: draws %u/%u/%u, shader binds %u -> %u (blended %u), "
+               "texture binds %u -> %u\n", in_order.draws, sorted.draws, by_depth.draws,
+               in_order.shader_binds, sorted.shader_binds, blended.shader_binds,
+               in_order.texture_binds, sorted.texture_binds);
+        s_failures++;
+    }
+    sglSetDrawSortMode(0x1234);
+    if (glGetError() != GL_INVALID_ENUM) {
+        printf("  FAIL draw_sort: unknown mode accepted\n");
+        s_failures++;
+    }
+
+    glDisable(GL_DEPTH_TEST);
+    glDeleteTextures(4, textures);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDeleteProgram(prog2);
+    glUseProgram(b->prog);
+    check_gl("draw_sort");
+
+    printf("%-22s %9.1f us/frame (%d draws, shader binds %u -> %u, texture binds %u -> %u)\n",
+           "draw_sort", (double)elapsed / 1000.0, BENCH_DRAWS, in_order.shader_binds,
+           sorted.shader_binds, in_order.texture_binds, sorted.texture_binds);
+}
+
+/* glClear calls with no draw between them reach the backend as one clear,
+ * recorded at the next draw or at eglSwapBuffers */
+static void run_clear_merge(EGLDisplay dpy, EGLSurface surf, const bench_t *b) {
+    glBindBuffer(GL_ARRAY_BUFFER, b->vbo);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, (const void *)0);
+
+    uint64_t start = now_ns();
+    for (int i = 0; i < BENCH_DRAWS; i++) {
+        glClear(GL_COLOR_BUFFER_BIT);
+        glClear(GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+    uint64_t elapsed = now_ns() - start;
+    eglSwapBuffers(dpy, surf);
+    sgl_frame_stats_t merged;
+    sglGetFrameStats(&merged);
+
+    /* A frame that only clears still clears */
+    glClear(GL_COLOR_BUFFER_BIT);
+    eglSwapBuffers(dpy, surf);
+    sgl_frame_stats_t clear_only;
+    sglGetFrameStats(&clear_only);
+
+    if (merged.clears != BENCH_DRAWS || merged.draws != BENCH_DRAWS || clear_only.clears != 1) {
+        printf("  FAIL clear_merge: %u clears for %d draws, %u in a clear-only frame\n",
+               merged.clears, BENCH_DRAWS, clear_only.clears);
+        s_failures++;
+    }
+    check_gl("clear_merge");
+
+    printf("%-22s %9.1f ns/clear+draw (%u clears for %d glClear calls)\n", "clear_merge",
+           (double)elapsed / BENCH_DRAWS, merged.clears, 2 * BENCH_DRAWS);
+}
+
+/* Little-endian container writers for the texture_file scenario */
+static void put32(FILE *fp, uint32_t v) {
+    uint8_t b[4] = { (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24) };
+    fwrite(b, 1, 4, fp);
+}
+
+static void put_blocks(FILE *fp, uint32_t size) {
+    static const uint8_t block[16] = { 0 };
+    for (uint32_t i = 0; i < size; i += 16) fwrite(block, 1, size - i < 16 ? size - i : 16, fp);
+}
+
+/* KTX 1.1, ASTC 4x4, full mip chain (16 bytes per 4x4 block) */
+static void write_ktx1(const char *path, uint32_t size, uint32_t levels) {
+    static const uint8_t id[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+    FILE *fp = fopen(path, "wb");
+    fwrite(id, 1, 12, fp);
+    uint32_t header[13] = { 0x04030201, 0, 1, 0, 0x93B0, 0x1908, size, size, 0, 0, 1, levels, 0 };
+    for (int i = 0; i < 13; i++) put32(fp, header[i]);
+    for (uint32_t l = 0; l < levels; l++) {
+        uint32_t dim = size >> l ? size >> l : 1;
+        uint32_t bytes = ((dim + 3) / 4) * ((dim + 3) / 4) * 16;
+        put32(fp, bytes);
+        put_blocks(fp, bytes);
+    }
+    fclose(fp);
+}
+
+/* KTX 2.0, VK_FORMAT_BC1_RGB_UNORM_BLOCK (8 bytes per 4x4 block), smallest level last */
+static void write_ktx2(const char *path, uint32_t size, uint32_t levels) {
+    static const uint8_t id[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+    FILE *fp = fopen(path, "wb");
+    fwrite(id, 1, 12, fp);
+    uint32_t header[9] = { 131, 1, size, size, 0, 0, 1, levels, 0 };
+    for (int i = 0; i < 9; i++) put32(fp, header[i]);
+    for (int i = 0; i < 8; i++) put32(fp, 0);       /* dfd/kvd/sgd index */
+    uint64_t offset = 80 + 24 * levels, total = 0;
+    for (uint32_t l = 0; l < levels; l++) {
+        uint32_t dim = size >> l ? size >> l : 1;
+        uint32_t bytes = ((dim + 3) / 4) * ((dim + 3) / 4) * 8;
+        put32(fp, (uint32_t)(offset + total)); put32(fp, 0);
+        put32(fp, bytes); put32(fp, 0);
+        put32(fp, bytes); put32(fp, 0);
+        total += bytes;
+    }
+    put_blocks(fp, (uint32_t)total);
+    fclose(fp);
+}
+
+/* .astc, 8x8 blocks, non-multiple-of-block size; truncated drops the last block */
+static void write_astc(const char *path, uint32_t w, uint32_t h, bool truncated) {
+    FILE *fp = fopen(path, "wb");
+    uint8_t header[16] = { 0x13, 0xAB, 0xA1, 0x5C, 8, 8, 1,
+                           (uint8_t)w, (uint8_t)(w >> 8), 0, (uint8_t)h, (uint8_t)(h >> 8), 0, 1, 0, 0 };
+    fwrite(header, 1, 16, fp);
+    uint32_t bytes = ((w + 7) / 8) * ((h + 7) / 8) * 16;
+    put_blocks(fp, truncated ? bytes - 16 : bytes);
+    fclose(fp);
+}
+
+static void run_texture_files(void) {
+    static const char *ktx1 = "/tmp/bench_gl_tex.ktx";
+    static const char *ktx2 = "/tmp/bench_gl_tex.ktx2";
+    static const char *astc = "/tmp/bench_gl_tex.astc";
+    static const char *bad  = "/tmp/bench_gl_bad.astc";
+    write_ktx1(ktx1, 1024, 11);
+    write_ktx2(ktx2, 256, 9);
+    write_astc(astc, 100, 60, false);
+    write_astc(bad, 100, 60, true);
+
+    GLuint tex;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+
+    uint64_t start = now_ns();
+    const char *files[3] = { ktx1, ktx2, astc };
+    for (int i = 0; i < 3; i++) {
+        if (!sglTexImageFromFile(GL_TEXTURE_2D, files[i])) {
+            printf("  FAIL texture_file: %s not loaded\n", files[i]);
+            s_failures++;
+        }
+    }
+    uint64_t total = now_ns() - start;
+    check_gl("texture_file");
+
+    if (sglTexImageFromFile(GL_TEXTURE_2D, bad) || glGetError() != GL_INVALID_OPERATION) {
+        printf("  FAIL texture_file: truncated file accepted\n");
+        s_failures++;
+    }
+
+    glDeleteTextures(1, &tex);
+    remove(ktx1); remove(ktx2); remove(astc); remove(bad);
+    printf("%-22s %9.1f us/file (KTX, KTX2, .astc; parse + stream)\n",
+           "texture_file", (double)total / 3 / 1000.0);
+}
+
+int main(void) {
+    /* Keep the host run self-contained */
+    sglSetShaderCachePath(NULL);
+
+    EGLDisplay dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    eglInitialize(dpy, NULL, NULL);
+    EGLConfig config;
+    EGLint num_configs = 0;
+    static const EGLint config_attribs[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT, EGL_NONE };
+    eglChooseConfig(dpy, config_attribs, &config, 1, &num_configs);
+    static const EGLint surface_attribs[] = { EGL_WIDTH, 1280, EGL_HEIGHT, 720, EGL_NONE };
+    EGLSurface surf = eglCreatePbufferSurface(dpy, config, surface_attribs);
+    static const EGLint context_attribs[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
+    EGLContext ctx = eglCreateContext(dpy, config, EGL_NO_CONTEXT, context_attribs);
+    if (!surf || !ctx || !eglMakeCurrent(dpy, surf, surf, ctx)) {
+        printf("FAIL: EGL setup (0x%04x)\n", eglGetError());
+        return 1;
+    }
+
+    printf("=== bench_gl (null backend) ===\n");
+
+    static bench_t b;
+    for (int i = 0; i < BENCH_VERTS * 4; i++) b.verts[i] = (float)(i % 7) * 0.1f;
+    b.prog = build_program();
+    glUseProgram(b.prog);
+    b.u_mvp = glGetUniformLocation(b.prog, "u_mvp");
+    b.u_offset = glGetUniformLocation(b.prog, "u_offset");
+    b.u_color = glGetUniformLocation(b.prog, "u_color");
+    b.u_tint = glGetUniformLocation(b.prog, "u_tint");
+    glGenBuffers(1, &b.vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, b.vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(b.verts), b.verts, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glViewport(0, 0, 1280, 720);
+    glEnable(GL_SCISSOR_TEST);
+    check_gl("setup");
+
+    for (size_t i = 0; i < sizeof(s_scenarios) / sizeof(s_scenarios[0]); i++) {
+        run_scenario(dpy, surf, &b, &s_scenarios[i]);
+    }
+    run_client_promotion(dpy, surf, &b);
+    run_element_buffer(dpy, surf, &b);
+    run_command_list(dpy, surf, &b);
+    run_link();
+    run_shader_release(&b);
+    run_uniform_storage(&b);
+    run_shader_bundle(&b);
+    run_objects();
+    run_memory_stats();
+    run_env_cubemap();
+    run_blit_chain();
+    run_gbuffer(&b);
+    run_shadow_map(&b);
+    run_packed_attribs(&b);
+    run_packed_textures();
+    run_mip_levels();
+    run_syncs(dpy);
+    run_texture_files();
+    run_capture_replay(dpy, surf, &b);
+    run_shared_upload(dpy, config, ctx, &b);
+    run_heap_config(dpy, config, surf, ctx);
+    run_surface_depth(dpy, config, surf, ctx);
+    run_render_resolution(dpy, surf);
+    run_transfer_queue(dpy, surf, &b);
+    run_draw_sort(dpy, surf, &b);
+    run_clear_merge(dpy, surf, &b);
+
+    glDeleteBuffers(1, &b.vbo);
+    glDeleteProgram(b.prog);
+    eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(dpy, ctx);
+    eglDestroySurface(dpy, surf);
+    eglTerminate(dpy);
+
+    if (s_failures) {
+        printf("%d failure(s)\n", s_failures);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
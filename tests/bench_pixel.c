@@ -0,0 +1,124 @@
+/*
+ * bench_pixel.c - Microbenchmark for the texture upload pixel kernels
+ *
+ * Reports MB/s (source bytes) per kernel for the scalar reference and the
+ * dispatched (NEON on AArch64) implementation, and checks both produce the
+ * same output and that 16-bit texels survive a widen/pack round trip.
+ *
+ * Compile (any platform):
+ *   gcc -O2 -o bench_pixel bench_pixel.c ../source/util/sgl_pixel.c -I../include -Wall
+ */
+
+#include "../source/util/sgl_pixel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_WIDTH     1024
+#define BENCH_HEIGHT    1024
+#define BENCH_ITERS     20
+
+typedef void (*kernel_fn)(uint8_t *dst, const uint8_t *src, uint32_t count);
+
+typedef struct {
+    const char *name;
+    uint32_t src_bpp;
+    kernel_fn scalar;
+    kernel_fn fast;
+} bench_kernel_t;
+
+static const bench_kernel_t s_kernels[] = {
+    { "RGB888   -> RGBA8888", 3, sgl_pixel_rgb8_to_rgba8_scalar,     sgl_pixel_rgb8_to_rgba8 },
+    { "RGB565   -> RGBA8888", 2, sgl_pixel_rgb565_to_rgba8_scalar,   sgl_pixel_rgb565_to_rgba8 },
+    { "RGBA4444 -> RGBA8888", 2, sgl_pixel_rgba4444_to_rgba8_scalar, sgl_pixel_rgba4444_to_rgba8 },
+    { "RGBA5551 -> RGBA8888", 2, sgl_pixel_rgba5551_to_rgba8_scalar, sgl_pixel_rgba5551_to_rgba8 },
+};
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Convert the whole image row by row, as the upload path does */
+static double run_kernel(kernel_fn fn, uint8_t *dst, const uint8_t *src, uint32_t src_bpp) {
+    double start = now_seconds();
+    for (int it = 0; it < BENCH_ITERS; it++) {
+        for (uint32_t y = 0; y < BENCH_HEIGHT; y++) {
+            fn(dst + y * BENCH_WIDTH * 4, src + y * BENCH_WIDTH * src_bpp, BENCH_WIDTH);
+        }
+    }
+    double elapsed = now_seconds() - start;
+    double bytes = (double)BENCH_WIDTH * BENCH_HEIGHT * src_bpp * BENCH_ITERS;
+    return bytes / elapsed / (1024.0 * 1024.0);
+}
+
+static double run_unpack(uint8_t *dst, const uint8_t *src, GLenum format) {
+    uint32_t bpp = sgl_pixel_src_bpp(format, GL_UNSIGNED_BYTE);
+    /* Odd width so rows need GL_UNPACK_ALIGNMENT padding and a strided copy */
+    uint32_t width = BENCH_WIDTH - 1;
+    uint32_t dst_stride = (width * bpp + 31) & ~31u;
+    double start = now_seconds();
+    for (int it = 0; it < BENCH_ITERS; it++) {
+        sgl_pixel_unpack(dst, dst_stride, src, width, BENCH_HEIGHT, format, GL_UNSIGNED_BYTE, 4);
+    }
+    double elapsed = now_seconds() - start;
+    double bytes = (double)width * BENCH_HEIGHT * bpp * BENCH_ITERS;
+    return bytes / elapsed / (1024.0 * 1024.0);
+}
+
+int main(void) {
+    size_t pixels = (size_t)BENCH_WIDTH * BENCH_HEIGHT;
+    uint8_t *src = malloc(pixels * 4);
+    uint8_t *dst_scalar = malloc(pixels * 4);
+    uint8_t *dst_fast = malloc(pixels * 4);
+    int failures = 0;
+
+    srand(1234);
+    for (size_t i = 0; i < pixels * 4; i++) src[i] = (uint8_t)rand();
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    printf("Dispatched kernels: NEON\n");
+#else
+    printf("Dispatched kernels: scalar (no NEON on this target)\n");
+#endif
+    printf("%dx%d image, %d iterations, MB/s of source data\n\n", BENCH_WIDTH, BENCH_HEIGHT, BENCH_ITERS);
+    printf("%-22s %12s %12s %8s\n", "Kernel", "Scalar", "Dispatched", "Match");
+
+    for (size_t k = 0; k < sizeof(s_kernels) / sizeof(s_kernels[0]); k++) {
+        const bench_kernel_t *bk = &s_kernels[k];
+        double scalar = run_kernel(bk->scalar, dst_scalar, src, bk->src_bpp);
+        double fast = run_kernel(bk->fast, dst_fast, src, bk->src_bpp);
+
+        /* Odd counts exercise the scalar tail of the vector kernels */
+        bk->scalar(dst_scalar, src, (uint32_t)pixels - 5);
+        bk->fast(dst_fast, src, (uint32_t)pixels - 5);
+        int match = memcmp(dst_scalar, dst_fast, (pixels - 5) * 4) == 0;
+        if (!match) failures++;
+
+        printf("%-22s %12.1f %12.1f %8s\n", bk->name, scalar, fast, match ? "yes" : "NO");
+    }
+
+    /* 16-bit textures are stored natively: widening for glReadPixels and
+     * packing for glCopyTexSubImage2D must round-trip every texel */
+    static const GLenum packed_types[] = {
+        GL_UNSIGNED_SHORT_5_6_5, GL_UNSIGNED_SHORT_4_4_4_4, GL_UNSIGNED_SHORT_5_5_5_1,
+    };
+    for (size_t t = 0; t < sizeof(packed_types) / sizeof(packed_types[0]); t++) {
+        sgl_pixel_widen_rgba8(dst_fast, src, (uint32_t)pixels, packed_types[t]);
+        sgl_pixel_pack_rgba8(dst_scalar, dst_fast, (uint32_t)pixels, packed_types[t]);
+        if (memcmp(dst_scalar, src, pixels * 2) != 0) {
+            printf("FAIL: 16-bit round trip for type 0x%04X\n", packed_types[t]);
+            failures++;
+        }
+    }
+
+    printf("%-22s %12s %12.1f\n", "Row copy RGBA8888", "-", run_unpack(dst_fast, src, GL_RGBA));
+    printf("%-22s %12s %12.1f\n", "Row copy LUMINANCE", "-", run_unpack(dst_fast, src, GL_LUMINANCE));
+
+    free(src);
+    free(dst_scalar);
+    free(dst_fast);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,10 @@
+precision mediump float;
+uniform vec3 u_light_dir;
+uniform float u_ambient;
+uniform vec3 u_albedo;
+varying vec3 v_normal;
+
+void main() {
+    float diffuse = max(dot(normalize(v_normal), u_light_dir), 0.0);
+    gl_FragColor = vec4(u_albedo * (u_ambient + diffuse), 1.0);
+}
@@ -0,0 +1,10 @@
+attribute vec3 a_position;
+attribute vec3 a_normal;
+uniform mat4 u_mvp;
+uniform mat3 u_normal_matrix;
+varying vec3 v_normal;
+
+void main() {
+    v_normal = u_normal_matrix * a_normal;
+    gl_Position = u_mvp * vec4(a_position, 1.0);
+}
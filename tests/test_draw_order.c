@@ -0,0 +1,531 @@
+/*
+ * test_draw_order.c - Sorted draws against in-order rendering, on the null backend
+ *
+ * sglSetDrawSortMode records opaque draws in another order than they were
+ * issued (gl_draw_sort.c). That must not change the image. Each scene is
+ * rendered in order and sorted with the null backend's draw log on
+ * (null_backend_set_draw_log), and the logs are compared: every draw must
+ * reach the backend with the same program, uniform data, textures and
+ * fixed-function state, clears must keep their place between the draws,
+ * and draws whose order the depth test does not decide must keep their
+ * order.
+ *
+ * glClear is deferred to the next draw (gl_clear.c), so state changed
+ * between a clear and the first draw after it must not leak into the
+ * clear. Those scenes are compared against a reference that flushes right
+ * after every glClear.
+ *
+ * Build and run (Linux):
+ *   make -f Makefile.host build_host/test_draw_order && build_host/test_draw_order
+ */
+
+#define GL_GLEXT_PROTOTYPES
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <GLES2/gl2sgl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "backend/null/null_backend.h"
+#include "context/sgl_context.h"
+
+#define LOG_CAPACITY    256
+#define SCENE_DRAWS     24
+
+/* ---- Test helper ---- */
+
+static int s_pass = 0, s_fail = 0;
+
+#define TEST(name) printf("\n=== %s ===\n", name)
+#define CHECK(cond, msg) do { \
+    if (cond) { s_pass++; printf("  [PASS] %s\n", msg); } \
+    else      { s_fail++; printf("  [FAIL] %s\n", msg); } \
+} while(0)
+
+/* ---- Scene setup ---- */
+
+static const char *s_vs =
+    "attribute vec4 a_position;\n"
+    "uniform mat4 u_mvp;\n"
+    "uniform vec4 u_offset;\n"
+    "void main() {\n"
+    "    gl_Position = u_mvp * a_position + u_offset;\n"
+    "}\n";
+
+static const char *s_fs[2] = {
+    "precision mediump float;\n"
+    "uniform vec4 u_color;\n"
+    "uniform vec4 u_tint[4];\n"
+    "uniform sampler2D u_tex;\n"
+    "void main() {\n"
+    "    gl_FragColor = u_color * u_tint[2] * texture2D(u_tex, u_tint[1].xy);\n"
+    "}\n",
+
+    "precision mediump float;\n"
+    "uniform vec4 u_color;\n"
+    "uniform vec4 u_tint[4];\n"
+    "uniform sampler2D u_tex;\n"
+    "void main() {\n"
+    "    gl_FragColor = u_color + u_tint[3] * texture2D(u_tex, u_tint[0].xy);\n"
+    "}\n",
+};
+
+typedef struct {
+    GLuint prog[2];
+    GLint u_mvp[2], u_offset[2], u_color[2], u_tint[2];
+    GLuint tex[2];
+    GLuint vbo, ebo;
+} scene_t;
+
+static GLuint compile(GLenum type, const char *src) {
+    GLuint sh = glCreateShader(type);
+    glShaderSource(sh, 1, &src, NULL);
+    glCompileShader(sh);
+    return sh;
+}
+
+static bool scene_init(scene_t *s) {
+    for (int i = 0; i < 2; i++) {
+        GLuint prog = glCreateProgram();
+        GLuint vs = compile(GL_VERTEX_SHADER, s_vs);
+        GLuint fs = compile(GL_FRAGMENT_SHADER, s_fs[i]);
+        glAttachShader(prog, vs);
+        glAttachShader(prog, fs);
+        glBindAttribLocation(prog, 0, "a_position");
+        glLinkProgram(prog);
+        glDeleteShader(vs);
+        glDeleteShader(fs);
+
+        GLint linked = 0;
+        glGetProgramiv(prog, GL_LINK_STATUS, &linked);
+        if (!linked) return false;
+        s->prog[i] = prog;
+        s->u_mvp[i] = glGetUniformLocation(prog, "u_mvp");
+        s->u_offset[i] = glGetUniformLocation(prog, "u_offset");
+        s->u_color[i] = glGetUniformLocation(prog, "u_color");
+        s->u_tint[i] = glGetUniformLocation(prog, "u_tint");
+        glUseProgram(prog);
+        glUniform1i(glGetUniformLocation(prog, "u_tex"), 0);
+    }
+
+    static const uint8_t texels[2][4] = { { 255, 0, 0, 255 }, { 0, 255, 0, 255 } };
+    glGenTextures(2, s->tex);
+    for (int i = 0; i < 2; i++) {
+        glBindTexture(GL_TEXTURE_2D, s->tex[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels[i]);
+    }
+
+    float verts[SCENE_DRAWS * 3 * 4];
+    for (int i = 0; i < SCENE_DRAWS * 3 * 4; i++) verts[i] = (float)(i % 11) * 0.1f - 0.5f;
+    GLushort indices[SCENE_DRAWS * 3];
+    for (int i = 0; i < SCENE_DRAWS * 3; i++) indices[i] = (GLushort)(SCENE_DRAWS * 3 - 1 - i);
+    glGenBuffers(1, &s->vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, s->vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
+    glGenBuffers(1, &s->ebo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s->ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, (const void *)0);
+    glEnableVertexAttribArray(0);
+    return glGetError() == GL_NO_ERROR;
+}
+
+static void scene_free(scene_t *s) {
+    glDeleteBuffers(1, &s->vbo);
+    glDeleteBuffers(1, &s->ebo);
+    glDeleteTextures(2, s->tex);
+    glDeleteProgram(s->prog[0]);
+    glDeleteProgram(s->prog[1]);
+}
+
+/* Draw i: its own vertices (arrays) or indices (elements), so it can be
+ * told apart in the log */
+static void scene_draw(int i) {
+    if (i % 4 == 3) {
+        glDrawElements(GL_TRIANGLES, 3, GL_UNSIGNED_SHORT, (const void *)(uintptr_t)(i * 3 * 2));
+    } else {
+        glDrawArrays(GL_TRIANGLES, i * 3, 3);
+    }
+}
+
+/* ---- Draw logs ---- */
+
+typedef struct {
+    null_draw_record_t records[LOG_CAPACITY];
+    uint32_t count;
+} draw_log_t;
+
+typedef void (*scene_fn)(const scene_t *s);
+
+/* Render a scene with the given sort mode, logging what reaches the backend */
+static void record_scene(const scene_t *s, scene_fn scene, GLenum sort_mode, draw_log_t *log) {
+    sgl_backend_t *be = sgl_get_current_context()->backend;
+    sglSetDrawSortMode(sort_mode);
+    null_backend_set_draw_log(be, log->records, LOG_CAPACITY);
+    scene(s);
+    glFinish();
+    log->count = null_backend_draw_log_count(be);
+    null_backend_set_draw_log(be, NULL, 0);
+    sglSetDrawSortMode(SGL_DRAW_SORT_NONE);
+    if (log->count > LOG_CAPACITY) log->count = LOG_CAPACITY;
+}
+
+static bool record_equal(const null_draw_record_t *a, const null_draw_record_t *b) {
+    if (a->clear_mask || b->clear_mask) {
+        return a->clear_mask == b->clear_mask &&
+               memcmp(a->clear_color, b->clear_color, sizeof(a->clear_color)) == 0 &&
+               a->clear_depth == b->clear_depth && a->clear_stencil == b->clear_stencil;
+    }
+    const sgl_scissor_state_t *sa = &a->scissor, *sb = &b->scissor;
+    return a->program == b->program && a->uniforms == b->uniforms &&
+           memcmp(a->textures, b->textures, sizeof(a->textures)) == 0 &&
+           sa->enabled == sb->enabled && sa->x == sb->x && sa->y == sb->y &&
+           sa->width == sb->width && sa->height == sb->height &&
+           memcmp(a->color_mask, b->color_mask, sizeof(a->color_mask)) == 0 &&
+           a->depth_test == b->depth_test && a->depth_write == b->depth_write &&
+           a->depth_func == b->depth_func && a->elements == b->elements && a->mode == b->mode &&
+           a->first == b->first && a->count == b->count && a->ebo_offset == b->ebo_offset &&
+           a->instances == b->instances;
+}
+
+/* Draws identify by their vertices or indices */
+static int record_compare(const void *x, const void *y) {
+    const null_draw_record_t *a = (const null_draw_record_t *)x;
+    const null_draw_record_t *b = (const null_draw_record_t *)y;
+    if (a->elements != b->elements) return a->elements ? 1 : -1;
+    if (a->first != b->first) return a->first < b->first ? -1 : 1;
+    if (a->ebo_offset != b->ebo_offset) return a->ebo_offset < b->ebo_offset ? -1 : 1;
+    return 0;
+}
+
+static bool logs_same_order(const draw_log_t *a, const draw_log_t *b) {
+    if (a->count != b->count) return false;
+    for (uint32_t i = 0; i < a->count; i++) {
+        if (!record_equal(&a->records[i], &b->records[i])) return false;
+    }
+    return true;
+}
+
+/* Same clears in the same places, and between them the same draws in any
+ * order. Sorts the draws between clears in place. */
+static bool logs_same_image(draw_log_t *a, draw_log_t *b) {
+    if (a->count != b->count) return false;
+    uint32_t begin = 0;
+    for (uint32_t i = 0; i <= a->count; i++) {
+        bool end = i == a->count || a->records[i].clear_mask || b->records[i].clear_mask;
+        if (!end) continue;
+        qsort(&a->records[begin], i - begin, sizeof(null_draw_record_t), record_compare);
+        qsort(&b->records[begin], i - begin, sizeof(null_draw_record_t), record_compare);
+        begin = i + 1;
+    }
+    return logs_same_order(a, b);
+}
+
+/* Merge clears with no draw between them the way the deferred clear does:
+ * one clear of every buffer, each to the value it was last cleared to */
+static void merge_clears(draw_log_t *log) {
+    uint32_t out = 0;
+    for (uint32_t i = 0; i < log->count; i++) {
+        null_draw_record_t *r = &log->records[i];
+        null_draw_record_t *prev = out > 0 ? &log->records[out - 1] : NULL;
+        if (r->clear_mask && prev && prev->clear_mask) {
+            if (r->clear_mask & GL_COLOR_BUFFER_BIT) {
+                memcpy(prev->clear_color, r->clear_color, sizeof(prev->clear_color));
+            }
+            if (r->clear_mask & GL_DEPTH_BUFFER_BIT) prev->clear_depth = r->clear_depth;
+            if (r->clear_mask & GL_STENCIL_BUFFER_BIT) prev->clear_stencil = r->clear_stencil;
+            prev->clear_mask |= r->clear_mask;
+            continue;
+        }
+        log->records[out++] = *r;
+    }
+    log->count = out;
+}
+
+static void print_log(const char *name, const draw_log_t *log) {
+    printf("  %s:\n", name);
+    for (uint32_t i = 0; i < log->count; i++) {
+        const null_draw_record_t *r = &log->records[i];
+        if (r->clear_mask) {
+            printf("    clear 0x%x color %.2f %.2f %.2f %.2f depth %.2f\n", r->clear_mask,
+                   r->clear_color[0], r->clear_color[1], r->clear_color[2], r->clear_color[3],
+                   r->clear_depth);
+            continue;
+        }
+        printf("    %s %d/%u prog %u uniforms %08x tex %u scissor %d:%d,%d %dx%d mask %d%d%d%d "
+               "depth %d%d 0x%x\n", r->elements ? "elements" : "arrays", r->first, r->ebo_offset,
+               r->program, r->uniforms, r->textures[0], r->scissor.enabled, r->scissor.x,
+               r->scissor.y, r->scissor.width, r->scissor.height, r->color_mask[0],
+               r->color_mask[1], r->color_mask[2], r->color_mask[3], r->depth_test,
+               r->depth_write, r->depth_func);
+    }
+}
+
+/* ---- Scenes ---- */
+
+static void set_depth(GLenum func) {
+    glEnable(GL_DEPTH_TEST);
+    glDepthMask(GL_TRUE);
+    glDepthFunc(func);
+    glDisable(GL_BLEND);
+}
+
+/*
+ * Two programs and two textures, interleaved, with uniforms written between
+ * draws of the same program: whole vectors, the leading elements of an
+ * array, the matrix, and draws that write nothing and reuse the previous
+ * values.
+ */
+static void scene_uniforms(const scene_t *s) {
+    static const float identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+    set_depth(GL_LESS);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    static const float tint[16] = { 0 };
+    for (int p = 0; p < 2; p++) {
+        glUseProgram(s->prog[p]);
+        glUniformMatrix4fv(s->u_mvp[p], 1, GL_FALSE, identity);
+        glUniform4f(s->u_offset[p], 0.0f, 0.0f, 0.0f, 0.0f);
+        glUniform4f(s->u_color[p], 0.0f, 0.0f, 0.0f, 1.0f);
+        glUniform4fv(s->u_tint[p], 4, tint);
+    }
+
+    for (int i = 0; i < SCENE_DRAWS; i++) {
+        int p = i % 3 == 0;
+        glUseProgram(s->prog[p]);
+        glBindTexture(GL_TEXTURE_2D, s->tex[(i >> 2) & 1]);
+        if (i % 2 == 0) glUniform4f(s->u_color[p], (float)i, 0.5f, 0.25f, 1.0f);
+        if (i % 5 == 1) {
+            const float tint[12] = { (float)i, 1.0f, 2.0f, 3.0f, 0.0f, (float)i };
+            glUniform4fv(s->u_tint[p], 3, tint);
+        }
+        if (i % 7 == 4) {
+            float mvp[16];
+            memcpy(mvp, identity, sizeof(mvp));
+            mvp[12] = (float)i;
+            glUniformMatrix4fv(s->u_mvp[p], 1, GL_FALSE, mvp);
+        }
+        sglSetDrawSortDepth((float)((i * 7) % SCENE_DRAWS));
+        scene_draw(i);
+    }
+
+    /* A clear in the middle: the draws before it stay before it */
+    glClear(GL_DEPTH_BUFFER_BIT);
+    for (int i = 0; i < SCENE_DRAWS; i += 5) {
+        int p = i & 1;
+        glUseProgram(s->prog[p]);
+        glUniform4f(s->u_offset[p], (float)i, 0.0f, 0.0f, 0.0f);
+        scene_draw(i);
+    }
+}
+
+/* Coplanar draws of both programs: with GL_LEQUAL or GL_GEQUAL the last one
+ * at a pixel wins, so their order must not change */
+static void scene_equal_depth(const scene_t *s) {
+    static const GLenum funcs[2] = { GL_LEQUAL, GL_GEQUAL };
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    for (int f = 0; f < 2; f++) {
+        set_depth(funcs[f]);
+        for (int i = 0; i < 8; i++) {
+            int p = i & 1;
+            glUseProgram(s->prog[p]);
+            glBindTexture(GL_TEXTURE_2D, s->tex[(i >> 1) & 1]);
+            glUniform4f(s->u_color[p], (float)i, (float)f, 0.0f, 1.0f);
+            sglSetDrawSortDepth((float)(8 - i));
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+        }
+    }
+}
+
+/* Set to render the reference: every glClear reaches the backend at once */
+static bool s_flush_clears = false;
+
+static void clear(GLbitfield mask) {
+    glClear(mask);
+    if (s_flush_clears) glFlush();
+}
+
+/*
+ * Clears followed by scissor, color mask, depth and clear value changes
+ * before the first draw, back-to-back clears of different buffers and of
+ * the same buffer, and a clear with no draw after it.
+ */
+static void scene_clear_state(const scene_t *s) {
+    set_depth(GL_LESS);
+    glClearColor(0.1f, 0.2f, 0.3f, 1.0f);
+    glClearDepthf(1.0f);
+    clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    /* Changed after the clear: applies to the draws only */
+    glClearColor(0.9f, 0.8f, 0.7f, 1.0f);
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(10, 20, 300, 200);
+    glColorMask(GL_TRUE, GL_FALSE, GL_TRUE, GL_FALSE);
+    for (int i = 0; i < 6; i++) {
+        glUseProgram(s->prog[i & 1]);
+        sglSetDrawSortDepth((float)(6 - i));
+        scene_draw(i);
+    }
+
+    /* Scissored clears, merged into one */
+    clear(GL_COLOR_BUFFER_BIT);
+    glClearDepthf(0.5f);
+    clear(GL_DEPTH_BUFFER_BIT);
+    glClearColor(0.0f, 0.0f, 1.0f, 1.0f);
+    clear(GL_COLOR_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDepthFunc(GL_GREATER);
+    for (int i = 6; i < 12; i++) {
+        glUseProgram(s->prog[i % 3 == 0]);
+        sglSetDrawSortDepth((float)i);
+        scene_draw(i);
+    }
+
+    /* Depth clear under a depth mask that is off: the draws keep it off */
+    glDepthMask(GL_FALSE);
+    clear(GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    glScissor(0, 0, 64, 64);
+    glEnable(GL_SCISSOR_TEST);
+    for (int i = 12; i < 16; i++) {
+        glUseProgram(s->prog[i & 1]);
+        scene_draw(i);
+    }
+
+    /* A clear with no state change after it: the draws keep the state */
+    clear(GL_DEPTH_BUFFER_BIT);
+    for (int i = 16; i < 20; i++) {
+        glUseProgram(s->prog[i & 1]);
+        scene_draw(i);
+    }
+
+    /* Nothing drawn after it: still cleared, by glFinish */
+    clear(GL_COLOR_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+    glDepthMask(GL_TRUE);
+}
+
+static void test_sorted_uniforms(const scene_t *s) {
+    TEST("Sorted draws with uniform writes between them");
+
+    static draw_log_t in_order, by_state, by_depth;
+    record_scene(s, scene_uniforms, SGL_DRAW_SORT_NONE, &in_order);
+    record_scene(s, scene_uniforms, SGL_DRAW_SORT_STATE, &by_state);
+    record_scene(s, scene_uniforms, SGL_DRAW_SORT_DEPTH, &by_depth);
+
+    CHECK(in_order.count == 2 + SCENE_DRAWS + (SCENE_DRAWS + 4) / 5, "every clear and draw logged");
+    CHECK(!logs_same_order(&in_order, &by_state), "SGL_DRAW_SORT_STATE reorders the draws");
+    CHECK(!logs_same_order(&in_order, &by_depth), "SGL_DRAW_SORT_DEPTH reorders the draws");
+
+    bool same_state = logs_same_image(&in_order, &by_state);
+    bool same_depth = logs_same_image(&in_order, &by_depth);
+    if (!same_state || !same_depth) {
+        print_log("in order", &in_order);
+        print_log(same_state ? "by depth" : "by state", same_state ? &by_depth : &by_state);
+    }
+    CHECK(same_state, "SGL_DRAW_SORT_STATE: same draws, uniforms and state as in order");
+    CHECK(same_depth, "SGL_DRAW_SORT_DEPTH: same draws, uniforms and state as in order");
+}
+
+static void test_equal_depth(const scene_t *s) {
+    TEST("GL_LEQUAL / GL_GEQUAL draws at equal depth");
+
+    static draw_log_t in_order, by_state, by_depth;
+    record_scene(s, scene_equal_depth, SGL_DRAW_SORT_NONE, &in_order);
+    record_scene(s, scene_equal_depth, SGL_DRAW_SORT_STATE, &by_state);
+    record_scene(s, scene_equal_depth, SGL_DRAW_SORT_DEPTH, &by_depth);
+
+    CHECK(in_order.count == 17, "every clear and draw logged");
+    CHECK(logs_same_order(&in_order, &by_state), "SGL_DRAW_SORT_STATE keeps submission order");
+    CHECK(logs_same_order(&in_order, &by_depth), "SGL_DRAW_SORT_DEPTH keeps submission order");
+}
+
+/* The draws after the last depth clear, which changed no state, still get
+ * the scissor and depth state set before it */
+static bool draws_keep_state(const draw_log_t *log) {
+    uint32_t begin = 0, draws = 0;
+    for (uint32_t i = 0; i < log->count; i++) {
+        if (log->records[i].clear_mask & GL_DEPTH_BUFFER_BIT) begin = i + 1;
+    }
+    for (uint32_t i = begin; i < log->count; i++) {
+        const null_draw_record_t *r = &log->records[i];
+        if (r->clear_mask) continue;
+        if (!r->scissor.enabled || r->scissor.x != 0 || r->scissor.y != 0 ||
+            r->scissor.width != 64 || r->scissor.height != 64) return false;
+        if (!r->depth_test || r->depth_write || r->depth_func != GL_GREATER) return false;
+        draws++;
+    }
+    return draws == 4;
+}
+
+static void test_deferred_clear(const scene_t *s) {
+    TEST("Deferred glClear with state changed before the first draw");
+
+    static draw_log_t flushed, deferred, by_state, by_depth;
+    s_flush_clears = true;
+    record_scene(s, scene_clear_state, SGL_DRAW_SORT_NONE, &flushed);
+    s_flush_clears = false;
+    record_scene(s, scene_clear_state, SGL_DRAW_SORT_NONE, &deferred);
+    record_scene(s, scene_clear_state, SGL_DRAW_SORT_STATE, &by_state);
+    record_scene(s, scene_clear_state, SGL_DRAW_SORT_DEPTH, &by_depth);
+
+    CHECK(flushed.count == 7 + 20, "every clear and draw logged");
+    CHECK(deferred.count == flushed.count - 2, "clears with no draw between them merged");
+    CHECK(draws_keep_state(&flushed) && draws_keep_state(&deferred),
+          "scissor and depth state re-emitted after a clear");
+
+    merge_clears(&flushed);
+    bool same = logs_same_order(&flushed, &deferred);
+    if (!same) {
+        print_log("flushed", &flushed);
+        print_log("deferred", &deferred);
+    }
+    CHECK(same, "deferred: same clears, draws and state as flushed at glClear");
+    CHECK(logs_same_image(&flushed, &by_state), "SGL_DRAW_SORT_STATE: same as flushed at glClear");
+    CHECK(logs_same_image(&flushed, &by_depth), "SGL_DRAW_SORT_DEPTH: same as flushed at glClear");
+}
+
+/* ---- Main ---- */
+
+int main(void) {
+    printf("draw order test suite (null backend)\n");
+    printf("====================================\n");
+
+    sglSetShaderCachePath(NULL);
+    EGLDisplay dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    eglInitialize(dpy, NULL, NULL);
+    EGLConfig config;
+    EGLint num_configs = 0;
+    static const EGLint config_attribs[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT, EGL_NONE };
+    eglChooseConfig(dpy, config_attribs, &config, 1, &num_configs);
+    static const EGLint surface_attribs[] = { EGL_WIDTH, 1280, EGL_HEIGHT, 720, EGL_NONE };
+    EGLSurface surf = eglCreatePbufferSurface(dpy, config, surface_attribs);
+    static const EGLint context_attribs[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
+    EGLContext ctx = eglCreateContext(dpy, config, EGL_NO_CONTEXT, context_attribs);
+    if (!surf || !ctx || !eglMakeCurrent(dpy, surf, surf, ctx)) {
+        printf("FAIL: EGL setup (0x%04x)\n", eglGetError());
+        return 1;
+    }
+
+    static scene_t s;
+    if (!scene_init(&s)) {
+        printf("FAIL: scene setup\n");
+        return 1;
+    }
+
+    test_sorted_uniforms(&s);
+    test_equal_depth(&s);
+    test_deferred_clear(&s);
+    CHECK(glGetError() == GL_NO_ERROR, "no GL error");
+
+    scene_free(&s);
+    eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(dpy, ctx);
+    eglDestroySurface(dpy, surf);
+    eglTerminate(dpy);
+
+    printf("\n====================================\n");
+    printf("Results: %d passed, %d failed\n", s_pass, s_fail);
+    return s_fail > 0 ? 1 : 0;
+}
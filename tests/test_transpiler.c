@@ -4,11 +4,15 @@
  * Compile (any platform):
  *   gcc -o test_transpiler test_transpiler.c glsl_transpiler.c -Wall
  *   cl test_transpiler.c glsl_transpiler.c
+ *
+ * Run with --bench to also time transpilation of a large generated shader.
  */
 
 #include "../source/transpiler/glsl_transpiler.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 /* ---- Test helper ---- */
 
@@ -522,9 +526,311 @@ static void test_unexpanded_precision_macro(void) {
     glslt_result_free(&r);
 }
 
+/* ---- Test: declarations spanning lines ---- */
+
+static void test_multiline_declarations(void) {
+    TEST("Multi-line Declarations");
+
+    const char *src =
+        "#version 100\n"
+        "uniform mediump vec4 u_colors[4],\n"
+        "                     u_tint;\n"
+        "attribute vec4\n"
+        "    a_pos;   // position\n"
+        "uniform /* inline */ float u_scale;\n"
+        "void main() {\n"
+        "    gl_Position = a_pos * u_scale * u_tint.x;\n"
+        "}\n";
+
+    glslt_options_t opts;
+    glslt_options_init(&opts);
+
+    glslt_result_t r = glslt_transpile(src, GLSLT_VERTEX, &opts);
+
+    CHECK(r.success, "transpile succeeded");
+    CHECK(r.num_uniforms == 3, "found 3 uniforms");
+    CHECK(r.num_attributes == 1, "found 1 attribute");
+
+    if (r.num_uniforms == 3) {
+        /* Sorted: u_colors, u_scale, u_tint */
+        CHECK(strcmp(r.uniforms[0].name, "u_colors") == 0, "first is u_colors");
+        CHECK(r.uniforms[0].array_size == 4, "u_colors array_size=4");
+        CHECK(strcmp(r.uniforms[1].name, "u_scale") == 0, "second is u_scale");
+        CHECK(strcmp(r.uniforms[2].name, "u_tint") == 0, "third is u_tint");
+    }
+
+    if (r.output) {
+        CHECK(strstr(r.output, "uniform mediump") == NULL, "declaration removed from body");
+        CHECK(strstr(r.output, "// position") == NULL, "trailing comment removed with declaration");
+        CHECK(strstr(r.output, "attribute") == NULL, "no 'attribute' keyword in output");
+        CHECK(strstr(r.output, "layout(location = 0) in vec4 a_pos") != NULL, "a_pos declared");
+        printf("\n--- Output ---\n%s--- End ---\n", r.output);
+    }
+
+    glslt_result_free(&r);
+}
+
+/* ---- Test: block comments and continued directives ---- */
+
+static void test_block_comments(void) {
+    TEST("Block Comments and Continued Directives");
+
+    const char *src =
+        "#version 100\n"
+        "precision mediump float;\n"
+        "/* uniform vec4 u_unused;\n"
+        "   texture2D(u_texture, v_uv) */\n"
+        "#define SAMPLE(uv) \\\n"
+        "    texture2D(u_texture, uv)\n"
+        "varying vec2 v_uv;\n"
+        "uniform sampler2D u_texture;\n"
+        "void main() { /* gl_FragColor */\n"
+        "    gl_FragData [ 0 ] = texture2DProj(u_texture, vec3(v_uv, 1.0));\n"
+        "}\n";
+
+    glslt_options_t opts;
+    glslt_options_init(&opts);
+
+    glslt_result_t r = glslt_transpile(src, GLSLT_FRAGMENT, &opts);
+
+    CHECK(r.success, "transpile succeeded");
+    CHECK(r.num_uniforms == 0, "declaration inside block comment ignored");
+    CHECK(r.num_samplers == 1, "found 1 sampler");
+    CHECK(r.num_varyings == 1, "found 1 varying");
+
+    if (r.output) {
+        CHECK(strstr(r.output, "/* uniform vec4 u_unused;") != NULL, "block comment preserved");
+        CHECK(strstr(r.output, "texture2D(u_texture, v_uv) */") != NULL,
+              "block comment text not rewritten");
+        CHECK(strstr(r.output, "#define") == NULL, "no #define in output");
+        CHECK(strstr(r.output, "    texture2D(u_texture, uv)") == NULL,
+              "continuation line removed with directive");
+        CHECK(strstr(r.output, "/* gl_FragColor */") != NULL, "inline block comment preserved");
+        CHECK(strstr(r.output, "fragColor = textureProj(") != NULL,
+              "gl_FragData [ 0 ] and texture2DProj rewritten");
+        CHECK(strstr(r.output, "layout(location = 0) out vec4 fragColor") != NULL,
+              "fragColor declaration");
+        printf("\n--- Output ---\n%s--- End ---\n", r.output);
+    }
+
+    glslt_result_free(&r);
+}
+
+/* ---- Test: instanced vertex shader ---- */
+
+static void test_instance_id(void) {
+    TEST("Instance ID (GL_EXT_draw_instanced)");
+
+    const char *src =
+        "#version 100\n"
+        "#extension GL_EXT_draw_instanced : require\n"
+        "attribute vec4 a_position;\n"
+        "attribute vec2 a_offset;\n"
+        "uniform float u_spacing;\n"
+        "void main() {\n"
+        "    float shift = float(gl_InstanceIDEXT) * u_spacing;\n"
+        "    gl_Position = a_position + vec4(a_offset + vec2(shift, 0.0), 0.0, 0.0);\n"
+        "}\n";
+
+    glslt_options_t opts;
+    glslt_options_init(&opts);
+
+    glslt_result_t r = glslt_transpile(src, GLSLT_VERTEX, &opts);
+
+    CHECK(r.success, "transpile succeeded");
+    CHECK(r.num_attributes == 2, "found 2 attributes");
+
+    if (r.output) {
+        CHECK(strstr(r.output, "gl_InstanceIDEXT") == NULL, "no gl_InstanceIDEXT in output");
+        CHECK(strstr(r.output, "float(gl_InstanceID)") != NULL, "gl_InstanceIDEXT renamed");
+        CHECK(strstr(r.output, "GL_EXT_draw_instanced") == NULL, "core extension directive removed");
+        printf("\n--- Output ---\n%s--- End ---\n", r.output);
+    }
+
+    glslt_result_free(&r);
+}
+
+/* ---- Test: multiple render targets ---- */
+
+static void test_frag_data(void) {
+    TEST("Multiple render targets (GL_EXT_draw_buffers)");
+
+    const char *src =
+        "#version 100\n"
+        "#extension GL_EXT_draw_buffers : require\n"
+        "precision mediump float;\n"
+        "varying vec3 v_normal;\n"
+        "varying vec4 v_albedo;\n"
+        "void main() {\n"
+        "    gl_FragData[0] = v_albedo;\n"
+        "    gl_FragData[ 1 ] = vec4(normalize(v_normal) * 0.5 + 0.5, 1.0);\n"
+        "    gl_FragData[3] = vec4(gl_FragCoord.z);\n"
+        "}\n";
+
+    glslt_options_t opts;
+    glslt_options_init(&opts);
+
+    glslt_result_t r = glslt_transpile(src, GLSLT_FRAGMENT, &opts);
+
+    CHECK(r.success, "transpile succeeded");
+
+    if (r.output) {
+        CHECK(strstr(r.output, "gl_FragData") == NULL, "no gl_FragData in output");
+        CHECK(strstr(r.output, "GL_EXT_draw_buffers") == NULL, "core extension directive removed");
+        CHECK(strstr(r.output, "layout(location = 0) out vec4 fragColor;") != NULL,
+              "gl_FragData[0] declared as fragColor");
+        CHECK(strstr(r.output, "layout(location = 1) out vec4 fragData_1;") != NULL,
+              "gl_FragData[1] declared at location 1");
+        CHECK(strstr(r.output, "layout(location = 3) out vec4 fragData_3;") != NULL,
+              "gl_FragData[3] declared at location 3");
+        CHECK(strstr(r.output, "fragData_2") == NULL, "unused draw buffer not declared");
+        CHECK(strstr(r.output, "    fragData_1 = vec4(") != NULL, "gl_FragData[ 1 ] rewritten");
+        printf("\n--- Output ---\n%s--- End ---\n", r.output);
+    }
+
+    glslt_result_free(&r);
+}
+
+static void test_uniform_optimization(void) {
+    TEST("Uniform optimization (dead uniforms, packing)");
+
+    const char *src =
+        "#version 100\n"
+        "precision mediump float;\n"
+        "uniform float a;\n"
+        "uniform vec3 b;\n"
+        "uniform vec2 c;\n"
+        "uniform vec4 d;\n"
+        "uniform mat4 m;\n"
+        "uniform float u_unused;\n"
+        "varying vec2 v_uv;\n"
+        "void main() {\n"
+        "    gl_FragColor = m * d + vec4(b * a, 1.0) + vec4(c + v_uv, 0.0, 0.0);\n"
+        "}\n";
+
+    glslt_options_t opts;
+    glslt_options_init(&opts);
+
+    /* Default: every uniform, alphabetical, std140 padding */
+    glslt_result_t r = glslt_transpile(src, GLSLT_FRAGMENT, &opts);
+    CHECK(r.success, "transpile succeeded");
+    CHECK(r.num_uniforms == 6, "found 6 uniforms");
+    CHECK(r.ubo_total_size == 144, "unoptimized UBO total=144");
+    if (r.output) {
+        CHECK(strstr(r.output, "u_unused") != NULL, "unoptimized block keeps u_unused");
+    }
+    glslt_result_free(&r);
+
+    opts.optimize_uniforms = 1;
+    r = glslt_transpile(src, GLSLT_FRAGMENT, &opts);
+    CHECK(r.success, "optimized transpile succeeded");
+    CHECK(r.num_uniforms == 6, "unreferenced uniform still reflected");
+    CHECK(r.ubo_total_size == 112, "optimized UBO total=112");
+
+    if (r.num_uniforms == 6) {
+        /* vec4/mat4 first, the float fills the vec3's slot, then the vec2 */
+        static const struct { const char *name; int offset; } expected[] = {
+            { "d", 0 }, { "m", 16 }, { "b", 80 }, { "a", 92 }, { "c", 96 }, { "u_unused", -1 },
+        };
+        for (int i = 0; i < 6; i++) {
+            char msg[64];
+            snprintf(msg, sizeof(msg), "%s at offset %d", expected[i].name, expected[i].offset);
+            CHECK(strcmp(r.uniforms[i].name, expected[i].name) == 0 &&
+                  r.uniforms[i].offset == expected[i].offset, msg);
+        }
+        CHECK(r.uniforms[5].size == 0, "u_unused size=0");
+    }
+
+    if (r.output) {
+        CHECK(strstr(r.output, "u_unused") == NULL, "u_unused not in output");
+        CHECK(strstr(r.output, "vec3 b;\n    float a;") != NULL, "float packed after vec3");
+        printf("\n--- Output ---\n%s--- End ---\n", r.output);
+    }
+
+    glslt_result_free(&r);
+
+    /* No referenced uniforms: no block at all */
+    r = glslt_transpile("#version 100\nuniform vec4 u_x;\nvoid main() { gl_FragColor = vec4(1.0); }\n",
+                        GLSLT_FRAGMENT, &opts);
+    CHECK(r.success && r.ubo_total_size == 0, "all-unreferenced shader has empty UBO");
+    if (r.output) {
+        CHECK(strstr(r.output, "uniform FragmentUniforms") == NULL, "no UBO block emitted");
+    }
+    glslt_result_free(&r);
+}
+
+/* ---- Benchmark: large uber-shader ---- */
+
+#define BENCH_DEFINES   400
+#define BENCH_UNIFORMS  48
+#define BENCH_LINES     4000
+#define BENCH_ITERS     50
+
+static char *build_bench_shader(size_t *out_len) {
+    size_t cap = 1024 * 1024;
+    char *src = (char *)malloc(cap);
+    size_t n = 0;
+    if (!src) return NULL;
+
+    n += snprintf(src + n, cap - n, "#version 100\nprecision mediump float;\n");
+    for (int i = 0; i < BENCH_DEFINES; i++) {
+        n += snprintf(src + n, cap - n, "#define FEATURE_%d %d\n", i, i & 1);
+    }
+    for (int i = 0; i < BENCH_UNIFORMS; i++) {
+        n += snprintf(src + n, cap - n, "uniform mediump vec4 u_param%d; // parameter %d\n", i, i);
+    }
+    n += snprintf(src + n, cap - n,
+                  "uniform sampler2D u_diffuse;\n"
+                  "uniform samplerCube u_env;\n"
+                  "varying vec2 v_uv;\n"
+                  "varying vec3 v_normal;\n"
+                  "void main() {\n"
+                  "    vec4 acc = vec4(0.0);\n");
+    for (int i = 0; i < BENCH_LINES; i++) {
+        n += snprintf(src + n, cap - n,
+                      "    acc += texture2D(u_diffuse, v_uv * %d.0) * u_param%d /* term */;"
+                      " acc += textureCube(u_env, v_normal) * 0.5;\n",
+                      i % 7 + 1, i % BENCH_UNIFORMS);
+    }
+    n += snprintf(src + n, cap - n, "    gl_FragColor = acc;\n}\n");
+
+    *out_len = n;
+    return src;
+}
+
+static void bench_large_shader(void) {
+    TEST("Benchmark: Large Fragment Shader");
+
+    size_t len = 0;
+    char *src = build_bench_shader(&len);
+    if (!src) {
+        CHECK(0, "allocate benchmark shader");
+        return;
+    }
+
+    glslt_options_t opts;
+    glslt_options_init(&opts);
+
+    int ok = 1;
+    clock_t start = clock();
+    for (int it = 0; it < BENCH_ITERS; it++) {
+        glslt_result_t r = glslt_transpile(src, GLSLT_FRAGMENT, &opts);
+        ok = ok && r.success && r.num_uniforms == BENCH_UNIFORMS && r.num_samplers == 2;
+        glslt_result_free(&r);
+    }
+    double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    CHECK(ok, "large shader transpiles with full reflection");
+    printf("  %zu bytes, %d iterations: %.3f ms/transpile, %.1f MB/s\n",
+           len, BENCH_ITERS, elapsed * 1000.0 / BENCH_ITERS,
+           (double)len * BENCH_ITERS / elapsed / (1024.0 * 1024.0));
+
+    free(src);
+}
+
 /* ---- Main ---- */
 
-int main(void) {
+int main(int argc, char **argv) {
     printf("glsl_transpiler test suite\n");
     printf("==========================\n");
 
@@ -539,6 +845,15 @@ int main(void) {
     test_comments();
     test_preprocessor_directives();
     test_unexpanded_precision_macro();
+    test_multiline_declarations();
+    test_block_comments();
+    test_instance_id();
+    test_frag_data();
+    test_uniform_optimization();
+
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        bench_large_shader();
+    }
 
     printf("\n==========================\n");
     printf("Results: %d passed, %d failed\n", s_pass, s_fail);
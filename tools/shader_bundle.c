@@ -0,0 +1,230 @@
+/*
+ * shader_bundle.c - Build a shader bundle for sglLoadShaderBundle()
+ *
+ * Links every <name>.vert / <name>.frag pair of GLSL ES 1.00 shaders found
+ * in the given directories through the host library (transpiler included)
+ * and writes the programs' binaries, named <name>, into one bundle file
+ * (source/util/sgl_bundle.h). The device loads it with sglLoadShaderBundle
+ * and needs neither the runtime compiler nor sglRegisterUniform calls.
+ *
+ * The host library's null compiler stores GLSL 4.60 text as the "DKSH",
+ * which only the host can load. For device code pass -u with the uam
+ * executable (devkitPro's tools/bin/uam); each stage is then compiled by it.
+ *
+ * Build and run (Linux):
+ *   make -f Makefile.host build_host/shader_bundle
+ *   build_host/shader_bundle -u $DEVKITPRO/tools/bin/uam -o romfs/shaders.sglb shaders/es
+ */
+
+#define GL_GLEXT_PROTOTYPES
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <GLES2/gl2sgl.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util/sgl_bundle.h"
+
+#define MAX_PROGRAMS  1024
+#define MAX_PATH      512
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: shader_bundle [-u uam] -o bundle.sglb dir...\n"
+            "  Links each <name>.vert + <name>.frag (GLSL ES 1.00) in the directories\n"
+            "  and writes the programs, named <name>, to the bundle.\n"
+            "  -u uam   compile device DKSH with this uam executable\n"
+            "           (without it, the code only loads on the host)\n");
+}
+
+static char *read_file(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return NULL;
+    char *data = NULL;
+    long size = -1;
+    if (fseek(fp, 0, SEEK_END) == 0) size = ftell(fp);
+    if (size >= 0 && fseek(fp, 0, SEEK_SET) == 0) {
+        data = (char *)malloc((size_t)size + 1);
+        if (data && fread(data, 1, (size_t)size, fp) != (size_t)size) {
+            free(data);
+            data = NULL;
+        }
+        if (data) data[size] = '\0';
+    }
+    fclose(fp);
+    return data;
+}
+
+static GLuint compile(GLenum type, const char *path) {
+    char *src = read_file(path);
+    if (!src) {
+        fprintf(stderr, "%s: cannot read\n", path);
+        return 0;
+    }
+    GLuint sh = glCreateShader(type);
+    glShaderSource(sh, 1, (const GLchar *const *)&src, NULL);
+    glCompileShader(sh);
+    free(src);
+    return sh;
+}
+
+/* Link dir/name.vert + dir/name.frag and append the program to the bundle */
+static bool add_program(sgl_bundle_writer_t *writer, const char *dir, const char *name) {
+    char vs_path[MAX_PATH], fs_path[MAX_PATH];
+    snprintf(vs_path, sizeof(vs_path), "%s/%s.vert", dir, name);
+    snprintf(fs_path, sizeof(fs_path), "%s/%s.frag", dir, name);
+
+    GLuint vs = compile(GL_VERTEX_SHADER, vs_path);
+    GLuint fs = compile(GL_FRAGMENT_SHADER, fs_path);
+    if (!vs || !fs) return false;
+
+    GLuint prog = glCreateProgram();
+    glAttachShader(prog, vs);
+    glAttachShader(prog, fs);
+    glLinkProgram(prog);
+
+    bool ok = false;
+    GLint linked = 0, length = 0;
+    glGetProgramiv(prog, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        /* Transpiler and uam errors are in the shader logs */
+        char log[2048] = "";
+        fprintf(stderr, "%s: link failed\n", name);
+        glGetShaderInfoLog(vs, sizeof(log), NULL, log);
+        if (log[0]) fprintf(stderr, "%s:\n%s\n", vs_path, log);
+        log[0] = '\0';
+        glGetShaderInfoLog(fs, sizeof(log), NULL, log);
+        if (log[0]) fprintf(stderr, "%s:\n%s\n", fs_path, log);
+        log[0] = '\0';
+        glGetProgramInfoLog(prog, sizeof(log), NULL, log);
+        if (log[0]) fprintf(stderr, "%s\n", log);
+    } else {
+        glGetProgramiv(prog, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+        void *binary = length > 0 ? malloc((size_t)length) : NULL;
+        GLenum format = 0;
+        if (binary) glGetProgramBinaryOES(prog, length, &length, &format, binary);
+        if (!binary || length == 0) {
+            fprintf(stderr, "%s: no program binary\n", name);
+        } else if (!sgl_bundle_add(writer, name, format, binary, (uint32_t)length)) {
+            fprintf(stderr, "%s: cannot add to the bundle (name too long or write failed)\n", name);
+        } else {
+            printf("  %-32s %8d bytes\n", name, length);
+            ok = true;
+        }
+        free(binary);
+    }
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+    glDeleteProgram(prog);
+    return ok;
+}
+
+static int compare_names(const void *a, const void *b) {
+    return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+/* Add every .vert with a matching .frag, in name order so bundles are reproducible */
+static int add_directory(sgl_bundle_writer_t *writer, const char *dir, int *failed) {
+    DIR *d = opendir(dir);
+    if (!d) {
+        fprintf(stderr, "%s: cannot open directory\n", dir);
+        (*failed)++;
+        return 0;
+    }
+
+    static char *names[MAX_PROGRAMS];
+    int count = 0;
+    struct dirent *ent;
+    while ((ent = readdir(d)) != NULL && count < MAX_PROGRAMS) {
+        size_t len = strlen(ent->d_name);
+        if (len <= 5 || strcmp(ent->d_name + len - 5, ".vert") != 0) continue;
+
+        char fs_path[MAX_PATH];
+        snprintf(fs_path, sizeof(fs_path), "%s/%.*s.frag", dir, (int)(len - 5), ent->d_name);
+        FILE *fp = fopen(fs_path, "rb");
+        if (!fp) {
+            fprintf(stderr, "%s/%s: no matching .frag, skipped\n", dir, ent->d_name);
+            continue;
+        }
+        fclose(fp);
+        names[count++] = strndup(ent->d_name, len - 5);
+    }
+    closedir(d);
+
+    qsort(names, (size_t)count, sizeof(names[0]), compare_names);
+    int added = 0;
+    for (int i = 0; i < count; i++) {
+        if (add_program(writer, dir, names[i])) added++;
+        else (*failed)++;
+        free(names[i]);
+    }
+    return added;
+}
+
+int main(int argc, char **argv) {
+    const char *out = NULL;
+    const char *uam = NULL;
+    int first_dir = argc;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out = argv[++i];
+        } else if (strcmp(argv[i], "-u") == 0 && i + 1 < argc) {
+            uam = argv[++i];
+        } else if (argv[i][0] == '-') {
+            usage();
+            return 2;
+        } else {
+            first_dir = i;
+            break;
+        }
+    }
+    if (!out || first_dir == argc) {
+        usage();
+        return 2;
+    }
+
+    /* Read by the library's host compiler (gl_shader.c) */
+    if (uam) setenv("SGL_UAM", uam, 1);
+    else unsetenv("SGL_UAM");
+    sglSetShaderCachePath(NULL);
+
+    EGLDisplay dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    eglInitialize(dpy, NULL, NULL);
+    EGLConfig config;
+    EGLint num_configs = 0;
+    static const EGLint config_attribs[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT, EGL_NONE };
+    eglChooseConfig(dpy, config_attribs, &config, 1, &num_configs);
+    static const EGLint surface_attribs[] = { EGL_WIDTH, 16, EGL_HEIGHT, 16, EGL_NONE };
+    EGLSurface surf = eglCreatePbufferSurface(dpy, config, surface_attribs);
+    static const EGLint context_attribs[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
+    EGLContext ctx = eglCreateContext(dpy, config, EGL_NO_CONTEXT, context_attribs);
+    if (!surf || !ctx || !eglMakeCurrent(dpy, surf, surf, ctx)) {
+        fprintf(stderr, "EGL setup failed (0x%04x)\n", eglGetError());
+        return 1;
+    }
+
+    sgl_bundle_writer_t *writer = sgl_bundle_create(out);
+    if (!writer) {
+        fprintf(stderr, "%s: cannot create\n", out);
+        return 1;
+    }
+
+    printf("%s (%s code):\n", out, uam ? "device" : "host");
+    int added = 0, failed = 0;
+    for (int i = first_dir; i < argc; i++) added += add_directory(writer, argv[i], &failed);
+
+    if (!sgl_bundle_finish(writer)) {
+        fprintf(stderr, "%s: write failed\n", out);
+        failed++;
+    }
+    printf("%d programs, %d failed\n", added, failed);
+
+    eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(dpy, ctx);
+    eglDestroySurface(dpy, surf);
+    eglTerminate(dpy);
+    return failed ? 1 : 0;
+}